@@ -0,0 +1,281 @@
+/**
+ * Headless end-to-end scene benchmark with golden performance baselines.
+ *
+ * Runs one curated scene (a dam-break scale series, the elasticity bunny
+ * or the solid-fluid-interaction scene) without any window, stepping the
+ * simulation through SceneGraph::takeOneFrame for a number of warm-up
+ * frames followed by timed frames. Emits machine-readable lines: one
+ * PHYSIKA_BENCH summary per run and one PHYSIKA_BENCH_MODULE line per
+ * module from the ModuleProfiler rolling averages. The average frame
+ * time is then compared against a checked-in baseline file keyed by the
+ * GPU model, and the process exits non-zero when the tolerance is
+ * exceeded, so CI turns red on the offending commit instead of a
+ * regression surfacing weeks later.
+ *
+ * Usage: App_SceneBench <scene> [warmup] [timed] [--update]
+ *   scene ∈ dambreak_small | dambreak_medium | dambreak_large |
+ *           elasticity | sfi
+ *   --update rewrites this scene's entry in the baseline file for the
+ *   local GPU instead of checking against it.
+ *
+ * The SceneGraph is a process-wide singleton, so each invocation runs
+ * exactly one scene; CI loops over the list.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <chrono>
+#include <cuda_runtime_api.h>
+
+#include "Framework/Framework/SceneGraph.h"
+#include "Framework/Framework/ModuleProfiler.h"
+#include "Framework/Framework/Log.h"
+
+#include "Dynamics/ParticleSystem/ParticleFluid.h"
+#include "Dynamics/ParticleSystem/ParticleElasticBody.h"
+#include "Dynamics/ParticleSystem/ElasticityModule.h"
+#include "Dynamics/ParticleSystem/PositionBasedFluidModel.h"
+#include "Dynamics/ParticleSystem/SolidFluidInteraction.h"
+#include "Dynamics/ParticleSystem/StaticBoundary.h"
+#include "Framework/Mapping/PointSetToPointSet.h"
+
+using namespace PhysIKA;
+
+//default tolerance over the baseline average, percent
+static const float TOLERANCE_PCT = 10.0f;
+
+void buildDamBreak(float spacing)
+{
+	SceneGraph& scene = SceneGraph::getInstance();
+	scene.setLowerBound(Vector3f(0));
+	scene.setUpperBound(Vector3f(1));
+
+	std::shared_ptr<StaticBoundary<DataType3f>> root = scene.createNewScene<StaticBoundary<DataType3f>>();
+	root->loadCube(Vector3f(0), Vector3f(1), 0.02, true);
+
+	std::shared_ptr<ParticleFluid<DataType3f>> fluid = std::make_shared<ParticleFluid<DataType3f>>();
+	root->addParticleSystem(fluid);
+
+	fluid->loadParticles(Vector3f(0.05, 0.05, 0.05), Vector3f(0.4, 0.8, 0.95), spacing);
+	fluid->setMass(100);
+}
+
+void buildElasticity()
+{
+	SceneGraph& scene = SceneGraph::getInstance();
+
+	std::shared_ptr<StaticBoundary<DataType3f>> root = scene.createNewScene<StaticBoundary<DataType3f>>();
+	root->loadCube(Vector3f(0), Vector3f(1), 0.005f, true);
+
+	std::shared_ptr<ParticleElasticBody<DataType3f>> bunny = std::make_shared<ParticleElasticBody<DataType3f>>();
+	root->addParticleSystem(bunny);
+
+	bunny->setMass(1.0);
+	bunny->loadParticles("../../Media/bunny/bunny_points.obj");
+	bunny->loadSurface("../../Media/bunny/bunny_mesh.obj");
+	bunny->translate(Vector3f(0.5, 0.2, 0.5));
+	bunny->getElasticitySolver()->setIterationNumber(10);
+}
+
+void buildSFI()
+{
+	SceneGraph& scene = SceneGraph::getInstance();
+
+	std::shared_ptr<StaticBoundary<DataType3f>> root = scene.createNewScene<StaticBoundary<DataType3f>>();
+	root->loadCube(Vector3f(0), Vector3f(1), 0.015f, true);
+
+	std::shared_ptr<ParticleFluid<DataType3f>> fluid = std::make_shared<ParticleFluid<DataType3f>>();
+	root->addParticleSystem(fluid);
+	fluid->loadParticles(Vector3f(0), Vector3f(0.5, 1.0, 1.0), 0.015f);
+	fluid->setMass(10);
+
+	std::shared_ptr<PositionBasedFluidModel<DataType3f>> pbd = std::make_shared<PositionBasedFluidModel<DataType3f>>();
+	fluid->currentPosition()->connect(&pbd->m_position);
+	fluid->currentVelocity()->connect(&pbd->m_velocity);
+	fluid->currentForce()->connect(&pbd->m_forceDensity);
+	pbd->setSmoothingLength(0.02);
+	fluid->setNumericalModel(pbd);
+
+	std::shared_ptr<SolidFluidInteraction<DataType3f>> sfi = std::make_shared<SolidFluidInteraction<DataType3f>>();
+	sfi->setInteractionDistance(0.02);
+	root->addChild(sfi);
+
+	for (int i = 0; i < 3; i++)
+	{
+		std::shared_ptr<ParticleElasticBody<DataType3f>> bunny = std::make_shared<ParticleElasticBody<DataType3f>>();
+		root->addParticleSystem(bunny);
+		bunny->setMass(1.0);
+		bunny->loadParticles("../../Media/bunny/sparse_bunny_points.obj");
+		bunny->loadSurface("../../Media/bunny/sparse_bunny_mesh.obj");
+		bunny->translate(Vector3f(0.75, 0.2, 0.4 + i * 0.3));
+		bunny->getElasticitySolver()->setIterationNumber(10);
+		bunny->getElasticitySolver()->inHorizon()->setValue(0.03);
+		bunny->getTopologyMapping()->setSearchingRadius(0.05);
+
+		sfi->addParticleSystem(bunny);
+	}
+}
+
+bool buildScene(const std::string& name)
+{
+	if (name == "dambreak_small")       buildDamBreak(0.015f);
+	else if (name == "dambreak_medium") buildDamBreak(0.0075f);
+	else if (name == "dambreak_large")  buildDamBreak(0.005f);
+	else if (name == "elasticity")      buildElasticity();
+	else if (name == "sfi")             buildSFI();
+	else return false;
+
+	return true;
+}
+
+//GPU model name with spaces flattened, used as the baseline file key
+std::string gpuModel()
+{
+	cudaDeviceProp prop;
+	if (cudaGetDeviceProperties(&prop, 0) != cudaSuccess)
+	{
+		return "unknown_gpu";
+	}
+
+	std::string name(prop.name);
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		if (name[i] == ' ' || name[i] == '/') name[i] = '_';
+	}
+	return name;
+}
+
+//executables run from bin/<config>, so the repository root is ../../
+std::string baselinePath()
+{
+	return "../../Examples/App_SceneBench/baselines/" + gpuModel() + ".csv";
+}
+
+//baseline file: one "scene,avg_ms" line per scene, '#' comments
+std::map<std::string, float> loadBaselines(const std::string& path)
+{
+	std::map<std::string, float> baselines;
+
+	std::ifstream in(path);
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.empty() || line[0] == '#') continue;
+
+		size_t comma = line.find(',');
+		if (comma == std::string::npos) continue;
+
+		baselines[line.substr(0, comma)] = (float)atof(line.c_str() + comma + 1);
+	}
+
+	return baselines;
+}
+
+void saveBaselines(const std::string& path, const std::map<std::string, float>& baselines)
+{
+	std::ofstream out(path);
+	out << "# scene,avg_frame_ms -- written by App_SceneBench --update" << std::endl;
+	for (auto it = baselines.begin(); it != baselines.end(); ++it)
+	{
+		out << it->first << "," << it->second << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: App_SceneBench <scene> [warmup] [timed] [--update]" << std::endl;
+		std::cerr << "scenes: dambreak_small dambreak_medium dambreak_large elasticity sfi" << std::endl;
+		return 2;
+	}
+
+	std::string sceneName = argv[1];
+	int warmup = 20;
+	int timed = 100;
+	bool update = false;
+
+	int posArg = 0;
+	for (int i = 2; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--update") update = true;
+		else if (posArg == 0) { warmup = atoi(argv[i]); posArg++; }
+		else if (posArg == 1) { timed = atoi(argv[i]); posArg++; }
+	}
+
+	if (!buildScene(sceneName))
+	{
+		std::cerr << "error: unknown scene '" << sceneName << "'" << std::endl;
+		return 2;
+	}
+
+	Log::setLevel(Log::Warning);
+
+	SceneGraph& scene = SceneGraph::getInstance();
+	scene.initialize();
+	scene.setProfilingEnabled(true);
+
+	for (int i = 0; i < warmup; i++)
+	{
+		scene.takeOneFrame();
+	}
+	cudaDeviceSynchronize();
+
+	//only the timed frames contribute to the per-module averages
+	ModuleProfiler::getInstance().clear();
+
+	float maxMs = 0.0f;
+	auto t0 = std::chrono::high_resolution_clock::now();
+	auto tPrev = t0;
+	for (int i = 0; i < timed; i++)
+	{
+		scene.takeOneFrame();
+		cudaDeviceSynchronize();
+
+		auto tNow = std::chrono::high_resolution_clock::now();
+		float frameMs = std::chrono::duration<float, std::milli>(tNow - tPrev).count();
+		maxMs = frameMs > maxMs ? frameMs : maxMs;
+		tPrev = tNow;
+	}
+	float avgMs = std::chrono::duration<float, std::milli>(tPrev - t0).count() / timed;
+
+	printf("PHYSIKA_BENCH scene=%s gpu=%s warmup=%d frames=%d avg_ms=%.3f max_ms=%.3f\n",
+		sceneName.c_str(), gpuModel().c_str(), warmup, timed, avgMs, maxMs);
+
+	//per-module rolling averages, one line each: module,avg_ms,max_ms,samples
+	std::stringstream csv(ModuleProfiler::getInstance().reportCSV());
+	std::string line;
+	while (std::getline(csv, line))
+	{
+		printf("PHYSIKA_BENCH_MODULE scene=%s %s\n", sceneName.c_str(), line.c_str());
+	}
+
+	std::string path = baselinePath();
+	std::map<std::string, float> baselines = loadBaselines(path);
+
+	if (update)
+	{
+		baselines[sceneName] = avgMs;
+		saveBaselines(path, baselines);
+		printf("PHYSIKA_BENCH_BASELINE scene=%s status=updated baseline_ms=%.3f\n", sceneName.c_str(), avgMs);
+		return 0;
+	}
+
+	auto it = baselines.find(sceneName);
+	if (it == baselines.end())
+	{
+		//no golden number for this GPU yet; report but do not fail
+		printf("PHYSIKA_BENCH_BASELINE scene=%s status=missing file=%s\n", sceneName.c_str(), path.c_str());
+		return 0;
+	}
+
+	float limit = it->second * (1.0f + TOLERANCE_PCT / 100.0f);
+	bool pass = avgMs <= limit;
+	printf("PHYSIKA_BENCH_BASELINE scene=%s status=%s baseline_ms=%.3f limit_ms=%.3f measured_ms=%.3f\n",
+		sceneName.c_str(), pass ? "pass" : "fail", it->second, limit, avgMs);
+
+	return pass ? 0 : 1;
+}
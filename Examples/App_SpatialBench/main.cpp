@@ -0,0 +1,109 @@
+/**
+* Microbenchmark of the spatial-algebra routines on the CPU rigid-body path:
+* SpatialVector cross products and Transform3d applications. Builds with the
+* generic templates or the AVX2/FMA specializations depending on the host
+* compiler flags, so the two can be compared by rebuilding with and without
+* the vector instruction set enabled.
+*/
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include "Dynamics/RigidBody/SpatialVector.h"
+#include "Dynamics/RigidBody/Transform3d.h"
+
+using namespace PhysIKA;
+
+namespace
+{
+	const int N = 1 << 14;
+	const int REPEAT = 200;
+
+	double toNsPerOp(std::chrono::high_resolution_clock::duration d, long long ops)
+	{
+		return std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(d).count() / (double)ops;
+	}
+}
+
+int main()
+{
+	std::default_random_engine e(42);
+	std::uniform_real_distribution<float> u(-2.0f, 2.0f);
+
+	std::vector<SpatialVector<float>> va(N), vb(N), vres(N);
+	std::vector<Transform3d<float>> xs(N);
+
+	for (int i = 0; i < N; ++i)
+	{
+		va[i].set(u(e), u(e), u(e), u(e), u(e), u(e));
+		vb[i].set(u(e), u(e), u(e), u(e), u(e), u(e));
+
+		Quaternion<float> q(u(e), u(e), u(e), u(e));
+		q.normalize();
+		xs[i] = Transform3d<float>(Vector3f(u(e), u(e), u(e)), q);
+	}
+
+#ifdef SPATIAL_VECTOR_AVX2
+	std::cout << "spatial algebra path: AVX2/FMA" << std::endl;
+#else
+	std::cout << "spatial algebra path: generic" << std::endl;
+#endif
+
+	long long ops = (long long)N * REPEAT;
+
+	auto t0 = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < REPEAT; ++r)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			vres[i] = va[i].crossM(vb[i]);
+		}
+	}
+	auto t1 = std::chrono::high_resolution_clock::now();
+	std::cout << "crossM:     " << toNsPerOp(t1 - t0, ops) << " ns/op" << std::endl;
+
+	t0 = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < REPEAT; ++r)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			vres[i] += va[i].crossF(vb[i]);
+		}
+	}
+	t1 = std::chrono::high_resolution_clock::now();
+	std::cout << "crossF:     " << toNsPerOp(t1 - t0, ops) << " ns/op" << std::endl;
+
+	t0 = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < REPEAT; ++r)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			vres[i] += xs[i].transformM(va[i]);
+		}
+	}
+	t1 = std::chrono::high_resolution_clock::now();
+	std::cout << "transformM: " << toNsPerOp(t1 - t0, ops) << " ns/op" << std::endl;
+
+	t0 = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < REPEAT; ++r)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			vres[i] += xs[i].transformF(vb[i]);
+		}
+	}
+	t1 = std::chrono::high_resolution_clock::now();
+	std::cout << "transformF: " << toNsPerOp(t1 - t0, ops) << " ns/op" << std::endl;
+
+	// keep the results observable so the loops cannot be optimized away
+	SpatialVector<float> sum;
+	for (int i = 0; i < N; ++i)
+	{
+		sum += vres[i];
+	}
+	std::cout << "checksum:   " << sum.norm() << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,9 @@
+#include "PyFieldView.h"
+
+#include "Core/DataTypes.h"
+
+void pybind_field_view(py::module& m)
+{
+	declare_device_array_view<PhysIKA::DataType3f::Coord>(m, "3f");
+	declare_device_array_view<PhysIKA::DataType3f::Real>(m, "1f");
+}
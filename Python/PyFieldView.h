@@ -0,0 +1,159 @@
+#pragma once
+#include "PyCommon.h"
+#include <pybind11/numpy.h>
+
+#include <cstdint>
+#include <memory>
+
+#include <cuda_runtime.h>
+
+#include "Core/Array/Array.h"
+#include "Core/Vector.h"
+#include "Framework/Framework/FieldArray.h"
+
+/**
+ * Element layout of a field as seen from Python: the numpy/CUDA typestr of the
+ * scalar and how many scalars one element packs (3 for Vector3f, 1 for Real).
+ */
+template <typename T>
+struct FieldViewTraits;
+
+template <>
+struct FieldViewTraits<float> {
+	using Scalar = float;
+	static const int components = 1;
+	static const char* typestr() { return "<f4"; }
+};
+
+template <>
+struct FieldViewTraits<double> {
+	using Scalar = double;
+	static const int components = 1;
+	static const char* typestr() { return "<f8"; }
+};
+
+template <typename T, int dim>
+struct FieldViewTraits<PhysIKA::Vector<T, dim>> {
+	using Scalar = T;
+	static const int components = dim;
+	static const char* typestr() { return FieldViewTraits<T>::typestr(); }
+};
+
+/**
+ * Zero-copy Python view of a DeviceArrayField.
+ *
+ * The `__cuda_array_interface__` property hands the device pointer straight to
+ * CuPy/Numba/PyTorch without any copy; the owning node must outlive the view
+ * (the bindings pin it with py::keep_alive). For host-side analysis, numpy()
+ * returns a NumPy array aliasing a pinned-host mirror of the field; the mirror
+ * is only refreshed at the explicit sync points sync() (device to host) and
+ * flush() (host to device), so a script controls exactly when the PCIe copy
+ * and device synchronization happen.
+ */
+template <typename T>
+class DeviceArrayView
+{
+public:
+	using Traits = FieldViewTraits<T>;
+	using Scalar = typename Traits::Scalar;
+
+	DeviceArrayView(PhysIKA::DeviceArrayField<T>* field)
+		: m_field(field)
+	{
+	}
+
+	int size() {
+		if (m_field == nullptr || m_field->isEmpty()) return 0;
+		return m_field->getValue().size();
+	}
+
+	std::uintptr_t dataPtr() {
+		if (size() == 0) return 0;
+		return reinterpret_cast<std::uintptr_t>(m_field->getValue().getDataPtr());
+	}
+
+	py::dict cudaArrayInterface() {
+		py::dict d;
+		int num = size();
+		if (Traits::components == 1)
+			d["shape"] = py::make_tuple(num);
+		else
+			d["shape"] = py::make_tuple(num, Traits::components);
+		d["typestr"] = Traits::typestr();
+		d["data"] = py::make_tuple(dataPtr(), false);
+		d["strides"] = py::none();
+		d["version"] = 2;
+		return d;
+	}
+
+	/**
+	 * Copy the device field into the pinned mirror and synchronize; until the
+	 * next sync() the NumPy view keeps showing this snapshot.
+	 */
+	void sync() {
+		int num = size();
+		if (num == 0) return;
+		ensureMirror(num);
+		cudaMemcpy(m_mirror->getDataPtr(), m_field->getValue().getDataPtr(), num * sizeof(T), cudaMemcpyDeviceToHost);
+		cudaDeviceSynchronize();
+	}
+
+	/**
+	 * Push host-side edits of the NumPy view back to the device field.
+	 */
+	void flush() {
+		int num = size();
+		if (num == 0 || m_mirror == nullptr) return;
+		cudaMemcpy(m_field->getValue().getDataPtr(), m_mirror->getDataPtr(), num * sizeof(T), cudaMemcpyHostToDevice);
+		cudaDeviceSynchronize();
+	}
+
+	Scalar* hostPtr() {
+		int num = size();
+		if (num == 0) return nullptr;
+		if (m_mirror == nullptr) sync();
+		return reinterpret_cast<Scalar*>(m_mirror->getDataPtr());
+	}
+
+private:
+	void ensureMirror(int num) {
+		if (m_mirror != nullptr && m_mirror->size() >= num) return;
+		//Array never frees in its own destructor, so release explicitly.
+		m_mirror = std::shared_ptr<PhysIKA::PinnedHostArray<T>>(
+			new PhysIKA::PinnedHostArray<T>(num),
+			[](PhysIKA::PinnedHostArray<T>* p) { p->release(); delete p; });
+	}
+
+	PhysIKA::DeviceArrayField<T>* m_field;
+	std::shared_ptr<PhysIKA::PinnedHostArray<T>> m_mirror = nullptr;
+};
+
+template <typename T>
+void declare_device_array_view(py::module &m, std::string typestr) {
+	using Class = DeviceArrayView<T>;
+	using Traits = FieldViewTraits<T>;
+	std::string pyclass_name = std::string("DeviceArrayView") + typestr;
+	py::class_<Class>(m, pyclass_name.c_str(), py::dynamic_attr())
+		.def("size", &Class::size)
+		.def("sync", &Class::sync)
+		.def("flush", &Class::flush)
+		.def_property_readonly("__cuda_array_interface__", &Class::cudaArrayInterface)
+		.def("numpy", [](py::object obj) {
+			Class& self = obj.cast<Class&>();
+			int num = self.size();
+			std::vector<py::ssize_t> shape;
+			std::vector<py::ssize_t> strides;
+			if (Traits::components == 1) {
+				shape = { num };
+				strides = { (py::ssize_t)sizeof(typename Class::Scalar) };
+			}
+			else {
+				shape = { num, Traits::components };
+				strides = { (py::ssize_t)(Traits::components * sizeof(typename Class::Scalar)), (py::ssize_t)sizeof(typename Class::Scalar) };
+			}
+			//obj as base: no copy, the array aliases the pinned mirror
+			return py::array_t<typename Class::Scalar>(shape, strides, self.hostPtr(), obj);
+			});
+}
+
+void pybind_field_view(py::module& m);
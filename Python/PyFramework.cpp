@@ -4,6 +4,7 @@
 #include "Framework/Framework/ModuleVisual.h"
 #include "Framework/Framework/SceneGraph.h"
 #include "Framework/Framework/Log.h"
+#include "Framework/Topology/NeighborStats.h"
 
 using Node = PhysIKA::Node;
 using SceneGraph = PhysIKA::SceneGraph;
@@ -51,9 +52,27 @@ void pybind_framework(py::module& m)
 		.def("get_timecost_perframe", &SceneGraph::getTimeCostPerFrame)
 		.def("get_frame_interval", &SceneGraph::getFrameInterval)
 		.def("get_frame_number", &SceneGraph::getFrameNumber)
+		//headless stepping; the GIL is released so Python threads keep running
+		.def("take_one_frame", &SceneGraph::takeOneFrame, py::call_guard<py::gil_scoped_release>())
+		.def("take_frames", &SceneGraph::takeFrames, py::call_guard<py::gil_scoped_release>())
+		.def("clear_scene", &SceneGraph::clearScene)
+		//context manager for sweep loops: tear the scene down on exit so the
+		//next iteration starts from a clean device heap
+		.def("__enter__", [](SceneGraph& scene) -> SceneGraph& { return scene; }, py::return_value_policy::reference)
+		.def("__exit__", [](SceneGraph& scene, py::object, py::object, py::object) { scene.clearScene(); return false; })
+		.def("get_memory_report", &SceneGraph::getMemoryReport)
 		.def("set_gravity", &SceneGraph::setGravity)
 		.def("get_gravity", &SceneGraph::getGravity)
 		.def("get_lower_bound", &SceneGraph::getLowerBound)
-		.def("set_upper_bound", &SceneGraph::setUpperBound);
+		.def("set_upper_bound", &SceneGraph::setUpperBound)
+		.def("get_neighbor_report", &SceneGraph::getNeighborReport)
+		.def("get_profile_report", &SceneGraph::getProfileReport);
+
+	py::class_<PhysIKA::NeighborStats>(m, "NeighborStats")
+		.def_static("get_instance", &PhysIKA::NeighborStats::getInstance, py::return_value_policy::reference, "Return an instance")
+		.def("dropped_neighbors", &PhysIKA::NeighborStats::droppedNeighbors)
+		.def("out_of_domain", &PhysIKA::NeighborStats::outOfDomain)
+		.def("histogram_bin", &PhysIKA::NeighborStats::histogramBin)
+		.def("report", &PhysIKA::NeighborStats::report);
 }
 
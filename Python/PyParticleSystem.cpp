@@ -1,9 +1,11 @@
 #include "PyParticleSystem.h"
+#include "PyFieldView.h"
 
 #include "Dynamics/ParticleSystem/ParticleElasticBody.h"
 #include "Dynamics/ParticleSystem/StaticBoundary.h"
 #include "Dynamics/ParticleSystem/ElasticityModule.h"
 #include "Dynamics/RigidBody/RigidBody.h"
+#include "Framework/Framework/CustomForceModule.h"
 
 template <typename TDataType>
 void declare_static_boundary(py::module &m, std::string typestr) {
@@ -28,7 +30,11 @@ void declare_particle_system(py::module &m, std::string typestr) {
 	using Parent = PhysIKA::Node;
 	std::string pyclass_name = std::string("ParticleSystem") + typestr;
 	py::class_<Class, Parent, std::shared_ptr<Class>>(m, pyclass_name.c_str(), py::buffer_protocol(), py::dynamic_attr())
-		.def(py::init<>());
+		.def(py::init<>())
+		//zero-copy state access; keep_alive pins the node while a view exists
+		.def("current_position", [](Class& s) { return DeviceArrayView<typename TDataType::Coord>(s.currentPosition()); }, py::keep_alive<0, 1>())
+		.def("current_velocity", [](Class& s) { return DeviceArrayView<typename TDataType::Coord>(s.currentVelocity()); }, py::keep_alive<0, 1>())
+		.def("current_force", [](Class& s) { return DeviceArrayView<typename TDataType::Coord>(s.currentForce()); }, py::keep_alive<0, 1>());
 }
 
 template <typename TDataType>
@@ -45,10 +51,44 @@ void declare_particle_elastic_body(py::module &m, std::string typestr) {
 		.def("translate", &Class::translate);
 }
 
+template <typename TDataType>
+void declare_custom_force_module(py::module &m, std::string typestr) {
+	using Class = PhysIKA::CustomForceModule<TDataType>;
+	using Coord = typename TDataType::Coord;
+	using Real = typename TDataType::Real;
+	std::string pyclass_name = std::string("CustomForceModule") + typestr;
+	py::class_<Class, std::shared_ptr<Class>>(m, pyclass_name.c_str(), py::dynamic_attr())
+		.def(py::init<>())
+		.def("get_stream", [](Class& module) { return reinterpret_cast<std::uintptr_t>(module.getStream()); })
+		//connect the node state into the module and register it in one call
+		.def("attach_to", [](std::shared_ptr<Class> module, std::shared_ptr<PhysIKA::ParticleSystem<TDataType>> node) {
+			node->currentPosition()->connect(module->inPosition());
+			node->currentVelocity()->connect(module->inVelocity());
+			node->currentForce()->connect(module->inForce());
+			node->addForceModule(module);
+			}, py::keep_alive<2, 1>())
+		.def("set_callback", [](Class& module, py::function callback) {
+			PhysIKA::DeviceArrayField<Coord>* fPos = module.inPosition();
+			PhysIKA::DeviceArrayField<Coord>* fVel = module.inVelocity();
+			PhysIKA::DeviceArrayField<Coord>* fForce = module.inForce();
+			module.setCallback([callback, fPos, fVel, fForce](PhysIKA::DeviceArray<Coord>&, PhysIKA::DeviceArray<Coord>&, PhysIKA::DeviceArray<Coord>&, Real dt, cudaStream_t stream) {
+				//zero-copy device views plus the stream handle; the callback
+				//enqueues on the stream and returns without synchronizing
+				py::gil_scoped_acquire gil;
+				callback(DeviceArrayView<Coord>(fForce),
+						 DeviceArrayView<Coord>(fPos),
+						 DeviceArrayView<Coord>(fVel),
+						 dt,
+						 reinterpret_cast<std::uintptr_t>(stream));
+				});
+			});
+}
+
 void pybind_particle_system(py::module& m)
 {
 	declare_static_boundary<PhysIKA::DataType3f>(m, "3f");
 	declare_particle_system<PhysIKA::DataType3f>(m, "3f");
 	declare_particle_elastic_body<PhysIKA::DataType3f>(m, "3f");
+	declare_custom_force_module<PhysIKA::DataType3f>(m, "3f");
 }
 
@@ -2,6 +2,7 @@
 
 #include "PyGlutGUI.h"
 #include "PyCore.h"
+#include "PyFieldView.h"
 #include "PyFramework.h"
 #include "PyParticleSystem.h"
 #include "PyRendering.h"
@@ -15,6 +16,7 @@ PYBIND11_MODULE(PyPhysIKA, m) {
 
 	pybind_glut_gui(m);
 	pybind_core(m);
+	pybind_field_view(m);
 	pybind_framework(m);
 	pybind_particle_system(m);
 	pybind_rendering(m);
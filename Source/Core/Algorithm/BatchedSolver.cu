@@ -0,0 +1,89 @@
+#include <cuda_runtime.h>
+#include "BatchedSolver.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	namespace BatchedSolver
+	{
+		template <typename Real>
+		__global__ void BS_Solve3x3(
+			DeviceArray<Vector<Real, 3>> x,
+			DeviceArray<SquareMatrix<Real, 3>> A,
+			DeviceArray<Vector<Real, 3>> b)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= x.size()) return;
+
+			Vector<Real, 3> xi;
+			if (solve3x3(xi, A[pId], b[pId]))
+			{
+				x[pId] = xi;
+			}
+		}
+
+		template <typename Real>
+		__global__ void BS_Inverse3x3(
+			DeviceArray<SquareMatrix<Real, 3>> invA,
+			DeviceArray<SquareMatrix<Real, 3>> A)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= invA.size()) return;
+
+			SquareMatrix<Real, 3> inv;
+			if (inverse3x3(inv, A[pId]))
+			{
+				invA[pId] = inv;
+			}
+		}
+
+		template <typename Real>
+		__global__ void BS_CholeskySolve6x6(
+			DeviceArray<Real> A,
+			DeviceArray<Real> b,
+			int batch)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= batch) return;
+
+			Real* Ai = A.getDataPtr() + 36 * pId;
+			if (cholesky6x6(Ai))
+			{
+				choleskySolve6x6(Ai, b.getDataPtr() + 6 * pId);
+			}
+		}
+
+		template <typename Real>
+		void solve3x3Batched(DeviceArray<Vector<Real, 3>>& x, DeviceArray<SquareMatrix<Real, 3>>& A, DeviceArray<Vector<Real, 3>>& b)
+		{
+			assert(x.size() == A.size() && x.size() == b.size());
+			unsigned pDim = cudaGridSize(x.size(), BLOCK_SIZE);
+			BS_Solve3x3 << <pDim, BLOCK_SIZE >> > (x, A, b);
+		}
+
+		template <typename Real>
+		void inverse3x3Batched(DeviceArray<SquareMatrix<Real, 3>>& invA, DeviceArray<SquareMatrix<Real, 3>>& A)
+		{
+			assert(invA.size() == A.size());
+			unsigned pDim = cudaGridSize(invA.size(), BLOCK_SIZE);
+			BS_Inverse3x3 << <pDim, BLOCK_SIZE >> > (invA, A);
+		}
+
+		template <typename Real>
+		void choleskySolve6x6Batched(DeviceArray<Real>& A, DeviceArray<Real>& b, int batch)
+		{
+			assert(A.size() >= 36 * batch && b.size() >= 6 * batch);
+			unsigned pDim = cudaGridSize(batch, BLOCK_SIZE);
+			BS_CholeskySolve6x6 << <pDim, BLOCK_SIZE >> > (A, b, batch);
+		}
+
+		template void solve3x3Batched(DeviceArray<Vector<float, 3>>&, DeviceArray<SquareMatrix<float, 3>>&, DeviceArray<Vector<float, 3>>&);
+		template void solve3x3Batched(DeviceArray<Vector<double, 3>>&, DeviceArray<SquareMatrix<double, 3>>&, DeviceArray<Vector<double, 3>>&);
+
+		template void inverse3x3Batched(DeviceArray<SquareMatrix<float, 3>>&, DeviceArray<SquareMatrix<float, 3>>&);
+		template void inverse3x3Batched(DeviceArray<SquareMatrix<double, 3>>&, DeviceArray<SquareMatrix<double, 3>>&);
+
+		template void choleskySolve6x6Batched(DeviceArray<float>&, DeviceArray<float>&, int);
+		template void choleskySolve6x6Batched(DeviceArray<double>&, DeviceArray<double>&, int);
+	}
+}
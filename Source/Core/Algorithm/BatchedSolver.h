@@ -0,0 +1,166 @@
+#pragma once
+#include "Core/Platform.h"
+#include "Core/Matrix.h"
+#include "Core/Vector.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility/cuda_utilities.h"
+
+/*
+*  This file implements batched small dense solves on device arrays.
+*  Several modules invert 3x3 systems per particle inline and contact
+*  blocks need 6x6 solves; centralizing the arithmetic here keeps one
+*  tuned variant instead of a copy per solver. The per-element routines
+*  are COMM_FUNC so kernels can also call them directly on their own data
+*  layouts; the launchers below run one thread per system.
+*/
+
+namespace PhysIKA
+{
+	namespace BatchedSolver
+	{
+		/*!
+		*	\brief	x = A^-1 b by Cramer's rule on the cofactors; one
+		*	division by the determinant, no intermediate inverse. Returns
+		*	false and leaves x untouched for singular A.
+		*/
+		template <typename Real>
+		COMM_FUNC bool solve3x3(Vector<Real, 3>& x, const SquareMatrix<Real, 3>& A, const Vector<Real, 3>& b)
+		{
+			Real c00 = A(1, 1) * A(2, 2) - A(1, 2) * A(2, 1);
+			Real c01 = A(1, 2) * A(2, 0) - A(1, 0) * A(2, 2);
+			Real c02 = A(1, 0) * A(2, 1) - A(1, 1) * A(2, 0);
+
+			Real det = A(0, 0) * c00 + A(0, 1) * c01 + A(0, 2) * c02;
+			if (det > -Real(EPSILON) && det < Real(EPSILON))
+			{
+				return false;
+			}
+			Real invDet = Real(1) / det;
+
+			Real c10 = A(0, 2) * A(2, 1) - A(0, 1) * A(2, 2);
+			Real c11 = A(0, 0) * A(2, 2) - A(0, 2) * A(2, 0);
+			Real c12 = A(0, 1) * A(2, 0) - A(0, 0) * A(2, 1);
+
+			Real c20 = A(0, 1) * A(1, 2) - A(0, 2) * A(1, 1);
+			Real c21 = A(0, 2) * A(1, 0) - A(0, 0) * A(1, 2);
+			Real c22 = A(0, 0) * A(1, 1) - A(0, 1) * A(1, 0);
+
+			x[0] = (c00 * b[0] + c10 * b[1] + c20 * b[2]) * invDet;
+			x[1] = (c01 * b[0] + c11 * b[1] + c21 * b[2]) * invDet;
+			x[2] = (c02 * b[0] + c12 * b[1] + c22 * b[2]) * invDet;
+			return true;
+		}
+
+		/*!
+		*	\brief	Cofactor inverse; returns false and leaves invA
+		*	untouched for singular A.
+		*/
+		template <typename Real>
+		COMM_FUNC bool inverse3x3(SquareMatrix<Real, 3>& invA, const SquareMatrix<Real, 3>& A)
+		{
+			Real c00 = A(1, 1) * A(2, 2) - A(1, 2) * A(2, 1);
+			Real c01 = A(1, 2) * A(2, 0) - A(1, 0) * A(2, 2);
+			Real c02 = A(1, 0) * A(2, 1) - A(1, 1) * A(2, 0);
+
+			Real det = A(0, 0) * c00 + A(0, 1) * c01 + A(0, 2) * c02;
+			if (det > -Real(EPSILON) && det < Real(EPSILON))
+			{
+				return false;
+			}
+			Real invDet = Real(1) / det;
+
+			invA(0, 0) = c00 * invDet;
+			invA(1, 0) = c01 * invDet;
+			invA(2, 0) = c02 * invDet;
+			invA(0, 1) = (A(0, 2) * A(2, 1) - A(0, 1) * A(2, 2)) * invDet;
+			invA(1, 1) = (A(0, 0) * A(2, 2) - A(0, 2) * A(2, 0)) * invDet;
+			invA(2, 1) = (A(0, 1) * A(2, 0) - A(0, 0) * A(2, 1)) * invDet;
+			invA(0, 2) = (A(0, 1) * A(1, 2) - A(0, 2) * A(1, 1)) * invDet;
+			invA(1, 2) = (A(0, 2) * A(1, 0) - A(0, 0) * A(1, 2)) * invDet;
+			invA(2, 2) = (A(0, 0) * A(1, 1) - A(0, 1) * A(1, 0)) * invDet;
+			return true;
+		}
+
+		/*!
+		*	\brief	In-place Cholesky factorization of a symmetric positive
+		*	definite 6x6 block, row-major Real[36]; the lower triangle is
+		*	overwritten with L. Returns false as soon as a pivot fails,
+		*	i.e. the block was not positive definite.
+		*/
+		template <typename Real>
+		COMM_FUNC bool cholesky6x6(Real* A)
+		{
+			for (int j = 0; j < 6; j++)
+			{
+				Real d = A[j * 6 + j];
+				for (int k = 0; k < j; k++)
+				{
+					d -= A[j * 6 + k] * A[j * 6 + k];
+				}
+				if (d < Real(EPSILON))
+				{
+					return false;
+				}
+				Real Ljj = sqrt(d);
+				A[j * 6 + j] = Ljj;
+				Real invLjj = Real(1) / Ljj;
+
+				for (int i = j + 1; i < 6; i++)
+				{
+					Real s = A[i * 6 + j];
+					for (int k = 0; k < j; k++)
+					{
+						s -= A[i * 6 + k] * A[j * 6 + k];
+					}
+					A[i * 6 + j] = s * invLjj;
+				}
+			}
+			return true;
+		}
+
+		/*!
+		*	\brief	Solve L L^T x = b with the factor produced by
+		*	cholesky6x6; b (Real[6]) is overwritten with x.
+		*/
+		template <typename Real>
+		COMM_FUNC void choleskySolve6x6(const Real* L, Real* b)
+		{
+			for (int i = 0; i < 6; i++)
+			{
+				Real s = b[i];
+				for (int k = 0; k < i; k++)
+				{
+					s -= L[i * 6 + k] * b[k];
+				}
+				b[i] = s / L[i * 6 + i];
+			}
+			for (int i = 5; i >= 0; i--)
+			{
+				Real s = b[i];
+				for (int k = i + 1; k < 6; k++)
+				{
+					s -= L[k * 6 + i] * b[k];
+				}
+				b[i] = s / L[i * 6 + i];
+			}
+		}
+
+		// x[i] = A[i]^-1 b[i]; singular systems leave x[i] untouched
+		template <typename Real>
+		void solve3x3Batched(DeviceArray<Vector<Real, 3>>& x, DeviceArray<SquareMatrix<Real, 3>>& A, DeviceArray<Vector<Real, 3>>& b);
+
+		// invA[i] = A[i]^-1; singular systems leave invA[i] untouched
+		template <typename Real>
+		void inverse3x3Batched(DeviceArray<SquareMatrix<Real, 3>>& invA, DeviceArray<SquareMatrix<Real, 3>>& A);
+
+		/*!
+		*	\brief	Solve batch symmetric positive definite 6x6 systems;
+		*	A holds 36 row-major entries per system and is overwritten
+		*	with its factor, b holds 6 entries per system and is
+		*	overwritten with the solution. Non-SPD systems keep their
+		*	right-hand side.
+		*/
+		template <typename Real>
+		void choleskySolve6x6Batched(DeviceArray<Real>& A, DeviceArray<Real>& b, int batch);
+	};
+}
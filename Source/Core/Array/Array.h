@@ -16,14 +16,14 @@ namespace PhysIKA {
 	class Array
 	{
 	public:
-		Array(const std::shared_ptr<MemoryManager<deviceType>> alloc = std::make_shared<DefaultMemoryManager<deviceType>>())
+		Array(const std::shared_ptr<MemoryManager<deviceType>> alloc = std::make_shared<CachingMemoryManager<deviceType>>())
 			: m_data(NULL)
 			, m_totalNum(0)
 			, m_alloc(alloc)
 		{
 		};
 
-		Array(int num, const std::shared_ptr<MemoryManager<deviceType>> alloc = std::make_shared<DefaultMemoryManager<deviceType>>())
+		Array(int num, const std::shared_ptr<MemoryManager<deviceType>> alloc = std::make_shared<CachingMemoryManager<deviceType>>())
 			: m_data(NULL)
 			, m_totalNum(num)
 			, m_alloc(alloc)
@@ -31,6 +31,39 @@ namespace PhysIKA {
 			allocMemory();
 		}
 
+		/*!
+		*	\brief	Kernels receive Array parameters by value; keep the shallow copy.
+		*/
+		Array(const Array<T, deviceType>& arr) = default;
+		Array<T, deviceType>& operator=(const Array<T, deviceType>& arr) = default;
+
+		/*!
+		*	\brief	Steal the buffer instead of copying it; the source is left empty.
+		*/
+		Array(Array<T, deviceType>&& arr)
+			: m_data(arr.m_data)
+			, m_totalNum(arr.m_totalNum)
+			, m_alloc(arr.m_alloc)
+		{
+			arr.m_data = NULL;
+			arr.m_totalNum = 0;
+		}
+
+		Array<T, deviceType>& operator=(Array<T, deviceType>&& arr)
+		{
+			if (this != &arr)
+			{
+				if (m_data != NULL) release();
+
+				m_data = arr.m_data;
+				m_totalNum = arr.m_totalNum;
+				m_alloc = arr.m_alloc;
+				arr.m_data = NULL;
+				arr.m_totalNum = 0;
+			}
+			return *this;
+		}
+
 		/*!
 		*	\brief	Should not release data here, call Release() explicitly.
 		*/
@@ -48,6 +81,12 @@ namespace PhysIKA {
 		*/
 		void release();
 
+		/*!
+		*	\brief	Drop trailing elements without touching the allocation;
+		*	used after stream compaction. n must not exceed size().
+		*/
+		void shrink(int n) { m_totalNum = n < m_totalNum ? n : m_totalNum; }
+
 		inline T*		getDataPtr() { return m_data; }
 
 		DeviceType		getDeviceType() { return deviceType; }
@@ -143,7 +182,6 @@ namespace PhysIKA {
 // 			break;
 // 		}
 
-		printf("%d %d\n", m_totalNum, sizeof(T));
 		m_alloc->allocMemory1D((void**)&m_data, m_totalNum, sizeof(T));
 
 		reset();
@@ -172,4 +210,28 @@ namespace PhysIKA {
 
 	template<typename T>
 	using DeviceArray = Array<T, DeviceType::GPU>;
+
+	/*!
+	*	\class	PinnedHostArray
+	*	\brief	Host array backed by cudaMallocHost pinned pages.
+	*
+	*	Pinned staging roughly doubles host<->device copy bandwidth and is required
+	*	for the copies to run asynchronously on a stream (Function1Pt::copyAsync).
+	*	Use it for upload staging in loaders and topology setters instead of
+	*	pageable std::vector buffers.
+	*/
+	template<typename T>
+	class PinnedHostArray : public Array<T, DeviceType::CPU>
+	{
+	public:
+		PinnedHostArray()
+			: Array<T, DeviceType::CPU>(std::make_shared<CudaMemoryManager<DeviceType::CPU>>())
+		{
+		}
+
+		PinnedHostArray(int num)
+			: Array<T, DeviceType::CPU>(num, std::make_shared<CudaMemoryManager<DeviceType::CPU>>())
+		{
+		}
+	};
 }
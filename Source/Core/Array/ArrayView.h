@@ -0,0 +1,66 @@
+#pragma once
+#include "Array.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	ArrayView
+	*	\brief	Non-owning view over the elements of a DeviceArray.
+	*
+	*	A view is a plain pointer/size pair that can be passed to kernels exactly
+	*	like DeviceArray, but makes no ownership claim: modules that only read or
+	*	scatter into somebody else's field can accept a view instead of keeping a
+	*	deep copy, and a view can expose a sub-range of a larger allocation (e.g.
+	*	a FieldGroup slab). ConstArrayView is the read-only variant compute
+	*	kernels should take for their inputs.
+	*/
+	template<typename T>
+	class ArrayView
+	{
+	public:
+		COMM_FUNC ArrayView() : m_data(nullptr), m_totalNum(0) {}
+		COMM_FUNC ArrayView(T* data, int num) : m_data(data), m_totalNum(num) {}
+		ArrayView(Array<T, DeviceType::GPU>& arr) : m_data(arr.getDataPtr()), m_totalNum(arr.size()) {}
+
+		COMM_FUNC inline T& operator [] (unsigned int id)
+		{
+			return m_data[id];
+		}
+
+		COMM_FUNC inline T operator [] (unsigned int id) const
+		{
+			return m_data[id];
+		}
+
+		COMM_FUNC inline int size() const { return m_totalNum; }
+		COMM_FUNC inline bool isEmpty() const { return m_data == nullptr; }
+		COMM_FUNC inline T* getDataPtr() const { return m_data; }
+
+	private:
+		T* m_data;
+		int m_totalNum;
+	};
+
+	template<typename T>
+	class ConstArrayView
+	{
+	public:
+		COMM_FUNC ConstArrayView() : m_data(nullptr), m_totalNum(0) {}
+		COMM_FUNC ConstArrayView(const T* data, int num) : m_data(data), m_totalNum(num) {}
+		COMM_FUNC ConstArrayView(const ArrayView<T>& view) : m_data(view.getDataPtr()), m_totalNum(view.size()) {}
+		ConstArrayView(Array<T, DeviceType::GPU>& arr) : m_data(arr.getDataPtr()), m_totalNum(arr.size()) {}
+
+		COMM_FUNC inline const T& operator [] (unsigned int id) const
+		{
+			return m_data[id];
+		}
+
+		COMM_FUNC inline int size() const { return m_totalNum; }
+		COMM_FUNC inline bool isEmpty() const { return m_data == nullptr; }
+		COMM_FUNC inline const T* getDataPtr() const { return m_data; }
+
+	private:
+		const T* m_data;
+		int m_totalNum;
+	};
+}
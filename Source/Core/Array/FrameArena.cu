@@ -0,0 +1,76 @@
+#include "FrameArena.h"
+
+#include <cuda_runtime.h>
+#include "Core/Utility/cuda_utilities.h"
+
+namespace PhysIKA {
+
+	FrameArena& FrameArena::getInstance()
+	{
+		static FrameArena instance;
+		return instance;
+	}
+
+	FrameArena::~FrameArena()
+	{
+		release();
+	}
+
+	void* FrameArena::allocate(size_t bytes)
+	{
+		const size_t alignment = 256;
+		bytes = (bytes + alignment - 1) / alignment * alignment;
+
+		if (m_used + bytes > m_capacity)
+		{
+			//Overflow blocks are rare after the first frame; satisfy the request with
+			//a dedicated allocation and fold it into the slab at the next reset().
+			size_t required = m_used + bytes;
+			m_highWater = required > m_highWater ? required : m_highWater;
+
+			void* overflow = nullptr;
+			cuSafeCall(cudaMalloc(&overflow, bytes));
+			m_overflow.push_back(overflow);
+			return overflow;
+		}
+
+		void* ptr = m_slab + m_used;
+		m_used += bytes;
+		m_highWater = m_used > m_highWater ? m_used : m_highWater;
+		return ptr;
+	}
+
+	void FrameArena::reset()
+	{
+		for (size_t i = 0; i < m_overflow.size(); i++)
+		{
+			cuSafeCall(cudaFree(m_overflow[i]));
+		}
+		m_overflow.clear();
+
+		if (m_highWater > m_capacity)
+		{
+			if (m_slab != nullptr)
+			{
+				cuSafeCall(cudaFree(m_slab));
+			}
+			m_capacity = m_highWater;
+			cuSafeCall(cudaMalloc((void**)&m_slab, m_capacity));
+		}
+
+		m_used = 0;
+	}
+
+	void FrameArena::release()
+	{
+		reset();
+
+		if (m_slab != nullptr)
+		{
+			cuSafeCall(cudaFree(m_slab));
+			m_slab = nullptr;
+		}
+		m_capacity = 0;
+		m_highWater = 0;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	FrameArena
+	*	\brief	Linear bump allocator for per-step device temporaries.
+	*
+	*	Constraint and compute modules keep long-lived member DeviceArrays that are
+	*	only alive inside a single constrain()/compute() call; across a scene these
+	*	idle scratch buffers add up. Sequentially executed modules can instead grab
+	*	scratch from this arena, so their temporaries alias the same device memory.
+	*
+	*	The arena is reset once per frame by SceneGraph::takeOneFrame(). Allocations
+	*	are 256-byte aligned bump allocations; the backing slab grows to the observed
+	*	high-water mark and is reused afterwards. Memory handed out this way must not
+	*	outlive the frame.
+	*/
+	class FrameArena
+	{
+	public:
+		static FrameArena& getInstance();
+
+		/**
+		 * @brief Bump-allocate device scratch, valid until the next reset().
+		 */
+		void* allocate(size_t bytes);
+
+		template<typename T>
+		T* allocate(int num)
+		{
+			return (T*)allocate((size_t)num * sizeof(T));
+		}
+
+		/**
+		 * @brief Recycle the whole arena. Called at the start of every frame.
+		 */
+		void reset();
+
+		/**
+		 * @brief Return the backing slab to the allocator.
+		 */
+		void release();
+
+		size_t used() { return m_used; }
+		size_t highWaterMark() { return m_highWater; }
+
+	private:
+		FrameArena() {};
+		~FrameArena();
+
+		char* m_slab = nullptr;
+		std::vector<void*> m_overflow;
+		size_t m_capacity = 0;
+		size_t m_used = 0;
+		size_t m_highWater = 0;
+	};
+}
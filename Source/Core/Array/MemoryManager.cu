@@ -2,6 +2,8 @@
 
 #include <cuda_runtime_api.h>
 #include <sstream>
+#include <mutex>
+#include <map>
 #include <stdexcept>
 #include <vector>
 #include <assert.h>
@@ -10,10 +12,191 @@
 
 namespace PhysIKA {
 
+	namespace {
+
+		std::mutex s_statsMutex;
+
+		struct AllocRecord
+		{
+			size_t bytes;
+			std::string tag;
+		};
+
+		struct TagStats
+		{
+			size_t live = 0;
+			size_t highWater = 0;
+		};
+
+		std::map<void*, AllocRecord> s_liveAllocs;
+		std::map<std::string, TagStats> s_tagStats;
+		size_t s_liveBytes = 0;
+		size_t s_highWaterBytes = 0;
+		size_t s_budgetBytes = 0;
+		size_t s_allocCount = 0;
+		bool s_oversubscribe = false;
+
+		thread_local std::vector<std::string> s_tagStack;
+
+		std::string currentTag()
+		{
+			return s_tagStack.empty() ? std::string("untagged") : s_tagStack.back();
+		}
+
+		//cudaMalloc with budget enforcement: trim the caching pool when the
+		//budget would be exceeded, and retry a failed allocation once after
+		//trimming before letting the error surface.
+		void guardedCudaMalloc(void** ptr, size_t bytes)
+		{
+			if (MemoryStats::budget() > 0 && MemoryStats::liveBytes() + bytes > MemoryStats::budget())
+			{
+				CachingMemoryManager<DeviceType::GPU>::trim();
+			}
+
+			cudaError_t err = cudaMalloc(ptr, bytes);
+			if (err != cudaSuccess)
+			{
+				cudaGetLastError();
+				CachingMemoryManager<DeviceType::GPU>::trim();
+
+				//last resort under oversubscription: a managed block the
+				//driver can page, instead of dying in cudaMalloc
+				if (MemoryStats::oversubscription())
+				{
+					err = cudaMalloc(ptr, bytes);
+					if (err == cudaSuccess)
+					{
+						return;
+					}
+					cudaGetLastError();
+
+					cuSafeCall(cudaMallocManaged(ptr, bytes));
+
+					int device = 0;
+					cudaGetDevice(&device);
+					cudaMemAdvise(*ptr, bytes, cudaMemAdviseSetPreferredLocation, device);
+					cudaMemPrefetchAsync(*ptr, bytes, device, 0);
+					return;
+				}
+
+				cuSafeCall(cudaMalloc(ptr, bytes));
+			}
+		}
+	}
+
+	void MemoryStats::recordAlloc(void* ptr, size_t bytes)
+	{
+		if (ptr == nullptr) return;
+
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+
+		AllocRecord rec;
+		rec.bytes = bytes;
+		rec.tag = currentTag();
+		s_liveAllocs[ptr] = rec;
+
+		TagStats& tag = s_tagStats[rec.tag];
+		tag.live += bytes;
+		tag.highWater = tag.live > tag.highWater ? tag.live : tag.highWater;
+
+		s_liveBytes += bytes;
+		s_highWaterBytes = s_liveBytes > s_highWaterBytes ? s_liveBytes : s_highWaterBytes;
+		s_allocCount++;
+	}
+
+	void MemoryStats::recordFree(void* ptr)
+	{
+		if (ptr == nullptr) return;
+
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+
+		auto it = s_liveAllocs.find(ptr);
+		if (it == s_liveAllocs.end()) return;
+
+		s_tagStats[it->second.tag].live -= it->second.bytes;
+		s_liveBytes -= it->second.bytes;
+		s_liveAllocs.erase(it);
+	}
+
+	size_t MemoryStats::liveBytes()
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+		return s_liveBytes;
+	}
+
+	size_t MemoryStats::highWaterBytes()
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+		return s_highWaterBytes;
+	}
+
+	size_t MemoryStats::allocCount()
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+		return s_allocCount;
+	}
+
+	void MemoryStats::setBudget(size_t bytes)
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+		s_budgetBytes = bytes;
+	}
+
+	size_t MemoryStats::budget()
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+		return s_budgetBytes;
+	}
+
+	void MemoryStats::setOversubscription(bool enabled)
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+		s_oversubscribe = enabled;
+	}
+
+	bool MemoryStats::oversubscription()
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+		return s_oversubscribe;
+	}
+
+	void MemoryStats::pushTag(const std::string& tag)
+	{
+		s_tagStack.push_back(tag);
+	}
+
+	void MemoryStats::popTag()
+	{
+		if (!s_tagStack.empty())
+		{
+			s_tagStack.pop_back();
+		}
+	}
+
+	std::string MemoryStats::report()
+	{
+		std::lock_guard<std::mutex> guard(s_statsMutex);
+
+		std::stringstream ss;
+		ss << "Device memory: " << s_liveBytes / 1024 << " KB live, "
+			<< s_highWaterBytes / 1024 << " KB high water";
+		if (s_budgetBytes > 0)
+		{
+			ss << ", budget " << s_budgetBytes / 1024 << " KB";
+		}
+		ss << "\n";
+
+		for (auto it = s_tagStats.begin(); it != s_tagStats.end(); ++it)
+		{
+			ss << "  " << it->first << ": " << it->second.live / 1024 << " KB live, "
+				<< it->second.highWater / 1024 << " KB high water\n";
+		}
+		return ss.str();
+	}
+
 	template<DeviceType deviceType>
 	void DefaultMemoryManager<deviceType>::allocMemory1D(void** ptr, size_t memsize, size_t valueSize)
 	{
-		printf("%d %d %d %d\n", deviceType, memsize, valueSize, memsize * valueSize);
 		switch (deviceType)
 		{
 		case CPU:
@@ -23,8 +206,8 @@ namespace PhysIKA {
 			break;
 		case GPU:
 			//assert(*ptr == 0);
-			cuSafeCall(cudaMalloc(ptr, memsize * valueSize));
-			//assert(*ptr);
+			guardedCudaMalloc(ptr, memsize * valueSize);
+			MemoryStats::recordAlloc(*ptr, memsize * valueSize);
 			break;
 		default:
 			break;
@@ -44,6 +227,7 @@ namespace PhysIKA {
 		case GPU:
 			cuSafeCall(cudaMallocPitch(ptr, &pitch, valueSize * width, height));
 			assert(*ptr);
+			MemoryStats::recordAlloc(*ptr, pitch * height);
 			break;
 		default:
 			break;
@@ -80,6 +264,7 @@ namespace PhysIKA {
 			break;
 		case GPU:
 			assert(*ptr != 0);
+			MemoryStats::recordFree(*ptr);
 			cuSafeCall(cudaFree(*ptr));
 			*ptr = 0;
 			break;
@@ -119,6 +304,7 @@ namespace PhysIKA {
 			break;
 		case GPU:
 			cuSafeCall(cudaMallocPitch(ptr, &pitch, valueSize * width, height));
+			MemoryStats::recordAlloc(*ptr, pitch * height);
 			break;
 		case UNDEFINED:
 			break;
@@ -154,4 +340,220 @@ namespace PhysIKA {
 		}
 	}
 
+	template<DeviceType deviceType>
+	void ManagedMemoryManager<deviceType>::allocMemory1D(void** ptr, size_t memsize, size_t valueSize)
+	{
+		if (deviceType != GPU)
+		{
+			DefaultMemoryManager<deviceType>::allocMemory1D(ptr, memsize, valueSize);
+			return;
+		}
+
+		size_t bytes = memsize * valueSize;
+		cuSafeCall(cudaMallocManaged(ptr, bytes));
+
+		//prefer the device but let the driver page under pressure
+		int device = 0;
+		cudaGetDevice(&device);
+		cudaMemAdvise(*ptr, bytes, cudaMemAdviseSetPreferredLocation, device);
+		cudaMemPrefetchAsync(*ptr, bytes, device, 0);
+
+		m_blocks[*ptr] = bytes;
+		MemoryStats::recordAlloc(*ptr, bytes);
+	}
+
+	template<DeviceType deviceType>
+	void ManagedMemoryManager<deviceType>::releaseMemory(void** ptr)
+	{
+		if (deviceType != GPU)
+		{
+			DefaultMemoryManager<deviceType>::releaseMemory(ptr);
+			return;
+		}
+
+		assert(*ptr != 0);
+		m_blocks.erase(*ptr);
+		MemoryStats::recordFree(*ptr);
+		cuSafeCall(cudaFree(*ptr));
+		*ptr = 0;
+	}
+
+	template<DeviceType deviceType>
+	void ManagedMemoryManager<deviceType>::evictToHost(cudaStream_t stream)
+	{
+		for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it)
+		{
+			cudaMemPrefetchAsync(it->first, it->second, cudaCpuDeviceId, stream);
+		}
+	}
+
+	template<DeviceType deviceType>
+	void ManagedMemoryManager<deviceType>::fetchToDevice(cudaStream_t stream)
+	{
+		int device = 0;
+		cudaGetDevice(&device);
+
+		for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it)
+		{
+			cudaMemPrefetchAsync(it->first, it->second, device, stream);
+		}
+	}
+
+	SlabMemoryManager::SlabMemoryManager(size_t capacityBytes)
+		: m_capacity(capacityBytes)
+	{
+		guardedCudaMalloc((void**)&m_slab, m_capacity);
+		MemoryStats::recordAlloc(m_slab, m_capacity);
+	}
+
+	SlabMemoryManager::~SlabMemoryManager()
+	{
+		if (m_slab != nullptr)
+		{
+			MemoryStats::recordFree(m_slab);
+			cuSafeCall(cudaFree(m_slab));
+		}
+	}
+
+	void SlabMemoryManager::allocMemory1D(void** ptr, size_t memsize, size_t valueSize)
+	{
+		const size_t alignment = 256;
+		size_t bytes = (memsize * valueSize + alignment - 1) / alignment * alignment;
+
+		if (m_used + bytes > m_capacity)
+		{
+			throw std::runtime_error("SlabMemoryManager: slab capacity exhausted");
+		}
+
+		*ptr = m_slab + m_used;
+		m_used += bytes;
+	}
+
+	void SlabMemoryManager::allocMemory2D(void** ptr, size_t& pitch, size_t height, size_t width, size_t valueSize)
+	{
+		pitch = width * valueSize;
+		allocMemory1D(ptr, height * width, valueSize);
+	}
+
+	void SlabMemoryManager::initMemory(void* ptr, int value, size_t count)
+	{
+		cudaMemset(ptr, value, count);
+	}
+
+	void SlabMemoryManager::releaseMemory(void** ptr)
+	{
+		//Individual arrays never return memory; the slab is freed as a whole.
+		*ptr = 0;
+	}
+
+	namespace {
+
+		//Process-wide pool shared by all CachingMemoryManager<GPU> instances:
+		//Array creates one manager per array, so per-instance bins would never hit.
+		std::mutex s_poolMutex;
+		std::multimap<size_t, void*> s_freeBlocks;
+		std::map<void*, size_t> s_blockSize;
+		size_t s_poolHits = 0;
+		size_t s_poolMisses = 0;
+		size_t s_cachedBytes = 0;
+
+		size_t sizeClass(size_t bytes)
+		{
+			size_t c = 256;
+			while (c < bytes)
+			{
+				c *= 2;
+			}
+			return c;
+		}
+	}
+
+	template<DeviceType deviceType>
+	void CachingMemoryManager<deviceType>::allocMemory1D(void** ptr, size_t memsize, size_t valueSize)
+	{
+		if (deviceType != GPU)
+		{
+			DefaultMemoryManager<deviceType>::allocMemory1D(ptr, memsize, valueSize);
+			return;
+		}
+
+		size_t bytes = sizeClass(memsize * valueSize);
+
+		{
+			std::lock_guard<std::mutex> guard(s_poolMutex);
+
+			auto it = s_freeBlocks.find(bytes);
+			if (it != s_freeBlocks.end())
+			{
+				*ptr = it->second;
+				s_freeBlocks.erase(it);
+				s_cachedBytes -= bytes;
+				s_poolHits++;
+				MemoryStats::recordAlloc(*ptr, bytes);
+				return;
+			}
+			s_poolMisses++;
+		}
+
+		guardedCudaMalloc(ptr, bytes);
+		MemoryStats::recordAlloc(*ptr, bytes);
+
+		std::lock_guard<std::mutex> guard(s_poolMutex);
+		s_blockSize[*ptr] = bytes;
+	}
+
+	template<DeviceType deviceType>
+	void CachingMemoryManager<deviceType>::releaseMemory(void** ptr)
+	{
+		if (deviceType != GPU)
+		{
+			DefaultMemoryManager<deviceType>::releaseMemory(ptr);
+			return;
+		}
+
+		assert(*ptr != 0);
+
+		MemoryStats::recordFree(*ptr);
+
+		std::lock_guard<std::mutex> guard(s_poolMutex);
+		size_t bytes = s_blockSize[*ptr];
+		s_freeBlocks.insert(std::make_pair(bytes, *ptr));
+		s_cachedBytes += bytes;
+		*ptr = 0;
+	}
+
+	template<DeviceType deviceType>
+	size_t CachingMemoryManager<deviceType>::poolHitCount()
+	{
+		std::lock_guard<std::mutex> guard(s_poolMutex);
+		return s_poolHits;
+	}
+
+	template<DeviceType deviceType>
+	size_t CachingMemoryManager<deviceType>::poolMissCount()
+	{
+		std::lock_guard<std::mutex> guard(s_poolMutex);
+		return s_poolMisses;
+	}
+
+	template<DeviceType deviceType>
+	size_t CachingMemoryManager<deviceType>::cachedBytes()
+	{
+		std::lock_guard<std::mutex> guard(s_poolMutex);
+		return s_cachedBytes;
+	}
+
+	template<DeviceType deviceType>
+	void CachingMemoryManager<deviceType>::trim()
+	{
+		std::lock_guard<std::mutex> guard(s_poolMutex);
+		for (auto it = s_freeBlocks.begin(); it != s_freeBlocks.end(); ++it)
+		{
+			s_blockSize.erase(it->second);
+			cuSafeCall(cudaFree(it->second));
+		}
+		s_freeBlocks.clear();
+		s_cachedBytes = 0;
+	}
+
 }
\ No newline at end of file
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <float.h>
+#include <math.h>
+#include "Core/Platform.h"
+#include "Core/Vector.h"
+
+namespace PhysIKA
+{
+	/**
+	* @brief Directed-rounding helpers backing the interval classes below.
+	* @details On the device the float and double paths use the hardware
+	*          directed-rounding intrinsics, so every bound costs the same as
+	*          the plain operation. On the host the result is widened by one
+	*          ulp with nextafter instead; the outcome is looser but still
+	*          conservative.
+	*/
+	namespace IntervalRound
+	{
+		COMM_FUNC inline float addDown(float a, float b)
+		{
+#ifdef __CUDA_ARCH__
+			return __fadd_rd(a, b);
+#else
+			return nextafterf(a + b, -FLT_MAX);
+#endif
+		}
+
+		COMM_FUNC inline float addUp(float a, float b)
+		{
+#ifdef __CUDA_ARCH__
+			return __fadd_ru(a, b);
+#else
+			return nextafterf(a + b, FLT_MAX);
+#endif
+		}
+
+		COMM_FUNC inline float subDown(float a, float b)
+		{
+#ifdef __CUDA_ARCH__
+			return __fsub_rd(a, b);
+#else
+			return nextafterf(a - b, -FLT_MAX);
+#endif
+		}
+
+		COMM_FUNC inline float subUp(float a, float b)
+		{
+#ifdef __CUDA_ARCH__
+			return __fsub_ru(a, b);
+#else
+			return nextafterf(a - b, FLT_MAX);
+#endif
+		}
+
+		COMM_FUNC inline float mulDown(float a, float b)
+		{
+#ifdef __CUDA_ARCH__
+			return __fmul_rd(a, b);
+#else
+			return nextafterf(a * b, -FLT_MAX);
+#endif
+		}
+
+		COMM_FUNC inline float mulUp(float a, float b)
+		{
+#ifdef __CUDA_ARCH__
+			return __fmul_ru(a, b);
+#else
+			return nextafterf(a * b, FLT_MAX);
+#endif
+		}
+
+		COMM_FUNC inline double addDown(double a, double b)
+		{
+#ifdef __CUDA_ARCH__
+			return __dadd_rd(a, b);
+#else
+			return nextafter(a + b, -DBL_MAX);
+#endif
+		}
+
+		COMM_FUNC inline double addUp(double a, double b)
+		{
+#ifdef __CUDA_ARCH__
+			return __dadd_ru(a, b);
+#else
+			return nextafter(a + b, DBL_MAX);
+#endif
+		}
+
+		COMM_FUNC inline double subDown(double a, double b)
+		{
+#ifdef __CUDA_ARCH__
+			return __dsub_rd(a, b);
+#else
+			return nextafter(a - b, -DBL_MAX);
+#endif
+		}
+
+		COMM_FUNC inline double subUp(double a, double b)
+		{
+#ifdef __CUDA_ARCH__
+			return __dsub_ru(a, b);
+#else
+			return nextafter(a - b, DBL_MAX);
+#endif
+		}
+
+		COMM_FUNC inline double mulDown(double a, double b)
+		{
+#ifdef __CUDA_ARCH__
+			return __dmul_rd(a, b);
+#else
+			return nextafter(a * b, -DBL_MAX);
+#endif
+		}
+
+		COMM_FUNC inline double mulUp(double a, double b)
+		{
+#ifdef __CUDA_ARCH__
+			return __dmul_ru(a, b);
+#else
+			return nextafter(a * b, DBL_MAX);
+#endif
+		}
+	}
+
+	/**
+	* @brief Closed interval with outward rounding, usable inside kernels.
+	* @details Interval keeps its method bodies in a host translation unit, so
+	*          device code cannot call them. This companion is header-inline
+	*          and rounds every arithmetic result outward, which keeps the true
+	*          value enclosed through chains of operations. It is meant for
+	*          conservative bounds - enclosing the values a quantity can take
+	*          over a step - where correctness only requires that the true
+	*          value never escapes the interval.
+	*/
+	template <typename Real>
+	class IntervalBound
+	{
+	public:
+		COMM_FUNC IntervalBound() : m_lo(0), m_hi(0) {}
+		COMM_FUNC IntervalBound(Real val) : m_lo(val), m_hi(val) {}
+		COMM_FUNC IntervalBound(Real lo, Real hi) : m_lo(lo), m_hi(hi) {}
+
+		COMM_FUNC Real lower() const { return m_lo; }
+		COMM_FUNC Real upper() const { return m_hi; }
+		COMM_FUNC Real width() const { return m_hi - m_lo; }
+
+		COMM_FUNC bool contains(Real val) const { return val >= m_lo && val <= m_hi; }
+
+		COMM_FUNC void encapsulate(Real val)
+		{
+			m_lo = val < m_lo ? val : m_lo;
+			m_hi = val > m_hi ? val : m_hi;
+		}
+
+		COMM_FUNC void merge(const IntervalBound<Real>& itv)
+		{
+			m_lo = itv.m_lo < m_lo ? itv.m_lo : m_lo;
+			m_hi = itv.m_hi > m_hi ? itv.m_hi : m_hi;
+		}
+
+		COMM_FUNC IntervalBound<Real> operator+ (const IntervalBound<Real>& itv) const
+		{
+			return IntervalBound<Real>(
+				IntervalRound::addDown(m_lo, itv.m_lo),
+				IntervalRound::addUp(m_hi, itv.m_hi));
+		}
+
+		COMM_FUNC IntervalBound<Real> operator- (const IntervalBound<Real>& itv) const
+		{
+			return IntervalBound<Real>(
+				IntervalRound::subDown(m_lo, itv.m_hi),
+				IntervalRound::subUp(m_hi, itv.m_lo));
+		}
+
+		COMM_FUNC IntervalBound<Real> operator* (const IntervalBound<Real>& itv) const
+		{
+			Real lo = IntervalRound::mulDown(m_lo, itv.m_lo);
+			Real v = IntervalRound::mulDown(m_lo, itv.m_hi);
+			lo = v < lo ? v : lo;
+			v = IntervalRound::mulDown(m_hi, itv.m_lo);
+			lo = v < lo ? v : lo;
+			v = IntervalRound::mulDown(m_hi, itv.m_hi);
+			lo = v < lo ? v : lo;
+
+			Real hi = IntervalRound::mulUp(m_lo, itv.m_lo);
+			v = IntervalRound::mulUp(m_lo, itv.m_hi);
+			hi = v > hi ? v : hi;
+			v = IntervalRound::mulUp(m_hi, itv.m_lo);
+			hi = v > hi ? v : hi;
+			v = IntervalRound::mulUp(m_hi, itv.m_hi);
+			hi = v > hi ? v : hi;
+
+			return IntervalBound<Real>(lo, hi);
+		}
+
+		COMM_FUNC IntervalBound<Real> operator* (Real s) const
+		{
+			if (s >= 0)
+			{
+				return IntervalBound<Real>(IntervalRound::mulDown(m_lo, s), IntervalRound::mulUp(m_hi, s));
+			}
+			return IntervalBound<Real>(IntervalRound::mulDown(m_hi, s), IntervalRound::mulUp(m_lo, s));
+		}
+
+	private:
+		Real m_lo, m_hi;
+	};
+
+	/**
+	* @brief Axis-aligned interval box over Vector<Real, 3>.
+	* @details Built from the positions a vertex can reach within a step, the
+	*          box encloses the whole motion, so distance bounds between two
+	*          boxes hold for every instant of the step. Collision kernels use
+	*          distanceSquaredLower as a conservative cull before the exact
+	*          proximity tests: a pair whose lower bound already exceeds the
+	*          contact thickness cannot collide and is skipped without touching
+	*          the expensive closest-point routines.
+	*/
+	template <typename Real>
+	class IntervalVector3
+	{
+	public:
+		typedef Vector<Real, 3> Coord;
+
+		COMM_FUNC IntervalVector3() {}
+		COMM_FUNC IntervalVector3(const Coord& v)
+			: m_x(v[0]), m_y(v[1]), m_z(v[2]) {}
+		COMM_FUNC IntervalVector3(const IntervalBound<Real>& x, const IntervalBound<Real>& y, const IntervalBound<Real>& z)
+			: m_x(x), m_y(y), m_z(z) {}
+
+		/**
+		* @brief Bounds of the moving point p0 + t * (p1 - p0) for t in [0, 1].
+		* @details The motion is linear, so the componentwise extremes sit at
+		*          the endpoints and the box is exact - no rounding needed.
+		*/
+		COMM_FUNC static IntervalVector3<Real> fromSegment(const Coord& p0, const Coord& p1)
+		{
+			IntervalVector3<Real> box(p0);
+			box.encapsulate(p1);
+			return box;
+		}
+
+		COMM_FUNC const IntervalBound<Real>& x() const { return m_x; }
+		COMM_FUNC const IntervalBound<Real>& y() const { return m_y; }
+		COMM_FUNC const IntervalBound<Real>& z() const { return m_z; }
+
+		COMM_FUNC void encapsulate(const Coord& v)
+		{
+			m_x.encapsulate(v[0]);
+			m_y.encapsulate(v[1]);
+			m_z.encapsulate(v[2]);
+		}
+
+		COMM_FUNC void merge(const IntervalVector3<Real>& box)
+		{
+			m_x.merge(box.m_x);
+			m_y.merge(box.m_y);
+			m_z.merge(box.m_z);
+		}
+
+		COMM_FUNC IntervalVector3<Real> operator+ (const IntervalVector3<Real>& box) const
+		{
+			return IntervalVector3<Real>(m_x + box.m_x, m_y + box.m_y, m_z + box.m_z);
+		}
+
+		COMM_FUNC IntervalVector3<Real> operator- (const IntervalVector3<Real>& box) const
+		{
+			return IntervalVector3<Real>(m_x - box.m_x, m_y - box.m_y, m_z - box.m_z);
+		}
+
+		COMM_FUNC IntervalVector3<Real> operator* (Real s) const
+		{
+			return IntervalVector3<Real>(m_x * s, m_y * s, m_z * s);
+		}
+
+		COMM_FUNC IntervalBound<Real> dot(const IntervalVector3<Real>& box) const
+		{
+			return m_x * box.m_x + m_y * box.m_y + m_z * box.m_z;
+		}
+
+		COMM_FUNC IntervalVector3<Real> cross(const IntervalVector3<Real>& box) const
+		{
+			return IntervalVector3<Real>(
+				m_y * box.m_z - m_z * box.m_y,
+				m_z * box.m_x - m_x * box.m_z,
+				m_x * box.m_y - m_y * box.m_x);
+		}
+
+		/**
+		* @brief Lower bound on the squared distance between any point of this
+		*        box and any point of the other, rounded down so the bound
+		*        stays conservative.
+		*/
+		COMM_FUNC Real distanceSquaredLower(const IntervalVector3<Real>& box) const
+		{
+			Real gx = componentGap(m_x, box.m_x);
+			Real gy = componentGap(m_y, box.m_y);
+			Real gz = componentGap(m_z, box.m_z);
+
+			Real d2 = IntervalRound::mulDown(gx, gx);
+			d2 = IntervalRound::addDown(d2, IntervalRound::mulDown(gy, gy));
+			d2 = IntervalRound::addDown(d2, IntervalRound::mulDown(gz, gz));
+			return d2;
+		}
+
+	private:
+		COMM_FUNC static Real componentGap(const IntervalBound<Real>& a, const IntervalBound<Real>& b)
+		{
+			if (b.lower() > a.upper())
+			{
+				return IntervalRound::subDown(b.lower(), a.upper());
+			}
+			if (a.lower() > b.upper())
+			{
+				return IntervalRound::subDown(a.lower(), b.upper());
+			}
+			return Real(0);
+		}
+
+		IntervalBound<Real> m_x, m_y, m_z;
+	};
+
+}  //end of namespace PhysIKA
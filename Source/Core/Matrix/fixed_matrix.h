@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Core/Platform.h"
+#include "Core/Vector/fixed_vector.h"
+
+namespace PhysIKA
+{
+	/**
+	 * @brief Stack-allocated matrix with compile-time dimensions and the
+	 * element access interface of MatrixMN.
+	 *
+	 * The articulated-body solvers pass 6x6 spatial inertia matrices around in
+	 * their per-body loops; backing them with MatrixMN means one heap
+	 * allocation per matrix per step. FixedMatrix keeps the same accessors for
+	 * dimensions known at compile time so those loops can work entirely on the
+	 * stack.
+	 */
+	template<typename T, unsigned int M, unsigned int N>
+	class FixedMatrix
+	{
+	public:
+		COMM_FUNC FixedMatrix() { setZeros(); }
+
+		COMM_FUNC inline unsigned int rows() const { return M; }
+		COMM_FUNC inline unsigned int cols() const { return N; }
+
+		COMM_FUNC void setZeros()
+		{
+			for (unsigned int i = 0; i < M * N; ++i)
+			{
+				m_data[i] = T(0);
+			}
+		}
+
+		COMM_FUNC inline T& operator()(unsigned int i, unsigned int j) { return m_data[i * N + j]; }
+		COMM_FUNC inline const T& operator()(unsigned int i, unsigned int j) const { return m_data[i * N + j]; }
+
+		COMM_FUNC const FixedMatrix<T, M, N> operator+ (const FixedMatrix<T, M, N>& m) const
+		{
+			FixedMatrix<T, M, N> res;
+			for (unsigned int i = 0; i < M * N; ++i)
+			{
+				res.m_data[i] = m_data[i] + m.m_data[i];
+			}
+			return res;
+		}
+
+		COMM_FUNC const FixedMatrix<T, M, N> operator- (const FixedMatrix<T, M, N>& m) const
+		{
+			FixedMatrix<T, M, N> res;
+			for (unsigned int i = 0; i < M * N; ++i)
+			{
+				res.m_data[i] = m_data[i] - m.m_data[i];
+			}
+			return res;
+		}
+
+		COMM_FUNC const FixedMatrix<T, M, N> operator* (T s) const
+		{
+			FixedMatrix<T, M, N> res;
+			for (unsigned int i = 0; i < M * N; ++i)
+			{
+				res.m_data[i] = m_data[i] * s;
+			}
+			return res;
+		}
+
+		COMM_FUNC const FixedVector<T, M> operator* (const FixedVector<T, N>& v) const
+		{
+			FixedVector<T, M> res;
+			for (unsigned int i = 0; i < M; ++i)
+			{
+				T sum = T(0);
+				for (unsigned int j = 0; j < N; ++j)
+				{
+					sum += (*this)(i, j) * v[j];
+				}
+				res[i] = sum;
+			}
+			return res;
+		}
+
+	private:
+		T m_data[M * N];
+	};
+}
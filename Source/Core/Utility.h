@@ -6,8 +6,11 @@
 
 #include "Utility/Function1Pt.h"
 #include "Utility/Function2Pt.h"
+#include "Utility/FunctionConvert.h"
+#include "Utility/Coord4.h"
 #include "Utility/Reduction.h"
 #include "Utility/Arithmetic.h"
 #include "Utility/CTimer.h"
 #include "Utility/GTimer.h"
-#include "Utility/Scan.h"
\ No newline at end of file
+#include "Utility/Scan.h"
+#include "Utility/Sort.h"
\ No newline at end of file
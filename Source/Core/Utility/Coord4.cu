@@ -0,0 +1,91 @@
+#include <cuda_runtime.h>
+#include "Coord4.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	namespace FunctionPack
+	{
+		template <typename TCoord4, typename TCoord>
+		__global__ void KerPack(TCoord4* dst, TCoord* src, int num)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			TCoord s = src[pId];
+			TCoord4 d;
+			d.x = s[0]; d.y = s[1]; d.z = s[2]; d.w = 0;
+			dst[pId] = d;
+		}
+
+		template <typename TCoord, typename TCoord4>
+		__global__ void KerUnpack(TCoord* dst, TCoord4* src, int num)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			TCoord4 s = src[pId];
+			dst[pId] = TCoord(s.x, s.y, s.z);
+		}
+
+		__global__ void KerPackRaw(float4* dst, float3* src, int num)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			float3 s = src[pId];
+			dst[pId] = make_float4(s.x, s.y, s.z, 0.0f);
+		}
+
+		__global__ void KerUnpackRaw(float3* dst, float4* src, int num)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			float4 s = src[pId];
+			dst[pId] = make_float3(s.x, s.y, s.z);
+		}
+
+		void pack(DeviceArray<float4>& dst, DeviceArray<Vector3f>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerPack << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void pack(DeviceArray<double4>& dst, DeviceArray<Vector3d>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerPack << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void pack(DeviceArray<float4>& dst, DeviceArray<float3>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerPackRaw << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void unpack(DeviceArray<Vector3f>& dst, DeviceArray<float4>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerUnpack << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void unpack(DeviceArray<Vector3d>& dst, DeviceArray<double4>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerUnpack << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void unpack(DeviceArray<float3>& dst, DeviceArray<float4>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerUnpackRaw << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector_types.h>
+#include <vector_functions.h>
+#include "Core/Platform.h"
+#include "Core/Array/Array.h"
+#include "Core/Vector.h"
+/*
+*  Aligned position storage for gather-heavy kernels. A Vector3f is 12
+*  bytes, so a neighbor gather issues three 4-byte loads that straddle
+*  cache lines; packed as float4/double4 (position plus a free w lane)
+*  the same gather is one aligned vector load. Coord4Type maps a Real
+*  to its packed coordinate type, the inline helpers convert between
+*  the layouts inside kernels, and FunctionPack mirrors whole arrays;
+*  hot modules keep a packed mirror of the position array and repack
+*  once per sweep.
+*/
+
+namespace PhysIKA
+{
+	template<typename Real> struct Coord4Type;
+
+	template<> struct Coord4Type<float>
+	{
+		typedef float4 type;
+	};
+
+	template<> struct Coord4Type<double>
+	{
+		typedef double4 type;
+	};
+
+	COMM_FUNC inline float4 makeCoord4(const Vector3f& v, float w)
+	{
+		return make_float4(v[0], v[1], v[2], w);
+	}
+
+	COMM_FUNC inline double4 makeCoord4(const Vector3d& v, double w)
+	{
+		return make_double4(v[0], v[1], v[2], w);
+	}
+
+	COMM_FUNC inline Vector3f coordPoint(const float4& v)
+	{
+		return Vector3f(v.x, v.y, v.z);
+	}
+
+	COMM_FUNC inline Vector3d coordPoint(const double4& v)
+	{
+		return Vector3d(v.x, v.y, v.z);
+	}
+
+	namespace FunctionPack
+	{
+		void pack(DeviceArray<float4>& dst, DeviceArray<Vector3f>& src);
+		void pack(DeviceArray<double4>& dst, DeviceArray<Vector3d>& src);
+		void pack(DeviceArray<float4>& dst, DeviceArray<float3>& src);
+
+		void unpack(DeviceArray<Vector3f>& dst, DeviceArray<float4>& src);
+		void unpack(DeviceArray<Vector3d>& dst, DeviceArray<double4>& src);
+		void unpack(DeviceArray<float3>& dst, DeviceArray<float4>& src);
+	}
+}
@@ -60,6 +60,22 @@ namespace PhysIKA
 			else if (g1.IsCPU() && g2.IsCPU())	memcpy(g1.GetDataPtr(), g2.GetDataPtr(), totalNum * sizeof(T));
 		}
 
+		/**
+		 * @brief Asynchronous copy on the given stream. The host side must be pinned
+		 * (PinnedHostArray or CudaMemoryManager-backed) for the transfer to actually
+		 * overlap; pageable memory silently degrades to a synchronous copy.
+		 */
+		template<typename T, DeviceType dType1, DeviceType dType2>
+		void copyAsync(Array<T, dType1>& arr1, Array<T, dType2>& arr2, cudaStream_t stream)
+		{
+			assert(arr1.size() == arr2.size());
+			int totalNum = arr1.size();
+			if (arr1.isGPU() && arr2.isGPU())	(cudaMemcpyAsync(arr1.getDataPtr(), arr2.getDataPtr(), totalNum * sizeof(T), cudaMemcpyDeviceToDevice, stream));
+			else if (arr1.isCPU() && arr2.isGPU())	(cudaMemcpyAsync(arr1.getDataPtr(), arr2.getDataPtr(), totalNum * sizeof(T), cudaMemcpyDeviceToHost, stream));
+			else if (arr1.isGPU() && arr2.isCPU())	(cudaMemcpyAsync(arr1.getDataPtr(), arr2.getDataPtr(), totalNum * sizeof(T), cudaMemcpyHostToDevice, stream));
+			else if (arr1.isCPU() && arr2.isCPU())	memcpy(arr1.getDataPtr(), arr2.getDataPtr(), totalNum * sizeof(T));
+		}
+
 		template<typename T1, typename T2>
 		void Length(DeviceArray<T1>& lhs, DeviceArray<T2>& rhs);
 
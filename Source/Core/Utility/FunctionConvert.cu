@@ -0,0 +1,75 @@
+#include <cuda_runtime.h>
+#include "FunctionConvert.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	namespace FunctionConvert
+	{
+		template <typename TDst, typename TSrc>
+		__global__ void KerConvertScalar(TDst* dst, TSrc* src, int num)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			dst[pId] = (TDst)src[pId];
+		}
+
+		template <typename TDst, typename TSrc, int Dim>
+		__global__ void KerConvertVector(Vector<TDst, Dim>* dst, Vector<TSrc, Dim>* src, int num)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			Vector<TSrc, Dim> s = src[pId];
+			Vector<TDst, Dim> d;
+			for (int j = 0; j < Dim; j++)
+			{
+				d[j] = (TDst)s[j];
+			}
+			dst[pId] = d;
+		}
+
+		void convert(DeviceArray<double>& dst, DeviceArray<float>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerConvertScalar << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void convert(DeviceArray<float>& dst, DeviceArray<double>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerConvertScalar << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void convert(DeviceArray<Vector2d>& dst, DeviceArray<Vector2f>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerConvertVector << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void convert(DeviceArray<Vector2f>& dst, DeviceArray<Vector2d>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerConvertVector << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void convert(DeviceArray<Vector3d>& dst, DeviceArray<Vector3f>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerConvertVector << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+
+		void convert(DeviceArray<Vector3f>& dst, DeviceArray<Vector3d>& src)
+		{
+			assert(dst.size() == src.size());
+			unsigned pDim = cudaGridSize(dst.size(), BLOCK_SIZE);
+			KerConvertVector << <pDim, BLOCK_SIZE >> > (dst.getDataPtr(), src.getDataPtr(), dst.size());
+		}
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Core/Vector.h"
+/*
+*  This file implements precision conversion between device arrays, the
+*  boundary piece of mixed-precision simulation: a module can keep its
+*  internal state in double - long rigid chains drift visibly in float -
+*  while exchanging the scene-wide single-precision fields, converting on
+*  the way in and out instead of forcing the whole scene to double.
+*/
+
+namespace PhysIKA
+{
+	namespace FunctionConvert
+	{
+		void convert(DeviceArray<double>& dst, DeviceArray<float>& src);
+		void convert(DeviceArray<float>& dst, DeviceArray<double>& src);
+
+		void convert(DeviceArray<Vector2d>& dst, DeviceArray<Vector2f>& src);
+		void convert(DeviceArray<Vector2f>& dst, DeviceArray<Vector2d>& src);
+
+		void convert(DeviceArray<Vector3d>& dst, DeviceArray<Vector3f>& src);
+		void convert(DeviceArray<Vector3f>& dst, DeviceArray<Vector3d>& src);
+	};
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include "Core/Platform.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility/cuda_utilities.h"
+
+/*
+*  This file implements expression fusion over device arrays. Function2Pt
+*  covers single binary ops, so a chain like a velocity update followed by
+*  a position update costs one full array read/write pass per op. The
+*  templates below build the whole chain as a typed expression on the host
+*  and evaluate it with one kernel: terminals wrap device arrays or
+*  constants, operators compose them, assign() binds an expression to a
+*  destination, and the statements passed to evaluate() run one after the
+*  other inside the same thread - a later statement sees the value an
+*  earlier one just wrote for its element, which is exactly the dependence
+*  of integrator chains.
+*
+*  The kernels live in this header, so include it from .cu files only.
+*
+*  Usage, fusing v += dt * (f + g) with p += dt * v:
+*
+*      using namespace FunctionFuse;
+*      evaluate(num,
+*          assign(vel, term(vel) + scale(dt, term(force) + constant(gravity))),
+*          assign(pos, term(pos) + scale(dt, term(vel))));
+*/
+
+namespace PhysIKA
+{
+	namespace FunctionFuse
+	{
+		template <typename T>
+		struct ArrayTerm
+		{
+			typedef T ValueType;
+			T* data;
+			GPU_FUNC inline T eval(int i) const { return data[i]; }
+		};
+
+		template <typename T>
+		struct ConstTerm
+		{
+			typedef T ValueType;
+			T val;
+			GPU_FUNC inline T eval(int i) const { return val; }
+		};
+
+		template <typename L, typename R>
+		struct AddExpr
+		{
+			typedef typename L::ValueType ValueType;
+			L l; R r;
+			GPU_FUNC inline ValueType eval(int i) const { return l.eval(i) + r.eval(i); }
+		};
+
+		template <typename L, typename R>
+		struct SubExpr
+		{
+			typedef typename L::ValueType ValueType;
+			L l; R r;
+			GPU_FUNC inline ValueType eval(int i) const { return l.eval(i) - r.eval(i); }
+		};
+
+		template <typename S, typename E>
+		struct ScaleExpr
+		{
+			typedef typename E::ValueType ValueType;
+			S s; E e;
+			GPU_FUNC inline ValueType eval(int i) const { return e.eval(i) * s; }
+		};
+
+		template <typename T>
+		inline ArrayTerm<T> term(DeviceArray<T>& arr) { return ArrayTerm<T>{ arr.getDataPtr() }; }
+
+		template <typename T>
+		inline ConstTerm<T> constant(T val) { return ConstTerm<T>{ val }; }
+
+		template <typename S, typename E>
+		inline ScaleExpr<S, E> scale(S s, E e) { return ScaleExpr<S, E>{ s, e }; }
+
+		//found through argument-dependent lookup only, so they never
+		//interfere with operators on ordinary types
+		template <typename L, typename R>
+		inline AddExpr<L, R> operator+(L l, R r) { return AddExpr<L, R>{ l, r }; }
+
+		template <typename L, typename R>
+		inline SubExpr<L, R> operator-(L l, R r) { return SubExpr<L, R>{ l, r }; }
+
+		template <typename T, typename E>
+		struct AssignStmt
+		{
+			T* dst; E expr;
+			GPU_FUNC inline void run(int i) const { dst[i] = expr.eval(i); }
+		};
+
+		template <typename T, typename E>
+		inline AssignStmt<T, E> assign(DeviceArray<T>& dst, E expr) { return AssignStmt<T, E>{ dst.getDataPtr(), expr }; }
+
+		template <typename S1>
+		__global__ void KerFusedFunc(int num, S1 s1)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			s1.run(pId);
+		}
+
+		template <typename S1, typename S2>
+		__global__ void KerFusedFunc(int num, S1 s1, S2 s2)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			s1.run(pId);
+			s2.run(pId);
+		}
+
+		template <typename S1, typename S2, typename S3>
+		__global__ void KerFusedFunc(int num, S1 s1, S2 s2, S3 s3)
+		{
+			int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+			if (pId >= num) return;
+
+			s1.run(pId);
+			s2.run(pId);
+			s3.run(pId);
+		}
+
+		template <typename S1>
+		void evaluate(int num, S1 s1)
+		{
+			if (num <= 0) return;
+			unsigned pDim = cudaGridSize(num, BLOCK_SIZE);
+			KerFusedFunc << <pDim, BLOCK_SIZE >> > (num, s1);
+		}
+
+		template <typename S1, typename S2>
+		void evaluate(int num, S1 s1, S2 s2)
+		{
+			if (num <= 0) return;
+			unsigned pDim = cudaGridSize(num, BLOCK_SIZE);
+			KerFusedFunc << <pDim, BLOCK_SIZE >> > (num, s1, s2);
+		}
+
+		template <typename S1, typename S2, typename S3>
+		void evaluate(int num, S1 s1, S2 s2, S3 s3)
+		{
+			if (num <= 0) return;
+			unsigned pDim = cudaGridSize(num, BLOCK_SIZE);
+			KerFusedFunc << <pDim, BLOCK_SIZE >> > (num, s1, s2, s3);
+		}
+	};
+}
@@ -0,0 +1,116 @@
+#include "Percentile.h"
+#include "cuda_utilities.h"
+
+namespace PhysIKA {
+
+	template<typename T>
+	__global__ void PCT_Histogram(
+		int* hist,
+		T* val,
+		int num,
+		T lo,
+		T invWidth)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		int b = (int)((val[pId] - lo) * invWidth);
+		b = b < 0 ? 0 : b;
+		b = b > Percentile<T>::BIN_NUM - 1 ? Percentile<T>::BIN_NUM - 1 : b;
+
+		atomicAdd(&hist[b], 1);
+	}
+
+	template<typename T>
+	Percentile<T>::Percentile()
+	{
+		cuSafeCall(cudaMalloc((void**)&m_hist, BIN_NUM * sizeof(int)));
+		m_reduce = new Reduction<T>();
+	}
+
+	template<typename T>
+	Percentile<T>::~Percentile()
+	{
+		if (m_hist != nullptr)
+		{
+			cudaFree(m_hist);
+		}
+		if (m_reduce != nullptr)
+		{
+			delete m_reduce;
+		}
+	}
+
+	template<typename T>
+	T Percentile<T>::percentile(T* val, int num, float quantile)
+	{
+		if (num <= 0) return T(0);
+
+		//no usable range yet: measure it exactly once
+		if (!(m_hi > m_lo))
+		{
+			m_lo = m_reduce->minimum(val, num);
+			m_hi = m_reduce->maximum(val, num);
+			if (!(m_hi > m_lo))
+			{
+				return m_hi;
+			}
+		}
+
+		T width = (m_hi - m_lo) / T(BIN_NUM);
+		T invWidth = T(1) / width;
+
+		cuSafeCall(cudaMemset(m_hist, 0, BIN_NUM * sizeof(int)));
+		cuExecute(num, PCT_Histogram,
+			m_hist,
+			val,
+			num,
+			m_lo,
+			invWidth);
+		cuSafeCall(cudaMemcpy(m_host, m_hist, BIN_NUM * sizeof(int), cudaMemcpyDeviceToHost));
+
+		int target = (int)(quantile * num + 0.5f);
+		target = target < 1 ? 1 : target;
+
+		int sum = 0;
+		int b = 0;
+		while (b < BIN_NUM - 1 && sum + m_host[b] < target)
+		{
+			sum += m_host[b];
+			b++;
+		}
+
+		//highest occupied bin, for the range adaptation below
+		int bTop = BIN_NUM - 1;
+		while (bTop > 0 && m_host[bTop] == 0)
+		{
+			bTop--;
+		}
+
+		T result;
+		if (b == BIN_NUM - 1)
+		{
+			//the quantile landed in the clamped top bin, where outliers
+			//hide the true edge; answer exactly and widen for next time
+			result = m_reduce->maximum(val, num);
+			m_hi = result > m_hi ? result : m_hi;
+		}
+		else
+		{
+			result = m_lo + T(b + 1) * width;
+		}
+
+		//keep the occupied bins covering most of the range: widen when
+		//the data presses against the top, tighten when it huddles low
+		if (bTop == BIN_NUM - 1)
+		{
+			m_hi = m_lo + (m_hi - m_lo) * T(1.5);
+		}
+		else if (bTop < BIN_NUM / 2)
+		{
+			m_hi = m_lo + T(bTop + 2) * width;
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cuda_runtime.h>
+#include "Reduction.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	Percentile
+	*	\brief	Histogram-based quantile query on device data.
+	*
+	*	A single glitched particle makes Reduction::maximum jumpy, which
+	*	forces anything driven by it - an adaptive timestep above all -
+	*	to stay conservative. This helper answers "which value do q of
+	*	the entries stay below" with one histogram pass over the data
+	*	and a 1KB readback: values are binned over the range observed on
+	*	the previous call (outliers clamp into the edge bins) and the
+	*	host walks the counts to the requested quantile. The range
+	*	adapts between calls, so on temporally coherent data - velocity
+	*	magnitudes across frames - the steady state is one pass; only
+	*	the first call and a quantile landing in the clamped top bin
+	*	fall back to an exact Reduction.
+	*
+	*	The answer is conservative: the upper edge of the bin the
+	*	quantile lands in, at most one bin width above the exact value.
+	*/
+	template<typename T>
+	class Percentile
+	{
+	public:
+		static const int BIN_NUM = 256;
+
+		Percentile();
+		~Percentile();
+
+		/*!
+		*	\brief	Value not exceeded by a fraction quantile (in (0, 1])
+		*	of the num entries; quantile = 1 degenerates to a robust
+		*	maximum estimate.
+		*/
+		T percentile(T* val, int num, float quantile);
+
+	private:
+		int* m_hist = nullptr;
+		int m_host[BIN_NUM];
+
+		//bin range carried between calls
+		T m_lo = T(0);
+		T m_hi = T(0);
+
+		Reduction<T>* m_reduce = nullptr;
+	};
+
+	template class Percentile<float>;
+	template class Percentile<double>;
+}
@@ -3,7 +3,6 @@
 #include <cfloat>
 #include <cuda_runtime.h>
 #include "cuda_utilities.h"
-#include "sharedmem.h"
 #include "Functional.h"
 
 namespace PhysIKA {
@@ -14,6 +13,10 @@ namespace PhysIKA {
 	Reduction<T>::Reduction()
 		: m_num(0)
 		, m_aux(NULL)
+		, m_result(NULL)
+		, m_batchPtrs(NULL)
+		, m_batchAux(NULL)
+		, m_batchCap(0)
 	{
 
 	}
@@ -23,6 +26,10 @@ namespace PhysIKA {
 	Reduction<T>::Reduction(unsigned num)
 		: m_num(num)
 		, m_aux(NULL)
+		, m_result(NULL)
+		, m_batchPtrs(NULL)
+		, m_batchAux(NULL)
+		, m_batchCap(0)
 	{
 		allocAuxiliaryArray(m_num);
 	}
@@ -31,6 +38,12 @@ namespace PhysIKA {
 	Reduction<T>::~Reduction()
 	{
 		cudaFree(m_aux);
+		cudaFree(m_result);
+		if (m_batchPtrs != NULL)
+		{
+			cudaFree(m_batchPtrs);
+			cudaFree(m_batchAux);
+		}
 	}
 
 	template<typename T>
@@ -43,75 +56,139 @@ namespace PhysIKA {
 	template<typename T>
 	int Reduction<T>::getAuxiliaryArraySize(int n)
 	{
-		return (n / REDUCTION_BLOCK + 1) + (n / (REDUCTION_BLOCK*REDUCTION_BLOCK) + REDUCTION_BLOCK);
+		return REDUCTION_BLOCK;
 	}
 
 	/*!
-	*	\brief	Reduction using maximum of float values in shared memory for a warp.
+	*	\brief	Fold the 32 lane values of a warp into lane 0 via register shuffles.
+	*/
+	template <typename T,
+			  typename Function>
+	__device__ inline T KerReduceWarpShfl(T v, Function func)
+	{
+		for (int offset = 16; offset > 0; offset >>= 1)
+		{
+			v = func(v, __shfl_down_sync(0xffffffff, v, offset));
+		}
+		return v;
+	}
+
+	/*!
+	*	\brief	Grid-stride block reduction: each thread folds its strided
+	*	elements in registers, warps combine via shuffles and the per-warp
+	*	partials meet in shared memory, leaving one value per block in pAux[].
 	*/
 	template <typename T, 
 			  unsigned blockSize,
 			  typename Function>
-	__device__ 	void KerReduceWarp(volatile T* pData, unsigned tid, Function func)
+	__global__ void KerReduceBlocks(const T *pData, unsigned n, T *pAux, Function func, T val)
 	{
-		if (blockSize >= 64)pData[tid] = func(pData[tid], pData[tid + 32]);
-		if (blockSize >= 32)pData[tid] = func(pData[tid], pData[tid + 16]);
-		if (blockSize >= 16)pData[tid] = func(pData[tid], pData[tid + 8]);
-		if (blockSize >= 8)pData[tid] = func(pData[tid], pData[tid + 4]);
-		if (blockSize >= 4)pData[tid] = func(pData[tid], pData[tid + 2]);
-		if (blockSize >= 2)pData[tid] = func(pData[tid], pData[tid + 1]);
+		__shared__ T warpRes[blockSize / 32];
+
+		unsigned tid = threadIdx.x;
+
+		T v = val;
+		for (unsigned id = blockIdx.x*blockDim.x + tid; id < n; id += blockDim.x*gridDim.x)
+		{
+			v = func(v, pData[id]);
+		}
+
+		v = KerReduceWarpShfl(v, func);
+		if ((tid & 31) == 0) warpRes[tid >> 5] = v;
+		__syncthreads();
+
+		if (tid < 32)
+		{
+			v = tid < blockSize / 32 ? warpRes[tid] : val;
+			v = KerReduceWarpShfl(v, func);
+			if (tid == 0) pAux[blockIdx.x] = v;
+		}
 	}
 
 	/*!
-	*	\brief	Accumulates the sum of n values of array pData[], 
-	*	storing the result in the beginning of res[].
-	*	(Many positions of res[] are used as blocks, storing the final result in res[0]).
+	*	\brief	Batched variant: blockIdx.y selects the array, partials land
+	*	in a row of pAux per array.
 	*/
-	template <typename T, 
+	template <typename T,
 			  unsigned blockSize,
 			  typename Function>
-	__global__ void KerReduce(const T *pData, unsigned n, T *pAux, Function func, T val)
+	__global__ void KerReduceBlocksBatched(T* const* pData, unsigned n, T *pAux, unsigned auxPitch, Function func, T val)
 	{
-		//extern __shared__ T sharedMem[];
+		__shared__ T warpRes[blockSize / 32];
+
+		unsigned tid = threadIdx.x;
+		const T* data = pData[blockIdx.y];
+
+		T v = val;
+		for (unsigned id = blockIdx.x*blockDim.x + tid; id < n; id += blockDim.x*gridDim.x)
+		{
+			v = func(v, data[id]);
+		}
 
-		SharedMemory<T> smem;
-		T* sharedMem = smem.getPointer();
+		v = KerReduceWarpShfl(v, func);
+		if ((tid & 31) == 0) warpRes[tid >> 5] = v;
+		__syncthreads();
+
+		if (tid < 32)
+		{
+			v = tid < blockSize / 32 ? warpRes[tid] : val;
+			v = KerReduceWarpShfl(v, func);
+			if (tid == 0) pAux[blockIdx.y*auxPitch + blockIdx.x] = v;
+		}
+	}
+
+	/*!
+	*	\brief	One block per row: fold a row of block partials into pResults[row].
+	*/
+	template <typename T,
+			  unsigned blockSize,
+			  typename Function>
+	__global__ void KerReduceRows(const T *pAux, unsigned n, unsigned auxPitch, T *pResults, Function func, T val)
+	{
+		__shared__ T warpRes[blockSize / 32];
 
 		unsigned tid = threadIdx.x;
-		unsigned id = blockIdx.x*blockDim.x + threadIdx.x;
-		sharedMem[tid] = (id < n ? pData[id] : val);
+		const T* row = pAux + blockIdx.x*auxPitch;
+
+		T v = tid < n ? row[tid] : val;
+
+		v = KerReduceWarpShfl(v, func);
+		if ((tid & 31) == 0) warpRes[tid >> 5] = v;
 		__syncthreads();
-		if (blockSize >= 512) { if (tid < 256)sharedMem[tid] = func(sharedMem[tid], sharedMem[tid + 256]);  __syncthreads(); }
-		if (blockSize >= 256) { if (tid < 128)sharedMem[tid] = func(sharedMem[tid], sharedMem[tid + 128]);  __syncthreads(); }
-		if (blockSize >= 128) { if (tid < 64) sharedMem[tid] = func(sharedMem[tid], sharedMem[tid + 64]);   __syncthreads(); }
-		if (tid < 32)KerReduceWarp<T, blockSize>(sharedMem, tid, func);
-		if (tid == 0)pAux[blockIdx.x] = sharedMem[0];
+
+		if (tid < 32)
+		{
+			v = tid < blockSize / 32 ? warpRes[tid] : val;
+			v = KerReduceWarpShfl(v, func);
+			if (tid == 0) pResults[blockIdx.x] = v;
+		}
 	}
 
+	/*!
+	*	\brief	Two fixed launches: the block pass sweeps the data once with a
+	*	grid-stride loop into at most REDUCTION_BLOCK partials, the row pass
+	*	folds those into pResult[0]. No host synchronization happens here.
+	*/
 	template<typename T, typename Function>
-	T Reduce(T* pData, unsigned num, T* pAux, Function func, T v0)
+	void ReduceToDevice(T* pData, unsigned num, T* pAux, T* pResult, Function func, T v0, cudaStream_t stream)
 	{
-		unsigned n = num;
-		unsigned sharedMemSize = REDUCTION_BLOCK * sizeof(T);
 		unsigned blockNum = cudaGridSize(num, REDUCTION_BLOCK);
-		T* subData = pData;
-		T* aux1 = pAux;
-		T* aux2 = pAux + blockNum;
-		T* subAux = aux1;
-		while (n > 1) {
-			KerReduce<T, REDUCTION_BLOCK, Function> << <blockNum, REDUCTION_BLOCK, sharedMemSize >> > (subData, n, subAux, func, v0);
-			n = blockNum; 
-			blockNum = cudaGridSize(n, REDUCTION_BLOCK);
-			if (n > 1) {
-				subData = subAux; subAux = (subData == aux1 ? aux2 : aux1);
-			}
-		}
+		blockNum = blockNum < REDUCTION_BLOCK ? blockNum : REDUCTION_BLOCK;
+
+		KerReduceBlocks<T, REDUCTION_BLOCK, Function> << <blockNum, REDUCTION_BLOCK, 0, stream >> > (pData, num, pAux, func, v0);
+		KerReduceRows<T, REDUCTION_BLOCK, Function> << <1, REDUCTION_BLOCK, 0, stream >> > (pAux, blockNum, blockNum, pResult, func, v0);
+	}
+
+	template<typename T, typename Function>
+	T Reduce(T* pData, unsigned num, T* pAux, T* pResult, Function func, T v0)
+	{
+		ReduceToDevice(pData, num, pAux, pResult, func, v0, (cudaStream_t)0);
+
+		//blocking readback of the scalar result; visible in the sync audit
+		SyncAudit::getInstance().onImplicitSync("Reduction readback");
 
 		T val;
-		if (num > 1)
-			cudaMemcpy(&val, subAux, sizeof(T), cudaMemcpyDeviceToHost);
-		else 
-			cudaMemcpy(&val, pData, sizeof(T), cudaMemcpyDeviceToHost);
+		cudaMemcpy(&val, pResult, sizeof(T), cudaMemcpyDeviceToHost);
 
 		return val;
 	}
@@ -122,7 +199,7 @@ namespace PhysIKA {
 		if (num != m_num)
 			allocAuxiliaryArray(num);
 
-		return Reduce(val, num, m_aux, PlusFunc<T>(), (T)0);
+		return Reduce(val, num, m_aux, m_result, PlusFunc<T>(), (T)0);
 	}
 
 	template<typename T>
@@ -131,7 +208,7 @@ namespace PhysIKA {
 		if (num != m_num)
 			allocAuxiliaryArray(num);
 
-		return Reduce(val, num, m_aux, MaximumFunc<T>(), (T)-FLT_MAX);
+		return Reduce(val, num, m_aux, m_result, MaximumFunc<T>(), (T)-FLT_MAX);
 	}
 
 	template<typename T>
@@ -140,7 +217,7 @@ namespace PhysIKA {
 		if (num != m_num)
 			allocAuxiliaryArray(num);
 
-		return Reduce(val, num, m_aux, MinimumFunc<T>(), (T)FLT_MAX);
+		return Reduce(val, num, m_aux, m_result, MinimumFunc<T>(), (T)FLT_MAX);
 	}
 
 	template<typename T>
@@ -149,13 +226,83 @@ namespace PhysIKA {
 		if (num != m_num)
 			allocAuxiliaryArray(num);
 
-		return Reduce(val, num, m_aux, PlusFunc<T>(), (T)0) / num;
+		return Reduce(val, num, m_aux, m_result, PlusFunc<T>(), (T)0) / num;
+	}
+
+	template<typename T>
+	T* PhysIKA::Reduction<T>::accumulateAsync(T* val, int num, cudaStream_t stream)
+	{
+		if (num != m_num)
+			allocAuxiliaryArray(num);
+
+		ReduceToDevice(val, (unsigned)num, m_aux, m_result, PlusFunc<T>(), (T)0, stream);
+		return m_result;
+	}
+
+	template<typename T>
+	T* PhysIKA::Reduction<T>::maximumAsync(T* val, int num, cudaStream_t stream)
+	{
+		if (num != m_num)
+			allocAuxiliaryArray(num);
+
+		ReduceToDevice(val, (unsigned)num, m_aux, m_result, MaximumFunc<T>(), (T)-FLT_MAX, stream);
+		return m_result;
+	}
+
+	template<typename T>
+	T* PhysIKA::Reduction<T>::minimumAsync(T* val, int num, cudaStream_t stream)
+	{
+		if (num != m_num)
+			allocAuxiliaryArray(num);
+
+		ReduceToDevice(val, (unsigned)num, m_aux, m_result, MinimumFunc<T>(), (T)FLT_MAX, stream);
+		return m_result;
+	}
+
+	template<typename T, typename Function>
+	void ReduceBatched(T* const* vals, int batchSize, int num, T** devPtrs, T* batchAux, T* results, Function func, T v0, cudaStream_t stream)
+	{
+		cudaMemcpyAsync(devPtrs, vals, batchSize * sizeof(T*), cudaMemcpyHostToDevice, stream);
+
+		unsigned blockNum = cudaGridSize(num, REDUCTION_BLOCK);
+		blockNum = blockNum < REDUCTION_BLOCK ? blockNum : REDUCTION_BLOCK;
+
+		dim3 grid(blockNum, batchSize);
+		KerReduceBlocksBatched<T, REDUCTION_BLOCK, Function> << <grid, REDUCTION_BLOCK, 0, stream >> > (devPtrs, (unsigned)num, batchAux, blockNum, func, v0);
+		KerReduceRows<T, REDUCTION_BLOCK, Function> << <batchSize, REDUCTION_BLOCK, 0, stream >> > (batchAux, blockNum, blockNum, results, func, v0);
+	}
+
+	template<typename T>
+	void PhysIKA::Reduction<T>::accumulateBatched(T* const* vals, int batchSize, int num, T* results, cudaStream_t stream)
+	{
+		if (batchSize > m_batchCap)
+			allocBatchArray(batchSize);
+
+		ReduceBatched(vals, batchSize, num, m_batchPtrs, m_batchAux, results, PlusFunc<T>(), (T)0, stream);
+	}
+
+	template<typename T>
+	void PhysIKA::Reduction<T>::maximumBatched(T* const* vals, int batchSize, int num, T* results, cudaStream_t stream)
+	{
+		if (batchSize > m_batchCap)
+			allocBatchArray(batchSize);
+
+		ReduceBatched(vals, batchSize, num, m_batchPtrs, m_batchAux, results, MaximumFunc<T>(), (T)-FLT_MAX, stream);
+	}
+
+	template<typename T>
+	void PhysIKA::Reduction<T>::minimumBatched(T* const* vals, int batchSize, int num, T* results, cudaStream_t stream)
+	{
+		if (batchSize > m_batchCap)
+			allocBatchArray(batchSize);
+
+		ReduceBatched(vals, batchSize, num, m_batchPtrs, m_batchAux, results, MinimumFunc<T>(), (T)FLT_MAX, stream);
 	}
 
 	template<typename T>
 	void Reduction<T>::allocAuxiliaryArray(int num)
 	{
-		if (m_aux == nullptr)
+		if (m_aux != NULL)
 		{
 			cudaFree(m_aux);
 		}
@@ -164,6 +311,25 @@ namespace PhysIKA {
 
 		m_auxNum = getAuxiliaryArraySize(num);
 		cudaMalloc((void**)&m_aux, m_auxNum * sizeof(T));
+
+		if (m_result == NULL)
+		{
+			cudaMalloc((void**)&m_result, sizeof(T));
+		}
+	}
+
+	template<typename T>
+	void Reduction<T>::allocBatchArray(int batchSize)
+	{
+		if (m_batchPtrs != NULL)
+		{
+			cudaFree(m_batchPtrs);
+			cudaFree(m_batchAux);
+		}
+
+		m_batchCap = batchSize;
+		cudaMalloc((void**)&m_batchPtrs, batchSize * sizeof(T*));
+		cudaMalloc((void**)&m_batchAux, batchSize * REDUCTION_BLOCK * sizeof(T));
 	}
 
-}
\ No newline at end of file
+}
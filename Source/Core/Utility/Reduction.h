@@ -1,4 +1,6 @@
 #pragma once
+#include <cuda_runtime.h>
+
 namespace PhysIKA {
 
 	template<typename T>
@@ -18,17 +20,47 @@ namespace PhysIKA {
 
 		T average(T* val, int num);
 
+		/*!
+		*	\brief	Queue the reduction on a stream and return a device pointer
+		*	to the result without synchronizing the host. The pointer stays
+		*	valid until the next call on this instance.
+		*/
+		T* accumulateAsync(T* val, int num, cudaStream_t stream = 0);
+
+		T* maximumAsync(T* val, int num, cudaStream_t stream = 0);
+
+		T* minimumAsync(T* val, int num, cudaStream_t stream = 0);
+
+		/*!
+		*	\brief	Reduce batchSize equally sized arrays in one launch.
+		*	vals is a host array of device pointers, results a device array
+		*	of batchSize entries.
+		*/
+		void accumulateBatched(T* const* vals, int batchSize, int num, T* results, cudaStream_t stream = 0);
+
+		void maximumBatched(T* const* vals, int batchSize, int num, T* results, cudaStream_t stream = 0);
+
+		void minimumBatched(T* const* vals, int batchSize, int num, T* results, cudaStream_t stream = 0);
+
 	private:
 		Reduction(unsigned num);
 
 		void allocAuxiliaryArray(int num);
 
+		void allocBatchArray(int batchSize);
+
 		int getAuxiliaryArraySize(int n);
 		
 		unsigned m_num;
 		
 		T* m_aux;
 		int m_auxNum;
+
+		T* m_result;
+
+		T** m_batchPtrs;
+		T* m_batchAux;
+		int m_batchCap;
 	};
 
 
@@ -3,8 +3,16 @@
 
 namespace PhysIKA
 {
-#define SCAN_LEVEL 2
-
+	/**
+	* @brief Exclusive prefix sum with persistent temporary storage.
+	* @details Backed by the single-pass decoupled-lookback scan from CUB,
+	*          which replaces the earlier multi-kernel Blelloch implementation;
+	*          the temporary storage is kept between calls and only grows, so
+	*          the per-frame scans issued by neighbor-list construction pay no
+	*          device allocation in steady state. The bcao flag tuned shared
+	*          memory bank conflicts in the old implementation and is kept only
+	*          so existing call sites compile unchanged; it has no effect.
+	*/
 	class Scan
 	{
 	public:
@@ -18,21 +26,9 @@ namespace PhysIKA
 		void exclusive(DeviceArray<int>& data, bool bcao = true);
 
 	private:
-		void scanLargeDeviceArray(int *d_out, int *d_in, int length, bool bcao, int level);
-		void scanSmallDeviceArray(int *d_out, int *d_in, int length, bool bcao);
-		void scanLargeEvenDeviceArray(int *output, int *input, int length, bool bcao, int level);
-
-		bool isPowerOfTwo(int x);
-		int nextPowerOfTwo(int x);
-
-
-	private:
-		DeviceArray<int> m_buffer;
-
-		DeviceArray<int> m_sums[SCAN_LEVEL];
-		DeviceArray<int> m_incr[SCAN_LEVEL];
+		/// grow-only CUB temporary storage, reused across calls
+		void* m_temp = nullptr;
+		size_t m_tempBytes = 0;
 	};
 
 }
-
-
@@ -0,0 +1,127 @@
+#include "Sort.h"
+#include <cuda_runtime.h>
+#include <cub/cub.cuh>
+#include "cuda_utilities.h"
+
+namespace PhysIKA
+{
+	Sort::Sort()
+	{
+	}
+
+	Sort::~Sort()
+	{
+		if (m_temp != nullptr)
+		{
+			cudaFree(m_temp);
+		}
+		if (m_keyAlt != nullptr)
+		{
+			cudaFree(m_keyAlt);
+		}
+		if (m_valAlt != nullptr)
+		{
+			cudaFree(m_valAlt);
+		}
+	}
+
+	void* Sort::reserve(void*& buf, size_t& capacity, size_t bytes)
+	{
+		if (bytes > capacity)
+		{
+			if (buf != nullptr)
+			{
+				cuSafeCall(cudaFree(buf));
+			}
+			cuSafeCall(cudaMalloc(&buf, bytes));
+			capacity = bytes;
+		}
+		return buf;
+	}
+
+	template<typename TKey, typename TVal>
+	void Sort::sortByKey(TKey* keys, TVal* values, int length)
+	{
+		if (length <= 0) return;
+
+		TKey* keyAlt = (TKey*)reserve(m_keyAlt, m_keyAltBytes, length * sizeof(TKey));
+		TVal* valAlt = (TVal*)reserve(m_valAlt, m_valAltBytes, length * sizeof(TVal));
+
+		cub::DoubleBuffer<TKey> dKeys(keys, keyAlt);
+		cub::DoubleBuffer<TVal> dVals(values, valAlt);
+
+		size_t required = 0;
+		cub::DeviceRadixSort::SortPairs(nullptr, required, dKeys, dVals, length);
+		reserve(m_temp, m_tempBytes, required);
+
+		size_t avail = m_tempBytes;
+		cub::DeviceRadixSort::SortPairs(m_temp, avail, dKeys, dVals, length);
+
+		//the sorted sequence may end up in the partner buffer
+		if (dKeys.Current() != keys)
+		{
+			cuSafeCall(cudaMemcpy(keys, dKeys.Current(), length * sizeof(TKey), cudaMemcpyDeviceToDevice));
+			cuSafeCall(cudaMemcpy(values, dVals.Current(), length * sizeof(TVal), cudaMemcpyDeviceToDevice));
+		}
+	}
+
+	template<typename TKey, typename TVal>
+	void Sort::sortByKey(DeviceArray<TKey>& keys, DeviceArray<TVal>& values)
+	{
+		assert(keys.size() == values.size());
+		sortByKey(keys.getDataPtr(), values.getDataPtr(), keys.size());
+	}
+
+	template<typename TKey, typename TVal>
+	void Sort::sortByKeySegmented(TKey* keys, TVal* values, int length, int* segBegin, int* segEnd, int segNum)
+	{
+		if (length <= 0 || segNum <= 0) return;
+
+		TKey* keyAlt = (TKey*)reserve(m_keyAlt, m_keyAltBytes, length * sizeof(TKey));
+		TVal* valAlt = (TVal*)reserve(m_valAlt, m_valAltBytes, length * sizeof(TVal));
+
+		cub::DoubleBuffer<TKey> dKeys(keys, keyAlt);
+		cub::DoubleBuffer<TVal> dVals(values, valAlt);
+
+		size_t required = 0;
+		cub::DeviceSegmentedRadixSort::SortPairs(nullptr, required, dKeys, dVals, length, segNum, segBegin, segEnd);
+		reserve(m_temp, m_tempBytes, required);
+
+		size_t avail = m_tempBytes;
+		cub::DeviceSegmentedRadixSort::SortPairs(m_temp, avail, dKeys, dVals, length, segNum, segBegin, segEnd);
+
+		if (dKeys.Current() != keys)
+		{
+			cuSafeCall(cudaMemcpy(keys, dKeys.Current(), length * sizeof(TKey), cudaMemcpyDeviceToDevice));
+			cuSafeCall(cudaMemcpy(values, dVals.Current(), length * sizeof(TVal), cudaMemcpyDeviceToDevice));
+		}
+	}
+
+	template<typename TKey, typename TVal>
+	void Sort::sortByKeySegmented(DeviceArray<TKey>& keys, DeviceArray<TVal>& values, DeviceArray<int>& segBegin, DeviceArray<int>& segEnd)
+	{
+		assert(keys.size() == values.size());
+		assert(segBegin.size() == segEnd.size());
+		sortByKeySegmented(keys.getDataPtr(), values.getDataPtr(), keys.size(), segBegin.getDataPtr(), segEnd.getDataPtr(), segBegin.size());
+	}
+
+	template void Sort::sortByKey(unsigned int* keys, int* values, int length);
+	template void Sort::sortByKey(unsigned int* keys, float* values, int length);
+	template void Sort::sortByKey(unsigned long long* keys, int* values, int length);
+	template void Sort::sortByKey(unsigned long long* keys, float* values, int length);
+
+	template void Sort::sortByKey(DeviceArray<unsigned int>& keys, DeviceArray<int>& values);
+	template void Sort::sortByKey(DeviceArray<unsigned int>& keys, DeviceArray<float>& values);
+	template void Sort::sortByKey(DeviceArray<unsigned long long>& keys, DeviceArray<int>& values);
+	template void Sort::sortByKey(DeviceArray<unsigned long long>& keys, DeviceArray<float>& values);
+
+	template void Sort::sortByKeySegmented(unsigned int* keys, int* values, int length, int* segBegin, int* segEnd, int segNum);
+	template void Sort::sortByKeySegmented(unsigned int* keys, float* values, int length, int* segBegin, int* segEnd, int segNum);
+	template void Sort::sortByKeySegmented(unsigned long long* keys, int* values, int length, int* segBegin, int* segEnd, int segNum);
+	template void Sort::sortByKeySegmented(unsigned long long* keys, float* values, int length, int* segBegin, int* segEnd, int segNum);
+
+	template void Sort::sortByKeySegmented(DeviceArray<unsigned int>& keys, DeviceArray<int>& values, DeviceArray<int>& segBegin, DeviceArray<int>& segEnd);
+	template void Sort::sortByKeySegmented(DeviceArray<unsigned int>& keys, DeviceArray<float>& values, DeviceArray<int>& segBegin, DeviceArray<int>& segEnd);
+	template void Sort::sortByKeySegmented(DeviceArray<unsigned long long>& keys, DeviceArray<int>& values, DeviceArray<int>& segBegin, DeviceArray<int>& segEnd);
+	template void Sort::sortByKeySegmented(DeviceArray<unsigned long long>& keys, DeviceArray<float>& values, DeviceArray<int>& segBegin, DeviceArray<int>& segEnd);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Core/Array/Array.h"
+
+namespace PhysIKA
+{
+	/**
+	* @brief Key-value radix sort with persistent scratch buffers.
+	* @details Wraps the CUB radix sort the way Scan wraps its prefix sum: the
+	*          temporary storage and the double-buffer partners survive between
+	*          calls and only grow, so per-frame sorts stop paying a device
+	*          allocation on every invocation the way raw thrust calls do.
+	*          Keys are 32 or 64 bit unsigned integers; the segmented variant
+	*          sorts many independent ranges in a single pass.
+	*/
+	class Sort
+	{
+	public:
+		Sort();
+		~Sort();
+
+		/**
+		* @brief Sorts keys ascending, in place, moving the value payload with them.
+		*/
+		template<typename TKey, typename TVal>
+		void sortByKey(TKey* keys, TVal* values, int length);
+
+		template<typename TKey, typename TVal>
+		void sortByKey(DeviceArray<TKey>& keys, DeviceArray<TVal>& values);
+
+		/**
+		* @brief Sorts every segment independently in one pass.
+		* @param segBegin Device array holding the first element of each segment.
+		* @param segEnd Device array holding one past the last element of each segment.
+		*/
+		template<typename TKey, typename TVal>
+		void sortByKeySegmented(TKey* keys, TVal* values, int length, int* segBegin, int* segEnd, int segNum);
+
+		template<typename TKey, typename TVal>
+		void sortByKeySegmented(DeviceArray<TKey>& keys, DeviceArray<TVal>& values, DeviceArray<int>& segBegin, DeviceArray<int>& segEnd);
+
+	private:
+		/// grow-only device buffer, reused across calls
+		void* reserve(void*& buf, size_t& capacity, size_t bytes);
+
+		void* m_temp = nullptr;
+		size_t m_tempBytes = 0;
+
+		void* m_keyAlt = nullptr;
+		size_t m_keyAltBytes = 0;
+
+		void* m_valAlt = nullptr;
+		size_t m_valAltBytes = 0;
+	};
+
+}
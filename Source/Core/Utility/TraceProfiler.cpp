@@ -0,0 +1,206 @@
+#include "TraceProfiler.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace PhysIKA
+{
+	//the GPU lane gets its own timeline row, well clear of real thread slots
+	static const int GPU_TID = 1000;
+
+	TraceProfiler& TraceProfiler::getInstance()
+	{
+		static TraceProfiler instance;
+		return instance;
+	}
+
+	void TraceProfiler::setEnabled(bool enabled)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		if (enabled && !m_epochValid)
+		{
+			//common time base: a CUDA event and the CPU clock captured
+			//back to back; GPU ranges are placed relative to the event,
+			//CPU ranges relative to the clock
+			if (m_epochEvent == NULL)
+			{
+				cudaEventCreate(&m_epochEvent);
+			}
+			cudaEventRecord(m_epochEvent);
+			cudaEventSynchronize(m_epochEvent);
+			m_epoch = std::chrono::steady_clock::now();
+			m_epochValid = true;
+		}
+
+		m_enabled = enabled;
+	}
+
+	void TraceProfiler::setCapacity(size_t events)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_capacity = events < 16 ? 16 : events;
+	}
+
+	void TraceProfiler::nameCurrentThread(const std::string& name)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_threadNames[currentThreadSlot()] = name;
+	}
+
+	double TraceProfiler::nowUs()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_epoch).count();
+	}
+
+	void TraceProfiler::addRange(const std::string& name, double startUs, double durUs)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		Range range;
+		range.name = name;
+		range.tid = currentThreadSlot();
+		range.startUs = startUs;
+		range.durUs = durUs;
+
+		if (m_ranges.size() < m_capacity)
+		{
+			m_ranges.push_back(range);
+		}
+		else
+		{
+			m_ranges[m_head] = range;
+			m_head = (m_head + 1) % m_capacity;
+		}
+	}
+
+	cudaEvent_t TraceProfiler::acquireEvent()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		if (!m_eventPool.empty())
+		{
+			cudaEvent_t ev = m_eventPool.back();
+			m_eventPool.pop_back();
+			return ev;
+		}
+
+		cudaEvent_t ev;
+		cudaEventCreate(&ev);
+		return ev;
+	}
+
+	void TraceProfiler::submitGpuRange(const std::string& name, cudaEvent_t start, cudaEvent_t stop)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		GpuRange range;
+		range.name = name;
+		range.start = start;
+		range.stop = stop;
+		m_pendingGpu.push_back(range);
+	}
+
+	int TraceProfiler::currentThreadSlot()
+	{
+		//caller holds m_mutex
+		auto id = std::this_thread::get_id();
+		auto it = m_threadSlots.find(id);
+		if (it != m_threadSlots.end())
+		{
+			return it->second;
+		}
+
+		int slot = (int)m_threadSlots.size();
+		m_threadSlots[id] = slot;
+		return slot;
+	}
+
+	void TraceProfiler::resolveGpuRanges()
+	{
+		//caller holds m_mutex
+		for (size_t i = 0; i < m_pendingGpu.size(); i++)
+		{
+			GpuRange& pending = m_pendingGpu[i];
+
+			cudaEventSynchronize(pending.stop);
+
+			float startMs = 0.0f;
+			float stopMs = 0.0f;
+			cudaEventElapsedTime(&startMs, m_epochEvent, pending.start);
+			cudaEventElapsedTime(&stopMs, m_epochEvent, pending.stop);
+
+			Range range;
+			range.name = pending.name;
+			range.tid = GPU_TID;
+			range.startUs = startMs * 1000.0;
+			range.durUs = (stopMs - startMs) * 1000.0;
+
+			if (m_ranges.size() < m_capacity)
+			{
+				m_ranges.push_back(range);
+			}
+			else
+			{
+				m_ranges[m_head] = range;
+				m_head = (m_head + 1) % m_capacity;
+			}
+
+			m_eventPool.push_back(pending.start);
+			m_eventPool.push_back(pending.stop);
+		}
+		m_pendingGpu.clear();
+	}
+
+	bool TraceProfiler::exportChromeTracing(const std::string& fileName)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		resolveGpuRanges();
+
+		std::ofstream output(fileName);
+		if (!output.is_open())
+		{
+			return false;
+		}
+
+		output << "{\"traceEvents\":[";
+
+		bool first = true;
+
+		//thread-name metadata so the timeline rows are readable
+		for (auto it = m_threadNames.begin(); it != m_threadNames.end(); ++it)
+		{
+			if (!first) output << ",";
+			first = false;
+			output << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << it->first
+				<< ",\"args\":{\"name\":\"" << it->second << "\"}}";
+		}
+		if (!first) output << ",";
+		output << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << GPU_TID
+			<< ",\"args\":{\"name\":\"GPU\"}}";
+
+		for (size_t i = 0; i < m_ranges.size(); i++)
+		{
+			const Range& range = m_ranges[i];
+			output << ",{\"ph\":\"X\",\"name\":\"" << range.name
+				<< "\",\"pid\":0,\"tid\":" << range.tid
+				<< ",\"ts\":" << range.startUs
+				<< ",\"dur\":" << range.durUs << "}";
+		}
+
+		output << "]}";
+
+		return true;
+	}
+
+	void TraceProfiler::clear()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		resolveGpuRanges();
+		m_ranges.clear();
+		m_head = 0;
+	}
+}
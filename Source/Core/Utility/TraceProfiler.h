@@ -0,0 +1,172 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cuda_runtime.h>
+
+namespace PhysIKA {
+
+/*!
+*	\class	TraceProfiler
+*	\brief	Scoped hierarchical profiler with chrome://tracing export.
+*
+*	CTimer and GTimer measure one interval each and cannot express
+*	nesting or cross-thread overlap. This profiler records named ranges
+*	instead: TraceScope brackets a CPU range on the calling thread and
+*	TraceGpuScope brackets a GPU range with a CUDA event pair, all
+*	against one common time base taken when tracing is enabled. Ranges
+*	on the same thread nest by containment, so wrapping Node::advance,
+*	Module::update and the IO writer loop yields a full sim/render/IO
+*	timeline without manual bookkeeping. Events live in a fixed-size
+*	ring buffer (the newest ones win) and exportChromeTracing() writes
+*	the JSON that chrome://tracing and Perfetto load directly.
+*/
+class TraceProfiler
+{
+public:
+	static TraceProfiler& getInstance();
+
+	/**
+	 * @brief Enabling (re)takes the common time base; a disabled profiler
+	 * makes every scope a no-op.
+	 */
+	void setEnabled(bool enabled);
+	bool isEnabled() { return m_enabled; }
+
+	/**
+	 * @brief Ring-buffer size in events; the oldest events are overwritten.
+	 */
+	void setCapacity(size_t events);
+
+	/**
+	 * @brief Label the calling thread in the exported timeline.
+	 */
+	void nameCurrentThread(const std::string& name);
+
+	/**
+	 * @brief Write all resolved events as chrome://tracing JSON. Pending
+	 * GPU ranges are synchronized first.
+	 */
+	bool exportChromeTracing(const std::string& fileName);
+
+	void clear();
+
+public:
+	//the scope classes below are the intended interface; these are their
+	//record hooks
+	void addRange(const std::string& name, double startUs, double durUs);
+	double nowUs();
+	cudaEvent_t acquireEvent();
+	void submitGpuRange(const std::string& name, cudaEvent_t start, cudaEvent_t stop);
+
+private:
+	TraceProfiler() {};
+
+	int currentThreadSlot();
+	void resolveGpuRanges();
+
+	struct Range
+	{
+		std::string name;
+		int tid;
+		double startUs;
+		double durUs;
+	};
+
+	struct GpuRange
+	{
+		std::string name;
+		cudaEvent_t start;
+		cudaEvent_t stop;
+	};
+
+	bool m_enabled = false;
+	bool m_epochValid = false;
+
+	std::chrono::steady_clock::time_point m_epoch;
+	cudaEvent_t m_epochEvent = NULL;
+
+	size_t m_capacity = 65536;
+	size_t m_head = 0;
+	std::vector<Range> m_ranges;
+
+	std::vector<GpuRange> m_pendingGpu;
+	std::vector<cudaEvent_t> m_eventPool;
+
+	std::map<std::thread::id, int> m_threadSlots;
+	std::map<int, std::string> m_threadNames;
+
+	std::mutex m_mutex;
+};
+
+/*!
+*	\brief	RAII CPU range on the calling thread.
+*/
+class TraceScope
+{
+public:
+	TraceScope(const std::string& name)
+	{
+		m_active = TraceProfiler::getInstance().isEnabled();
+		if (m_active)
+		{
+			m_name = name;
+			m_startUs = TraceProfiler::getInstance().nowUs();
+		}
+	}
+
+	~TraceScope()
+	{
+		if (m_active)
+		{
+			double stopUs = TraceProfiler::getInstance().nowUs();
+			TraceProfiler::getInstance().addRange(m_name, m_startUs, stopUs - m_startUs);
+		}
+	}
+
+private:
+	std::string m_name;
+	double m_startUs = 0.0;
+	bool m_active;
+};
+
+/*!
+*	\brief	RAII GPU range: an event pair around the enclosed launches,
+*	resolved against the common time base at export.
+*/
+class TraceGpuScope
+{
+public:
+	TraceGpuScope(const std::string& name, cudaStream_t stream = 0)
+	{
+		m_active = TraceProfiler::getInstance().isEnabled();
+		if (m_active)
+		{
+			m_name = name;
+			m_stream = stream;
+			m_start = TraceProfiler::getInstance().acquireEvent();
+			cudaEventRecord(m_start, m_stream);
+		}
+	}
+
+	~TraceGpuScope()
+	{
+		if (m_active)
+		{
+			cudaEvent_t stop = TraceProfiler::getInstance().acquireEvent();
+			cudaEventRecord(stop, m_stream);
+			TraceProfiler::getInstance().submitGpuRange(m_name, m_start, stop);
+		}
+	}
+
+private:
+	std::string m_name;
+	cudaStream_t m_stream = 0;
+	cudaEvent_t m_start = NULL;
+	bool m_active;
+};
+
+}
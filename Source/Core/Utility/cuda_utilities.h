@@ -22,6 +22,11 @@
 #include <vector_types.h>
 #include <vector_functions.h>
 #include <iostream>
+#include <unordered_map>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <vector>
 #include "cuda_helper_math.h"
 
 namespace PhysIKA{
@@ -88,6 +93,7 @@ namespace PhysIKA{
 #else
 #define cuSynchronize()	{						\
 		char str[200];							\
+		PhysIKA::SyncAudit::getInstance().onSync(__FILE__, __LINE__);	\
 		cudaDeviceSynchronize();				\
 		cudaError_t err = cudaGetLastError();	\
 		if (err != cudaSuccess)					\
@@ -98,6 +104,471 @@ namespace PhysIKA{
 	}
 #endif
 
+/*!
+*	\class	SyncAudit
+*	\brief	Per-frame census of host-device synchronization points.
+*
+*	In release builds cuSynchronize compiles away, so kernel launches run
+*	free of per-launch syncs; errors surface through the per-frame
+*	sentinel (checkFrameSentinel) instead of a sync after every launch.
+*	What still stalls the pipeline are the remaining blocking calls:
+*	debug-build cuSynchronize sites and implicit syncs such as the
+*	device-to-host readback inside Reduction. Each one costs tens of
+*	microseconds of idle GPU. When the audit is enabled every such site
+*	reports itself here; SceneGraph resets the counters per frame and
+*	prints one line per site, so stray syncs can be found and driven to
+*	zero instead of being rediscovered in profiler timelines.
+*/
+class SyncAudit
+{
+public:
+	static SyncAudit& getInstance()
+	{
+		static SyncAudit instance;
+		return instance;
+	}
+
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	bool isEnabled() { return m_enabled; }
+
+	/**
+	 * @brief Record one synchronization at file:line; called by the
+	 * cuSynchronize macro. Costs a branch while the audit is off.
+	 */
+	void onSync(const char* file, int line)
+	{
+		if (!m_enabled) return;
+
+		std::lock_guard<std::mutex> guard(m_mutex);
+		std::stringstream ss;
+		ss << file << ":" << line;
+		m_sites[ss.str()]++;
+		m_frameSyncs++;
+	}
+
+	/**
+	 * @brief Record one implicitly synchronizing call (a blocking
+	 * readback, an unpooled allocation) under a descriptive label.
+	 */
+	void onImplicitSync(const char* label)
+	{
+		if (!m_enabled) return;
+
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_sites[label]++;
+		m_frameSyncs++;
+	}
+
+	/**
+	 * @brief Reset the counters; called at the start of every frame.
+	 */
+	void beginFrame()
+	{
+		if (!m_enabled) return;
+
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_sites.clear();
+		m_frameSyncs = 0;
+	}
+
+	/**
+	 * @brief Synchronizations recorded since beginFrame().
+	 */
+	unsigned int frameSyncs() { return m_frameSyncs; }
+
+	/**
+	 * @brief One line per synchronizing site with its count this frame.
+	 */
+	std::string report()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		std::stringstream ss;
+		ss << "Synchronization audit: " << m_frameSyncs << " syncs this frame" << std::endl;
+		for (auto it = m_sites.begin(); it != m_sites.end(); ++it)
+		{
+			ss << "  " << it->first << ": " << it->second << std::endl;
+		}
+		return ss.str();
+	}
+
+private:
+	SyncAudit() {};
+
+	bool m_enabled = false;
+	unsigned int m_frameSyncs = 0;
+	std::unordered_map<std::string, unsigned int> m_sites;
+	std::mutex m_mutex;
+};
+
+/**
+ * @brief Deferred error sentinel: probe the sticky CUDA error state once,
+ * without synchronizing the device. Launch failures and faults from earlier
+ * asynchronous work stick in the runtime and show up here at the latest, so
+ * release builds keep error coverage at one cheap probe per frame instead of
+ * a cudaDeviceSynchronize behind every launch. The attribution is coarser
+ * than debug-build cuSynchronize - the error names the frame, not the
+ * kernel - which is the trade for never stalling the pipeline.
+ */
+static inline void checkFrameSentinel(long frame)
+{
+	cudaError_t err = cudaPeekAtLastError();
+	if (err != cudaSuccess)
+	{
+		std::stringstream ss;
+		ss << "CUDA error: " << err << " : " << cudaGetErrorString(err)
+			<< " detected by the frame sentinel at frame " << frame
+			<< " (enable a debug build for per-launch attribution)";
+		throw std::runtime_error(ss.str());
+	}
+}
+
+/*!
+*	\class	LaunchConfigCache
+*	\brief	Occupancy-derived launch configurations, cached per kernel.
+*
+*	The fixed BLOCK_SIZE of cuExecute leaves many kernels below their best
+*	occupancy. blockSizeFor() asks the occupancy API once per kernel entry
+*	point, remembers the answer, and records the theoretical occupancy so
+*	the profiler report can show which kernels run badly configured.
+*/
+class LaunchConfigCache
+{
+public:
+	static LaunchConfigCache& getInstance()
+	{
+		static LaunchConfigCache instance;
+		return instance;
+	}
+
+	cuint blockSizeFor(const void* kernel, const char* name)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		auto it = m_configs.find(kernel);
+		if (it != m_configs.end())
+		{
+			return it->second.blockSize;
+		}
+
+		int minGridSize = 0;
+		int blockSize = BLOCK_SIZE;
+		if (cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, kernel) != cudaSuccess || blockSize <= 0)
+		{
+			blockSize = BLOCK_SIZE;
+		}
+
+		Config config;
+		config.name = name;
+		config.blockSize = blockSize;
+		config.occupancy = 0.0f;
+
+		int blocksPerSM = 0;
+		if (cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blocksPerSM, kernel, blockSize, 0) == cudaSuccess)
+		{
+			int device = 0;
+			cudaDeviceProp prop;
+			cudaGetDevice(&device);
+			if (cudaGetDeviceProperties(&prop, device) == cudaSuccess && prop.maxThreadsPerMultiProcessor > 0)
+			{
+				config.occupancy = (float)(blocksPerSM * blockSize) / (float)prop.maxThreadsPerMultiProcessor;
+			}
+		}
+
+		m_configs[kernel] = config;
+
+		return (cuint)blockSize;
+	}
+
+	/**
+	 * @brief One line per tuned kernel: chosen block size and theoretical
+	 * occupancy at that size.
+	 */
+	std::string report()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		std::stringstream ss;
+		ss << "Kernel launch configurations (block size | occupancy)" << std::endl;
+		for (auto it = m_configs.begin(); it != m_configs.end(); ++it)
+		{
+			ss << it->second.name << ": " << it->second.blockSize << " | " << it->second.occupancy << std::endl;
+		}
+		return ss.str();
+	}
+
+private:
+	LaunchConfigCache() {};
+
+	struct Config
+	{
+		std::string name;
+		int blockSize = BLOCK_SIZE;
+		float occupancy = 0.0f;
+	};
+
+	std::unordered_map<const void*, Config> m_configs;
+	std::mutex m_mutex;
+};
+
+/*!
+*	\class	KernelStats
+*	\brief	Optional per-kernel launch instrumentation behind cuExecute.
+*
+*	When enabled, every launch going through the cuExecute macros is
+*	bracketed with CUDA events and attributed to the module currently
+*	executing (Module::update() brackets execution with beginModule()/
+*	endModule()). endModule() resolves the outstanding events and folds
+*	the samples into per-kernel and per-module aggregates: launch count,
+*	summed kernel milliseconds and the launch-weighted occupancy from the
+*	occupancy API at the used block size, which is the closest figure
+*	available without a CUPTI session. Module::update() publishes the
+*	per-module aggregate through fields, so the property panel and the
+*	Python binding can watch a solver's kernels live. Disabled, the hooks
+*	cost a single branch per launch.
+*/
+class KernelStats
+{
+public:
+	struct ModuleCounters
+	{
+		unsigned int launches = 0;
+		float kernelMs = 0.0f;
+		float occupancy = 0.0f;		//launch-weighted, theoretical at the used block size
+	};
+
+	static KernelStats& getInstance()
+	{
+		static KernelStats instance;
+		return instance;
+	}
+
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	bool isEnabled() { return m_enabled; }
+
+	/**
+	 * @brief Open a module scope; launches until endModule() are
+	 * attributed to name. The working counters of that module restart.
+	 */
+	void beginModule(const std::string& name)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_currentModule = name;
+	}
+
+	void onLaunch(const void* kernel, const char* name, cuint blockNum, cuint blockSize, cudaStream_t stream = 0)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		Sample s;
+		s.kernel = kernel;
+		s.name = name;
+		s.blockSize = blockSize;
+		s.stream = stream;
+		s.start = acquireEvent();
+		cudaEventRecord(s.start, stream);
+		m_pending.push_back(s);
+	}
+
+	void onComplete()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		if (m_pending.empty() || m_pending.back().stop != NULL)
+		{
+			return;
+		}
+
+		Sample& s = m_pending.back();
+		s.stop = acquireEvent();
+		cudaEventRecord(s.stop, s.stream);
+	}
+
+	/**
+	 * @brief Close the module scope: wait for the recorded events and
+	 * fold the samples into the per-kernel table and the module's
+	 * counters. Runs once per module execution, so the synchronization
+	 * only costs while instrumentation is on.
+	 */
+	void endModule()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		ModuleCounters counters;
+		for (size_t i = 0; i < m_pending.size(); i++)
+		{
+			Sample& s = m_pending[i];
+			if (s.stop == NULL)
+			{
+				releaseEvent(s.start);
+				continue;
+			}
+
+			cudaEventSynchronize(s.stop);
+
+			float ms = 0.0f;
+			cudaEventElapsedTime(&ms, s.start, s.stop);
+
+			float occ = occupancyFor(s.kernel, s.blockSize);
+
+			counters.launches++;
+			counters.kernelMs += ms;
+			counters.occupancy += occ;
+
+			KernelRecord& rec = m_kernels[s.name];
+			rec.launches++;
+			rec.totalMs += ms;
+			rec.occupancy = occ;
+
+			releaseEvent(s.start);
+			releaseEvent(s.stop);
+		}
+		m_pending.clear();
+
+		if (counters.launches > 0)
+		{
+			counters.occupancy /= counters.launches;
+		}
+
+		if (!m_currentModule.empty())
+		{
+			m_modules[m_currentModule] = counters;
+		}
+		m_currentModule.clear();
+	}
+
+	/**
+	 * @brief Counters of the module's most recent execution.
+	 */
+	bool queryModule(const std::string& name, ModuleCounters& out)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		auto it = m_modules.find(name);
+		if (it == m_modules.end())
+		{
+			return false;
+		}
+
+		out = it->second;
+		return true;
+	}
+
+	/**
+	 * @brief One line per kernel: launch count, summed milliseconds and
+	 * occupancy at the used block size, sorted by name.
+	 */
+	std::string report()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		std::stringstream ss;
+		ss << "Kernel statistics (launches | total ms | occupancy)" << std::endl;
+		for (auto it = m_kernels.begin(); it != m_kernels.end(); ++it)
+		{
+			ss << it->first << ": " << it->second.launches
+				<< " | " << it->second.totalMs
+				<< " | " << it->second.occupancy << std::endl;
+		}
+		return ss.str();
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_kernels.clear();
+		m_modules.clear();
+	}
+
+private:
+	KernelStats() {};
+
+	struct Sample
+	{
+		const void* kernel = NULL;
+		const char* name = NULL;
+		cuint blockSize = BLOCK_SIZE;
+		cudaStream_t stream = 0;
+		cudaEvent_t start = NULL;
+		cudaEvent_t stop = NULL;
+	};
+
+	struct KernelRecord
+	{
+		unsigned int launches = 0;
+		float totalMs = 0.0f;
+		float occupancy = 0.0f;
+	};
+
+	cudaEvent_t acquireEvent()
+	{
+		if (!m_eventPool.empty())
+		{
+			cudaEvent_t ev = m_eventPool.back();
+			m_eventPool.pop_back();
+			return ev;
+		}
+
+		cudaEvent_t ev = NULL;
+		cudaEventCreate(&ev);
+		return ev;
+	}
+
+	void releaseEvent(cudaEvent_t ev)
+	{
+		if (ev != NULL)
+		{
+			m_eventPool.push_back(ev);
+		}
+	}
+
+	float occupancyFor(const void* kernel, cuint blockSize)
+	{
+		auto it = m_occupancy.find(kernel);
+		if (it != m_occupancy.end() && it->second.blockSize == blockSize)
+		{
+			return it->second.occupancy;
+		}
+
+		float occupancy = 0.0f;
+		int blocksPerSM = 0;
+		if (cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blocksPerSM, kernel, blockSize, 0) == cudaSuccess)
+		{
+			int device = 0;
+			cudaDeviceProp prop;
+			cudaGetDevice(&device);
+			if (cudaGetDeviceProperties(&prop, device) == cudaSuccess && prop.maxThreadsPerMultiProcessor > 0)
+			{
+				occupancy = (float)(blocksPerSM * (int)blockSize) / (float)prop.maxThreadsPerMultiProcessor;
+			}
+		}
+
+		OccupancyEntry entry;
+		entry.blockSize = blockSize;
+		entry.occupancy = occupancy;
+		m_occupancy[kernel] = entry;
+
+		return occupancy;
+	}
+
+	struct OccupancyEntry
+	{
+		cuint blockSize = BLOCK_SIZE;
+		float occupancy = 0.0f;
+	};
+
+	bool m_enabled = false;
+
+	std::string m_currentModule;
+	std::vector<Sample> m_pending;
+	std::vector<cudaEvent_t> m_eventPool;
+
+	std::unordered_map<const void*, OccupancyEntry> m_occupancy;
+	std::unordered_map<std::string, KernelRecord> m_kernels;
+	std::unordered_map<std::string, ModuleCounters> m_modules;
+	std::mutex m_mutex;
+};
+
 /**
  * @brief Macro definition for execuation of cuda kernels, note that at lease one block will be executed.
  * 
@@ -106,11 +577,40 @@ namespace PhysIKA{
  */
 #define cuExecute(size, Func, ...){						\
 		uint pDims = cudaGridSize(size, BLOCK_SIZE);	\
+		if (PhysIKA::KernelStats::getInstance().isEnabled())										\
+			PhysIKA::KernelStats::getInstance().onLaunch((const void*)&Func, #Func, pDims, BLOCK_SIZE);	\
 		Func << <pDims, BLOCK_SIZE >> > (				\
 		__VA_ARGS__);									\
+		if (PhysIKA::KernelStats::getInstance().isEnabled())										\
+			PhysIKA::KernelStats::getInstance().onComplete();										\
 		cuSynchronize();								\
 	}
 
+/**
+ * @brief Launch Func with its occupancy-derived block size, queried once per
+ * kernel through LaunchConfigCache. For sizes below one tuned block the block
+ * shrinks to the next warp multiple so tiny launches do not park idle warps.
+ * Kernels guard with an absolute-index check, so the thread mapping is the
+ * same as cuExecute.
+ */
+#define cuExecuteTuned(size, Func, ...){											\
+		cuint bDim = PhysIKA::LaunchConfigCache::getInstance().blockSizeFor(		\
+			(const void*)&Func, #Func);												\
+		if ((cuint)(size) < bDim)													\
+		{																			\
+			bDim = (((cuint)(size) + 31) / 32) * 32;								\
+			bDim = bDim == 0 ? 32 : bDim;											\
+		}																			\
+		uint pDims = cudaGridSize(size, bDim);										\
+		if (PhysIKA::KernelStats::getInstance().isEnabled())						\
+			PhysIKA::KernelStats::getInstance().onLaunch((const void*)&Func, #Func, pDims, bDim);	\
+		Func << <pDims, bDim >> > (													\
+		__VA_ARGS__);																\
+		if (PhysIKA::KernelStats::getInstance().isEnabled())						\
+			PhysIKA::KernelStats::getInstance().onComplete();						\
+		cuSynchronize();															\
+	}
+
 #define cuExecute3D(size, Func, ...){						\
 		uint3 pDims = cudaGridSize(size, BLOCK_SIZE);	\
 		Func << <pDims, BLOCK_SIZE >> > (				\
@@ -118,6 +618,23 @@ namespace PhysIKA{
 		cuSynchronize();								\
 	}
 
+/**
+ * @brief Asynchronous variant of cuExecute: launch Func on the given stream
+ * without synchronizing the host. Only the launch itself is checked; ordering
+ * against other streams must be established with events (see DeviceContext)
+ * and results must be waited on before they are read back.
+ */
+#define cuExecuteAsync(stream, size, Func, ...){		\
+		uint pDims = cudaGridSize(size, BLOCK_SIZE);	\
+		if (PhysIKA::KernelStats::getInstance().isEnabled())										\
+			PhysIKA::KernelStats::getInstance().onLaunch((const void*)&Func, #Func, pDims, BLOCK_SIZE, stream);	\
+		Func << <pDims, BLOCK_SIZE, 0, stream >> > (	\
+		__VA_ARGS__);									\
+		if (PhysIKA::KernelStats::getInstance().isEnabled())										\
+			PhysIKA::KernelStats::getInstance().onComplete();										\
+		cuSafeCall(cudaGetLastError());					\
+	}
+
 }// end of namespace PhysIKA
 
 #endif //PHYSIKA_CORE_UTILITIES_CUDA_UTILITIES_H_
\ No newline at end of file
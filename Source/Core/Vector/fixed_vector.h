@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Core/Platform.h"
+
+namespace PhysIKA
+{
+	/**
+	 * @brief Stack-allocated vector with a compile-time size and the element
+	 * access interface of Vectornd.
+	 *
+	 * Vectornd allocates its storage through a MemoryManager on every
+	 * construction, which turns the small fixed-size temporaries built inside
+	 * the articulated-body solver loops into heap traffic. When the dimension
+	 * is known at compile time, FixedVector is a drop-in replacement without
+	 * any allocation.
+	 */
+	template<typename T, unsigned int N>
+	class FixedVector
+	{
+	public:
+		COMM_FUNC FixedVector() { setZeros(); }
+
+		COMM_FUNC inline unsigned int size() const { return N; }
+
+		COMM_FUNC void setZeros()
+		{
+			for (unsigned int i = 0; i < N; ++i)
+			{
+				m_data[i] = T(0);
+			}
+		}
+
+		COMM_FUNC inline T& operator()(unsigned int i) { return m_data[i]; }
+		COMM_FUNC inline const T& operator()(unsigned int i) const { return m_data[i]; }
+		COMM_FUNC inline T& operator[](unsigned int i) { return m_data[i]; }
+		COMM_FUNC inline const T& operator[](unsigned int i) const { return m_data[i]; }
+
+		COMM_FUNC const FixedVector<T, N> operator+ (const FixedVector<T, N>& v) const
+		{
+			FixedVector<T, N> res;
+			for (unsigned int i = 0; i < N; ++i)
+			{
+				res.m_data[i] = m_data[i] + v.m_data[i];
+			}
+			return res;
+		}
+
+		COMM_FUNC const FixedVector<T, N> operator- (const FixedVector<T, N>& v) const
+		{
+			FixedVector<T, N> res;
+			for (unsigned int i = 0; i < N; ++i)
+			{
+				res.m_data[i] = m_data[i] - v.m_data[i];
+			}
+			return res;
+		}
+
+		COMM_FUNC const FixedVector<T, N> operator* (T s) const
+		{
+			FixedVector<T, N> res;
+			for (unsigned int i = 0; i < N; ++i)
+			{
+				res.m_data[i] = m_data[i] * s;
+			}
+			return res;
+		}
+
+		COMM_FUNC T dot(const FixedVector<T, N>& v) const
+		{
+			T res = T(0);
+			for (unsigned int i = 0; i < N; ++i)
+			{
+				res += m_data[i] * v.m_data[i];
+			}
+			return res;
+		}
+
+	private:
+		T m_data[N];
+	};
+}
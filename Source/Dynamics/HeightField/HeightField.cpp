@@ -1,28 +0,0 @@
-#include "HeightField.h"
-#include "Framework/Topology/Frame.h"
-#include "Framework/Topology/PointSet.h"
-#include "Framework/Topology/TriangleSet.h"
-#include "Framework/Mapping/FrameToPointSet.h"
-
-namespace PhysIKA
-{
-	IMPLEMENT_CLASS_1(HeightField, TDataType)
-
-	template<typename TDataType>
-	HeightField<TDataType>::HeightField()
-		: Node()
-	{
-	}
-
-	template<typename TDataType>
-	HeightField<TDataType>::~HeightField()
-	{
-		
-	}
-
-	template<typename TDataType>
-	bool HeightField<TDataType>::initialize()
-	{
-		return true;
-	}
-}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <cuda_runtime.h>
+#include "HeightField.h"
+#include "Core/Utility.h"
+#include "Framework/Framework/Log.h"
+#include "Framework/Topology/Frame.h"
+#include "Framework/Topology/PointSet.h"
+#include "Framework/Topology/TriangleSet.h"
+#include "Framework/Mapping/FrameToPointSet.h"
+#include "IO/Image_IO/image.h"
+#include "IO/Image_IO/image_io.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(HeightField, TDataType)
+
+	template<typename Real>
+	__global__ void HF_HeightFromPixels(
+		DeviceArray2D<Real> height,
+		DeviceArray<unsigned char> pixels,
+		int pixelSize,
+		Real minHeight,
+		Real maxHeight)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		int nx = height.Nx();
+		int nz = height.Ny();
+		if (tId >= nx * nz) return;
+
+		int i = tId % nx;
+		int j = tId / nx;
+
+		//average the color channels; the alpha channel, if any, is ignored
+		int base = tId * pixelSize;
+		Real lum = (Real(pixels[base]) + Real(pixels[base + 1]) + Real(pixels[base + 2])) / Real(3 * 255);
+
+		height(i, j) = minHeight + lum * (maxHeight - minHeight);
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void HF_ComputeGradient(
+		DeviceArray2D<Coord> gradient,
+		DeviceArray2D<Real> height,
+		Real spacing)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		int nx = height.Nx();
+		int nz = height.Ny();
+		if (tId >= nx * nz) return;
+
+		int i = tId % nx;
+		int j = tId / nx;
+
+		//central differences, one-sided at the borders
+		int i0 = i > 0 ? i - 1 : i;
+		int i1 = i < nx - 1 ? i + 1 : i;
+		int j0 = j > 0 ? j - 1 : j;
+		int j1 = j < nz - 1 ? j + 1 : j;
+
+		Coord g;
+		g[0] = (height(i1, j) - height(i0, j)) / ((i1 - i0) * spacing);
+		g[1] = (height(i, j1) - height(i, j0)) / ((j1 - j0) * spacing);
+		gradient(i, j) = g;
+	}
+
+	template<typename Real>
+	__global__ void HF_Downsample(
+		DeviceArray2D<Real> coarse,
+		DeviceArray2D<Real> fine)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		int nx = coarse.Nx();
+		int nz = coarse.Ny();
+		if (tId >= nx * nz) return;
+
+		int i = tId % nx;
+		int j = tId / nx;
+
+		//2x2 box filter, clamped at odd-sized borders
+		int i0 = 2 * i;
+		int j0 = 2 * j;
+		int i1 = min(i0 + 1, fine.Nx() - 1);
+		int j1 = min(j0 + 1, fine.Ny() - 1);
+
+		coarse(i, j) = Real(0.25) * (fine(i0, j0) + fine(i1, j0) + fine(i0, j1) + fine(i1, j1));
+	}
+
+	template<typename TDataType>
+	HeightField<TDataType>::HeightField()
+		: Node()
+		, m_spacing(Real(0.005))
+		, m_origin(Coord(0))
+	{
+	}
+
+	template<typename TDataType>
+	HeightField<TDataType>::~HeightField()
+	{
+		m_height.Release();
+		m_gradient.Release();
+		for (size_t i = 0; i < m_mips.size(); i++)
+		{
+			m_mips[i].Release();
+		}
+	}
+
+	template<typename TDataType>
+	void HeightField<TDataType>::setExtents(int nx, int nz)
+	{
+		m_height.Resize(nx, nz);
+		m_height.Reset();
+	}
+
+	template<typename TDataType>
+	bool HeightField<TDataType>::loadImage(std::string filename, Real minHeight, Real maxHeight)
+	{
+		Image image;
+		if (!ImageIO::load(filename, &image))
+		{
+			Log::sendMessage(Log::Error, std::string("Failed to load ") + filename);
+			return false;
+		}
+
+		int nx = image.width();
+		int nz = image.height();
+		setExtents(nx, nz);
+
+		//one bulk upload of the raw pixels; everything else happens on the device
+		DeviceArray<unsigned char> pixels;
+		pixels.resize(nx * nz * image.pixelSize());
+		cuSafeCall(cudaMemcpy(pixels.getDataPtr(), image.rawData(), pixels.size() * sizeof(unsigned char), cudaMemcpyHostToDevice));
+
+		cuExecute(nx * nz, HF_HeightFromPixels,
+			m_height,
+			pixels,
+			(int)image.pixelSize(),
+			minHeight,
+			maxHeight);
+
+		pixels.release();
+
+		updateDerivedData();
+
+		return true;
+	}
+
+	template<typename TDataType>
+	void HeightField<TDataType>::updateDerivedData()
+	{
+		int nx = m_height.Nx();
+		int nz = m_height.Ny();
+		if (nx == 0 || nz == 0) return;
+
+		if (m_gradient.Nx() != nx || m_gradient.Ny() != nz)
+		{
+			m_gradient.Resize(nx, nz);
+		}
+
+		cuExecute(nx * nz, HF_ComputeGradient,
+			m_gradient,
+			m_height,
+			m_spacing);
+
+		for (size_t i = 0; i < m_mips.size(); i++)
+		{
+			m_mips[i].Release();
+		}
+		m_mips.clear();
+
+		//halve until a single sample remains in both directions
+		int cx = nx;
+		int cz = nz;
+		while (cx > 1 || cz > 1)
+		{
+			cx = (cx + 1) / 2;
+			cz = (cz + 1) / 2;
+
+			m_mips.push_back(DeviceArray2D<Real>());
+			m_mips.back().Resize(cx, cz);
+
+			DeviceArray2D<Real>& fine = m_mips.size() == 1 ? m_height : m_mips[m_mips.size() - 2];
+
+			cuExecute(cx * cz, HF_Downsample,
+				m_mips.back(),
+				fine);
+		}
+	}
+
+	template<typename TDataType>
+	DeviceArray2D<typename TDataType::Real>& HeightField<TDataType>::getMipLevel(int level)
+	{
+		if (level <= 0 || m_mips.empty())
+		{
+			return m_height;
+		}
+
+		int idx = level - 1;
+		int last = (int)m_mips.size() - 1;
+		return m_mips[idx < last ? idx : last];
+	}
+
+	template<typename TDataType>
+	bool HeightField<TDataType>::initialize()
+	{
+		return true;
+	}
+}
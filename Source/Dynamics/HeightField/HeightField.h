@@ -1,11 +1,19 @@
 #pragma once
+#include <vector>
 #include "Framework/Framework/Node.h"
+#include "Core/Array/Array.h"
+#include "Core/Array/Array2D.h"
 
 namespace PhysIKA
 {
 	/*!
 	*	\class	HeightField
 	*	\brief	A height field node
+	*
+	*	Heights are stored as a regular nx x nz grid of samples on the
+	*	device; sample (i, k) sits at origin + (i, k) * spacing in the
+	*	xz plane. Renderers and solvers share this one array, nothing is
+	*	ever mirrored to the host.
 	*/
 	template<typename TDataType>
 	class HeightField : public Node
@@ -18,10 +26,61 @@ namespace PhysIKA
 		HeightField();
 		virtual ~HeightField();
 
+		//! allocate an nx x nz grid of height samples on the device
+		void setExtents(int nx, int nz);
+
+		/*!
+		*	\brief	Build the height samples from a gray-scale or color
+		*	image, one sample per pixel.
+		*
+		*	The raw pixels cross to the device in a single upload; the
+		*	luminance-to-height conversion, the surface gradient and the
+		*	whole mip pyramid are then built by kernels, so an 8k terrain
+		*	source never runs through a host-side per-pixel loop. Pixel
+		*	luminance 0 maps to minHeight, 255 to maxHeight.
+		*/
+		bool loadImage(std::string filename, Real minHeight, Real maxHeight);
+
+		/*!
+		*	\brief	Rebuild the gradient and the mip pyramid from the
+		*	current heights; called by loadImage and after external edits.
+		*/
+		void updateDerivedData();
+
+		//! number of mip levels, counting the full-resolution array as level 0
+		int getMipLevelCount() { return (int)m_mips.size() + 1; }
+
+		/*!
+		*	\brief	Level 0 is the full-resolution array; every further
+		*	level halves the resolution by 2x2 averaging. Coarse collision
+		*	or rendering queries pick a level matching their footprint
+		*	instead of thrashing the full-resolution samples.
+		*/
+		DeviceArray2D<Real>& getMipLevel(int level);
+
+		//! central-difference surface gradient at full resolution
+		DeviceArray2D<Coord>& getGradient() { return m_gradient; }
+
+		void setGridSpacing(Real spacing) { m_spacing = spacing; }
+		void setOrigin(Coord origin) { m_origin = origin; }
+
+		int getNx() { return m_height.Nx(); }
+		int getNz() { return m_height.Ny(); }
+		Real getGridSpacing() { return m_spacing; }
+		Coord getOrigin() { return m_origin; }
+
+		DeviceArray2D<Real>& getHeights() { return m_height; }
+
 	public:
 		bool initialize() override;
 
 	private:
+		Real m_spacing;
+		Coord m_origin;
+		DeviceArray2D<Real> m_height;
+
+		DeviceArray2D<Coord> m_gradient;
+		std::vector<DeviceArray2D<Real>> m_mips;
 	};
 
 
@@ -30,4 +89,4 @@ namespace PhysIKA
 #else
 	template class HeightField<DataType2d>;
 #endif
-}
\ No newline at end of file
+}
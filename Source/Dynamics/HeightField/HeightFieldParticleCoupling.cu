@@ -0,0 +1,319 @@
+#include <cuda_runtime.h>
+#include "HeightFieldParticleCoupling.h"
+#include "Core/Utility.h"
+#include "Core/Utility/CudaRand.h"
+
+namespace PhysIKA
+{
+	template<typename Real>
+	__global__ void HFC_TagBreaking(
+		DeviceArray<int> flags,
+		DeviceArray2D<Real> height,
+		Real spacing,
+		Real slopeThreshold,
+		Real minDepth,
+		Real dh)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		int nx = height.Nx();
+		int nz = height.Ny();
+		if (tId >= nx * nz) return;
+
+		int i = tId % nx;
+		int j = tId / nx;
+
+		flags[tId] = 0;
+
+		Real h = height(i, j);
+		if (h < minDepth || h < dh) return;
+
+		//steepness against the four neighbors; the debit pass runs
+		//separately so every cell decides on the undisturbed surface
+		Real slope = Real(0);
+		if (i > 0)      slope = max(slope, abs(h - height(i - 1, j)));
+		if (i < nx - 1) slope = max(slope, abs(h - height(i + 1, j)));
+		if (j > 0)      slope = max(slope, abs(h - height(i, j - 1)));
+		if (j < nz - 1) slope = max(slope, abs(h - height(i, j + 1)));
+		slope /= spacing;
+
+		if (slope > slopeThreshold)
+		{
+			flags[tId] = 1;
+		}
+	}
+
+	template<typename Real, typename Coord, typename Coord2D>
+	__global__ void HFC_Spawn(
+		DeviceArray<Coord> spawnPos,
+		DeviceArray<Coord> spawnVel,
+		int* cursor,
+		DeviceArray<int> flags,
+		DeviceArray2D<Real> height,
+		DeviceArray2D<Coord2D> velocity,
+		Coord origin,
+		Real spacing,
+		Real dh,
+		int seed)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		int nx = height.Nx();
+		int nz = height.Ny();
+		if (tId >= nx * nz) return;
+
+		if (flags[tId] == 0) return;
+
+		int i = tId % nx;
+		int j = tId / nx;
+
+		Real h = height(i, j);
+		height(i, j) = h - dh;
+
+		int slot = atomicAdd(cursor, 1);
+
+		RandNumber gen(seed + tId);
+		Real jx = (gen.Generate() - Real(0.5)) * spacing;
+		Real jz = (gen.Generate() - Real(0.5)) * spacing;
+
+		Coord p;
+		p[0] = origin[0] + i * spacing + jx;
+		p[1] = origin[1] + h;
+		p[2] = origin[2] + j * spacing + jz;
+		spawnPos[slot] = p;
+
+		//the parcel leaves with the local depth-averaged velocity, so its
+		//momentum travels with it
+		Coord2D v2 = velocity(i, j);
+		Coord v;
+		v[0] = v2[0];
+		v[1] = Real(0);
+		v[2] = v2[1];
+		spawnVel[slot] = v;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void HFC_AbsorbCount(
+		DeviceArray<int> counts,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray2D<Real> height,
+		DeviceArray2D<Real> fluxL,
+		DeviceArray2D<Real> fluxR,
+		DeviceArray2D<Real> fluxB,
+		DeviceArray2D<Real> fluxT,
+		Coord origin,
+		Real spacing,
+		Real dh,
+		Real particleVolume,
+		Real maxVelocity,
+		Real band)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		counts[pId] = 1;
+
+		Coord v = velArr[pId];
+		if (v.norm() > maxVelocity) return;
+
+		Coord p = posArr[pId];
+		int i = (int)floor((p[0] - origin[0]) / spacing + Real(0.5));
+		int j = (int)floor((p[2] - origin[2]) / spacing + Real(0.5));
+
+		int nx = height.Nx();
+		int nz = height.Ny();
+		if (i < 0 || i >= nx || j < 0 || j >= nz) return;
+
+		Real surface = origin[1] + height(i, j);
+		if (abs(p[1] - surface) > band) return;
+
+		//credit the parcel back: its volume raises the column, its
+		//horizontal momentum enters the pipes as directional outflow
+		atomicAdd(&height(i, j), dh);
+
+		Real fx = particleVolume * abs(v[0]) / spacing;
+		Real fz = particleVolume * abs(v[2]) / spacing;
+		if (v[0] > Real(0)) atomicAdd(&fluxR(i, j), fx);
+		else                atomicAdd(&fluxL(i, j), fx);
+		if (v[2] > Real(0)) atomicAdd(&fluxT(i, j), fz);
+		else                atomicAdd(&fluxB(i, j), fz);
+
+		counts[pId] = 0;
+	}
+
+	template<typename Coord>
+	__global__ void HFC_Scatter(
+		DeviceArray<Coord> outPos,
+		DeviceArray<Coord> outVel,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<int> counts,
+		DeviceArray<int> offsets)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		if (counts[pId] == 0) return;
+
+		int slot = offsets[pId];
+		outPos[slot] = posArr[pId];
+		outVel[slot] = velArr[pId];
+	}
+
+	template<typename TDataType>
+	HeightFieldParticleCoupling<TDataType>::HeightFieldParticleCoupling()
+		: m_origin(Coord(0))
+		, m_spacing(Real(0.005))
+		, m_samplingDistance(Real(0.005))
+		, m_spawnSlope(Real(0.5))
+		, m_spawnMinDepth(Real(0.01))
+		, m_absorbVelocity(Real(0.1))
+		, m_absorbBand(Real(0.01))
+	{
+	}
+
+	template<typename TDataType>
+	HeightFieldParticleCoupling<TDataType>::~HeightFieldParticleCoupling()
+	{
+		m_spawnCursor.release();
+		m_spawnPos.release();
+		m_spawnVel.release();
+		m_counts.release();
+		m_offsets.release();
+		m_bufPos.release();
+		m_bufVel.release();
+	}
+
+	template<typename TDataType>
+	int HeightFieldParticleCoupling<TDataType>::spawn(DeviceArray2D<Real>& height, DeviceArray2D<Coord2D>& velocity)
+	{
+		int nx = height.Nx();
+		int nz = height.Ny();
+		int candidates = nx * nz;
+		if (candidates == 0) return 0;
+
+		//one particle stands for a cube of sampling-distance edge length
+		Real volume = m_samplingDistance * m_samplingDistance * m_samplingDistance;
+		Real dh = volume / (m_spacing * m_spacing);
+
+		if (m_counts.size() < candidates)
+		{
+			m_counts.resize(candidates);
+		}
+		if (m_spawnPos.size() < candidates)
+		{
+			m_spawnPos.resize(candidates);
+			m_spawnVel.resize(candidates);
+		}
+		if (m_spawnCursor.size() != 1)
+		{
+			m_spawnCursor.resize(1);
+		}
+		cuSafeCall(cudaMemset(m_spawnCursor.getDataPtr(), 0, sizeof(int)));
+
+		cuExecute(candidates, HFC_TagBreaking,
+			m_counts,
+			height,
+			m_spacing,
+			m_spawnSlope,
+			m_spawnMinDepth,
+			dh);
+
+		cuExecute(candidates, HFC_Spawn,
+			m_spawnPos,
+			m_spawnVel,
+			m_spawnCursor.getDataPtr(),
+			m_counts,
+			height,
+			velocity,
+			m_origin,
+			m_spacing,
+			dh,
+			m_spawnSeed);
+
+		int spawned = 0;
+		cuSafeCall(cudaMemcpy(&spawned, m_spawnCursor.getDataPtr(), sizeof(int), cudaMemcpyDeviceToHost));
+
+		m_spawnSeed += candidates;
+
+		return spawned;
+	}
+
+	template<typename TDataType>
+	int HeightFieldParticleCoupling<TDataType>::absorb(
+		DeviceArray<Coord>& position,
+		DeviceArray<Coord>& velocity,
+		DeviceArray2D<Real>& height,
+		DeviceArray2D<Real>& fluxL,
+		DeviceArray2D<Real>& fluxR,
+		DeviceArray2D<Real>& fluxB,
+		DeviceArray2D<Real>& fluxT)
+	{
+		int num = position.size();
+		if (num == 0) return 0;
+
+		Real volume = m_samplingDistance * m_samplingDistance * m_samplingDistance;
+		Real dh = volume / (m_spacing * m_spacing);
+
+		if (m_counts.size() < num)
+		{
+			m_counts.resize(num);
+			m_offsets.resize(num);
+		}
+		else if (m_offsets.size() < num)
+		{
+			m_offsets.resize(num);
+		}
+
+		cuExecute(num, HFC_AbsorbCount,
+			m_counts,
+			position,
+			velocity,
+			height,
+			fluxL,
+			fluxR,
+			fluxB,
+			fluxT,
+			m_origin,
+			m_spacing,
+			dh,
+			volume,
+			m_absorbVelocity,
+			m_absorbBand);
+
+		m_scan.exclusive(m_offsets.getDataPtr(), m_counts.getDataPtr(), num);
+
+		int lastOffset = 0;
+		int lastCount = 0;
+		cuSafeCall(cudaMemcpy(&lastOffset, m_offsets.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastCount, m_counts.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+
+		int newNum = lastOffset + lastCount;
+
+		if (m_bufPos.size() < newNum)
+		{
+			m_bufPos.resize(newNum);
+			m_bufVel.resize(newNum);
+		}
+
+		if (newNum > 0)
+		{
+			cuExecute(num, HFC_Scatter,
+				m_bufPos,
+				m_bufVel,
+				position,
+				velocity,
+				m_counts,
+				m_offsets);
+		}
+
+		return newNum;
+	}
+
+#ifdef PRECISION_FLOAT
+	template class HeightFieldParticleCoupling<DataType3f>;
+#else
+	template class HeightFieldParticleCoupling<DataType3d>;
+#endif
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Core/Array/Array2D.h"
+#include "Core/Utility/Scan.h"
+#include "Core/Vector.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	HeightFieldParticleCoupling
+	*	\brief	Two-way transfer between a shallow-water height field and a
+	*	particle fluid.
+	*
+	*	The hybrid puts particles only where the action is: spawn() turns
+	*	steep, breaking cells into particles seeded at the surface with the
+	*	local depth-averaged velocity, debiting exactly one particle volume
+	*	of depth per spawned particle; absorb() removes settled particles
+	*	near the surface, crediting their volume back to the cell and
+	*	depositing their horizontal momentum into the pipe fluxes. Both
+	*	transfers conserve mass exactly - a water parcel leaves with its own
+	*	momentum and returns it on absorption.
+	*
+	*	Spawning follows the emitter idiom (an atomic cursor into
+	*	preallocated pools, see ParticleEmitter); absorption follows the
+	*	compaction idiom (count, Scan, scatter). The template parameter is
+	*	the 3D particle data type; the height-field side is addressed with
+	*	2D vectors of the same precision.
+	*/
+	template<typename TDataType>
+	class HeightFieldParticleCoupling
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef Vector<Real, 2> Coord2D;
+
+		HeightFieldParticleCoupling();
+		~HeightFieldParticleCoupling();
+
+		/*!
+		*	\brief	Placement of the height field in the particle world:
+		*	sample (i, k) sits at origin + (i, 0, k) * spacing and heights
+		*	are measured upward from origin along y.
+		*/
+		void setSpace(Coord origin, Real spacing)
+		{
+			m_origin = origin;
+			m_spacing = spacing;
+		}
+
+		/*!
+		*	\brief	Sampling distance of the particle fluid; one particle
+		*	stands for a cube of this edge length worth of water.
+		*/
+		void setSamplingDistance(Real d) { m_samplingDistance = d; }
+
+		/*!
+		*	\brief	Cells steeper than slope (surface difference over
+		*	spacing) holding at least minDepth of water spawn particles.
+		*/
+		void setSpawnThresholds(Real slope, Real minDepth)
+		{
+			m_spawnSlope = slope;
+			m_spawnMinDepth = minDepth;
+		}
+
+		/*!
+		*	\brief	Particles slower than maxVelocity within band of the
+		*	local surface are absorbed back into the height field.
+		*/
+		void setAbsorbThresholds(Real maxVelocity, Real band)
+		{
+			m_absorbVelocity = maxVelocity;
+			m_absorbBand = band;
+		}
+
+		/*!
+		*	\brief	Turn breaking cells into particles; at most one per cell
+		*	and call. The accepted samples are available in
+		*	getSpawnPosition() / getSpawnVelocity() for the caller to append
+		*	to the particle state, the spawned depth is already debited.
+		*
+		*	\return	the number of spawned particles.
+		*/
+		int spawn(DeviceArray2D<Real>& height, DeviceArray2D<Coord2D>& velocity);
+
+		/*!
+		*	\brief	Absorb settled near-surface particles. Their volume is
+		*	credited to the height field and their horizontal momentum
+		*	deposited into the pipe fluxes (see ShallowWaterModel::getFluxL
+		*	and friends). The surviving particles are compacted into
+		*	outPosition() / outVelocity(), following the ParticleMergeSplit
+		*	contract: the caller resizes its fields to the returned count
+		*	and copies the buffers back.
+		*
+		*	\return	the number of particles kept.
+		*/
+		int absorb(
+			DeviceArray<Coord>& position,
+			DeviceArray<Coord>& velocity,
+			DeviceArray2D<Real>& height,
+			DeviceArray2D<Real>& fluxL,
+			DeviceArray2D<Real>& fluxR,
+			DeviceArray2D<Real>& fluxB,
+			DeviceArray2D<Real>& fluxT);
+
+		DeviceArray<Coord>& getSpawnPosition() { return m_spawnPos; }
+		DeviceArray<Coord>& getSpawnVelocity() { return m_spawnVel; }
+
+		DeviceArray<Coord>& outPosition() { return m_bufPos; }
+		DeviceArray<Coord>& outVelocity() { return m_bufVel; }
+
+	private:
+		Coord m_origin;
+		Real m_spacing;
+		Real m_samplingDistance;
+
+		Real m_spawnSlope;
+		Real m_spawnMinDepth;
+		Real m_absorbVelocity;
+		Real m_absorbBand;
+
+		int m_spawnSeed = 0;
+
+		DeviceArray<int> m_spawnCursor;
+		DeviceArray<Coord> m_spawnPos;
+		DeviceArray<Coord> m_spawnVel;
+
+		DeviceArray<int> m_counts;
+		DeviceArray<int> m_offsets;
+		DeviceArray<Coord> m_bufPos;
+		DeviceArray<Coord> m_bufVel;
+		Scan m_scan;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class HeightFieldParticleCoupling<DataType3f>;
+#else
+	template class HeightFieldParticleCoupling<DataType3d>;
+#endif
+}
@@ -0,0 +1,32 @@
+#include "ShallowWaterFluid.h"
+#include "ShallowWaterModel.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(ShallowWaterFluid, TDataType)
+
+	template<typename TDataType>
+	ShallowWaterFluid<TDataType>::ShallowWaterFluid()
+		: HeightField<TDataType>()
+	{
+		m_swe = this->template setNumericalModel<ShallowWaterModel<TDataType>>("shallow_water");
+		this->setNumericalModel(m_swe);
+
+		//the array addresses are stable, only their contents grow later
+		m_swe->setHeights(&this->getHeights());
+		m_swe->setTerrain(&m_terrain);
+	}
+
+	template<typename TDataType>
+	ShallowWaterFluid<TDataType>::~ShallowWaterFluid()
+	{
+		m_terrain.Release();
+	}
+
+	template<typename TDataType>
+	void ShallowWaterFluid<TDataType>::advance(Real dt)
+	{
+		m_swe->setGridSpacing(this->getGridSpacing());
+		m_swe->step(dt);
+	}
+}
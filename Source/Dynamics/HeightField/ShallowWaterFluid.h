@@ -0,0 +1,47 @@
+#pragma once
+#include "HeightField.h"
+
+namespace PhysIKA
+{
+	template<typename TDataType> class ShallowWaterModel;
+
+	/*!
+	*	\class	ShallowWaterFluid
+	*	\brief	A height-field water body driven by the shallow-water solver.
+	*
+	*	The counterpart of ParticleFluid for large calm water bodies: the
+	*	node owns the depth samples through HeightField and steps a
+	*	ShallowWaterModel over them every frame. Call setExtents and fill
+	*	the heights with the initial water depth; for a sloped bed resize
+	*	getTerrain() to the same extents and fill it with the bed elevation.
+	*/
+	template<typename TDataType>
+	class ShallowWaterFluid : public HeightField<TDataType>
+	{
+		DECLARE_CLASS_1(ShallowWaterFluid, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		ShallowWaterFluid();
+		virtual ~ShallowWaterFluid();
+
+		void advance(Real dt) override;
+
+		//! Bed elevation per cell; empty means a flat bed at zero.
+		DeviceArray2D<Real>& getTerrain() { return m_terrain; }
+
+		std::shared_ptr<ShallowWaterModel<TDataType>> getShallowWaterModel() { return m_swe; }
+
+	private:
+		DeviceArray2D<Real> m_terrain;
+
+		std::shared_ptr<ShallowWaterModel<TDataType>> m_swe;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class ShallowWaterFluid<DataType2f>;
+#else
+	template class ShallowWaterFluid<DataType2d>;
+#endif
+}
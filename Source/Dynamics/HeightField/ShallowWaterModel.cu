@@ -0,0 +1,208 @@
+#include <cuda_runtime.h>
+#include "ShallowWaterModel.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(ShallowWaterModel, TDataType)
+
+	template<typename Real>
+	GPU_FUNC Real SWM_Surface(
+		DeviceArray2D<Real>& height,
+		DeviceArray2D<Real>& terrain,
+		bool hasTerrain,
+		int i,
+		int j)
+	{
+		Real eta = height(i, j);
+		if (hasTerrain)
+		{
+			eta += terrain(i, j);
+		}
+		return eta;
+	}
+
+	template<typename Real>
+	__global__ void SWM_UpdateFlux(
+		DeviceArray2D<Real> fluxL,
+		DeviceArray2D<Real> fluxR,
+		DeviceArray2D<Real> fluxB,
+		DeviceArray2D<Real> fluxT,
+		DeviceArray2D<Real> height,
+		DeviceArray2D<Real> terrain,
+		bool hasTerrain,
+		Real gravity,
+		Real spacing,
+		Real damping,
+		Real dt)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		int nx = height.Nx();
+		int nz = height.Ny();
+		if (tId >= nx * nz) return;
+
+		int i = tId % nx;
+		int j = tId / nx;
+
+		Real eta = SWM_Surface(height, terrain, hasTerrain, i, j);
+
+		//the pipe cross section and length both equal the grid spacing, so
+		//the acceleration term reduces to g * dh * spacing
+		Real a = dt * gravity * spacing;
+
+		Real fl = i > 0      ? max(Real(0), damping * fluxL(i, j) + a * (eta - SWM_Surface(height, terrain, hasTerrain, i - 1, j))) : Real(0);
+		Real fr = i < nx - 1 ? max(Real(0), damping * fluxR(i, j) + a * (eta - SWM_Surface(height, terrain, hasTerrain, i + 1, j))) : Real(0);
+		Real fb = j > 0      ? max(Real(0), damping * fluxB(i, j) + a * (eta - SWM_Surface(height, terrain, hasTerrain, i, j - 1))) : Real(0);
+		Real ft = j < nz - 1 ? max(Real(0), damping * fluxT(i, j) + a * (eta - SWM_Surface(height, terrain, hasTerrain, i, j + 1))) : Real(0);
+
+		//a cell may not drain more water than it holds
+		Real outflow = fl + fr + fb + ft;
+		if (outflow > EPSILON)
+		{
+			Real scale = height(i, j) * spacing * spacing / (outflow * dt);
+			if (scale < Real(1))
+			{
+				fl *= scale;
+				fr *= scale;
+				fb *= scale;
+				ft *= scale;
+			}
+		}
+
+		fluxL(i, j) = fl;
+		fluxR(i, j) = fr;
+		fluxB(i, j) = fb;
+		fluxT(i, j) = ft;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void SWM_UpdateHeight(
+		DeviceArray2D<Real> height,
+		DeviceArray2D<Coord> velocity,
+		DeviceArray2D<Real> fluxL,
+		DeviceArray2D<Real> fluxR,
+		DeviceArray2D<Real> fluxB,
+		DeviceArray2D<Real> fluxT,
+		Real spacing,
+		Real dt)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		int nx = height.Nx();
+		int nz = height.Ny();
+		if (tId >= nx * nz) return;
+
+		int i = tId % nx;
+		int j = tId / nx;
+
+		Real inL = i > 0      ? fluxR(i - 1, j) : Real(0);
+		Real inR = i < nx - 1 ? fluxL(i + 1, j) : Real(0);
+		Real inB = j > 0      ? fluxT(i, j - 1) : Real(0);
+		Real inT = j < nz - 1 ? fluxB(i, j + 1) : Real(0);
+
+		Real dV = dt * (inL + inR + inB + inT - fluxL(i, j) - fluxR(i, j) - fluxB(i, j) - fluxT(i, j));
+
+		Real h = height(i, j) + dV / (spacing * spacing);
+		h = h < Real(0) ? Real(0) : h;
+		height(i, j) = h;
+
+		//depth-averaged velocity from the net flux through the cell, used
+		//for shoreline coupling; dry cells report zero
+		Coord vel(0);
+		if (h > EPSILON)
+		{
+			vel[0] = Real(0.5) * (inL - fluxL(i, j) + fluxR(i, j) - inR) / (spacing * h);
+			vel[1] = Real(0.5) * (inB - fluxB(i, j) + fluxT(i, j) - inT) / (spacing * h);
+		}
+		velocity(i, j) = vel;
+	}
+
+	template<typename TDataType>
+	ShallowWaterModel<TDataType>::ShallowWaterModel()
+		: NumericalModel()
+		, m_spacing(Real(0.005))
+		, m_gravity(Real(9.8))
+		, m_damping(Real(0.998))
+	{
+	}
+
+	template<typename TDataType>
+	ShallowWaterModel<TDataType>::~ShallowWaterModel()
+	{
+		m_fluxL.Release();
+		m_fluxR.Release();
+		m_fluxB.Release();
+		m_fluxT.Release();
+		m_velocity.Release();
+	}
+
+	template<typename TDataType>
+	bool ShallowWaterModel<TDataType>::initializeImpl()
+	{
+		return m_height != nullptr;
+	}
+
+	template<typename TDataType>
+	void ShallowWaterModel<TDataType>::step(Real dt)
+	{
+		if (m_height == nullptr) return;
+
+		int nx = m_height->Nx();
+		int nz = m_height->Ny();
+		int num = nx * nz;
+		if (num == 0) return;
+
+		if (m_fluxL.Nx() != nx || m_fluxL.Ny() != nz)
+		{
+			m_fluxL.Resize(nx, nz);
+			m_fluxR.Resize(nx, nz);
+			m_fluxB.Resize(nx, nz);
+			m_fluxT.Resize(nx, nz);
+			m_velocity.Resize(nx, nz);
+
+			m_fluxL.Reset();
+			m_fluxR.Reset();
+			m_fluxB.Reset();
+			m_fluxT.Reset();
+			m_velocity.Reset();
+		}
+
+		bool hasTerrain = m_terrain != nullptr && m_terrain->Nx() == nx && m_terrain->Ny() == nz;
+
+		//an empty dummy keeps the kernel signature uniform when no bed is bound
+		DeviceArray2D<Real>& terrain = hasTerrain ? *m_terrain : m_fluxL;
+
+		//the damping factor is specified per second
+		Real damping = pow(m_damping, dt);
+
+		cuExecute(num, SWM_UpdateFlux,
+			m_fluxL,
+			m_fluxR,
+			m_fluxB,
+			m_fluxT,
+			*m_height,
+			terrain,
+			hasTerrain,
+			m_gravity,
+			m_spacing,
+			damping,
+			dt);
+
+		cuExecute(num, SWM_UpdateHeight,
+			*m_height,
+			m_velocity,
+			m_fluxL,
+			m_fluxR,
+			m_fluxB,
+			m_fluxT,
+			m_spacing,
+			dt);
+	}
+
+#ifdef PRECISION_FLOAT
+	template class ShallowWaterModel<DataType2f>;
+#else
+	template class ShallowWaterModel<DataType2d>;
+#endif
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "Framework/Framework/NumericalModel.h"
+#include "Core/Array/Array2D.h"
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	ShallowWaterModel
+	*	\brief	GPU shallow-water solver over a height field.
+	*
+	*	Large calm water bodies do not need particles. This model evolves
+	*	the water depth of a HeightField with the virtual-pipe scheme: each
+	*	cell keeps four outflow fluxes that relax towards the surface-level
+	*	difference to its neighbors, the fluxes are rescaled so a cell never
+	*	drains below zero within a step, and the depth update is the flux
+	*	divergence. Two kernels per step, no neighbor search and no linear
+	*	solve, which makes it orders of magnitude cheaper than a particle
+	*	discretization of the same water body.
+	*
+	*	A cell-centered depth-averaged velocity is derived from the fluxes
+	*	each step for shoreline coupling with particle splashes.
+	*/
+	template<typename TDataType>
+	class ShallowWaterModel : public NumericalModel
+	{
+		DECLARE_CLASS_1(ShallowWaterModel, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		ShallowWaterModel();
+		virtual ~ShallowWaterModel();
+
+		void step(Real dt) override;
+
+		/*!
+		*	\brief	Bind the depth samples the model evolves; the array is
+		*	owned by the HeightField node.
+		*/
+		void setHeights(DeviceArray2D<Real>* height) { m_height = height; }
+
+		/*!
+		*	\brief	Optional bed elevation; an empty or mismatched array
+		*	means a flat bed at zero. The surface level the fluxes respond
+		*	to is bed plus depth.
+		*/
+		void setTerrain(DeviceArray2D<Real>* terrain) { m_terrain = terrain; }
+
+		void setGridSpacing(Real spacing) { m_spacing = spacing; }
+
+		void setGravity(Real g) { m_gravity = g; }
+
+		/*!
+		*	\brief	Per-second retention factor of the pipe fluxes; values
+		*	below one damp surface oscillations.
+		*/
+		void setDamping(Real damping) { m_damping = damping; }
+
+		//! Depth-averaged cell velocity of the last step, for coupling.
+		DeviceArray2D<Coord>& getVelocity() { return m_velocity; }
+
+		//! The pipe fluxes, exposed so the particle coupling layer can
+		//! deposit the momentum of absorbed particles (see
+		//! HeightFieldParticleCoupling).
+		DeviceArray2D<Real>& getFluxL() { return m_fluxL; }
+		DeviceArray2D<Real>& getFluxR() { return m_fluxR; }
+		DeviceArray2D<Real>& getFluxB() { return m_fluxB; }
+		DeviceArray2D<Real>& getFluxT() { return m_fluxT; }
+
+	protected:
+		bool initializeImpl() override;
+
+	private:
+		Real m_spacing;
+		Real m_gravity;
+		Real m_damping;
+
+		DeviceArray2D<Real>* m_height = nullptr;
+		DeviceArray2D<Real>* m_terrain = nullptr;
+
+		//outflow fluxes towards -x, +x, -z and +z
+		DeviceArray2D<Real> m_fluxL;
+		DeviceArray2D<Real> m_fluxR;
+		DeviceArray2D<Real> m_fluxB;
+		DeviceArray2D<Real> m_fluxT;
+
+		DeviceArray2D<Coord> m_velocity;
+	};
+
+#ifdef PRECISION_FLOAT
+	extern template class ShallowWaterModel<DataType2f>;
+#else
+	extern template class ShallowWaterModel<DataType2d>;
+#endif
+}
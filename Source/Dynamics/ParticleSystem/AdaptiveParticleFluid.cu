@@ -0,0 +1,138 @@
+#include <cuda_runtime.h>
+#include "AdaptiveParticleFluid.h"
+#include "DensityPBD.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(AdaptiveParticleFluid, TDataType)
+
+	template<typename Real>
+	__global__ void APF_FillMass(
+		DeviceArray<Real> massArr,
+		Real mass)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= massArr.size()) return;
+
+		massArr[pId] = mass;
+	}
+
+	template<typename Real>
+	__global__ void APF_ComputeInvMass(
+		DeviceArray<Real> invMassArr,
+		DeviceArray<Real> massArr)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= massArr.size()) return;
+
+		invMassArr[pId] = Real(1) / massArr[pId];
+	}
+
+	template<typename TDataType>
+	AdaptiveParticleFluid<TDataType>::AdaptiveParticleFluid(std::string name)
+		: ParticleFluid<TDataType>(name)
+	{
+	}
+
+	template<typename TDataType>
+	AdaptiveParticleFluid<TDataType>::~AdaptiveParticleFluid()
+	{
+		m_mass.release();
+	}
+
+	template<typename TDataType>
+	void AdaptiveParticleFluid<TDataType>::setAdaptationSpace(Real spacing, Coord lo, Coord hi)
+	{
+		m_adaptor.setSpacing(spacing);
+		m_adaptor.setBounds(lo, hi);
+	}
+
+	template<typename TDataType>
+	bool AdaptiveParticleFluid<TDataType>::resetStatus()
+	{
+		bool ret = ParticleFluid<TDataType>::resetStatus();
+
+		//all particles start at the fine level; masses are kept relative to
+		//the base sampling mass, so the uniform initial value is one
+		int num = this->currentPosition()->getElementCount();
+		m_mass.resize(num);
+		if (num > 0)
+		{
+			cuExecute(num, APF_FillMass,
+				m_mass,
+				Real(1));
+		}
+
+		m_frame = 0;
+
+		return ret;
+	}
+
+	template<typename TDataType>
+	void AdaptiveParticleFluid<TDataType>::advance(Real dt)
+	{
+		if (this->getParticleEmitters().size() == 0)
+		{
+			m_frame++;
+
+			int num = this->currentPosition()->getElementCount();
+			if (num > 0 && m_frame % m_interval == 0)
+			{
+				//the particle set may have been rewritten behind our back,
+				//e.g. by compaction; restart from the fine level then
+				if (m_mass.size() != num)
+				{
+					m_mass.resize(num);
+					cuExecute(num, APF_FillMass,
+						m_mass,
+						Real(1));
+				}
+
+				int newNum = m_adaptor.apply(
+					this->currentPosition()->getValue(),
+					this->currentVelocity()->getValue(),
+					m_mass,
+					Real(1));
+
+				if (newNum != num)
+				{
+					this->currentPosition()->setElementCount(newNum);
+					this->currentVelocity()->setElementCount(newNum);
+					this->currentForce()->setElementCount(newNum);
+					m_mass.resize(newNum);
+				}
+
+				cuSafeCall(cudaMemcpy(this->currentPosition()->getValue().getDataPtr(), m_adaptor.outPosition().getDataPtr(), newNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+				cuSafeCall(cudaMemcpy(this->currentVelocity()->getValue().getDataPtr(), m_adaptor.outVelocity().getDataPtr(), newNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+				cuSafeCall(cudaMemcpy(m_mass.getDataPtr(), m_adaptor.outMass().getDataPtr(), newNum * sizeof(Real), cudaMemcpyDeviceToDevice));
+
+				updateMassInv(newNum);
+			}
+		}
+
+		ParticleFluid<TDataType>::advance(dt);
+	}
+
+	template<typename TDataType>
+	void AdaptiveParticleFluid<TDataType>::updateMassInv(int num)
+	{
+		auto pbd = this->template getModule<DensityPBD<TDataType>>("density_constraint");
+		if (pbd == nullptr || num == 0) return;
+
+		if (pbd->m_massInv.getElementCount() != num)
+		{
+			pbd->m_massInv.setElementCount(num);
+		}
+
+		cuExecute(num, APF_ComputeInvMass,
+			pbd->m_massInv.getValue(),
+			m_mass);
+	}
+
+#ifdef PRECISION_FLOAT
+	template class AdaptiveParticleFluid<DataType3f>;
+#else
+	template class AdaptiveParticleFluid<DataType3d>;
+#endif
+}
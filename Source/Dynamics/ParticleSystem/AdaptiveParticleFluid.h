@@ -0,0 +1,67 @@
+#pragma once
+#include "ParticleFluid.h"
+#include "ParticleMergeSplit.h"
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	AdaptiveParticleFluid
+	*	\brief	Position-based fluid with spatially adaptive resolution.
+	*
+	*	Keeps the fine sampling near the free surface and lets the interior
+	*	coarsen: every adaptation interval a ParticleMergeSplit pass merges
+	*	interior particles and re-splits coarse particles that drift back
+	*	into the surface band, then the node's state fields are resized to
+	*	the new count. The per-particle mass produced by merging is coupled
+	*	into the density solver through DensityPBD's inverse-mass field, so
+	*	heavy particles move proportionally less under the same constraint.
+	*
+	*	Adaptation is skipped while particle emitters drive the particle
+	*	set, since ParticleFluid then rewrites the state arrays from the
+	*	emitters each frame.
+	*/
+	template<typename TDataType>
+	class AdaptiveParticleFluid : public ParticleFluid<TDataType>
+	{
+		DECLARE_CLASS_1(AdaptiveParticleFluid, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		AdaptiveParticleFluid(std::string name = "default");
+		virtual ~AdaptiveParticleFluid();
+
+		void advance(Real dt) override;
+		bool resetStatus() override;
+
+		/*!
+		*	\brief	Fine sampling distance and the domain of the adaptation
+		*	hash; forwarded to ParticleMergeSplit.
+		*/
+		void setAdaptationSpace(Real spacing, Coord lo, Coord hi);
+
+		/*!
+		*	\brief	Run the merge/split pass every frames-th frame.
+		*/
+		void setAdaptationInterval(int frames) { m_interval = frames < 1 ? 1 : frames; }
+
+		void setSurfaceNeighborThreshold(int num) { m_adaptor.setSurfaceNeighborThreshold(num); }
+		void setMaxMassRatio(Real factor) { m_adaptor.setMaxMassRatio(factor); }
+
+	private:
+		void updateMassInv(int num);
+
+		ParticleMergeSplit<TDataType> m_adaptor;
+
+		DeviceArray<Real> m_mass;
+
+		int m_interval = 8;
+		int m_frame = 0;
+	};
+
+#ifdef PRECISION_FLOAT
+	extern template class AdaptiveParticleFluid<DataType3f>;
+#else
+	extern template class AdaptiveParticleFluid<DataType3d>;
+#endif
+}
@@ -35,6 +35,14 @@ namespace PhysIKA
 			OBJECTID_MASK = 0x000000FF
 		};
 
+		//bit 27, taken from the undefined range: particle lies within the
+		//narrow band of a boundary and needs the precise constraint
+		enum LocationType
+		{
+			LOCATION_MASK = 0x08000000,
+			LOCATION_NEAR_BOUNDARY = 0x08000000
+		};
+
 		COMM_FUNC inline void SetMaterialType(MaterialType type) { m_tag = ((~MATERIAL_MASK) & m_tag) | type; }
 		COMM_FUNC inline void SetKinematicType(KinematicType type) { m_tag = ((~KINEMATIC_MASK) & m_tag) | type; }
 		COMM_FUNC inline void SetObjectId(unsigned id) { m_tag = ((~OBJECTID_MASK) & m_tag) | id; }
@@ -61,6 +69,10 @@ namespace PhysIKA
 		COMM_FUNC inline void SetPassive() { SetKinematicType(KinematicType::KINEMATIC_PASSIVE); }
 		COMM_FUNC inline void SetDynamic() { SetKinematicType(KinematicType::KINEMATIC_POSITIVE); }
 
+		COMM_FUNC inline bool IsNearBoundary() { return (m_tag & LOCATION_MASK) != 0; }
+		COMM_FUNC inline void SetNearBoundary() { m_tag |= LOCATION_NEAR_BOUNDARY; }
+		COMM_FUNC inline void ClearNearBoundary() { m_tag &= ~LOCATION_MASK; }
+
 	private:
 		unsigned m_tag;
 	};
@@ -0,0 +1,125 @@
+#include <cuda_runtime.h>
+#include "AttributePartition.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA {
+
+	__global__ void APT_MarkDynamic(
+		DeviceArray<int> flags,
+		DeviceArray<Attribute> attArr)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= attArr.size()) return;
+
+		flags[pId] = attArr[pId].IsDynamic() ? 1 : 0;
+	}
+
+	__global__ void APT_Scatter(
+		DeviceArray<int> dynamicIds,
+		DeviceArray<int> otherIds,
+		DeviceArray<int> flags,
+		DeviceArray<int> offsets)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= flags.size()) return;
+
+		if (flags[pId] == 1)
+		{
+			dynamicIds[offsets[pId]] = pId;
+		}
+		else
+		{
+			//non-dynamic particles before pId: pId minus the dynamic ones
+			otherIds[pId - offsets[pId]] = pId;
+		}
+	}
+
+	__global__ void APT_CountMixedWarps(
+		int* counter,
+		DeviceArray<int> flags)
+	{
+		//one thread inspects one 32-wide index group
+		int wId = threadIdx.x + (blockIdx.x * blockDim.x);
+		int begin = wId * 32;
+		if (begin >= flags.size()) return;
+
+		int end = begin + 32 < flags.size() ? begin + 32 : flags.size();
+		int first = flags[begin];
+		for (int i = begin + 1; i < end; i++)
+		{
+			if (flags[i] != first)
+			{
+				atomicAdd(counter, 1);
+				return;
+			}
+		}
+	}
+
+	AttributePartition::AttributePartition()
+	{
+	}
+
+	AttributePartition::~AttributePartition()
+	{
+		m_flags.release();
+		m_offsets.release();
+		m_dynamicIds.release();
+		m_otherIds.release();
+
+		if (m_counter != nullptr)
+		{
+			cudaFree(m_counter);
+		}
+	}
+
+	void AttributePartition::update(DeviceArray<Attribute>& attributes)
+	{
+		int num = attributes.size();
+		if (num == 0)
+		{
+			m_dynamicNum = 0;
+			m_otherNum = 0;
+			m_mixedWarps = 0;
+			return;
+		}
+
+		if (m_flags.size() != num)
+		{
+			m_flags.resize(num);
+			m_offsets.resize(num);
+			m_dynamicIds.resize(num);
+			m_otherIds.resize(num);
+		}
+		if (m_counter == nullptr)
+		{
+			cuSafeCall(cudaMalloc(&m_counter, sizeof(int)));
+		}
+
+		cuExecute(num, APT_MarkDynamic,
+			m_flags,
+			attributes);
+
+		m_scan.exclusive(m_offsets, m_flags);
+
+		//the dynamic count is the last offset plus the last flag
+		int lastOffset = 0;
+		int lastFlag = 0;
+		cuSafeCall(cudaMemcpy(&lastOffset, m_offsets.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastFlag, m_flags.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		m_dynamicNum = lastOffset + lastFlag;
+		m_otherNum = num - m_dynamicNum;
+
+		cuExecute(num, APT_Scatter,
+			m_dynamicIds,
+			m_otherIds,
+			m_flags,
+			m_offsets);
+
+		cuSafeCall(cudaMemset(m_counter, 0, sizeof(int)));
+		int warpNum = (num + 31) / 32;
+		cuExecute(warpNum, APT_CountMixedWarps,
+			m_counter,
+			m_flags);
+		cuSafeCall(cudaMemcpy(&m_mixedWarps, m_counter, sizeof(int), cudaMemcpyDeviceToHost));
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Core/Utility/Scan.h"
+#include "Attribute.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	AttributePartition
+	*	\brief	Index partition by kinematic attribute class.
+	*
+	*	Kernels guarded by `if (!attribute[pId].IsDynamic()) return;` pay
+	*	for the guard in warp divergence whenever dynamic and non-dynamic
+	*	particles interleave. This helper compacts the particle indices
+	*	into one list per class on the device - flags, an exclusive Scan,
+	*	one scatter - so such kernels can launch over a list and every
+	*	thread takes the same path. A divergence counter, the number of
+	*	32-wide index groups that mix classes, quantifies what the
+	*	unpartitioned launch would have lost.
+	*/
+	class AttributePartition
+	{
+	public:
+		AttributePartition();
+		~AttributePartition();
+
+		/*!
+		*	\brief	Rebuild the index lists from the current attributes;
+		*	once per step is enough as long as no module edits them.
+		*/
+		void update(DeviceArray<Attribute>& attributes);
+
+		//! indices of the dynamic particles, in ascending order
+		DeviceArray<int>& dynamicIndices() { return m_dynamicIds; }
+
+		//! indices of the fixed and passive particles, in ascending order
+		DeviceArray<int>& otherIndices() { return m_otherIds; }
+
+		int dynamicCount() { return m_dynamicNum; }
+		int otherCount() { return m_otherNum; }
+
+		/*!
+		*	\brief	32-wide index groups of the last update containing both
+		*	classes; each one would have run both paths of a guarded kernel.
+		*/
+		int mixedWarpCount() { return m_mixedWarps; }
+
+	private:
+		Scan m_scan;
+
+		DeviceArray<int> m_flags;
+		DeviceArray<int> m_offsets;
+		DeviceArray<int> m_dynamicIds;
+		DeviceArray<int> m_otherIds;
+
+		int* m_counter = nullptr;
+
+		int m_dynamicNum = 0;
+		int m_otherNum = 0;
+		int m_mixedWarps = 0;
+	};
+}
@@ -4,6 +4,15 @@
 #include "Framework/Framework/Node.h"
 
 #include "Framework/Topology/DistanceField3D.h"
+#include "Framework/Topology/TriangleSet.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <thrust/copy.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/execution_policy.h>
 
 namespace PhysIKA
 {
@@ -66,9 +75,148 @@ namespace PhysIKA
 		velArr[pId] = vec;
 	}
 
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void K_TagNearBoundary(
+		DeviceArray<int> flags,
+		DeviceArray<Coord> posArr,
+		DistanceField3D<TDataType> df,
+		Attribute* attArr,
+		Real band)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Real dist;
+		Coord normal;
+		df.getDistance(posArr[pId], dist, normal);
+
+		bool near = dist < band;
+		flags[pId] = near ? 1 : 0;
+
+		if (attArr != NULL)
+		{
+			if (near)
+				attArr[pId].SetNearBoundary();
+			else
+				attArr[pId].ClearNearBoundary();
+		}
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void K_ConstrainSDFBanded(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<int> nearIds,
+		int nearNum,
+		DistanceField3D<TDataType> df,
+		Real normalFriction,
+		Real tangentialFriction,
+		Real dt)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= nearNum) return;
+
+		int pId = nearIds[tId];
+
+		Coord pos = posArr[pId];
+		Coord vec = velArr[pId];
+
+		Real dist;
+		Coord normal;
+		df.getDistance(pos, dist, normal);
+		// constrain particle
+		if (dist <= 0) {
+			Real olddist = -dist;
+			RandNumber rGen(pId);
+			dist = 0.0001f*rGen.Generate();
+			// reflect position
+			pos -= (olddist + dist)*normal;
+			// reflect velocity
+			Real vlength = vec.norm();
+			Real vec_n = vec.dot(normal);
+			Coord vec_normal = vec_n*normal;
+			Coord vec_tan = vec - vec_normal;
+			if (vec_n > 0) vec_normal = -vec_normal;
+			vec_normal *= (1.0f - normalFriction);
+			vec = vec_normal + vec_tan;
+			vec *= pow(Real(M_E), -dt*tangentialFriction);
+		}
+
+		posArr[pId] = pos;
+		velArr[pId] = vec;
+	}
+
+	template<typename TDataType>
+	bool BoundaryConstraint<TDataType>::constrainBanded(DeviceArray<Coord>& position, DeviceArray<Coord>& velocity, Real dt)
+	{
+		int num = position.size();
+		cuint pDim = cudaGridSize(num, BLOCK_SIZE);
+
+		//retag when the position array changed or the band interval elapsed;
+		//a different array (several objects driving one boundary) always retags
+		bool stale = m_band_ptr != position.getDataPtr()
+			|| m_near_flags.size() != num
+			|| m_band_frame % m_refresh_interval == 0;
+
+		if (stale)
+		{
+			if (m_near_flags.size() != num)
+			{
+				m_near_flags.resize(num);
+				m_near_ids.resize(num);
+			}
+
+			//the attribute bit is only maintained for the module's own particles
+			Attribute* attPtr = NULL;
+			if (!m_attribute.isEmpty() && m_attribute.getElementCount() == num && !m_position.isEmpty() && m_position.getValue().getDataPtr() == position.getDataPtr())
+			{
+				attPtr = m_attribute.getValue().getDataPtr();
+			}
+
+			K_TagNearBoundary << <pDim, BLOCK_SIZE >> > (
+				m_near_flags,
+				position,
+				*m_cSDF,
+				attPtr,
+				m_band);
+
+			int* ids_end = thrust::copy_if(thrust::device,
+				thrust::make_counting_iterator(0), thrust::make_counting_iterator(num),
+				m_near_flags.getDataPtr(), m_near_ids.getDataPtr(), thrust::identity<int>());
+			m_near_num = ids_end - m_near_ids.getDataPtr();
+
+			m_band_ptr = position.getDataPtr();
+			m_band_frame = 0;
+		}
+		m_band_frame++;
+
+		if (m_near_num > 0)
+		{
+			cuint nDim = cudaGridSize(m_near_num, BLOCK_SIZE);
+			K_ConstrainSDFBanded << <nDim, BLOCK_SIZE >> > (
+				position,
+				velocity,
+				m_near_ids,
+				m_near_num,
+				*m_cSDF,
+				m_normal_friction,
+				m_tangent_friction,
+				dt);
+		}
+
+		return true;
+	}
+
 	template<typename TDataType>
 	bool BoundaryConstraint<TDataType>::constrain()
 	{
+		updateActiveRegion(m_position.getValue());
+
+		if (m_narrow_band)
+		{
+			return constrainBanded(m_position.getValue(), m_velocity.getValue(), getParent()->getDt());
+		}
+
 		cuint pDim = cudaGridSize(m_position.getElementCount(), BLOCK_SIZE);
 		K_ConstrainSDF << <pDim, BLOCK_SIZE >> > (
 			m_position.getValue(),
@@ -84,6 +232,13 @@ namespace PhysIKA
 	template<typename TDataType>
 	bool BoundaryConstraint<TDataType>::constrain(DeviceArray<Coord>& position, DeviceArray<Coord>& velocity, Real dt)
 	{
+		updateActiveRegion(position);
+
+		if (m_narrow_band)
+		{
+			return constrainBanded(position, velocity, dt);
+		}
+
 		cuint pDim = cudaGridSize(position.size(), BLOCK_SIZE);
 		K_ConstrainSDF << <pDim, BLOCK_SIZE >> > (
 			position,
@@ -104,6 +259,138 @@ namespace PhysIKA
 		m_cSDF->loadSDF(filename, inverted);
 	}
 
+	template<typename TDataType>
+	void BoundaryConstraint<TDataType>::loadBricks(std::string filename, bool inverted)
+	{
+		m_cSDF->loadBricks(filename, inverted);
+	}
+
+	__device__ static float AtomicMinReal(float* address, float val)
+	{
+		int* address_as_i = (int*)address;
+		int old = *address_as_i, assumed;
+		do {
+			assumed = old;
+			old = atomicCAS(address_as_i, assumed, __float_as_int(fminf(val, __int_as_float(assumed))));
+		} while (assumed != old);
+		return __int_as_float(old);
+	}
+
+	__device__ static float AtomicMaxReal(float* address, float val)
+	{
+		int* address_as_i = (int*)address;
+		int old = *address_as_i, assumed;
+		do {
+			assumed = old;
+			old = atomicCAS(address_as_i, assumed, __float_as_int(fmaxf(val, __int_as_float(assumed))));
+		} while (assumed != old);
+		return __int_as_float(old);
+	}
+
+	__device__ static double AtomicMinReal(double* address, double val)
+	{
+		unsigned long long* address_as_ull = (unsigned long long*)address;
+		unsigned long long old = *address_as_ull, assumed;
+		do {
+			assumed = old;
+			old = atomicCAS(address_as_ull, assumed, __double_as_longlong(fmin(val, __longlong_as_double(assumed))));
+		} while (assumed != old);
+		return __longlong_as_double(old);
+	}
+
+	__device__ static double AtomicMaxReal(double* address, double val)
+	{
+		unsigned long long* address_as_ull = (unsigned long long*)address;
+		unsigned long long old = *address_as_ull, assumed;
+		do {
+			assumed = old;
+			old = atomicCAS(address_as_ull, assumed, __double_as_longlong(fmax(val, __longlong_as_double(assumed))));
+		} while (assumed != old);
+		return __longlong_as_double(old);
+	}
+
+	//grid-stride bounding box: thread-local bounds, shared halving, one
+	//atomic per block and axis
+	template <typename Real, typename Coord>
+	__global__ void K_ParticleBounds(
+		Real* bounds,
+		DeviceArray<Coord> posArr)
+	{
+		__shared__ Real s_lo[3][BLOCK_SIZE];
+		__shared__ Real s_hi[3][BLOCK_SIZE];
+
+		Coord lo(Real(1e30));
+		Coord hi(Real(-1e30));
+
+		int num = posArr.size();
+		for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < num; i += blockDim.x * gridDim.x)
+		{
+			Coord pos = posArr[i];
+			for (int d = 0; d < 3; d++)
+			{
+				lo[d] = pos[d] < lo[d] ? pos[d] : lo[d];
+				hi[d] = pos[d] > hi[d] ? pos[d] : hi[d];
+			}
+		}
+
+		for (int d = 0; d < 3; d++)
+		{
+			s_lo[d][threadIdx.x] = lo[d];
+			s_hi[d][threadIdx.x] = hi[d];
+		}
+		__syncthreads();
+
+		for (int stride = blockDim.x / 2; stride > 0; stride /= 2)
+		{
+			if (threadIdx.x < stride)
+			{
+				for (int d = 0; d < 3; d++)
+				{
+					if (s_lo[d][threadIdx.x + stride] < s_lo[d][threadIdx.x]) s_lo[d][threadIdx.x] = s_lo[d][threadIdx.x + stride];
+					if (s_hi[d][threadIdx.x + stride] > s_hi[d][threadIdx.x]) s_hi[d][threadIdx.x] = s_hi[d][threadIdx.x + stride];
+				}
+			}
+			__syncthreads();
+		}
+
+		if (threadIdx.x == 0)
+		{
+			for (int d = 0; d < 3; d++)
+			{
+				AtomicMinReal(bounds + d, s_lo[d][0]);
+				AtomicMaxReal(bounds + 3 + d, s_hi[d][0]);
+			}
+		}
+	}
+
+	template<typename TDataType>
+	void BoundaryConstraint<TDataType>::updateActiveRegion(DeviceArray<Coord>& position)
+	{
+		if (!m_cSDF->isStreaming() || position.size() <= 0)
+		{
+			return;
+		}
+
+		if (m_region_bounds.size() != 6)
+		{
+			m_region_bounds.resize(6);
+		}
+
+		Real init[6] = { Real(1e30), Real(1e30), Real(1e30), Real(-1e30), Real(-1e30), Real(-1e30) };
+		cuSafeCall(cudaMemcpy(m_region_bounds.getDataPtr(), init, 6 * sizeof(Real), cudaMemcpyHostToDevice));
+
+		int gDim = cudaGridSize(position.size(), BLOCK_SIZE);
+		gDim = gDim < 64 ? gDim : 64;
+		K_ParticleBounds << <gDim, BLOCK_SIZE >> > (
+			m_region_bounds.getDataPtr(),
+			position);
+
+		Real result[6];
+		cuSafeCall(cudaMemcpy(result, m_region_bounds.getDataPtr(), 6 * sizeof(Real), cudaMemcpyDeviceToHost));
+
+		m_cSDF->setActiveRegion(Coord(result[0], result[1], result[2]), Coord(result[3], result[4], result[5]));
+	}
+
 
 	template<typename TDataType>
 	void BoundaryConstraint<TDataType>::setCube(Coord lo, Coord hi, Real distance, bool inverted)
@@ -125,4 +412,40 @@ namespace PhysIKA
 		m_cSDF->loadSphere(center, r, inverted);
 	}
 
+	template<typename TDataType>
+	void BoundaryConstraint<TDataType>::setMesh(std::shared_ptr<TriangleSet<TDataType>> triSet, Real distance, bool inverted)
+	{
+		DeviceArray<Coord>& points = triSet->getPoints();
+		int num = points.size();
+		if (num <= 0) return;
+
+		//mesh bounding box, computed once on the host at load time
+		std::vector<Coord> host_points(num);
+		cuSafeCall(cudaMemcpy(&host_points[0], points.getDataPtr(), num * sizeof(Coord), cudaMemcpyDeviceToHost));
+
+		Coord lo = host_points[0];
+		Coord hi = host_points[0];
+		for (int i = 1; i < num; ++i)
+		{
+			for (int d = 0; d < 3; ++d)
+			{
+				lo[d] = std::min(lo[d], host_points[i][d]);
+				hi[d] = std::max(hi[d], host_points[i][d]);
+			}
+		}
+
+		int nx = floor((hi[0] - lo[0]) / distance);
+		int ny = floor((hi[1] - lo[1]) / distance);
+		int nz = floor((hi[2] - lo[2]) / distance);
+
+		m_cSDF->setSpace(lo - 5 * distance, hi + 5 * distance, nx + 10, ny + 10, nz + 10);
+		m_cSDF->loadMesh(points, *(triSet->getTriangles()), inverted);
+	}
+
+
+#ifdef PRECISION_FLOAT
+	template class BoundaryConstraint<DataType3f>;
+#else
+	template class BoundaryConstraint<DataType3d>;
+#endif
 }
\ No newline at end of file
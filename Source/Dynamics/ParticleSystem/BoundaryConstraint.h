@@ -1,10 +1,12 @@
 #pragma once
 #include "Framework/Framework/ModuleConstraint.h"
 #include "Framework/Framework/FieldArray.h"
+#include "Attribute.h"
 
 namespace PhysIKA {
 
 	template<typename TDataType> class DistanceField3D;
+	template<typename TDataType> class TriangleSet;
 
 	template<typename TDataType>
 	class BoundaryConstraint : public ConstraintModule
@@ -22,23 +24,77 @@ namespace PhysIKA {
 		bool constrain(DeviceArray<Coord>& position, DeviceArray<Coord>& velocity, Real dt);
 
 		void load(std::string filename, bool inverted = false);
+
+		/**
+		 * @brief Open a chunked brick file written by DistanceField3D::saveBricks.
+		 * Only the coarse level is read up front; full-resolution bricks are
+		 * streamed in around the particles as they move (see updateActiveRegion),
+		 * so huge terrain fields start instantly and device memory follows the
+		 * active region.
+		 */
+		void loadBricks(std::string filename, bool inverted = false);
+
 		void setCube(Coord lo, Coord hi, Real distance, bool inverted = false);
 		void setSphere(Coord center, Real r, Real distance, bool inverted = false);
 
+		/// bake the SDF from a triangle mesh on the GPU, no pre-baked file needed
+		void setMesh(std::shared_ptr<TriangleSet<TDataType>> triSet, Real distance, bool inverted = false);
+
+		/**
+		 * @brief Restrict the precise SDF constraint to particles within band of
+		 * the boundary. A tagging pass evaluates the SDF for all particles only
+		 * every refreshInterval steps, compacts the near-boundary indices (and
+		 * sets the near-boundary Attribute bit when the attribute field is
+		 * connected); the steps in between constrain only that subset. band must
+		 * be larger than the distance a particle can travel in refreshInterval
+		 * steps.
+		 */
+		void enableNarrowBand(bool enabled, Real band = Real(0.05), int refreshInterval = 8)
+		{
+			m_narrow_band = enabled;
+			m_band = band;
+			m_refresh_interval = refreshInterval < 1 ? 1 : refreshInterval;
+		}
+
 	public:
 		DeviceArrayField<Coord> m_position;
 		DeviceArrayField<Coord> m_velocity;
+		DeviceArrayField<Attribute> m_attribute;
 
 		Real m_normal_friction = 0.95f;
 		Real m_tangent_friction = 0.0;
 
 		std::shared_ptr<DistanceField3D<TDataType>> m_cSDF;
+
+	private:
+		bool constrainBanded(DeviceArray<Coord>& position, DeviceArray<Coord>& velocity, Real dt);
+
+		/**
+		 * @brief Feed the particle bounding box to the streaming SDF loader.
+		 * No-op unless the field came from loadBricks.
+		 */
+		void updateActiveRegion(DeviceArray<Coord>& position);
+
+		bool m_narrow_band = false;
+		Real m_band = Real(0.05);
+		int m_refresh_interval = 8;
+
+		//narrow-band state; retagged when stale, when the position array
+		//changes, or every refreshInterval steps
+		int m_band_frame = 0;
+		int m_near_num = 0;
+		Coord* m_band_ptr = nullptr;
+		DeviceArray<int> m_near_flags;
+		DeviceArray<int> m_near_ids;
+
+		//particle bounds scratch for the streaming SDF (min xyz, max xyz)
+		DeviceArray<Real> m_region_bounds;
 	};
 
 #ifdef PRECISION_FLOAT
-template class BoundaryConstraint<DataType3f>;
+extern template class BoundaryConstraint<DataType3f>;
 #else
-template class BoundaryConstraint<DataType3d>;
+extern template class BoundaryConstraint<DataType3d>;
 #endif
 
 }
@@ -18,6 +18,10 @@ namespace PhysIKA
     template<typename TDataType, int PhaseCount>
     CahnHilliard<TDataType, PhaseCount>::~CahnHilliard()
 	{
+        m_gridC.Release();
+        m_gridC0.Release();
+        m_gridMu.Release();
+        m_gridWeight.Release();
 	}
 
 
@@ -151,11 +155,239 @@ namespace PhysIKA
     }
 
 
+    template<typename Real, typename Coord, typename PhaseVector>
+    __global__ void CH_ParticleToGrid(
+        DeviceArray3D<PhaseVector> gridC,
+        DeviceArray3D<Real> gridW,
+        DeviceArray<Coord> posArr,
+        DeviceArray<PhaseVector> cArr,
+        Coord origin,
+        Real spacing)
+	{
+        int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+        if (pId >= posArr.size()) return;
+
+        Coord gp = (posArr[pId] - origin) / spacing;
+        int i = (int)floor(gp[0]); int j = (int)floor(gp[1]); int k = (int)floor(gp[2]);
+        Real fx = gp[0] - i; Real fy = gp[1] - j; Real fz = gp[2] - k;
+
+        PhaseVector c_i = cArr[pId];
+
+        for (int dk = 0; dk < 2; dk++)
+        {
+            for (int dj = 0; dj < 2; dj++)
+            {
+                for (int di = 0; di < 2; di++)
+                {
+                    int gi = i + di; int gj = j + dj; int gk = k + dk;
+                    gi = gi < 0 ? 0 : (gi > gridC.Nx() - 1 ? gridC.Nx() - 1 : gi);
+                    gj = gj < 0 ? 0 : (gj > gridC.Ny() - 1 ? gridC.Ny() - 1 : gj);
+                    gk = gk < 0 ? 0 : (gk > gridC.Nz() - 1 ? gridC.Nz() - 1 : gk);
+
+                    Real w = (di == 0 ? 1 - fx : fx)*(dj == 0 ? 1 - fy : fy)*(dk == 0 ? 1 - fz : fz);
+
+                    int id = gridC.Index(gi, gj, gk);
+                    for (int ph = 0; ph < c_i.dims(); ph++)
+                    {
+                        atomicAdd(&gridC[id][ph], w*c_i[ph]);
+                    }
+                    atomicAdd(&gridW[id], w);
+                }
+            }
+        }
+    }
+
+    template<typename Real, typename PhaseVector>
+    __global__ void CH_GridNormalize(
+        DeviceArray3D<PhaseVector> gridC,
+        DeviceArray3D<Real> gridW)
+	{
+        int id = threadIdx.x + (blockIdx.x * blockDim.x);
+        if (id >= gridC.Size()) return;
+
+        if (gridW[id] > EPSILON)
+        {
+            gridC[id] /= gridW[id];
+        }
+    }
+
+    template<typename TDataType,
+    typename Real=typename TDataType::Real,
+    typename PhaseVector=typename CahnHilliard<TDataType>::PhaseVector>
+    __global__ void CH_GridChemicalPotential(
+        DeviceArray3D<PhaseVector> gridMu,
+        DeviceArray3D<PhaseVector> gridC,
+        Real spacing,
+        Real epsilon)
+	{
+        int id = threadIdx.x + (blockIdx.x * blockDim.x);
+        if (id >= gridC.Size()) return;
+
+        int i = id % gridC.Nx();
+        int j = (id / gridC.Nx()) % gridC.Ny();
+        int k = id / (gridC.Nx()*gridC.Ny());
+
+        int im = i > 0 ? i - 1 : i;					int ip = i < gridC.Nx() - 1 ? i + 1 : i;
+        int jm = j > 0 ? j - 1 : j;					int jp = j < gridC.Ny() - 1 ? j + 1 : j;
+        int km = k > 0 ? k - 1 : k;					int kp = k < gridC.Nz() - 1 ? k + 1 : k;
+
+        PhaseVector c = gridC(i, j, k);
+        PhaseVector lap_c = gridC(im, j, k) + gridC(ip, j, k)
+            + gridC(i, jm, k) + gridC(i, jp, k)
+            + gridC(i, j, km) + gridC(i, j, kp) - c*Real(6);
+        lap_c /= spacing*spacing;
+
+        HelmholtzEnergyFunction<TDataType> F{/*alpha*/1, /*s1*/0, /*s2*/0};
+        PhaseVector mu = F.derivative(c);
+        Real sum = 0; for (int ph = 0; ph < mu.dims(); ph++) sum += mu[ph];
+        mu -= sum/mu.dims();
+        mu -= epsilon * epsilon * lap_c;
+        gridMu[id] = mu;
+    }
+
+    template<typename Real, typename PhaseVector>
+    __global__ void CH_GridUpdateConcentration(
+        DeviceArray3D<PhaseVector> gridC,
+        DeviceArray3D<PhaseVector> gridMu,
+        Real spacing,
+        Real M,
+        Real dt)
+	{
+        int id = threadIdx.x + (blockIdx.x * blockDim.x);
+        if (id >= gridC.Size()) return;
+
+        int i = id % gridC.Nx();
+        int j = (id / gridC.Nx()) % gridC.Ny();
+        int k = id / (gridC.Nx()*gridC.Ny());
+
+        int im = i > 0 ? i - 1 : i;					int ip = i < gridC.Nx() - 1 ? i + 1 : i;
+        int jm = j > 0 ? j - 1 : j;					int jp = j < gridC.Ny() - 1 ? j + 1 : j;
+        int km = k > 0 ? k - 1 : k;					int kp = k < gridC.Nz() - 1 ? k + 1 : k;
+
+        PhaseVector lap_mu = gridMu(im, j, k) + gridMu(ip, j, k)
+            + gridMu(i, jm, k) + gridMu(i, jp, k)
+            + gridMu(i, j, km) + gridMu(i, j, kp) - gridMu(i, j, k)*Real(6);
+        lap_mu /= spacing*spacing;
+
+        PhaseVector c = gridC[id] + lap_mu * (M * dt);
+        for (int ph = 0; ph < c.dims(); ph++)
+            if (c[ph] < 0) c[ph] = 0;
+        Real sum = 0; for (int ph = 0; ph < c.dims(); ph++) sum += c[ph];
+        if (sum > EPSILON) c /= sum;
+        gridC[id] = c;
+    }
+
+    template<typename Real, typename Coord, typename PhaseVector>
+    __global__ void CH_GridToParticle(
+        DeviceArray<PhaseVector> cArr,
+        DeviceArray<Coord> posArr,
+        DeviceArray3D<PhaseVector> gridC,
+        DeviceArray3D<PhaseVector> gridC0,
+        Coord origin,
+        Real spacing)
+	{
+        int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+        if (pId >= posArr.size()) return;
+
+        Coord gp = (posArr[pId] - origin) / spacing;
+        int i = (int)floor(gp[0]); int j = (int)floor(gp[1]); int k = (int)floor(gp[2]);
+        Real fx = gp[0] - i; Real fy = gp[1] - j; Real fz = gp[2] - k;
+
+        //gather the grid-side change only, so particle detail survives the round trip
+        PhaseVector dc(0);
+        for (int dk = 0; dk < 2; dk++)
+        {
+            for (int dj = 0; dj < 2; dj++)
+            {
+                for (int di = 0; di < 2; di++)
+                {
+                    int gi = i + di; int gj = j + dj; int gk = k + dk;
+                    gi = gi < 0 ? 0 : (gi > gridC.Nx() - 1 ? gridC.Nx() - 1 : gi);
+                    gj = gj < 0 ? 0 : (gj > gridC.Ny() - 1 ? gridC.Ny() - 1 : gj);
+                    gk = gk < 0 ? 0 : (gk > gridC.Nz() - 1 ? gridC.Nz() - 1 : gk);
+
+                    Real w = (di == 0 ? 1 - fx : fx)*(dj == 0 ? 1 - fy : fy)*(dk == 0 ? 1 - fz : fz);
+                    dc += (gridC(gi, gj, gk) - gridC0(gi, gj, gk)) * w;
+                }
+            }
+        }
+
+        PhaseVector c = cArr[pId] + dc;
+        for (int ph = 0; ph < c.dims(); ph++)
+            if (c[ph] < 0) c[ph] = 0;
+        Real sum = 0; for (int ph = 0; ph < c.dims(); ph++) sum += c[ph];
+        if (sum > EPSILON) c /= sum;
+        cArr[pId] = c;
+    }
+
+    template<typename TDataType, int PhaseCount>
+    void CahnHilliard<TDataType, PhaseCount>::integrateOnGrid(Real dt)
+	{
+        int num = m_position.getElementCount();
+        uint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+        int nx = (int)ceil((m_gridHi[0] - m_gridLo[0]) / m_gridSpacing) + 1;
+        int ny = (int)ceil((m_gridHi[1] - m_gridLo[1]) / m_gridSpacing) + 1;
+        int nz = (int)ceil((m_gridHi[2] - m_gridLo[2]) / m_gridSpacing) + 1;
+
+        if (m_gridC.Nx() != nx || m_gridC.Ny() != ny || m_gridC.Nz() != nz)
+        {
+            m_gridC.Resize(nx, ny, nz);
+            m_gridC0.Resize(nx, ny, nz);
+            m_gridMu.Resize(nx, ny, nz);
+            m_gridWeight.Resize(nx, ny, nz);
+        }
+
+        m_gridC.Reset();
+        m_gridWeight.Reset();
+
+        CH_ParticleToGrid<<<pDims, BLOCK_SIZE>>>(
+            m_gridC,
+            m_gridWeight,
+            m_position.getValue(),
+            m_concentration.getValue(),
+            m_gridLo,
+            m_gridSpacing);
+
+        uint gDims = cudaGridSize(m_gridC.Size(), BLOCK_SIZE);
+        CH_GridNormalize<<<gDims, BLOCK_SIZE>>>(m_gridC, m_gridWeight);
+
+        cuSafeCall(cudaMemcpy(m_gridC0.GetDataPtr(), m_gridC.GetDataPtr(), m_gridC.Size() * sizeof(PhaseVector), cudaMemcpyDeviceToDevice));
+
+        CH_GridChemicalPotential<TDataType><<<gDims, BLOCK_SIZE>>>(
+            m_gridMu,
+            m_gridC,
+            m_gridSpacing,
+            m_interfaceEpsilon.getValue());
+
+        CH_GridUpdateConcentration<<<gDims, BLOCK_SIZE>>>(
+            m_gridC,
+            m_gridMu,
+            m_gridSpacing,
+            m_degenerateMobilityM.getValue(),
+            dt);
+
+        CH_GridToParticle<<<pDims, BLOCK_SIZE>>>(
+            m_concentration.getValue(),
+            m_position.getValue(),
+            m_gridC,
+            m_gridC0,
+            m_gridLo,
+            m_gridSpacing);
+        cuSynchronize();
+    }
+
     template<typename TDataType, int PhaseCount>
     bool CahnHilliard<TDataType, PhaseCount>::integrate() 
 	{
         Real dt = getParent()->getDt();
 
+        if (m_useGrid)
+        {
+            integrateOnGrid(dt);
+            return true;
+        }
+
         int num = m_position.getElementCount();
 
 		uint pDims = cudaGridSize(num, BLOCK_SIZE);
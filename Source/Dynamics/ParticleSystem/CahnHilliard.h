@@ -10,6 +10,7 @@
  */
 #pragma once
 #include "Framework/Framework/Module.h"
+#include "Core/Array/Array3D.h"
 
 namespace PhysIKA
 {
@@ -28,6 +29,29 @@ namespace PhysIKA
 
 		bool integrate();
 
+		/**
+		 * @brief Solve the phase field on a coarse background grid instead of
+		 * per particle. Concentrations are splatted to the grid with trilinear
+		 * weights, the chemical potential and the update use 7-point stencils,
+		 * and the concentration change is gathered back to the particles. Cuts
+		 * the stencil cost by roughly the particle/cell ratio.
+		 */
+		void setGridMode(bool enabled, Real spacing)
+		{
+			m_useGrid = enabled;
+			m_gridSpacing = spacing;
+		}
+
+		/**
+		 * @brief Domain covered by the background grid; particles outside are
+		 * clamped to the boundary cells.
+		 */
+		void setGridBounds(Coord lo, Coord hi)
+		{
+			m_gridLo = lo;
+			m_gridHi = hi;
+		}
+
 		VarField<Real> m_particleVolume;
 		VarField<Real> m_smoothingLength;
 
@@ -40,6 +64,19 @@ namespace PhysIKA
 
 		DeviceArrayField<PhaseVector> m_chemicalPotential;
         DeviceArrayField<PhaseVector> m_concentration;
+
+	private:
+		void integrateOnGrid(Real dt);
+
+		bool m_useGrid = false;
+		Real m_gridSpacing = Real(0.02);
+		Coord m_gridLo = Coord(0);
+		Coord m_gridHi = Coord(1);
+
+		DeviceArray3D<PhaseVector> m_gridC;
+		DeviceArray3D<PhaseVector> m_gridC0;
+		DeviceArray3D<PhaseVector> m_gridMu;
+		DeviceArray3D<Real> m_gridWeight;
 	};
 #ifdef PRECISION_FLOAT
 	template class CahnHilliard<DataType3f>;
@@ -0,0 +1,544 @@
+#include "ClothSelfCollision.h"
+#include "Core/Utility.h"
+#include "Core/IntervalVector3.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Topology/TriangleSet.h"
+#include "Framework/Topology/NeighborQuery.h"
+
+#include <set>
+#include <vector>
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(ClothSelfCollision, TDataType)
+
+	template<typename TDataType>
+	ClothSelfCollision<TDataType>::ClothSelfCollision()
+		: ConstraintModule()
+	{
+		this->attachField(&m_position, "position", "Storing the particle positions!", false);
+		this->attachField(&m_velocity, "velocity", "Storing the particle velocities!", false);
+	}
+
+	template<typename TDataType>
+	ClothSelfCollision<TDataType>::~ClothSelfCollision()
+	{
+		if (m_reduce != nullptr)
+		{
+			delete m_reduce;
+		}
+	}
+
+	template<typename Coord>
+	GPU_FUNC void SelfCol_AtomicAddCoord(Coord* addr, Coord val)
+	{
+		atomicAdd(&((*addr)[0]), val[0]);
+		atomicAdd(&((*addr)[1]), val[1]);
+		atomicAdd(&((*addr)[2]), val[2]);
+	}
+
+	//closest point on triangle abc to p, with barycentric weights
+	template<typename Real, typename Coord>
+	GPU_FUNC void SelfCol_ClosestPointTriangle(
+		Coord p, Coord a, Coord b, Coord c,
+		Coord& q, Real& w0, Real& w1, Real& w2)
+	{
+		Coord ab = b - a;
+		Coord ac = c - a;
+		Coord ap = p - a;
+		Real d1 = ab.dot(ap);
+		Real d2 = ac.dot(ap);
+		if (d1 <= 0 && d2 <= 0) { w0 = 1; w1 = 0; w2 = 0; q = a; return; }
+
+		Coord bp = p - b;
+		Real d3 = ab.dot(bp);
+		Real d4 = ac.dot(bp);
+		if (d3 >= 0 && d4 <= d3) { w0 = 0; w1 = 1; w2 = 0; q = b; return; }
+
+		Real vc = d1*d4 - d3*d2;
+		if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		{
+			Real v = d1 / (d1 - d3);
+			w0 = 1 - v; w1 = v; w2 = 0;
+			q = a + ab*v;
+			return;
+		}
+
+		Coord cp = p - c;
+		Real d5 = ab.dot(cp);
+		Real d6 = ac.dot(cp);
+		if (d6 >= 0 && d5 <= d6) { w0 = 0; w1 = 0; w2 = 1; q = c; return; }
+
+		Real vb = d5*d2 - d1*d6;
+		if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		{
+			Real w = d2 / (d2 - d6);
+			w0 = 1 - w; w1 = 0; w2 = w;
+			q = a + ac*w;
+			return;
+		}
+
+		Real va = d3*d6 - d5*d4;
+		if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+		{
+			Real w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			w0 = 0; w1 = 1 - w; w2 = w;
+			q = b + (c - b)*w;
+			return;
+		}
+
+		Real denom = Real(1) / (va + vb + vc);
+		Real v = vb*denom;
+		Real w = vc*denom;
+		w0 = 1 - v - w; w1 = v; w2 = w;
+		q = a + ab*v + ac*w;
+	}
+
+	//closest points of segments p1q1 and p2q2, returned as parameters s and t
+	template<typename Real, typename Coord>
+	GPU_FUNC void SelfCol_ClosestSegmentSegment(
+		Coord p1, Coord q1, Coord p2, Coord q2,
+		Real& s, Real& t)
+	{
+		Coord d1 = q1 - p1;
+		Coord d2 = q2 - p2;
+		Coord r = p1 - p2;
+		Real a = d1.dot(d1);
+		Real e = d2.dot(d2);
+		Real f = d2.dot(r);
+		Real c = d1.dot(r);
+		Real b = d1.dot(d2);
+
+		Real denom = a*e - b*b;
+		s = denom > EPSILON ? (b*f - c*e) / denom : Real(0);
+		s = s < 0 ? Real(0) : (s > 1 ? Real(1) : s);
+
+		t = e > EPSILON ? (b*s + f) / e : Real(0);
+		if (t < 0)
+		{
+			t = 0;
+			s = a > EPSILON ? -c / a : Real(0);
+			s = s < 0 ? Real(0) : (s > 1 ? Real(1) : s);
+		}
+		else if (t > 1)
+		{
+			t = 1;
+			s = a > EPSILON ? (b - c) / a : Real(0);
+			s = s < 0 ? Real(0) : (s > 1 ? Real(1) : s);
+		}
+	}
+
+	__global__ void K_SelfCollision_BuildVer2Tri(
+		NeighborList<int> ver2tri,
+		DeviceArray<TopologyModule::Triangle> triangles,
+		int limit)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= ver2tri.size()) return;
+
+		int num = 0;
+		for (int i = 0; i < triangles.size() && num < limit; ++i)
+		{
+			TopologyModule::Triangle tri = triangles[i];
+			if (tri[0] == pId || tri[1] == pId || tri[2] == pId)
+			{
+				ver2tri.setElement(pId, num++, i);
+			}
+		}
+		ver2tri.setNeighborSize(pId, num);
+	}
+
+	__global__ void K_SelfCollision_BuildVer2Edge(
+		NeighborList<int> ver2edge,
+		DeviceArray<TopologyModule::Edge> edges,
+		int limit)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= ver2edge.size()) return;
+
+		int num = 0;
+		for (int i = 0; i < edges.size() && num < limit; ++i)
+		{
+			TopologyModule::Edge edge = edges[i];
+			if (edge[0] == pId || edge[1] == pId)
+			{
+				ver2edge.setElement(pId, num++, i);
+			}
+		}
+		ver2edge.setNeighborSize(pId, num);
+	}
+
+	template<typename Coord>
+	__global__ void K_SelfCollision_VTCandidates(
+		NeighborList<int> candidates,
+		DeviceArray<Coord> posArr,
+		DeviceArray<TopologyModule::Triangle> triangles,
+		NeighborList<int> vertexNbr,
+		NeighborList<int> ver2tri,
+		int limit)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		int num = 0;
+		int nbSize = vertexNbr.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = vertexNbr.getElement(pId, ne);
+			int triSize = ver2tri.getNeighborSize(j);
+			for (int nt = 0; nt < triSize; nt++)
+			{
+				int t = ver2tri.getElement(j, nt);
+				TopologyModule::Triangle tri = triangles[t];
+				//skip incident triangles
+				if (tri[0] == pId || tri[1] == pId || tri[2] == pId) continue;
+
+				//the same triangle reaches pId through each nearby vertex
+				bool inserted = false;
+				for (int k = 0; k < num; k++)
+				{
+					if (candidates.getElement(pId, k) == t)
+					{
+						inserted = true;
+						break;
+					}
+				}
+				if (!inserted && num < limit)
+				{
+					candidates.setElement(pId, num++, t);
+				}
+			}
+		}
+		candidates.setNeighborSize(pId, num);
+	}
+
+	__global__ void K_SelfCollision_EECandidates(
+		NeighborList<int> candidates,
+		DeviceArray<TopologyModule::Edge> edges,
+		NeighborList<int> vertexNbr,
+		NeighborList<int> ver2edge,
+		int limit)
+	{
+		int eId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (eId >= edges.size()) return;
+
+		TopologyModule::Edge e0 = edges[eId];
+
+		int num = 0;
+		for (int side = 0; side < 2; side++)
+		{
+			int v = e0[side];
+			int nbSize = vertexNbr.getNeighborSize(v);
+			for (int ne = 0; ne < nbSize; ne++)
+			{
+				int j = vertexNbr.getElement(v, ne);
+				int edgeSize = ver2edge.getNeighborSize(j);
+				for (int nk = 0; nk < edgeSize; nk++)
+				{
+					int e = ver2edge.getElement(j, nk);
+					//each pair is handled once, by the edge with the smaller id
+					if (e <= eId) continue;
+
+					TopologyModule::Edge e1 = edges[e];
+					if (e1[0] == e0[0] || e1[0] == e0[1] || e1[1] == e0[0] || e1[1] == e0[1]) continue;
+
+					bool inserted = false;
+					for (int k = 0; k < num; k++)
+					{
+						if (candidates.getElement(eId, k) == e)
+						{
+							inserted = true;
+							break;
+						}
+					}
+					if (!inserted && num < limit)
+					{
+						candidates.setElement(eId, num++, e);
+					}
+				}
+			}
+		}
+		candidates.setNeighborSize(eId, num);
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void K_SelfCollision_VTResponse(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<TopologyModule::Triangle> triangles,
+		NeighborList<int> candidates,
+		Real thickness,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+
+		//interval box over every position the vertex can reach this step
+		IntervalVector3<Real> box_i = IntervalVector3<Real>::fromSegment(pos_i, pos_i + velArr[pId] * dt);
+
+		int nbSize = candidates.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int t = candidates.getElement(pId, ne);
+			TopologyModule::Triangle tri = triangles[t];
+			Coord a = posArr[tri[0]];
+			Coord b = posArr[tri[1]];
+			Coord c = posArr[tri[2]];
+
+			//conservative cull: if the swept boxes stay farther apart than the
+			//thickness for the whole step, the pair cannot collide
+			IntervalVector3<Real> box_t = IntervalVector3<Real>::fromSegment(a, a + velArr[tri[0]] * dt);
+			box_t.merge(IntervalVector3<Real>::fromSegment(b, b + velArr[tri[1]] * dt));
+			box_t.merge(IntervalVector3<Real>::fromSegment(c, c + velArr[tri[2]] * dt));
+			if (box_i.distanceSquaredLower(box_t) >= thickness * thickness) continue;
+
+			Coord q;
+			Real w0, w1, w2;
+			SelfCol_ClosestPointTriangle(pos_i, a, b, c, q, w0, w1, w2);
+
+			Coord d = pos_i - q;
+			Real dist = d.norm();
+			if (dist >= thickness) continue;
+
+			Coord n;
+			if (dist > EPSILON)
+			{
+				n = d / dist;
+			}
+			else
+			{
+				n = (b - a).cross(c - a);
+				if (n.norm() < EPSILON) continue;
+				n = n.normalize();
+			}
+
+			Real wsum = Real(1) + w0*w0 + w1*w1 + w2*w2;
+
+			//impulse on the approaching relative velocity
+			Coord vrel = velArr[pId] - (velArr[tri[0]]*w0 + velArr[tri[1]]*w1 + velArr[tri[2]]*w2);
+			Real vn = vrel.dot(n);
+			if (vn < 0)
+			{
+				Real imp = -vn / wsum;
+				SelfCol_AtomicAddCoord(&velArr[pId], n*imp);
+				SelfCol_AtomicAddCoord(&velArr[tri[0]], -n*(imp*w0));
+				SelfCol_AtomicAddCoord(&velArr[tri[1]], -n*(imp*w1));
+				SelfCol_AtomicAddCoord(&velArr[tri[2]], -n*(imp*w2));
+			}
+
+			//separate both sides by the remaining overlap
+			Real depth = (thickness - dist) / wsum;
+			SelfCol_AtomicAddCoord(&posArr[pId], n*depth);
+			SelfCol_AtomicAddCoord(&posArr[tri[0]], -n*(depth*w0));
+			SelfCol_AtomicAddCoord(&posArr[tri[1]], -n*(depth*w1));
+			SelfCol_AtomicAddCoord(&posArr[tri[2]], -n*(depth*w2));
+		}
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void K_SelfCollision_EEResponse(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<TopologyModule::Edge> edges,
+		NeighborList<int> candidates,
+		Real thickness,
+		Real dt)
+	{
+		int eId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (eId >= edges.size()) return;
+
+		TopologyModule::Edge e0 = edges[eId];
+		Coord p1 = posArr[e0[0]];
+		Coord q1 = posArr[e0[1]];
+
+		IntervalVector3<Real> box0 = IntervalVector3<Real>::fromSegment(p1, p1 + velArr[e0[0]] * dt);
+		box0.merge(IntervalVector3<Real>::fromSegment(q1, q1 + velArr[e0[1]] * dt));
+
+		int nbSize = candidates.getNeighborSize(eId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int e = candidates.getElement(eId, ne);
+			TopologyModule::Edge e1 = edges[e];
+			Coord p2 = posArr[e1[0]];
+			Coord q2 = posArr[e1[1]];
+
+			//same swept-box cull as the vertex-triangle pass
+			IntervalVector3<Real> box1 = IntervalVector3<Real>::fromSegment(p2, p2 + velArr[e1[0]] * dt);
+			box1.merge(IntervalVector3<Real>::fromSegment(q2, q2 + velArr[e1[1]] * dt));
+			if (box0.distanceSquaredLower(box1) >= thickness * thickness) continue;
+
+			Real s, t;
+			SelfCol_ClosestSegmentSegment(p1, q1, p2, q2, s, t);
+
+			Coord cA = p1 + (q1 - p1)*s;
+			Coord cB = p2 + (q2 - p2)*t;
+			Coord d = cA - cB;
+			Real dist = d.norm();
+			if (dist >= thickness || dist < EPSILON) continue;
+
+			Coord n = d / dist;
+
+			Real wA0 = 1 - s, wA1 = s;
+			Real wB0 = 1 - t, wB1 = t;
+			Real wsum = wA0*wA0 + wA1*wA1 + wB0*wB0 + wB1*wB1;
+
+			Coord vrel = velArr[e0[0]]*wA0 + velArr[e0[1]]*wA1 - velArr[e1[0]]*wB0 - velArr[e1[1]]*wB1;
+			Real vn = vrel.dot(n);
+			if (vn < 0)
+			{
+				Real imp = -vn / wsum;
+				SelfCol_AtomicAddCoord(&velArr[e0[0]], n*(imp*wA0));
+				SelfCol_AtomicAddCoord(&velArr[e0[1]], n*(imp*wA1));
+				SelfCol_AtomicAddCoord(&velArr[e1[0]], -n*(imp*wB0));
+				SelfCol_AtomicAddCoord(&velArr[e1[1]], -n*(imp*wB1));
+			}
+
+			Real depth = (thickness - dist) / wsum;
+			SelfCol_AtomicAddCoord(&posArr[e0[0]], n*(depth*wA0));
+			SelfCol_AtomicAddCoord(&posArr[e0[1]], n*(depth*wA1));
+			SelfCol_AtomicAddCoord(&posArr[e1[0]], -n*(depth*wB0));
+			SelfCol_AtomicAddCoord(&posArr[e1[1]], -n*(depth*wB1));
+		}
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void K_SelfCollision_Displacement(
+		DeviceArray<Real> disp,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> oldArr)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		disp[pId] = (posArr[pId] - oldArr[pId]).norm();
+	}
+
+	template<typename TDataType>
+	bool ClothSelfCollision<TDataType>::initializeImpl()
+	{
+		if (m_triSet == nullptr || m_position.isEmpty())
+		{
+			std::cout << "Exception: " << std::string("ClothSelfCollision's fields are not fully initialized!") << "\n";
+			return false;
+		}
+
+		int numV = m_position.getElementCount();
+
+		//take the edges from the topology when present, otherwise derive them from the triangles
+		auto edges = m_triSet->getEdges();
+		if (edges != nullptr && edges->size() > 0)
+		{
+			m_edges.resize(edges->size());
+			Function1Pt::copy(m_edges, *edges);
+		}
+		else
+		{
+			auto triangles = m_triSet->getTriangles();
+			std::vector<Triangle> hTri(triangles->size());
+			cuSafeCall(cudaMemcpy(&hTri[0], triangles->getDataPtr(), triangles->size() * sizeof(Triangle), cudaMemcpyDeviceToHost));
+
+			std::set<std::pair<int, int>> edgeSet;
+			for (int i = 0; i < hTri.size(); i++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					int v0 = hTri[i][k];
+					int v1 = hTri[i][(k + 1) % 3];
+					edgeSet.insert(std::make_pair(v0 < v1 ? v0 : v1, v0 < v1 ? v1 : v0));
+				}
+			}
+
+			std::vector<Edge> hEdges;
+			for (auto it = edgeSet.begin(); it != edgeSet.end(); it++)
+			{
+				hEdges.push_back(Edge(it->first, it->second));
+			}
+			m_edges.resize(hEdges.size());
+			Function1Pt::copy(m_edges, hEdges);
+		}
+
+		m_ver2tri.resize(numV);
+		m_ver2tri.setNeighborLimit(8);
+		m_ver2edge.resize(numV);
+		m_ver2edge.setNeighborLimit(8);
+
+		uint pDims = cudaGridSize(numV, BLOCK_SIZE);
+		K_SelfCollision_BuildVer2Tri << <pDims, BLOCK_SIZE >> > (m_ver2tri, *(m_triSet->getTriangles()), 8);
+		K_SelfCollision_BuildVer2Edge << <pDims, BLOCK_SIZE >> > (m_ver2edge, m_edges, 8);
+		cuSynchronize();
+
+		m_vt_candidates.resize(numV);
+		m_vt_candidates.setNeighborLimit(16);
+		m_ee_candidates.resize(m_edges.size());
+		m_ee_candidates.setNeighborLimit(16);
+
+		m_disp_buf.resize(numV);
+		m_reduce = Reduction<Real>::Create(numV);
+
+		m_nbrQuery = std::make_shared<NeighborQuery<TDataType>>();
+		m_nList = std::make_shared<NeighborList<int>>();
+		m_nList->resize(numV);
+		m_nList->setNeighborLimit(16);
+
+		return true;
+	}
+
+	template<typename TDataType>
+	void ClothSelfCollision<TDataType>::updateCandidates()
+	{
+		DeviceArray<Coord>& pos = m_position.getValue();
+
+		//gather at an enlarged radius so the lists stay valid while vertices
+		//move by up to half the slack
+		Real radius = 2 * m_thickness;
+		m_nbrQuery->queryParticleNeighbors(*m_nList, pos, radius);
+
+		uint pDims = cudaGridSize(pos.size(), BLOCK_SIZE);
+		K_SelfCollision_VTCandidates << <pDims, BLOCK_SIZE >> > (m_vt_candidates, pos, *(m_triSet->getTriangles()), *m_nList, m_ver2tri, 16);
+
+		uint eDims = cudaGridSize(m_edges.size(), BLOCK_SIZE);
+		K_SelfCollision_EECandidates << <eDims, BLOCK_SIZE >> > (m_ee_candidates, m_edges, *m_nList, m_ver2edge, 16);
+		cuSynchronize();
+
+		if (m_rebuild_pos.size() != pos.size())
+		{
+			m_rebuild_pos.resize(pos.size());
+		}
+		Function1Pt::copy(m_rebuild_pos, pos);
+	}
+
+	template<typename TDataType>
+	bool ClothSelfCollision<TDataType>::constrain()
+	{
+		DeviceArray<Coord>& pos = m_position.getValue();
+		DeviceArray<Coord>& vel = m_velocity.getValue();
+
+		uint pDims = cudaGridSize(pos.size(), BLOCK_SIZE);
+
+		if (m_rebuild_pos.size() != pos.size())
+		{
+			updateCandidates();
+		}
+		else
+		{
+			K_SelfCollision_Displacement << <pDims, BLOCK_SIZE >> > (m_disp_buf, pos, m_rebuild_pos);
+			Real maxDisp = m_reduce->maximum(m_disp_buf.getDataPtr(), m_disp_buf.size());
+			if (maxDisp > Real(0.5) * m_thickness)
+			{
+				updateCandidates();
+			}
+		}
+
+		Real dt = this->getParent()->getDt();
+
+		K_SelfCollision_VTResponse << <pDims, BLOCK_SIZE >> > (pos, vel, *(m_triSet->getTriangles()), m_vt_candidates, m_thickness, dt);
+
+		uint eDims = cudaGridSize(m_edges.size(), BLOCK_SIZE);
+		K_SelfCollision_EEResponse << <eDims, BLOCK_SIZE >> > (pos, vel, m_edges, m_ee_candidates, m_thickness, dt);
+		cuSynchronize();
+
+		return true;
+	}
+}
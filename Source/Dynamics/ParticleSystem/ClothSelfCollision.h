@@ -0,0 +1,94 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Framework/Framework/ModuleConstraint.h"
+#include "Framework/Framework/ModuleTopology.h"
+#include "Framework/Framework/FieldArray.h"
+#include "Framework/Topology/NeighborList.h"
+
+namespace PhysIKA {
+
+	template <typename> class TriangleSet;
+	template <typename> class NeighborQuery;
+	template <typename> class Reduction;
+
+	/*!
+	*	\class	ClothSelfCollision
+	*	\brief	Self-collision for cloth meshes.
+	*
+	*	Vertex-triangle and edge-edge proximity tests with impulse response.
+	*	Candidate pairs are gathered from a spatial hash at an enlarged radius
+	*	and cached; the hash and the candidate lists are only rebuilt once the
+	*	maximum vertex displacement exceeds half the slack, so typical frames
+	*	reuse the previous frame's pairs. Inside the response kernels each
+	*	candidate is first tested against interval boxes enclosing the motion
+	*	of both sides over the step; pairs whose conservative distance bound
+	*	never drops below the thickness skip the exact proximity tests.
+	*/
+	template<typename TDataType>
+	class ClothSelfCollision : public ConstraintModule
+	{
+		DECLARE_CLASS_1(ClothSelfCollision, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef typename TopologyModule::Edge Edge;
+		typedef typename TopologyModule::Triangle Triangle;
+
+		ClothSelfCollision();
+		~ClothSelfCollision() override;
+
+		bool constrain() override;
+
+		void setTopology(std::shared_ptr<TriangleSet<TDataType>> triSet) { m_triSet = triSet; }
+
+		/**
+		 * @brief Cloth thickness: proximities closer than this distance are resolved.
+		 */
+		void setThickness(Real thickness) { m_thickness = thickness; }
+
+	public:
+		/**
+		* @brief Particle position
+		*/
+		DeviceArrayField<Coord> m_position;
+
+		/**
+		* @brief Particle velocity
+		*/
+		DeviceArrayField<Coord> m_velocity;
+
+	protected:
+		bool initializeImpl() override;
+
+	private:
+		void updateCandidates();
+
+		Real m_thickness = Real(0.0075);
+
+		std::shared_ptr<TriangleSet<TDataType>> m_triSet;
+
+		DeviceArray<Edge> m_edges;
+
+		//vertex->triangle and vertex->edge incidence, built once
+		NeighborList<int> m_ver2tri;
+		NeighborList<int> m_ver2edge;
+
+		//cached candidate pairs, valid until vertices move by half the slack
+		NeighborList<int> m_vt_candidates;
+		NeighborList<int> m_ee_candidates;
+
+		DeviceArray<Coord> m_rebuild_pos;
+		DeviceArray<Real> m_disp_buf;
+
+		std::shared_ptr<NeighborQuery<TDataType>> m_nbrQuery;
+		std::shared_ptr<NeighborList<int>> m_nList;
+		Reduction<Real>* m_reduce = nullptr;
+	};
+
+#ifdef PRECISION_FLOAT
+template class ClothSelfCollision<DataType3f>;
+#else
+template class ClothSelfCollision<DataType3d>;
+#endif
+
+}
@@ -0,0 +1,226 @@
+#include "ConservationMonitor.h"
+#include "Core/Utility.h"
+#include "Framework/Framework/Node.h"
+
+#include <sstream>
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(ConservationMonitor, TDataType)
+
+	template<typename TDataType>
+	ConservationMonitor<TDataType>::ConservationMonitor()
+		: ComputeModule()
+	{
+		m_particleMass.setValue(Real(1));
+		m_kineticEnergy.setValue(Real(0));
+		m_potentialEnergy.setValue(Real(0));
+		m_totalMass.setValue(Real(0));
+		m_momentum.setValue(Coord(0));
+
+		attachField(&m_particleMass, "particle_mass", "Mass of a single particle!", false);
+		attachField(&m_position, "position", "Storing the particle positions!", false);
+		attachField(&m_velocity, "velocity", "Storing the particle velocities!", false);
+		attachField(&m_kineticEnergy, "kinetic_energy", "Kinetic energy of the latest sample!", false);
+		attachField(&m_potentialEnergy, "potential_energy", "Gravitational potential energy of the latest sample!", false);
+		attachField(&m_totalMass, "total_mass", "Total mass of the latest sample!", false);
+		attachField(&m_momentum, "momentum", "Linear momentum of the latest sample!", false);
+	}
+
+	template<typename TDataType>
+	ConservationMonitor<TDataType>::~ConservationMonitor()
+	{
+		for (int i = 0; i < 5; i++)
+		{
+			m_partial[i].release();
+		}
+		m_results.release();
+
+		if (m_reduce != NULL)
+		{
+			delete m_reduce;
+		}
+	}
+
+	//One pass over the state writes all five per-particle series; the
+	//batched reduction then collapses them in a single launch.
+	template<typename Real, typename Coord>
+	__global__ void CM_MeasureParticles(
+		DeviceArray<Real> kinetic,
+		DeviceArray<Real> potential,
+		DeviceArray<Real> momentumX,
+		DeviceArray<Real> momentumY,
+		DeviceArray<Real> momentumZ,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		Coord gravity,
+		Real mass)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+		Coord vel_i = velArr[pId];
+
+		kinetic[pId] = Real(0.5) * mass * vel_i.normSquared();
+		potential[pId] = -mass * gravity.dot(pos_i);
+		momentumX[pId] = mass * vel_i[0];
+		momentumY[pId] = mass * vel_i[1];
+		momentumZ[pId] = mass * vel_i[2];
+	}
+
+	template<typename TDataType>
+	void ConservationMonitor<TDataType>::compute()
+	{
+		if (m_position.isEmpty() || m_velocity.isEmpty())
+		{
+			return;
+		}
+
+		long call = m_counter++;
+		if (call % m_stride != 0)
+		{
+			return;
+		}
+
+		int num = m_position.getElementCount();
+		if (num <= 0)
+		{
+			return;
+		}
+
+		if (m_partial[0].size() != num)
+		{
+			for (int i = 0; i < 5; i++)
+			{
+				m_partial[i].resize(num);
+			}
+		}
+		if (m_results.size() != 5)
+		{
+			m_results.resize(5);
+		}
+		if (m_reduce == NULL)
+		{
+			m_reduce = new Reduction<Real>();
+		}
+
+		Real mass = m_particleMass.getValue();
+
+		cuint pDims = cudaGridSize(num, BLOCK_SIZE);
+		CM_MeasureParticles << <pDims, BLOCK_SIZE >> > (
+			m_partial[0],
+			m_partial[1],
+			m_partial[2],
+			m_partial[3],
+			m_partial[4],
+			m_position.getValue(),
+			m_velocity.getValue(),
+			m_gravity,
+			mass);
+		cuSynchronize();
+
+		Real* vals[5];
+		for (int i = 0; i < 5; i++)
+		{
+			vals[i] = m_partial[i].getDataPtr();
+		}
+		m_reduce->accumulateBatched(vals, 5, num, m_results.getDataPtr());
+
+		//the only host traffic per sample: five scalars
+		Real sums[5];
+		SyncAudit::getInstance().onImplicitSync("ConservationMonitor readback");
+		cuSafeCall(cudaMemcpy(sums, m_results.getDataPtr(), 5 * sizeof(Real), cudaMemcpyDeviceToHost));
+
+		Sample s;
+		s.frame = call;
+		s.kinetic = sums[0];
+		s.potential = sums[1];
+		s.mass = mass * num;
+		s.momentum = Coord(sums[2], sums[3], sums[4]);
+
+		if (m_ring.size() != (size_t)m_capacity)
+		{
+			m_ring.resize(m_capacity);
+		}
+		m_ring[m_head] = s;
+		m_head = (m_head + 1) % m_capacity;
+		m_count = m_count < m_capacity ? m_count + 1 : m_capacity;
+
+		m_kineticEnergy.setValue(s.kinetic);
+		m_potentialEnergy.setValue(s.potential);
+		m_totalMass.setValue(s.mass);
+		m_momentum.setValue(s.momentum);
+	}
+
+	template<typename TDataType>
+	void ConservationMonitor<TDataType>::setHistoryCapacity(int n)
+	{
+		m_capacity = n < 1 ? 1 : n;
+		m_ring.clear();
+		m_head = 0;
+		m_count = 0;
+	}
+
+	template<typename TDataType>
+	bool ConservationMonitor<TDataType>::latest(Sample& out)
+	{
+		if (m_count == 0)
+		{
+			return false;
+		}
+
+		out = m_ring[(m_head + m_capacity - 1) % m_capacity];
+		return true;
+	}
+
+	template<typename TDataType>
+	std::vector<typename ConservationMonitor<TDataType>::Sample> ConservationMonitor<TDataType>::history()
+	{
+		std::vector<Sample> out(m_count);
+		int start = (m_head + m_capacity - m_count) % m_capacity;
+		for (int i = 0; i < m_count; i++)
+		{
+			out[i] = m_ring[(start + i) % m_capacity];
+		}
+		return out;
+	}
+
+	template<typename TDataType>
+	std::string ConservationMonitor<TDataType>::report()
+	{
+		std::stringstream ss;
+		if (m_count == 0)
+		{
+			ss << "ConservationMonitor: no samples yet" << std::endl;
+			return ss.str();
+		}
+
+		std::vector<Sample> h = this->history();
+		Sample& first = h.front();
+		Sample& last = h.back();
+
+		auto drift = [](Real now, Real ref) -> Real {
+			Real base = ref < 0 ? -ref : ref;
+			return base < EPSILON ? Real(0) : (now - ref) / base;
+		};
+
+		Real e0 = first.kinetic + first.potential;
+		Real e1 = last.kinetic + last.potential;
+
+		ss << "ConservationMonitor over " << m_count << " samples:" << std::endl;
+		ss << "  total energy:   " << e1 << " (drift " << drift(e1, e0) << ")" << std::endl;
+		ss << "  kinetic energy: " << last.kinetic << std::endl;
+		ss << "  total mass:     " << last.mass << " (drift " << drift(last.mass, first.mass) << ")" << std::endl;
+		ss << "  momentum:       (" << last.momentum[0] << ", " << last.momentum[1] << ", " << last.momentum[2]
+			<< "), |p| " << last.momentum.norm() << std::endl;
+
+		return ss.str();
+	}
+
+#ifdef PRECISION_FLOAT
+	template class ConservationMonitor<DataType3f>;
+#else
+	template class ConservationMonitor<DataType3d>;
+#endif
+}
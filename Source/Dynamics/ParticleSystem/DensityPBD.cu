@@ -1,8 +1,12 @@
 #include <cuda_runtime.h>
+
+#include <cooperative_groups.h>
 //#include "Core/Utilities/template_functions.h"
 #include "Core/Utility.h"
 #include "DensityPBD.h"
 #include "Framework/Framework/Node.h"
+#include "Framework/Framework/SceneGraph.h"
+#include "Framework/Framework/FrameGovernor.h"
 #include <string>
 #include "SummationDensity.h"
 #include "Framework/Topology/FieldNeighbor.h"
@@ -17,7 +21,7 @@ namespace PhysIKA
 		DeviceArray<Real> weights,
 		DeviceArray<Coord> posArr,
 		NeighborList<int> neighbors,
-		SpikyKernel<Real> kernel,
+		FixedSpikyKernel<Real> kernel,
 		Real smoothingLength)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
@@ -34,7 +38,7 @@ namespace PhysIKA
 
 			if (r > EPSILON)
 			{
-				total_weight += kernel.Weight(r, smoothingLength);
+				total_weight += kernel.Weight(r);
 			}
 		}
 
@@ -42,21 +46,23 @@ namespace PhysIKA
 	}
 
 
-	template <typename Real, typename Coord>
+	template <typename Real, typename Coord, typename Coord4>
 	__global__ void K_ComputeLambdas(
 		DeviceArray<Real> lambdaArr,
 		DeviceArray<Real> rhoArr,
-		DeviceArray<Coord> posArr,
+		DeviceArray<Coord4> posArr,
 		NeighborList<int> neighbors,
-		SpikyKernel<Real> kern,
-		Real smoothingLength)
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		int* activity)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
 		if (pId >= posArr.size()) return;
+		if (activity != nullptr && activity[pId] == 0) return;
 
-		
 
-		Coord pos_i = posArr[pId];
+
+		Coord pos_i = coordPoint(posArr[pId]);
 
 		Real lamda_i = Real(0);
 		Coord grad_ci(0);
@@ -65,11 +71,12 @@ namespace PhysIKA
 		for (int ne = 0; ne < nbSize; ne++)
 		{
 			int j = neighbors.getElement(pId, ne);
-			Real r = (pos_i - posArr[j]).norm();
+			Coord pos_ij = pos_i - coordPoint(posArr[j]);
+			Real r = pos_ij.norm();
 
 			if (r > EPSILON)
 			{
-				Coord g = kern.Gradient(r, smoothingLength)*(pos_i - posArr[j]) * (1.0f / r);
+				Coord g = kern.Gradient(r)*pos_ij * (1.0f / r);
 				grad_ci += g;
 				lamda_i += g.dot(g);
 			}
@@ -96,7 +103,7 @@ namespace PhysIKA
 		DeviceArray<Coord> posArr,
 		DeviceArray<Real> massInvArr,
 		NeighborList<int> neighbors,
-		SpikyKernel<Real> kern,
+		FixedSpikyKernel<Real> kern,
 		Real smoothingLength)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
@@ -115,7 +122,7 @@ namespace PhysIKA
 
 			if (r > EPSILON)
 			{
-				Coord g = kern.Gradient(r, smoothingLength)*(pos_i - posArr[j]) * (1.0f / r);
+				Coord g = kern.Gradient(r)*(pos_i - posArr[j]) * (1.0f / r);
 				grad_ci += g;
 				lamda_i += g.dot(g) * massInvArr[j];
 			}
@@ -131,20 +138,72 @@ namespace PhysIKA
 	}
 
 
-	template <typename Real, typename Coord>
+	template <typename Real, typename Coord, typename Coord4>
+	__global__ void K_ComputeDensityAndLambdas(
+		DeviceArray<Real> lambdaArr,
+		DeviceArray<Real> rhoArr,
+		DeviceArray<Coord4> posArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		Real mass,
+		int* activity)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+		if (activity != nullptr && activity[pId] == 0) return;
+
+		Coord pos_i = coordPoint(posArr[pId]);
+
+		//One sweep over the neighbor list yields the density, the constraint
+		//gradients and the gradient-norm accumulator; the positions are only
+		//loaded once instead of twice per solver iteration.
+		Real rho_i = Real(0);
+		Real lamda_i = Real(0);
+		Coord grad_ci(0);
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Coord pos_ij = pos_i - coordPoint(posArr[j]);
+			Real r = pos_ij.norm();
+
+			rho_i += mass * kern.Weight(r);
+
+			if (r > EPSILON)
+			{
+				Coord g = kern.Gradient(r) * pos_ij * (1.0f / r);
+				grad_ci += g;
+				lamda_i += g.dot(g);
+			}
+		}
+
+		lamda_i += grad_ci.dot(grad_ci);
+
+		lamda_i = -(rho_i - 1000.0f) / (lamda_i + 0.1f);
+
+		rhoArr[pId] = rho_i;
+		lambdaArr[pId] = lamda_i > 0.0f ? 0.0f : lamda_i;
+	}
+
+
+	template <typename Real, typename Coord, typename Coord4>
 	__global__ void K_ComputeDisplacement(
-		DeviceArray<Coord> dPos, 
-		DeviceArray<Real> lambdas, 
-		DeviceArray<Coord> posArr, 
-		NeighborList<int> neighbors, 
-		SpikyKernel<Real> kern,
+		DeviceArray<Coord> dPos,
+		DeviceArray<Real> lambdas,
+		DeviceArray<Coord4> posArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
 		Real smoothingLength,
-		Real dt)
+		Real dt,
+		int* activity)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
 		if (pId >= posArr.size()) return;
+		if (activity != nullptr && activity[pId] == 0) return;
 
-		Coord pos_i = posArr[pId];
+		Coord pos_i = coordPoint(posArr[pId]);
 		Real lamda_i = lambdas[pId];
 
 		Coord dP_i(0);
@@ -152,10 +211,11 @@ namespace PhysIKA
 		for (int ne = 0; ne < nbSize; ne++)
 		{
 			int j = neighbors.getElement(pId, ne);
-			Real r = (pos_i - posArr[j]).norm();
+			Coord pos_ij = pos_i - coordPoint(posArr[j]);
+			Real r = pos_ij.norm();
 			if (r > EPSILON)
 			{
-				Coord dp_ij = 10.0f*(pos_i - posArr[j])*(lamda_i + lambdas[j])*kern.Gradient(r, smoothingLength)* (1.0 / r);
+				Coord dp_ij = 10.0f*pos_ij*(lamda_i + lambdas[j])*kern.Gradient(r)* (1.0 / r);
 				dP_i += dp_ij;
 				
 				atomicAdd(&dPos[pId][0], dp_ij[0]);
@@ -178,6 +238,49 @@ namespace PhysIKA
 //		dPos[pId] = dP_i;
 	}
 
+	/*!
+	*	\brief	Deterministic twin of K_ComputeDisplacement. The pair term
+	*	dp_ij is antisymmetric, and every pair is visited from both ends of
+	*	the (symmetric) neighbor list, so summing dp_ij twice over the
+	*	neighbors of pId and writing only dPos[pId] reproduces the scatter
+	*	result without atomics; with sorted neighbor lists the accumulation
+	*	order - and thus the rounding - is the same every run.
+	*/
+	template <typename Real, typename Coord, typename Coord4>
+	__global__ void K_ComputeDisplacementGather(
+		DeviceArray<Coord> dPos,
+		DeviceArray<Real> lambdas,
+		DeviceArray<Coord4> posArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		Real dt,
+		int* activity)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+		if (activity != nullptr && activity[pId] == 0) return;
+
+		Coord pos_i = coordPoint(posArr[pId]);
+		Real lamda_i = lambdas[pId];
+
+		Coord dP_i(0);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Coord pos_ij = pos_i - coordPoint(posArr[j]);
+			Real r = pos_ij.norm();
+			if (r > EPSILON)
+			{
+				Coord dp_ij = 10.0f*pos_ij*(lamda_i + lambdas[j])*kern.Gradient(r)* (1.0 / r);
+				dP_i += dp_ij * Real(2);
+			}
+		}
+
+		dPos[pId] = dP_i;
+	}
+
 	template <typename Real, typename Coord>
 	__global__ void K_ComputeDisplacement(
 		DeviceArray<Coord> dPos,
@@ -185,7 +288,7 @@ namespace PhysIKA
 		DeviceArray<Coord> posArr,
 		DeviceArray<Real> massInvArr,
 		NeighborList<int> neighbors,
-		SpikyKernel<Real> kern,
+		FixedSpikyKernel<Real> kern,
 		Real smoothingLength,
 		Real dt)
 	{
@@ -202,7 +305,7 @@ namespace PhysIKA
 			Real r = (pos_i - posArr[j]).norm();
 			if (r > EPSILON)
 			{
-				Coord dp_ij = 10.0f*(pos_i - posArr[j])*(lamda_i + lambdas[j])*kern.Gradient(r, smoothingLength)* (1.0 / r);
+				Coord dp_ij = 10.0f*(pos_i - posArr[j])*(lamda_i + lambdas[j])*kern.Gradient(r)* (1.0 / r);
 				Coord dp_ji = -dp_ij * massInvArr[j];
 				dp_ij = dp_ij * massInvArr[pId];
 				atomicAdd(&dPos[pId][0], dp_ij[0]);
@@ -223,19 +326,355 @@ namespace PhysIKA
 		}
 	}
 
+	//deterministic twin of the unified-particle overload above; the reaction
+	//a neighbor scatters onto pId is dp_ij*massInv[pId] again, so the whole
+	//sum is scaled by the particle's own inverse mass
+	template <typename Real, typename Coord>
+	__global__ void K_ComputeDisplacementGather(
+		DeviceArray<Coord> dPos,
+		DeviceArray<Real> lambdas,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Real> massInvArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+		Real lamda_i = lambdas[pId];
+
+		Coord dP_i(0);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Real r = (pos_i - posArr[j]).norm();
+			if (r > EPSILON)
+			{
+				Coord dp_ij = 10.0f*(pos_i - posArr[j])*(lamda_i + lambdas[j])*kern.Gradient(r)* (1.0 / r);
+				dP_i += dp_ij * Real(2);
+			}
+		}
+
+		dPos[pId] = dP_i * massInvArr[pId];
+	}
+
+	template<typename Real>
+	__device__ inline Real DP_ExpWeightGradient(const Real r, const Real h)
+	{
+		const Real q = r / h;
+		if (q > 1.0f) return 0.0f;
+		const Real d = 1.0 - q;
+		return 3 * d*d / h;
+	}
+
+	template<typename Real>
+	__device__ inline Real DP_BulkEnergyGradient(
+		Real rho,
+		Real restRho,
+		Real lambda)
+	{
+		Real ratio = rho / restRho;
+		ratio = ratio < Real(1) ? Real(1) : ratio;
+		return lambda*(ratio*ratio - 1)*ratio / restRho;
+	}
+
+	/*!
+	*	\brief	Displacement sweep with the Helmholtz surface smoothing folded
+	*	in: the pairwise bulk-energy term of H_TakeOneIteration is accumulated
+	*	from the same loaded neighbor data as the PBD correction, so the
+	*	separate smoothing sweep over the neighbor list disappears.
+	*/
+	template <typename Real, typename Coord>
+	__global__ void K_ComputeDisplacementSmoothed(
+		DeviceArray<Coord> dPos,
+		DeviceArray<Real> lambdas,
+		DeviceArray<Real> rhoArr,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		Real restRho,
+		Real smoothingLambda,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+		Real lamda_i = lambdas[pId];
+		Real BE_i = DP_BulkEnergyGradient(rhoArr[pId], restRho, smoothingLambda);
+
+		Real factor = Real(0.1) * dt*dt / restRho / (smoothingLength*smoothingLength);
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Coord pos_ij = pos_i - posArr[j];
+			Real r = pos_ij.norm();
+			if (r > EPSILON)
+			{
+				Coord dp_ij = 10.0f*pos_ij*(lamda_i + lambdas[j])*kern.Gradient(r)* (1.0 / r);
+
+				Real BE_j = DP_BulkEnergyGradient(rhoArr[j], restRho, smoothingLambda);
+				Real fe_ij = -(BE_i + BE_j) / 2 * DP_ExpWeightGradient(r, smoothingLength) / r;
+
+				dp_ij += factor*fe_ij*(posArr[j] - pos_i);
+
+				atomicAdd(&dPos[pId][0], dp_ij[0]);
+				atomicAdd(&dPos[j][0], -dp_ij[0]);
+
+				if (Coord::dims() >= 2)
+				{
+					atomicAdd(&dPos[pId][1], dp_ij[1]);
+					atomicAdd(&dPos[j][1], -dp_ij[1]);
+				}
+
+				if (Coord::dims() >= 3)
+				{
+					atomicAdd(&dPos[pId][2], dp_ij[2]);
+					atomicAdd(&dPos[j][2], -dp_ij[2]);
+				}
+			}
+		}
+	}
+
+	//deterministic twin of K_ComputeDisplacementSmoothed; both the spiky and
+	//the bulk-energy pair terms are antisymmetric, so the doubled one-sided
+	//sum again equals the scatter result
+	template <typename Real, typename Coord>
+	__global__ void K_ComputeDisplacementSmoothedGather(
+		DeviceArray<Coord> dPos,
+		DeviceArray<Real> lambdas,
+		DeviceArray<Real> rhoArr,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		Real restRho,
+		Real smoothingLambda,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+		Real lamda_i = lambdas[pId];
+		Real BE_i = DP_BulkEnergyGradient(rhoArr[pId], restRho, smoothingLambda);
+
+		Real factor = Real(0.1) * dt*dt / restRho / (smoothingLength*smoothingLength);
+
+		Coord dP_i(0);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Coord pos_ij = pos_i - posArr[j];
+			Real r = pos_ij.norm();
+			if (r > EPSILON)
+			{
+				Coord dp_ij = 10.0f*pos_ij*(lamda_i + lambdas[j])*kern.Gradient(r)* (1.0 / r);
+
+				Real BE_j = DP_BulkEnergyGradient(rhoArr[j], restRho, smoothingLambda);
+				Real fe_ij = -(BE_i + BE_j) / 2 * DP_ExpWeightGradient(r, smoothingLength) / r;
+
+				dp_ij += factor*fe_ij*(posArr[j] - pos_i);
+
+				dP_i += dp_ij * Real(2);
+			}
+		}
+
+		dPos[pId] = dP_i;
+	}
+
+	/*!
+	*	\brief	Persistent-threads solver: all iterations of the fused PBD
+	*	scheme run inside one cooperative launch, with grid-wide syncs
+	*	separating the reset+lambda, displacement and position phases. Each
+	*	thread walks particles in a grid-stride loop because a cooperative
+	*	grid is capped at one resident wave.
+	*/
+	template <typename Real, typename Coord>
+	__global__ void K_SolvePBDPersistent(
+		DeviceArray<Real> lambdaArr,
+		DeviceArray<Real> rhoArr,
+		DeviceArray<Coord> dPos,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		Real mass,
+		Real dt,
+		int itNum)
+	{
+		cooperative_groups::grid_group grid = cooperative_groups::this_grid();
+
+		int num = posArr.size();
+		int stride = blockDim.x * gridDim.x;
+
+		for (int iter = 0; iter < itNum; iter++)
+		{
+			for (int pId = threadIdx.x + (blockIdx.x * blockDim.x); pId < num; pId += stride)
+			{
+				dPos[pId] = Coord(0);
+
+				Coord pos_i = posArr[pId];
+
+				Real rho_i = Real(0);
+				Real lamda_i = Real(0);
+				Coord grad_ci(0);
+
+				int nbSize = neighbors.getNeighborSize(pId);
+				for (int ne = 0; ne < nbSize; ne++)
+				{
+					int j = neighbors.getElement(pId, ne);
+					Coord pos_ij = pos_i - posArr[j];
+					Real r = pos_ij.norm();
+
+					rho_i += mass * kern.Weight(r);
+
+					if (r > EPSILON)
+					{
+						Coord g = kern.Gradient(r) * pos_ij * (1.0f / r);
+						grad_ci += g;
+						lamda_i += g.dot(g);
+					}
+				}
+
+				lamda_i += grad_ci.dot(grad_ci);
+
+				lamda_i = -(rho_i - 1000.0f) / (lamda_i + 0.1f);
+
+				rhoArr[pId] = rho_i;
+				lambdaArr[pId] = lamda_i > 0.0f ? 0.0f : lamda_i;
+			}
+
+			grid.sync();
+
+			for (int pId = threadIdx.x + (blockIdx.x * blockDim.x); pId < num; pId += stride)
+			{
+				Coord pos_i = posArr[pId];
+				Real lamda_i = lambdaArr[pId];
+
+				int nbSize = neighbors.getNeighborSize(pId);
+				for (int ne = 0; ne < nbSize; ne++)
+				{
+					int j = neighbors.getElement(pId, ne);
+					Real r = (pos_i - posArr[j]).norm();
+					if (r > EPSILON)
+					{
+						Coord dp_ij = 10.0f*(pos_i - posArr[j])*(lamda_i + lambdaArr[j])*kern.Gradient(r)* (1.0 / r);
+
+						atomicAdd(&dPos[pId][0], dp_ij[0]);
+						atomicAdd(&dPos[j][0], -dp_ij[0]);
+
+						if (Coord::dims() >= 2)
+						{
+							atomicAdd(&dPos[pId][1], dp_ij[1]);
+							atomicAdd(&dPos[j][1], -dp_ij[1]);
+						}
+
+						if (Coord::dims() >= 3)
+						{
+							atomicAdd(&dPos[pId][2], dp_ij[2]);
+							atomicAdd(&dPos[j][2], -dp_ij[2]);
+						}
+					}
+				}
+			}
+
+			grid.sync();
+
+			for (int pId = threadIdx.x + (blockIdx.x * blockDim.x); pId < num; pId += stride)
+			{
+				posArr[pId] += dPos[pId];
+			}
+
+			grid.sync();
+		}
+	}
+
 	template <typename Real, typename Coord>
 	__global__ void K_UpdatePosition(
 		DeviceArray<Coord> posArr, 
 		DeviceArray<Coord> velArr, 
 		DeviceArray<Coord> dPos, 
-		Real dt)
+		Real dt,
+		int* activity)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
 		if (pId >= posArr.size()) return;
+		if (activity != nullptr && activity[pId] == 0) return;
 
 		posArr[pId] += dPos[pId];
 	}
 
+	//Gather-only displacement used by the two-color scheme: each particle of
+	//the active color accumulates its own correction, so no atomics are needed
+	//and the other color's positions stay untouched until the next phase.
+	template <typename Real, typename Coord>
+	__global__ void K_ComputeDisplacementRB(
+		DeviceArray<Coord> dPos,
+		DeviceArray<Real> lambdas,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		FixedSpikyKernel<Real> kern,
+		Real smoothingLength,
+		int parity)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+		if ((pId & 1) != parity) return;
+
+		Coord pos_i = posArr[pId];
+		Real lamda_i = lambdas[pId];
+
+		Coord dP_i(0);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Real r = (pos_i - posArr[j]).norm();
+			if (r > EPSILON)
+			{
+				dP_i += 20.0f*(pos_i - posArr[j])*(lamda_i + lambdas[j])*kern.Gradient(r)* (1.0 / r);
+			}
+		}
+
+		dPos[pId] = dP_i;
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void K_UpdatePositionRB(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> dPos,
+		int parity)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+		if ((pId & 1) != parity) return;
+
+		posArr[pId] += dPos[pId];
+	}
+
+	template <typename Real>
+	__global__ void K_ComputeDensityError(
+		DeviceArray<Real> error,
+		DeviceArray<Real> rhoArr,
+		Real restRho)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= error.size()) return;
+
+		//Only compression counts, matching the clamped lambda.
+		Real e = rhoArr[pId] - restRho;
+		error[pId] = e > Real(0) ? e / restRho : Real(0);
+	}
+
 
 	template<typename TDataType>
 	DensityPBD<TDataType>::DensityPBD()
@@ -257,14 +696,74 @@ namespace PhysIKA
 		this->inNeighborIndex()->connect(m_summation->inNeighborIndex());
 
 		m_summation->outDensity()->connect(this->outDensity());
+
+		//quality-scaling knobs for the frame-time governor: extra early-exit
+		//slack goes first, then the cosmetic surface smoothing term, then
+		//whole solver iterations
+		FrameGovernor::getInstance().registerKnob(this, 10, "DensityPBD tolerance",
+			[this]() {
+				if (m_governor_tol_steps >= 4) return false;
+				m_governor_tol_steps++;
+				return true;
+			},
+			[this]() {
+				if (m_governor_tol_steps == 0) return false;
+				m_governor_tol_steps--;
+				return true;
+			});
+
+		FrameGovernor::getInstance().registerKnob(this, 20, "DensityPBD surface smoothing",
+			[this]() {
+				if (m_smoothingLambda == Real(0) || m_governor_skip_smoothing) return false;
+				m_governor_skip_smoothing = true;
+				return true;
+			},
+			[this]() {
+				if (!m_governor_skip_smoothing) return false;
+				m_governor_skip_smoothing = false;
+				return true;
+			});
+
+		FrameGovernor::getInstance().registerKnob(this, 40, "DensityPBD iterations",
+			[this]() {
+				if (this->varIterationNumber()->getValue() - m_governor_iter_steps <= 2) return false;
+				m_governor_iter_steps++;
+				return true;
+			},
+			[this]() {
+				if (m_governor_iter_steps == 0) return false;
+				m_governor_iter_steps--;
+				return true;
+			});
 	}
 
 	template<typename TDataType>
 	DensityPBD<TDataType>::~DensityPBD()
 	{
+		FrameGovernor::getInstance().removeKnobs(this);
+
 		m_lamda.release();
 		m_deltaPos.release();
 		m_position_old.release();
+		m_posq.release();
+		m_error.release();
+		m_carried_lamda.release();
+		m_remap_buf.release();
+
+		if (m_reduce != nullptr)
+		{
+			delete m_reduce;
+		}
+	}
+
+	template<typename TDataType>
+	void DensityPBD<TDataType>::setHalfPrecisionCache(bool enabled)
+	{
+		m_summation->setHalfPrecisionCache(enabled);
+		if (enabled)
+		{
+			m_fused_iteration = false;
+		}
 	}
 
 	template<typename TDataType>
@@ -286,14 +785,85 @@ namespace PhysIKA
 		if (m_lamda.size() != this->inPosition()->getElementCount())
 			m_lamda.resize(this->inPosition()->getElementCount());
 
+		Real dt = this->getParent()->getDt();
+
+		if (m_warm_start)
+		{
+			applyWarmStart(dt);
+		}
+
 		int it = 0;
 
 		int itNum = this->varIterationNumber()->getValue();
+
+		//effective settings under the frame-time governor: degraded runs
+		//drop iterations (never below two), gain early-exit slack and may
+		//skip the cosmetic smoothing term; see FrameGovernor
+		itNum = itNum - m_governor_iter_steps < 2 ? 2 : itNum - m_governor_iter_steps;
+		Real tolerance = m_tolerance + m_governor_tol_steps * Real(5e-4);
+		Real smoothingLambda = m_governor_skip_smoothing ? Real(0) : m_smoothingLambda;
+
+		//Persistent path: the whole loop runs in one cooperative launch. It
+		//covers the fused equal-mass scheme only and performs no host-side
+		//tolerance checks, which is the right trade for the small scenes the
+		//mode targets.
+		//the persistent kernel scatters with atomics internally, so the
+		//deterministic mode falls back to the iterated launches; the
+		//activity mask is only honored by the iterated kernels
+		if (m_persistent && m_fused_iteration && m_massInv.isEmpty()
+			&& !m_red_black && smoothingLambda == Real(0)
+			&& m_activity_mask == nullptr
+			&& !SceneGraph::getInstance().isDeterministic())
+		{
+			if (solvePersistent())
+			{
+				if (m_warm_start)
+				{
+					captureWarmStart(dt);
+				}
+				updateVelocity();
+				return true;
+			}
+		}
+
 		while (it < itNum)
 		{
 			takeOneIteration();
 
 			it++;
+
+			//Calm regions converge long before the fixed iteration count; a
+			//positive tolerance buys the extra reduction per iteration back
+			//many times over by skipping the remaining sweeps.
+			if (tolerance > Real(0) && it < itNum)
+			{
+				if (m_error.size() != num)
+				{
+					m_error.resize(num);
+				}
+				if (m_reduce == nullptr || m_reduce_num != num)
+				{
+					if (m_reduce != nullptr) delete m_reduce;
+					m_reduce = Reduction<Real>::Create(num);
+					m_reduce_num = num;
+				}
+
+				cuExecute(num, K_ComputeDensityError,
+					m_error,
+					this->outDensity()->getValue(),
+					this->varRestDensity()->getValue());
+
+				Real err = m_reduce->average(m_error.getDataPtr(), num);
+				if (err < tolerance)
+				{
+					break;
+				}
+			}
+		}
+
+		if (m_warm_start)
+		{
+			captureWarmStart(dt);
 		}
 
 		updateVelocity();
@@ -302,6 +872,231 @@ namespace PhysIKA
 	}
 
 
+	template<typename TDataType>
+	bool DensityPBD<TDataType>::solvePersistent()
+	{
+		int num = this->inPosition()->getElementCount();
+
+		int device = 0;
+		cudaDeviceProp prop;
+		cudaGetDevice(&device);
+		cudaGetDeviceProperties(&prop, device);
+		if (prop.cooperativeLaunch == 0)
+		{
+			return false;
+		}
+
+		auto densityField = m_summation->outDensity();
+		if (densityField->getElementCount() != num)
+		{
+			densityField->setElementCount(num);
+		}
+
+		//one resident wave at most; the kernel grid-strides over the rest
+		int blocksPerSM = 0;
+		if (cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blocksPerSM, K_SolvePBDPersistent<Real, Coord>, BLOCK_SIZE, 0) != cudaSuccess || blocksPerSM <= 0)
+		{
+			return false;
+		}
+
+		int gridSize = blocksPerSM * prop.multiProcessorCount;
+		int needed = cudaGridSize(num, BLOCK_SIZE);
+		gridSize = gridSize < needed ? gridSize : needed;
+
+		Real dt = this->getParent()->getDt();
+		Real smoothingLength = this->varSmoothingLength()->getValue();
+		Real mass = m_summation->getScaledMass();
+		int itNum = this->varIterationNumber()->getValue();
+
+		DeviceArray<Real>& rho = densityField->getValue();
+		DeviceArray<Coord>& pos = this->inPosition()->getValue();
+		NeighborList<int>& neighbors = this->inNeighborIndex()->getValue();
+
+		FixedSpikyKernel<Real> fixedKern(smoothingLength, m_kernel.m_scale);
+
+		void* args[] = {
+			&m_lamda,
+			&rho,
+			&m_deltaPos,
+			&pos,
+			&neighbors,
+			&fixedKern,
+			&smoothingLength,
+			&mass,
+			&dt,
+			&itNum };
+
+		cuSafeCall(cudaLaunchCooperativeKernel((void*)K_SolvePBDPersistent<Real, Coord>, gridSize, BLOCK_SIZE, args, 0, 0));
+		cuSynchronize();
+
+		return true;
+	}
+
+	template <typename Real>
+	__global__ void K_ScaleLambdas(
+		DeviceArray<Real> lambdaArr,
+		DeviceArray<Real> carriedArr,
+		Real scale)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= lambdaArr.size()) return;
+
+		lambdaArr[pId] = scale * carriedArr[pId];
+	}
+
+	template <typename Real>
+	__global__ void K_RemapLambdas(
+		DeviceArray<Real> dstArr,
+		DeviceArray<Real> srcArr,
+		DeviceArray<int> newToOld)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= dstArr.size()) return;
+
+		int oldId = newToOld[pId];
+		dstArr[pId] = oldId >= 0 && oldId < srcArr.size() ? srcArr[oldId] : Real(0);
+	}
+
+	//Apply the displacement of the previous-step multipliers before the
+	//first iteration. The multipliers scale with dt^2 in the displacement
+	//form, so a substep change keeps the guess consistent.
+	template<typename TDataType>
+	void DensityPBD<TDataType>::applyWarmStart(Real dt)
+	{
+		int num = this->inPosition()->getElementCount();
+
+		if (m_carried_lamda.size() != num || m_carried_dt < EPSILON)
+		{
+			return;
+		}
+
+		Real scale = (dt * dt) / (m_carried_dt * m_carried_dt);
+
+		cuExecute(num, K_ScaleLambdas,
+			m_lamda,
+			m_carried_lamda,
+			scale);
+
+		m_deltaPos.reset();
+
+		bool deterministic = SceneGraph::getInstance().isDeterministic();
+
+		FixedSpikyKernel<Real> fixedKern(this->varSmoothingLength()->getValue(), m_kernel.m_scale);
+
+		int* activityPtr = m_activity_mask == nullptr ? nullptr : m_activity_mask->getDataPtr();
+
+		if (m_massInv.isEmpty())
+		{
+			//repack positions into the aligned mirror for the gather kernels
+			if (m_posq.size() != num)
+			{
+				m_posq.resize(num);
+			}
+			FunctionPack::pack(m_posq, this->inPosition()->getValue());
+
+			if (deterministic)
+			{
+				cuExecute(num, K_ComputeDisplacementGather,
+					m_deltaPos,
+					m_lamda,
+					m_posq,
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt,
+					activityPtr);
+			}
+			else
+			{
+				cuExecute(num, K_ComputeDisplacement,
+					m_deltaPos,
+					m_lamda,
+					m_posq,
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt,
+					activityPtr);
+			}
+		}
+		else
+		{
+			if (deterministic)
+			{
+				cuExecute(num, K_ComputeDisplacementGather,
+					m_deltaPos,
+					m_lamda,
+					this->inPosition()->getValue(),
+					m_massInv.getValue(),
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt);
+			}
+			else
+			{
+				cuExecute(num, K_ComputeDisplacement,
+					m_deltaPos,
+					m_lamda,
+					this->inPosition()->getValue(),
+					m_massInv.getValue(),
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt);
+			}
+		}
+
+		cuExecute(num, K_UpdatePosition,
+			this->inPosition()->getValue(),
+			this->inVelocity()->getValue(),
+			m_deltaPos,
+			dt,
+			activityPtr);
+	}
+
+	template<typename TDataType>
+	void DensityPBD<TDataType>::captureWarmStart(Real dt)
+	{
+		int num = m_lamda.size();
+
+		if (m_carried_lamda.size() != num)
+		{
+			m_carried_lamda.resize(num);
+		}
+
+		Function1Pt::copy(m_carried_lamda, m_lamda);
+		m_carried_dt = dt;
+	}
+
+	template<typename TDataType>
+	void DensityPBD<TDataType>::remapWarmStart(DeviceArray<int>& newToOld)
+	{
+		if (m_carried_lamda.size() == 0)
+		{
+			return;
+		}
+
+		int num = newToOld.size();
+
+		if (m_remap_buf.size() != num)
+		{
+			m_remap_buf.resize(num);
+		}
+
+		cuExecute(num, K_RemapLambdas,
+			m_remap_buf,
+			m_carried_lamda,
+			newToOld);
+
+		if (m_carried_lamda.size() != num)
+		{
+			m_carried_lamda.resize(num);
+		}
+
+		Function1Pt::copy(m_carried_lamda, m_remap_buf);
+	}
+
 	template<typename TDataType>
 	void DensityPBD<TDataType>::takeOneIteration()
 	{
@@ -310,58 +1105,235 @@ namespace PhysIKA
 		int num = this->inPosition()->getElementCount();
 		uint pDims = cudaGridSize(num, BLOCK_SIZE);
 
-		
+
 
 		m_deltaPos.reset();
 
-		m_summation->update();
+		//deterministic mode swaps the atomic scatter kernels for their
+		//fixed-order gather twins; see SceneGraph::setDeterministic
+		bool deterministic = SceneGraph::getInstance().isDeterministic();
 
-		if (m_massInv.isEmpty())
+		//the frame-time governor may skip the cosmetic smoothing term
+		Real smoothingLambda = m_governor_skip_smoothing ? Real(0) : m_smoothingLambda;
+
+		//h is fixed across the launches below, so fold it into the kernel
+		//coefficients once on the host
+		FixedSpikyKernel<Real> fixedKern(this->varSmoothingLength()->getValue(), m_kernel.m_scale);
+
+		//sleeping particles early-out of the solve; nullptr means everyone
+		//is awake (see ParticleSleeping)
+		int* activityPtr = m_activity_mask == nullptr ? nullptr : m_activity_mask->getDataPtr();
+
+		if (m_fused_iteration && m_massInv.isEmpty())
 		{
-			cuExecute(num, K_ComputeLambdas,
+			//Fused path: density and lambda in a single neighbor sweep. The
+			//unified-particle variant still needs per-particle inverse masses
+			//and keeps the two-pass scheme below.
+			auto densityField = m_summation->outDensity();
+			if (densityField->getElementCount() != num)
+			{
+				densityField->setElementCount(num);
+			}
+
+			//repack positions into the aligned mirror for the gather kernels
+			if (m_posq.size() != num)
+			{
+				m_posq.resize(num);
+			}
+			FunctionPack::pack(m_posq, this->inPosition()->getValue());
+
+			cuExecute(num, K_ComputeDensityAndLambdas,
 				m_lamda,
-				m_summation->outDensity()->getValue(),
-				this->inPosition()->getValue(),
+				densityField->getValue(),
+				m_posq,
 				this->inNeighborIndex()->getValue(),
-				m_kernel,
-				this->varSmoothingLength()->getValue());
+				fixedKern,
+				this->varSmoothingLength()->getValue(),
+				m_summation->getScaledMass(),
+				activityPtr);
+
+			if (smoothingLambda > Real(0))
+			{
+				if (deterministic)
+				{
+					cuExecute(num, K_ComputeDisplacementSmoothedGather,
+						m_deltaPos,
+						m_lamda,
+						densityField->getValue(),
+						this->inPosition()->getValue(),
+						this->inNeighborIndex()->getValue(),
+						fixedKern,
+						this->varSmoothingLength()->getValue(),
+						this->varRestDensity()->getValue(),
+						smoothingLambda,
+						dt);
+				}
+				else
+				{
+					cuExecute(num, K_ComputeDisplacementSmoothed,
+						m_deltaPos,
+						m_lamda,
+						densityField->getValue(),
+						this->inPosition()->getValue(),
+						this->inNeighborIndex()->getValue(),
+						fixedKern,
+						this->varSmoothingLength()->getValue(),
+						this->varRestDensity()->getValue(),
+						smoothingLambda,
+						dt);
+				}
+
+				cuExecute(num, K_UpdatePosition,
+					this->inPosition()->getValue(),
+					this->inVelocity()->getValue(),
+					m_deltaPos,
+					dt,
+					activityPtr);
+
+				return;
+			}
+
+			if (m_red_black)
+			{
+				//Even-indexed particles move first; the odd half then reacts to
+				//their fresh positions, which does Gauss-Seidel-style work within
+				//a single iteration. The positions are applied per color from a
+				//gathered buffer, so neither phase races on its reads.
+				for (int parity = 0; parity < 2; parity++)
+				{
+					cuExecute(num, K_ComputeDisplacementRB,
+						m_deltaPos,
+						m_lamda,
+						this->inPosition()->getValue(),
+						this->inNeighborIndex()->getValue(),
+						fixedKern,
+						this->varSmoothingLength()->getValue(),
+						parity);
+
+					cuExecute(num, K_UpdatePositionRB,
+						this->inPosition()->getValue(),
+						m_deltaPos,
+						parity);
+				}
+
+				return;
+			}
+
+			if (deterministic)
+			{
+				cuExecute(num, K_ComputeDisplacementGather,
+					m_deltaPos,
+					m_lamda,
+					m_posq,
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt,
+					activityPtr);
+			}
+			else
+			{
+				cuExecute(num, K_ComputeDisplacement,
+					m_deltaPos,
+					m_lamda,
+					m_posq,
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt,
+					activityPtr);
+			}
+		}
+		else if (m_massInv.isEmpty())
+		{
+			m_summation->update();
+
+			//repack positions into the aligned mirror for the gather kernels
+			if (m_posq.size() != num)
+			{
+				m_posq.resize(num);
+			}
+			FunctionPack::pack(m_posq, this->inPosition()->getValue());
 
-			cuExecute(num, K_ComputeDisplacement,
-				m_deltaPos,
+			cuExecute(num, K_ComputeLambdas,
 				m_lamda,
-				this->inPosition()->getValue(),
+				m_summation->outDensity()->getValue(),
+				m_posq,
 				this->inNeighborIndex()->getValue(),
-				m_kernel,
+				fixedKern,
 				this->varSmoothingLength()->getValue(),
-				dt);
+				activityPtr);
+
+			if (deterministic)
+			{
+				cuExecute(num, K_ComputeDisplacementGather,
+					m_deltaPos,
+					m_lamda,
+					m_posq,
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt,
+					activityPtr);
+			}
+			else
+			{
+				cuExecute(num, K_ComputeDisplacement,
+					m_deltaPos,
+					m_lamda,
+					m_posq,
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt,
+					activityPtr);
+			}
 		}
 		else
 		{
+			m_summation->update();
+
 			cuExecute(num, K_ComputeLambdas,
 				m_lamda,
 				m_summation->outDensity()->getValue(),
 				this->inPosition()->getValue(),
 				m_massInv.getValue(),
 				this->inNeighborIndex()->getValue(),
-				m_kernel,
+				fixedKern,
 				this->varSmoothingLength()->getValue());
 
-			cuExecute(num, K_ComputeDisplacement,
-				m_deltaPos,
-				m_lamda,
-				this->inPosition()->getValue(),
-				m_massInv.getValue(),
-				this->inNeighborIndex()->getValue(),
-				m_kernel,
-				this->varSmoothingLength()->getValue(),
-				dt);
+			if (deterministic)
+			{
+				cuExecute(num, K_ComputeDisplacementGather,
+					m_deltaPos,
+					m_lamda,
+					this->inPosition()->getValue(),
+					m_massInv.getValue(),
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt);
+			}
+			else
+			{
+				cuExecute(num, K_ComputeDisplacement,
+					m_deltaPos,
+					m_lamda,
+					this->inPosition()->getValue(),
+					m_massInv.getValue(),
+					this->inNeighborIndex()->getValue(),
+					fixedKern,
+					this->varSmoothingLength()->getValue(),
+					dt);
+			}
 		}
 
 		cuExecute(num, K_UpdatePosition,
 			this->inPosition()->getValue(),
 			this->inVelocity()->getValue(),
 			m_deltaPos,
-			dt);
+			dt,
+			activityPtr);
 	}
 
 	template <typename Real, typename Coord>
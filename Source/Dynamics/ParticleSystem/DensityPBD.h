@@ -5,6 +5,8 @@
 #include "Framework/Framework/FieldArray.h"
 #include "Framework/Topology/FieldNeighbor.h"
 #include "Kernel.h"
+#include "Core/Utility/Reduction.h"
+#include "Core/Utility/Coord4.h"
 
 namespace PhysIKA {
 
@@ -21,6 +23,7 @@ namespace PhysIKA {
 	public:
 		typedef typename TDataType::Real Real;
 		typedef typename TDataType::Coord Coord;
+		typedef typename Coord4Type<Real>::type Coord4;
 
 		DensityPBD();
 		~DensityPBD() override;
@@ -31,6 +34,79 @@ namespace PhysIKA {
 
 		void updateVelocity();
 
+		/**
+		 * @brief Toggle the fused density+lambda sweep (default on). The
+		 * separate SummationDensity pass is kept for debugging comparisons.
+		 */
+		void setFusedIteration(bool fused) { m_fused_iteration = fused; }
+
+		/**
+		 * @brief Forward the half-precision neighbor gather to the density
+		 * pass. Implies the separate two-pass scheme, since the fused kernel
+		 * reads full-precision positions for its constraint gradients.
+		 */
+		void setHalfPrecisionCache(bool enabled);
+
+		/**
+		 * @brief Relative density-error tolerance for an early exit of the
+		 * iteration loop; 0 (the default) keeps the fixed iteration count.
+		 */
+		void setConvergenceTolerance(Real tol) { m_tolerance = tol; }
+
+		/**
+		 * @brief Two-color position updates: even-indexed particles move first
+		 * and odd-indexed ones react to their fresh positions within the same
+		 * iteration. Converges in fewer sweeps on a spatially sorted layout.
+		 */
+		void setRedBlackOrdering(bool enabled) { m_red_black = enabled; }
+
+		/**
+		 * @brief Evaluate a Helmholtz-style free-surface smoothing term inside
+		 * the fused projection sweep instead of running the Helmholtz module
+		 * as a separate constraint over the same neighbor list. lambda is the
+		 * bulk-energy coefficient the standalone module exposes; zero disables
+		 * the term.
+		 */
+		void setSurfaceSmoothing(Real lambda) { m_smoothingLambda = lambda; }
+
+		/**
+		 * @brief Run the whole iteration loop inside one persistent-threads
+		 * kernel that separates the phases with grid-wide syncs, so small
+		 * scenes stop paying per-phase launch overhead. Requires cooperative
+		 * launch support and the fused equal-mass path; falls back to the
+		 * per-phase launches otherwise.
+		 */
+		void setPersistentSolver(bool enabled) { m_persistent = enabled; }
+
+		/**
+		 * @brief Optional per-particle activity mask (see ParticleSleeping):
+		 * particles flagged 0 early-out of the iteration kernels on the
+		 * default equal-mass paths. The caller keeps the array alive and
+		 * guarantees that every neighbor of an awake particle is awake,
+		 * e.g. by classifying whole hash cells with one dilation ring.
+		 * nullptr disables masking; the red-black and persistent paths
+		 * ignore it.
+		 */
+		void setActivityMask(DeviceArray<int>* mask) { m_activity_mask = mask; }
+
+		/**
+		 * @brief Carry the Lagrange multipliers of the previous step forward
+		 * as an initial guess. Pressure is temporally smooth, so applying the
+		 * displacement of the scaled previous-step multipliers before the
+		 * first iteration reaches the same density error in roughly half the
+		 * sweeps. The carried state is dropped automatically when the
+		 * particle count changes; after a reordering or compaction pass call
+		 * remapWarmStart() to keep it valid instead.
+		 */
+		void setWarmStart(bool enabled) { m_warm_start = enabled; }
+
+		/**
+		 * @brief Permute the carried multipliers after particle reordering;
+		 * newToOld[i] holds the previous index of particle i. Entries outside
+		 * the old range (freshly emitted particles) start from zero.
+		 */
+		void remapWarmStart(DeviceArray<int>& newToOld);
+
 	public:
 		DeviceArrayField<Real> m_massInv; // mass^-1 as described in unified particle physics
 
@@ -77,12 +153,45 @@ namespace PhysIKA {
 		DEF_EMPTY_OUT_ARRAY(Density, Real, DeviceType::GPU, "Final particle density");
 
 	private:
+		bool solvePersistent();
+
+		void applyWarmStart(Real dt);
+		void captureWarmStart(Real dt);
+
 		SpikyKernel<Real> m_kernel;
 
+		bool m_fused_iteration = true;
+		bool m_red_black = false;
+		bool m_persistent = false;
+		DeviceArray<int>* m_activity_mask = nullptr;
+		Real m_tolerance = Real(0);
+		Real m_smoothingLambda = Real(0);
+
+		//degradation steps applied by the frame-time governor; the user
+		//settings above stay untouched and the effective values are derived
+		//per frame, see FrameGovernor
+		int m_governor_iter_steps = 0;
+		int m_governor_tol_steps = 0;
+		bool m_governor_skip_smoothing = false;
+
+		DeviceArray<Real> m_error;
+		Reduction<Real>* m_reduce = nullptr;
+		int m_reduce_num = 0;
+
 		DeviceArray<Real> m_lamda;
 		DeviceArray<Coord> m_deltaPos;
 		DeviceArray<Coord> m_position_old;
 
+		//16-byte aligned mirror of the positions, repacked once per solver
+		//iteration so the neighbor gathers issue single vector loads
+		DeviceArray<Coord4> m_posq;
+
+		//multipliers of the previous step and the dt they were solved with
+		bool m_warm_start = false;
+		Real m_carried_dt = Real(0);
+		DeviceArray<Real> m_carried_lamda;
+		DeviceArray<Real> m_remap_buf;
+
 	private:
 		std::shared_ptr<SummationDensity<TDataType>> m_summation;
 	};
@@ -37,8 +37,9 @@ namespace PhysIKA
 		*/
 	}
 
-	template<typename Real, typename Coord>
+	template<typename Real, typename Coord, typename TKernel>
 	__global__ void K_ComputeDensityMesh(
+		TKernel kern,
 		DeviceArray<Real> rhoArr,
 		DeviceArray<Coord> posArr,
 		DeviceArray<TopologyModule::Triangle> Tri,
@@ -57,7 +58,6 @@ namespace PhysIKA
 		if (pId >= posArr.size()) return;
 		//if (pId >= Start)  return;
 
-		SpikyKernel<Real> kern;
 		Real r;
 		Real rho_i = Real(0);
 		Real rho_tmp;
@@ -239,7 +239,33 @@ namespace PhysIKA
 		int Start)
 	{
 		cuint pDims = cudaGridSize(rho.size(), BLOCK_SIZE);
-		K_ComputeDensityMesh <Real, Coord> << <pDims, BLOCK_SIZE >> > (
+		if (m_use_table)
+		{
+			if (!m_table_ready)
+			{
+				setupKernelTable<SpikyKernel<Real>>();
+				m_table_ready = true;
+			}
+			K_ComputeDensityMesh << <pDims, BLOCK_SIZE >> > (
+				TabulatedKernel<Real>(),
+				rho,
+				pos,
+				Tri,
+				positionTri,
+				neighbors,
+				neighborsTri,
+				smoothingLength,
+				m_factor*mass,
+				sampling_distance,
+				use_mesh,
+				use_ghost,
+				Start
+				);
+			return;
+		}
+
+		K_ComputeDensityMesh << <pDims, BLOCK_SIZE >> > (
+			SpikyKernel<Real>(),
 			rho, 
 			pos,
 			Tri, 
@@ -42,6 +42,12 @@ namespace PhysIKA {
 			int Start);
 
 		void setCorrection(Real factor) { m_factor = factor; }
+
+		/**
+		 * @brief Sample the smoothing kernel from the constant-memory lookup
+		 * table instead of evaluating the polynomial per neighbor pair.
+		 */
+		void setKernelTable(bool enabled) { m_use_table = enabled; }
 		void setSmoothingLength(Real length) { m_smoothingLength.setValue(length); }
 	
 	protected:
@@ -67,6 +73,8 @@ namespace PhysIKA {
 
 	private:
 		Real m_factor;
+		bool m_use_table = false;
+		bool m_table_ready = false;
 	};
 
 #ifdef PRECISION_FLOAT
@@ -0,0 +1,351 @@
+#include <cuda_runtime.h>
+#include "DivergenceFreeFluidModel.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Topology/NeighborQuery.h"
+#include "ParticleIntegrator.h"
+#include "SummationDensity.h"
+#include "ImplicitViscosity.h"
+#include "Kernel.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(DivergenceFreeFluidModel, TDataType)
+
+	template<typename Real, typename Coord>
+	__global__ void DF_ComputeAlpha(
+		DeviceArray<Real> alphaArr,
+		DeviceArray<Real> rhoArr,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		Real smoothingLength,
+		Real mass)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		SpikyKernel<Real> kern;
+
+		Coord pos_i = posArr[pId];
+		Coord grad_sum(0);
+		Real grad_sq = Real(0);
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Real r = (pos_i - posArr[j]).norm();
+
+			if (r > EPSILON)
+			{
+				Coord g = mass*kern.Gradient(r, smoothingLength)*(pos_i - posArr[j]) * (1.0f / r);
+				grad_sum += g;
+				grad_sq += g.dot(g);
+			}
+		}
+
+		Real denom = grad_sum.dot(grad_sum) + grad_sq;
+		alphaArr[pId] = denom > EPSILON ? rhoArr[pId] / denom : Real(0);
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void DF_ComputeDivergence(
+		DeviceArray<Real> divArr,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		NeighborList<int> neighbors,
+		Real smoothingLength,
+		Real mass)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		SpikyKernel<Real> kern;
+
+		Coord pos_i = posArr[pId];
+		Coord vel_i = velArr[pId];
+		Real div_i = Real(0);
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Real r = (pos_i - posArr[j]).norm();
+
+			if (r > EPSILON)
+			{
+				Coord g = kern.Gradient(r, smoothingLength)*(pos_i - posArr[j]) * (1.0f / r);
+				div_i += mass*(vel_i - velArr[j]).dot(g);
+			}
+		}
+
+		//only compression is corrected, expansion at the free surface stays untouched
+		divArr[pId] = div_i > Real(0) ? div_i : Real(0);
+	}
+
+	//constant-density stiffness: kappa_i / rho_i for the predicted density deviation
+	template<typename Real>
+	__global__ void DF_ComputeKappaDensity(
+		DeviceArray<Real> kappaArr,
+		DeviceArray<Real> errArr,
+		DeviceArray<Real> divArr,
+		DeviceArray<Real> alphaArr,
+		DeviceArray<Real> rhoArr,
+		Real restRho,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= kappaArr.size()) return;
+
+		Real rhoStar = rhoArr[pId] + dt*divArr[pId];
+		Real dev = rhoStar - restRho;
+		dev = dev > Real(0) ? dev : Real(0);
+
+		kappaArr[pId] = dev*alphaArr[pId] / (dt*dt*rhoArr[pId]);
+		errArr[pId] = dev / restRho;
+	}
+
+	//divergence-free stiffness: kappa_i / rho_i for the velocity divergence
+	template<typename Real>
+	__global__ void DF_ComputeKappaDivergence(
+		DeviceArray<Real> kappaArr,
+		DeviceArray<Real> divArr,
+		DeviceArray<Real> alphaArr,
+		DeviceArray<Real> rhoArr,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= kappaArr.size()) return;
+
+		kappaArr[pId] = divArr[pId] * alphaArr[pId] / (dt*rhoArr[pId]);
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void DF_UpdateVelocity(
+		DeviceArray<Coord> velArr,
+		DeviceArray<Real> kappaArr,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		Real smoothingLength,
+		Real mass,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		SpikyKernel<Real> kern;
+
+		Coord pos_i = posArr[pId];
+		Real kappa_i = kappaArr[pId];
+		Coord dv_i(0);
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Real r = (pos_i - posArr[j]).norm();
+
+			if (r > EPSILON)
+			{
+				Coord g = kern.Gradient(r, smoothingLength)*(pos_i - posArr[j]) * (1.0f / r);
+				dv_i += mass*(kappa_i + kappaArr[j])*g;
+			}
+		}
+
+		velArr[pId] -= dt*dv_i;
+	}
+
+	template<typename TDataType>
+	DivergenceFreeFluidModel<TDataType>::DivergenceFreeFluidModel()
+		: NumericalModel()
+		, m_restRho(Real(1000))
+		, m_maxItDensity(8)
+		, m_maxItDivergence(4)
+		, m_densityError(Real(0.01))
+		, m_reduce(NULL)
+	{
+		m_smoothingLength.setValue(Real(0.006));
+
+		attachField(&m_smoothingLength, "smoothingLength", "Smoothing length", false);
+
+		attachField(&m_position, "position", "Storing the particle positions!", false);
+		attachField(&m_velocity, "velocity", "Storing the particle velocities!", false);
+		attachField(&m_forceDensity, "force_density", "Storing the particle force densities!", false);
+	}
+
+	template<typename TDataType>
+	DivergenceFreeFluidModel<TDataType>::~DivergenceFreeFluidModel()
+	{
+		m_alpha.release();
+		m_kappa.release();
+		m_divergence.release();
+		m_error.release();
+
+		if (m_reduce)
+		{
+			delete m_reduce;
+		}
+	}
+
+	template<typename TDataType>
+	bool DivergenceFreeFluidModel<TDataType>::initializeImpl()
+	{
+		cuSynchronize();
+
+		m_nbrQuery = this->getParent()->addComputeModule<NeighborQuery<TDataType>>("neighborhood");
+		m_smoothingLength.connect(m_nbrQuery->inRadius());
+		m_position.connect(m_nbrQuery->inPosition());
+		m_nbrQuery->initialize();
+
+		cuSynchronize();
+
+		m_summation = this->getParent()->addComputeModule<SummationDensity<TDataType>>("summation");
+		m_smoothingLength.connect(m_summation->varSmoothingLength());
+		m_position.connect(m_summation->inPosition());
+		m_nbrQuery->outNeighborhood()->connect(m_summation->inNeighborIndex());
+		m_summation->initialize();
+
+		cuSynchronize();
+
+		m_integrator = this->getParent()->setNumericalIntegrator<ParticleIntegrator<TDataType>>("integrator");
+		m_position.connect(m_integrator->inPosition());
+		m_velocity.connect(m_integrator->inVelocity());
+		m_forceDensity.connect(m_integrator->inForceDensity());
+		m_integrator->initialize();
+
+		cuSynchronize();
+
+		m_visModule = this->getParent()->addConstraintModule<ImplicitViscosity<TDataType>>("viscosity");
+		m_visModule->setViscosity(Real(1));
+		m_smoothingLength.connect(&m_visModule->m_smoothingLength);
+		m_position.connect(&m_visModule->m_position);
+		m_velocity.connect(&m_visModule->m_velocity);
+		m_nbrQuery->outNeighborhood()->connect(&m_visModule->m_neighborhood);
+		m_visModule->initialize();
+
+		cuSynchronize();
+
+		int num = m_position.getElementCount();
+		m_alpha.resize(num);
+		m_kappa.resize(num);
+		m_divergence.resize(num);
+		m_error.resize(num);
+
+		m_reduce = Reduction<Real>::Create(num);
+
+		return true;
+	}
+
+	template<typename TDataType>
+	void DivergenceFreeFluidModel<TDataType>::step(Real dt)
+	{
+		Node* parent = getParent();
+		if (parent == NULL)
+		{
+			Log::sendMessage(Log::Error, "Parent not set for DivergenceFreeFluidModel!");
+			return;
+		}
+
+		int num = m_position.getElementCount();
+		if (m_alpha.size() != num)
+		{
+			m_alpha.resize(num);
+			m_kappa.resize(num);
+			m_divergence.resize(num);
+			m_error.resize(num);
+		}
+
+		Real mass = m_summation->getScaledMass();
+		Real h = m_smoothingLength.getValue();
+
+		m_integrator->begin();
+
+		m_nbrQuery->compute();
+		m_integrator->updateVelocity();
+
+		//density and alpha depend on positions only, so they stay valid
+		//through both velocity solves
+		m_summation->compute();
+		cuExecute(num, DF_ComputeAlpha,
+			m_alpha,
+			m_summation->outDensity()->getValue(),
+			m_position.getValue(),
+			m_nbrQuery->outNeighborhood()->getValue(),
+			h,
+			mass);
+
+		//constant-density solve: remove the density deviation predicted for
+		//the end of the step
+		int itor = 0;
+		while (itor < m_maxItDensity)
+		{
+			cuExecute(num, DF_ComputeDivergence,
+				m_divergence,
+				m_position.getValue(),
+				m_velocity.getValue(),
+				m_nbrQuery->outNeighborhood()->getValue(),
+				h,
+				mass);
+
+			cuExecute(num, DF_ComputeKappaDensity,
+				m_kappa,
+				m_error,
+				m_divergence,
+				m_alpha,
+				m_summation->outDensity()->getValue(),
+				m_restRho,
+				dt);
+
+			if (m_reduce->average(m_error.getDataPtr(), num) < m_densityError)
+				break;
+
+			cuExecute(num, DF_UpdateVelocity,
+				m_velocity.getValue(),
+				m_kappa,
+				m_position.getValue(),
+				m_nbrQuery->outNeighborhood()->getValue(),
+				h,
+				mass,
+				dt);
+
+			itor++;
+		}
+
+		//divergence-free solve: remove the remaining velocity divergence
+		itor = 0;
+		while (itor < m_maxItDivergence)
+		{
+			cuExecute(num, DF_ComputeDivergence,
+				m_divergence,
+				m_position.getValue(),
+				m_velocity.getValue(),
+				m_nbrQuery->outNeighborhood()->getValue(),
+				h,
+				mass);
+
+			cuExecute(num, DF_ComputeKappaDivergence,
+				m_kappa,
+				m_divergence,
+				m_alpha,
+				m_summation->outDensity()->getValue(),
+				dt);
+
+			cuExecute(num, DF_UpdateVelocity,
+				m_velocity.getValue(),
+				m_kappa,
+				m_position.getValue(),
+				m_nbrQuery->outNeighborhood()->getValue(),
+				h,
+				mass,
+				dt);
+
+			itor++;
+		}
+
+		m_visModule->constrain();
+
+		m_integrator->updatePosition();
+
+		m_integrator->end();
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Framework/Framework/NumericalModel.h"
+#include "Framework/Framework/FieldVar.h"
+#include "Framework/Framework/FieldArray.h"
+#include "Core/Utility/Reduction.h"
+
+namespace PhysIKA
+{
+	template<typename TDataType> class ParticleIntegrator;
+	template<typename TDataType> class NeighborQuery;
+	template<typename TDataType> class SummationDensity;
+	template<typename TDataType> class ImplicitViscosity;
+	/*!
+	*	\class	DivergenceFreeFluidModel
+	*	\brief	Divergence-free smoothed particle hydrodynamics.
+	*
+	*	This class implements a DFSPH solver operating on velocities: a
+	*	constant-density solve removes the density deviation predicted for the
+	*	end of the step and a divergence-free solve removes the velocity
+	*	divergence itself. Both reuse the stiffness factor alpha computed once
+	*	per step, so the per-iteration cost is two neighbor sweeps without any
+	*	position update in between.
+	*	Refer to Bender and Koschier's "Divergence-Free Smoothed Particle
+	*	Hydrodynamics" for details.
+	*/
+	template<typename TDataType>
+	class DivergenceFreeFluidModel : public NumericalModel
+	{
+		DECLARE_CLASS_1(DivergenceFreeFluidModel, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		DivergenceFreeFluidModel();
+		virtual ~DivergenceFreeFluidModel();
+
+		void step(Real dt) override;
+
+		void setSmoothingLength(Real len) { m_smoothingLength.setValue(len); }
+		void setRestDensity(Real rho) { m_restRho = rho; }
+
+		void setDensityIterationNumber(int n) { m_maxItDensity = n; }
+		void setDivergenceIterationNumber(int n) { m_maxItDivergence = n; }
+
+	public:
+		VarField<Real> m_smoothingLength;
+
+		DeviceArrayField<Coord> m_position;
+		DeviceArrayField<Coord> m_velocity;
+		DeviceArrayField<Coord> m_forceDensity;
+
+	protected:
+		bool initializeImpl() override;
+
+	private:
+		Real m_restRho;
+
+		int m_maxItDensity;
+		int m_maxItDivergence;
+		Real m_densityError;
+
+		DeviceArray<Real> m_alpha;
+		DeviceArray<Real> m_kappa;
+		DeviceArray<Real> m_divergence;
+		DeviceArray<Real> m_error;
+
+		Reduction<Real>* m_reduce;
+
+		std::shared_ptr<SummationDensity<TDataType>> m_summation;
+		std::shared_ptr<ImplicitViscosity<TDataType>> m_visModule;
+		std::shared_ptr<ParticleIntegrator<TDataType>> m_integrator;
+		std::shared_ptr<NeighborQuery<TDataType>> m_nbrQuery;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class DivergenceFreeFluidModel<DataType3f>;
+#else
+	template class DivergenceFreeFluidModel<DataType3d>;
+#endif
+}
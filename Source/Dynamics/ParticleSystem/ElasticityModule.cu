@@ -1,5 +1,6 @@
 #include <cuda_runtime.h>
 #include "ElasticityModule.h"
+#include "RestShapeCache.h"
 #include "Framework/Framework/Node.h"
 #include "Core/Algorithm/MatrixFunc.h"
 #include "Core/Utility.h"
@@ -337,6 +338,175 @@ namespace PhysIKA
 		m_invK.release();
 		m_F.release();
 		m_position_old.release();
+		m_colors.release();
+
+		if (m_contention != NULL)
+		{
+			cudaFree(m_contention);
+		}
+	}
+
+	/*!
+	*	\brief	EM_EnforceElasticity with the neighbor scatter aggregated per
+	*	warp: lanes targeting the same particle j reduce their contributions
+	*	over shuffles and the leader lane issues one global atomic. The
+	*	contention counter accumulates how many atomics were merged away.
+	*/
+	template <typename Real, typename Coord, typename Matrix, typename NPair>
+	__global__ void EM_EnforceElasticityWarpAgg(
+		DeviceArray<Coord> delta_position,
+		DeviceArray<Real> weights,
+		DeviceArray<Real> bulkCoefs,
+		DeviceArray<Matrix> invK,
+		DeviceArray<Coord> position,
+		NeighborList<NPair> restShapes,
+		Real horizon,
+		Real mu,
+		Real lambda,
+		unsigned long long* contention)
+	{
+
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= position.size()) return;
+
+		CorrectedKernel<Real> g_weightKernel;
+
+		NPair np_i = restShapes.getElement(pId, 0);
+		Coord rest_i = np_i.pos;
+		int size_i = restShapes.getNeighborSize(pId);
+
+		Coord cur_pos_i = position[pId];
+
+		Coord accPos = Coord(0);
+		Real accA = Real(0);
+		Real bulk_i = bulkCoefs[pId];
+
+		Real total_weight = 0.0f;
+		Matrix deform_i = Matrix(0.0f);
+		for (int ne = 0; ne < size_i; ne++)
+		{
+			NPair np_j = restShapes.getElement(pId, ne);
+			Coord rest_j = np_j.pos;
+			int j = np_j.index;
+
+			Real r = (rest_j - rest_i).norm();
+
+			if (r > EPSILON)
+			{
+				Real weight = g_weightKernel.Weight(r, horizon);
+
+				Coord p = (position[j] - position[pId]) / horizon;
+				Coord q = (rest_j - rest_i) / horizon*weight;
+
+				deform_i(0, 0) += p[0] * q[0]; deform_i(0, 1) += p[0] * q[1]; deform_i(0, 2) += p[0] * q[2];
+				deform_i(1, 0) += p[1] * q[0]; deform_i(1, 1) += p[1] * q[1]; deform_i(1, 2) += p[1] * q[2];
+				deform_i(2, 0) += p[2] * q[0]; deform_i(2, 1) += p[2] * q[1]; deform_i(2, 2) += p[2] * q[2];
+				total_weight += weight;
+			}
+		}
+
+		if (total_weight > EPSILON)
+		{
+			deform_i *= (1.0f / total_weight);
+			deform_i = deform_i * invK[pId];
+		}
+		else
+		{
+			total_weight = 1.0f;
+		}
+
+		if ((deform_i.determinant()) < -0.001f)
+		{
+			deform_i = Matrix::identityMatrix();
+		}
+
+		for (int ne = 0; ne < size_i; ne++)
+		{
+			NPair np_j = restShapes.getElement(pId, ne);
+			Coord rest_j = np_j.pos;
+			int j = np_j.index;
+
+			Coord cur_pos_j = position[j];
+			Real r = (rest_j - rest_i).norm();
+
+			if (r > 0.01f*horizon)
+			{
+				Real weight = g_weightKernel.WeightRR(r, horizon);
+
+				Coord rest_dir_ij = deform_i*(rest_i - rest_j);
+				Coord cur_dir_ij = cur_pos_i - cur_pos_j;
+
+				cur_dir_ij = cur_dir_ij.norm() > EPSILON ? cur_dir_ij.normalize() : Coord(0);
+				rest_dir_ij = rest_dir_ij.norm() > EPSILON ? rest_dir_ij.normalize() : Coord(0, 0, 0);
+
+				Real mu_ij = mu*bulk_i* g_weightKernel.WeightRR(r, horizon);
+				Coord mu_pos_ij = position[j] + r*rest_dir_ij;
+				Coord mu_pos_ji = position[pId] - r*rest_dir_ij;
+
+				Real lambda_ij = lambda*bulk_i*g_weightKernel.WeightRR(r, horizon);
+				Coord lambda_pos_ij = position[j] + r*cur_dir_ij;
+				Coord lambda_pos_ji = position[pId] - r*cur_dir_ij;
+
+				Coord delta_pos_ij = mu_ij*mu_pos_ij + lambda_ij*lambda_pos_ij;
+				Real delta_weight_ij = mu_ij + lambda_ij;
+
+				Coord delta_pos_ji = mu_ij*mu_pos_ji + lambda_ij*lambda_pos_ji;
+
+				accA += delta_weight_ij;
+				accPos += delta_pos_ij;
+
+#if __CUDA_ARCH__ >= 700
+				unsigned int active = __activemask();
+				unsigned int peers = __match_any_sync(active, j);
+				int lane = threadIdx.x & 31;
+				int leader = __ffs(peers) - 1;
+
+				Real w_sum = Real(0);
+				Coord p_sum = Coord(0);
+
+				//every peer lane walks the same group, so all of them
+				//participate in each shuffle while only the leader accumulates
+				unsigned int bits = peers;
+				while (bits)
+				{
+					int src = __ffs(bits) - 1;
+					Real w = __shfl_sync(peers, delta_weight_ij, src);
+					Real px = __shfl_sync(peers, delta_pos_ji[0], src);
+					Real py = __shfl_sync(peers, delta_pos_ji[1], src);
+					Real pz = __shfl_sync(peers, delta_pos_ji[2], src);
+					if (lane == leader)
+					{
+						w_sum += w;
+						p_sum += Coord(px, py, pz);
+					}
+					bits &= bits - 1;
+				}
+
+				if (lane == leader)
+				{
+					atomicAdd(&weights[j], w_sum);
+					atomicAdd(&delta_position[j][0], p_sum[0]);
+					atomicAdd(&delta_position[j][1], p_sum[1]);
+					atomicAdd(&delta_position[j][2], p_sum[2]);
+
+					if (__popc(peers) > 1)
+					{
+						atomicAdd(contention, (unsigned long long)(__popc(peers) - 1));
+					}
+				}
+#else
+				atomicAdd(&weights[j], delta_weight_ij);
+				atomicAdd(&delta_position[j][0], delta_pos_ji[0]);
+				atomicAdd(&delta_position[j][1], delta_pos_ji[1]);
+				atomicAdd(&delta_position[j][2], delta_pos_ji[2]);
+#endif
+			}
+		}
+
+		atomicAdd(&weights[pId], accA);
+		atomicAdd(&delta_position[pId][0], accPos[0]);
+		atomicAdd(&delta_position[pId][1], accPos[1]);
+		atomicAdd(&delta_position[pId][2], accPos[2]);
 	}
 
 	template<typename TDataType>
@@ -348,17 +518,41 @@ namespace PhysIKA
 		m_displacement.reset();
 		m_weights.reset();
 
-		EM_EnforceElasticity << <pDims, BLOCK_SIZE >> > (
-			m_displacement,
-			m_weights,
-			m_bulkCoefs,
-			m_invK,
-			this->inPosition()->getValue(),
-			m_restShape.getValue(),
-			this->inHorizon()->getValue(),
-			m_mu.getValue(),
-			m_lambda.getValue());
-		cuSynchronize();
+		if (m_useWarpAgg)
+		{
+			if (m_contention == NULL)
+			{
+				cuSafeCall(cudaMalloc((void**)&m_contention, sizeof(unsigned long long)));
+			}
+			cuSafeCall(cudaMemset(m_contention, 0, sizeof(unsigned long long)));
+
+			EM_EnforceElasticityWarpAgg << <pDims, BLOCK_SIZE >> > (
+				m_displacement,
+				m_weights,
+				m_bulkCoefs,
+				m_invK,
+				this->inPosition()->getValue(),
+				m_restShape.getValue(),
+				this->inHorizon()->getValue(),
+				m_mu.getValue(),
+				m_lambda.getValue(),
+				m_contention);
+			cuSynchronize();
+		}
+		else
+		{
+			EM_EnforceElasticity << <pDims, BLOCK_SIZE >> > (
+				m_displacement,
+				m_weights,
+				m_bulkCoefs,
+				m_invK,
+				this->inPosition()->getValue(),
+				m_restShape.getValue(),
+				this->inHorizon()->getValue(),
+				m_mu.getValue(),
+				m_lambda.getValue());
+			cuSynchronize();
+		}
 
 		K_UpdatePosition << <pDims, BLOCK_SIZE >> > (
 			this->inPosition()->getValue(),
@@ -368,6 +562,211 @@ namespace PhysIKA
 		cuSynchronize();
 	}
 
+	template<typename TDataType>
+	unsigned long long ElasticityModule<TDataType>::getScatterContention()
+	{
+		if (m_contention == NULL)
+		{
+			return 0;
+		}
+
+		unsigned long long merged = 0;
+		cuSafeCall(cudaMemcpy(&merged, m_contention, sizeof(unsigned long long), cudaMemcpyDeviceToHost));
+		return merged;
+	}
+
+	template <typename Real, typename Coord, typename Matrix, typename NPair>
+	__global__ void EM_EnforceElasticityColored(
+		DeviceArray<Coord> delta_position,
+		DeviceArray<Real> weights,
+		DeviceArray<Real> bulkCoefs,
+		DeviceArray<Matrix> invK,
+		DeviceArray<Coord> position,
+		NeighborList<NPair> restShapes,
+		DeviceArray<int> colors,
+		int current,
+		Real horizon,
+		Real mu,
+		Real lambda)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= position.size()) return;
+		if (colors[pId] != current) return;
+
+		CorrectedKernel<Real> g_weightKernel;
+
+		NPair np_i = restShapes.getElement(pId, 0);
+		Coord rest_i = np_i.pos;
+		int size_i = restShapes.getNeighborSize(pId);
+
+		Coord cur_pos_i = position[pId];
+
+		Coord accPos = Coord(0);
+		Real accA = Real(0);
+		Real bulk_i = bulkCoefs[pId];
+
+		Real total_weight = 0.0f;
+		Matrix deform_i = Matrix(0.0f);
+		for (int ne = 0; ne < size_i; ne++)
+		{
+			NPair np_j = restShapes.getElement(pId, ne);
+			Coord rest_j = np_j.pos;
+			int j = np_j.index;
+
+			Real r = (rest_j - rest_i).norm();
+
+			if (r > EPSILON)
+			{
+				Real weight = g_weightKernel.Weight(r, horizon);
+
+				Coord p = (position[j] - position[pId]) / horizon;
+				Coord q = (rest_j - rest_i) / horizon*weight;
+
+				deform_i(0, 0) += p[0] * q[0]; deform_i(0, 1) += p[0] * q[1]; deform_i(0, 2) += p[0] * q[2];
+				deform_i(1, 0) += p[1] * q[0]; deform_i(1, 1) += p[1] * q[1]; deform_i(1, 2) += p[1] * q[2];
+				deform_i(2, 0) += p[2] * q[0]; deform_i(2, 1) += p[2] * q[1]; deform_i(2, 2) += p[2] * q[2];
+				total_weight += weight;
+			}
+		}
+
+		if (total_weight > EPSILON)
+		{
+			deform_i *= (1.0f / total_weight);
+			deform_i = deform_i * invK[pId];
+		}
+		else
+		{
+			total_weight = 1.0f;
+		}
+
+		if ((deform_i.determinant()) < -0.001f)
+		{
+			deform_i = Matrix::identityMatrix();
+		}
+
+		for (int ne = 0; ne < size_i; ne++)
+		{
+			NPair np_j = restShapes.getElement(pId, ne);
+			Coord rest_j = np_j.pos;
+			int j = np_j.index;
+
+			Coord cur_pos_j = position[j];
+			Real r = (rest_j - rest_i).norm();
+
+			if (r > 0.01f*horizon)
+			{
+				Coord rest_dir_ij = deform_i*(rest_i - rest_j);
+				Coord cur_dir_ij = cur_pos_i - cur_pos_j;
+
+				cur_dir_ij = cur_dir_ij.norm() > EPSILON ? cur_dir_ij.normalize() : Coord(0);
+				rest_dir_ij = rest_dir_ij.norm() > EPSILON ? rest_dir_ij.normalize() : Coord(0, 0, 0);
+
+				Real mu_ij = mu*bulk_i* g_weightKernel.WeightRR(r, horizon);
+				Coord mu_pos_ij = position[j] + r*rest_dir_ij;
+				Coord mu_pos_ji = position[pId] - r*rest_dir_ij;
+
+				Real lambda_ij = lambda*bulk_i*g_weightKernel.WeightRR(r, horizon);
+				Coord lambda_pos_ij = position[j] + r*cur_dir_ij;
+				Coord lambda_pos_ji = position[pId] - r*cur_dir_ij;
+
+				Coord delta_pos_ij = mu_ij*mu_pos_ij + lambda_ij*lambda_pos_ij;
+				Real delta_weight_ij = mu_ij + lambda_ij;
+
+				Coord delta_pos_ji = mu_ij*mu_pos_ji + lambda_ij*lambda_pos_ji;
+
+				accA += delta_weight_ij;
+				accPos += delta_pos_ij;
+
+				//neighbors belong to other colors, their half of the pair is
+				//committed when their color runs
+				atomicAdd(&weights[j], delta_weight_ij);
+				atomicAdd(&delta_position[j][0], delta_pos_ji[0]);
+				atomicAdd(&delta_position[j][1], delta_pos_ji[1]);
+				atomicAdd(&delta_position[j][2], delta_pos_ji[2]);
+			}
+		}
+
+		atomicAdd(&weights[pId], accA);
+		atomicAdd(&delta_position[pId][0], accPos[0]);
+		atomicAdd(&delta_position[pId][1], accPos[1]);
+		atomicAdd(&delta_position[pId][2], accPos[2]);
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void K_UpdatePositionColored(
+		DeviceArray<Coord> position,
+		DeviceArray<Coord> old_position,
+		DeviceArray<Coord> delta_position,
+		DeviceArray<Real> delta_weights,
+		DeviceArray<int> colors,
+		int current)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= position.size()) return;
+		if (colors[pId] != current) return;
+
+		position[pId] = (old_position[pId] + delta_position[pId]) / (1.0 + delta_weights[pId]);
+	}
+
+	__global__ void EM_InitColors(DeviceArray<int> colors)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= colors.size()) return;
+
+		colors[pId] = -1;
+	}
+
+	/*!
+	*	\brief	One elimination round of a greedy parallel coloring: an
+	*	uncolored particle whose index is the largest among its uncolored
+	*	rest-shape neighbors takes the smallest color unused around it.
+	*/
+	template <typename NPair>
+	__global__ void EM_ColorRound(
+		DeviceArray<int> colors,
+		NeighborList<NPair> restShapes,
+		int* remaining)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= colors.size()) return;
+		if (colors[pId] >= 0) return;
+
+		int size_i = restShapes.getNeighborSize(pId);
+
+		bool dominant = true;
+		for (int ne = 0; ne < size_i; ne++)
+		{
+			int j = restShapes.getElement(pId, ne).index;
+			if (j != pId && colors[j] < 0 && j > pId)
+			{
+				dominant = false;
+				break;
+			}
+		}
+
+		if (!dominant)
+		{
+			atomicAdd(remaining, 1);
+			return;
+		}
+
+		//64 bits cover far more colors than a neighbor-limited stencil needs
+		unsigned long long used = 0;
+		for (int ne = 0; ne < size_i; ne++)
+		{
+			int j = restShapes.getElement(pId, ne).index;
+			int c = colors[j];
+			if (j != pId && c >= 0 && c < 64)
+			{
+				used |= 1ull << c;
+			}
+		}
+
+		int c = 0;
+		while ((used >> c) & 1) c++;
+		colors[pId] = c;
+	}
+
 	template<typename Real>
 	__global__ void EM_InitBulkStiffness(DeviceArray<Real> stiffness)
 	{
@@ -401,6 +800,41 @@ namespace PhysIKA
 	}
 
 
+	template<typename TDataType>
+	void ElasticityModule<TDataType>::updateColoring()
+	{
+		int num = this->inPosition()->getElementCount();
+		uint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+		if (m_colors.size() != num)
+		{
+			m_colors.resize(num);
+		}
+
+		EM_InitColors << <pDims, BLOCK_SIZE >> > (m_colors);
+
+		int* remaining;
+		cuSafeCall(cudaMalloc((void**)&remaining, sizeof(int)));
+
+		int left = num;
+		while (left > 0)
+		{
+			cuSafeCall(cudaMemset(remaining, 0, sizeof(int)));
+			EM_ColorRound << <pDims, BLOCK_SIZE >> > (
+				m_colors,
+				m_restShape.getValue(),
+				remaining);
+			cuSafeCall(cudaMemcpy(&left, remaining, sizeof(int), cudaMemcpyDeviceToHost));
+		}
+		cuSafeCall(cudaFree(remaining));
+
+		Reduction<int>* reduce = Reduction<int>::Create(num);
+		m_colorNum = reduce->maximum(m_colors.getDataPtr(), num) + 1;
+		delete reduce;
+
+		m_coloringDirty = false;
+	}
+
 	template<typename TDataType>
 	void ElasticityModule<TDataType>::solveElasticity()
 	{
@@ -409,12 +843,60 @@ namespace PhysIKA
 
 		this->computeInverseK();
 
-		int itor = 0;
-		while (itor < m_iterNum.getValue())
+		if (m_useColoredGS)
+		{
+			if (m_coloringDirty)
+			{
+				this->updateColoring();
+			}
+
+			int num = this->inPosition()->getElementCount();
+			uint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+			int itor = 0;
+			while (itor < m_iterNum.getValue())
+			{
+				m_displacement.reset();
+				m_weights.reset();
+
+				for (int c = 0; c < m_colorNum; c++)
+				{
+					EM_EnforceElasticityColored << <pDims, BLOCK_SIZE >> > (
+						m_displacement,
+						m_weights,
+						m_bulkCoefs,
+						m_invK,
+						this->inPosition()->getValue(),
+						m_restShape.getValue(),
+						m_colors,
+						c,
+						this->inHorizon()->getValue(),
+						m_mu.getValue(),
+						m_lambda.getValue());
+					cuSynchronize();
+
+					K_UpdatePositionColored << <pDims, BLOCK_SIZE >> > (
+						this->inPosition()->getValue(),
+						m_position_old,
+						m_displacement,
+						m_weights,
+						m_colors,
+						c);
+					cuSynchronize();
+				}
+
+				itor++;
+			}
+		}
+		else
 		{
-			this->enforceElasticity();
+			int itor = 0;
+			while (itor < m_iterNum.getValue())
+			{
+				this->enforceElasticity();
 
-			itor++;
+				itor++;
+			}
 		}
 
 		this->updateVelocity();
@@ -496,6 +978,22 @@ namespace PhysIKA
 	template<typename TDataType>
 	void ElasticityModule<TDataType>::resetRestShape()
 	{
+		std::vector<int> cacheKey;
+		if (m_sharedRestShape)
+		{
+			auto& cache = RestShapeCache<TDataType>::getInstance();
+			cacheKey = cache.computeKey(this->inPosition()->getValue());
+
+			auto shared = cache.find(cacheKey, this->inHorizon()->getValue());
+			if (shared != nullptr)
+			{
+				m_restShape.setReference(shared);
+				m_restShapeCached = true;
+				m_coloringDirty = true;
+				return;
+			}
+		}
+
 		m_restShape.setElementCount(this->inNeighborhood()->getValue().size());
 		m_restShape.getValue().getIndex().resize(this->inNeighborhood()->getValue().getIndex().size());
 
@@ -514,6 +1012,44 @@ namespace PhysIKA
 
 		K_UpdateRestShape<< <pDims, BLOCK_SIZE >> > (m_restShape.getValue(), this->inNeighborhood()->getValue(), this->inPosition()->getValue());
 		cuSynchronize();
+
+		if (m_sharedRestShape)
+		{
+			RestShapeCache<TDataType>::getInstance().insert(cacheKey, this->inHorizon()->getValue(), m_restShape.getReference());
+			m_restShapeCached = true;
+		}
+
+		m_coloringDirty = true;
+	}
+
+	template<typename TDataType>
+	void ElasticityModule<TDataType>::makeRestShapePrivate()
+	{
+		if (!m_restShapeCached)
+		{
+			return;
+		}
+
+		auto shared = m_restShape.getReference();
+
+		auto priv = std::make_shared<NeighborList<NPair>>();
+		priv->resize(shared->size());
+		priv->getIndex().resize(shared->getIndex().size());
+
+		if (shared->isLimited())
+		{
+			priv->setNeighborLimit(shared->getNeighborLimit());
+		}
+		else
+		{
+			priv->getElements().resize(shared->getElements().size());
+		}
+
+		Function1Pt::copy(priv->getIndex(), shared->getIndex());
+		Function1Pt::copy(priv->getElements(), shared->getElements());
+
+		m_restShape.setReference(priv);
+		m_restShapeCached = false;
 	}
 
 	template<typename TDataType>
@@ -545,4 +1081,10 @@ namespace PhysIKA
 		return true;
 	}
 
+
+#ifdef PRECISION_FLOAT
+	template class ElasticityModule<DataType3f>;
+#else
+	template class ElasticityModule<DataType3d>;
+#endif
 }
\ No newline at end of file
@@ -40,11 +40,51 @@ namespace PhysIKA {
 		void setIterationNumber(int num) { m_iterNum.setValue(num); }
 		int getIterationNumber() { return m_iterNum.getValue(); }
 
+		/**
+		 * @brief Replace the Jacobi-style sweeps with Gauss-Seidel sweeps over
+		 * a precomputed coloring of the rest-shape connectivity. Within a color
+		 * no two particles are neighbors, so each color updates in parallel
+		 * while later colors already see the new positions. The coloring is
+		 * rebuilt only when the rest shape changes.
+		 */
+		void setColoredGaussSeidel(bool enabled) { m_useColoredGS = enabled; }
+
+		/**
+		 * @brief Share one immutable rest-shape list between instances of the
+		 * same asset via RestShapeCache. On a cache hit resetRestShape() skips
+		 * the rebuild and points m_restShape at the cached buffers; modules
+		 * that rewrite the rest shape detach first through
+		 * makeRestShapePrivate().
+		 */
+		void enableSharedRestShape(bool enabled) { m_sharedRestShape = enabled; }
+
+		/**
+		 * @brief Merge scatter contributions that target the same neighbor
+		 * within a warp before touching global memory. Dense packings (sand
+		 * piles) serialize badly on the per-lane atomics of the projection
+		 * sweep; aggregation issues one global atomic per warp-local target.
+		 * Requires compute capability 7.0; older devices fall back to the
+		 * plain atomics inside the same kernel.
+		 */
+		void setWarpAggregatedScatter(bool enabled) { m_useWarpAgg = enabled; }
+
+		/**
+		 * @brief Number of global atomics merged away during the last
+		 * projection sweep; only meaningful when warp aggregation is enabled.
+		 */
+		unsigned long long getScatterContention();
+
 		void resetRestShape();
 
 	protected:
 		bool initializeImpl() override;
 
+		/**
+		 * @brief Copy-on-write hook: if the current rest shape is a cached,
+		 * shared list, replace it with a private deep copy before mutation.
+		 */
+		void makeRestShapePrivate();
+
 		/**
 		 * @brief Correct the particle position with one iteration
 		 * Be sure computeInverseK() is called as long as the rest shape is changed
@@ -100,15 +140,26 @@ namespace PhysIKA {
 		DeviceArray<Coord> m_displacement;
 		DeviceArray<Matrix> m_invK;
 	private:
+		void updateColoring();
+
 		VarField<int> m_iterNum;
 
 		DeviceArray<Real> m_stiffness;
 		DeviceArray<Matrix> m_F;
+
+		bool m_useColoredGS = false;
+		bool m_useWarpAgg = false;
+		unsigned long long* m_contention = NULL;
+		bool m_sharedRestShape = false;
+		bool m_restShapeCached = false;
+		bool m_coloringDirty = true;
+		int m_colorNum = 0;
+		DeviceArray<int> m_colors;
 	};
 
 #ifdef PRECISION_FLOAT
-	template class ElasticityModule<DataType3f>;
+	extern template class ElasticityModule<DataType3f>;
 #else
-	template class ElasticityModule<DataType3d>;
+	extern template class ElasticityModule<DataType3d>;
 #endif
 }
\ No newline at end of file
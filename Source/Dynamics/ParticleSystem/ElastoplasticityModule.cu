@@ -6,6 +6,7 @@
 #include "Kernel.h"
 #include <thrust/scan.h>
 #include <thrust/reduce.h>
+#include <thrust/count.h>
 //#include "svd3_cuda2.h"
 
 namespace PhysIKA
@@ -266,6 +267,9 @@ namespace PhysIKA
 	template<typename TDataType>
 	void ElastoplasticityModule<TDataType>::applyPlasticity()
 	{
+		//the rest shape is rewritten below; detach from any shared cache entry
+		this->makeRestShapePrivate();
+
 		this->rotateRestShape();
 
 		this->computeMaterialStiffness();
@@ -401,10 +405,12 @@ namespace PhysIKA
 		DeviceArray<Matrix> invF,
 		DeviceArray<Coord> position,
 		NeighborList<NPair> restShape,
-		Real horizon)
+		Real horizon,
+		DeviceArray<int> touched)
 	{
 		int i = threadIdx.x + (blockIdx.x * blockDim.x);
 		if (i >= invF.size()) return;
+		if (touched[i] == 0) return;
 
 		CorrectedKernel<Real> kernSmooth;
 
@@ -480,20 +486,209 @@ namespace PhysIKA
 		bYield[i] = true;
 	}
 
+	__global__ void PM_AccumulateYield(
+		DeviceArray<bool> accum,
+		DeviceArray<bool> bYield)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= bYield.size()) return;
+
+		if (bYield[i])
+		{
+			accum[i] = true;
+			bYield[i] = false;
+		}
+	}
+
+	__global__ void PM_RestoreYield(
+		DeviceArray<bool> bYield,
+		DeviceArray<bool> accum)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= bYield.size()) return;
+
+		bYield[i] = accum[i];
+		accum[i] = false;
+	}
+
+	//the inverse deformation is only read for yielded particles and their
+	//neighbors; everything else can skip the factorization
+	__global__ void PM_MarkTouched(
+		DeviceArray<int> touched,
+		DeviceArray<bool> bYield,
+		NeighborList<int> neighborhood)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= touched.size()) return;
+
+		if (bYield[i])
+		{
+			touched[i] = 1;
+			return;
+		}
+
+		int nbSize = neighborhood.getNeighborSize(i);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			if (bYield[neighborhood.getElement(i, ne)])
+			{
+				touched[i] = 1;
+				return;
+			}
+		}
+
+		touched[i] = 0;
+	}
+
+	template <typename NPair>
+	__global__ void PM_CheckRestShapeLayout(
+		DeviceArray<int> mismatch,
+		DeviceArray<bool> bYield,
+		NeighborList<int> neighborhood,
+		NeighborList<NPair> restShape)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= mismatch.size()) return;
+
+		mismatch[i] = bYield[i] && neighborhood.getNeighborSize(i) != restShape.getNeighborSize(i) ? 1 : 0;
+	}
+
+	//in-place twin of the yielded branch of PM_ReconstructRestShape, usable
+	//when every yielded particle keeps its neighbor count: each thread only
+	//rewrites its own row, so the packed list needs no reallocation
+	template <typename Coord, typename Matrix, typename NPair>
+	__global__ void PM_ReconstructRestShapeInPlace(
+		NeighborList<NPair> restShape,
+		DeviceArray<bool> bYield,
+		DeviceArray<Coord> position,
+		DeviceArray<Matrix> invF,
+		NeighborList<int> neighborhood)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= restShape.size()) return;
+
+		if (!bYield[i]) return;
+
+		int nbSize = neighborhood.getNeighborSize(i);
+		Coord pos_i = position[i];
+
+		Matrix invF_i = invF[i];
+
+		NPair np;
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighborhood.getElement(i, ne);
+			Matrix invF_j = invF[j];
+
+			np.index = j;
+			np.pos = pos_i + 0.5*(invF_i + invF_j)*(position[j] - pos_i);
+			if (i != j)
+			{
+				restShape.setElement(i, ne, np);
+			}
+			else
+			{
+				if (ne == 0)
+				{
+					restShape.setElement(i, ne, np);
+				}
+				else
+				{
+					auto ele = restShape.getElement(i, 0);
+					restShape.setElement(i, 0, np);
+					restShape.setElement(i, ne, ele);
+				}
+			}
+		}
+
+		bYield[i] = false;
+	}
+
 	template<typename TDataType>
 	void ElastoplasticityModule<TDataType>::reconstructRestShape()
 	{
 		//constructRestShape(m_neighborhood.getValue(), m_position.getValue());
 
-		uint pDims = cudaGridSize(this->inPosition()->getElementCount(), BLOCK_SIZE);
+		int num = this->inPosition()->getElementCount();
+		uint pDims = cudaGridSize(num, BLOCK_SIZE);
 
 		if (m_reconstuct_all_neighborhood.getValue())
 		{
 			PM_EnableAllReconstruction << <pDims, BLOCK_SIZE >> > (m_bYield);
 		}
+		else if (m_reconstruct_interval > 1)
+		{
+			//batch mode: fold this substep's flags into the accumulator and
+			//rewrite the topology once per interval. The projection itself
+			//keeps running every substep, only the rebuild is deferred.
+			if (m_bYieldAccum.size() != num)
+			{
+				m_bYieldAccum.resize(num);
+				m_bYieldAccum.reset();
+			}
+
+			PM_AccumulateYield << <pDims, BLOCK_SIZE >> > (m_bYieldAccum, m_bYield);
+
+			m_reconstruct_step++;
+			if (m_reconstruct_step % m_reconstruct_interval != 0)
+			{
+				return;
+			}
+
+			PM_RestoreYield << <pDims, BLOCK_SIZE >> > (m_bYield, m_bYieldAccum);
+		}
+
+		//most substeps nothing yields; skip the rebuild entirely then
+		int yieldNum = (int)thrust::count(thrust::device, m_bYield.getDataPtr(), m_bYield.getDataPtr() + num, true);
+		if (yieldNum == 0)
+		{
+			return;
+		}
+
+		if (m_touched.size() != num)
+		{
+			m_touched.resize(num);
+		}
+
+		//the factorization below is only read for yielded particles and
+		//their neighbors
+		PM_MarkTouched << <pDims, BLOCK_SIZE >> > (
+			m_touched,
+			m_bYield,
+			this->inNeighborhood()->getValue());
+
+		PM_ComputeInverseDeformation << <pDims, BLOCK_SIZE >> > (
+			m_invF,
+			this->inPosition()->getValue(),
+			this->m_restShape.getValue(),
+			this->inHorizon()->getValue(),
+			m_touched);
+
+		//when every yielded particle keeps its neighbor count, the rows can
+		//be rewritten in place without reallocating the packed list; the
+		//scratch array is reused for the mismatch flags
+		PM_CheckRestShapeLayout << <pDims, BLOCK_SIZE >> > (
+			m_touched,
+			m_bYield,
+			this->inNeighborhood()->getValue(),
+			this->m_restShape.getValue());
+
+		int mismatchNum = thrust::reduce(thrust::device, m_touched.getDataPtr(), m_touched.getDataPtr() + num, (int)0, thrust::plus<int>());
+		if (mismatchNum == 0)
+		{
+			PM_ReconstructRestShapeInPlace << <pDims, BLOCK_SIZE >> > (
+				this->m_restShape.getValue(),
+				m_bYield,
+				this->inPosition()->getValue(),
+				m_invF,
+				this->inNeighborhood()->getValue());
+			cuSynchronize();
+
+			return;
+		}
 
 		NeighborList<NPair> newNeighborList;
-		newNeighborList.resize(this->inPosition()->getElementCount());
+		newNeighborList.resize(num);
 		DeviceArray<int>& index = newNeighborList.getIndex();
 		DeviceArray<NPair>& elements = newNeighborList.getElements();
 
@@ -507,12 +702,6 @@ namespace PhysIKA
 		thrust::exclusive_scan(thrust::device, index.getDataPtr(), index.getDataPtr() + index.size(), index.getDataPtr());
 		elements.resize(total_num);
 
-		PM_ComputeInverseDeformation << <pDims, BLOCK_SIZE >> > (
-			m_invF,
-			this->inPosition()->getValue(),
-			this->m_restShape.getValue(),
-			this->inHorizon()->getValue());
-
 		PM_ReconstructRestShape<< <pDims, BLOCK_SIZE >> > (
 			newNeighborList,
 			m_bYield,
@@ -561,9 +750,10 @@ namespace PhysIKA
 
 
 	template <typename Real, typename Coord, typename Matrix, typename NPair>
-	__global__ void EM_RotateRestShape(
+	__global__ void EM_ComputeShapeMatrices(
+		DeviceArray<Matrix> defGrad,
+		DeviceArray<Matrix> shapeMat,
 		DeviceArray<Coord> position,
-		DeviceArray<bool> bYield,
 		NeighborList<NPair> restShapes,
 		Real smoothingLength)
 	{
@@ -575,7 +765,6 @@ namespace PhysIKA
 		Coord rest_pos_i = restShapes.getElement(pId, 0).pos;
 		int size_i = restShapes.getNeighborSize(pId);
 
-		//			cout << i << " " << rids[shape_i.ids[shape_i.idx]] << endl;
 		Real total_weight = 0.0f;
 		Matrix mat_i(0);
 		Matrix invK_i(0);
@@ -591,7 +780,6 @@ namespace PhysIKA
 				Real weight = kernSmooth.Weight(r, smoothingLength);
 
 				Coord p = (position[j] - position[pId]) / smoothingLength;
-				//Vector3f q = (shape_i.pos[ne] - rest_i)*(1.0f/r)*weight;
 				Coord q = (rest_pos_j - rest_pos_i) / smoothingLength;
 
 				mat_i(0, 0) += p[0] * q[0] * weight; mat_i(0, 1) += p[0] * q[1] * weight; mat_i(0, 2) += p[0] * q[2] * weight;
@@ -612,28 +800,70 @@ namespace PhysIKA
 			invK_i *= (1.0f / total_weight);
 		}
 
+		defGrad[pId] = mat_i;
+		shapeMat[pId] = invK_i;
+	}
+
+	/*!
+	*	\brief	Batched rotation extraction: the shape matrix is inverted with
+	*	clamped singular values (the SVD handles degenerate stencils), then the
+	*	rotation of defGrad * K^-1 is taken either via full SVD or, on the fast
+	*	path, the iterative polar decomposition. Only R leaves the kernel.
+	*/
+	template <typename Real, typename Matrix>
+	__global__ void EM_BatchExtractRotation(
+		DeviceArray<Matrix> rotation,
+		DeviceArray<Matrix> defGrad,
+		DeviceArray<Matrix> shapeMat,
+		Real threshold,
+		int fastPath)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= rotation.size()) return;
+
+		Matrix invK_i = shapeMat[pId];
+
 		Matrix R, U, D, V;
 		polarDecomposition(invK_i, R, U, D, V);
 
-		Real threshold = 0.0001f*smoothingLength;
 		D(0, 0) = D(0, 0) > threshold ? 1.0 / D(0, 0) : 1.0;
 		D(1, 1) = D(1, 1) > threshold ? 1.0 / D(1, 1) : 1.0;
 		D(2, 2) = D(2, 2) > threshold ? 1.0 / D(2, 2) : 1.0;
 
 		invK_i = V*D*U.transpose();
 
-		mat_i *= invK_i;
+		Matrix mat_i = defGrad[pId] * invK_i;
 
-		polarDecomposition(mat_i, R, U, D, V);
+		if (fastPath)
+		{
+			polarDecomposition(mat_i, R, Real(EPSILON));
+		}
+		else
+		{
+			polarDecomposition(mat_i, R, U, D, V);
+		}
+
+		rotation[pId] = R;
+	}
+
+	template <typename Coord, typename Matrix, typename NPair>
+	__global__ void EM_ApplyRestShapeRotation(
+		DeviceArray<Matrix> rotation,
+		NeighborList<NPair> restShapes)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= rotation.size()) return;
+
+		Matrix R = rotation[pId];
+		Coord rest_pos_i = restShapes.getElement(pId, 0).pos;
+		int size_i = restShapes.getNeighborSize(pId);
 
 		for (int ne = 0; ne < size_i; ne++)
 		{
 			NPair np_j = restShapes.getElement(pId, ne);
-			int j = np_j.index;
 			Coord rest_pos_j = np_j.pos;
 
-			Coord new_rest_pos_j = rest_pos_i + R*(rest_pos_j - rest_pos_i);
-			np_j.pos = new_rest_pos_j;
+			np_j.pos = rest_pos_i + R*(rest_pos_j - rest_pos_i);
 			restShapes.setElement(pId, ne, np_j);
 		}
 	}
@@ -645,11 +875,27 @@ namespace PhysIKA
 		int num = this->inPosition()->getElementCount();
 		uint pDims = cudaGridSize(num, BLOCK_SIZE);
 
-		EM_RotateRestShape <Real, Coord, Matrix, NPair> << <pDims, BLOCK_SIZE >> > (
+		Real h = this->inHorizon()->getValue();
+
+		EM_ComputeShapeMatrices <Real, Coord, Matrix, NPair> << <pDims, BLOCK_SIZE >> > (
+			m_defGrad,
+			m_shapeMat,
 			this->inPosition()->getValue(),
-			m_bYield,
 			this->m_restShape.getValue(),
-			this->inHorizon()->getValue());
+			h);
+		cuSynchronize();
+
+		EM_BatchExtractRotation <Real, Matrix> << <pDims, BLOCK_SIZE >> > (
+			m_rotation,
+			m_defGrad,
+			m_shapeMat,
+			Real(0.0001)*h,
+			m_polarFastPath ? 1 : 0);
+		cuSynchronize();
+
+		EM_ApplyRestShapeRotation <Coord, Matrix, NPair> << <pDims, BLOCK_SIZE >> > (
+			m_rotation,
+			this->m_restShape.getValue());
 		cuSynchronize();
 	}
 
@@ -657,6 +903,9 @@ namespace PhysIKA
 	bool ElastoplasticityModule<TDataType>::initializeImpl()
 	{
 		m_invF.resize(this->inPosition()->getElementCount());
+		m_defGrad.resize(this->inPosition()->getElementCount());
+		m_shapeMat.resize(this->inPosition()->getElementCount());
+		m_rotation.resize(this->inPosition()->getElementCount());
 		m_yiled_I1.resize(this->inPosition()->getElementCount());
 		m_yield_J2.resize(this->inPosition()->getElementCount());
 		m_I1.resize(this->inPosition()->getElementCount());
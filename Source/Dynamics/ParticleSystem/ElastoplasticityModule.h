@@ -47,6 +47,23 @@ namespace PhysIKA {
 		void enableIncompressibility();
 		void disableIncompressibility();
 
+		/**
+		 * @brief Use the iterative polar decomposition instead of the full SVD
+		 * when extracting the rest-shape rotation. Most frames only need R, so
+		 * the cheaper factorization is sufficient; the full SVD stays in place
+		 * for the shape-matrix inversion, which needs the singular values.
+		 */
+		void setPolarFastPath(bool enabled) { m_polarFastPath = enabled; }
+
+		/**
+		 * @brief Batch the rest-shape topology rebuild: yield flags are
+		 * accumulated over frames substeps and the reconstruction runs once
+		 * per batch instead of after every plasticity projection. The
+		 * projection itself still runs every substep. 1 restores the
+		 * per-substep rebuild.
+		 */
+		void setReconstructionInterval(int frames) { m_reconstruct_interval = frames < 1 ? 1 : frames; }
+
 	protected:
 		bool initializeImpl() override;
 
@@ -71,8 +88,19 @@ namespace PhysIKA {
 		VarField<bool> m_reconstuct_all_neighborhood;
 		VarField<bool> m_incompressible;
 
+		bool m_polarFastPath = false;
+
+		int m_reconstruct_interval = 1;
+		int m_reconstruct_step = 0;
+
 		DeviceArray<bool> m_bYield;
+		DeviceArray<bool> m_bYieldAccum;
+		//scratch shared by the touched-particle mask and the layout check
+		DeviceArray<int> m_touched;
 		DeviceArray<Matrix> m_invF;
+		DeviceArray<Matrix> m_defGrad;
+		DeviceArray<Matrix> m_shapeMat;
+		DeviceArray<Matrix> m_rotation;
 		DeviceArray<Real> m_yiled_I1;
 		DeviceArray<Real> m_yield_J2;
 		DeviceArray<Real> m_I1;
@@ -1,11 +1,15 @@
 #include <cuda_runtime.h>
 #include "Core/Utility.h"
+#include "Core/Utility/Scan.h"
 #include "Framework/Framework/Log.h"
 #include "Framework/Framework/FieldVar.h"
 #include "Framework/Framework/MechanicalState.h"
 #include "Framework/Framework/Node.h"
 #include "FixedPoints.h"
 
+#include <map>
+#include <set>
+
 namespace PhysIKA
 {
 	IMPLEMENT_CLASS_1(FixedPoints, TDataType)
@@ -22,8 +26,8 @@ namespace PhysIKA
 	template<typename TDataType>
 	FixedPoints<TDataType>::~FixedPoints()
 	{
-		m_bFixed.release();
-		m_fixed_positions.release();
+		m_anchor_ids.release();
+		m_anchor_points.release();
 	}
 
 
@@ -39,107 +43,266 @@ namespace PhysIKA
 		return true;
 	}
 
+	//first index in the sorted array whose id is not less than key
+	__device__ int FP_LowerBound(int* ids, int num, int key)
+	{
+		int lo = 0;
+		int hi = num;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) >> 1;
+			if (ids[mid] < key)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	__global__ void K_FP_FlagSurvivors(
+		DeviceArray<int> flags,
+		DeviceArray<int> anchorIds,
+		DeviceArray<int> evictIds)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= anchorIds.size()) return;
+
+		int id = anchorIds[tId];
+		int lb = FP_LowerBound(evictIds.getDataPtr(), evictIds.size(), id);
+		flags[tId] = (lb < evictIds.size() && evictIds[lb] == id) ? 0 : 1;
+	}
+
+	template <typename Coord>
+	__global__ void K_FP_CompactAnchors(
+		DeviceArray<int> outIds,
+		DeviceArray<Coord> outPts,
+		DeviceArray<int> anchorIds,
+		DeviceArray<Coord> anchorPts,
+		DeviceArray<int> flags,
+		DeviceArray<int> offsets)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= anchorIds.size()) return;
+
+		if (flags[tId])
+		{
+			int dst = offsets[tId];
+			outIds[dst] = anchorIds[tId];
+			outPts[dst] = anchorPts[tId];
+		}
+	}
+
+	//Ranked merge of two sorted, disjoint id ranges: every element's final
+	//position is its own rank plus its rank in the other range, so both
+	//sides scatter independently in one pass.
+	template <typename Coord>
+	__global__ void K_FP_MergeOldAnchors(
+		DeviceArray<int> outIds,
+		DeviceArray<Coord> outPts,
+		DeviceArray<int> anchorIds,
+		DeviceArray<Coord> anchorPts,
+		DeviceArray<int> addIds)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= anchorIds.size()) return;
+
+		int id = anchorIds[tId];
+		int dst = tId + FP_LowerBound(addIds.getDataPtr(), addIds.size(), id);
+		outIds[dst] = id;
+		outPts[dst] = anchorPts[tId];
+	}
+
+	template <typename Coord>
+	__global__ void K_FP_MergeNewAnchors(
+		DeviceArray<int> outIds,
+		DeviceArray<Coord> outPts,
+		DeviceArray<int> addIds,
+		DeviceArray<Coord> addPts,
+		DeviceArray<int> anchorIds)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= addIds.size()) return;
+
+		int id = addIds[tId];
+		int dst = tId + FP_LowerBound(anchorIds.getDataPtr(), anchorIds.size(), id);
+		outIds[dst] = id;
+		outPts[dst] = addPts[tId];
+	}
 
 	template<typename TDataType>
-	void FixedPoints<TDataType>::updateContext()
+	void FixedPoints<TDataType>::flushPendingEdits()
 	{
-		int totalNum = m_position.getValue().size();
-		if (m_bFixed.size() != totalNum)
+		//batch-local dedup on host: the batch is the edit set, not the
+		//anchor set, so this stays small however many anchors exist
+		std::map<int, Coord> adds;
+		for (size_t i = 0; i < m_pending_add_ids.size(); i++)
 		{
-			m_bFixed_host.resize(totalNum);
-			m_fixed_positions_host.resize(totalNum);
+			adds[m_pending_add_ids[i]] = m_pending_add_points[i];
+		}
 
-			m_bFixed.resize(totalNum);
-			m_fixed_positions.resize(totalNum);
+		//re-added ids are evicted first, so the merge ranges stay disjoint
+		std::set<int> evict(m_pending_remove_ids.begin(), m_pending_remove_ids.end());
+		for (auto it = adds.begin(); it != adds.end(); it++)
+		{
+			evict.insert(it->first);
 		}
 
-		for (int i = 0; i < m_bFixed_host.size(); i++)
+		m_pending_add_ids.clear();
+		m_pending_add_points.clear();
+		m_pending_remove_ids.clear();
+
+		if (m_anchor_num > 0 && !evict.empty())
 		{
-			m_bFixed_host[i] = 0;
+			std::vector<int> evictHost(evict.begin(), evict.end());
+			DeviceArray<int> evictIds;
+			evictIds.resize((int)evictHost.size());
+			Function1Pt::copy(evictIds, evictHost);
+
+			DeviceArray<int> flags;
+			DeviceArray<int> offsets;
+			flags.resize(m_anchor_num);
+			offsets.resize(m_anchor_num);
+
+			cuExecute(m_anchor_num, K_FP_FlagSurvivors, flags, m_anchor_ids, evictIds);
+
+			Scan scan;
+			scan.exclusive(offsets, flags);
+
+			//tiny readback: survivor count only
+			int lastFlag = 0;
+			int lastOffset = 0;
+			cuSafeCall(cudaMemcpy(&lastFlag, flags.getDataPtr() + m_anchor_num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+			cuSafeCall(cudaMemcpy(&lastOffset, offsets.getDataPtr() + m_anchor_num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+			int newNum = lastOffset + lastFlag;
+
+			if (newNum != m_anchor_num)
+			{
+				DeviceArray<int> compactIds;
+				DeviceArray<Coord> compactPts;
+				compactIds.resize(newNum);
+				compactPts.resize(newNum);
+
+				if (newNum > 0)
+				{
+					cuExecute(m_anchor_num, K_FP_CompactAnchors, compactIds, compactPts, m_anchor_ids, m_anchor_points, flags, offsets);
+				}
+
+				m_anchor_ids.release();
+				m_anchor_points.release();
+				m_anchor_ids = std::move(compactIds);
+				m_anchor_points = std::move(compactPts);
+				m_anchor_num = newNum;
+			}
+
+			evictIds.release();
+			flags.release();
+			offsets.release();
 		}
 
-		for (auto it = m_fixedPts.begin(); it != m_fixedPts.end(); it++)
+		if (!adds.empty())
 		{
-			if (it->first >= 0 && it->first < totalNum)
+			//std::map iterates in ascending id order, so the batch uploads sorted
+			std::vector<int> addIdsHost;
+			std::vector<Coord> addPtsHost;
+			addIdsHost.reserve(adds.size());
+			addPtsHost.reserve(adds.size());
+			for (auto it = adds.begin(); it != adds.end(); it++)
 			{
-				m_bFixed_host[it->first] = 1;
-				m_fixed_positions_host[it->first] = it->second;
+				addIdsHost.push_back(it->first);
+				addPtsHost.push_back(it->second);
 			}
+
+			DeviceArray<int> addIds;
+			DeviceArray<Coord> addPts;
+			addIds.resize((int)addIdsHost.size());
+			addPts.resize((int)addPtsHost.size());
+			Function1Pt::copy(addIds, addIdsHost);
+			Function1Pt::copy(addPts, addPtsHost);
+
+			int mergedNum = m_anchor_num + (int)addIdsHost.size();
+			DeviceArray<int> mergedIds;
+			DeviceArray<Coord> mergedPts;
+			mergedIds.resize(mergedNum);
+			mergedPts.resize(mergedNum);
+
+			if (m_anchor_num > 0)
+			{
+				cuExecute(m_anchor_num, K_FP_MergeOldAnchors, mergedIds, mergedPts, m_anchor_ids, m_anchor_points, addIds);
+			}
+			cuExecute((int)addIdsHost.size(), K_FP_MergeNewAnchors, mergedIds, mergedPts, addIds, addPts, m_anchor_ids);
+
+			m_anchor_ids.release();
+			m_anchor_points.release();
+			m_anchor_ids = std::move(mergedIds);
+			m_anchor_points = std::move(mergedPts);
+			m_anchor_num = mergedNum;
+
+			addIds.release();
+			addPts.release();
 		}
 
-		Function1Pt::copy(m_bFixed, m_bFixed_host);
-		Function1Pt::copy(m_fixed_positions, m_fixed_positions_host);
+		cuSynchronize();
 	}
 
 	template<typename TDataType>
 	void FixedPoints<TDataType>::addFixedPoint(int id, Coord pt)
 	{
-		m_fixedPts[id] = pt;
-
-		bUpdateRequired = true;
+		m_pending_add_ids.push_back(id);
+		m_pending_add_points.push_back(pt);
 	}
 
 
 	template<typename TDataType>
 	void FixedPoints<TDataType>::removeFixedPoint(int id)
 	{
-		auto it = m_fixedPts.begin();
-		while (it != m_fixedPts.end())
-		{
-			if (it->first == id)
-			{
-				m_fixedPts.erase(it++);
-			}
-			else
-				it++;
-		}
-
-		bUpdateRequired = true;
+		m_pending_remove_ids.push_back(id);
 	}
 
 
 	template<typename TDataType>
 	void FixedPoints<TDataType>::clear()
 	{
-		m_fixedPts.clear();
+		m_pending_add_ids.clear();
+		m_pending_add_points.clear();
+		m_pending_remove_ids.clear();
 
-		bUpdateRequired = true;
+		m_anchor_ids.release();
+		m_anchor_points.release();
+		m_anchor_num = 0;
 	}
 
 	template <typename Coord>
-	__global__ void K_DoFixPoints(
+	__global__ void K_FP_ApplyAnchors(
 		DeviceArray<Coord> curPos,
 		DeviceArray<Coord> curVel,
-		DeviceArray<int> bFixed,
-		DeviceArray<Coord> fixedPts)
+		DeviceArray<int> anchorIds,
+		DeviceArray<Coord> anchorPts)
 	{
-		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
-		if (pId >= curPos.size()) return;
-		
-		if (bFixed[pId])
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= anchorIds.size()) return;
+
+		//one thread per anchor; sorted ids keep the scattered writes
+		//near-sequential
+		int id = anchorIds[tId];
+		if (id >= 0 && id < curPos.size())
 		{
-			curPos[pId] = fixedPts[pId];
-			curVel[pId] = Coord(0);
+			curPos[id] = anchorPts[tId];
+			curVel[id] = Coord(0);
 		}
-
 	}
 
 	template<typename TDataType>
 	bool FixedPoints<TDataType>::constrain()
 	{
-		if (m_fixedPts.size() <= 0)
-			return false;
-
-		if (bUpdateRequired)
+		if (!m_pending_add_ids.empty() || !m_pending_remove_ids.empty())
 		{
-			updateContext();
-			bUpdateRequired = false;
+			flushPendingEdits();
 		}
 
+		if (m_anchor_num <= 0)
+			return false;
 
-		uint pDims = cudaGridSize(m_bFixed.size(), BLOCK_SIZE);
-
-		K_DoFixPoints<Coord> << < pDims, BLOCK_SIZE >> > (m_position.getValue(), m_velocity.getValue(), m_bFixed, m_fixed_positions);
+		cuExecuteTuned(m_anchor_num, K_FP_ApplyAnchors<Coord>, m_position.getValue(), m_velocity.getValue(), m_anchor_ids, m_anchor_points);
 
 		return true;
 	}
@@ -163,9 +326,7 @@ namespace PhysIKA
 	template<typename TDataType>
 	void PhysIKA::FixedPoints<TDataType>::constrainPositionToPlane(Coord pos, Coord dir)
 	{
-		uint pDims = cudaGridSize(m_bFixed.size(), BLOCK_SIZE);
-
-		K_DoPlaneConstrain<< < pDims, BLOCK_SIZE >> > (m_position.getValue(), pos, dir);
+		cuExecuteTuned(m_position.getElementCount(), K_DoPlaneConstrain<Coord>, m_position.getValue(), pos, dir);
 	}
 
-}
\ No newline at end of file
+}
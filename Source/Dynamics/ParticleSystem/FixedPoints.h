@@ -2,10 +2,23 @@
 #include "Framework/Framework/ModuleConstraint.h"
 #include "Framework/Framework/FieldArray.h"
 
-#include <map>
+#include <vector>
 
 namespace PhysIKA {
 
+	/**
+	 * @brief Pins particles to anchor positions.
+	 *
+	 * Anchors live on the device in a pair of contiguous arrays sorted by
+	 * particle id, and the constraint kernel runs over the anchor range
+	 * only, so a handful of active pins on a million-particle cloth does
+	 * not launch a thread per particle. addFixedPoint/removeFixedPoint
+	 * stage edits in host batches; the next constrain() folds a batch into
+	 * the sorted arrays with an eviction compact plus a ranked merge, so
+	 * an edit uploads the batch, never the whole anchor set. Rooted
+	 * vegetation and pinned cloth with millions of anchors stay fully
+	 * device-resident across edits.
+	 */
 	template<typename TDataType>
 	class FixedPoints : public ConstraintModule
 	{
@@ -17,6 +30,10 @@ namespace PhysIKA {
 		FixedPoints();
 		~FixedPoints() override;
 
+		/**
+		 * @brief Pin particle id to pt; re-adding an id moves its anchor.
+		 * Staged until the next constrain().
+		 */
 		void addFixedPoint(int id, Coord pt);
 		void removeFixedPoint(int id);
 
@@ -26,6 +43,11 @@ namespace PhysIKA {
 
 		void constrainPositionToPlane(Coord pos, Coord dir);
 
+		/**
+		 * @brief Number of anchors once the staged edits are folded in.
+		 */
+		int getFixedPointNumber() { return m_anchor_num + (int)m_pending_add_ids.size(); }
+
 	public:
 		/**
 		* @brief Particle position
@@ -43,17 +65,17 @@ namespace PhysIKA {
 		FieldID m_initPosID;
 
 	private:
-		void updateContext();
-
-		bool bUpdateRequired = false;
-
-		std::map<int, Coord> m_fixedPts;
+		void flushPendingEdits();
 
-		std::vector<int> m_bFixed_host;
-		std::vector<Coord> m_fixed_positions_host;
+		//staged edits; folded into the device arrays on the next constrain()
+		std::vector<int> m_pending_add_ids;
+		std::vector<Coord> m_pending_add_points;
+		std::vector<int> m_pending_remove_ids;
 
-		DeviceArray<int> m_bFixed;
-		DeviceArray<Coord> m_fixed_positions;
+		//sorted by particle id, m_anchor_num valid entries
+		DeviceArray<int> m_anchor_ids;
+		DeviceArray<Coord> m_anchor_points;
+		int m_anchor_num = 0;
 	};
 
 #ifdef PRECISION_FLOAT
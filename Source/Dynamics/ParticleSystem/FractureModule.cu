@@ -107,6 +107,147 @@ namespace PhysIKA
 		}
 	}
 
+	/*!
+	*	\brief	Cheap yield predicate: max|ratio - 1| over the stencil bounds
+	*	both J2 and |1 - I1|, so a particle below the scaled cohesion bound
+	*	cannot satisfy the Drucker-Prager criterion and is skipped.
+	*/
+	template <typename Real, typename Coord, typename NPair>
+	__global__ void PM_MarkYieldCandidates(
+		DeviceArray<int> candidates,
+		int* count,
+		DeviceArray<Real> bulk_stiffiness,
+		DeviceArray<Coord> position,
+		NeighborList<NPair> restShape,
+		Real horizon,
+		Real A,
+		Real B,
+		Real mu,
+		Real lambda,
+		Real margin)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= position.size()) return;
+
+		Real bulk_i = bulk_stiffiness[i];
+		if (bulk_i < EPSILON) return;
+
+		Coord rest_pos_i = restShape.getElement(i, 0).pos;
+		Coord cur_pos_i = position[i];
+
+		Real maxDev = Real(0);
+		int size_i = restShape.getNeighborSize(i);
+		for (int ne = 1; ne < size_i; ne++)
+		{
+			NPair np_j = restShape.getElement(i, ne);
+			Real r = (rest_pos_i - np_j.pos).norm();
+
+			if (r > 0.01*horizon)
+			{
+				Real ratio_ij = (position[np_j.index] - cur_pos_i).norm() / r;
+				Real dev = ratio_ij > Real(1) ? ratio_ij - Real(1) : Real(1) - ratio_ij;
+				maxDev = dev > maxDev ? dev : maxDev;
+			}
+		}
+
+		if (maxDev*bulk_i*(mu + B*lambda) > margin*A)
+		{
+			int slot = atomicAdd(count, 1);
+			candidates[slot] = i;
+		}
+	}
+
+	template <typename Real, typename Coord, typename NPair>
+	__global__ void PM_ComputeInvariantsQueued(
+		DeviceArray<int> candidates,
+		int* count,
+		DeviceArray<Real> bulk_stiffiness,
+		DeviceArray<Coord> position,
+		NeighborList<NPair> restShape,
+		Real horizon,
+		Real A,
+		Real B,
+		Real mu,
+		Real lambda)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= *count) return;
+
+		int i = candidates[tId];
+
+		CorrectedKernel<Real> kernSmooth;
+
+		Coord rest_pos_i = restShape.getElement(i, 0).pos;
+		Coord cur_pos_i = position[i];
+
+		Real I1_i = 0.0f;
+		Real J2_i = 0.0f;
+		int size_i = restShape.getNeighborSize(i);
+		Real total_weight = Real(0);
+		for (int ne = 1; ne < size_i; ne++)
+		{
+			NPair np_j = restShape.getElement(i, ne);
+			Coord rest_pos_j = np_j.pos;
+			int j = np_j.index;
+			Real r = (rest_pos_i - rest_pos_j).norm();
+
+			if (r > 0.01*horizon)
+			{
+				Real weight = kernSmooth.Weight(r, horizon);
+				Coord p = (position[j] - cur_pos_i);
+				Real ratio_ij = p.norm() / r;
+
+				I1_i += weight*ratio_ij;
+
+				total_weight += weight;
+			}
+		}
+
+		if (total_weight > EPSILON)
+		{
+			I1_i /= total_weight;
+		}
+		else
+		{
+			I1_i = 1.0f;
+		}
+
+		for (int ne = 1; ne < size_i; ne++)
+		{
+			NPair np_j = restShape.getElement(i, ne);
+			int j = np_j.index;
+			Coord rest_pos_j = np_j.pos;
+			Real r = (rest_pos_i - rest_pos_j).norm();
+
+			if (r > 0.01*horizon)
+			{
+				Real weight = kernSmooth.Weight(r, horizon);
+				Vector3f p = (position[j] - cur_pos_i);
+				Real ratio_ij = p.norm() / r;
+				J2_i = (ratio_ij - I1_i)*(ratio_ij - I1_i)*weight;
+			}
+		}
+		if (total_weight > EPSILON)
+		{
+			J2_i /= total_weight;
+			J2_i = sqrt(J2_i);
+		}
+		else
+		{
+			J2_i = 0.0f;
+		}
+
+		Real D1 = 1 - I1_i;
+
+		Real s_J2 = J2_i*mu*bulk_stiffiness[i];
+		Real s_D1 = D1*lambda*bulk_stiffiness[i];
+
+		if (s_J2 > A + B*s_D1)
+		{
+			bulk_stiffiness[i] = 0.0f;
+		}
+	}
+
 	template<typename TDataType>
 	void FractureModule<TDataType>::applyPlasticity()
 	{
@@ -116,6 +257,55 @@ namespace PhysIKA
 		Real A = this->computeA();
 		Real B = this->computeB();
 
+		if (m_eventDriven)
+		{
+			if (m_candidates.size() != num)
+			{
+				m_candidates.resize(num);
+			}
+
+			int* count;
+			cuSafeCall(cudaMalloc((void**)&count, sizeof(int)));
+			cuSafeCall(cudaMemset(count, 0, sizeof(int)));
+
+			PM_MarkYieldCandidates << <pDims, BLOCK_SIZE >> > (
+				m_candidates,
+				count,
+				this->m_bulkCoefs,
+				this->inPosition()->getValue(),
+				this->m_restShape.getValue(),
+				this->inHorizon()->getValue(),
+				A,
+				B,
+				this->m_mu.getValue(),
+				this->m_lambda.getValue(),
+				m_candidateMargin);
+			cuSynchronize();
+
+			int candidateNum = 0;
+			cuSafeCall(cudaMemcpy(&candidateNum, count, sizeof(int), cudaMemcpyDeviceToHost));
+
+			if (candidateNum > 0)
+			{
+				uint cDims = cudaGridSize(candidateNum, BLOCK_SIZE);
+				PM_ComputeInvariantsQueued << <cDims, BLOCK_SIZE >> > (
+					m_candidates,
+					count,
+					this->m_bulkCoefs,
+					this->inPosition()->getValue(),
+					this->m_restShape.getValue(),
+					this->inHorizon()->getValue(),
+					A,
+					B,
+					this->m_mu.getValue(),
+					this->m_lambda.getValue());
+				cuSynchronize();
+			}
+
+			cuSafeCall(cudaFree(count));
+			return;
+		}
+
 		PM_ComputeInvariants<< <pDims, BLOCK_SIZE >> > (
 			this->m_bulkCoefs,
 			this->inPosition()->getValue(),
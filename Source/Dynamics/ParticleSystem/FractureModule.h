@@ -17,6 +17,26 @@ namespace PhysIKA {
 		~FractureModule() override {};
 
 		void applyPlasticity() override;
+
+		/**
+		 * @brief Only evaluate the full yield criterion for particles whose
+		 * cheap stretch-deviation bound says they could possibly yield. The
+		 * candidates are collected into an atomic queue on the device, so
+		 * quiet steps skip the two weighted neighbor sweeps almost entirely.
+		 */
+		void setEventDriven(bool enabled) { m_eventDriven = enabled; }
+
+		/**
+		 * @brief Safety margin of the candidate predicate; lower values admit
+		 * more candidates. 1 accepts exactly the provable bound.
+		 */
+		void setCandidateMargin(Real margin) { m_candidateMargin = margin; }
+
+	private:
+		bool m_eventDriven = false;
+		Real m_candidateMargin = Real(1);
+
+		DeviceArray<int> m_candidates;
 	};
 
 #ifdef PRECISION_FLOAT
@@ -0,0 +1,171 @@
+#include <cuda_runtime.h>
+#include "GhostParticles.h"
+#include "Core/Utility.h"
+#include "Core/Utility/CudaRand.h"
+
+namespace PhysIKA
+{
+	template<typename Real, typename Coord, typename TDataType>
+	GPU_FUNC bool GP_Candidate(
+		Coord& p,
+		DistanceField3D<TDataType> df,
+		int tId,
+		Coord lo,
+		Real spacing,
+		int nx,
+		int ny,
+		Real thickness)
+	{
+		int i = tId % nx;
+		int j = (tId / nx) % ny;
+		int k = tId / (nx * ny);
+
+		//the jitter is a pure function of the candidate id, so the count
+		//and scatter passes see the same sample
+		RandNumber gen(tId);
+		Coord jitter;
+		jitter[0] = (gen.Generate() - Real(0.5)) * Real(0.5) * spacing;
+		jitter[1] = (gen.Generate() - Real(0.5)) * Real(0.5) * spacing;
+		jitter[2] = (gen.Generate() - Real(0.5)) * Real(0.5) * spacing;
+
+		p = lo + Coord(i * spacing, j * spacing, k * spacing) + jitter;
+
+		Real d;
+		Coord normal;
+		df.getDistance(p, d, normal);
+
+		return d > -thickness && d < Real(0);
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void GP_CountSamples(
+		DeviceArray<int> counts,
+		DistanceField3D<TDataType> df,
+		Coord lo,
+		Real spacing,
+		int nx,
+		int ny,
+		Real thickness)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= counts.size()) return;
+
+		Coord p;
+		counts[tId] = GP_Candidate<Real>(p, df, tId, lo, spacing, nx, ny, thickness) ? 1 : 0;
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void GP_ScatterSamples(
+		DeviceArray<Coord> position,
+		DeviceArray<int> counts,
+		DeviceArray<int> offsets,
+		DistanceField3D<TDataType> df,
+		Coord lo,
+		Real spacing,
+		int nx,
+		int ny,
+		Real thickness)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= counts.size()) return;
+
+		if (counts[tId] == 0) return;
+
+		Coord p;
+		GP_Candidate<Real>(p, df, tId, lo, spacing, nx, ny, thickness);
+
+		position[offsets[tId]] = p;
+	}
+
+	template<typename TDataType>
+	GhostParticles<TDataType>::GhostParticles()
+	{
+	}
+
+	template<typename TDataType>
+	GhostParticles<TDataType>::~GhostParticles()
+	{
+		m_counts.release();
+		m_offsets.release();
+		m_position.release();
+
+		if (m_hashReady)
+		{
+			m_hash.release();
+		}
+	}
+
+	template<typename TDataType>
+	void GhostParticles<TDataType>::sample(DistanceField3D<TDataType>& sdf, Coord lo, Coord hi, Real spacing, Real thickness)
+	{
+		int nx = (int)floor((hi[0] - lo[0]) / spacing) + 1;
+		int ny = (int)floor((hi[1] - lo[1]) / spacing) + 1;
+		int nz = (int)floor((hi[2] - lo[2]) / spacing) + 1;
+
+		int candidates = nx * ny * nz;
+		if (candidates <= 0) return;
+
+		if (m_counts.size() != candidates)
+		{
+			m_counts.resize(candidates);
+			m_offsets.resize(candidates);
+		}
+
+		cuExecute(candidates, GP_CountSamples,
+			m_counts,
+			sdf,
+			lo,
+			spacing,
+			nx,
+			ny,
+			thickness);
+
+		m_scan.exclusive(m_offsets.getDataPtr(), m_counts.getDataPtr(), candidates);
+
+		int lastOffset = 0;
+		int lastCount = 0;
+		cuSafeCall(cudaMemcpy(&lastOffset, m_offsets.getDataPtr() + candidates - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastCount, m_counts.getDataPtr() + candidates - 1, sizeof(int), cudaMemcpyDeviceToHost));
+
+		int num = lastOffset + lastCount;
+
+		m_position.resize(num);
+
+		if (num == 0) return;
+
+		cuExecute(candidates, GP_ScatterSamples,
+			m_position,
+			m_counts,
+			m_offsets,
+			sdf,
+			lo,
+			spacing,
+			nx,
+			ny,
+			thickness);
+	}
+
+	template<typename TDataType>
+	void GhostParticles<TDataType>::buildStaticHash(Real h, Coord lo, Coord hi)
+	{
+		if (m_position.size() == 0) return;
+
+		if (m_hashReady)
+		{
+			m_hash.clear();
+		}
+		else
+		{
+			m_hash.setSpace(h, lo, hi);
+			m_hashReady = true;
+		}
+
+		m_hash.construct(m_position);
+	}
+
+#ifdef PRECISION_FLOAT
+	template class GhostParticles<DataType3f>;
+#else
+	template class GhostParticles<DataType3d>;
+#endif
+}
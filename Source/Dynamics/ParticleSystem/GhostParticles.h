@@ -0,0 +1,78 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Core/Utility/Scan.h"
+#include "Framework/Topology/GridHash.h"
+#include "Framework/Topology/DistanceField3D.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	GhostParticles
+	*	\brief	Static boundary particle layers sampled from a signed
+	*	distance field on the device.
+	*
+	*	Accurate no-slip boundaries need boundary particles, which so far
+	*	had to be pre-generated offline and loaded as frozen fluid. This
+	*	helper samples them at load time directly from a DistanceField3D:
+	*	lattice candidates inside the narrow band are jittered by a
+	*	deterministic per-candidate random offset (a cheap stand-in for
+	*	Poisson-disc blue noise that avoids the grid-aligned density bias)
+	*	and kept when the signed distance falls inside the requested layer
+	*	depth. The surviving samples are compacted with the usual
+	*	count/Scan/scatter pass.
+	*
+	*	Because the samples never move, the spatial hash over them is built
+	*	exactly once; SummationDensity walks that static hash for the ghost
+	*	contribution instead of re-hashing the boundary every frame (see
+	*	SummationDensity::setGhostParticles).
+	*/
+	template<typename TDataType>
+	class GhostParticles
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		GhostParticles();
+		~GhostParticles();
+
+		/*!
+		*	\brief	Sample ghost layers inside the solid region of sdf.
+		*
+		*	Candidates lie on a lattice with the given spacing covering
+		*	[lo, hi]; a candidate survives when its signed distance is in
+		*	(-thickness, 0), i.e. within thickness of the boundary on the
+		*	solid side. thickness should cover the smoothing length so the
+		*	kernel support of near-wall fluid particles is filled.
+		*/
+		void sample(DistanceField3D<TDataType>& sdf, Coord lo, Coord hi, Real spacing, Real thickness);
+
+		/*!
+		*	\brief	Build the static hash over the samples; h must not be
+		*	smaller than the smoothing length of the queries. Called once
+		*	after sample().
+		*/
+		void buildStaticHash(Real h, Coord lo, Coord hi);
+
+		DeviceArray<Coord>& getPosition() { return m_position; }
+		GridHash<TDataType>& getHash() { return m_hash; }
+
+		int size() { return m_position.size(); }
+
+	private:
+		DeviceArray<int> m_counts;
+		DeviceArray<int> m_offsets;
+		Scan m_scan;
+
+		DeviceArray<Coord> m_position;
+
+		GridHash<TDataType> m_hash;
+		bool m_hashReady = false;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class GhostParticles<DataType3f>;
+#else
+	template class GhostParticles<DataType3d>;
+#endif
+}
@@ -7,6 +7,8 @@ namespace PhysIKA
 	GranularModule<TDataType>::GranularModule()
 		: ElastoplasticityModule<TDataType>()
 	{
+		//sand piles are the high-contention case the aggregated scatter targets
+		this->setWarpAggregatedScatter(true);
 	}
 
 
@@ -1,6 +1,7 @@
 //#include "Core/Utilities/template_functions.h"
 #include "Helmholtz.h"
 #include "Framework/Framework/Node.h"
+#include "Framework/Framework/FrameGovernor.h"
 #include <string>
 #include "Kernel.h"
 #include "SummationDensity.h"
@@ -108,7 +109,7 @@ namespace PhysIKA
 		return w / r / r;
 	}
 
-	template <typename Real, typename Coord>
+	template <typename Real, typename Coord, typename TKernel = SpikyKernel<Real>>
 		__global__ void H_ComputeGradient(
 			DeviceArray<Coord> grads,
 			DeviceArray<Real> rhoArr,
@@ -126,7 +127,7 @@ namespace PhysIKA
 		Real a2 = bulk;
 		Real a3 = surfaceTension;
 
-		SpikyKernel<Real> kern;
+		TKernel kern;
 
 		Real w1 = 1.0f*a1;
 		Real w2 = 0.005f*(rhoArr[pId] - 1000.0f) / (1000.0f)*a2;
@@ -244,11 +245,27 @@ namespace PhysIKA
 		, m_kappa(0.0)
 	{
 		m_bSetup = false;
+
+		//smoothing is cosmetic next to the pressure solve, so its iterations
+		//are a mid-priority knob for the frame-time governor
+		FrameGovernor::getInstance().registerKnob(this, 30, "Helmholtz iterations",
+			[this]() {
+				if (m_maxIteration - m_governor_iter_steps <= 1) return false;
+				m_governor_iter_steps++;
+				return true;
+			},
+			[this]() {
+				if (m_governor_iter_steps == 0) return false;
+				m_governor_iter_steps--;
+				return true;
+			});
 	}
 
 	template<typename TDataType>
 	Helmholtz<TDataType>::~Helmholtz()
 	{
+		FrameGovernor::getInstance().removeKnobs(this);
+
 		m_bufPos.release();
 		m_originPos.release();
 	}
@@ -476,8 +493,12 @@ namespace PhysIKA
 
 		uint pDims = cudaGridSize(num, BLOCK_SIZE);
 
+		//honor setIterationNumber (the loop count used to be hard-coded to
+		//five) minus any iterations dropped by the frame-time governor
+		int maxIt = m_maxIteration - m_governor_iter_steps < 1 ? 1 : m_maxIteration - m_governor_iter_steps;
+
 		int it = 0;
-		while (it < 5)
+		while (it < maxIt)
 		{
 			//printf("Iteration %d: \n", it);
 
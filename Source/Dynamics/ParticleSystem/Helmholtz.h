@@ -54,6 +54,9 @@ namespace PhysIKA {
 		Real m_smoothingLength;
 		Real m_referenceRho;
 
+		//iterations dropped by the frame-time governor; see FrameGovernor
+		int m_governor_iter_steps = 0;
+
 		Real m_scale;
 		Real m_lambda;
 		Real m_kappa;
@@ -0,0 +1,64 @@
+#include "HostBoundaryConstraint.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(HostBoundaryConstraint, TDataType)
+
+	template<typename TDataType>
+	HostBoundaryConstraint<TDataType>::HostBoundaryConstraint()
+		: ConstraintModule()
+		, m_lo(0)
+		, m_hi(1)
+		, m_friction(1)
+	{
+	}
+
+	template<typename TDataType>
+	bool HostBoundaryConstraint<TDataType>::constrain()
+	{
+		if (this->inPosition()->isEmpty())
+		{
+			return false;
+		}
+
+		HostArray<Coord>& posArr = this->inPosition()->getValue();
+		HostArray<Coord>& velArr = this->inVelocity()->getValue();
+
+		int num = posArr.size();
+
+#pragma omp parallel for
+		for (int pId = 0; pId < num; pId++)
+		{
+			Coord pos = posArr[pId];
+			Coord vel = velArr[pId];
+
+			bool hit = false;
+			for (int c = 0; c < Coord::dims(); c++)
+			{
+				if (pos[c] < m_lo[c])
+				{
+					pos[c] = m_lo[c];
+					vel[c] = vel[c] < 0 ? 0 : vel[c];
+					hit = true;
+				}
+				if (pos[c] > m_hi[c])
+				{
+					pos[c] = m_hi[c];
+					vel[c] = vel[c] > 0 ? 0 : vel[c];
+					hit = true;
+				}
+			}
+
+			if (hit)
+			{
+				vel *= m_friction;
+			}
+
+			posArr[pId] = pos;
+			velArr[pId] = vel;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Framework/Framework/ModuleConstraint.h"
+#include "Framework/Framework/FieldArray.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	HostBoundaryConstraint
+	*	\brief	Axis-aligned box boundary on the CPU.
+	*
+	*	Host-side companion of the particle boundary for scenes stepped with
+	*	HostParticleIntegrator: particles are clamped to the box and the
+	*	velocity component along the violated face normal is removed, with
+	*	an optional tangential friction factor. The per-particle loop runs
+	*	under OpenMP.
+	*/
+	template<typename TDataType>
+	class HostBoundaryConstraint : public ConstraintModule
+	{
+		DECLARE_CLASS_1(HostBoundaryConstraint, TDataType)
+
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		HostBoundaryConstraint();
+		~HostBoundaryConstraint() override {};
+
+		bool constrain() override;
+
+		void setBox(Coord lo, Coord hi)
+		{
+			m_lo = lo;
+			m_hi = hi;
+		}
+
+		/**
+		 * @brief Fraction of the tangential velocity kept on contact, 1 by
+		 * default (free slip).
+		 */
+		void setTangentialFriction(Real friction) { m_friction = friction; }
+
+	public:
+
+		/**
+		* @brief Position
+		* Particle position
+		*/
+		DEF_EMPTY_IN_ARRAY(Position, Coord, DeviceType::CPU, "Particle position");
+
+		/**
+		* @brief Velocity
+		* Particle velocity
+		*/
+		DEF_EMPTY_IN_ARRAY(Velocity, Coord, DeviceType::CPU, "Particle velocity");
+
+	private:
+		Coord m_lo;
+		Coord m_hi;
+		Real m_friction;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class HostBoundaryConstraint<DataType3f>;
+#else
+	template class HostBoundaryConstraint<DataType3d>;
+#endif
+}
@@ -0,0 +1,101 @@
+#include "HostParticleIntegrator.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Framework/SceneGraph.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(HostParticleIntegrator, TDataType)
+
+	template<typename TDataType>
+	HostParticleIntegrator<TDataType>::HostParticleIntegrator()
+		: NumericalIntegrator()
+	{
+	}
+
+	template<typename TDataType>
+	void HostParticleIntegrator<TDataType>::begin()
+	{
+		if (this->inForceDensity()->isEmpty())
+		{
+			return;
+		}
+
+		HostArray<Coord>& force = this->inForceDensity()->getValue();
+		Real* f = (Real*)force.getDataPtr();
+		int total = Coord::dims() * force.size();
+
+#pragma omp parallel for simd
+		for (int k = 0; k < total; k++)
+		{
+			f[k] = Real(0);
+		}
+	}
+
+	template<typename TDataType>
+	bool HostParticleIntegrator<TDataType>::updateVelocity()
+	{
+		Real dt = getParent()->getDt();
+		Coord gravity = SceneGraph::getInstance().getGravity();
+
+		HostArray<Coord>& velArr = this->inVelocity()->getValue();
+		HostArray<Coord>& forceArr = this->inForceDensity()->getValue();
+
+		int num = velArr.size();
+
+		//contiguous scalar view: this loop vectorizes
+		Real* v = (Real*)velArr.getDataPtr();
+		Real* f = (Real*)forceArr.getDataPtr();
+		int total = Coord::dims() * num;
+
+#pragma omp parallel for simd
+		for (int k = 0; k < total; k++)
+		{
+			v[k] += dt * f[k];
+		}
+
+		Coord gdt = gravity * dt;
+#pragma omp parallel for
+		for (int pId = 0; pId < num; pId++)
+		{
+			velArr[pId] += gdt;
+		}
+
+		return true;
+	}
+
+	template<typename TDataType>
+	bool HostParticleIntegrator<TDataType>::updatePosition()
+	{
+		Real dt = getParent()->getDt();
+
+		HostArray<Coord>& posArr = this->inPosition()->getValue();
+		HostArray<Coord>& velArr = this->inVelocity()->getValue();
+
+		Real* p = (Real*)posArr.getDataPtr();
+		Real* v = (Real*)velArr.getDataPtr();
+		int total = Coord::dims() * posArr.size();
+
+#pragma omp parallel for simd
+		for (int k = 0; k < total; k++)
+		{
+			p[k] += dt * v[k];
+		}
+
+		return true;
+	}
+
+	template<typename TDataType>
+	bool HostParticleIntegrator<TDataType>::integrate()
+	{
+		if (this->inPosition()->isEmpty())
+		{
+			return false;
+		}
+
+		updateVelocity();
+		updatePosition();
+
+		return true;
+	}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Framework/Framework/NumericalIntegrator.h"
+#include "Framework/Framework/FieldVar.h"
+#include "Framework/Framework/FieldArray.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	HostParticleIntegrator
+	*	\brief	Semi-implicit Euler integration on the CPU.
+	*
+	*	Host-side counterpart of ParticleIntegrator operating on
+	*	Array<T, DeviceType::CPU> state. The loops run over the flat scalar
+	*	components under OpenMP so the compiler can vectorize them, which
+	*	lets small scenes and CI machines without a GPU step particle state.
+	*/
+	template<typename TDataType>
+	class HostParticleIntegrator : public NumericalIntegrator
+	{
+		DECLARE_CLASS_1(HostParticleIntegrator, TDataType)
+
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		HostParticleIntegrator();
+		~HostParticleIntegrator() override {};
+
+		void begin() override;
+
+		bool integrate() override;
+
+		bool updateVelocity();
+		bool updatePosition();
+
+	public:
+
+		/**
+		* @brief Position
+		* Particle position
+		*/
+		DEF_EMPTY_IN_ARRAY(Position, Coord, DeviceType::CPU, "Particle position");
+
+		/**
+		* @brief Velocity
+		* Particle velocity
+		*/
+		DEF_EMPTY_IN_ARRAY(Velocity, Coord, DeviceType::CPU, "Particle velocity");
+
+		/**
+		* @brief Force density
+		* Force density on each particle
+		*/
+		DEF_EMPTY_IN_ARRAY(ForceDensity, Coord, DeviceType::CPU, "Force density on each particle");
+	};
+
+#ifdef PRECISION_FLOAT
+	template class HostParticleIntegrator<DataType3f>;
+#else
+	template class HostParticleIntegrator<DataType3d>;
+#endif
+}
@@ -174,6 +174,96 @@ namespace PhysIKA
 		position[pId] = (old_position[pId] + delta_position[pId]) / (1.0 + delta_weights[pId]);
 	}
 
+	//residual of the linearized projective system at the current positions:
+	//r = (x_old + b) - (1 + W) x, so the explicit Jacobi update is exactly the
+	//diagonal solve of the same system
+	template <typename Real, typename Coord>
+	__global__ void HM_ComputeResidual(
+		DeviceArray<Coord> residual,
+		DeviceArray<Coord> position,
+		DeviceArray<Coord> old_position,
+		DeviceArray<Coord> delta_position,
+		DeviceArray<Real> delta_weights)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= position.size()) return;
+
+		residual[pId] = old_position[pId] + delta_position[pId] - (1.0 + delta_weights[pId])*position[pId];
+	}
+
+	/*!
+	*	\brief	Matrix-free Hessian-vector product over the rest-shape stencil:
+	*	diagonal (1 + W) plus the spring coupling k_ij (v_i - v_j). The pair
+	*	stiffness is recomputed in place from the kernel weights; the
+	*	strain-dependent basis factors are dropped (Gauss-Newton), the outer
+	*	Newton loop accounts for them.
+	*/
+	template <typename Real, typename Coord, typename NPair>
+	__global__ void HM_HessianVec(
+		DeviceArray<Coord> Av,
+		DeviceArray<Coord> v,
+		DeviceArray<Real> delta_weights,
+		DeviceArray<Real> bulkCoefs,
+		NeighborList<NPair> restShapes,
+		Real horizon,
+		Real mu,
+		Real lambda)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= v.size()) return;
+
+		CorrectedKernel<Real> g_weightKernel;
+
+		NPair np_i = restShapes.getElement(pId, 0);
+		Coord rest_i = np_i.pos;
+		int size_i = restShapes.getNeighborSize(pId);
+
+		Coord v_i = v[pId];
+		Real bulk_i = bulkCoefs[pId];
+
+		Coord acc = (1.0 + delta_weights[pId])*v_i;
+		for (int ne = 0; ne < size_i; ne++)
+		{
+			NPair np_j = restShapes.getElement(pId, ne);
+			int j = np_j.index;
+			Real r = (np_j.pos - rest_i).norm();
+
+			if (r > 0.01f*horizon)
+			{
+				Real k_ij = (mu + lambda)*bulk_i*g_weightKernel.WeightRR(r, horizon);
+				acc += k_ij*(v_i - v[j]);
+			}
+		}
+
+		Av[pId] = acc;
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void HM_PairwiseDot(
+		DeviceArray<Real> dots,
+		DeviceArray<Coord> v1,
+		DeviceArray<Coord> v2)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= dots.size()) return;
+
+		dots[pId] = v1[pId].dot(v2[pId]);
+	}
+
+	//z = alpha * x + y for Coord arrays; Function2Pt only covers scalars
+	template <typename Real, typename Coord>
+	__global__ void HM_Axpy(
+		DeviceArray<Coord> z,
+		DeviceArray<Coord> x,
+		DeviceArray<Coord> y,
+		Real alpha)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= z.size()) return;
+
+		z[pId] = alpha*x[pId] + y[pId];
+	}
+
 	template<typename TDataType>
 	void HyperelasticityModule<TDataType>::enforceElasticity()
 	{
@@ -228,6 +318,151 @@ namespace PhysIKA
 	}
 
 
+	template<typename TDataType>
+	void HyperelasticityModule<TDataType>::solveImplicit()
+	{
+		int num = this->inPosition()->getElementCount();
+		uint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+		if (m_cg_r.size() != num)
+		{
+			m_cg_r.resize(num);
+			m_cg_p.resize(num);
+			m_cg_q.resize(num);
+			m_dots.resize(num);
+		}
+		if (m_dotReduce == NULL)
+		{
+			m_dotReduce = Reduction<Real>::Create(num);
+		}
+
+		auto dot = [&](DeviceArray<Coord>& v1, DeviceArray<Coord>& v2) -> Real
+		{
+			HM_PairwiseDot << <pDims, BLOCK_SIZE >> > (m_dots, v1, v2);
+			return m_dotReduce->accumulate(m_dots.getDataPtr(), num);
+		};
+
+		int newton = 0;
+		while (newton < m_newtonIter)
+		{
+			//refresh the projective targets and pair weights at the current iterate
+			this->m_displacement.reset();
+			this->m_weights.reset();
+
+			switch (m_energyType)
+			{
+			case Linear:
+				HM_EnforceElasticity << <pDims, BLOCK_SIZE >> > (
+					this->m_displacement,
+					this->m_weights,
+					this->m_bulkCoefs,
+					this->m_invK,
+					this->inPosition()->getValue(),
+					this->m_restShape.getValue(),
+					this->inHorizon()->getValue(),
+					this->m_mu.getValue(),
+					this->m_lambda.getValue(),
+					ConstantFunc<Real>());
+				break;
+
+			case Quadratic:
+				HM_EnforceElasticity << <pDims, BLOCK_SIZE >> > (
+					this->m_displacement,
+					this->m_weights,
+					this->m_bulkCoefs,
+					this->m_invK,
+					this->inPosition()->getValue(),
+					this->m_restShape.getValue(),
+					this->inHorizon()->getValue(),
+					this->m_mu.getValue(),
+					this->m_lambda.getValue(),
+					QuadraticFunc<Real>());
+				break;
+
+			default:
+				break;
+			}
+			cuSynchronize();
+
+			HM_ComputeResidual << <pDims, BLOCK_SIZE >> > (
+				m_cg_r,
+				this->inPosition()->getValue(),
+				this->m_position_old,
+				this->m_displacement,
+				this->m_weights);
+			cuSynchronize();
+
+			//CG on the linearized system, solution accumulated into the positions
+			Function1Pt::copy(m_cg_p, m_cg_r);
+			Real rr = dot(m_cg_r, m_cg_r);
+
+			int itor = 0;
+			while (itor < m_cgIter && rr > EPSILON)
+			{
+				HM_HessianVec << <pDims, BLOCK_SIZE >> > (
+					m_cg_q,
+					m_cg_p,
+					this->m_weights,
+					this->m_bulkCoefs,
+					this->m_restShape.getValue(),
+					this->inHorizon()->getValue(),
+					this->m_mu.getValue(),
+					this->m_lambda.getValue());
+				cuSynchronize();
+
+				Real pq = dot(m_cg_p, m_cg_q);
+				if (pq < EPSILON) break;
+
+				Real alpha = rr / pq;
+
+				HM_Axpy << <pDims, BLOCK_SIZE >> > (
+					this->inPosition()->getValue(),
+					m_cg_p,
+					this->inPosition()->getValue(),
+					alpha);
+				HM_Axpy << <pDims, BLOCK_SIZE >> > (
+					m_cg_r,
+					m_cg_q,
+					m_cg_r,
+					-alpha);
+				cuSynchronize();
+
+				Real rr_old = rr;
+				rr = dot(m_cg_r, m_cg_r);
+
+				HM_Axpy << <pDims, BLOCK_SIZE >> > (
+					m_cg_p,
+					m_cg_p,
+					m_cg_r,
+					rr / rr_old);
+				cuSynchronize();
+
+				itor++;
+			}
+
+			newton++;
+		}
+	}
+
+	template<typename TDataType>
+	void HyperelasticityModule<TDataType>::solveElasticity()
+	{
+		if (m_implicit)
+		{
+			Function1Pt::copy(this->m_position_old, this->inPosition()->getValue());
+
+			this->computeInverseK();
+
+			this->solveImplicit();
+
+			this->updateVelocity();
+		}
+		else
+		{
+			ElasticityModule<TDataType>::solveElasticity();
+		}
+	}
+
 #ifdef PRECISION_FLOAT
 	template class HyperelasticityModule<DataType3f>;
 #else
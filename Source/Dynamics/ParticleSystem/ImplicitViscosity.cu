@@ -1,6 +1,7 @@
 #include "ImplicitViscosity.h"
 #include "Core/Utility.h"
 #include "Framework/Framework/Node.h"
+#include "Framework/Framework/DeviceContext.h"
 #include "Framework/Topology/FieldNeighbor.h"
 
 namespace PhysIKA
@@ -29,24 +30,40 @@ namespace PhysIKA
 		Real dt)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		//Stage the block's positions and ping-pong velocities; for spatially
+		//sorted particles most neighbor reads stay inside the block's range
+		//and come from shared memory.
+		__shared__ Coord shPos[BLOCK_SIZE];
+		__shared__ Coord shVel[BLOCK_SIZE];
+		int blockStart = blockIdx.x * blockDim.x;
+		if (pId < posArr.size())
+		{
+			shPos[threadIdx.x] = posArr[pId];
+			shVel[threadIdx.x] = velArr[pId];
+		}
+		__syncthreads();
+
 		if (pId >= posArr.size()) return;
 
 		Real r;
 		Coord dv_i(0);
-		Coord pos_i = posArr[pId];
-		Coord vel_i = velArr[pId];
+		Coord pos_i = shPos[threadIdx.x];
+		Coord vel_i = shVel[threadIdx.x];
 		Real totalWeight = 0.0f;
 		int nbSize = neighbors.getNeighborSize(pId);
 		for (int ne = 0; ne < nbSize; ne++)
 		{
 			int j = neighbors.getElement(pId, ne);
-			r = (pos_i - posArr[j]).norm();
+			bool local = (j >= blockStart && j < blockStart + BLOCK_SIZE);
+			Coord pos_j = local ? shPos[j - blockStart] : posArr[j];
+			r = (pos_i - pos_j).norm();
 
 			if (r > EPSILON)
 			{
 				Real weight = VB_VisWeight(r, smoothingLength);
 				totalWeight += weight;
-				dv_i += weight * velArr[j];
+				dv_i += weight * (local ? shVel[j - blockStart] : velArr[j]);
 			}
 		}
 
@@ -93,6 +110,306 @@ namespace PhysIKA
 	{
 		m_velOld.release();
 		m_velBuf.release();
+		m_residual.release();
+		m_coarseErr.release();
+		m_coarseErrBuf.release();
+		m_velPrev.release();
+
+		if (m_mgReduce != NULL)
+		{
+			delete m_mgReduce;
+		}
+	}
+
+	/*!
+	*	\brief	Residual of the implicit viscosity equation under the current
+	*	velocities: the Jacobi update each particle would take, minus where it
+	*	already is. Smooth components of this field are what plain sweeps
+	*	remove slowest.
+	*/
+	template<typename Real, typename Coord>
+	__global__ void IV_ComputeResidual(
+		DeviceArray<Coord> residual,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		DeviceArray<Coord> velOld,
+		DeviceArray<Coord> velArr,
+		Real viscosity,
+		Real smoothingLength,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+		Coord dv_i(0);
+		Real totalWeight = 0.0f;
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Real r = (pos_i - posArr[j]).norm();
+			if (r > EPSILON)
+			{
+				Real weight = VB_VisWeight(r, smoothingLength);
+				totalWeight += weight;
+				dv_i += weight * velArr[j];
+			}
+		}
+
+		Real b = dt*viscosity / smoothingLength;
+		b = totalWeight < EPSILON ? 0.0f : b;
+		totalWeight = totalWeight < EPSILON ? 1.0f : totalWeight;
+		dv_i /= totalWeight;
+
+		residual[pId] = velOld[pId] / (1.0f + b) + dv_i*b / (1.0f + b) - velArr[pId];
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void IV_RestrictResidual(
+		DeviceArray<Coord> coarseErr,
+		DeviceArray<Coord> residual,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		Real smoothingLength,
+		int stride)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		if (pId % stride != 0)
+		{
+			coarseErr[pId] = Coord(0);
+			return;
+		}
+
+		Coord pos_i = posArr[pId];
+		Coord acc = residual[pId];
+		Real totalWeight = Real(1);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Real r = (pos_i - posArr[j]).norm();
+			if (r > EPSILON)
+			{
+				Real weight = VB_VisWeight(r, smoothingLength);
+				acc += weight * residual[j];
+				totalWeight += weight;
+			}
+		}
+
+		coarseErr[pId] = acc / totalWeight;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void IV_CoarseSmooth(
+		DeviceArray<Coord> errNew,
+		DeviceArray<Coord> errOld,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		Real smoothingLength,
+		int stride)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		if (pId % stride != 0)
+		{
+			errNew[pId] = Coord(0);
+			return;
+		}
+
+		Coord pos_i = posArr[pId];
+		Coord acc(0);
+		Real totalWeight = Real(0);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			if (j % stride != 0) continue;
+
+			Real r = (pos_i - posArr[j]).norm();
+			if (r > EPSILON)
+			{
+				Real weight = VB_VisWeight(r, smoothingLength);
+				acc += weight * errOld[j];
+				totalWeight += weight;
+			}
+		}
+
+		//damped Jacobi on the coarse subset
+		Coord avg = totalWeight > EPSILON ? acc / totalWeight : errOld[pId];
+		errNew[pId] = Real(0.5)*errOld[pId] + Real(0.5)*avg;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void IV_Prolongate(
+		DeviceArray<Coord> velArr,
+		DeviceArray<Coord> coarseErr,
+		DeviceArray<Coord> posArr,
+		NeighborList<int> neighbors,
+		Real smoothingLength,
+		int stride)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+		Coord acc(0);
+		Real totalWeight = Real(0);
+
+		if (pId % stride == 0)
+		{
+			acc = coarseErr[pId];
+			totalWeight = Real(1);
+		}
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			if (j % stride != 0) continue;
+
+			Real r = (pos_i - posArr[j]).norm();
+			if (r > EPSILON)
+			{
+				Real weight = VB_VisWeight(r, smoothingLength);
+				acc += weight * coarseErr[j];
+				totalWeight += weight;
+			}
+		}
+
+		if (totalWeight > EPSILON)
+		{
+			velArr[pId] += acc / totalWeight;
+		}
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void IV_ComputeDiff(
+		DeviceArray<Coord> diff,
+		DeviceArray<Coord> vel,
+		DeviceArray<Coord> velPrev)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= diff.size()) return;
+
+		diff[pId] = vel[pId] - velPrev[pId];
+	}
+
+	template<typename TDataType>
+	void ImplicitViscosity<TDataType>::takeOneJacobiSweep(Real vis, Real dt)
+	{
+		int num = m_position.getElementCount();
+		cuint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+		Function1Pt::copy(m_velBuf, m_velocity.getValue());
+		K_ApplyViscosity << <pDims, BLOCK_SIZE >> > (
+			m_velocity.getValue(),
+			m_position.getValue(),
+			m_neighborhood.getValue(),
+			m_velOld,
+			m_velBuf,
+			vis,
+			m_smoothingLength.getValue(),
+			dt);
+		cuSynchronize();
+	}
+
+	template<typename TDataType>
+	bool ImplicitViscosity<TDataType>::solveMultigrid(Real vis, Real dt)
+	{
+		int num = m_position.getElementCount();
+		cuint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+		if (m_residual.size() != num)
+		{
+			m_residual.resize(num);
+			m_coarseErr.resize(num);
+			m_coarseErrBuf.resize(num);
+			m_velPrev.resize(num);
+		}
+		if (m_mgReduce == NULL)
+		{
+			m_mgReduce = Reduction<Real>::Create(3 * num);
+		}
+
+		Function1Pt::copy(m_velOld, m_velocity.getValue());
+
+		Real h = m_smoothingLength.getValue();
+
+		for (int cycle = 0; cycle < m_mgMaxCycles; cycle++)
+		{
+			Function1Pt::copy(m_velPrev, m_velocity.getValue());
+
+			//pre-smoothing knocks out the high-frequency error
+			takeOneJacobiSweep(vis, dt);
+			takeOneJacobiSweep(vis, dt);
+
+			IV_ComputeResidual << <pDims, BLOCK_SIZE >> > (
+				m_residual,
+				m_position.getValue(),
+				m_neighborhood.getValue(),
+				m_velOld,
+				m_velocity.getValue(),
+				vis,
+				h,
+				dt);
+			cuSynchronize();
+
+			IV_RestrictResidual << <pDims, BLOCK_SIZE >> > (
+				m_coarseErr,
+				m_residual,
+				m_position.getValue(),
+				m_neighborhood.getValue(),
+				h,
+				m_mgStride);
+			cuSynchronize();
+
+			for (int t = 0; t < 4; t++)
+			{
+				Function1Pt::copy(m_coarseErrBuf, m_coarseErr);
+				IV_CoarseSmooth << <pDims, BLOCK_SIZE >> > (
+					m_coarseErr,
+					m_coarseErrBuf,
+					m_position.getValue(),
+					m_neighborhood.getValue(),
+					h,
+					m_mgStride);
+				cuSynchronize();
+			}
+
+			IV_Prolongate << <pDims, BLOCK_SIZE >> > (
+				m_velocity.getValue(),
+				m_coarseErr,
+				m_position.getValue(),
+				m_neighborhood.getValue(),
+				h,
+				m_mgStride);
+			cuSynchronize();
+
+			takeOneJacobiSweep(vis, dt);
+			takeOneJacobiSweep(vis, dt);
+
+			//infinity norm of the per-cycle velocity change
+			IV_ComputeDiff << <pDims, BLOCK_SIZE >> > (
+				m_residual,
+				m_velocity.getValue(),
+				m_velPrev);
+			cuSynchronize();
+
+			Real vmax = m_mgReduce->maximum((Real*)m_residual.getDataPtr(), 3 * num);
+			Real vmin = m_mgReduce->minimum((Real*)m_residual.getDataPtr(), 3 * num);
+			vmax = vmax > -vmin ? vmax : -vmin;
+
+			if (vmax < m_mgTolerance)
+			{
+				break;
+			}
+		}
+
+		return true;
 	}
 
 	template<typename TDataType>
@@ -103,26 +420,69 @@ namespace PhysIKA
 		{
 			cuint pDims = cudaGridSize(num, BLOCK_SIZE);
 
-			m_velOld.resize(num);
-			m_velBuf.resize(num);
+			if (m_velOld.size() != num)
+			{
+				m_velOld.resize(num);
+				m_velBuf.resize(num);
+			}
 
 			Real vis = m_viscosity.getValue();
 			Real dt = getParent()->getDt();
-			Function1Pt::copy(m_velOld, m_velocity.getValue());
-			for (int t = 0; t < m_maxInteration; t++)
+
+			if (m_useMultigrid)
 			{
-				Function1Pt::copy(m_velBuf, m_velocity.getValue());
-				cuExecute(num, K_ApplyViscosity,
-					m_velocity.getValue(),
-					m_position.getValue(),
-					m_neighborhood.getValue(),
-					m_velOld,
-					m_velBuf,
-					vis,
-					m_smoothingLength.getValue(),
-					dt);
+				return solveMultigrid(vis, dt);
+			}
+
+			//The graph bakes in raw buffer pointers, so a reallocation of the
+			//velocity, position or neighbor buffers invalidates it as well.
+			void* velPtr = m_velocity.getValue().getDataPtr();
+			void* posPtr = m_position.getValue().getDataPtr();
+			void* nbrPtr = m_neighborhood.getValue().getElements().getDataPtr();
+			if (num != m_graphNum || dt != m_graphDt || vis != m_graphVis ||
+				m_maxInteration != m_graphIters ||
+				velPtr != m_graphVelPtr || posPtr != m_graphPosPtr || nbrPtr != m_graphNbrPtr)
+			{
+				m_graph.invalidate();
+				m_graphNum = num;
+				m_graphDt = dt;
+				m_graphVis = vis;
+				m_graphIters = m_maxInteration;
+				m_graphVelPtr = velPtr;
+				m_graphPosPtr = posPtr;
+				m_graphNbrPtr = nbrPtr;
 			}
 
+			//The Jacobi sweeps only touch the velocity buffers; run them on a
+			//pooled context stream so the per-launch host synchronization of
+			//cuExecute disappears and an independent module can overlap them.
+			auto context = getParent()->getContext();
+			cudaStream_t stream = context->getStream(1);
+			context->streamWaitDefault(1);
+
+			//Record the whole sweep sequence once and replay it on subsequent
+			//steps; ~2x m_maxInteration launches collapse into a single submit.
+			if (m_graph.beginCapture(stream))
+			{
+				Function1Pt::copyAsync(m_velOld, m_velocity.getValue(), stream);
+				for (int t = 0; t < m_maxInteration; t++)
+				{
+					Function1Pt::copyAsync(m_velBuf, m_velocity.getValue(), stream);
+					cuExecuteAsync(stream, num, K_ApplyViscosity,
+						m_velocity.getValue(),
+						m_position.getValue(),
+						m_neighborhood.getValue(),
+						m_velOld,
+						m_velBuf,
+						vis,
+						m_smoothingLength.getValue(),
+						dt);
+				}
+				m_graph.endCapture(stream);
+			}
+			m_graph.launch(stream);
+			context->streamSync(1);
+
 			return true;
 		}
 	}
@@ -146,4 +506,10 @@ namespace PhysIKA
 	}
 
 
+
+#ifdef PRECISION_FLOAT
+	template class ImplicitViscosity<DataType3f>;
+#else
+	template class ImplicitViscosity<DataType3d>;
+#endif
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "Framework/Framework/FieldVar.h"
 #include "Framework/Framework/FieldArray.h"
 #include "Framework/Topology/FieldNeighbor.h"
+#include "Framework/Framework/CudaGraph.h"
+#include "Core/Utility/Reduction.h"
 
 namespace PhysIKA {
 	template<typename TDataType>
@@ -21,6 +23,23 @@ namespace PhysIKA {
 
 		void setViscosity(Real mu);
 
+		/**
+		 * @brief Replace the fixed Jacobi sweeps with a two-level V-cycle:
+		 * fine pre-smoothing, residual restriction onto a coarse particle
+		 * subset (every coarseStride-th particle, coupled through the existing
+		 * neighbor list), error smoothing on that subset, kernel-weighted
+		 * prolongation and post-smoothing. Cycles stop once the velocity
+		 * change per cycle falls below the tolerance, so stiff (honey-like)
+		 * fluids converge in a few cycles instead of dozens of sweeps.
+		 */
+		void setMultigrid(bool enabled, Real tolerance = Real(1e-4), int maxCycles = 10, int coarseStride = 8)
+		{
+			m_useMultigrid = enabled;
+			m_mgTolerance = tolerance;
+			m_mgMaxCycles = maxCycles;
+			m_mgStride = coarseStride;
+		}
+
 
 	protected:
 		bool initializeImpl() override;
@@ -35,18 +54,43 @@ namespace PhysIKA {
 		NeighborField<int> m_neighborhood;
 
 	private:
+		void takeOneJacobiSweep(Real vis, Real dt);
+		bool solveMultigrid(Real vis, Real dt);
+
 		int m_maxInteration;
 
+		bool m_useMultigrid = false;
+		Real m_mgTolerance = Real(1e-4);
+		int m_mgMaxCycles = 10;
+		int m_mgStride = 8;
+
 		DeviceArray<Coord> m_velOld;
 		DeviceArray<Coord> m_velBuf;
 
-		
+		DeviceArray<Coord> m_residual;
+		DeviceArray<Coord> m_coarseErr;
+		DeviceArray<Coord> m_coarseErrBuf;
+		DeviceArray<Coord> m_velPrev;
+
+		Reduction<Real>* m_mgReduce = NULL;
+
+		//Recorded Jacobi sweep sequence; stale whenever the particle count,
+		//the iteration count, a baked-in scalar parameter or one of the
+		//captured buffer addresses changes.
+		CudaGraph m_graph;
+		int m_graphNum = -1;
+		int m_graphIters = -1;
+		Real m_graphDt = Real(-1);
+		Real m_graphVis = Real(-1);
+		void* m_graphVelPtr = nullptr;
+		void* m_graphPosPtr = nullptr;
+		void* m_graphNbrPtr = nullptr;
 	};
 
 
 #ifdef PRECISION_FLOAT
-	template class ImplicitViscosity<DataType3f>;
+	extern template class ImplicitViscosity<DataType3f>;
 #else
-	template class ImplicitViscosity<DataType3d>;
+	extern template class ImplicitViscosity<DataType3d>;
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "IpcExporter.h"
+#include "Framework/Framework/Field.h"
+#include "Framework/Framework/Log.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS(IpcExporter)
+
+	IpcExporter::IpcExporter()
+		: IOModule()
+	{
+	}
+
+	IpcExporter::~IpcExporter()
+	{
+	}
+
+	void IpcExporter::addBuffer(std::string name, Field* field)
+	{
+		m_buffers.push_back(std::make_pair(name, field));
+	}
+
+	bool IpcExporter::execute()
+	{
+		if (m_buffers.empty())
+		{
+			return true;
+		}
+
+		if (!m_created)
+		{
+			if (!m_channel.create(m_channel_name))
+			{
+				Log::sendMessage(Log::Error, "IpcExporter: cannot create channel " + m_channel_name);
+				return false;
+			}
+			m_created = true;
+		}
+
+		for (size_t i = 0; i < m_buffers.size(); i++)
+		{
+			Field* field = m_buffers[i].second;
+
+			//array fields only: their dump goes through cudaMemcpy, which
+			//accepts the device-side mirror as destination
+			size_t elementBytes = field->getElementBytes();
+			if (elementBytes == 0 || field->isEmpty() || field->getClassName() != std::string("ArrayBuffer"))
+			{
+				continue;
+			}
+
+			void* devPtr = m_channel.ensureBuffer(m_buffers[i].first, (std::uint32_t)elementBytes, (std::uint64_t)field->getElementCount());
+			if (devPtr == nullptr)
+			{
+				continue;
+			}
+
+			//device-to-device through the checkpoint dump path: dst is a
+			//device pointer and cudaMemcpyDefault resolves the direction
+			field->dumpRawData(devPtr);
+		}
+
+		m_channel.publishFrame();
+
+		return true;
+	}
+}
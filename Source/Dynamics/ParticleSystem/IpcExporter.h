@@ -0,0 +1,48 @@
+#pragma once
+#include "Framework/Framework/ModuleIO.h"
+#include "IO/Ipc_IO/IpcMemoryChannel.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	IpcExporter
+	*	\brief	Publishes device fields to an external process every frame.
+	*
+	*	Registered fields (particle positions, velocities, phase
+	*	concentrations, ...) are mirrored into CUDA-IPC-exported device
+	*	buffers by device-to-device copies and announced through an
+	*	IpcMemoryChannel descriptor block, replacing the per-frame file
+	*	export toward the out-of-process renderer. The mirror copy keeps
+	*	the exported allocation stable while solver arrays resize or live
+	*	inside co-allocated slabs, whose base pointers CUDA IPC cannot
+	*	export directly.
+	*/
+	class IpcExporter : public IOModule
+	{
+		DECLARE_CLASS(IpcExporter)
+	public:
+		IpcExporter();
+		virtual ~IpcExporter();
+
+		void setChannelName(std::string name) { m_channel_name = name; }
+
+		/**
+		 * @brief Publish field under name; any array field with a
+		 * trivially copyable element type works.
+		 */
+		void addBuffer(std::string name, Field* field);
+
+		bool execute() override;
+
+	private:
+		std::string m_channel_name = std::string("physika_ipc");
+		bool m_created = false;
+
+		IpcMemoryChannel m_channel;
+		std::vector<std::pair<std::string, Field*>> m_buffers;
+	};
+}
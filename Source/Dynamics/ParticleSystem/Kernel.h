@@ -11,12 +11,12 @@ namespace PhysIKA {
 		COMM_FUNC Kernel() {};
 		COMM_FUNC ~Kernel() {};
 
-		COMM_FUNC inline virtual Real Weight(const Real r, const Real h)
+		COMM_FUNC inline Real Weight(const Real r, const Real h)
 		{
 			return Real(0);
 		}
 
-		COMM_FUNC inline virtual Real Gradient(const Real r, const Real h)
+		COMM_FUNC inline Real Gradient(const Real r, const Real h)
 		{
 			return Real(0);
 		}
@@ -33,7 +33,7 @@ namespace PhysIKA {
 		COMM_FUNC SpikyKernel() : Kernel<Real>() {};
 		COMM_FUNC ~SpikyKernel() {};
 
-		COMM_FUNC inline Real Weight(const Real r, const Real h) override
+		COMM_FUNC inline Real Weight(const Real r, const Real h)
 		{
 			const Real q = r / h;
 			if (q > 1.0f) return 0.0f;
@@ -44,7 +44,7 @@ namespace PhysIKA {
 			}
 		}
 
-		COMM_FUNC inline Real Gradient(const Real r, const Real h) override
+		COMM_FUNC inline Real Gradient(const Real r, const Real h)
 		{
 			const Real q = r / h;
 			if (q > 1.0f) return 0.0;
@@ -58,6 +58,55 @@ namespace PhysIKA {
 	};
 
 
+	/*!
+	*	\class	FixedSpikyKernel
+	*	\brief	Spiky kernel with the smoothing length baked in.
+	*
+	*	The solver configuration is fixed for the lifetime of a launch, so the
+	*	reciprocal of h and the fused normalization coefficients are computed
+	*	once on the host and travel with the kernel object; the per-pair
+	*	evaluations in the inner loops reduce to multiplications. Produces the
+	*	same values as SpikyKernel::Weight/Gradient with the same h and scale.
+	*/
+	template<typename Real>
+	class FixedSpikyKernel
+	{
+	public:
+		COMM_FUNC FixedSpikyKernel(const Real h = Real(1), const Real scale = Real(1))
+		{
+			m_invH = Real(1) / h;
+			const Real hhh = h * h * h;
+			m_weightCoef = 15.0f / ((Real)M_PI * hhh) * scale;
+			m_gradientCoef = -45.0f / ((Real)M_PI * hhh) * scale;
+		}
+		COMM_FUNC ~FixedSpikyKernel() {};
+
+		COMM_FUNC inline Real Weight(const Real r) const
+		{
+			const Real q = r * m_invH;
+			if (q > 1.0f) return 0.0f;
+			else {
+				const Real d = 1.0 - q;
+				return m_weightCoef * d * d * d;
+			}
+		}
+
+		COMM_FUNC inline Real Gradient(const Real r) const
+		{
+			const Real q = r * m_invH;
+			if (q > 1.0f) return 0.0;
+			else {
+				const Real d = 1.0 - q;
+				return m_gradientCoef * d * d;
+			}
+		}
+
+	private:
+		Real m_invH;
+		Real m_weightCoef;
+		Real m_gradientCoef;
+	};
+
 	template<typename Real>
 	class SmoothKernel : public Kernel<Real>
 	{
@@ -65,7 +114,7 @@ namespace PhysIKA {
 		COMM_FUNC SmoothKernel() : Kernel<Real>() {};
 		COMM_FUNC ~SmoothKernel() {};
 
-		COMM_FUNC inline Real Weight(const Real r, const Real h) override
+		COMM_FUNC inline Real Weight(const Real r, const Real h)
 		{
 			const Real q = r / h;
 			if (q > 1.0f) return 0.0f;
@@ -74,7 +123,7 @@ namespace PhysIKA {
 			}
 		}
 
-		COMM_FUNC inline Real Gradient(const Real r, const Real h) override
+		COMM_FUNC inline Real Gradient(const Real r, const Real h)
 		{
 			const Real q = r / h;
 			if (q > 1.0f) return 0.0f;
@@ -96,7 +145,7 @@ namespace PhysIKA {
 		COMM_FUNC CorrectedKernel() : Kernel<Real>() {};
 		COMM_FUNC ~CorrectedKernel() {};
 
-		COMM_FUNC inline Real Weight(const Real r, const Real h) override
+		COMM_FUNC inline Real Weight(const Real r, const Real h)
 		{
 			const Real q = r / h;
 			SmoothKernel<Real> kernSmooth;
@@ -150,7 +199,7 @@ namespace PhysIKA {
 		COMM_FUNC CubicKernel() : Kernel<Real>() {};
 		COMM_FUNC ~CubicKernel() {};
 
-		COMM_FUNC inline Real Weight(const Real r, const Real h) override
+		COMM_FUNC inline Real Weight(const Real r, const Real h)
 		{
 			const Real hh = h*h;
 			const Real q = 2.0f*r / h;
@@ -173,7 +222,7 @@ namespace PhysIKA {
 			}
 		}
 
-		COMM_FUNC inline Real Gradient(const Real r, const Real h) override
+		COMM_FUNC inline Real Gradient(const Real r, const Real h)
 		{
 			const Real hh = h*h;
 			const Real q = 2.0f*r / h;
@@ -204,7 +253,7 @@ namespace PhysIKA {
 		COMM_FUNC QuarticKernel() : Kernel<Real>() {};
 		COMM_FUNC ~QuarticKernel() {};
 
-		COMM_FUNC inline Real Weight(const Real r, const Real h) override
+		COMM_FUNC inline Real Weight(const Real r, const Real h)
 		{
 			const Real hh = h*h;
 			const Real q = 2.5f*r / h;
@@ -235,7 +284,7 @@ namespace PhysIKA {
 			}
 		}
 
-		COMM_FUNC inline Real Gradient(const Real r, const Real h) override
+		COMM_FUNC inline Real Gradient(const Real r, const Real h)
 		{
 			const Real hh = h*h;
 			const Real q = 2.5f*r / h;
@@ -261,4 +310,78 @@ namespace PhysIKA {
 			}
 		}
 	};
+
+#ifdef __CUDACC__
+
+#define KERNEL_TABLE_SIZE 128
+
+	static __constant__ float c_kernelWTable[KERNEL_TABLE_SIZE];
+	static __constant__ float c_kernelGTable[KERNEL_TABLE_SIZE];
+
+	/**
+	 * @brief Kernel evaluated from a precomputed lookup table in constant memory.
+	 *
+	 * The table stores the kernel shape sampled over the normalized distance
+	 * q = r/h at h = 1 and rescales by 1/h^3, which reproduces any kernel whose
+	 * h-dependence is a pure h^-3 prefactor (SpikyKernel, CubicKernel). Sampling
+	 * two constant-memory entries replaces the cubic polynomial and division per
+	 * neighbor pair. Constant symbols are per translation unit: call
+	 * setupKernelTable() from the .cu file that launches the sampling kernels.
+	 */
+	template<typename Real>
+	class TabulatedKernel : public Kernel<Real>
+	{
+	public:
+		COMM_FUNC TabulatedKernel() : Kernel<Real>() {};
+		COMM_FUNC ~TabulatedKernel() {};
+
+		GPU_FUNC inline Real Weight(const Real r, const Real h)
+		{
+			const Real q = r / h;
+			if (q > 1.0f) return 0.0f;
+
+			const Real x = q * Real(KERNEL_TABLE_SIZE - 1);
+			const int i0 = (int)x;
+			const int i1 = i0 + 1 < KERNEL_TABLE_SIZE ? i0 + 1 : i0;
+			const Real fx = x - i0;
+			const Real w = c_kernelWTable[i0] * (Real(1) - fx) + c_kernelWTable[i1] * fx;
+			return w / (h*h*h) * this->m_scale;
+		}
+
+		GPU_FUNC inline Real Gradient(const Real r, const Real h)
+		{
+			const Real q = r / h;
+			if (q > 1.0f) return 0.0f;
+
+			const Real x = q * Real(KERNEL_TABLE_SIZE - 1);
+			const int i0 = (int)x;
+			const int i1 = i0 + 1 < KERNEL_TABLE_SIZE ? i0 + 1 : i0;
+			const Real fx = x - i0;
+			const Real g = c_kernelGTable[i0] * (Real(1) - fx) + c_kernelGTable[i1] * fx;
+			return g / (h*h*h) * this->m_scale;
+		}
+	};
+
+	/**
+	 * @brief Fill this translation unit's kernel table by sampling TKernel.
+	 */
+	template<typename TKernel>
+	inline void setupKernelTable()
+	{
+		float W[KERNEL_TABLE_SIZE];
+		float G[KERNEL_TABLE_SIZE];
+
+		TKernel kern;
+		for (int i = 0; i < KERNEL_TABLE_SIZE; i++)
+		{
+			float q = (float)i / (float)(KERNEL_TABLE_SIZE - 1);
+			W[i] = kern.Weight(q, 1.0f);
+			G[i] = kern.Gradient(q, 1.0f);
+		}
+
+		cudaMemcpyToSymbol(c_kernelWTable, W, sizeof(W));
+		cudaMemcpyToSymbol(c_kernelGTable, G, sizeof(G));
+	}
+
+#endif
 }
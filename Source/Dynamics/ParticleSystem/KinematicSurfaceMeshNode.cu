@@ -0,0 +1,98 @@
+#include <cuda_runtime.h>
+#include "KinematicSurfaceMeshNode.h"
+#include "Framework/Topology/TriangleSet.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	template<typename Real, typename Coord, typename Matrix>
+	__global__ void KM_ApplyRigidMotion(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<Coord> restArr,
+		Matrix rotation,
+		Coord translation,
+		Coord pivot,
+		Coord linearVel,
+		Coord omega)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord p = rotation * (restArr[pId] - pivot) + pivot + translation;
+		posArr[pId] = p;
+
+		//analytic rigid-body velocity, so the collision response sees the
+		//boundary's true motion instead of a finite difference
+		Coord r = p - (pivot + translation);
+		velArr[pId] = linearVel + omega.cross(r);
+	}
+
+	template<typename TDataType>
+	KinematicSurfaceMeshNode<TDataType>::KinematicSurfaceMeshNode(std::string name)
+		: TriangularSurfaceMeshNode<TDataType>(name)
+		, m_linearVelocity(Coord(0))
+		, m_angularVelocity(Coord(0))
+		, m_pivot(Coord(0))
+		, m_translation(Coord(0))
+	{
+	}
+
+	template<typename TDataType>
+	KinematicSurfaceMeshNode<TDataType>::~KinematicSurfaceMeshNode()
+	{
+		m_restPosition.release();
+	}
+
+	template<typename TDataType>
+	bool KinematicSurfaceMeshNode<TDataType>::resetStatus()
+	{
+		bool ret = TriangularSurfaceMeshNode<TDataType>::resetStatus();
+
+		//cache the rest geometry once; the per-frame update only ever
+		//transforms this copy
+		int num = this->getVertexPosition()->getElementCount();
+		if (num > 0)
+		{
+			m_restPosition.resize(num);
+			Function1Pt::copy(m_restPosition, this->getVertexPosition()->getValue());
+		}
+
+		m_translation = Coord(0);
+		m_rotation = Quaternion<Real>();
+
+		return ret;
+	}
+
+	template<typename TDataType>
+	void KinematicSurfaceMeshNode<TDataType>::advance(Real dt)
+	{
+		int num = m_restPosition.size();
+		if (num == 0) return;
+
+		m_translation += m_linearVelocity * dt;
+
+		Real angSpeed = m_angularVelocity.norm();
+		if (angSpeed > EPSILON)
+		{
+			Coord axis = m_angularVelocity / angSpeed;
+			m_rotation = Quaternion<Real>(angSpeed * dt, axis) * m_rotation;
+		}
+
+		cuExecute(num, KM_ApplyRigidMotion,
+			this->getVertexPosition()->getValue(),
+			this->getVertexVelocity()->getValue(),
+			m_restPosition,
+			m_rotation.get3x3Matrix(),
+			m_translation,
+			m_pivot,
+			m_linearVelocity,
+			m_angularVelocity);
+	}
+
+#ifdef PRECISION_FLOAT
+	template class KinematicSurfaceMeshNode<DataType3f>;
+#else
+	template class KinematicSurfaceMeshNode<DataType3d>;
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "TriangularSurfaceMeshNode.h"
+#include "Core/Quaternion/quaternion.h"
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	KinematicSurfaceMeshNode
+	*	\brief	Triangle mesh following a prescribed rigid motion.
+	*
+	*	Animated obstacles (paddles, propellers) neither need dynamics nor
+	*	deserve a full vertex re-upload every frame. The rest positions are
+	*	cached on the device once at reset; each frame a single kernel
+	*	applies the current rigid transform to them and writes the analytic
+	*	rigid-body velocity v + omega x r into the vertex velocity field,
+	*	so MeshCollision couples against a boundary that moves and pushes
+	*	consistently. No host-device traffic is involved after setup.
+	*
+	*	The motion is a constant linear velocity plus a constant angular
+	*	velocity about a pivot; both can be changed at any time and take
+	*	effect from the current pose.
+	*/
+	template<typename TDataType>
+	class KinematicSurfaceMeshNode : public TriangularSurfaceMeshNode<TDataType>
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef typename TDataType::Matrix Matrix;
+
+		KinematicSurfaceMeshNode(std::string name = "KinematicSurfaceMeshNode");
+		virtual ~KinematicSurfaceMeshNode();
+
+		void advance(Real dt) override;
+		bool resetStatus() override;
+
+		void setLinearVelocity(Coord vel) { m_linearVelocity = vel; }
+
+		/*!
+		*	\brief	Rotation at omega radians per second about the axis
+		*	through pivot; the axis length is the angular speed.
+		*/
+		void setAngularVelocity(Coord omega, Coord pivot)
+		{
+			m_angularVelocity = omega;
+			m_pivot = pivot;
+		}
+
+	private:
+		Coord m_linearVelocity;
+		Coord m_angularVelocity;
+		Coord m_pivot;
+
+		//accumulated pose relative to the cached rest positions
+		Coord m_translation;
+		Quaternion<Real> m_rotation;
+
+		DeviceArray<Coord> m_restPosition;
+	};
+
+#ifdef PRECISION_FLOAT
+	extern template class KinematicSurfaceMeshNode<DataType3f>;
+#else
+	extern template class KinematicSurfaceMeshNode<DataType3d>;
+#endif
+}
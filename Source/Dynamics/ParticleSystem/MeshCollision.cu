@@ -7,6 +7,9 @@
 #include "Framework/Topology/Primitive3D.h"
 #include "Framework/Topology/PrimitiveSweep3D.h"
 
+#include <thrust/sort.h>
+#include <thrust/execution_policy.h>
+
 namespace PhysIKA
 {
 	IMPLEMENT_CLASS_1(MeshCollision, TDataType)
@@ -392,7 +395,11 @@ namespace PhysIKA
 		DeviceArray<TopologyModule::Triangle> triangle_index,
 		NeighborList<int> triangle_neighbors,
 		Real threshold,
-		Real dt
+		Real dt,
+		int* eventCount,
+		long long* eventKeys,
+		Coord* eventImpulses,
+		int eventCapacity
 	)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
@@ -418,8 +425,11 @@ namespace PhysIKA
 		Coord3D total_pos(0);
 		Coord3D delta_pos(0);
 
-		
-		
+		const int MAX_HITS = 8;
+		int hitTri[MAX_HITS];
+		Coord3D hitDelta[MAX_HITS];
+		int hitNum = 0;
+
 		for (int ne = 0; ne < nbrSize; ne++)
 		{
 			int j = triangle_neighbors.getElement(pId, ne);
@@ -492,6 +502,13 @@ namespace PhysIKA
 					d_pos_i *= 0.0;// threshold / d_pos_i.norm();
 				}
 				delta_pos += d_pos_i;
+
+				if (hitNum < MAX_HITS)
+				{
+					hitTri[hitNum] = j;
+					hitDelta[hitNum] = d_pos_i;
+					hitNum++;
+				}
 			}
 
 
@@ -515,10 +532,60 @@ namespace PhysIKA
 			
 
 			particle_velocity[pId] = vel_i;
+
+			//append the reaction onto the mesh as one event per touched vertex;
+			//the queue is sorted by vertex and reduced in a later gather pass.
+			//The key's low word identifies the writer, so keys are unique and
+			//the sorted order does not depend on the atomic slot assignment
+			if (eventKeys != NULL)
+			{
+				for (int h = 0; h < hitNum; h++)
+				{
+					Coord imp = -(hitDelta[h] / dt) / (Real)(interNum * 3);
+					int base = atomicAdd(eventCount, 3);
+					if (base + 3 > eventCapacity) break;
+
+					for (int k = 0; k < 3; k++)
+					{
+						unsigned int writer = (unsigned int)(3 * (pId * MAX_HITS + h) + k);
+						eventKeys[base + k] = ((long long)triangle_index[hitTri[h]][k] << 32) | writer;
+						eventImpulses[base + k] = imp;
+					}
+				}
+			}
 		}
 		return;
 	}
 
+	//one thread per event; the first event of each vertex segment sums the
+	//whole segment and applies it, so no two threads write the same vertex
+	template<typename Real, typename Coord>
+	__global__ void K_GatherMeshImpulses(
+		DeviceArray<Coord> triangle_vertex,
+		DeviceArray<Real> triangle_vertex_mass,
+		long long* eventKeys,
+		Coord* eventImpulses,
+		int eventNum,
+		Real dt)
+	{
+		int eId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (eId >= eventNum) return;
+
+		int vertex = (int)(eventKeys[eId] >> 32);
+		if (eId > 0 && (int)(eventKeys[eId - 1] >> 32) == vertex) return;
+
+		Coord sum(0);
+		for (int e = eId; e < eventNum && (int)(eventKeys[e] >> 32) == vertex; e++)
+		{
+			sum += eventImpulses[e];
+		}
+
+		Real mass = triangle_vertex_mass[vertex];
+		if (mass < EPSILON) return;
+
+		triangle_vertex[vertex] += sum * dt / mass;
+	}
+
 	template<typename TDataType>
 	void MeshCollision<TDataType>::doCollision()
 	{
@@ -576,6 +643,21 @@ namespace PhysIKA
 		
 		//K_CCD_MESH <Real, Coord> << <pDims, BLOCK_SIZE >> > (
 		
+		//mesh feedback only when vertex masses are provided; an empty queue
+		//pointer keeps the old one-way behavior
+		bool two_way = !m_triangle_vertex_mass.isEmpty();
+		int eventCapacity = 24 * total_num;
+		if (two_way && m_eventKeys.size() < eventCapacity)
+		{
+			m_eventCount.resize(1);
+			m_eventKeys.resize(eventCapacity);
+			m_eventImpulses.resize(eventCapacity);
+		}
+		if (two_way)
+		{
+			m_eventCount.reset();
+		}
+
 		cuExecute(total_num, K_CCD_MESH,
 			m_position.getValue(),
 			m_velocity.getValue(),
@@ -585,8 +667,33 @@ namespace PhysIKA
 			m_triangle_index.getValue(),
 			m_neighborhood_tri.getValue(),
 			radius,
-			getParent()->getDt()
+			getParent()->getDt(),
+			two_way ? m_eventCount.getDataPtr() : NULL,
+			two_way ? m_eventKeys.getDataPtr() : NULL,
+			two_way ? m_eventImpulses.getDataPtr() : NULL,
+			eventCapacity
 			);
+
+		if (two_way)
+		{
+			int eventNum = 0;
+			cuSafeCall(cudaMemcpy(&eventNum, m_eventCount.getDataPtr(), sizeof(int), cudaMemcpyDeviceToHost));
+			eventNum = eventNum < eventCapacity ? eventNum : eventCapacity;
+
+			if (eventNum > 0)
+			{
+				thrust::sort_by_key(thrust::device, m_eventKeys.getDataPtr(), m_eventKeys.getDataPtr() + eventNum, m_eventImpulses.getDataPtr());
+
+				cuExecute(eventNum, K_GatherMeshImpulses,
+					m_triangle_vertex.getValue(),
+					m_triangle_vertex_mass.getValue(),
+					m_eventKeys.getDataPtr(),
+					m_eventImpulses.getDataPtr(),
+					eventNum,
+					getParent()->getDt()
+					);
+			}
+		}
 		
 		
 
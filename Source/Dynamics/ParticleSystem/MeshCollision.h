@@ -50,7 +50,16 @@ public:
 	
 protected:
 	DeviceArray<int> m_objId;
-	
+
+	//contact events recorded during CCD: one entry per touched mesh vertex,
+	//sorted by vertex and reduced in a gather pass instead of scattering
+	//impulses with per-vertex atomics. The key packs (vertex, writer) so
+	//equal-vertex segments sort into a unique order and the reduction is
+	//bitwise reproducible regardless of how the atomic slot grabs landed
+	DeviceArray<int> m_eventCount;
+	DeviceArray<long long> m_eventKeys;
+	DeviceArray<Coord> m_eventImpulses;
+
 	DeviceArray<Real> weights;
 	DeviceArray<Coord> init_pos;
 	DeviceArray<Coord> posBuf;
@@ -0,0 +1,923 @@
+#include "MultiGpuParticleFluid.h"
+#include "Kernel.h"
+
+#include "Framework/Framework/SceneGraph.h"
+#include "Framework/Framework/Log.h"
+#include "Framework/Topology/PointSet.h"
+#include "Core/Utility.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(MultiGpuParticleFluid, TDataType)
+
+	//counter slots shared by the band-collect and partition kernels
+	static const int CNT_SEND_LEFT = 0;
+	static const int CNT_SEND_RIGHT = 1;
+	static const int CNT_KEEP = 2;
+	static const int CNT_NUM = 3;
+
+	/*!
+	*	\brief	Non-owning DeviceArray view over a raw slab buffer, so the
+	*	per-device state can be handed to GridHash::construct. Array never
+	*	frees its storage in the destructor, which makes the view safe.
+	*/
+	template<typename T>
+	class SlabArrayView : public DeviceArray<T>
+	{
+	public:
+		SlabArrayView(T* data, int num)
+		{
+			this->m_data = data;
+			this->m_totalNum = num;
+		}
+	};
+
+	template <typename Real, typename Coord>
+	__global__ void K_MGF_Predict(
+		Coord* pos,
+		Coord* vel,
+		Coord* posOld,
+		int num,
+		Coord gravity,
+		Coord lo,
+		Coord hi,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		Coord v = vel[pId] + gravity * dt;
+		Coord p = pos[pId] + v * dt;
+
+		//simple box boundary: clamp the position and kill the normal velocity
+		for (int d = 0; d < Coord::dims(); d++)
+		{
+			if (p[d] < lo[d]) { p[d] = lo[d]; v[d] = Real(0); }
+			if (p[d] > hi[d]) { p[d] = hi[d]; v[d] = Real(0); }
+		}
+
+		vel[pId] = v;
+		pos[pId] = p;
+		posOld[pId] = p;
+	}
+
+	/*!
+	*	\brief	Stage the particles within one smoothing length of a slab face
+	*	into the send buffer for that side; the neighbor slab pulls them onto
+	*	its ghost tail. Only positions travel - the solve never reads ghost
+	*	velocities.
+	*/
+	template <typename Real, typename Coord>
+	__global__ void K_MGF_CollectBand(
+		Coord* pos,
+		int num,
+		Real leftEdge,
+		Real rightEdge,
+		int hasLeft,
+		int hasRight,
+		Coord* sendLeft,
+		Coord* sendRight,
+		int* counters)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		Coord p = pos[pId];
+		if (hasLeft && p[0] < leftEdge)
+		{
+			int slot = atomicAdd(&counters[CNT_SEND_LEFT], 1);
+			sendLeft[slot] = p;
+		}
+		if (hasRight && p[0] > rightEdge)
+		{
+			int slot = atomicAdd(&counters[CNT_SEND_RIGHT], 1);
+			sendRight[slot] = p;
+		}
+	}
+
+	/*!
+	*	\brief	Per-slab twin of K_ComputeDensityAndLambdas in DensityPBD.cu,
+	*	gathering straight from the cell hash instead of a NeighborList. It
+	*	runs over owned particles and ghosts alike, so every owned particle
+	*	near a slab face sees the lambdas of its off-device neighbors.
+	*/
+	template <typename Real, typename Coord, typename TDataType>
+	__global__ void K_MGF_DensityAndLambdas(
+		Real* lambdaArr,
+		Coord* posArr,
+		int total,
+		GridHash<TDataType> hash,
+		SpikyKernel<Real> kern,
+		Real smoothingLength,
+		Real mass,
+		Real restDensity)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= total) return;
+
+		Coord pos_i = posArr[pId];
+		int3 gId3 = hash.getIndex3(pos_i);
+
+		Real rho_i = Real(0);
+		Real lamda_i = Real(0);
+		Coord grad_ci(0);
+
+		for (int i = -1; i <= 1; i++)
+		{
+			for (int j = -1; j <= 1; j++)
+			{
+				for (int k = -1; k <= 1; k++)
+				{
+					int cId = hash.getIndex(gId3.x + i, gId3.y + j, gId3.z + k);
+					if (cId < 0) continue;
+
+					int cellNum = hash.getCounter(cId);
+					for (int t = 0; t < cellNum; t++)
+					{
+						int nbId = hash.getParticleId(cId, t);
+						Coord pos_ij = pos_i - posArr[nbId];
+						Real r = pos_ij.norm();
+						if (r >= smoothingLength) continue;
+
+						rho_i += mass * kern.Weight(r, smoothingLength);
+
+						if (r > EPSILON)
+						{
+							Coord g = kern.Gradient(r, smoothingLength) * pos_ij * (1.0f / r);
+							grad_ci += g;
+							lamda_i += g.dot(g);
+						}
+					}
+				}
+			}
+		}
+
+		lamda_i += grad_ci.dot(grad_ci);
+
+		lamda_i = -(rho_i - restDensity) / (lamda_i + 0.1f);
+
+		lambdaArr[pId] = lamda_i > 0.0f ? 0.0f : lamda_i;
+	}
+
+	/*!
+	*	\brief	Gather-form displacement over the cell hash; each owned
+	*	particle sums the doubled antisymmetric pair term over its neighbors
+	*	(see K_ComputeDisplacementGather in DensityPBD.cu for the identity).
+	*	The gather form is what makes the decomposition work: ghosts never
+	*	receive scatter contributions, they only lend their positions and
+	*	lambdas, and their home slab computes their displacement itself.
+	*/
+	template <typename Real, typename Coord, typename TDataType>
+	__global__ void K_MGF_ComputeDisplacement(
+		Coord* dPos,
+		Real* lambdaArr,
+		Coord* posArr,
+		int ownedNum,
+		GridHash<TDataType> hash,
+		SpikyKernel<Real> kern,
+		Real smoothingLength)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= ownedNum) return;
+
+		Coord pos_i = posArr[pId];
+		Real lamda_i = lambdaArr[pId];
+		int3 gId3 = hash.getIndex3(pos_i);
+
+		Coord dP_i(0);
+
+		for (int i = -1; i <= 1; i++)
+		{
+			for (int j = -1; j <= 1; j++)
+			{
+				for (int k = -1; k <= 1; k++)
+				{
+					int cId = hash.getIndex(gId3.x + i, gId3.y + j, gId3.z + k);
+					if (cId < 0) continue;
+
+					int cellNum = hash.getCounter(cId);
+					for (int t = 0; t < cellNum; t++)
+					{
+						int nbId = hash.getParticleId(cId, t);
+						Coord pos_ij = pos_i - posArr[nbId];
+						Real r = pos_ij.norm();
+						if (r >= smoothingLength || r <= EPSILON) continue;
+
+						Coord dp_ij = 10.0f*pos_ij*(lamda_i + lambdaArr[nbId])*kern.Gradient(r, smoothingLength)* (1.0 / r);
+						dP_i += dp_ij * Real(2);
+					}
+				}
+			}
+		}
+
+		dPos[pId] = dP_i;
+	}
+
+	template <typename Coord>
+	__global__ void K_MGF_ApplyDisplacement(
+		Coord* pos,
+		Coord* dPos,
+		int ownedNum)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= ownedNum) return;
+
+		pos[pId] += dPos[pId];
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void K_MGF_UpdateVelocity(
+		Coord* vel,
+		Coord* pos,
+		Coord* posOld,
+		int ownedNum,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= ownedNum) return;
+
+		vel[pId] += (pos[pId] - posOld[pId]) / dt;
+	}
+
+	/*!
+	*	\brief	Split the owned particles into survivors and emigrants after
+	*	the solve: survivors are compacted into the keep buffers, particles
+	*	that crossed a slab face go to the send buffer of that side. Boundary
+	*	slabs keep everything on their outer side - the box clamp already
+	*	confined those particles.
+	*/
+	template <typename Real, typename Coord>
+	__global__ void K_MGF_Partition(
+		Coord* pos,
+		Coord* vel,
+		int num,
+		Real x0,
+		Real x1,
+		int hasLeft,
+		int hasRight,
+		Coord* keepPos,
+		Coord* keepVel,
+		Coord* sendPosL,
+		Coord* sendVelL,
+		Coord* sendPosR,
+		Coord* sendVelR,
+		int* counters)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		Coord p = pos[pId];
+
+		if (hasLeft && p[0] < x0)
+		{
+			int slot = atomicAdd(&counters[CNT_SEND_LEFT], 1);
+			sendPosL[slot] = p;
+			sendVelL[slot] = vel[pId];
+			return;
+		}
+		if (hasRight && p[0] >= x1)
+		{
+			int slot = atomicAdd(&counters[CNT_SEND_RIGHT], 1);
+			sendPosR[slot] = p;
+			sendVelR[slot] = vel[pId];
+			return;
+		}
+
+		int slot = atomicAdd(&counters[CNT_KEEP], 1);
+		keepPos[slot] = p;
+		keepVel[slot] = vel[pId];
+	}
+
+	template<typename TDataType>
+	MultiGpuParticleFluid<TDataType>::MultiGpuParticleFluid(std::string name)
+		: ParticleSystem<TDataType>(name)
+	{
+	}
+
+	template<typename TDataType>
+	MultiGpuParticleFluid<TDataType>::~MultiGpuParticleFluid()
+	{
+		releaseSlabs();
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::setDeviceCount(int num)
+	{
+		m_deviceNum = num < 0 ? 0 : num;
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::setBounds(Coord lo, Coord hi)
+	{
+		m_lo = lo;
+		m_hi = hi;
+		m_boundsSet = true;
+	}
+
+	template<typename TDataType>
+	bool MultiGpuParticleFluid<TDataType>::resetStatus()
+	{
+		//the particle set changed; redistribute on the next advance
+		m_distributed = false;
+		return ParticleSystem<TDataType>::resetStatus();
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::resizeSlab(Slab& slab, int required)
+	{
+		if (slab.capacity >= required) return;
+
+		int newCap = slab.capacity * 2 > required ? slab.capacity * 2 : required;
+
+		cudaSetDevice(slab.device);
+
+		Coord* pos;		cuSafeCall(cudaMalloc((void**)&pos, newCap * sizeof(Coord)));
+		Coord* vel;		cuSafeCall(cudaMalloc((void**)&vel, newCap * sizeof(Coord)));
+		Coord* posOld;	cuSafeCall(cudaMalloc((void**)&posOld, newCap * sizeof(Coord)));
+		Coord* dPos;	cuSafeCall(cudaMalloc((void**)&dPos, newCap * sizeof(Coord)));
+		Real* lambda;	cuSafeCall(cudaMalloc((void**)&lambda, newCap * sizeof(Real)));
+		Coord* bufPos;	cuSafeCall(cudaMalloc((void**)&bufPos, newCap * sizeof(Coord)));
+		Coord* bufVel;	cuSafeCall(cudaMalloc((void**)&bufVel, newCap * sizeof(Coord)));
+		Coord* sendPos[2];
+		Coord* sendVel[2];
+		for (int s = 0; s < 2; s++)
+		{
+			cuSafeCall(cudaMalloc((void**)&sendPos[s], newCap * sizeof(Coord)));
+			cuSafeCall(cudaMalloc((void**)&sendVel[s], newCap * sizeof(Coord)));
+		}
+
+		if (slab.num > 0)
+		{
+			cuSafeCall(cudaMemcpy(pos, slab.pos, slab.num * sizeof(Coord), cudaMemcpyDeviceToDevice));
+			cuSafeCall(cudaMemcpy(vel, slab.vel, slab.num * sizeof(Coord), cudaMemcpyDeviceToDevice));
+			cuSafeCall(cudaMemcpy(posOld, slab.posOld, slab.num * sizeof(Coord), cudaMemcpyDeviceToDevice));
+			//migrate() compacts survivors into the buffers before growing
+			cuSafeCall(cudaMemcpy(bufPos, slab.bufPos, slab.num * sizeof(Coord), cudaMemcpyDeviceToDevice));
+			cuSafeCall(cudaMemcpy(bufVel, slab.bufVel, slab.num * sizeof(Coord), cudaMemcpyDeviceToDevice));
+		}
+
+		if (slab.pos != nullptr)
+		{
+			cudaFree(slab.pos);
+			cudaFree(slab.vel);
+			cudaFree(slab.posOld);
+			cudaFree(slab.dPos);
+			cudaFree(slab.lambda);
+			cudaFree(slab.bufPos);
+			cudaFree(slab.bufVel);
+			for (int s = 0; s < 2; s++)
+			{
+				cudaFree(slab.sendPos[s]);
+				cudaFree(slab.sendVel[s]);
+			}
+		}
+
+		slab.pos = pos;
+		slab.vel = vel;
+		slab.posOld = posOld;
+		slab.dPos = dPos;
+		slab.lambda = lambda;
+		slab.bufPos = bufPos;
+		slab.bufVel = bufVel;
+		for (int s = 0; s < 2; s++)
+		{
+			slab.sendPos[s] = sendPos[s];
+			slab.sendVel[s] = sendVel[s];
+		}
+		slab.capacity = newCap;
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::releaseSlabs()
+	{
+		for (int d = 0; d < (int)m_slabs.size(); d++)
+		{
+			Slab& slab = m_slabs[d];
+			cudaSetDevice(slab.device);
+
+			if (slab.pos != nullptr)
+			{
+				cudaFree(slab.pos);
+				cudaFree(slab.vel);
+				cudaFree(slab.posOld);
+				cudaFree(slab.dPos);
+				cudaFree(slab.lambda);
+				cudaFree(slab.bufPos);
+				cudaFree(slab.bufVel);
+				for (int s = 0; s < 2; s++)
+				{
+					cudaFree(slab.sendPos[s]);
+					cudaFree(slab.sendVel[s]);
+				}
+			}
+			if (slab.counters != nullptr)
+			{
+				cudaFree(slab.counters);
+			}
+			if (slab.stream != 0)
+			{
+				cudaStreamDestroy(slab.stream);
+				cudaStreamDestroy(slab.copyStream);
+				cudaEventDestroy(slab.stepStart);
+				cudaEventDestroy(slab.stepStop);
+			}
+			slab.hash.release();
+		}
+		m_slabs.clear();
+
+		cudaSetDevice(m_primaryDevice);
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::distribute()
+	{
+		releaseSlabs();
+
+		cudaGetDevice(&m_primaryDevice);
+
+		int total = this->currentPosition()->getElementCount();
+		if (total <= 0)
+		{
+			m_distributed = true;
+			return;
+		}
+
+		if (!m_boundsSet)
+		{
+			Vector3f sceneLo = SceneGraph::getInstance().getLowerBound();
+			Vector3f sceneHi = SceneGraph::getInstance().getUpperBound();
+			for (int d = 0; d < Coord::dims(); d++)
+			{
+				m_lo[d] = sceneLo[d];
+				m_hi[d] = sceneHi[d];
+			}
+		}
+
+		//kernel-corrected particle mass of a filled neighborhood, the same
+		//correction SummationDensity::calculateScalingFactor applies
+		{
+			Real d = m_samplingDistance;
+			Real H = m_smoothingLength;
+			Real V = d * d * d;
+
+			SpikyKernel<Real> kern;
+
+			Real total_weight(0);
+			int half_res = H / d + 1;
+			for (int i = -half_res; i <= half_res; i++)
+				for (int j = -half_res; j <= half_res; j++)
+					for (int k = -half_res; k <= half_res; k++)
+					{
+						Real x = i * d;
+						Real y = j * d;
+						Real z = k * d;
+						Real r = sqrt(x * x + y * y + z * z);
+						total_weight += V * kern.Weight(r, H);
+					}
+
+			m_scaledMass = m_restDensity * V / total_weight;
+		}
+
+		int visible = 0;
+		cudaGetDeviceCount(&visible);
+
+		int devNum = m_deviceNum == 0 ? visible : (m_deviceNum < visible ? m_deviceNum : visible);
+		if (devNum < 1) devNum = 1;
+
+		//the halo and migration copies - and the shared NeighborStats
+		//counters - rely on peer access between adjacent devices
+		for (int d = 0; d < devNum - 1; d++)
+		{
+			int canForward = 0;
+			int canBackward = 0;
+			cudaDeviceCanAccessPeer(&canForward, d, d + 1);
+			cudaDeviceCanAccessPeer(&canBackward, d + 1, d);
+			if (!canForward || !canBackward)
+			{
+				Log::sendMessage(Log::Warning, "MultiGpuParticleFluid: no peer access between adjacent devices, falling back to a single device");
+				devNum = 1;
+				break;
+			}
+		}
+		for (int d = 0; d < devNum - 1; d++)
+		{
+			cudaSetDevice(d);
+			cudaDeviceEnablePeerAccess(d + 1, 0);
+			cudaSetDevice(d + 1);
+			cudaDeviceEnablePeerAccess(d, 0);
+			cudaGetLastError();	//already-enabled is fine
+		}
+
+		//pull the loaded state to the host and sort it along the split axis
+		std::vector<Coord> hPos(total);
+		std::vector<Coord> hVel(total);
+		cudaSetDevice(m_primaryDevice);
+		cuSafeCall(cudaMemcpy(hPos.data(), this->currentPosition()->getValue().getDataPtr(), total * sizeof(Coord), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(hVel.data(), this->currentVelocity()->getValue().getDataPtr(), total * sizeof(Coord), cudaMemcpyDeviceToHost));
+
+		std::vector<int> order(total);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&hPos](int a, int b) {
+			return hPos[a][0] < hPos[b][0];
+		});
+
+		m_slabs.resize(devNum);
+		m_hostCounters.resize(devNum * CNT_NUM);
+
+		int offset = 0;
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+			slab.device = d;
+
+			//equal particle counts per slab; the boundary sits halfway
+			//between the last particle of one chunk and the first of the next
+			int num = total / devNum + (d < total % devNum ? 1 : 0);
+
+			slab.x0 = d == 0 ? m_lo[0] : m_slabs[d - 1].x1;
+			slab.x1 = d == devNum - 1
+				? m_hi[0]
+				: Real(0.5) * (hPos[order[offset + num - 1]][0] + hPos[order[offset + num]][0]);
+
+			cudaSetDevice(d);
+			cuSafeCall(cudaStreamCreate(&slab.stream));
+			cuSafeCall(cudaStreamCreate(&slab.copyStream));
+			cuSafeCall(cudaEventCreate(&slab.stepStart));
+			cuSafeCall(cudaEventCreate(&slab.stepStop));
+			cuSafeCall(cudaMalloc((void**)&slab.counters, CNT_NUM * sizeof(int)));
+
+			resizeSlab(slab, num + num / 4 + 1024);
+			slab.num = num;
+			slab.ghostNum = 0;
+
+			std::vector<Coord> chunkPos(num);
+			std::vector<Coord> chunkVel(num);
+			for (int i = 0; i < num; i++)
+			{
+				chunkPos[i] = hPos[order[offset + i]];
+				chunkVel[i] = hVel[order[offset + i]];
+			}
+			cuSafeCall(cudaMemcpy(slab.pos, chunkPos.data(), num * sizeof(Coord), cudaMemcpyHostToDevice));
+			cuSafeCall(cudaMemcpy(slab.vel, chunkVel.data(), num * sizeof(Coord), cudaMemcpyHostToDevice));
+
+			//slab-local hash domain: full extent across the slab, padded
+			//along the split axis so ghosts and migration candidates land
+			//inside the grid
+			Coord hashLo = m_lo;
+			Coord hashHi = m_hi;
+			for (int i = 0; i < Coord::dims(); i++)
+			{
+				hashLo[i] -= m_smoothingLength;
+				hashHi[i] += m_smoothingLength;
+			}
+			hashLo[0] = slab.x0 - 2 * m_smoothingLength;
+			hashHi[0] = slab.x1 + 2 * m_smoothingLength;
+			slab.hash.setSpace(m_smoothingLength, hashLo, hashHi);
+
+			offset += num;
+		}
+
+		cudaSetDevice(m_primaryDevice);
+		m_distributed = true;
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::exchangeHalos()
+	{
+		int devNum = (int)m_slabs.size();
+
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+
+			int fromLeft = d > 0 ? m_hostCounters[(d - 1) * CNT_NUM + CNT_SEND_RIGHT] : 0;
+			int fromRight = d < devNum - 1 ? m_hostCounters[(d + 1) * CNT_NUM + CNT_SEND_LEFT] : 0;
+
+			resizeSlab(slab, slab.num + fromLeft + fromRight);
+
+			cudaSetDevice(slab.device);
+
+			int tail = slab.num;
+			if (fromLeft > 0)
+			{
+				Slab& left = m_slabs[d - 1];
+				cuSafeCall(cudaMemcpyPeerAsync(slab.pos + tail, slab.device, left.sendPos[1], left.device, fromLeft * sizeof(Coord), slab.copyStream));
+				tail += fromLeft;
+			}
+			if (fromRight > 0)
+			{
+				Slab& right = m_slabs[d + 1];
+				cuSafeCall(cudaMemcpyPeerAsync(slab.pos + tail, slab.device, right.sendPos[0], right.device, fromRight * sizeof(Coord), slab.copyStream));
+				tail += fromRight;
+			}
+
+			slab.ghostNum = fromLeft + fromRight;
+		}
+
+		for (int d = 0; d < devNum; d++)
+		{
+			cudaStreamSynchronize(m_slabs[d].copyStream);
+		}
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::migrate()
+	{
+		int devNum = (int)m_slabs.size();
+
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+			if (slab.num <= 0) continue;
+
+			cudaSetDevice(slab.device);
+			cuSafeCall(cudaMemsetAsync(slab.counters, 0, CNT_NUM * sizeof(int), slab.stream));
+
+			uint pDims = cudaGridSize(slab.num, BLOCK_SIZE);
+			K_MGF_Partition << <pDims, BLOCK_SIZE, 0, slab.stream >> > (
+				slab.pos, slab.vel, slab.num,
+				slab.x0, slab.x1,
+				d > 0 ? 1 : 0, d < devNum - 1 ? 1 : 0,
+				slab.bufPos, slab.bufVel,
+				slab.sendPos[0], slab.sendVel[0],
+				slab.sendPos[1], slab.sendVel[1],
+				slab.counters);
+
+			cuSafeCall(cudaMemcpyAsync(&m_hostCounters[d * CNT_NUM], slab.counters, CNT_NUM * sizeof(int), cudaMemcpyDeviceToHost, slab.stream));
+		}
+		for (int d = 0; d < devNum; d++)
+		{
+			cudaSetDevice(m_slabs[d].device);
+			cudaStreamSynchronize(m_slabs[d].stream);
+		}
+
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+
+			int keep = slab.num > 0 ? m_hostCounters[d * CNT_NUM + CNT_KEEP] : 0;
+			int fromLeft = d > 0 ? m_hostCounters[(d - 1) * CNT_NUM + CNT_SEND_RIGHT] : 0;
+			int fromRight = d < devNum - 1 ? m_hostCounters[(d + 1) * CNT_NUM + CNT_SEND_LEFT] : 0;
+
+			resizeSlab(slab, keep + fromLeft + fromRight);
+
+			cudaSetDevice(slab.device);
+
+			if (keep > 0)
+			{
+				cuSafeCall(cudaMemcpyAsync(slab.pos, slab.bufPos, keep * sizeof(Coord), cudaMemcpyDeviceToDevice, slab.copyStream));
+				cuSafeCall(cudaMemcpyAsync(slab.vel, slab.bufVel, keep * sizeof(Coord), cudaMemcpyDeviceToDevice, slab.copyStream));
+			}
+
+			int tail = keep;
+			if (fromLeft > 0)
+			{
+				Slab& left = m_slabs[d - 1];
+				cuSafeCall(cudaMemcpyPeerAsync(slab.pos + tail, slab.device, left.sendPos[1], left.device, fromLeft * sizeof(Coord), slab.copyStream));
+				cuSafeCall(cudaMemcpyPeerAsync(slab.vel + tail, slab.device, left.sendVel[1], left.device, fromLeft * sizeof(Coord), slab.copyStream));
+				tail += fromLeft;
+			}
+			if (fromRight > 0)
+			{
+				Slab& right = m_slabs[d + 1];
+				cuSafeCall(cudaMemcpyPeerAsync(slab.pos + tail, slab.device, right.sendPos[0], right.device, fromRight * sizeof(Coord), slab.copyStream));
+				cuSafeCall(cudaMemcpyPeerAsync(slab.vel + tail, slab.device, right.sendVel[0], right.device, fromRight * sizeof(Coord), slab.copyStream));
+				tail += fromRight;
+			}
+
+			slab.num = tail;
+			slab.ghostNum = 0;
+		}
+		for (int d = 0; d < devNum; d++)
+		{
+			cudaStreamSynchronize(m_slabs[d].copyStream);
+		}
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::advance(Real dt)
+	{
+		if (!m_distributed)
+		{
+			distribute();
+		}
+
+		int devNum = (int)m_slabs.size();
+		if (devNum == 0) return;
+
+		Vector3f g = SceneGraph::getInstance().getGravity();
+		Coord gravity(0);
+		for (int i = 0; i < Coord::dims(); i++)
+		{
+			gravity[i] = g[i];
+		}
+
+		Real band = m_smoothingLength;
+		SpikyKernel<Real> kern;
+
+		//predict under gravity and stage the halo bands; every device works
+		//on its own stream, so the slabs run concurrently
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+			if (slab.num <= 0) continue;
+
+			cudaSetDevice(slab.device);
+			cuSafeCall(cudaEventRecord(slab.stepStart, slab.stream));
+			cuSafeCall(cudaMemsetAsync(slab.counters, 0, CNT_NUM * sizeof(int), slab.stream));
+
+			uint pDims = cudaGridSize(slab.num, BLOCK_SIZE);
+			K_MGF_Predict << <pDims, BLOCK_SIZE, 0, slab.stream >> > (
+				slab.pos, slab.vel, slab.posOld, slab.num,
+				gravity, m_lo, m_hi, dt);
+
+			K_MGF_CollectBand << <pDims, BLOCK_SIZE, 0, slab.stream >> > (
+				slab.pos, slab.num,
+				slab.x0 + band, slab.x1 - band,
+				d > 0 ? 1 : 0, d < devNum - 1 ? 1 : 0,
+				slab.sendPos[0], slab.sendPos[1],
+				slab.counters);
+
+			cuSafeCall(cudaMemcpyAsync(&m_hostCounters[d * CNT_NUM], slab.counters, CNT_NUM * sizeof(int), cudaMemcpyDeviceToHost, slab.stream));
+		}
+		for (int d = 0; d < devNum; d++)
+		{
+			cudaSetDevice(m_slabs[d].device);
+			cudaStreamSynchronize(m_slabs[d].stream);
+		}
+
+		exchangeHalos();
+
+		//rebuild the per-slab hash over owned particles plus ghosts
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+			int active = slab.num + slab.ghostNum;
+			if (active <= 0) continue;
+
+			cudaSetDevice(slab.device);
+			SlabArrayView<Coord> posView(slab.pos, active);
+			slab.hash.construct(posView, slab.stream);
+		}
+
+		//constraint iterations; the ghost positions stay frozen at their
+		//predicted state, the per-iteration drift across a face is well below
+		//the kernel support for any sane dt
+		for (int it = 0; it < m_maxIteration; it++)
+		{
+			for (int d = 0; d < devNum; d++)
+			{
+				Slab& slab = m_slabs[d];
+				int active = slab.num + slab.ghostNum;
+				if (slab.num <= 0) continue;
+
+				cudaSetDevice(slab.device);
+
+				uint tDims = cudaGridSize(active, BLOCK_SIZE);
+				K_MGF_DensityAndLambdas << <tDims, BLOCK_SIZE, 0, slab.stream >> > (
+					slab.lambda, slab.pos, active,
+					slab.hash, kern, m_smoothingLength, m_scaledMass, m_restDensity);
+
+				uint pDims = cudaGridSize(slab.num, BLOCK_SIZE);
+				K_MGF_ComputeDisplacement << <pDims, BLOCK_SIZE, 0, slab.stream >> > (
+					slab.dPos, slab.lambda, slab.pos, slab.num,
+					slab.hash, kern, m_smoothingLength);
+
+				K_MGF_ApplyDisplacement << <pDims, BLOCK_SIZE, 0, slab.stream >> > (
+					slab.pos, slab.dPos, slab.num);
+			}
+		}
+
+		//velocity correction from the solved positions
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+			if (slab.num <= 0) continue;
+
+			cudaSetDevice(slab.device);
+			uint pDims = cudaGridSize(slab.num, BLOCK_SIZE);
+			K_MGF_UpdateVelocity << <pDims, BLOCK_SIZE, 0, slab.stream >> > (
+				slab.vel, slab.pos, slab.posOld, slab.num, dt);
+			cuSafeCall(cudaEventRecord(m_slabs[d].stepStop, slab.stream));
+		}
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+			cudaSetDevice(slab.device);
+			cudaStreamSynchronize(slab.stream);
+
+			if (slab.num > 0)
+			{
+				float ms = 0;
+				cudaEventElapsedTime(&ms, slab.stepStart, slab.stepStop);
+				slab.timeMs = slab.timeMs == 0 ? ms : 0.9f * slab.timeMs + 0.1f * ms;
+			}
+		}
+
+		migrate();
+
+		m_stepCount++;
+		if (m_rebalanceEnabled && m_stepCount % m_rebalanceInterval == 0)
+		{
+			rebalance();
+		}
+
+		cudaSetDevice(m_primaryDevice);
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::rebalance()
+	{
+		int devNum = (int)m_slabs.size();
+		if (devNum < 2) return;
+
+		float minMs = m_slabs[0].timeMs;
+		float maxMs = m_slabs[0].timeMs;
+		for (int d = 1; d < devNum; d++)
+		{
+			minMs = m_slabs[d].timeMs < minMs ? m_slabs[d].timeMs : minMs;
+			maxMs = m_slabs[d].timeMs > maxMs ? m_slabs[d].timeMs : maxMs;
+		}
+		if (minMs <= 0 || maxMs / minMs < (float)m_imbalanceThreshold)
+		{
+			return;
+		}
+
+		//shift every interior boundary toward its slower side, proportional
+		//to the timing gap and capped so one pass never moves more than a
+		//tenth of a slab; the next migrate() carries the particles over
+		bool moved = false;
+		for (int d = 0; d < devNum - 1; d++)
+		{
+			Slab& left = m_slabs[d];
+			Slab& right = m_slabs[d + 1];
+			if (left.timeMs <= 0 || right.timeMs <= 0) continue;
+
+			float gap = (left.timeMs - right.timeMs) / (left.timeMs + right.timeMs);
+			if (gap > -0.05f && gap < 0.05f) continue;
+
+			Real width = (left.x1 - left.x0) < (right.x1 - right.x0)
+				? (left.x1 - left.x0)
+				: (right.x1 - right.x0);
+			Real shift = Real(0.5) * Real(gap) * Real(0.2) * width;
+			Real cap = Real(0.1) * width;
+			shift = shift > cap ? cap : (shift < -cap ? -cap : shift);
+
+			//a slower left slab sheds its rightmost band: the boundary
+			//moves left, and vice versa
+			left.x1 -= shift;
+			right.x0 = left.x1;
+			moved = true;
+		}
+
+		if (!moved) return;
+
+		//the hash grids have to cover the new intervals
+		for (int d = 0; d < devNum; d++)
+		{
+			Slab& slab = m_slabs[d];
+			cudaSetDevice(slab.device);
+
+			Coord hashLo = m_lo;
+			Coord hashHi = m_hi;
+			for (int i = 0; i < Coord::dims(); i++)
+			{
+				hashLo[i] -= m_smoothingLength;
+				hashHi[i] += m_smoothingLength;
+			}
+			hashLo[0] = slab.x0 - 2 * m_smoothingLength;
+			hashHi[0] = slab.x1 + 2 * m_smoothingLength;
+			slab.hash.setSpace(m_smoothingLength, hashLo, hashHi);
+		}
+		cudaSetDevice(m_primaryDevice);
+	}
+
+	template<typename TDataType>
+	void MultiGpuParticleFluid<TDataType>::updateTopology()
+	{
+		//gather the slabs back onto the primary device so rendering and IO
+		//keep seeing one contiguous particle set
+		if (m_distributed && m_slabs.size() > 0)
+		{
+			DeviceArray<Coord>& position = this->currentPosition()->getValue();
+			DeviceArray<Coord>& velocity = this->currentVelocity()->getValue();
+
+			int offset = 0;
+			for (int d = 0; d < (int)m_slabs.size(); d++)
+			{
+				Slab& slab = m_slabs[d];
+				if (slab.num <= 0) continue;
+				if (offset + slab.num > position.size()) break;
+
+				cuSafeCall(cudaMemcpyPeer(position.getDataPtr() + offset, m_primaryDevice, slab.pos, slab.device, slab.num * sizeof(Coord)));
+				cuSafeCall(cudaMemcpyPeer(velocity.getDataPtr() + offset, m_primaryDevice, slab.vel, slab.device, slab.num * sizeof(Coord)));
+				offset += slab.num;
+			}
+		}
+
+		ParticleSystem<TDataType>::updateTopology();
+	}
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "ParticleSystem.h"
+#include "Framework/Topology/GridHash.h"
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	MultiGpuParticleFluid
+	*	\brief	Position-based fluid decomposed into per-GPU slabs.
+	*
+	*	The domain is split into slabs along the x axis, one per device, with
+	*	slab boundaries chosen so that every slab starts with the same number
+	*	of particles. Each device owns the particles inside its interval and
+	*	keeps ghost replicas of the neighbor particles within one smoothing
+	*	length of its faces; ghosts are refreshed once per step over P2P
+	*	copies before the constraint solve, and particles crossing a slab
+	*	boundary migrate to the neighbor device afterwards. Every device runs
+	*	the fused density/lambda sweep and a gather-form displacement on its
+	*	own stream, so the slabs advance concurrently.
+	*
+	*	The node carries its own compact PBD solver and a simple box boundary;
+	*	module-based solvers (DensityPBD, StaticBoundary) assume a single
+	*	device and are not attached. If fewer than two devices are visible, or
+	*	peer access between adjacent devices cannot be enabled, the node falls
+	*	back to a single slab and behaves like an ordinary ParticleFluid.
+	*/
+	template<typename TDataType>
+	class MultiGpuParticleFluid : public ParticleSystem<TDataType>
+	{
+		DECLARE_CLASS_1(MultiGpuParticleFluid, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		MultiGpuParticleFluid(std::string name = "default");
+		virtual ~MultiGpuParticleFluid();
+
+		/**
+		 * @brief Number of devices to decompose over; pass 0 to use every
+		 * visible device. Has to be called before the scene is initialized.
+		 */
+		void setDeviceCount(int num);
+		int getDeviceCount() { return (int)m_slabs.size(); }
+
+		void setSmoothingLength(Real h) { m_smoothingLength = h; }
+		void setSamplingDistance(Real d) { m_samplingDistance = d; }
+		void setIterationNumber(int num) { m_maxIteration = num; }
+
+		/**
+		 * @brief Axis-aligned box the fluid is clamped against; defaults to
+		 * the scene bounds.
+		 */
+		void setBounds(Coord lo, Coord hi);
+
+		/**
+		 * @brief Timing-driven load balancing, on by default. Every slab
+		 * times its own step with CUDA events; when the rolling ratio of
+		 * the slowest to the fastest slab exceeds the threshold, the
+		 * boundary between a slow slab and its faster neighbor shifts
+		 * toward the slow one and the regular migration pass carries the
+		 * particles over. Keeps a sloshing dam break from collapsing onto
+		 * one device.
+		 */
+		void setRebalancing(bool enabled) { m_rebalanceEnabled = enabled; }
+		void setRebalanceThreshold(Real ratio) { m_imbalanceThreshold = ratio; }
+		void setRebalanceInterval(int frames) { m_rebalanceInterval = frames; }
+
+		void advance(Real dt) override;
+		void updateTopology() override;
+		bool resetStatus() override;
+
+	private:
+		/**
+		 * @brief Per-device state. The owned particles occupy [0, num) and
+		 * the ghost replicas [num, num + ghostNum); all solver kernels run
+		 * over both, but only the owned range is integrated and written back.
+		 */
+		struct Slab
+		{
+			int device = 0;
+
+			Real x0 = Real(0);			//owned interval along the split axis
+			Real x1 = Real(0);
+
+			int num = 0;				//particles owned by this slab
+			int ghostNum = 0;			//halo replicas appended behind the owned ones
+			int capacity = 0;
+
+			Coord* pos = nullptr;		//owned followed by ghosts
+			Coord* vel = nullptr;
+			Coord* posOld = nullptr;
+			Coord* dPos = nullptr;
+			Real* lambda = nullptr;
+
+			Coord* bufPos = nullptr;	//compaction targets for migration
+			Coord* bufVel = nullptr;
+
+			Coord* sendPos[2] = { nullptr, nullptr };	//staged bands, 0: to the left neighbor, 1: to the right
+			Coord* sendVel[2] = { nullptr, nullptr };
+			int* counters = nullptr;	//particles staged left/right and survivors, see the CNT_ slots
+
+			GridHash<TDataType> hash;
+			cudaStream_t stream = 0;		//compute
+			cudaStream_t copyStream = 0;	//halo and migration transfers
+
+			cudaEvent_t stepStart = 0;		//bracket the per-slab step for load balancing
+			cudaEvent_t stepStop = 0;
+			float timeMs = 0;				//rolling per-step cost
+		};
+
+		//Splits the particles loaded into currentPosition into slabs and
+		//uploads each one to its device; called once from the first advance.
+		void distribute();
+
+		void resizeSlab(Slab& slab, int required);
+		void releaseSlabs();
+
+		//Refresh the ghost bands: every slab stages its boundary bands, the
+		//neighbors pull them over P2P onto their tails.
+		void exchangeHalos();
+
+		//Hand particles that left their interval to the neighbor slab and
+		//compact the survivors.
+		void migrate();
+
+		//Shift slab boundaries toward the slower device when the rolling
+		//step times drift apart; the next migrate() moves the particles.
+		void rebalance();
+
+		int m_deviceNum = 0;
+		int m_maxIteration = 5;
+
+		Real m_smoothingLength = Real(0.011);
+		Real m_samplingDistance = Real(0.005);
+		Real m_restDensity = Real(1000);
+		Real m_scaledMass = Real(0);	//kernel-corrected particle mass, see SummationDensity
+
+		int m_primaryDevice = 0;	//device the node state lives on; restored after every pass
+
+		Coord m_lo;
+		Coord m_hi;
+		bool m_boundsSet = false;
+
+		bool m_distributed = false;
+
+		bool m_rebalanceEnabled = true;
+		Real m_imbalanceThreshold = Real(1.3);
+		int m_rebalanceInterval = 30;
+		int m_stepCount = 0;
+
+		std::vector<Slab> m_slabs;
+		std::vector<int> m_hostCounters;	//one CNT_ block per slab, filled at sync points
+	};
+
+#ifdef PRECISION_FLOAT
+	template class MultiGpuParticleFluid<DataType3f>;
+#else
+	template class MultiGpuParticleFluid<DataType3d>;
+#endif
+}
@@ -71,6 +71,115 @@ namespace PhysIKA
 		position_new[pId] = position[pId] + lambda_prime *delta_p;
 	}
 
+	//shared-memory capacity of the direct strand solver, in constraints
+	#define ODE_MAX_DIRECT 512
+
+	/**
+	 * One strand per block. The distance constraints of a chain couple only
+	 * through their shared particles, so the Schur complement J M^-1 J^T is
+	 * tridiagonal: diagonal w_i + w_{i+1}, off-diagonal -w * (n_i . n_j) of
+	 * adjacent segment directions. The system A lambda = -C is solved
+	 * exactly with parallel cyclic reduction on the linearization around the
+	 * current directions, and the positions move by the weighted constraint
+	 * gradients scaled with the multipliers.
+	 */
+	template <typename Real, typename Coord>
+	__global__ void ODE_SolveStrandDirect(
+		DeviceArray<Coord> position_new,
+		DeviceArray<Coord> position,
+		DeviceArray<Real> mass,
+		Real distance,
+		Real stiffness,
+		int strandLen)
+	{
+		__shared__ Real sA[2][ODE_MAX_DIRECT];
+		__shared__ Real sB[2][ODE_MAX_DIRECT];
+		__shared__ Real sC[2][ODE_MAX_DIRECT];
+		__shared__ Real sD[2][ODE_MAX_DIRECT];
+		__shared__ Real sNx[ODE_MAX_DIRECT];
+		__shared__ Real sNy[ODE_MAX_DIRECT];
+		__shared__ Real sNz[ODE_MAX_DIRECT];
+		__shared__ Real sLam[ODE_MAX_DIRECT];
+
+		int base = blockIdx.x * strandLen;
+		int m = strandLen - 1;
+
+		//assemble one row per constraint
+		for (int i = threadIdx.x; i < m; i += blockDim.x)
+		{
+			Coord d = position[base + i] - position[base + i + 1];
+			Real len = d.norm();
+			Coord n = len > EPSILON ? d * (Real(1) / len) : Coord(1, 0, 0);
+
+			sNx[i] = n[0];
+			sNy[i] = n[1];
+			sNz[i] = n[2];
+
+			sB[0][i] = Real(1) / mass[base + i] + Real(1) / mass[base + i + 1];
+			sD[0][i] = -(len - distance);
+		}
+		__syncthreads();
+
+		for (int i = threadIdx.x; i < m; i += blockDim.x)
+		{
+			Real dotPrev = i > 0     ? sNx[i - 1] * sNx[i] + sNy[i - 1] * sNy[i] + sNz[i - 1] * sNz[i] : Real(0);
+			Real dotNext = i < m - 1 ? sNx[i] * sNx[i + 1] + sNy[i] * sNy[i + 1] + sNz[i] * sNz[i + 1] : Real(0);
+
+			sA[0][i] = i > 0     ? -dotPrev / mass[base + i]     : Real(0);
+			sC[0][i] = i < m - 1 ? -dotNext / mass[base + i + 1] : Real(0);
+		}
+		__syncthreads();
+
+		//parallel cyclic reduction; rows outside the strand act as identity
+		int cur = 0;
+		for (int s = 1; s < m; s <<= 1)
+		{
+			int nxt = 1 - cur;
+			for (int i = threadIdx.x; i < m; i += blockDim.x)
+			{
+				int lo = i - s;
+				int hi = i + s;
+
+				Real alpha = lo >= 0 ? -sA[cur][i] / sB[cur][lo] : Real(0);
+				Real gamma = hi < m  ? -sC[cur][i] / sB[cur][hi] : Real(0);
+
+				sA[nxt][i] = lo >= 0 ? alpha * sA[cur][lo] : Real(0);
+				sC[nxt][i] = hi < m  ? gamma * sC[cur][hi] : Real(0);
+				sB[nxt][i] = sB[cur][i]
+					+ (lo >= 0 ? alpha * sC[cur][lo] : Real(0))
+					+ (hi < m  ? gamma * sA[cur][hi] : Real(0));
+				sD[nxt][i] = sD[cur][i]
+					+ (lo >= 0 ? alpha * sD[cur][lo] : Real(0))
+					+ (hi < m  ? gamma * sD[cur][hi] : Real(0));
+			}
+			__syncthreads();
+			cur = nxt;
+		}
+
+		for (int i = threadIdx.x; i < m; i += blockDim.x)
+		{
+			sLam[i] = sD[cur][i] / sB[cur][i];
+		}
+		__syncthreads();
+
+		//dp_k = w_k * (lambda_k n_k - lambda_{k-1} n_{k-1})
+		for (int k = threadIdx.x; k < strandLen; k += blockDim.x)
+		{
+			Coord dp = Coord(0);
+			if (k < m)
+			{
+				dp += sLam[k] * Coord(sNx[k], sNy[k], sNz[k]);
+			}
+			if (k > 0)
+			{
+				dp -= sLam[k - 1] * Coord(sNx[k - 1], sNy[k - 1], sNz[k - 1]);
+			}
+			dp *= Real(1) / mass[base + k];
+
+			position_new[base + k] = position[base + k] + stiffness * dp;
+		}
+	}
+
 	template <typename Real, typename Coord>
 	__global__ void ODE_UpdateVelocity(
 		DeviceArray<Coord> velArr,
@@ -106,12 +215,49 @@ namespace PhysIKA
 	{
 	}
 
+	template<typename TDataType>
+	bool OneDimElasticityModule<TDataType>::trySolveDirect()
+	{
+		int num = m_position.getElementCount();
+
+		int strandLen = m_strandLength <= 1 ? num : m_strandLength;
+		if (strandLen < 2 || strandLen - 1 > ODE_MAX_DIRECT || num % strandLen != 0)
+		{
+			return false;
+		}
+
+		int strands = num / strandLen;
+
+		//one relinearization pass absorbs most of the rotation nonlinearity
+		for (int pass = 0; pass < 2; pass++)
+		{
+			Function1Pt::copy(m_position_buf, m_position.getValue());
+
+			ODE_SolveStrandDirect << <strands, BLOCK_SIZE >> > (
+				m_position.getValue(),
+				m_position_buf,
+				m_mass.getValue(),
+				m_distance.getValue(),
+				m_lambda.getValue(),
+				strandLen);
+			cuSynchronize();
+		}
+
+		return true;
+	}
+
 	template<typename TDataType>
 	void OneDimElasticityModule<TDataType>::solveElasticity()
 	{
 		//Save new positions
 		Function1Pt::copy(m_position_old, m_position.getValue());
-		
+
+		if (m_direct && trySolveDirect())
+		{
+			this->updateVelocity();
+			return;
+		}
+
 		int itor = 0;
 		Real lambda_prime = 1 - pow(1 - m_lambda.getValue(), 1 / Real(m_iterNum.getValue()));
 		while (itor < m_iterNum.getValue())
@@ -0,0 +1,270 @@
+#include "ParticleCachePlayer.h"
+#include "Framework/Topology/PointSet.h"
+#include "Core/Utility.h"
+#include "IO/Particle_Cache/ParticleCache.h"
+
+#include <cstdio>
+#include <sstream>
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(ParticleCachePlayer, TDataType)
+
+	template<typename TDataType>
+	ParticleCachePlayer<TDataType>::ParticleCachePlayer(std::string name)
+		: Node(name)
+	{
+		m_pSet = std::make_shared<PointSet<TDataType>>();
+		this->setTopologyModule(m_pSet);
+	}
+
+	template<typename TDataType>
+	ParticleCachePlayer<TDataType>::~ParticleCachePlayer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_shutdown = true;
+		}
+		m_wakeup.notify_all();
+		if (m_prefetcher.joinable())
+		{
+			m_prefetcher.join();
+		}
+
+		for (auto it = m_cached.begin(); it != m_cached.end(); ++it)
+		{
+			releaseFrame(it->second);
+		}
+	}
+
+	template<typename TDataType>
+	std::string ParticleCachePlayer<TDataType>::frameFileName(int frame)
+	{
+		std::stringstream ss; ss << frame;
+		return m_path + m_prefix + ss.str() + std::string(".pcache");
+	}
+
+	template<typename TDataType>
+	void ParticleCachePlayer<TDataType>::setCache(std::string path, std::string prefix)
+	{
+		m_path = path;
+		m_prefix = prefix;
+
+		//count the consecutive frames present on disk
+		m_frame_count = 0;
+		for (;;)
+		{
+			FILE* fp = fopen(frameFileName(m_frame_count).c_str(), "rb");
+			if (fp == nullptr) break;
+			fclose(fp);
+			m_frame_count++;
+		}
+	}
+
+	template<typename TDataType>
+	void ParticleCachePlayer<TDataType>::setPrefetchCount(int num)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_prefetch_num = num < 1 ? 1 : num;
+		}
+		m_wakeup.notify_all();
+	}
+
+	template<typename TDataType>
+	int ParticleCachePlayer<TDataType>::getFrameCount()
+	{
+		return m_frame_count;
+	}
+
+	template<typename TDataType>
+	bool ParticleCachePlayer<TDataType>::initialize()
+	{
+		if (m_frame_count > 0 && !m_prefetcher.joinable())
+		{
+			m_prefetcher = std::thread(&ParticleCachePlayer<TDataType>::prefetchLoop, this);
+		}
+
+		return gotoFrame(0);
+	}
+
+	template<typename TDataType>
+	bool ParticleCachePlayer<TDataType>::readFrame(int frame, PinnedFrame& out)
+	{
+		std::lock_guard<std::mutex> lock(m_reader_mutex);
+
+		if (frame != m_reader_next)
+		{
+			//non-sequential access: restart decoding at the covering keyframe
+			int back = ParticleCacheDeltaReader::keyDistance(frameFileName(frame));
+			if (back < 0)
+			{
+				return false;
+			}
+
+			m_reader.reset();
+			for (int f = frame - back; f < frame; f++)
+			{
+				if (!m_reader.open(frameFileName(f)))
+				{
+					m_reader_next = -1;
+					return false;
+				}
+			}
+		}
+
+		if (!m_reader.open(frameFileName(frame)) || m_reader.getRealBytes() != sizeof(Real))
+		{
+			m_reader.reset();
+			m_reader_next = -1;
+			return false;
+		}
+		m_reader_next = frame + 1;
+
+		const void* positions = m_reader.getPositions();
+		if (positions == nullptr && m_reader.getParticleNum() > 0)
+		{
+			return false;
+		}
+
+		out.num = m_reader.getParticleNum();
+
+		size_t elements = size_t(out.num) * 3;
+		if (out.capacity < elements)
+		{
+			releaseFrame(out);
+			cuSafeCall(cudaMallocHost(&out.data, elements * sizeof(Real)));
+			out.capacity = elements;
+		}
+		if (elements > 0)
+		{
+			memcpy(out.data, positions, elements * sizeof(Real));
+		}
+
+		return true;
+	}
+
+	template<typename TDataType>
+	bool ParticleCachePlayer<TDataType>::upload(PinnedFrame& frame)
+	{
+		DeviceArray<Coord>& points = m_pSet->getPoints();
+		if (points.size() != frame.num)
+		{
+			points.resize(frame.num);
+		}
+		if (frame.num > 0)
+		{
+			cuSafeCall(cudaMemcpy(points.getDataPtr(), frame.data, frame.num * sizeof(Coord), cudaMemcpyHostToDevice));
+		}
+		return true;
+	}
+
+	template<typename TDataType>
+	void ParticleCachePlayer<TDataType>::releaseFrame(PinnedFrame& frame)
+	{
+		if (frame.data != nullptr)
+		{
+			cudaFreeHost(frame.data);
+			frame.data = nullptr;
+			frame.capacity = 0;
+		}
+	}
+
+	template<typename TDataType>
+	bool ParticleCachePlayer<TDataType>::gotoFrame(int frame)
+	{
+		if (frame < 0 || frame >= m_frame_count)
+		{
+			return false;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_current = frame;
+
+		auto it = m_cached.find(frame);
+		if (it != m_cached.end())
+		{
+			//upload under the lock so the prefetcher cannot evict the
+			//frame mid-copy; the window re-centering keeps it anyway
+			bool ok = upload(it->second);
+			lock.unlock();
+			m_wakeup.notify_all();
+			return ok;
+		}
+		lock.unlock();
+		m_wakeup.notify_all();
+
+		//cold scrub target: read it on the calling thread while the
+		//prefetcher fills the window around it
+		PinnedFrame tmp;
+		bool ok = readFrame(frame, tmp) && upload(tmp);
+		releaseFrame(tmp);
+		return ok;
+	}
+
+	template<typename TDataType>
+	void ParticleCachePlayer<TDataType>::advance(Real dt)
+	{
+		if (m_current + 1 < m_frame_count)
+		{
+			gotoFrame(m_current + 1);
+		}
+	}
+
+	template<typename TDataType>
+	void ParticleCachePlayer<TDataType>::prefetchLoop()
+	{
+		for (;;)
+		{
+			int target = -1;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_wakeup.wait(lock, [&] {
+					if (m_shutdown) return true;
+
+					int last = m_current + m_prefetch_num;
+					if (last > m_frame_count) last = m_frame_count;
+					for (int i = m_current; i < last; i++)
+					{
+						if (m_cached.find(i) == m_cached.end())
+						{
+							target = i;
+							return true;
+						}
+					}
+					return false;
+				});
+				if (m_shutdown) return;
+
+				//evict frames that left the read-ahead window
+				for (auto it = m_cached.begin(); it != m_cached.end();)
+				{
+					if (it->first < m_current || it->first >= m_current + m_prefetch_num)
+					{
+						releaseFrame(it->second);
+						it = m_cached.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+			}
+
+			PinnedFrame frame;
+			readFrame(target, frame);  //a failed read caches an empty marker, avoiding a retry loop
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_cached.find(target) == m_cached.end())
+				{
+					m_cached[target] = frame;
+				}
+				else
+				{
+					releaseFrame(frame);
+				}
+			}
+		}
+	}
+}
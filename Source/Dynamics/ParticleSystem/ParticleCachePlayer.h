@@ -0,0 +1,96 @@
+#pragma once
+#include "Framework/Framework/Node.h"
+#include "Framework/Framework/CachePlayback.h"
+#include "IO/Particle_Cache/ParticleCacheDelta.h"
+
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace PhysIKA
+{
+	template <typename TDataType> class PointSet;
+
+	/*!
+	*	\class	ParticleCachePlayer
+	*	\brief	Replays binary particle caches written by ParticleWriter.
+	*
+	*	The node streams frames path + prefix + <index> + ".pcache" from
+	*	disk into its point set instead of simulating. A prefetcher thread
+	*	keeps a read-ahead window of frames in pinned host memory, so
+	*	sequential playback and timeline scrubbing upload from RAM instead
+	*	of waiting on disk; jumping to an arbitrary frame re-centers the
+	*	window there. Caches far larger than device memory stay scrubbable
+	*	since only the window is resident. Delta-compressed caches (see
+	*	ParticleCacheDelta) decode transparently; a scrub into the middle of
+	*	a delta run restarts decoding from the covering keyframe.
+	*/
+	template<typename TDataType>
+	class ParticleCachePlayer : public Node, public CachePlayback
+	{
+		DECLARE_CLASS_1(ParticleCachePlayer, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		ParticleCachePlayer(std::string name = "default");
+		virtual ~ParticleCachePlayer();
+
+		/**
+		 * @brief Frame files are path + prefix + <index> + ".pcache",
+		 * indexed from 0 as ParticleWriter writes them.
+		 */
+		void setCache(std::string path, std::string prefix);
+
+		void setPrefetchCount(int num);
+
+		int getFrameCount() override;
+		bool gotoFrame(int frame) override;
+
+		void advance(Real dt) override;
+		bool initialize() override;
+
+	private:
+		struct PinnedFrame
+		{
+			Real* data = nullptr;
+			size_t capacity = 0;
+			unsigned int num = 0;
+		};
+
+		std::string frameFileName(int frame);
+		bool readFrame(int frame, PinnedFrame& out);
+		bool upload(PinnedFrame& frame);
+		void releaseFrame(PinnedFrame& frame);
+		void prefetchLoop();
+
+		std::shared_ptr<PointSet<TDataType>> m_pSet;
+
+		std::string m_path;
+		std::string m_prefix;
+
+		int m_frame_count = 0;
+		int m_current = 0;
+		int m_prefetch_num = 8;
+
+		//delta frames decode sequentially against the previous two frames;
+		//one shared reader with its own lock serves both the prefetcher and
+		//direct reads, walking back to the keyframe on non-sequential access
+		std::mutex m_reader_mutex;
+		ParticleCacheDeltaReader m_reader;
+		int m_reader_next = 0;
+
+		std::map<int, PinnedFrame> m_cached;
+		std::thread m_prefetcher;
+		std::mutex m_mutex;
+		std::condition_variable m_wakeup;
+		bool m_shutdown = false;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class ParticleCachePlayer<DataType3f>;
+#else
+	template class ParticleCachePlayer<DataType3d>;
+#endif
+}
@@ -0,0 +1,114 @@
+#include <cuda_runtime.h>
+#include "ParticleCompaction.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA {
+
+	template<typename Coord>
+	__global__ void PC_MarkInsideBox(
+		DeviceArray<int> flags,
+		DeviceArray<Coord> posArr,
+		Coord lo,
+		Coord hi)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord p = posArr[pId];
+		bool inside =
+			p[0] >= lo[0] && p[0] <= hi[0] &&
+			p[1] >= lo[1] && p[1] <= hi[1] &&
+			p[2] >= lo[2] && p[2] <= hi[2];
+
+		flags[pId] = inside ? 1 : 0;
+	}
+
+	template<typename Coord>
+	__global__ void PC_Scatter(
+		DeviceArray<Coord> bufPos,
+		DeviceArray<Coord> bufVel,
+		DeviceArray<Coord> bufForce,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<Coord> forceArr,
+		DeviceArray<int> flags,
+		DeviceArray<int> offsets)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		if (flags[pId] == 1)
+		{
+			int target = offsets[pId];
+			bufPos[target] = posArr[pId];
+			bufVel[target] = velArr[pId];
+			bufForce[target] = forceArr[pId];
+		}
+	}
+
+	template<typename TDataType>
+	ParticleCompaction<TDataType>::ParticleCompaction()
+	{
+	}
+
+	template<typename TDataType>
+	ParticleCompaction<TDataType>::~ParticleCompaction()
+	{
+		m_offsets.release();
+		m_bufPos.release();
+		m_bufVel.release();
+		m_bufForce.release();
+	}
+
+	template<typename TDataType>
+	void ParticleCompaction<TDataType>::markInsideBox(DeviceArray<int>& flags, DeviceArray<Coord>& pos, Coord lo, Coord hi)
+	{
+		cuExecute(pos.size(), PC_MarkInsideBox,
+			flags,
+			pos,
+			lo,
+			hi);
+	}
+
+	template<typename TDataType>
+	int ParticleCompaction<TDataType>::compact(DeviceArray<int>& flags, DeviceArray<Coord>& pos, DeviceArray<Coord>& vel, DeviceArray<Coord>& force)
+	{
+		int num = pos.size();
+		if (num == 0) return 0;
+
+		if (m_offsets.size() != num)
+		{
+			m_offsets.resize(num);
+			m_bufPos.resize(num);
+			m_bufVel.resize(num);
+			m_bufForce.resize(num);
+		}
+
+		m_scan.exclusive(m_offsets, flags);
+
+		//the new count is the last offset plus the last flag
+		int lastOffset = 0;
+		int lastFlag = 0;
+		cuSafeCall(cudaMemcpy(&lastOffset, m_offsets.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastFlag, flags.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		int newNum = lastOffset + lastFlag;
+
+		if (newNum == num) return num;
+
+		cuExecute(num, PC_Scatter,
+			m_bufPos,
+			m_bufVel,
+			m_bufForce,
+			pos,
+			vel,
+			force,
+			flags,
+			m_offsets);
+
+		cuSafeCall(cudaMemcpy(pos.getDataPtr(), m_bufPos.getDataPtr(), newNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+		cuSafeCall(cudaMemcpy(vel.getDataPtr(), m_bufVel.getDataPtr(), newNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+		cuSafeCall(cudaMemcpy(force.getDataPtr(), m_bufForce.getDataPtr(), newNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+
+		return newNum;
+	}
+}
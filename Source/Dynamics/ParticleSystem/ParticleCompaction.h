@@ -0,0 +1,55 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Core/Utility/Scan.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	ParticleCompaction
+	*	\brief	Stream compaction of particle state on the device.
+	*
+	*	Removing particles used to require a host round-trip: download the
+	*	positions, filter, re-upload. This helper keeps the whole pipeline on
+	*	the GPU: a predicate kernel writes keep flags, an exclusive Scan turns
+	*	them into scatter offsets, and one gather pass moves the surviving
+	*	position/velocity/force triples to the front. Only the new count
+	*	crosses back to the host.
+	*/
+	template<typename TDataType>
+	class ParticleCompaction
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		ParticleCompaction();
+		~ParticleCompaction();
+
+		/*!
+		*	\brief	Flag the particles inside the axis-aligned box with 1.
+		*/
+		void markInsideBox(DeviceArray<int>& flags, DeviceArray<Coord>& pos, Coord lo, Coord hi);
+
+		/*!
+		*	\brief	Move the flagged particles to the front of all three
+		*	arrays, keeping their relative order, and return the new count.
+		*	The trailing entries are left untouched; shrink the arrays at the
+		*	call site.
+		*/
+		int compact(DeviceArray<int>& flags, DeviceArray<Coord>& pos, DeviceArray<Coord>& vel, DeviceArray<Coord>& force);
+
+	private:
+		Scan m_scan;
+
+		DeviceArray<int> m_offsets;
+		DeviceArray<Coord> m_bufPos;
+		DeviceArray<Coord> m_bufVel;
+		DeviceArray<Coord> m_bufForce;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class ParticleCompaction<DataType3f>;
+#else
+	template class ParticleCompaction<DataType3d>;
+#endif
+}
@@ -152,4 +152,10 @@ namespace PhysIKA
 		return mapping;
 	}
 
+
+#ifdef PRECISION_FLOAT
+	template class ParticleElasticBody<DataType3f>;
+#else
+	template class ParticleElasticBody<DataType3d>;
+#endif
 }
\ No newline at end of file
@@ -44,8 +44,8 @@ namespace PhysIKA
 	};
 
 #ifdef PRECISION_FLOAT
-	template class ParticleElasticBody<DataType3f>;
+	extern template class ParticleElasticBody<DataType3f>;
 #else
-	template class ParticleElasticBody<DataType3d>;
+	extern template class ParticleElasticBody<DataType3d>;
 #endif
 }
\ No newline at end of file
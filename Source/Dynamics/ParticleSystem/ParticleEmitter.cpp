@@ -17,7 +17,7 @@ namespace PhysIKA
 	template<typename TDataType>
 	void ParticleEmitter<TDataType>::generateParticles()
 	{
-
+		gen_num = 0;
 	}
 
 	template<typename TDataType>
@@ -26,52 +26,47 @@ namespace PhysIKA
 		generateParticles();
 
 		int cur_size = this->currentPosition()->getElementCount();
+		int gen_size = this->gen_num;
+		int total_num = cur_size + gen_size;
+
+		if (total_num == 0) return;
 
 		if (cur_size > 0)
 		{
-			DeviceArray<Coord>& cur_points0 = this->currentPosition()->getValue();
-			DeviceArray<Coord>& cur_vels0 = this->currentVelocity()->getValue();
-			DeviceArray<Coord>& cur_forces0 = this->currentForce()->getValue();
-
-			pos_buf.resize(cur_size);
-			vel_buf.resize(cur_size);
-			force_buf.resize(cur_size);
-
-			Function1Pt::copy(pos_buf, cur_points0);
-			Function1Pt::copy(vel_buf, cur_vels0);
-			Function1Pt::copy(force_buf, cur_forces0);
+			//grow-only staging, so the append stops reallocating every frame
+			if (pos_buf.size() < cur_size)
+			{
+				pos_buf.resize(cur_size);
+				vel_buf.resize(cur_size);
+				force_buf.resize(cur_size);
+			}
+
+			cudaMemcpy(pos_buf.getDataPtr(), this->currentPosition()->getValue().getDataPtr(), cur_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
+			cudaMemcpy(vel_buf.getDataPtr(), this->currentVelocity()->getValue().getDataPtr(), cur_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
+			cudaMemcpy(force_buf.getDataPtr(), this->currentForce()->getValue().getDataPtr(), cur_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
 		}
 
+		this->currentPosition()->setElementCount(total_num);
+		this->currentVelocity()->setElementCount(total_num);
+		this->currentForce()->setElementCount(total_num);
 
-		int total_num = cur_size + gen_pos.size();
+		DeviceArray<Coord>& cur_points = this->currentPosition()->getValue();
+		DeviceArray<Coord>& cur_vels = this->currentVelocity()->getValue();
+		DeviceArray<Coord>& cur_forces = this->currentForce()->getValue();
 
-		if (total_num > 0)
+		if (cur_size > 0)
 		{
-			this->currentPosition()->setElementCount(cur_size + gen_pos.size());
-			this->currentVelocity()->setElementCount(cur_size + gen_pos.size());
-			this->currentForce()->setElementCount(cur_size + gen_pos.size());
-
-			//printf("%d %d %d\n", cur_size, gen_pos.size(), this->currentPosition()->getElementCount());
-
-			DeviceArray<Coord>& cur_points = this->currentPosition()->getValue();
-			DeviceArray<Coord>& cur_vels = this->currentVelocity()->getValue();
-			DeviceArray<Coord>& cur_forces = this->currentForce()->getValue();
-
-			cur_points.reset();
-			cur_vels.reset();
-			cur_forces.reset();
-
 			cudaMemcpy(cur_points.getDataPtr(), pos_buf.getDataPtr(), cur_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
-			cudaMemcpy(cur_points.getDataPtr() + cur_size, gen_pos.getDataPtr(), gen_pos.size() * sizeof(Coord), cudaMemcpyDeviceToDevice);
-
 			cudaMemcpy(cur_vels.getDataPtr(), vel_buf.getDataPtr(), cur_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
-			cudaMemcpy(cur_vels.getDataPtr() + cur_size, gen_vel.getDataPtr(), gen_pos.size() * sizeof(Coord), cudaMemcpyDeviceToDevice);
-
 			cudaMemcpy(cur_forces.getDataPtr(), force_buf.getDataPtr(), cur_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
-			cudaMemcpy(cur_forces.getDataPtr() + cur_size, gen_pos.getDataPtr(), gen_pos.size() * sizeof(Coord), cudaMemcpyDeviceToDevice);
+		}
 
+		if (gen_size > 0)
+		{
+			cudaMemcpy(cur_points.getDataPtr() + cur_size, gen_pos.getDataPtr(), gen_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
+			cudaMemcpy(cur_vels.getDataPtr() + cur_size, gen_vel.getDataPtr(), gen_size * sizeof(Coord), cudaMemcpyDeviceToDevice);
+			cudaMemset(cur_forces.getDataPtr() + cur_size, 0, gen_size * sizeof(Coord));
 		}
-		//return;
 	}
 	template<typename TDataType>
 	void ParticleEmitter<TDataType>::advance(Real dt)
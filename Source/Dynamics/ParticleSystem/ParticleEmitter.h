@@ -42,6 +42,15 @@ namespace PhysIKA
 		DeviceArray<Coord> vel_buf;
 		DeviceArray<Coord> force_buf;
 		int sum = 0;
+
+		//device-side spawning state: gen_num is the number of valid entries
+		//in gen_pos / gen_vel (their capacity is the candidate lattice of
+		//the emitter shape), m_spawnCursor is the atomic slot cursor the
+		//spawn kernels bump and m_spawnSeed decorrelates the per-frame
+		//random draws
+		int gen_num = 0;
+		DeviceArray<int> m_spawnCursor;
+		int m_spawnSeed = 0;
 	private:
 		
 	};
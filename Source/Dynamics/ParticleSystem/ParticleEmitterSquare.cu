@@ -0,0 +1,133 @@
+#include <cuda_runtime.h>
+#include "ParticleEmitterSquare.h"
+#include "Core/Utility.h"
+#include "Core/Utility/CudaRand.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(ParticleEmitterSquare, TDataType)
+
+	//one thread per lattice candidate on the emitter rectangle; accepted
+	//samples claim a slot through the atomic cursor, so there is no
+	//host-side generation loop and no upload
+	template<typename Real, typename Coord, typename Matrix>
+	__global__ void PE_SpawnSquare(
+		DeviceArray<Coord> genPos,
+		DeviceArray<Coord> genVel,
+		int* cursor,
+		int nx,
+		int nz,
+		Real spacing,
+		Real w,
+		Real h,
+		Matrix rotation,
+		Coord center,
+		Coord velocity,
+		int seed)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= nx * nz) return;
+
+		Real x = -w + (tId % nx) * spacing;
+		Real z = -h + (tId / nx) * spacing;
+
+		RandNumber gen(seed + tId);
+		if (gen.Generate() >= Real(1.0 / 40.0)) return;
+
+		int slot = atomicAdd(cursor, 1);
+		if (slot >= genPos.size()) return;
+
+		Coord p = Coord(x, 0, z);
+		genPos[slot] = rotation * p + center;
+		genVel[slot] = velocity;
+	}
+
+	template<typename TDataType>
+	ParticleEmitterSquare<TDataType>::ParticleEmitterSquare(std::string name)
+		: ParticleEmitter<TDataType>(name)
+	{
+		this->varSamplingDistance()->setMin(0.001f);
+		this->varVelocityMagnitude()->setMax(10.0f);
+	}
+
+
+
+	template<typename TDataType>
+	ParticleEmitterSquare<TDataType>::~ParticleEmitterSquare()
+	{
+		gen_pos.release();
+	}
+	
+
+	template<typename TDataType>
+	void ParticleEmitterSquare<TDataType>::generateParticles()
+	{
+		auto sampling_distance = this->varSamplingDistance()->getValue();
+		if (sampling_distance < EPSILON)
+			sampling_distance = 0.005;
+		auto center = this->varLocation()->getValue();
+
+		auto rot_vec = this->varRotation()->getValue();
+
+		Quaternion<Real> quat = Quaternion<float>::Identity();
+		float x_rad = rot_vec[0] / 180.0f * M_PI;
+		float y_rad = rot_vec[1] / 180.0f * M_PI;
+		float z_rad = rot_vec[2] / 180.0f * M_PI;
+
+		quat = quat * Quaternion<Real>(x_rad, Coord(1, 0, 0));
+		quat = quat * Quaternion<Real>(y_rad, Coord(0, 1, 0));
+		quat = quat * Quaternion<Real>(z_rad, Coord(0, 0, 1));
+
+		auto rot_mat = quat.get3x3Matrix();
+
+		Coord v0 = this->varVelocityMagnitude()->getValue()*rot_mat*Vector3f(0, -1, 0);
+
+		auto w = this->varWidth()->getValue();
+		auto h = this->varHeight()->getValue();
+
+		int nx = (int)floor(2 * w / sampling_distance) + 1;
+		int nz = (int)floor(2 * h / sampling_distance) + 1;
+		int candidates = nx * nz;
+		if (candidates <= 0)
+		{
+			this->gen_num = 0;
+			return;
+		}
+
+		//the candidate lattice bounds the spawn count, so the pools are
+		//grown once and reused; the steady state allocates nothing
+		if (gen_pos.size() < candidates)
+		{
+			gen_pos.resize(candidates);
+			gen_vel.resize(candidates);
+		}
+		if (m_spawnCursor.size() == 0)
+		{
+			m_spawnCursor.resize(1);
+		}
+		cuSafeCall(cudaMemset(m_spawnCursor.getDataPtr(), 0, sizeof(int)));
+
+		cuExecute(candidates, PE_SpawnSquare,
+			gen_pos,
+			gen_vel,
+			m_spawnCursor.getDataPtr(),
+			nx,
+			nz,
+			sampling_distance,
+			w,
+			h,
+			rot_mat,
+			center,
+			v0,
+			m_spawnSeed);
+
+		//only the accepted count crosses back to the host
+		int spawned = 0;
+		cuSafeCall(cudaMemcpy(&spawned, m_spawnCursor.getDataPtr(), sizeof(int), cudaMemcpyDeviceToHost));
+		this->gen_num = spawned < candidates ? spawned : candidates;
+
+		m_spawnSeed += candidates;
+	}
+
+	
+}
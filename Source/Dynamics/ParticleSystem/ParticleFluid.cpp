@@ -4,6 +4,7 @@
 #include "Framework/Topology/PointSet.h"
 #include "Core/Utility.h"
 #include "SummationDensity.h"
+#include "ParticleSleeping.h"
 
 #include <time.h>
 
@@ -129,6 +130,22 @@ namespace PhysIKA
 	}
 
 
+	template<typename TDataType>
+	std::shared_ptr<ParticleSleeping<TDataType>> ParticleFluid<TDataType>::enableParticleSleeping(Real h, Coord lo, Coord hi)
+	{
+		auto sleeping = this->template getModule<ParticleSleeping<TDataType>>("particle_sleeping");
+		if (sleeping == nullptr)
+		{
+			sleeping = this->template addComputeModule<ParticleSleeping<TDataType>>("particle_sleeping");
+			this->currentPosition()->connect(sleeping->inPosition());
+			this->currentVelocity()->connect(sleeping->inVelocity());
+		}
+
+		sleeping->setSpace(h, lo, hi);
+
+		return sleeping;
+	}
+
 	template<typename TDataType>
 	bool PhysIKA::ParticleFluid<TDataType>::resetStatus()
 	{
@@ -145,4 +162,10 @@ namespace PhysIKA
 		return true;
 	}
 
+
+#ifdef PRECISION_FLOAT
+	template class ParticleFluid<DataType3f>;
+#else
+	template class ParticleFluid<DataType3d>;
+#endif
 }
\ No newline at end of file
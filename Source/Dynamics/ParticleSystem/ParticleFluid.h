@@ -12,6 +12,8 @@ namespace PhysIKA
 	*	Refer to Macklin and Muller's "Position Based Fluids" for details
 	*
 	*/
+	template<typename TDataType> class ParticleSleeping;
+
 	template<typename TDataType>
 	class ParticleFluid : public ParticleSystem<TDataType>
 	{
@@ -26,13 +28,22 @@ namespace PhysIKA
 		void advance(Real dt) override;
 		bool resetStatus() override;
 
+		/**
+		 * @brief Put settled regions of this fluid to sleep. Registers a
+		 * ParticleSleeping module under "particle_sleeping" that classifies
+		 * the hash cells in [lo, hi] by their velocity statistics each
+		 * step; h should match the solver's smoothing length. Thresholds
+		 * can be tuned on the returned module.
+		 */
+		std::shared_ptr<ParticleSleeping<TDataType>> enableParticleSleeping(Real h, Coord lo, Coord hi);
+
 	private:
 		DEF_NODE_PORTS(ParticleEmitter, ParticleEmitter<TDataType>, "Particle Emitters");
 	};
 
 #ifdef PRECISION_FLOAT
-	template class ParticleFluid<DataType3f>;
+	extern template class ParticleFluid<DataType3f>;
 #else
-	template class ParticleFluid<DataType3d>;
+	extern template class ParticleFluid<DataType3d>;
 #endif
 }
\ No newline at end of file
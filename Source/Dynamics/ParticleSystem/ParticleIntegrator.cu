@@ -4,6 +4,8 @@
 #include "Framework/Framework/FieldVar.h"
 #include "Framework/Framework/Node.h"
 #include "Core/Utility.h"
+#include "Core/Array/ArrayView.h"
+#include "Core/Utility/FunctionFuse.h"
 #include "Framework/Framework/SceneGraph.h"
 
 namespace PhysIKA
@@ -59,7 +61,7 @@ namespace PhysIKA
 	template<typename Real, typename Coord>
 	__global__ void K_UpdateVelocity(
 		DeviceArray<Coord> vel,
-		DeviceArray<Coord> forceDensity,
+		ConstArrayView<Coord> forceDensity,
 		Coord gravity,
 		Real dt)
 	{
@@ -73,8 +75,8 @@ namespace PhysIKA
 	template<typename Real, typename Coord>
 	__global__ void K_UpdateVelocity(
 		DeviceArray<Coord> vel,
-		DeviceArray<Coord> force,
-		DeviceArray<Real> mass,
+		ConstArrayView<Coord> force,
+		ConstArrayView<Real> mass,
 		Real dt)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
@@ -92,7 +94,7 @@ namespace PhysIKA
 		int total_num = this->inPosition()->getElementCount();
 		cuExecute(total_num, K_UpdateVelocity,
 			this->inVelocity()->getValue(),
-			this->inForceDensity()->getValue(),
+			ConstArrayView<Coord>(this->inForceDensity()->getValue()),
 			gravity,
 			dt);
 
@@ -102,7 +104,7 @@ namespace PhysIKA
 	template<typename Real, typename Coord>
 	__global__ void K_UpdatePosition(
 		DeviceArray<Coord> pos,
-		DeviceArray<Coord> vel,
+		ConstArrayView<Coord> vel,
 		Real dt)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
@@ -119,7 +121,7 @@ namespace PhysIKA
 		int total_num = this->inPosition()->getReference()->size();
 		cuExecute(total_num, K_UpdatePosition,
 			this->inPosition()->getValue(),
-			this->inVelocity()->getValue(),
+			ConstArrayView<Coord>(this->inVelocity()->getValue()),
 			dt);
 
 		return true;
@@ -130,10 +132,29 @@ namespace PhysIKA
 	{
 		if (!this->inPosition()->isEmpty())
 		{
-			updateVelocity();
-			updatePosition();
+			//both steps fused into one kernel: the position update reads
+			//the velocity its thread just wrote, so the intermediate
+			//velocities never make an extra round trip through memory
+			Real dt = getParent()->getDt();
+			Coord gravity = SceneGraph::getInstance().getGravity();
+
+			int total_num = this->inPosition()->getElementCount();
+
+			using namespace FunctionFuse;
+			evaluate(total_num,
+				assign(this->inVelocity()->getValue(),
+					term(this->inVelocity()->getValue()) + scale(dt, term(this->inForceDensity()->getValue()) + constant(gravity))),
+				assign(this->inPosition()->getValue(),
+					term(this->inPosition()->getValue()) + scale(dt, term(this->inVelocity()->getValue()))));
+			cuSynchronize();
 		}
 
 		return true;
 	}
+
+#ifdef PRECISION_FLOAT
+	template class ParticleIntegrator<DataType3f>;
+#else
+	template class ParticleIntegrator<DataType3d>;
+#endif
 }
\ No newline at end of file
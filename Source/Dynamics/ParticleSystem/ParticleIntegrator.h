@@ -54,8 +54,8 @@ namespace PhysIKA {
 	};
 
 #ifdef PRECISION_FLOAT
-	template class ParticleIntegrator<DataType3f>;
+	extern template class ParticleIntegrator<DataType3f>;
 #else
- 	template class ParticleIntegrator<DataType3d>;
+ 	extern template class ParticleIntegrator<DataType3d>;
 #endif
 }
\ No newline at end of file
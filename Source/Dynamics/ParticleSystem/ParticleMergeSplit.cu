@@ -0,0 +1,314 @@
+#include <cuda_runtime.h>
+#include "ParticleMergeSplit.h"
+#include "Core/Utility.h"
+#include "Core/Utility/CudaRand.h"
+
+namespace PhysIKA {
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void PMS_TagSurface(
+		DeviceArray<int> surface,
+		DeviceArray<Coord> posArr,
+		GridHash<TDataType> hash,
+		Real radius,
+		int threshold)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos_i = posArr[pId];
+		int3 gId3 = hash.getIndex3(pos_i);
+
+		int counter = 0;
+		for (int c = 0; c < 27; c++)
+		{
+			int cId = hash.getIndex(gId3.x + c % 3 - 1, gId3.y + (c / 3) % 3 - 1, gId3.z + c / 9 - 1);
+			if (cId == INVALID) continue;
+
+			int totalNum = hash.getCounter(cId);
+			for (int n = 0; n < totalNum; n++)
+			{
+				int j = hash.getParticleId(cId, n);
+				Real d_ij = (pos_i - posArr[j]).norm();
+				if (d_ij < radius)
+				{
+					counter++;
+				}
+			}
+		}
+
+		surface[pId] = counter < threshold ? 1 : 0;
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void PMS_DilateSurface(
+		DeviceArray<int> fine,
+		DeviceArray<int> surface,
+		DeviceArray<Coord> posArr,
+		GridHash<TDataType> hash,
+		Real radius)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		if (surface[pId] == 1)
+		{
+			fine[pId] = 1;
+			return;
+		}
+
+		Coord pos_i = posArr[pId];
+		int3 gId3 = hash.getIndex3(pos_i);
+
+		int tagged = 0;
+		for (int c = 0; c < 27 && tagged == 0; c++)
+		{
+			int cId = hash.getIndex(gId3.x + c % 3 - 1, gId3.y + (c / 3) % 3 - 1, gId3.z + c / 9 - 1);
+			if (cId == INVALID) continue;
+
+			int totalNum = hash.getCounter(cId);
+			for (int n = 0; n < totalNum; n++)
+			{
+				int j = hash.getParticleId(cId, n);
+				if (surface[j] == 1 && (pos_i - posArr[j]).norm() < radius)
+				{
+					tagged = 1;
+					break;
+				}
+			}
+		}
+
+		fine[pId] = tagged;
+	}
+
+	//one thread per hash cell; a particle belongs to exactly one cell, so the
+	//in-place merge writes never race
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void PMS_MergeInCell(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<Real> massArr,
+		DeviceArray<int> counts,
+		DeviceArray<int> fine,
+		GridHash<TDataType> hash,
+		Real maxMass)
+	{
+		int cId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (cId >= hash.nx * hash.ny * hash.nz) return;
+
+		int totalNum = hash.getCounter(cId);
+
+		int prev = -1;
+		for (int n = 0; n < totalNum; n++)
+		{
+			int j = hash.getParticleId(cId, n);
+			if (fine[j] == 1) continue;
+
+			if (prev == -1)
+			{
+				prev = j;
+				continue;
+			}
+
+			Real m = massArr[prev] + massArr[j];
+			if (m > maxMass)
+			{
+				prev = j;
+				continue;
+			}
+
+			//combine at the center of mass with the momentum-preserving velocity
+			posArr[prev] = (massArr[prev] * posArr[prev] + massArr[j] * posArr[j]) / m;
+			velArr[prev] = (massArr[prev] * velArr[prev] + massArr[j] * velArr[j]) / m;
+			massArr[prev] = m;
+			counts[j] = 0;
+			prev = -1;
+		}
+	}
+
+	__global__ void PMS_InitCounts(
+		DeviceArray<int> counts)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= counts.size()) return;
+
+		counts[pId] = 1;
+	}
+
+	template<typename Real>
+	__global__ void PMS_SplitCounts(
+		DeviceArray<int> counts,
+		DeviceArray<int> fine,
+		DeviceArray<Real> massArr,
+		Real splitMass)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= counts.size()) return;
+
+		if (counts[pId] == 1 && fine[pId] == 1 && massArr[pId] > splitMass)
+		{
+			counts[pId] = 2;
+		}
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void PMS_Scatter(
+		DeviceArray<Coord> outPos,
+		DeviceArray<Coord> outVel,
+		DeviceArray<Real> outMass,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<Real> massArr,
+		DeviceArray<int> counts,
+		DeviceArray<int> offsets,
+		Real spacing)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		int c = counts[pId];
+		if (c == 0) return;
+
+		int target = offsets[pId];
+
+		if (c == 1)
+		{
+			outPos[target] = posArr[pId];
+			outVel[target] = velArr[pId];
+			outMass[target] = massArr[pId];
+			return;
+		}
+
+		//split into two halves placed symmetrically about the parent: the
+		//total mass, momentum and center of mass are unchanged
+		RandNumber gen(pId);
+		Coord dir;
+		dir[0] = gen.Generate() - Real(0.5);
+		dir[1] = gen.Generate() - Real(0.5);
+		dir[2] = gen.Generate() - Real(0.5);
+		Real len = dir.norm();
+		dir = len < EPSILON ? Coord(Real(1), Real(0), Real(0)) : dir / len;
+
+		Coord offset = Real(0.25) * spacing * dir;
+		Real halfMass = Real(0.5) * massArr[pId];
+
+		outPos[target] = posArr[pId] - offset;
+		outVel[target] = velArr[pId];
+		outMass[target] = halfMass;
+
+		outPos[target + 1] = posArr[pId] + offset;
+		outVel[target + 1] = velArr[pId];
+		outMass[target + 1] = halfMass;
+	}
+
+	template<typename TDataType>
+	ParticleMergeSplit<TDataType>::ParticleMergeSplit()
+		: m_spacing(Real(0.005))
+		, m_lo(Coord(0))
+		, m_hi(Coord(1))
+	{
+	}
+
+	template<typename TDataType>
+	ParticleMergeSplit<TDataType>::~ParticleMergeSplit()
+	{
+		m_hash.release();
+		m_surface.release();
+		m_fine.release();
+		m_counts.release();
+		m_offsets.release();
+		m_outPos.release();
+		m_outVel.release();
+		m_outMass.release();
+	}
+
+	template<typename TDataType>
+	int ParticleMergeSplit<TDataType>::apply(DeviceArray<Coord>& pos, DeviceArray<Coord>& vel, DeviceArray<Real>& mass, Real baseMass)
+	{
+		int num = pos.size();
+		if (num == 0) return 0;
+
+		Real radius = Real(2) * m_spacing;
+
+		if (!m_hashReady)
+		{
+			m_hash.setSpace(radius, m_lo, m_hi);
+			m_hashReady = true;
+		}
+
+		if (m_surface.size() != num)
+		{
+			m_surface.resize(num);
+			m_fine.resize(num);
+			m_counts.resize(num);
+			m_offsets.resize(num);
+		}
+
+		m_hash.clear();
+		m_hash.construct(pos);
+
+		cuExecute(num, PMS_TagSurface,
+			m_surface,
+			pos,
+			m_hash,
+			radius,
+			m_surfaceThreshold);
+
+		cuExecute(num, PMS_DilateSurface,
+			m_fine,
+			m_surface,
+			pos,
+			m_hash,
+			radius);
+
+		//every particle starts alive with one output slot; the merge pass
+		//zeroes the absorbed partners, the split pass doubles the heavy
+		//surface particles
+		cuExecute(num, PMS_InitCounts,
+			m_counts);
+
+		int cellNum = m_hash.nx * m_hash.ny * m_hash.nz;
+		cuExecute(cellNum, PMS_MergeInCell,
+			pos,
+			vel,
+			mass,
+			m_counts,
+			m_fine,
+			m_hash,
+			m_maxMassRatio * baseMass);
+
+		cuExecute(num, PMS_SplitCounts,
+			m_counts,
+			m_fine,
+			mass,
+			Real(1.5) * baseMass);
+
+		m_scan.exclusive(m_offsets, m_counts);
+
+		int lastOffset = 0;
+		int lastCount = 0;
+		cuSafeCall(cudaMemcpy(&lastOffset, m_offsets.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastCount, m_counts.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		int newNum = lastOffset + lastCount;
+
+		if (m_outPos.size() < newNum)
+		{
+			m_outPos.resize(newNum);
+			m_outVel.resize(newNum);
+			m_outMass.resize(newNum);
+		}
+
+		cuExecute(num, PMS_Scatter,
+			m_outPos,
+			m_outVel,
+			m_outMass,
+			pos,
+			vel,
+			mass,
+			m_counts,
+			m_offsets,
+			m_spacing);
+
+		return newNum;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Core/Utility/Scan.h"
+#include "Framework/Topology/GridHash.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	ParticleMergeSplit
+	*	\brief	Spatially adaptive particle resolution on the device.
+	*
+	*	Fluid interiors rarely need the sampling density the free surface
+	*	does. This helper rewrites the particle set once per adaptation
+	*	interval: particles in the fine band (the free surface, detected by a
+	*	low neighbor count, plus one dilation ring) that have accumulated
+	*	more than the base mass are split into two halves, while interior
+	*	particles are pair-merged within their hash cell. Both transfers
+	*	conserve mass and momentum exactly - splits place the halves
+	*	symmetrically about the parent with the parent's velocity, merges
+	*	combine partners at their center of mass with the mass-weighted
+	*	velocity. The whole pass follows the ParticleCompaction idiom: a
+	*	per-particle output count, an exclusive Scan and a single scatter;
+	*	only the new count crosses back to the host.
+	*/
+	template<typename TDataType>
+	class ParticleMergeSplit
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		ParticleMergeSplit();
+		~ParticleMergeSplit();
+
+		/*!
+		*	\brief	Base sampling distance of the fine level; the tagging
+		*	radius is twice this value.
+		*/
+		void setSpacing(Real d) { m_spacing = d; m_hashReady = false; }
+
+		/*!
+		*	\brief	Domain covered by the spatial hash.
+		*/
+		void setBounds(Coord lo, Coord hi) { m_lo = lo; m_hi = hi; m_hashReady = false; }
+
+		/*!
+		*	\brief	Particles with fewer neighbors than this are tagged as
+		*	free surface.
+		*/
+		void setSurfaceNeighborThreshold(int num) { m_surfaceThreshold = num; }
+
+		/*!
+		*	\brief	A merged particle never exceeds factor times the base
+		*	mass, which bounds the coarsening level.
+		*/
+		void setMaxMassRatio(Real factor) { m_maxMassRatio = factor; }
+
+		/*!
+		*	\brief	One adaptation pass over the particle state. The input
+		*	arrays are consumed as scratch; the rewritten set is available
+		*	through the out*() buffers and the new count is returned.
+		*/
+		int apply(DeviceArray<Coord>& pos, DeviceArray<Coord>& vel, DeviceArray<Real>& mass, Real baseMass);
+
+		DeviceArray<Coord>& outPosition() { return m_outPos; }
+		DeviceArray<Coord>& outVelocity() { return m_outVel; }
+		DeviceArray<Real>& outMass() { return m_outMass; }
+
+	private:
+		Real m_spacing;
+		Coord m_lo;
+		Coord m_hi;
+		int m_surfaceThreshold = 22;
+		Real m_maxMassRatio = Real(8);
+
+		bool m_hashReady = false;
+		GridHash<TDataType> m_hash;
+		Scan m_scan;
+
+		DeviceArray<int> m_surface;
+		DeviceArray<int> m_fine;
+		DeviceArray<int> m_counts;
+		DeviceArray<int> m_offsets;
+
+		DeviceArray<Coord> m_outPos;
+		DeviceArray<Coord> m_outVel;
+		DeviceArray<Real> m_outMass;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class ParticleMergeSplit<DataType3f>;
+#else
+	template class ParticleMergeSplit<DataType3d>;
+#endif
+}
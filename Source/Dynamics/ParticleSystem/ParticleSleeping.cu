@@ -0,0 +1,227 @@
+#include <cuda_runtime.h>
+#include "ParticleSleeping.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(ParticleSleeping, TDataType)
+
+	//one thread per cell: mean velocity and velocity variance over the
+	//cell's particles decide whether it keeps solving
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void PS_ClassifyCells(
+		DeviceArray<int> cellActive,
+		DeviceArray<Coord> velArr,
+		GridHash<TDataType> hash,
+		Real vThreshold,
+		Real varThreshold)
+	{
+		int cId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (cId >= cellActive.size()) return;
+
+		int totalNum = hash.getCounter(cId);
+		if (totalNum == 0)
+		{
+			cellActive[cId] = 0;
+			return;
+		}
+
+		Coord mean(0);
+		Real meanSq = Real(0);
+		for (int n = 0; n < totalNum; n++)
+		{
+			Coord v = velArr[hash.getParticleId(cId, n)];
+			mean += v;
+			meanSq += v.normSquared();
+		}
+
+		mean /= Real(totalNum);
+		Real variance = meanSq / Real(totalNum) - mean.normSquared();
+
+		cellActive[cId] = (mean.norm() > vThreshold || variance > varThreshold) ? 1 : 0;
+	}
+
+	//a sleeping cell next to an awake one wakes up, so the interface always
+	//solves with fresh neighbor data and motion can propagate back in
+	template<typename TDataType>
+	__global__ void PS_DilateCells(
+		DeviceArray<int> cellDilated,
+		DeviceArray<int> cellActive,
+		GridHash<TDataType> hash)
+	{
+		int cId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (cId >= cellActive.size()) return;
+
+		if (cellActive[cId] == 1)
+		{
+			cellDilated[cId] = 1;
+			return;
+		}
+
+		int i = cId % hash.nx;
+		int j = (cId / hash.nx) % hash.ny;
+		int k = cId / (hash.nx * hash.ny);
+
+		int tagged = 0;
+		for (int c = 0; c < 27 && tagged == 0; c++)
+		{
+			int nId = hash.getIndex(i + c % 3 - 1, j + (c / 3) % 3 - 1, k + c / 9 - 1);
+			if (nId != INVALID && cellActive[nId] == 1)
+			{
+				tagged = 1;
+			}
+		}
+
+		cellDilated[cId] = tagged;
+	}
+
+	template<typename Coord, typename TDataType>
+	__global__ void PS_ScatterActivity(
+		DeviceArray<int> activity,
+		DeviceArray<int> cellDilated,
+		DeviceArray<Coord> posArr,
+		GridHash<TDataType> hash)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		int cId = hash.getIndex(posArr[pId]);
+		activity[pId] = cId == INVALID ? 1 : cellDilated[cId];
+	}
+
+	template<typename Coord>
+	__global__ void PS_Freeze(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<Coord> prePosArr,
+		DeviceArray<int> activity)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		if (activity[pId] == 0)
+		{
+			posArr[pId] = prePosArr[pId];
+			velArr[pId] = Coord(0);
+		}
+	}
+
+	template<typename TDataType>
+	ParticleSleeping<TDataType>::ParticleSleeping()
+		: ComputeModule()
+		, m_h(Real(0.01))
+		, m_lo(Coord(0))
+		, m_hi(Coord(1))
+		, m_vThreshold(Real(0.01))
+		, m_varThreshold(Real(0.001))
+	{
+	}
+
+	template<typename TDataType>
+	ParticleSleeping<TDataType>::~ParticleSleeping()
+	{
+		m_hash.release();
+		m_cellActive.release();
+		m_cellDilated.release();
+		m_activity.release();
+		m_prePosition.release();
+	}
+
+	template<typename TDataType>
+	void ParticleSleeping<TDataType>::setSpace(Real h, Coord lo, Coord hi)
+	{
+		m_h = h;
+		m_lo = lo;
+		m_hi = hi;
+		m_hashReady = false;
+	}
+
+	template<typename TDataType>
+	void ParticleSleeping<TDataType>::setThresholds(Real vThreshold, Real varThreshold)
+	{
+		m_vThreshold = vThreshold;
+		m_varThreshold = varThreshold;
+	}
+
+	template<typename TDataType>
+	void ParticleSleeping<TDataType>::cache()
+	{
+		if (this->inPosition()->isEmpty()) return;
+
+		int num = this->inPosition()->getElementCount();
+		if (m_prePosition.size() != num)
+		{
+			m_prePosition.resize(num);
+		}
+
+		Function1Pt::copy(m_prePosition, this->inPosition()->getValue());
+	}
+
+	template<typename TDataType>
+	void ParticleSleeping<TDataType>::compute()
+	{
+		if (this->inPosition()->isEmpty()) return;
+
+		int num = this->inPosition()->getElementCount();
+
+		if (!m_hashReady)
+		{
+			m_hash.setSpace(m_h, m_lo, m_hi);
+			m_hashReady = true;
+		}
+
+		if (m_activity.size() != num)
+		{
+			m_activity.resize(num);
+		}
+
+		m_hash.clear();
+		m_hash.construct(this->inPosition()->getValue());
+
+		int cellNum = m_hash.nx * m_hash.ny * m_hash.nz;
+		if (m_cellActive.size() != cellNum)
+		{
+			m_cellActive.resize(cellNum);
+			m_cellDilated.resize(cellNum);
+		}
+
+		cuExecute(cellNum, PS_ClassifyCells,
+			m_cellActive,
+			this->inVelocity()->getValue(),
+			m_hash,
+			m_vThreshold,
+			m_varThreshold);
+
+		cuExecute(cellNum, PS_DilateCells,
+			m_cellDilated,
+			m_cellActive,
+			m_hash);
+
+		cuExecute(num, PS_ScatterActivity,
+			m_activity,
+			m_cellDilated,
+			this->inPosition()->getValue(),
+			m_hash);
+	}
+
+	template<typename TDataType>
+	void ParticleSleeping<TDataType>::freeze()
+	{
+		if (this->inPosition()->isEmpty()) return;
+
+		int num = this->inPosition()->getElementCount();
+		if (m_prePosition.size() != num || m_activity.size() != num) return;
+
+		cuExecute(num, PS_Freeze,
+			this->inPosition()->getValue(),
+			this->inVelocity()->getValue(),
+			m_prePosition,
+			m_activity);
+	}
+
+#ifdef PRECISION_FLOAT
+	template class ParticleSleeping<DataType3f>;
+#else
+	template class ParticleSleeping<DataType3d>;
+#endif
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "Framework/Framework/ModuleCompute.h"
+#include "Framework/Framework/FieldArray.h"
+#include "Framework/Topology/GridHash.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	ParticleSleeping
+	*	\brief	Per-cell activity classification for settled fluid regions.
+	*
+	*	A reservoir is mostly still water once the splash dies down, yet
+	*	every particle keeps paying for the full constraint solve. This
+	*	module classifies the grid-hash cells by their velocity statistics:
+	*	a cell whose mean speed and velocity variance both fall below the
+	*	thresholds is put to sleep, with one ring of dilation so any cell
+	*	adjacent to moving fluid stays awake. The per-particle activity
+	*	mask is handed to DensityPBD, whose default iteration kernels
+	*	early-out on sleeping particles; the dilation ring guarantees that
+	*	every neighbor an awake particle reads carries a fresh lambda.
+	*
+	*	Sleeping particles hold their position (hydrostatic rest) via
+	*	cache()/freeze() around the solve, and wake up automatically the
+	*	moment a neighboring cell starts moving.
+	*/
+	template<typename TDataType>
+	class ParticleSleeping : public ComputeModule
+	{
+		DECLARE_CLASS_1(ParticleSleeping, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		ParticleSleeping();
+		~ParticleSleeping() override;
+
+		/*!
+		*	\brief	Classify the cells and refresh the activity mask.
+		*/
+		void compute() override;
+
+		/*!
+		*	\brief	Snapshot the pre-step positions; call before the
+		*	integrator moves anything.
+		*/
+		void cache();
+
+		/*!
+		*	\brief	Restore the sleeping particles from the snapshot and
+		*	zero their velocity; call after the solve.
+		*/
+		void freeze();
+
+		/*!
+		*	\brief	Cell size of the classification grid; use the solver's
+		*	smoothing length so one dilation ring covers the neighborhood
+		*	an awake particle reads.
+		*/
+		void setSpace(Real h, Coord lo, Coord hi);
+
+		/*!
+		*	\brief	A cell sleeps when its mean speed stays below vThreshold
+		*	and its velocity variance below varThreshold.
+		*/
+		void setThresholds(Real vThreshold, Real varThreshold);
+
+		DeviceArray<int>& getActivity() { return m_activity; }
+
+	public:
+		DEF_EMPTY_IN_ARRAY(Position, Coord, DeviceType::GPU, "Particle position");
+
+		DEF_EMPTY_IN_ARRAY(Velocity, Coord, DeviceType::GPU, "Particle velocity");
+
+	private:
+		Real m_h;
+		Coord m_lo;
+		Coord m_hi;
+		Real m_vThreshold;
+		Real m_varThreshold;
+
+		bool m_hashReady = false;
+		GridHash<TDataType> m_hash;
+
+		DeviceArray<int> m_cellActive;
+		DeviceArray<int> m_cellDilated;
+		DeviceArray<int> m_activity;
+		DeviceArray<Coord> m_prePosition;
+	};
+
+#ifdef PRECISION_FLOAT
+	extern template class ParticleSleeping<DataType3f>;
+#else
+	extern template class ParticleSleeping<DataType3d>;
+#endif
+}
@@ -1,6 +1,8 @@
 #include "ParticleSystem.h"
 #include "PositionBasedFluidModel.h"
+#include "RegionOfInterest.h"
 
+#include "Framework/Framework/FieldGroup.h"
 #include "Framework/Topology/PointSet.h"
 #include "Core/Utility.h"
 
@@ -36,6 +38,19 @@ namespace PhysIKA
 		m_pSet->loadObjFile(filename);
 	}
 
+	//The sample coordinates along one axis, accumulated exactly like the
+	//original scalar loop so the generated positions stay bitwise identical.
+	template<typename Real>
+	static std::vector<Real> sampleAxis(Real lo, Real hi, Real distance)
+	{
+		std::vector<Real> samples;
+		for (Real x = lo; x <= hi; x += distance)
+		{
+			samples.push_back(x);
+		}
+		return samples;
+	}
+
 	template<typename TDataType>
 	void ParticleSystem<TDataType>::loadParticles(Coord center, Real r, Real distance)
 	{
@@ -45,16 +60,54 @@ namespace PhysIKA
 		Coord lo = center - r;
 		Coord hi = center + r;
 
-		for (Real x = lo[0]; x <= hi[0]; x +=  distance)
+		std::vector<Real> xs = sampleAxis(lo[0], hi[0], distance);
+		std::vector<Real> ys = sampleAxis(lo[1], hi[1], distance);
+		std::vector<Real> zs = sampleAxis(lo[2], hi[2], distance);
+
+		int nx = (int)xs.size();
+		int ny = (int)ys.size();
+		int nz = (int)zs.size();
+
+		//count per x-slice first so every slice can be filled in parallel
+		std::vector<int> sliceNum(nx, 0);
+#pragma omp parallel for
+		for (int i = 0; i < nx; i++)
 		{
-			for (Real y = lo[1]; y <= hi[1]; y += distance)
+			int num = 0;
+			for (int j = 0; j < ny; j++)
 			{
-				for (Real z = lo[2]; z <= hi[2]; z += distance)
+				for (int k = 0; k < nz; k++)
 				{
-					Coord p = Coord(x, y, z);
-					if ((p-center).norm() < r)
+					if ((Coord(xs[i], ys[j], zs[k]) - center).norm() < r)
 					{
-						vertList.push_back(Coord(x, y, z));
+						num++;
+					}
+				}
+			}
+			sliceNum[i] = num;
+		}
+
+		std::vector<int> sliceStart(nx, 0);
+		int total = 0;
+		for (int i = 0; i < nx; i++)
+		{
+			sliceStart[i] = total;
+			total += sliceNum[i];
+		}
+
+		vertList.resize(total);
+#pragma omp parallel for
+		for (int i = 0; i < nx; i++)
+		{
+			int w = sliceStart[i];
+			for (int j = 0; j < ny; j++)
+			{
+				for (int k = 0; k < nz; k++)
+				{
+					Coord p = Coord(xs[i], ys[j], zs[k]);
+					if ((p - center).norm() < r)
+					{
+						vertList[w++] = p;
 					}
 				}
 			}
@@ -74,14 +127,24 @@ namespace PhysIKA
 		std::vector<Coord> vertList;
 		std::vector<Coord> normalList;
 
-		for (Real x = lo[0]; x <= hi[0]; x += distance)
+		std::vector<Real> xs = sampleAxis(lo[0], hi[0], distance);
+		std::vector<Real> ys = sampleAxis(lo[1], hi[1], distance);
+		std::vector<Real> zs = sampleAxis(lo[2], hi[2], distance);
+
+		int nx = (int)xs.size();
+		int ny = (int)ys.size();
+		int nz = (int)zs.size();
+
+		vertList.resize((size_t)nx * ny * nz);
+#pragma omp parallel for
+		for (int i = 0; i < nx; i++)
 		{
-			for (Real y = lo[1]; y <= hi[1]; y += distance)
+			size_t w = (size_t)i * ny * nz;
+			for (int j = 0; j < ny; j++)
 			{
-				for (Real z = lo[2]; z <= hi[2]; z += distance)
+				for (int k = 0; k < nz; k++)
 				{
-					Coord p = Coord(x, y, z);
-					vertList.push_back(Coord(x, y, z));
+					vertList[w++] = Coord(xs[i], ys[j], zs[k]);
 				}
 			}
 		}
@@ -113,6 +176,23 @@ namespace PhysIKA
 		return true;
 	}
 
+	template<typename TDataType>
+	std::shared_ptr<RegionOfInterest<TDataType>> ParticleSystem<TDataType>::setRegionOfInterest(Coord lo, Coord hi, Real blendWidth)
+	{
+		auto roi = this->template getModule<RegionOfInterest<TDataType>>("simulation_roi");
+		if (roi == nullptr)
+		{
+			roi = this->template addConstraintModule<RegionOfInterest<TDataType>>("simulation_roi");
+			this->currentPosition()->connect(roi->inPosition());
+			this->currentVelocity()->connect(roi->inVelocity());
+		}
+
+		roi->setBox(lo, hi);
+		roi->setBlendWidth(blendWidth);
+
+		return roi;
+	}
+
 	template<typename TDataType>
 	bool ParticleSystem<TDataType>::initialize()
 	{
@@ -155,9 +235,15 @@ namespace PhysIKA
 
 		if (pts.size() > 0)
 		{
-			this->currentPosition()->setElementCount(pts.size());
-			this->currentVelocity()->setElementCount(pts.size());
-			this->currentForce()->setElementCount(pts.size());
+			//Co-allocate the per-particle state in one structure-of-arrays slab, so
+			//the arrays stay adjacent in memory and a spatial reordering pass can
+			//gather all of them with a single permutation.
+			m_stateGroup = std::make_shared<FieldGroup>();
+			m_stateGroup->reserve(pts.size(), 3 * sizeof(Coord));
+
+			this->currentPosition()->setReference(m_stateGroup->addArray<Coord>());
+			this->currentVelocity()->setReference(m_stateGroup->addArray<Coord>());
+			this->currentForce()->setReference(m_stateGroup->addArray<Coord>());
 
 			Function1Pt::copy(this->currentPosition()->getValue(), pts);
 			this->currentVelocity()->getReference()->reset();
@@ -177,4 +263,10 @@ namespace PhysIKA
 // 
 // 		return m_pointsRender;
 // 	}
+
+#ifdef PRECISION_FLOAT
+	template class ParticleSystem<DataType3f>;
+#else
+	template class ParticleSystem<DataType3d>;
+#endif
 }
\ No newline at end of file
@@ -4,7 +4,9 @@
 
 namespace PhysIKA
 {
+	class FieldGroup;
 	template <typename TDataType> class PointSet;
+	template <typename TDataType> class RegionOfInterest;
 	/*!
 	*	\class	ParticleSystem
 	*	\brief	Position-based fluids.
@@ -33,6 +35,16 @@ namespace PhysIKA
 		virtual bool translate(Coord t);
 		virtual bool scale(Real s);
 
+		/**
+		 * @brief Restrict full dynamics to the axis-aligned box [lo, hi].
+		 * Particles outside follow the far-field velocity set on the
+		 * returned module (zero by default, i.e. frozen); blendWidth is the
+		 * fade between the two regimes, measured inward from the boundary.
+		 * Registers a RegionOfInterest module under "simulation_roi" on
+		 * first use, repeated calls only update the box.
+		 */
+		std::shared_ptr<RegionOfInterest<TDataType>> setRegionOfInterest(Coord lo, Coord hi, Real blendWidth);
+
 
 		void updateTopology() override;
 		bool resetStatus() override;
@@ -62,13 +74,16 @@ namespace PhysIKA
 
 	protected:
 		std::shared_ptr<PointSet<TDataType>> m_pSet;
+
+		//Backing slab that co-allocates the current state arrays, see resetStatus().
+		std::shared_ptr<FieldGroup> m_stateGroup;
 //		std::shared_ptr<PointRenderModule> m_pointsRender;
 	};
 
 
 #ifdef PRECISION_FLOAT
-	template class ParticleSystem<DataType3f>;
+	extern template class ParticleSystem<DataType3f>;
 #else
-	template class ParticleSystem<DataType3d>;
+	extern template class ParticleSystem<DataType3d>;
 #endif
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include "Framework/Framework/MechanicalState.h"
 #include "Framework/Framework/ModuleIO.h"
 #include "Core/Utility/Function1Pt.h"
+#include "Core/Utility/cuda_utilities.h"
+#include "IO/Particle_Cache/ParticleCache.h"
+#include "IO/Particle_Cache/AsyncWriteQueue.h"
+#include "Framework/Framework/MpiContext.h"
 
 #include <sstream>
 #include <iostream>
@@ -44,6 +48,95 @@ namespace PhysIKA
 		printf("===========WRITER============\n");
 		assert(m_position.getElementCount() == m_color_mapping.getElementCount());
 
+		MpiContext& mpi = MpiContext::getInstance();
+
+		//multi-node runs: every rank writes its own subdomain, rank 0 keeps
+		//a merge index so post tools can stitch a frame back together
+		if (mpi.isDistributed() && mpi.rank() == 0 && (m_async_write || m_binary_cache))
+		{
+			std::ofstream index((m_output_path + m_name_prefix + std::string(".mindex")).c_str(), std::ios::app);
+			index << m_output_index;
+			for (int r = 0; r < mpi.size(); r++)
+			{
+				index << " " << m_name_prefix << "_r" << r << m_output_index << ".pcache";
+			}
+			index << std::endl;
+		}
+
+		if (m_async_write)
+		{
+			std::stringstream ss; ss << m_output_index;
+			std::string filename = m_output_path + m_name_prefix + mpi.rankTag() + ss.str() + std::string(".pcache");
+
+			int total_num = m_position.getElementCount();
+			std::uint64_t posBytes = std::uint64_t(total_num) * sizeof(Coord);
+			std::uint64_t scalarBytes = std::uint64_t(total_num) * sizeof(Real);
+
+			//backpressure lives here: this blocks only when the disk falls
+			//behind all staging slots
+			AsyncWriteQueue& queue = AsyncWriteQueue::getInstance();
+			int slot = queue.acquireSlot(posBytes + scalarBytes);
+
+			if (total_num > 0)
+			{
+				cuSafeCall(cudaMemcpyAsync(queue.slotBuffer(slot), m_position.getValue().getDataPtr(), posBytes, cudaMemcpyDeviceToHost, queue.stream()));
+				cuSafeCall(cudaMemcpyAsync(queue.slotBuffer(slot) + posBytes, m_color_mapping.getValue().getDataPtr(), scalarBytes, cudaMemcpyDeviceToHost, queue.stream()));
+			}
+
+			AsyncWriteQueue::FrameDesc desc;
+			desc.filename = filename;
+			desc.particleNum = (std::uint32_t)total_num;
+			desc.realBytes = (std::uint32_t)sizeof(Real);
+			desc.posOffset = 0;
+			desc.scalarOffset = (std::int64_t)posBytes;
+			queue.submit(slot, desc);
+
+			m_output_index++;
+			return true;
+		}
+
+		if (m_binary_cache)
+		{
+			std::stringstream ss; ss << m_output_index;
+			std::string filename = m_output_path + m_name_prefix + mpi.rankTag() + ss.str() + std::string(".pcache");
+
+			int total_num = m_position.getElementCount();
+
+			//stage through pinned memory: one flat copy per attribute instead
+			//of millions of formatted writes
+			if (m_pinned_pos.size() != total_num)
+			{
+				m_pinned_pos.resize(total_num);
+				m_pinned_mapping.resize(total_num);
+			}
+
+			if (total_num > 0)
+			{
+				Function1Pt::copy(m_pinned_pos, m_position.getValue());
+				Function1Pt::copy(m_pinned_mapping, m_color_mapping.getValue());
+			}
+
+			if (m_delta_compression)
+			{
+				m_delta_writer.writeFrame(filename,
+					total_num > 0 ? m_pinned_pos.getDataPtr() : nullptr,
+					total_num > 0 ? m_pinned_mapping.getDataPtr() : nullptr,
+					(std::uint32_t)total_num,
+					(std::uint32_t)sizeof(Real));
+			}
+			else
+			{
+				ParticleCacheWriter::writeFrame(filename,
+					total_num > 0 ? m_pinned_pos.getDataPtr() : nullptr,
+					total_num > 0 ? m_pinned_mapping.getDataPtr() : nullptr,
+					(std::uint32_t)total_num,
+					(std::uint32_t)sizeof(Real));
+			}
+
+			m_output_index++;
+			return true;
+		}
+
 		
 
 		std::stringstream ss; ss << m_output_index;
@@ -4,6 +4,10 @@
 #include "ParticleIntegrator.h"
 #include "SummationDensity.h"
 #include "ImplicitViscosity.h"
+#include "VorticityConfinement.h"
+#include "RegionOfInterest.h"
+#include "ConservationMonitor.h"
+#include "ParticleSleeping.h"
 #include "Framework/Framework/MechanicalState.h"
 #include "Framework/Mapping/PointSetToPointSet.h"
 #include "Framework/Topology/FieldNeighbor.h"
@@ -34,7 +38,10 @@ namespace PhysIKA
 	template<typename TDataType>
 	PositionBasedFluidModel<TDataType>::~PositionBasedFluidModel()
 	{
-		
+		if (m_velReduce)
+		{
+			delete m_velReduce;
+		}
 	}
 
 	template<typename TDataType>
@@ -54,6 +61,8 @@ namespace PhysIKA
 		m_position.connect(m_pbdModule->inPosition());
 		m_velocity.connect(m_pbdModule->inVelocity());
 		m_nbrQuery->outNeighborhood()->connect(m_pbdModule->inNeighborIndex());
+		m_pbdModule->setSurfaceSmoothing(m_smoothingLambda);
+		m_pbdModule->setPersistentSolver(m_persistentSolver);
 		m_pbdModule->initialize();
 
 		cuSynchronize();
@@ -76,9 +85,57 @@ namespace PhysIKA
 
 		cuSynchronize();
 
+		if (m_vorticityIntensity > Real(0))
+		{
+			m_vortModule = this->getParent()->addConstraintModule<VorticityConfinement<TDataType>>("vorticity_confinement");
+			m_vortModule->setIntensity(m_vorticityIntensity);
+			m_smoothingLength.connect(&m_vortModule->m_smoothingLength);
+			m_position.connect(&m_vortModule->m_position);
+			m_velocity.connect(&m_vortModule->m_velocity);
+			m_nbrQuery->outNeighborhood()->connect(&m_vortModule->m_neighborhood);
+			m_vortModule->initialize();
+
+			cuSynchronize();
+		}
+
 		return true;
 	}
 
+	template<typename TDataType>
+	void PositionBasedFluidModel<TDataType>::setSurfaceSmoothing(Real lambda)
+	{
+		m_smoothingLambda = lambda;
+
+		//the constraint module only exists after initialization
+		if (m_pbdModule != nullptr)
+		{
+			m_pbdModule->setSurfaceSmoothing(lambda);
+		}
+	}
+
+	template<typename TDataType>
+	void PositionBasedFluidModel<TDataType>::setVorticityConfinement(Real intensity)
+	{
+		m_vorticityIntensity = intensity;
+
+		//the constraint module only exists after initialization
+		if (m_vortModule != nullptr)
+		{
+			m_vortModule->setIntensity(intensity);
+		}
+	}
+
+	template<typename TDataType>
+	void PositionBasedFluidModel<TDataType>::setPersistentSolver(bool enabled)
+	{
+		m_persistentSolver = enabled;
+
+		if (m_pbdModule != nullptr)
+		{
+			m_pbdModule->setPersistentSolver(enabled);
+		}
+	}
+
 	template<typename TDataType>
 	void PositionBasedFluidModel<TDataType>::step(Real dt)
 	{
@@ -90,13 +147,111 @@ namespace PhysIKA
 		}
 		m_integrator->begin();
 
- 		m_nbrQuery->compute();
- 		m_integrator->integrate();
-		
-		m_pbdModule->constrain();
+		//region-of-interest freeze needs the pre-step state before anything
+		//moves; the blend itself runs after the solve
+		auto roi = parent->template getModule<RegionOfInterest<TDataType>>("simulation_roi");
+		if (roi != nullptr)
+		{
+			roi->cache();
+		}
+
+		//classify settled cells on the pre-step velocities; the solver's
+		//iteration kernels then early-out on the sleeping particles
+		auto sleeping = parent->template getModule<ParticleSleeping<TDataType>>("particle_sleeping");
+		if (sleeping != nullptr)
+		{
+			sleeping->cache();
+			sleeping->compute();
+			m_pbdModule->setActivityMask(&sleeping->getActivity());
+		}
+
+		//force hooks (e.g. CustomForceModule) fill the force field the
+		//integrator just cleared, before the velocity update reads it
+		for (auto& fModule : parent->getForceModuleList())
+		{
+			fModule->applyForce();
+		}
+
+		if (m_adaptiveSubstep)
+		{
+			//one neighbor build serves all substeps: the CFL bound below keeps
+			//the per-substep displacement within the hash padding
+			m_nbrQuery->compute();
+
+			int num = m_velocity.getElementCount();
+			if (m_velReduce == NULL)
+			{
+				m_velReduce = Reduction<Real>::Create(3 * num);
+			}
+
+			//infinity-norm bound on the velocity from the raw components,
+			//no dedicated magnitude kernel needed
+			Real* v = (Real*)m_velocity.getValue().getDataPtr();
+			Real vmax = m_velReduce->maximum(v, 3 * num);
+			Real vmin = m_velReduce->minimum(v, 3 * num);
+			vmax = vmax > -vmin ? vmax : -vmin;
+
+			Real h = m_smoothingLength.getValue();
+			int substeps = (int)ceil(vmax * dt / (m_cflNumber * h));
+			substeps = substeps < 1 ? 1 : (substeps > m_maxSubsteps ? m_maxSubsteps : substeps);
+
+			Real subDt = dt / substeps;
+			parent->setDt(subDt);
+
+			for (int i = 0; i < substeps; i++)
+			{
+				m_integrator->integrate();
+				m_pbdModule->constrain();
+
+				//re-energize the swirls the projection damped before the
+				//viscosity sweep smooths the velocities
+				if (m_vortModule != nullptr)
+				{
+					m_vortModule->constrain();
+				}
+
+				m_visModule->constrain();
+			}
+
+			parent->setDt(dt);
+		}
+		else
+		{
+			//The query snapshots the pre-step positions and builds hash and
+			//counts on its private stream, so the predictor's rewrite of the
+			//live positions overlaps the build; sync() finishes the gather.
+			m_nbrQuery->computeAsync();
+			m_integrator->integrate();
+			m_nbrQuery->sync();
+
+			m_pbdModule->constrain();
+
+			if (m_vortModule != nullptr)
+			{
+				m_vortModule->constrain();
+			}
+
+	 		m_visModule->constrain();
+		}
+
+		if (sleeping != nullptr)
+		{
+			sleeping->freeze();
+		}
+
+		if (roi != nullptr)
+		{
+			roi->constrain();
+		}
+
+		//conservation statistics on the post-step state; sampling stride and
+		//cost live inside the monitor
+		auto monitor = parent->template getModule<ConservationMonitor<TDataType>>("conservation_monitor");
+		if (monitor != nullptr)
+		{
+			monitor->compute();
+		}
 
- 		m_visModule->constrain();
-		
 		m_integrator->end();
 	}
 
@@ -135,4 +290,10 @@ namespace PhysIKA
 		m_surfaceTensionSolver = solver;
 		getParent()->addForceModule(m_surfaceTensionSolver);
 	}
+
+#ifdef PRECISION_FLOAT
+	template class PositionBasedFluidModel<DataType3f>;
+#else
+	template class PositionBasedFluidModel<DataType3d>;
+#endif
 }
\ No newline at end of file
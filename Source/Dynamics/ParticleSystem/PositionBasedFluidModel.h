@@ -3,6 +3,7 @@
 #include "Framework/Framework/FieldVar.h"
 #include "Framework/Framework/FieldArray.h"
 #include "DensityPBD.h"
+#include "Core/Utility/Reduction.h"
 
 namespace PhysIKA
 {
@@ -11,6 +12,7 @@ namespace PhysIKA
 	template<typename TDataType> class NeighborQuery;
 	template<typename TDataType> class DensityPBD;
 	template<typename TDataType> class ImplicitViscosity;
+	template<typename TDataType> class VorticityConfinement;
 	class ForceModule;
 	class ConstraintModule;
 	/*!
@@ -37,6 +39,41 @@ namespace PhysIKA
 		void setSmoothingLength(Real len) { m_smoothingLength.setValue(len); }
 		void setRestDensity(Real rho) { m_restRho = rho; }
 
+		/**
+		 * @brief Run several internal substeps per frame off a single
+		 * neighbor-list build. The substep count follows the CFL number
+		 * computed from the current maximum velocity, capped by maxSubsteps.
+		 */
+		/**
+		 * @brief Free-surface smoothing strength, evaluated inside the PBD
+		 * projection sweep (see DensityPBD::setSurfaceSmoothing) instead of a
+		 * separate Helmholtz constraint pass. Zero disables it.
+		 */
+		void setSurfaceSmoothing(Real lambda);
+
+		/**
+		 * @brief Run the pressure solve as a single persistent-threads kernel;
+		 * see DensityPBD::setPersistentSolver(). Pays off on small interactive
+		 * scenes where per-phase launch overhead dominates.
+		 */
+		void setPersistentSolver(bool enabled);
+
+		/**
+		 * @brief Feed back the rotational motion the projection damps; see
+		 * VorticityConfinement. The module runs between the density constraint
+		 * and the viscosity sweep off the same neighbor list, so enabling it
+		 * costs two extra gather sweeps and no extra neighbor build. Zero
+		 * disables it; enable before the scene is initialized.
+		 */
+		void setVorticityConfinement(Real intensity);
+
+		void setAdaptiveSubstep(bool enabled, int maxSubsteps = 5, Real cfl = Real(0.5))
+		{
+			m_adaptiveSubstep = enabled;
+			m_maxSubsteps = maxSubsteps;
+			m_cflNumber = cfl;
+		}
+
 		void setIncompressibilitySolver(std::shared_ptr<ConstraintModule> solver);
 		void setViscositySolver(std::shared_ptr<ConstraintModule> solver);
 		void setSurfaceTensionSolver(std::shared_ptr<ForceModule> solver);
@@ -60,12 +97,21 @@ namespace PhysIKA
 		int m_pNum;
 		Real m_restRho;
 
+		bool m_adaptiveSubstep = false;
+		Real m_smoothingLambda = Real(0);
+		bool m_persistentSolver = false;
+		Real m_vorticityIntensity = Real(0);
+		int m_maxSubsteps = 5;
+		Real m_cflNumber = Real(0.5);
+		Reduction<Real>* m_velReduce = NULL;
+
 		std::shared_ptr<ForceModule> m_surfaceTensionSolver;
 		std::shared_ptr<ConstraintModule> m_viscositySolver;
 		std::shared_ptr<ConstraintModule> m_incompressibilitySolver;
 
 		std::shared_ptr<DensityPBD<TDataType>> m_pbdModule;
 		std::shared_ptr<ImplicitViscosity<TDataType>> m_visModule;
+		std::shared_ptr<VorticityConfinement<TDataType>> m_vortModule;
 
 		std::shared_ptr<PointSetToPointSet<TDataType>> m_mapping;
 		std::shared_ptr<ParticleIntegrator<TDataType>> m_integrator;
@@ -73,8 +119,8 @@ namespace PhysIKA
 	};
 
 #ifdef PRECISION_FLOAT
-	template class PositionBasedFluidModel<DataType3f>;
+	extern template class PositionBasedFluidModel<DataType3f>;
 #else
-	template class PositionBasedFluidModel<DataType3d>;
+	extern template class PositionBasedFluidModel<DataType3d>;
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include <cuda_runtime.h>
+#include "RegionOfInterest.h"
+#include "Framework/Framework/Node.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(RegionOfInterest, TDataType)
+
+	//blend weight: 1 deep inside the box, fading to 0 across the band at
+	//the boundary, 0 everywhere outside
+	template<typename Real, typename Coord>
+	GPU_FUNC inline Real ROI_BlendWeight(Coord pos, Coord lo, Coord hi, Real width)
+	{
+		Real depth = pos[0] - lo[0];
+		depth = min(depth, hi[0] - pos[0]);
+		depth = min(depth, pos[1] - lo[1]);
+		depth = min(depth, hi[1] - pos[1]);
+		depth = min(depth, pos[2] - lo[2]);
+		depth = min(depth, hi[2] - pos[2]);
+
+		if (depth <= Real(0)) return Real(0);
+		if (depth >= width) return Real(1);
+		return depth / width;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void ROI_Constrain(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<Coord> prePosArr,
+		Coord lo,
+		Coord hi,
+		Real width,
+		Coord farVel,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Real w = ROI_BlendWeight(prePosArr[pId], lo, hi, width);
+		if (w >= Real(1)) return;
+
+		Coord presPos = prePosArr[pId] + dt * farVel;
+
+		posArr[pId] = w * posArr[pId] + (Real(1) - w) * presPos;
+		velArr[pId] = w * velArr[pId] + (Real(1) - w) * farVel;
+	}
+
+	template<typename TDataType>
+	RegionOfInterest<TDataType>::RegionOfInterest()
+		: ConstraintModule()
+		, m_lo(Coord(0))
+		, m_hi(Coord(1))
+		, m_blendWidth(Real(0.05))
+		, m_farVelocity(Coord(0))
+	{
+	}
+
+	template<typename TDataType>
+	RegionOfInterest<TDataType>::~RegionOfInterest()
+	{
+		m_prePosition.release();
+	}
+
+	template<typename TDataType>
+	void RegionOfInterest<TDataType>::cache()
+	{
+		if (this->inPosition()->isEmpty()) return;
+
+		int num = this->inPosition()->getElementCount();
+		if (m_prePosition.size() != num)
+		{
+			m_prePosition.resize(num);
+		}
+
+		Function1Pt::copy(m_prePosition, this->inPosition()->getValue());
+	}
+
+	template<typename TDataType>
+	bool RegionOfInterest<TDataType>::constrain()
+	{
+		if (this->inPosition()->isEmpty()) return false;
+
+		int num = this->inPosition()->getElementCount();
+
+		//the snapshot can lag one frame behind when particles were added or
+		//removed mid-step; skip the blend until the sizes agree again
+		if (m_prePosition.size() != num) return false;
+
+		Real dt = getParent()->getDt();
+
+		cuExecute(num, ROI_Constrain,
+			this->inPosition()->getValue(),
+			this->inVelocity()->getValue(),
+			m_prePosition,
+			m_lo,
+			m_hi,
+			m_blendWidth,
+			m_farVelocity,
+			dt);
+
+		return true;
+	}
+
+#ifdef PRECISION_FLOAT
+	template class RegionOfInterest<DataType3f>;
+#else
+	template class RegionOfInterest<DataType3d>;
+#endif
+}
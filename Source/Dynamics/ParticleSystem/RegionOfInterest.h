@@ -0,0 +1,79 @@
+#pragma once
+#include "Framework/Framework/ModuleConstraint.h"
+#include "Framework/Framework/FieldArray.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	RegionOfInterest
+	*	\brief	Full dynamics inside a user-supplied box, frozen or
+	*	prescribed motion outside.
+	*
+	*	Artist shots often care about a small part of the domain; the rest
+	*	only has to look plausible. The module snapshots the pre-step state
+	*	(cache(), called before the solver runs), lets the solver update
+	*	everything, and then rewrites the outside (constrain()): particles
+	*	beyond the box follow the prescribed far-field velocity (zero by
+	*	default, i.e. frozen), while a blending band inside the boundary
+	*	fades between the simulated and the prescribed state so the frozen
+	*	far field does not read as a hard wall.
+	*
+	*	The solver still visits every particle; this trades correctness
+	*	outside the box for visual continuity, not yet for solve time.
+	*/
+	template<typename TDataType>
+	class RegionOfInterest : public ConstraintModule
+	{
+		DECLARE_CLASS_1(RegionOfInterest, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		RegionOfInterest();
+		~RegionOfInterest() override;
+
+		/*!
+		*	\brief	Snapshot the pre-step state; call before the solver.
+		*/
+		void cache();
+
+		/*!
+		*	\brief	Rewrite the outside from the snapshot; call after the
+		*	solver.
+		*/
+		bool constrain() override;
+
+		void setBox(Coord lo, Coord hi) { m_lo = lo; m_hi = hi; }
+
+		/*!
+		*	\brief	Width of the fade between full dynamics and the
+		*	prescribed far field, measured inward from the box boundary.
+		*/
+		void setBlendWidth(Real width) { m_blendWidth = width; }
+
+		/*!
+		*	\brief	Particles outside the box advect with this velocity;
+		*	zero freezes them in place.
+		*/
+		void setFarFieldVelocity(Coord vel) { m_farVelocity = vel; }
+
+	public:
+		DEF_EMPTY_IN_ARRAY(Position, Coord, DeviceType::GPU, "Particle position");
+
+		DEF_EMPTY_IN_ARRAY(Velocity, Coord, DeviceType::GPU, "Particle velocity");
+
+	private:
+		Coord m_lo;
+		Coord m_hi;
+		Real m_blendWidth;
+		Coord m_farVelocity;
+
+		DeviceArray<Coord> m_prePosition;
+	};
+
+#ifdef PRECISION_FLOAT
+	extern template class RegionOfInterest<DataType3f>;
+#else
+	extern template class RegionOfInterest<DataType3d>;
+#endif
+}
@@ -0,0 +1,96 @@
+#include "RestShapeCache.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	template<typename TDataType>
+	RestShapeCache<TDataType>& RestShapeCache<TDataType>::getInstance()
+	{
+		static RestShapeCache<TDataType> instance;
+		return instance;
+	}
+
+	template<typename TDataType>
+	std::vector<int> RestShapeCache<TDataType>::computeKey(DeviceArray<Coord>& pos)
+	{
+		int num = pos.size();
+
+		std::vector<Coord> hostPos(num);
+		cuSafeCall(cudaMemcpy(hostPos.data(), pos.getDataPtr(), num * sizeof(Coord), cudaMemcpyDeviceToHost));
+
+		Coord centroid(0);
+		for (int i = 0; i < num; i++)
+		{
+			centroid += hostPos[i];
+		}
+		centroid /= Real(num);
+
+		//quantize the centroid-relative layout so translated instances of one
+		//asset produce identical keys despite floating point drift
+		const Real quant = Real(16384);
+
+		std::vector<int> key(3 * num);
+		for (int i = 0; i < num; i++)
+		{
+			Coord rel = hostPos[i] - centroid;
+			key[3 * i + 0] = (int)floor(rel[0] * quant + Real(0.5));
+			key[3 * i + 1] = (int)floor(rel[1] * quant + Real(0.5));
+			key[3 * i + 2] = (int)floor(rel[2] * quant + Real(0.5));
+		}
+
+		return key;
+	}
+
+	template<typename TDataType>
+	std::size_t RestShapeCache<TDataType>::hashKey(const std::vector<int>& key, Real radius)
+	{
+		//FNV-1a over the quantized coordinates and the radius
+		std::size_t h = (std::size_t)1469598103934665603ULL;
+		for (size_t i = 0; i < key.size(); i++)
+		{
+			h = (h ^ (std::size_t)(unsigned int)key[i]) * (std::size_t)1099511628211ULL;
+		}
+		h = (h ^ (std::size_t)(unsigned int)(int)floor(radius * Real(16384) + Real(0.5))) * (std::size_t)1099511628211ULL;
+		return h;
+	}
+
+	template<typename TDataType>
+	std::shared_ptr<NeighborList<typename RestShapeCache<TDataType>::NPair>> RestShapeCache<TDataType>::find(const std::vector<int>& key, Real radius)
+	{
+		std::size_t h = hashKey(key, radius);
+
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		auto range = m_entries.equal_range(h);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second.radius == radius && it->second.key == key)
+			{
+				return it->second.shape;
+			}
+		}
+
+		return nullptr;
+	}
+
+	template<typename TDataType>
+	void RestShapeCache<TDataType>::insert(const std::vector<int>& key, Real radius, std::shared_ptr<NeighborList<NPair>> shape)
+	{
+		Entry entry;
+		entry.key = key;
+		entry.radius = radius;
+		entry.shape = shape;
+
+		std::size_t h = hashKey(key, radius);
+
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_entries.insert(std::make_pair(h, entry));
+	}
+
+	template<typename TDataType>
+	void RestShapeCache<TDataType>::clear()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_entries.clear();
+	}
+}
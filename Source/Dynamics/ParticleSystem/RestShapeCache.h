@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include "Core/DataTypes.h"
+#include "Core/Array/Array.h"
+#include "Framework/Topology/NeighborList.h"
+#include "Dynamics/ParticleSystem/NeighborData.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	RestShapeCache
+	*	\brief	Shareable, immutable rest-shape lists keyed by source geometry.
+	*
+	*	Scenes that instance the same elastic asset many times used to pay the
+	*	full rest-shape build per instance and keep a private copy of the NPair
+	*	list. The cache keys each list by a quantized, centroid-relative
+	*	signature of the particle layout plus the supporting radius; since the
+	*	elasticity kernels only ever consume rest-pair differences and local
+	*	indices, translated instances of one asset can all share a single
+	*	device buffer. Entries are immutable — a module that needs to rewrite
+	*	its rest shape must detach first, see
+	*	ElasticityModule::makeRestShapePrivate(). Lookups and insertions are
+	*	mutex-guarded so instances may initialize concurrently.
+	*/
+	template<typename TDataType>
+	class RestShapeCache
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef TPair<TDataType> NPair;
+
+		static RestShapeCache& getInstance();
+
+		/**
+		 * @brief Translation-invariant signature of a particle layout. Copies
+		 * the positions to the host once, so call it at initialization only.
+		 */
+		std::vector<int> computeKey(DeviceArray<Coord>& pos);
+
+		/**
+		 * @brief Return the cached list for the given signature and radius, or
+		 * nullptr if no instance has published one yet.
+		 */
+		std::shared_ptr<NeighborList<NPair>> find(const std::vector<int>& key, Real radius);
+
+		void insert(const std::vector<int>& key, Real radius, std::shared_ptr<NeighborList<NPair>> shape);
+
+		void clear();
+
+	private:
+		RestShapeCache() {};
+
+		std::size_t hashKey(const std::vector<int>& key, Real radius);
+
+		struct Entry
+		{
+			std::vector<int> key;
+			Real radius;
+			std::shared_ptr<NeighborList<NPair>> shape;
+		};
+
+		std::unordered_multimap<std::size_t, Entry> m_entries;
+		std::mutex m_mutex;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class RestShapeCache<DataType3f>;
+#else
+	template class RestShapeCache<DataType3d>;
+#endif
+}
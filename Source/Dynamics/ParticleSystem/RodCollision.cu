@@ -179,17 +179,21 @@ namespace PhysIKA
 
 		Function1Pt::copy(init_pos, m_points);
 
-		uint pDims = cudaGridSize(m_points.size(), BLOCK_SIZE);
+		//occupancy-derived block sizes, resolved once per kernel
+		uint collideDim = LaunchConfigCache::getInstance().blockSizeFor((const void*)&K_Collide<Real, Coord>, "K_Collide");
+		uint targetDim = LaunchConfigCache::getInstance().blockSizeFor((const void*)&K_ComputeTarget<Real, Coord>, "K_ComputeTarget");
+		uint velDim = LaunchConfigCache::getInstance().blockSizeFor((const void*)&K_ComputeVelocity<Real, Coord>, "K_ComputeVelocity");
+
 		for (size_t it = 0; it < 5; it++)
 		{
 			weights.reset();
 			posBuf.reset();
-			K_Collide << <pDims, BLOCK_SIZE >> > (m_objId, m_points, posBuf, weights, *m_nList, radius);
-			K_ComputeTarget << <pDims, BLOCK_SIZE >> > (m_points, posBuf, weights);
+			K_Collide << <cudaGridSize(m_points.size(), collideDim), collideDim >> > (m_objId, m_points, posBuf, weights, *m_nList, radius);
+			K_ComputeTarget << <cudaGridSize(m_points.size(), targetDim), targetDim >> > (m_points, posBuf, weights);
 			Function1Pt::copy(m_points, posBuf);
 		}
 
-		K_ComputeVelocity << <pDims, BLOCK_SIZE >> > (init_pos, m_points, m_vels, getParent()->getDt());
+		K_ComputeVelocity << <cudaGridSize(m_points.size(), velDim), velDim >> > (init_pos, m_points, m_vels, getParent()->getDt());
 
 		posBuf.release();
 		weights.release();
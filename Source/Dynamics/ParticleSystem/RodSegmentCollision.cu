@@ -0,0 +1,406 @@
+#include "RodSegmentCollision.h"
+#include "Core/Utility.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Framework/SceneGraph.h"
+#include "Framework/Framework/CollidableObject.h"
+#include "Framework/Collision/CollidablePoints.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(RodSegmentCollision, TDataType)
+
+	template<typename TDataType>
+	RodSegmentCollision<TDataType>::RodSegmentCollision()
+		: CollisionModel()
+	{
+	}
+
+	template<typename TDataType>
+	RodSegmentCollision<TDataType>::~RodSegmentCollision()
+	{
+		m_collidableObjects.clear();
+
+		m_objId.release();
+		m_points.release();
+		m_vels.release();
+		m_segMid.release();
+		m_segLen.release();
+		m_deltaPos.release();
+		m_deltaVel.release();
+
+		if (m_hashReady)
+		{
+			m_hash.release();
+		}
+		if (m_reduce != nullptr)
+		{
+			delete m_reduce;
+		}
+	}
+
+	template<typename TDataType>
+	bool RodSegmentCollision<TDataType>::isSupport(std::shared_ptr<CollidableObject> obj)
+	{
+		if (obj->getType() == CollidableObject::POINTSET_TYPE)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	template<typename TDataType>
+	void RodSegmentCollision<TDataType>::addCollidableObject(std::shared_ptr<CollidableObject> obj)
+	{
+		auto derived = std::dynamic_pointer_cast<CollidablePoints<TDataType>>(obj);
+		if (obj->getType() == CollidableObject::POINTSET_TYPE)
+		{
+			m_collidableObjects.push_back(derived);
+		}
+	}
+
+	//closest points between segments p1q1 and p2q2, returned as the
+	//clamped parameters along each segment
+	template<typename Real, typename Coord>
+	GPU_FUNC Real RSC_SegmentDistance(
+		Coord p1, Coord q1, Coord p2, Coord q2,
+		Real& s, Real& t)
+	{
+		Coord d1 = q1 - p1;
+		Coord d2 = q2 - p2;
+		Coord r = p1 - p2;
+
+		Real a = d1.dot(d1);
+		Real e = d2.dot(d2);
+		Real f = d2.dot(r);
+
+		if (a < EPSILON && e < EPSILON)
+		{
+			s = Real(0);
+			t = Real(0);
+			return r.norm();
+		}
+
+		if (a < EPSILON)
+		{
+			s = Real(0);
+			t = min(max(f / e, Real(0)), Real(1));
+		}
+		else
+		{
+			Real c = d1.dot(r);
+			if (e < EPSILON)
+			{
+				t = Real(0);
+				s = min(max(-c / a, Real(0)), Real(1));
+			}
+			else
+			{
+				Real b = d1.dot(d2);
+				Real denom = a * e - b * b;
+
+				s = denom > EPSILON ? min(max((b * f - c * e) / denom, Real(0)), Real(1)) : Real(0);
+				t = (b * s + f) / e;
+
+				if (t < Real(0))
+				{
+					t = Real(0);
+					s = min(max(-c / a, Real(0)), Real(1));
+				}
+				else if (t > Real(1))
+				{
+					t = Real(1);
+					s = min(max((b - c) / a, Real(0)), Real(1));
+				}
+			}
+		}
+
+		Coord c1 = p1 + s * d1;
+		Coord c2 = p2 + t * d2;
+		return (c1 - c2).norm();
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void RSC_SetupSegments(
+		DeviceArray<Coord> segMid,
+		DeviceArray<Real> segLen,
+		DeviceArray<Coord> points,
+		DeviceArray<int> objIds,
+		Coord parking)
+	{
+		int sId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (sId >= segMid.size()) return;
+
+		if (objIds[sId] != objIds[sId + 1])
+		{
+			//invalid pair: park the midpoint outside the hash domain
+			segMid[sId] = parking;
+			segLen[sId] = Real(0);
+			return;
+		}
+
+		Coord p = points[sId];
+		Coord q = points[sId + 1];
+		segMid[sId] = Real(0.5) * (p + q);
+		segLen[sId] = (q - p).norm();
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void RSC_Collide(
+		DeviceArray<Coord> deltaPos,
+		DeviceArray<Coord> deltaVel,
+		DeviceArray<Coord> points,
+		DeviceArray<Coord> vels,
+		DeviceArray<int> objIds,
+		DeviceArray<Coord> segMid,
+		GridHash<TDataType> hash,
+		Real radius)
+	{
+		int sId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (sId >= segMid.size()) return;
+
+		if (objIds[sId] != objIds[sId + 1]) return;
+
+		Coord p1 = points[sId];
+		Coord q1 = points[sId + 1];
+
+		int3 cell = hash.getIndex3(segMid[sId]);
+
+		for (int c = 0; c < 27; c++)
+		{
+			int cellId = hash.getIndex(cell.x + c % 3 - 1, cell.y + (c / 3) % 3 - 1, cell.z + c / 9 - 1);
+			if (cellId == INVALID) continue;
+
+			int nbSize = hash.getCounter(cellId);
+			for (int ne = 0; ne < nbSize; ne++)
+			{
+				int tId = hash.getParticleId(cellId, ne);
+
+				//each unordered pair once; the conservative cell size makes
+				//the search symmetric, so the smaller index always sees it
+				if (tId <= sId) continue;
+
+				if (objIds[tId] != objIds[tId + 1]) continue;
+
+				//segments sharing an endpoint along the same rod
+				if (objIds[sId] == objIds[tId] && tId - sId <= 1) continue;
+
+				Coord p2 = points[tId];
+				Coord q2 = points[tId + 1];
+
+				Real u, v;
+				Real dist = RSC_SegmentDistance(p1, q1, p2, q2, u, v);
+				if (dist >= 2 * radius) continue;
+
+				Coord c1 = p1 + u * (q1 - p1);
+				Coord c2 = p2 + v * (q2 - p2);
+				Coord n = c1 - c2;
+				if (n.norm() < EPSILON)
+				{
+					n = Coord(1, 0, 0);
+				}
+				else
+				{
+					n = n.normalize();
+				}
+
+				//effective inverse masses of the contact points with unit
+				//point masses
+				Real wa = (1 - u) * (1 - u) + u * u;
+				Real wb = (1 - v) * (1 - v) + v * v;
+				Real wSum = wa + wb;
+
+				//inelastic normal impulse
+				Coord va = (1 - u) * vels[sId] + u * vels[sId + 1];
+				Coord vb = (1 - v) * vels[tId] + v * vels[tId + 1];
+				Real vn = (va - vb).dot(n);
+				if (vn < Real(0))
+				{
+					Real jn = -vn / wSum;
+					Coord dv = jn * n;
+
+					atomicAdd(&deltaVel[sId][0], (1 - u) * dv[0]);
+					atomicAdd(&deltaVel[sId][1], (1 - u) * dv[1]);
+					atomicAdd(&deltaVel[sId][2], (1 - u) * dv[2]);
+					atomicAdd(&deltaVel[sId + 1][0], u * dv[0]);
+					atomicAdd(&deltaVel[sId + 1][1], u * dv[1]);
+					atomicAdd(&deltaVel[sId + 1][2], u * dv[2]);
+
+					atomicAdd(&deltaVel[tId][0], -(1 - v) * dv[0]);
+					atomicAdd(&deltaVel[tId][1], -(1 - v) * dv[1]);
+					atomicAdd(&deltaVel[tId][2], -(1 - v) * dv[2]);
+					atomicAdd(&deltaVel[tId + 1][0], -v * dv[0]);
+					atomicAdd(&deltaVel[tId + 1][1], -v * dv[1]);
+					atomicAdd(&deltaVel[tId + 1][2], -v * dv[2]);
+				}
+
+				//positional depenetration, half strength to stay stable
+				//when several contacts pile up
+				Real push = Real(0.5) * (2 * radius - dist) / wSum;
+				Coord dp = push * n;
+
+				atomicAdd(&deltaPos[sId][0], (1 - u) * dp[0]);
+				atomicAdd(&deltaPos[sId][1], (1 - u) * dp[1]);
+				atomicAdd(&deltaPos[sId][2], (1 - u) * dp[2]);
+				atomicAdd(&deltaPos[sId + 1][0], u * dp[0]);
+				atomicAdd(&deltaPos[sId + 1][1], u * dp[1]);
+				atomicAdd(&deltaPos[sId + 1][2], u * dp[2]);
+
+				atomicAdd(&deltaPos[tId][0], -(1 - v) * dp[0]);
+				atomicAdd(&deltaPos[tId][1], -(1 - v) * dp[1]);
+				atomicAdd(&deltaPos[tId][2], -(1 - v) * dp[2]);
+				atomicAdd(&deltaPos[tId + 1][0], -v * dp[0]);
+				atomicAdd(&deltaPos[tId + 1][1], -v * dp[1]);
+				atomicAdd(&deltaPos[tId + 1][2], -v * dp[2]);
+			}
+		}
+	}
+
+	template<typename Coord>
+	__global__ void RSC_Apply(
+		DeviceArray<Coord> points,
+		DeviceArray<Coord> vels,
+		DeviceArray<Coord> deltaPos,
+		DeviceArray<Coord> deltaVel)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= points.size()) return;
+
+		points[pId] += deltaPos[pId];
+		vels[pId] += deltaVel[pId];
+	}
+
+	template<typename TDataType>
+	void RodSegmentCollision<TDataType>::doCollision()
+	{
+		int num = m_points.size();
+		if (num < 2) return;
+
+		int start = 0;
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			DeviceArray<Coord>& points = m_collidableObjects[i]->getPositions();
+			DeviceArray<Coord>& vels = m_collidableObjects[i]->getVelocities();
+			int n = points.size();
+			cudaMemcpy(m_points.getDataPtr() + start, points.getDataPtr(), n * sizeof(Coord), cudaMemcpyDeviceToDevice);
+			cudaMemcpy(m_vels.getDataPtr() + start, vels.getDataPtr(), n * sizeof(Coord), cudaMemcpyDeviceToDevice);
+			start += n;
+		}
+
+		int segNum = num - 1;
+
+		if (m_segMid.size() != segNum)
+		{
+			m_segMid.resize(segNum);
+			m_segLen.resize(segNum);
+		}
+		if (m_deltaPos.size() != num)
+		{
+			m_deltaPos.resize(num);
+			m_deltaVel.resize(num);
+		}
+		if (m_reduce == nullptr)
+		{
+			m_reduce = Reduction<Real>::Create(segNum);
+		}
+
+		Vector3f sceneLow = SceneGraph::getInstance().getLowerBound();
+		Vector3f sceneUp = SceneGraph::getInstance().getUpperBound();
+		Coord lo = Coord(sceneLow[0], sceneLow[1], sceneLow[2]);
+		Coord hi = Coord(sceneUp[0], sceneUp[1], sceneUp[2]);
+
+		//park invalid pairs outside the domain so the hash skips them
+		Coord parking = lo - Coord(1, 1, 1);
+
+		cuExecute(segNum, RSC_SetupSegments,
+			m_segMid,
+			m_segLen,
+			m_points,
+			m_objId,
+			parking);
+
+		//the cell must cover a whole capsule so the 27-cell walk around a
+		//midpoint is a conservative broadphase for segment pairs
+		Real maxLen = m_reduce->maximum(m_segLen.getDataPtr(), segNum);
+		Real cellSize = maxLen + 2 * m_radius;
+
+		if (!m_hashReady || cellSize > m_hashCellSize)
+		{
+			if (m_hashReady)
+			{
+				m_hash.release();
+			}
+			//headroom so mild stretching does not rebuild the tables
+			m_hashCellSize = Real(1.2) * cellSize;
+			m_hash.setSpace(m_hashCellSize, lo, hi);
+			m_hashReady = true;
+		}
+
+		m_hash.clear();
+		m_hash.construct(m_segMid);
+
+		m_deltaPos.reset();
+		m_deltaVel.reset();
+
+		cuExecute(segNum, RSC_Collide,
+			m_deltaPos,
+			m_deltaVel,
+			m_points,
+			m_vels,
+			m_objId,
+			m_segMid,
+			m_hash,
+			m_radius);
+
+		cuExecute(num, RSC_Apply,
+			m_points,
+			m_vels,
+			m_deltaPos,
+			m_deltaVel);
+
+		start = 0;
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			DeviceArray<Coord>& points = m_collidableObjects[i]->getPositions();
+			DeviceArray<Coord>& vels = m_collidableObjects[i]->getVelocities();
+			int n = points.size();
+			cudaMemcpy(points.getDataPtr(), m_points.getDataPtr() + start, n * sizeof(Coord), cudaMemcpyDeviceToDevice);
+			cudaMemcpy(vels.getDataPtr(), m_vels.getDataPtr() + start, n * sizeof(Coord), cudaMemcpyDeviceToDevice);
+
+			m_collidableObjects[i]->updateMechanicalState();
+			start += n;
+		}
+	}
+
+	template<typename TDataType>
+	bool RodSegmentCollision<TDataType>::initializeImpl()
+	{
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			m_collidableObjects[i]->initialize();
+		}
+
+		int totalNum = 0;
+		std::vector<int> ids;
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			DeviceArray<Coord>& points = m_collidableObjects[i]->getPositions();
+			for (int j = 0; j < points.size(); j++)
+			{
+				ids.push_back(i);
+			}
+			totalNum += points.size();
+		}
+
+		if (totalNum <= 0)
+			return false;
+
+		m_objId.resize(totalNum);
+		m_points.resize(totalNum);
+		m_vels.resize(totalNum);
+
+		Function1Pt::copy(m_objId, ids);
+
+		return true;
+	}
+
+}
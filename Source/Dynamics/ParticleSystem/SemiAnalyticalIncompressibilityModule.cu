@@ -299,16 +299,13 @@ namespace PhysIKA
 
 
 	template <typename Real, typename Coord>
-	__global__ void VC_ComputeAlphaTmp
+	__global__ void VC_CacheTriangleContributions
 	(
-		DeviceArray<Real> alpha,
-		DeviceArray<Real> rho_alpha,
-		DeviceArray<Real> mass,
+		DeviceArray<TriangleContribution<Real>> triCache,
 		DeviceArray<Coord> position,
 		DeviceArray<TopologyModule::Triangle> m_triangle_index,
 		DeviceArray<Coord> positionTri,
 		DeviceArray<Attribute> attribute,
-		NeighborList<int> neighbors,
 		NeighborList<int> neighborsTri,
 		Real smoothingLength,
 		Real m_sampling_distance,
@@ -316,38 +313,36 @@ namespace PhysIKA
 	)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
-
 		if (pId >= position.size()) return;
 		if (!attribute[pId].IsDynamic()) return;
 
-		
-
 		Coord pos_i = position[pId];
-		Real alpha_i = 0.0f;
-		Real ra = 0.0f;
-		int nbSize = neighbors.getNeighborSize(pId);
-		int nbSizeTri;
-		
-		nbSizeTri = neighborsTri.getNeighborSize(pId);
-		
-		Real debug_r = smoothingLength;
-		bool tmp = false;
-		Real AreaB;
+		int nbSizeTri = neighborsTri.getNeighborSize(pId);
+		int start = neighborsTri.beginIndex(pId);
+
 		for (int ne = 0; ne < nbSizeTri; ne++)
 		{
+			TriangleContribution<Real> coeff;
+			coeff.r = Real(0);
+			coeff.geom = Real(0);
+			coeff.span = 0;
+
 			int j = neighborsTri.getElement(pId, ne);
-			if (j >= 0) continue;
+			if (j >= 0)
+			{
+				triCache[start + ne] = coeff;
+				continue;
+			}
 			j *= -1;
 			j--;
-			//	Real m_sampling_distance = 0.015;
+
+			int runHead = ne;
 
 			Triangle3D t3d(positionTri[m_triangle_index[j][0]], positionTri[m_triangle_index[j][1]], positionTri[m_triangle_index[j][2]]);
 			Plane3D PL(positionTri[m_triangle_index[j][0]], t3d.normal());
 			Point3D p3d(pos_i);
-			//Point3D nearest_pt = p3d.project(t3d);
 			Point3D nearest_pt = p3d.project(PL);
 			Real r = (nearest_pt.origin - pos_i).norm();
-			tmp = true;
 			float d = p3d.distance(PL);
 
 			Real AreaSum = p3d.areaTriangle(t3d, smoothingLength);
@@ -366,40 +361,77 @@ namespace PhysIKA
 					if ((t3d.normal().cross(t3d_n.normal())).norm() > EPSILON) break;
 
 					AreaSum += p3d.areaTriangle(t3d_n, smoothingLength);
-					
+
 					if (abs(p3d.distance(t3d_n)) < MinDistance)
 					{
 						MinDistance = abs(p3d.distance(t3d_n));
 						Min_Pt = (p3d.project(t3d_n)).origin - pos_i;
 					}
-					//printf("%d %d\n", j, jn);
+					//mark slots consumed by this coplanar run
+					triCache[start + ne + 1] = coeff;
 					ne++;
 				} while (ne < nbSizeTri - 1);
 			}
 			Min_Pt /= Min_Pt.norm();
 
-
 			d = abs(d);
+			coeff.r = r;
+			coeff.span = ne - runHead + 1;
 			if (smoothingLength - d > EPSILON&& smoothingLength* smoothingLength - d * d > EPSILON&& d > EPSILON)
 			{
 				Coord n_PL = - t3d.normal();
 				if (flip[pId] < 0)  n_PL *= -1;
-				Coord n_TR = (p3d.project(t3d)).origin - pos_i;
 				n_PL = n_PL / n_PL.norm();
-				n_TR = n_TR / n_TR.norm();
-				
-				AreaB = M_PI * (smoothingLength * smoothingLength - d * d);
 
-				Real a_ij =
-					kernWeightMesh(r, smoothingLength)
-					* 2.0 * (M_PI) * (1 - d / smoothingLength)
-					//* p3d.areaTriangle(t3d, smoothingLength) * n_PL.dot(n_TR)
+				coeff.geom =
+					2.0 * (M_PI) * (1 - d / smoothingLength)
 					* AreaSum * n_PL.dot(Min_Pt)
 					/ ((M_PI) * (smoothingLength * smoothingLength - d * d)) /
 					(m_sampling_distance * m_sampling_distance * m_sampling_distance);
-				debug_r = min(r, debug_r);
-				alpha_i += a_ij;
 			}
+			triCache[start + runHead] = coeff;
+		}
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void VC_ComputeAlphaTmp
+	(
+		DeviceArray<Real> alpha,
+		DeviceArray<Real> rho_alpha,
+		DeviceArray<Real> mass,
+		DeviceArray<Coord> position,
+		DeviceArray<TriangleContribution<Real>> triCache,
+		DeviceArray<Attribute> attribute,
+		NeighborList<int> neighbors,
+		NeighborList<int> neighborsTri,
+		Real smoothingLength,
+		Real m_sampling_distance,
+		DeviceArray<int> flip
+	)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		if (pId >= position.size()) return;
+		if (!attribute[pId].IsDynamic()) return;
+
+		
+
+		Coord pos_i = position[pId];
+		Real alpha_i = 0.0f;
+		Real ra = 0.0f;
+		int nbSize = neighbors.getNeighborSize(pId);
+		int nbSizeTri;
+		
+		nbSizeTri = neighborsTri.getNeighborSize(pId);
+		
+		int startTri = neighborsTri.beginIndex(pId);
+		for (int ne = 0; ne < nbSizeTri; ne++)
+		{
+			TriangleContribution<Real> coeff = triCache[startTri + ne];
+			if (coeff.span <= 0) continue;
+
+			alpha_i += kernWeightMesh(coeff.r, smoothingLength) * coeff.geom;
+			ne += coeff.span - 1;
 		}
 		
 		Real alpha_solid = alpha_i;
@@ -456,8 +488,7 @@ namespace PhysIKA
 		DeviceArray<Real> AiiTotal,
 		DeviceArray<Real> alpha,
 		DeviceArray<Coord> position,
-		DeviceArray<TopologyModule::Triangle> m_triangle_index,
-		DeviceArray<Coord> positionTri,
+		DeviceArray<TriangleContribution<Real>> triCache,
 		DeviceArray<Attribute> attribute,
 		NeighborList<int> neighbors,
 		NeighborList<int> neighborsTri,
@@ -486,78 +517,17 @@ namespace PhysIKA
 
 		int nbSizeTri;
 		nbSizeTri = neighborsTri.getNeighborSize(pId);
-		float dd;
+		int startTri = neighborsTri.beginIndex(pId);
 		for (int ne = 0; ne < nbSizeTri; ne++)
 		{
-			int j = neighborsTri.getElement(pId, ne);
-			if (j >= 0) continue;
-			j *= -1;
-			j--;
-			//Real m_sampling_distance = 0.015;
+			TriangleContribution<Real> coeff = triCache[startTri + ne];
+			if (coeff.span <= 0) continue;
 
-			Triangle3D t3d(positionTri[m_triangle_index[j][0]], positionTri[m_triangle_index[j][1]], positionTri[m_triangle_index[j][2]]);
-			Plane3D PL(positionTri[m_triangle_index[j][0]], t3d.normal());
-			Point3D p3d(pos_i);
-			//Point3D nearest_pt = p3d.project(t3d);
-			Point3D nearest_pt = p3d.project(PL);
-			Real r = (nearest_pt.origin - pos_i).norm();
-			float d = p3d.distance(PL);
-			//if (d < 0) continue;
-			d = abs(d);
-			dd = d;
+			Real wrr_ij = invAlpha * kernWRRMesh(coeff.r, smoothingLength) * coeff.geom;
+			diaA_total += 2.0f * wrr_ij;
+			diaA_test += 2.0f * wrr_ij;
 
-			Real AreaSum = p3d.areaTriangle(t3d, smoothingLength);
-			Real MinDistance = abs(p3d.distance(t3d));
-			Coord Min_Pt = (p3d.project(t3d)).origin - pos_i;
-			if (ne < nbSizeTri - 1 && neighborsTri.getElement(pId, ne + 1) < 0)
-			{
-				int jn;
-				do
-				{
-					jn = neighborsTri.getElement(pId, ne + 1);
-					if (jn > 0) break;
-					jn *= -1; jn--;
-
-					Triangle3D t3d_n(positionTri[m_triangle_index[jn][0]], positionTri[m_triangle_index[jn][1]], positionTri[m_triangle_index[jn][2]]);
-					if ((t3d.normal().cross(t3d_n.normal())).norm() > EPSILON) break;
-
-					AreaSum += p3d.areaTriangle(t3d_n, smoothingLength);
-
-					if (abs(p3d.distance(t3d_n)) < MinDistance)
-					{
-						MinDistance = abs(p3d.distance(t3d_n));
-						Min_Pt = (p3d.project(t3d_n)).origin - pos_i;
-					}
-					//printf("%d %d\n", j, jn);
-					ne++;
-				} while (ne < nbSizeTri - 1);
-			}
-			Min_Pt /= Min_Pt.norm();
-			if (smoothingLength - d > EPSILON&& smoothingLength* smoothingLength - d * d > EPSILON&& d > EPSILON)
-			{
-
-				//Coord n_PL = nearest_pt.origin - pos_i;
-				Coord n_PL = - t3d.normal();
-				if (flip[pId] < 0)  n_PL *= -1;
-				Coord n_TR = (p3d.project(t3d)).origin - pos_i;
-				n_PL = n_PL / n_PL.norm();
-				n_TR = n_TR / n_TR.norm();
-				Real wrr_ij = invAlpha *
-					kernWRRMesh(r, smoothingLength)
-					* 2.0 * (M_PI) * (1 - d / smoothingLength)
-					//* p3d.areaTriangle(t3d, smoothingLength) * n_PL.dot(n_TR)
-					* AreaSum * n_PL.dot(Min_Pt)
-					/ ((M_PI) * (smoothingLength * smoothingLength - d * d))
-					/ (m_sampling_distance * m_sampling_distance * m_sampling_distance);
-				//	printf("++++++++++++++++++++++++++++++++++++%.3lf\n", wrr_ij);
-				if (abs(wrr_ij) > 3000)
-				{
-					//	printf("WRR: %.3lf ANGLE: %.7lf distance:%.3lf weight:%.3lf\n", kernWRRMesh(r, smoothingLength), (smoothingLength * smoothingLength - d * d),
-					//		d,wrr_ij);
-				}
-				diaA_total += 2.0f * wrr_ij;
-				diaA_test += 2.0f * wrr_ij;
-			}
+			ne += coeff.span - 1;
 		}
 		Real diaA_GT = Real(0);
 		for (int ne = 0; ne < nbSize; ne++)
@@ -1341,6 +1311,7 @@ namespace PhysIKA
 	SemiAnalyticalIncompressibilityModule<TDataType>::~SemiAnalyticalIncompressibilityModule()
 	{
 		m_alpha.release();
+		m_triContributions.release();
 		m_Aii.release();
 		m_AiiFluid.release();
 		m_AiiTotal.release();
@@ -1432,6 +1403,12 @@ namespace PhysIKA
 
 		m_flip.getValue().reset();
 		m_alpha.reset();
+
+		int numTriPairs = m_neighborhood_triangles.getValue().elementSize();
+		if (m_triContributions.size() != numTriPairs)
+		{
+			m_triContributions.resize(numTriPairs);
+		}
 		//printf("sampling_distance = %.10lf; smoothing_length = %.10lf\n", m_sampling_distance.getValue(), m_smoothing_length.getValue());
 
 		VC_TriVelTmp << <pDimsT, BLOCK_SIZE >> > (
@@ -1451,13 +1428,25 @@ namespace PhysIKA
 			m_neighborhood_triangles.getValue()
 			);
 			
+		//derive the particle-triangle boundary coefficients once per substep
+		VC_CacheTriangleContributions << <pDims, BLOCK_SIZE >> > (
+			m_triContributions,
+			m_particle_position.getValue(),
+			m_triangle_index.getValue(),
+			m_triangle_vertex.getValue(),
+			m_particle_attribute.getValue(),
+			m_neighborhood_triangles.getValue(),
+			m_smoothing_length.getValue(),
+			m_sampling_distance.getValue(),
+			m_flip.getValue());
+		cuSynchronize();
+
 		VC_ComputeAlphaTmp << <pDims, BLOCK_SIZE >> > (
 			m_alpha,
 			Rho_alpha,
 			m_particle_mass.getValue(),
 			m_particle_position.getValue(),
-			m_triangle_index.getValue(),
-			m_triangle_vertex.getValue(),
+			m_triContributions,
 			m_particle_attribute.getValue(),
 			m_neighborhood_particles.getValue(),
 			m_neighborhood_triangles.getValue(),
@@ -1484,8 +1473,7 @@ namespace PhysIKA
 			m_AiiTotal,
 			m_alpha,
 			m_particle_position.getValue(),
-			m_triangle_index.getValue(),
-			m_triangle_vertex.getValue(),
+			m_triContributions,
 			m_particle_attribute.getValue(),
 			m_neighborhood_particles.getValue(),
 			m_neighborhood_triangles.getValue(),
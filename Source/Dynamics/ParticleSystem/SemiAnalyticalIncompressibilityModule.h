@@ -17,6 +17,21 @@ namespace PhysIKA {
 	//template <typename TDataType> class Plane3D;
 
 
+		/**
+	 * @brief Boundary integral coefficients of one particle / coplanar
+	 * triangle-run pair, derived once per substep and consumed by the
+	 * pressure setup kernels. geom folds the area sum, the plane distance
+	 * attenuation and the orientation term; span is the number of neighbor
+	 * slots the merged run covers (0 marks a slot consumed by a run head).
+	 */
+	template<typename Real>
+	struct TriangleContribution
+	{
+		Real r;
+		Real geom;
+		int span;
+	};
+
 	template<typename TDataType>
 	class SemiAnalyticalIncompressibilityModule : public ConstraintModule
 	{
@@ -90,6 +105,7 @@ namespace PhysIKA {
 
 		//Refer to "A Nonlocal Variational Particle Framework for Incompressible Free Surface Flows" for their exact meanings
 		DeviceArray<Real> m_alpha;
+		DeviceArray<TriangleContribution<Real>> m_triContributions;
 		DeviceArray<Real> Rho_alpha;
 		DeviceArray<Real> m_Aii;
 		DeviceArray<Real> m_AiiFluid;
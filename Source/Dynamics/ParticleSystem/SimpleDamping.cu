@@ -1,5 +1,6 @@
 #include <cuda_runtime.h>
 #include "Core/Utility.h"
+#include "Core/Utility/FunctionFuse.h"
 #include "Framework/Framework/Log.h"
 #include "Framework/Framework/FieldVar.h"
 #include "Framework/Framework/MechanicalState.h"
@@ -38,23 +39,12 @@ namespace PhysIKA
 		return true;
 	}
 
-	template <typename Real, typename Coord>
-	__global__ void K_DoDamping(
-		DeviceArray<Coord> vel,
-		Real coefficient)
-	{
-		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
-		if (pId >= vel.size()) return;
-		
-		vel[pId] *= coefficient;
-	}
-
 	template<typename TDataType>
 	bool SimpleDamping<TDataType>::constrain()
 	{
-		uint pDims = cudaGridSize(m_velocity.getValue().size(), BLOCK_SIZE);
-
-		K_DoDamping<< < pDims, BLOCK_SIZE >> > (m_velocity.getValue(), m_damping.getValue());
+		using namespace FunctionFuse;
+		evaluate(m_velocity.getValue().size(),
+			assign(m_velocity.getValue(), scale(m_damping.getValue(), term(m_velocity.getValue()))));
 
 		return true;
 	}
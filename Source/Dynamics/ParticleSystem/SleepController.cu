@@ -0,0 +1,77 @@
+#include "SleepController.h"
+#include "Framework/Framework/Node.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(SleepController, TDataType)
+
+	template<typename TDataType>
+	SleepController<TDataType>::SleepController()
+		: ComputeModule()
+	{
+	}
+
+	template<typename TDataType>
+	SleepController<TDataType>::~SleepController()
+	{
+		if (m_reduce != nullptr)
+		{
+			delete m_reduce;
+		}
+	}
+
+	template<typename TDataType>
+	void SleepController<TDataType>::wake()
+	{
+		m_quietFrames = 0;
+
+		Node* parent = this->getParent();
+		if (parent != nullptr)
+		{
+			parent->setActive(true);
+		}
+	}
+
+	template<typename TDataType>
+	void SleepController<TDataType>::compute()
+	{
+		Node* parent = this->getParent();
+		if (parent == nullptr || !parent->isActive())
+		{
+			return;
+		}
+
+		int num = this->inVelocity()->getElementCount();
+		if (num <= 0)
+		{
+			return;
+		}
+
+		if (m_reduce == nullptr || m_reduceNum != num)
+		{
+			if (m_reduce != nullptr) delete m_reduce;
+			m_reduce = Reduction<Real>::Create(3 * num);
+			m_reduceNum = num;
+		}
+
+		//infinity norm over the velocity components; the threshold compare
+		//does not need the exact particle speed
+		Real* velPtr = (Real*)this->inVelocity()->getValue().getDataPtr();
+		Real vMax = m_reduce->maximum(velPtr, 3 * num);
+		Real vMin = m_reduce->minimum(velPtr, 3 * num);
+		vMax = vMax > -vMin ? vMax : -vMin;
+
+		if (vMax < m_sleepThreshold)
+		{
+			m_quietFrames++;
+			if (m_quietFrames >= m_framesToSleep)
+			{
+				parent->setActive(false);
+			}
+		}
+		else
+		{
+			m_quietFrames = 0;
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Framework/Framework/ModuleCompute.h"
+#include "Framework/Framework/FieldArray.h"
+#include "Core/Utility/Reduction.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	SleepController
+	*	\brief	Kinetic-energy driven node sleeping.
+	*
+	*	Watches the per-particle velocities of its node and deactivates the
+	*	node once the maximum speed stays below the sleep threshold for a run
+	*	of consecutive frames, so settled debris stops paying for its whole
+	*	module pipeline in the animation traversal. A sleeping node is woken
+	*	through wake() — called by contact systems (see CollisionSDF) or
+	*	directly by the application.
+	*/
+	template<typename TDataType>
+	class SleepController : public ComputeModule
+	{
+		DECLARE_CLASS_1(SleepController, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		SleepController();
+		~SleepController() override;
+
+		void compute() override;
+
+		/**
+		 * @brief Maximum velocity component below which the node counts as
+		 * settled.
+		 */
+		void setSleepThreshold(Real v) { m_sleepThreshold = v; }
+
+		/**
+		 * @brief Consecutive settled frames required before the node sleeps.
+		 */
+		void setFramesToSleep(int num) { m_framesToSleep = num; }
+
+		/**
+		 * @brief Reactivate the parent node and restart the settling count.
+		 */
+		void wake();
+
+		/**
+		 * @brief Particle velocity
+		 */
+		DEF_EMPTY_IN_ARRAY(Velocity, Coord, DeviceType::GPU, "Particle velocity");
+
+	private:
+		Real m_sleepThreshold = Real(0.001);
+		int m_framesToSleep = 30;
+		int m_quietFrames = 0;
+
+		int m_reduceNum = 0;
+		Reduction<Real>* m_reduce = nullptr;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class SleepController<DataType3f>;
+#else
+	template class SleepController<DataType3d>;
+#endif
+}
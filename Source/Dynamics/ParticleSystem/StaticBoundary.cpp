@@ -3,6 +3,7 @@
 #include "Framework/Framework/Log.h"
 #include "Framework/Framework/Node.h"
 #include "Dynamics/ParticleSystem/BoundaryConstraint.h"
+#include "Dynamics/ParticleSystem/ParticleCompaction.h"
 
 #include "Framework/Topology/DistanceField3D.h"
 #include "Framework/Topology/TriangleSet.h"
@@ -20,6 +21,20 @@ namespace PhysIKA
 	template<typename TDataType>
 	StaticBoundary<TDataType>::~StaticBoundary()
 	{
+		m_cullFlags.release();
+	}
+
+	template<typename TDataType>
+	void StaticBoundary<TDataType>::setCullingBox(Coord lo, Coord hi)
+	{
+		m_cullingLo = lo;
+		m_cullingHi = hi;
+		m_culling = true;
+
+		if (m_compaction == nullptr)
+		{
+			m_compaction = std::make_shared<ParticleCompaction<TDataType>>();
+		}
 	}
 
 // 	template<typename TDataType>
@@ -56,6 +71,34 @@ namespace PhysIKA
 				m_obstacles[t]->constrain(posFd->getValue(), velFd->getValue(), dt);
 			}
 		}
+
+		if (m_culling)
+		{
+			for (int i = 0; i < pSys.size(); i++)
+			{
+				auto& pos = pSys[i]->currentPosition()->getValue();
+				auto& vel = pSys[i]->currentVelocity()->getValue();
+				auto& force = pSys[i]->currentForce()->getValue();
+
+				int num = pos.size();
+				if (num == 0) continue;
+
+				if (m_cullFlags.size() != num)
+				{
+					m_cullFlags.resize(num);
+				}
+
+				m_compaction->markInsideBox(m_cullFlags, pos, m_cullingLo, m_cullingHi);
+				int newNum = m_compaction->compact(m_cullFlags, pos, vel, force);
+
+				if (newNum < num)
+				{
+					pos.shrink(newNum);
+					vel.shrink(newNum);
+					force.shrink(newNum);
+				}
+			}
+		}
 	}
 
 	template<typename TDataType>
@@ -68,6 +111,23 @@ namespace PhysIKA
 	}
 
 
+	template<typename TDataType>
+	void StaticBoundary<TDataType>::loadMesh(std::string filename, Real distance, bool bOutBoundary, bool bVisible)
+	{
+		auto triSet = std::make_shared<TriangleSet<TDataType>>();
+		triSet->loadObjFile(filename);
+
+		auto boundary = std::make_shared<BoundaryConstraint<TDataType>>();
+		boundary->setMesh(triSet, distance, bOutBoundary);
+
+		m_obstacles.push_back(boundary);
+
+		auto m_surfaceNode = this->createChild<Node>("boundary_mesh");
+		m_surfaceNode->setControllable(false);
+		m_surfaceNode->setTopologyModule(triSet);
+		m_surfaceNode->setVisible(bVisible);
+	}
+
 	template<typename TDataType>
 	void StaticBoundary<TDataType>::loadCube(Coord lo, Coord hi, Real distance, bool bOutBoundary /*= false*/, bool bVisible)
 	{
@@ -132,4 +192,10 @@ namespace PhysIKA
 			m_obstacles[i]->m_cSDF->translate(t);
 		}
 	}
+
+#ifdef PRECISION_FLOAT
+	template class StaticBoundary<DataType3f>;
+#else
+	template class StaticBoundary<DataType3d>;
+#endif
 }
\ No newline at end of file
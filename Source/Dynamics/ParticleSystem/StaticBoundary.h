@@ -10,6 +10,7 @@ namespace PhysIKA {
 // 	template <typename TDataType> class ParticleSystem;
 	template <typename TDataType> class DistanceField3D;
 	template <typename TDataType> class BoundaryConstraint;
+	template <typename TDataType> class ParticleCompaction;
 
 	template<typename TDataType>
 	class StaticBoundary : public Node
@@ -28,12 +29,21 @@ namespace PhysIKA {
 		void advance(Real dt) override;
 
 		void loadSDF(std::string filename, bool bOutBoundary = false);
+
+		/// bake the boundary SDF from an obj mesh on the GPU at load time
+		void loadMesh(std::string filename, Real distance = 0.005f, bool bOutBoundary = false, bool bVisible = false);
 		void loadCube(Coord lo, Coord hi, Real distance = 0.005f, bool bOutBoundary = false, bool bVisible = false);
 		void loadShpere(Coord center, Real r, Real distance = 0.005f, bool bOutBoundary = false, bool bVisible = false);
 
 		void translate(Coord t);
 		void scale(Real s);
 
+		/*!
+		*	\brief	Delete particles that leave the given box. The filter runs
+		*	entirely on the device after the boundary constraints each step.
+		*/
+		void setCullingBox(Coord lo, Coord hi);
+
 	public:
 
 		std::vector<std::shared_ptr<BoundaryConstraint<TDataType>>> m_obstacles;
@@ -43,13 +53,21 @@ namespace PhysIKA {
 
 		DEF_NODE_PORTS(RigidBody, RigidBody<TDataType>, "A rigid body");
 		DEF_NODE_PORTS(ParticleSystem, ParticleSystem<TDataType>, "Particle Systems");
+
+	private:
+		bool m_culling = false;
+		Coord m_cullingLo;
+		Coord m_cullingHi;
+
+		DeviceArray<int> m_cullFlags;
+		std::shared_ptr<ParticleCompaction<TDataType>> m_compaction;
 	};
 
 
 #ifdef PRECISION_FLOAT
-template class StaticBoundary<DataType3f>;
+extern template class StaticBoundary<DataType3f>;
 #else
-template class StaticBoundary<DataType3d>;
+extern template class StaticBoundary<DataType3d>;
 #endif
 
 }
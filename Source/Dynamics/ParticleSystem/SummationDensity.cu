@@ -1,9 +1,11 @@
 #include <cuda_runtime.h>
+#include <cuda_fp16.h>
 #include "SummationDensity.h"
 #include "Framework/Framework/MechanicalState.h"
 #include "Framework/Framework/Node.h"
 #include "Core/Utility.h"
 #include "Kernel.h"
+#include "GhostParticles.h"
 
 namespace PhysIKA
 {
@@ -19,22 +21,129 @@ namespace PhysIKA
 	)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		//Stage the block's own positions once: with a spatially sorted layout
+		//most neighbor indices fall into the block's index range, so the inner
+		//loop serves them from shared memory instead of global gathers.
+		__shared__ Coord shPos[BLOCK_SIZE];
+		int blockStart = blockIdx.x * blockDim.x;
+		if (pId < posArr.size())
+		{
+			shPos[threadIdx.x] = posArr[pId];
+		}
+		__syncthreads();
+
 		if (pId >= posArr.size()) return;
 
-		SpikyKernel<Real> kern;
+		FixedSpikyKernel<Real> kern(smoothingLength);
 		Real r;
 		Real rho_i = Real(0);
-		Coord pos_i = posArr[pId];
+		Coord pos_i = shPos[threadIdx.x];
 		int nbSize = neighbors.getNeighborSize(pId);
 		for (int ne = 0; ne < nbSize; ne++)
 		{
 			int j = neighbors.getElement(pId, ne);
-			r = (pos_i - posArr[j]).norm();
-			rho_i += mass*kern.Weight(r, smoothingLength);
+			Coord pos_j = (j >= blockStart && j < blockStart + BLOCK_SIZE) ? shPos[j - blockStart] : posArr[j];
+			r = (pos_i - pos_j).norm();
+			rho_i += mass*kern.Weight(r);
+		}
+		rhoArr[pId] = rho_i;
+	}
+
+	template<typename Coord>
+	__global__ void K_PackHalfPositions(
+		DeviceArray<ushort4> packed,
+		DeviceArray<Coord> posArr)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord p = posArr[pId];
+		ushort4 h;
+		h.x = __half_as_ushort(__float2half((float)p[0]));
+		h.y = __half_as_ushort(__float2half((float)p[1]));
+		h.z = __half_as_ushort(__float2half((float)p[2]));
+		h.w = 0;
+		packed[pId] = h;
+	}
+
+	//Half-precision gather variant: the packed mirror halves the bytes moved
+	//per neighbor while the density itself accumulates in full precision.
+	template<typename Real, typename Coord>
+	__global__ void K_ComputeDensityHalf(
+		DeviceArray<Real> rhoArr,
+		DeviceArray<ushort4> packed,
+		NeighborList<int> neighbors,
+		Real smoothingLength,
+		Real mass)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= rhoArr.size()) return;
+
+		FixedSpikyKernel<Real> kern(smoothingLength);
+		Real rho_i = Real(0);
+
+		ushort4 hp_i = packed[pId];
+		float x_i = __half2float(__ushort_as_half(hp_i.x));
+		float y_i = __half2float(__ushort_as_half(hp_i.y));
+		float z_i = __half2float(__ushort_as_half(hp_i.z));
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			ushort4 hp_j = packed[j];
+
+			float dx = x_i - __half2float(__ushort_as_half(hp_j.x));
+			float dy = y_i - __half2float(__ushort_as_half(hp_j.y));
+			float dz = z_i - __half2float(__ushort_as_half(hp_j.z));
+
+			Real r = sqrt(dx * dx + dy * dy + dz * dz);
+			rho_i += mass * kern.Weight(r);
 		}
 		rhoArr[pId] = rho_i;
 	}
 
+	//Ghost contribution: the boundary samples are static, so instead of a
+	//per-frame neighbor list each fluid particle walks the 27 cells of the
+	//hash that was built once over the ghosts.
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void K_ComputeDensityGhosts(
+		DeviceArray<Real> rhoArr,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> ghostArr,
+		GridHash<TDataType> hash,
+		Real smoothingLength,
+		Real mass)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		FixedSpikyKernel<Real> kern(smoothingLength);
+		Coord pos_i = posArr[pId];
+		int3 cell = hash.getIndex3(pos_i);
+
+		Real rho_i = Real(0);
+		for (int c = 0; c < 27; c++)
+		{
+			int cellId = hash.getIndex(cell.x + c % 3 - 1, cell.y + (c / 3) % 3 - 1, cell.z + c / 9 - 1);
+			if (cellId == INVALID) continue;
+
+			int nbSize = hash.getCounter(cellId);
+			for (int ne = 0; ne < nbSize; ne++)
+			{
+				int j = hash.getParticleId(cellId, ne);
+				Real r = (pos_i - ghostArr[j]).norm();
+				rho_i += mass * kern.Weight(r);
+			}
+		}
+
+		if (rho_i > Real(0))
+		{
+			rhoArr[pId] += rho_i;
+		}
+	}
+
 	template<typename TDataType>
 	SummationDensity<TDataType>::SummationDensity()
 		: ComputeModule()
@@ -78,6 +187,17 @@ namespace PhysIKA
 			this->varSmoothingLength()->getValue(),
 			m_particle_mass);
 
+		if (m_ghosts != nullptr && m_ghosts->size() > 0)
+		{
+			cuExecute(p_num, K_ComputeDensityGhosts,
+				this->outDensity()->getValue(),
+				this->inPosition()->getValue(),
+				m_ghosts->getPosition(),
+				m_ghosts->getHash(),
+				this->varSmoothingLength()->getValue(),
+				m_factor * m_particle_mass);
+		}
+
 		this->outDensity()->tagModified(true);
 	}
 
@@ -101,6 +221,27 @@ namespace PhysIKA
 		Real smoothingLength,
 		Real mass)
 	{
+		if (m_use_half)
+		{
+			if (m_half_pos.size() != pos.size())
+			{
+				m_half_pos.resize(pos.size());
+			}
+
+			cuExecute(pos.size(), K_PackHalfPositions,
+				m_half_pos,
+				pos);
+
+			cuExecute(rho.size(), K_ComputeDensityHalf,
+				rho,
+				m_half_pos,
+				neighbors,
+				smoothingLength,
+				m_factor*mass);
+
+			return;
+		}
+
 		cuExecute(rho.size(), K_ComputeDensity,
 			rho, 
 			pos, 
@@ -118,7 +259,7 @@ namespace PhysIKA
 		
 		Real V = d * d*d;
 
-		SpikyKernel<Real> kern;
+		FixedSpikyKernel<Real> kern(H);
 
 		Real total_weight(0);
 		int half_res = H / d + 1;
@@ -130,7 +271,7 @@ namespace PhysIKA
 					Real y = j * d;
 					Real z = k * d;
 					Real r = sqrt(x * x + y * y + z * z);
-					total_weight += V * kern.Weight(r, H);
+					total_weight += V * kern.Weight(r);
 				}
 
 		m_factor = 1.0 / total_weight;
@@ -147,4 +288,10 @@ namespace PhysIKA
 		m_particle_mass = d*d*d*rho_0;
 	}
 
+
+#ifdef PRECISION_FLOAT
+	template class SummationDensity<DataType3f>;
+#else
+	template class SummationDensity<DataType3d>;
+#endif
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Core/Utility.h"
 #include "SurfaceTension.h"
 #include "Framework/Framework/MechanicalState.h"
+#include "Framework/Framework/Node.h"
 #include "Framework/Topology/NeighborList.h"
 #include "Kernel.h"
 
@@ -17,6 +18,16 @@ namespace PhysIKA
 	)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		//Block-tiled gather: see K_ComputeDensity.
+		__shared__ Coord shPos[BLOCK_SIZE];
+		int blockStart = blockIdx.x * blockDim.x;
+		if (pId < posArr.size())
+		{
+			shPos[threadIdx.x] = posArr[pId];
+		}
+		__syncthreads();
+
 		if (pId >= posArr.size()) return;
 
 		Real total_weight = Real(0);
@@ -24,18 +35,19 @@ namespace PhysIKA
 
 		SmoothKernel<Real> kern;
 
-		Coord pos_i = posArr[pId];
+		Coord pos_i = shPos[threadIdx.x];
 		int nbSize = neighbors.getNeighborSize(pId);
 		for (int ne = 0; ne < nbSize; ne++)
 		{
 			int j = neighbors.getElement(pId, ne);
-			Real r = (pos_i - posArr[j]).norm();
+			Coord pos_j = (j >= blockStart && j < blockStart + BLOCK_SIZE) ? shPos[j - blockStart] : posArr[j];
+			Real r = (pos_i - pos_j).norm();
 
 			if (r > EPSILON)
 			{
 				Real weight = -kern.Gradient(r, smoothingLength);
 				total_weight += weight;
-				dir_i += (posArr[j] - pos_i)*(weight / r);
+				dir_i += (pos_j - pos_i)*(weight / r);
 			}
 		}
 
@@ -59,6 +71,16 @@ namespace PhysIKA
 	)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		//Block-tiled gather: see K_ComputeDensity.
+		__shared__ Coord shPos[BLOCK_SIZE];
+		int blockStart = blockIdx.x * blockDim.x;
+		if (pId < posArr.size())
+		{
+			shPos[threadIdx.x] = posArr[pId];
+		}
+		__syncthreads();
+
 		if (pId >= posArr.size()) return;
 
 		Real Vref = mass / restDensity;
@@ -70,16 +92,17 @@ namespace PhysIKA
 
 		Coord F_i(0);
 		Coord dv_pi(0);
-		Coord pos_i = posArr[pId];
+		Coord pos_i = shPos[threadIdx.x];
 		int nbSize = neighbors.getNeighborSize(pId);
 		for (int ne = 0; ne < nbSize; ne++)
 		{
 			int j = neighbors.getElement(pId, ne);
-			float r = (pos_i - posArr[j]).norm();
+			Coord pos_j = (j >= blockStart && j < blockStart + BLOCK_SIZE) ? shPos[j - blockStart] : posArr[j];
+			float r = (pos_i - pos_j).norm();
 
 			if (r > EPSILON)
 			{
-				Coord temp = Vref*Vref*kern.Gradient(r, smoothingLength)*(posArr[j] - pos_i) * (1.0f / r);
+				Coord temp = Vref*Vref*kern.Gradient(r, smoothingLength)*(pos_j - pos_i) * (1.0f / r);
 				Coord dv_ij = dt * ceof*1.0f*(energyArr[pId])*temp / mass;
 				F_i += dv_ij;
 
@@ -103,31 +126,64 @@ namespace PhysIKA
 		, m_neighborhoodID(MechanicalState::particle_neighbors())
 		, m_intensity(Real(1))
 		, m_soothingLength(Real(0.0125))
+		, m_mass(Real(1))
+		, m_restDensity(Real(1000))
 	{
+		attachField(&m_position, "position", "Storing the particle positions!", false);
+		attachField(&m_velocity, "velocity", "Storing the particle velocities!", false);
+		attachField(&m_neighborhood, "neighborhood", "Storing neighboring particles' ids!", false);
+	}
 
+	template<typename TDataType>
+	SurfaceTension<TDataType>::~SurfaceTension()
+	{
+		m_energy.release();
 	}
 
 	template<typename TDataType>
 	bool SurfaceTension<TDataType>::execute()
 	{
-// 		m_energy = DeviceBuffer<Real>::create(num);
-// 
-// 		DeviceArray<Coord>* posArr = m_parent->GetNewPositionBuffer()->getDataPtr();
-// 		DeviceArray<Coord>* velArr = m_parent->GetNewVelocityBuffer()->getDataPtr();
-// 		DeviceArray<Attribute>* attArr = m_parent->GetAttributeBuffer()->getDataPtr();
-// 		float dt = m_parent->getDt();
-// 
-// 		DeviceArray<SPHNeighborList>* neighborArr = m_parent->GetNeighborBuffer()->getDataPtr();
-// 
-// 		DeviceArray<Real>* energy = m_energy->getDataPtr();
-// 
-// 		Real mass = m_parent->GetParticleMass();
-// 		Real smoothingLength = m_parent->GetSmoothingLength();
-// 		Real restDensity = m_parent->GetRestDensity();
-// 
-// 		uint pDims = cudaGridSize(posArr->size(), BLOCK_SIZE);
-// 		ST_ComputeSurfaceEnergy <Real, Coord> << < pDims, BLOCK_SIZE >> > (*energy, *posArr, *neighborArr, smoothingLength);
-// 		ST_ComputeSurfaceTension <Real, Coord> << < pDims, BLOCK_SIZE >> > (*velArr, *energy, *posArr, *attArr, *neighborArr, smoothingLength, mass, restDensity, dt);
+		if (m_position.isEmpty() || m_velocity.isEmpty() || m_neighborhood.isEmpty())
+		{
+			return false;
+		}
+
+		int num = m_position.getElementCount();
+		Real dt = getParent()->getDt();
+
+		uint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+		//the surface geometry varies slowly across substeps, so the
+		//energies are refreshed on the cache interval and reused in
+		//between; a count change invalidates the cache
+		bool refresh = m_energy.size() != num || m_callCounter % m_cacheInterval == 0;
+		if (m_energy.size() != num)
+		{
+			m_energy.resize(num);
+			m_callCounter = 0;
+		}
+
+		if (refresh)
+		{
+			ST_ComputeSurfaceEnergy << < pDims, BLOCK_SIZE >> > (
+				m_energy,
+				m_position.getValue(),
+				m_neighborhood.getValue(),
+				m_soothingLength);
+			cuSynchronize();
+		}
+		m_callCounter++;
+
+		ST_ComputeSurfaceTension << < pDims, BLOCK_SIZE >> > (
+			m_velocity.getValue(),
+			m_energy,
+			m_position.getValue(),
+			m_neighborhood.getValue(),
+			m_soothingLength,
+			m_mass,
+			m_restDensity,
+			dt);
+		cuSynchronize();
 
 		return true;
 	}
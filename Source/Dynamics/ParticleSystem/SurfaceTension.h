@@ -1,6 +1,7 @@
 #pragma once
 #include "Framework/Framework/ModuleForce.h"
 #include "Framework/Framework/FieldArray.h"
+#include "Framework/Topology/FieldNeighbor.h"
 
 namespace PhysIKA {
 
@@ -12,8 +13,8 @@ namespace PhysIKA {
 		typedef typename TDataType::Coord Coord;
 
 		SurfaceTension();
-		~SurfaceTension() override {};
-		
+		~SurfaceTension() override;
+
 		bool execute() override;
 
 		bool applyForce() override;
@@ -25,6 +26,26 @@ namespace PhysIKA {
 		void setIntensity(Real intensity) { m_intensity = intensity; }
 		void setSmoothingLength(Real len) { m_soothingLength = len; }
 
+		void setParticleMass(Real mass) { m_mass = mass; }
+		void setRestDensity(Real rho) { m_restDensity = rho; }
+
+		/**
+		 * @brief Recompute the surface-energy pass only every interval-th
+		 * call instead of every substep. The energy is a pure function of
+		 * the surface geometry, which barely moves within one frame, so
+		 * the force pass can consume the cached values across substeps;
+		 * with n substeps per frame this cuts the module's cost roughly
+		 * by n. The cache is also refreshed whenever the particle count
+		 * changes. The default of 1 keeps the old per-call behavior.
+		 */
+		void setCacheInterval(int interval) { m_cacheInterval = interval < 1 ? 1 : interval; }
+
+	public:
+		DeviceArrayField<Coord> m_position;
+		DeviceArrayField<Coord> m_velocity;
+
+		NeighborField<int> m_neighborhood;
+
 	protected:
 		FieldID m_posID;
 		FieldID m_velID;
@@ -33,8 +54,13 @@ namespace PhysIKA {
 	private:
 		Real m_intensity;
 		Real m_soothingLength;
+		Real m_mass;
+		Real m_restDensity;
 
-		DeviceArrayField<Real>* m_energy;
+		//per-particle surface energies, cached across substeps
+		DeviceArray<Real> m_energy;
+		int m_cacheInterval = 1;
+		int m_callCounter = 0;
 	};
 
 #ifdef PRECISION_FLOAT
@@ -42,4 +68,4 @@ namespace PhysIKA {
 #else
 	template class SurfaceTension<DataType3d>;
 #endif
-}
\ No newline at end of file
+}
@@ -0,0 +1,86 @@
+#include "TriangleMeshWriter.h"
+#include "Framework/Topology/TriangleSet.h"
+#include "Core/Utility/cuda_utilities.h"
+#include "IO/Particle_Cache/AsyncWriteQueue.h"
+
+#include <sstream>
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(TriangleMeshWriter, TDataType)
+
+	template<typename TDataType>
+	TriangleMeshWriter<TDataType>::TriangleMeshWriter()
+		: IOModule()
+	{
+	}
+
+	template<typename TDataType>
+	TriangleMeshWriter<TDataType>::~TriangleMeshWriter()
+	{
+	}
+
+	template<typename TDataType>
+	void TriangleMeshWriter<TDataType>::setNamePrefix(std::string prefix)
+	{
+		m_name_prefix = prefix;
+	}
+
+	template<typename TDataType>
+	void TriangleMeshWriter<TDataType>::setOutputPath(std::string path)
+	{
+		m_output_path = path;
+	}
+
+	template<typename TDataType>
+	void TriangleMeshWriter<TDataType>::setTopology(std::shared_ptr<TriangleSet<TDataType>> triSet)
+	{
+		m_triangle_set = triSet;
+	}
+
+	template<typename TDataType>
+	bool TriangleMeshWriter<TDataType>::execute()
+	{
+		if (m_triangle_set == nullptr)
+		{
+			return false;
+		}
+
+		std::stringstream ss; ss << m_output_index;
+		std::string filename = m_output_path + m_name_prefix + ss.str() + std::string(".pcache");
+
+		DeviceArray<Coord>& points = m_triangle_set->getPoints();
+		DeviceArray<Triangle>& triangles = *(m_triangle_set->getTriangles());
+
+		int vertNum = points.size();
+		int triNum = triangles.size();
+
+		std::uint64_t posBytes = std::uint64_t(vertNum) * sizeof(Coord);
+		std::uint64_t triBytes = std::uint64_t(triNum) * sizeof(Triangle);
+
+		AsyncWriteQueue& queue = AsyncWriteQueue::getInstance();
+		int slot = queue.acquireSlot(posBytes + triBytes);
+
+		if (vertNum > 0)
+		{
+			cuSafeCall(cudaMemcpyAsync(queue.slotBuffer(slot), points.getDataPtr(), posBytes, cudaMemcpyDeviceToHost, queue.stream()));
+		}
+		if (triNum > 0)
+		{
+			cuSafeCall(cudaMemcpyAsync(queue.slotBuffer(slot) + posBytes, triangles.getDataPtr(), triBytes, cudaMemcpyDeviceToHost, queue.stream()));
+		}
+
+		AsyncWriteQueue::FrameDesc desc;
+		desc.filename = filename;
+		desc.particleNum = (std::uint32_t)vertNum;
+		desc.triangleNum = (std::uint32_t)triNum;
+		desc.realBytes = (std::uint32_t)sizeof(Real);
+		desc.posOffset = 0;
+		desc.triOffset = (std::int64_t)posBytes;
+		queue.submit(slot, desc);
+
+		m_output_index++;
+
+		return true;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Framework/Framework/ModuleIO.h"
+#include "Framework/Framework/ModuleTopology.h"
+
+#include <memory>
+#include <string>
+
+namespace PhysIKA
+{
+	template <typename TDataType> class TriangleSet;
+
+	/**
+	 * @brief Per-frame writer for a deforming triangle mesh.
+	 *
+	 * Writes the vertex positions and triangle indices of a TriangleSet as
+	 * binary cache frames (IO/Particle_Cache) through the background writer
+	 * pipeline, so mesh output never stalls the simulation thread.
+	 */
+	template<typename TDataType>
+	class TriangleMeshWriter : public IOModule
+	{
+		DECLARE_CLASS_1(TriangleMeshWriter, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef typename TopologyModule::Triangle Triangle;
+
+		TriangleMeshWriter();
+		virtual ~TriangleMeshWriter();
+
+		void setNamePrefix(std::string prefix);
+		void setOutputPath(std::string path);
+
+		void setTopology(std::shared_ptr<TriangleSet<TDataType>> triSet);
+
+		bool execute() override;
+
+	private:
+		int m_output_index = 0;
+		std::string m_output_path;
+		std::string m_name_prefix;
+
+		std::shared_ptr<TriangleSet<TDataType>> m_triangle_set;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class TriangleMeshWriter<DataType3f>;
+#else
+	template class TriangleMeshWriter<DataType3d>;
+#endif
+}
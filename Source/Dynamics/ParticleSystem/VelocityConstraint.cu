@@ -397,6 +397,67 @@ namespace PhysIKA
 		}
 	}
 
+	/**
+	 * Branchless variant launched over the compacted dynamic-index list:
+	 * every thread is a dynamic particle, so the kinematic guard of the
+	 * overload above - one divergent branch per warp in mixed scenes,
+	 * paid on every CG iteration - disappears from the hot loop.
+	 */
+	template <typename Real, typename Coord>
+	__global__ void VC_ComputeAx
+	(
+		DeviceArray<Real> residual,
+		DeviceArray<Real> pressure,
+		DeviceArray<Real> aiiSymArr,
+		DeviceArray<Real> alpha,
+		DeviceArray<Coord> position,
+		DeviceArray<Attribute> attribute,
+		NeighborList<int> neighbor,
+		DeviceArray<int> dynamicIds,
+		int dynamicNum,
+		Real smoothingLength
+	)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= dynamicNum) return;
+
+		int pId = dynamicIds[tId];
+
+		Coord pos_i = position[pId];
+		Real invAlpha_i = 1.0f / alpha[pId];
+
+		atomicAdd(&residual[pId], aiiSymArr[pId] * pressure[pId]);
+		Real con1 = 1.0f;// PARAMS.mass / PARAMS.restDensity / PARAMS.restDensity;
+
+		int nbSize = neighbor.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbor.getElement(pId, ne);
+			Real r = (pos_i - position[j]).norm();
+
+			if (r > EPSILON && attribute[j].IsDynamic())
+			{
+				Real wrr_ij = kernWRR(r, smoothingLength);
+				Real a_ij = -invAlpha_i*wrr_ij;
+				atomicAdd(&residual[pId], con1*a_ij*pressure[j]);
+				atomicAdd(&residual[j], con1*a_ij*pressure[pId]);
+			}
+		}
+	}
+
+	template<typename Real>
+	__global__ void VC_ApplyDiagonalPrecond(
+		DeviceArray<Real> zArr,
+		DeviceArray<Real> rArr,
+		DeviceArray<Real> aiiArr)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= zArr.size()) return;
+
+		Real a = aiiArr[pId];
+		zArr[pId] = a > EPSILON ? rArr[pId] / a : rArr[pId];
+	}
+
 	template <typename Real, typename Coord>
 	__global__ void VC_UpdateVelocityBoundaryCorrected(
 		DeviceArray<Real> pressure,
@@ -546,6 +607,9 @@ namespace PhysIKA
 		attachField(&m_normal, "normal", "Storing the particle normals!", false);
 		attachField(&m_attribute, "attribute", "Storing the particle attributes!", false);
 		attachField(&m_neighborhood, "neighborhood", "Storing neighboring particles' ids!", false);
+
+		m_iterationCount.setValue(0);
+		m_residualError.setValue(Real(0));
 	}
 
 	template<typename TDataType>
@@ -562,6 +626,7 @@ namespace PhysIKA
 		m_y.release();
 		m_r.release();
 		m_p.release();
+		m_z.release();
 
 		m_pressure.release();
 
@@ -647,54 +712,125 @@ namespace PhysIKA
 			m_restDensity, 
 			dt);
 		
-		//solve the linear system of equations with a conjugate gradient method.
+		//solve the linear system of equations with a conjugate gradient method,
+		//starting from the previous step's pressure unless warm starting is off
+		if (!m_warmStart)
+		{
+			m_pressure.reset();
+		}
+
+		//attributes do not change within a step, so the dynamic indices are
+		//compacted once and every matrix-vector product launches branchless
+		//over them
+		m_partition.update(m_attribute.getValue());
+		int dynNum = m_partition.dynamicCount();
+		uint dynDims = cudaGridSize(dynNum, BLOCK_SIZE);
+
 		m_y.reset();
-		VC_ComputeAx << <pDims, BLOCK_SIZE >> > (
-			m_y, 
-			m_pressure, 
-			m_Aii, 
-			m_alpha, 
+		VC_ComputeAx << <dynDims, BLOCK_SIZE >> > (
+			m_y,
+			m_pressure,
+			m_Aii,
+			m_alpha,
 			m_position.getValue(),
 			m_attribute.getValue(),
 			m_neighborhood.getValue(),
+			m_partition.dynamicIndices(),
+			dynNum,
 			m_smoothingLength.getValue());
 
 		m_r.reset();
 		Function2Pt::subtract(m_r, m_divergence, m_y);
-		Function1Pt::copy(m_p, m_r);
 		Real rr = m_arithmetic->Dot(m_r, m_r);
 		Real err = sqrt(rr / m_r.size());
 
-		while (itor < 1000 && err > 1.0f)
+		if (m_usePrecond)
 		{
-			m_y.reset();
-			//VC_ComputeAx << <pDims, BLOCK_SIZE >> > (*yArr, *pArr, *aiiArr, *alphaArr, *posArr, *attArr, *neighborArr);
-			VC_ComputeAx << <pDims, BLOCK_SIZE >> > (
-				m_y, 
-				m_p, 
-				m_Aii, 
-				m_alpha, 
-				m_position.getValue(),
-				m_attribute.getValue(),
-				m_neighborhood.getValue(),
-				m_smoothingLength.getValue());
-
-			float alpha = rr / m_arithmetic->Dot(m_p, m_y);
-			Function2Pt::saxpy(m_pressure, m_p, m_pressure, alpha);
-			Function2Pt::saxpy(m_r, m_y, m_r, -alpha);
-
-			Real rr_old = rr;
-
-			rr = m_arithmetic->Dot(m_r, m_r);
-
-			Real beta = rr / rr_old;
-			Function2Pt::saxpy(m_p, m_p, m_r, beta);
-
-			err = sqrt(rr / m_r.size());
+			//preconditioned variant: the search direction follows z = r / Aii
+			//and the step sizes use (r, z) instead of (r, r).
+			VC_ApplyDiagonalPrecond << <pDims, BLOCK_SIZE >> > (
+				m_z,
+				m_r,
+				m_Aii);
+			Function1Pt::copy(m_p, m_z);
+			Real rz = m_arithmetic->Dot(m_r, m_z);
+
+			while (itor < 1000 && err > 1.0f)
+			{
+				m_y.reset();
+				VC_ComputeAx << <dynDims, BLOCK_SIZE >> > (
+					m_y,
+					m_p,
+					m_Aii,
+					m_alpha,
+					m_position.getValue(),
+					m_attribute.getValue(),
+					m_neighborhood.getValue(),
+					m_partition.dynamicIndices(),
+					dynNum,
+					m_smoothingLength.getValue());
+
+				float alpha = rz / m_arithmetic->Dot(m_p, m_y);
+				Function2Pt::saxpy(m_pressure, m_p, m_pressure, alpha);
+				Function2Pt::saxpy(m_r, m_y, m_r, -alpha);
+
+				VC_ApplyDiagonalPrecond << <pDims, BLOCK_SIZE >> > (
+					m_z,
+					m_r,
+					m_Aii);
+
+				Real rz_old = rz;
+				rz = m_arithmetic->Dot(m_r, m_z);
+
+				Real beta = rz / rz_old;
+				Function2Pt::saxpy(m_p, m_p, m_z, beta);
+
+				rr = m_arithmetic->Dot(m_r, m_r);
+				err = sqrt(rr / m_r.size());
+
+				itor++;
+			}
+		}
+		else
+		{
+			Function1Pt::copy(m_p, m_r);
 
-			itor++;
+			while (itor < 1000 && err > 1.0f)
+			{
+				m_y.reset();
+				//VC_ComputeAx << <pDims, BLOCK_SIZE >> > (*yArr, *pArr, *aiiArr, *alphaArr, *posArr, *attArr, *neighborArr);
+				VC_ComputeAx << <dynDims, BLOCK_SIZE >> > (
+					m_y,
+					m_p,
+					m_Aii,
+					m_alpha,
+					m_position.getValue(),
+					m_attribute.getValue(),
+					m_neighborhood.getValue(),
+					m_partition.dynamicIndices(),
+					dynNum,
+					m_smoothingLength.getValue());
+
+				float alpha = rr / m_arithmetic->Dot(m_p, m_y);
+				Function2Pt::saxpy(m_pressure, m_p, m_pressure, alpha);
+				Function2Pt::saxpy(m_r, m_y, m_r, -alpha);
+
+				Real rr_old = rr;
+
+				rr = m_arithmetic->Dot(m_r, m_r);
+
+				Real beta = rr / rr_old;
+				Function2Pt::saxpy(m_p, m_p, m_r, beta);
+
+				err = sqrt(rr / m_r.size());
+
+				itor++;
+			}
 		}
 
+		m_iterationCount.setValue(itor);
+		m_residualError.setValue(err);
+
 		//update the each particle's velocity
 		VC_UpdateVelocityBoundaryCorrected << <pDims, BLOCK_SIZE >> > (
 			m_pressure,
@@ -743,8 +879,11 @@ namespace PhysIKA
 		m_y.resize(num);
 		m_r.resize(num);
 		m_p.resize(num);
+		m_z.resize(num);
 
 		m_pressure.resize(num);
+		//the first solve has no previous pressure to carry over
+		m_pressure.reset();
 
 		m_reduce = Reduction<float>::Create(num);
 		m_arithmetic = Arithmetic<float>::Create(num);
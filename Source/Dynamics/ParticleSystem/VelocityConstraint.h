@@ -4,10 +4,10 @@
 #include "Core/Utility.h"
 #include "Framework/Framework/FieldVar.h"
 #include "Framework/Topology/FieldNeighbor.h"
+#include "AttributePartition.h"
 
 namespace PhysIKA {
 
-	class Attribute;
 	template<typename TDataType> class SummationDensity;
 
 	template<typename TDataType>
@@ -22,9 +22,31 @@ namespace PhysIKA {
 		
 		bool constrain() override;
 
+		/**
+		 * @brief Switch the pressure solve to Jacobi-preconditioned conjugate
+		 * gradients. Dividing the residual by the diagonal costs one extra
+		 * element-wise kernel per iteration and roughly halves the iteration
+		 * count on shallow-but-wide pools where the diagonal varies strongly
+		 * between surface and interior particles.
+		 */
+		void setPreconditioned(bool enabled) { m_usePrecond = enabled; }
+
+		/**
+		 * @brief Keep the pressure field of the previous step as the initial
+		 * guess of the conjugate gradient solve (default on). The pressure
+		 * field is temporally smooth, so the carried guess starts the
+		 * iteration close to the solution; disabling it restarts every solve
+		 * from zero.
+		 */
+		void setWarmStart(bool enabled) { m_warmStart = enabled; }
+
 	public:
 		VarField<Real> m_smoothingLength;
 
+		//Solver statistics of the last constrain() call.
+		VarField<int> m_iterationCount;
+		VarField<Real> m_residualError;
+
 		DeviceArrayField<Coord> m_velocity;
 		DeviceArrayField<Coord> m_position;
 		DeviceArrayField<Coord> m_normal;
@@ -36,6 +58,8 @@ namespace PhysIKA {
 
 	private:
 		bool m_bConfigured = false;
+		bool m_usePrecond = false;
+		bool m_warmStart = true;
 		Real m_maxAlpha;
 		Real m_maxA;
 		Real m_airPressure = 0.0f;
@@ -62,10 +86,15 @@ namespace PhysIKA {
 		DeviceArray<Real> m_y;
 		DeviceArray<Real> m_r;
 		DeviceArray<Real> m_p;
+		DeviceArray<Real> m_z;
 
 		Reduction<Real>* m_reduce;
 		Arithmetic<Real>* m_arithmetic;
 
+		//dynamic-index compaction; the CG matrix-vector products launch
+		//over it instead of branching on the kinematic attribute
+		AttributePartition m_partition;
+
 		std::shared_ptr<SummationDensity<TDataType>> m_densitySum;
 	};
 
@@ -0,0 +1,197 @@
+#include "VorticityConfinement.h"
+#include "Core/Utility.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Topology/NeighborList.h"
+#include "Kernel.h"
+
+namespace PhysIKA
+{
+	/*!
+	*	\brief	SPH curl of the velocity field: omega_i = sum_j (v_j - v_i) x gradW_ij.
+	*	The magnitude rides along in the w component so the confinement sweep
+	*	gets both with one aligned load per neighbor.
+	*/
+	template<typename Real, typename Coord, typename Coord4>
+	__global__ void VCF_ComputeCurl(
+		DeviceArray<Coord4> curlArr,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		NeighborList<int> neighbors,
+		Real smoothingLength)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		//Block-tiled gather: see K_ComputeDensity.
+		__shared__ Coord shPos[BLOCK_SIZE];
+		__shared__ Coord shVel[BLOCK_SIZE];
+		int blockStart = blockIdx.x * blockDim.x;
+		if (pId < posArr.size())
+		{
+			shPos[threadIdx.x] = posArr[pId];
+			shVel[threadIdx.x] = velArr[pId];
+		}
+		__syncthreads();
+
+		if (pId >= posArr.size()) return;
+
+		SpikyKernel<Real> kern;
+
+		Coord pos_i = shPos[threadIdx.x];
+		Coord vel_i = shVel[threadIdx.x];
+
+		Coord omega_i(0);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			bool local = (j >= blockStart && j < blockStart + BLOCK_SIZE);
+			Coord pos_j = local ? shPos[j - blockStart] : posArr[j];
+			Real r = (pos_i - pos_j).norm();
+
+			if (r > EPSILON)
+			{
+				Coord g = kern.Gradient(r, smoothingLength) * (pos_j - pos_i) * (1.0f / r);
+				Coord vel_j = local ? shVel[j - blockStart] : velArr[j];
+				omega_i += (vel_j - vel_i).cross(g);
+			}
+		}
+
+		curlArr[pId] = makeCoord4(omega_i, omega_i.norm());
+	}
+
+	/*!
+	*	\brief	Confinement force: N_i points up the gradient of the curl
+	*	magnitude, f_i = eps * (N_i x omega_i) re-energizes the swirl the
+	*	projection damped without adding net linear momentum.
+	*/
+	template<typename Real, typename Coord, typename Coord4>
+	__global__ void VCF_ApplyConfinement(
+		DeviceArray<Coord> velArr,
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord4> curlArr,
+		NeighborList<int> neighbors,
+		Real intensity,
+		Real smoothingLength,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+
+		//Block-tiled gather: see K_ComputeDensity.
+		__shared__ Coord shPos[BLOCK_SIZE];
+		int blockStart = blockIdx.x * blockDim.x;
+		if (pId < posArr.size())
+		{
+			shPos[threadIdx.x] = posArr[pId];
+		}
+		__syncthreads();
+
+		if (pId >= posArr.size()) return;
+
+		SpikyKernel<Real> kern;
+
+		Coord pos_i = shPos[threadIdx.x];
+
+		Coord eta_i(0);
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int ne = 0; ne < nbSize; ne++)
+		{
+			int j = neighbors.getElement(pId, ne);
+			Coord pos_j = (j >= blockStart && j < blockStart + BLOCK_SIZE) ? shPos[j - blockStart] : posArr[j];
+			Real r = (pos_i - pos_j).norm();
+
+			if (r > EPSILON)
+			{
+				//one 16-byte load covers the neighbor's curl magnitude
+				Coord4 c_j = curlArr[j];
+				Coord g = kern.Gradient(r, smoothingLength) * (pos_j - pos_i) * (1.0f / r);
+				eta_i += c_j.w * g;
+			}
+		}
+
+		Real etaNorm = eta_i.norm();
+		if (etaNorm > EPSILON)
+		{
+			Coord N_i = eta_i * (1.0f / etaNorm);
+			Coord omega_i = coordPoint(curlArr[pId]);
+			velArr[pId] += dt * intensity * N_i.cross(omega_i);
+		}
+	}
+
+	template<typename TDataType>
+	VorticityConfinement<TDataType>::VorticityConfinement()
+		: ConstraintModule()
+	{
+		m_intensity.setValue(Real(0.1));
+		m_smoothingLength.setValue(Real(0.011));
+
+		attachField(&m_intensity, "intensity", "The confinement strength!", false);
+		attachField(&m_smoothingLength, "smoothing_length", "The smoothing length in SPH!", false);
+		attachField(&m_position, "position", "Storing the particle positions!", false);
+		attachField(&m_velocity, "velocity", "Storing the particle velocities!", false);
+		attachField(&m_neighborhood, "neighborhood", "Storing neighboring particles' ids!", false);
+	}
+
+	template<typename TDataType>
+	VorticityConfinement<TDataType>::~VorticityConfinement()
+	{
+		m_curl.release();
+	}
+
+	template<typename TDataType>
+	bool VorticityConfinement<TDataType>::constrain()
+	{
+		int num = m_position.getElementCount();
+		if (num > 0)
+		{
+			cuint pDims = cudaGridSize(num, BLOCK_SIZE);
+
+			if (m_curl.size() != num)
+			{
+				m_curl.resize(num);
+			}
+
+			Real eps = m_intensity.getValue();
+			Real h = m_smoothingLength.getValue();
+			Real dt = getParent()->getDt();
+
+			VCF_ComputeCurl << <pDims, BLOCK_SIZE >> > (
+				m_curl,
+				m_position.getValue(),
+				m_velocity.getValue(),
+				m_neighborhood.getValue(),
+				h);
+
+			if (eps > EPSILON)
+			{
+				VCF_ApplyConfinement << <pDims, BLOCK_SIZE >> > (
+					m_velocity.getValue(),
+					m_position.getValue(),
+					m_curl,
+					m_neighborhood.getValue(),
+					eps,
+					h,
+					dt);
+			}
+		}
+
+		return true;
+	}
+
+	template<typename TDataType>
+	bool VorticityConfinement<TDataType>::initializeImpl()
+	{
+		return true;
+	}
+
+	template<typename TDataType>
+	void VorticityConfinement<TDataType>::setIntensity(Real eps)
+	{
+		m_intensity.setValue(eps);
+	}
+
+#ifdef PRECISION_FLOAT
+	template class VorticityConfinement<DataType3f>;
+#else
+	template class VorticityConfinement<DataType3d>;
+#endif
+}
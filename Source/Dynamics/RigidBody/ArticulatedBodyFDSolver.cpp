@@ -104,6 +104,7 @@ namespace PhysIKA
 	{
 		RigidBodyRoot<DataType3f>* root = static_cast<RigidBodyRoot<DataType3f>*>(s.m_root);
 		const std::vector<int>& idx_map = root->getJointIdxMap();
+		JointExecutionPlan* plan = root->getJointPlan() && root->getJointPlan()->isValid() ? root->getJointPlan().get() : NULL;
 
 		auto all_bodies = root->getAllParentidNodePair();
 		int n_rigid = all_bodies.size();
@@ -161,7 +162,7 @@ namespace PhysIKA
 			int parent_id = all_bodies[i].first;
 			int cur_id = cur_node->getId();
 
-			int cur_dof = parent_joint->getJointDOF();
+			int cur_dof = plan ? plan->getDof(cur_id) : parent_joint->getJointDOF();
 			//SpatialVector<float> U[6];
 			SpatialVector<float>* U = (this->m_U[cur_id]).getBases();
 
@@ -169,12 +170,14 @@ namespace PhysIKA
 			//if (!m_isValid)
 			if (cur_dof > 0)
 			{
-				RigidUtil::IxS(m_IA[cur_id], parent_joint->getJointSpace(), U);
-				RigidUtil::setStxS(parent_joint->getJointSpace().getBases(), cur_dof, U, cur_dof, D, 0, 0);
+				const SpatialVector<float>* S = plan ? plan->getBases(cur_id) : parent_joint->getJointSpace().getBases();
+
+				RigidUtil::IxS(m_IA[cur_id], S, cur_dof, U);
+				RigidUtil::setStxS(S, cur_dof, U, cur_dof, D, 0, 0);
 
 				/// ui
 				/// at presetn, taw is not taken into consideration
-				RigidUtil::setStxS(parent_joint->getJointSpace().getBases(), cur_dof, -m_pA[cur_id], m_ui, idx_map[cur_id]);
+				RigidUtil::setStxS(S, cur_dof, -m_pA[cur_id], m_ui, idx_map[cur_id]);
 
 				this->m_D_inv[cur_id] = RigidUtil::inverse(D, cur_dof);
 			}
@@ -210,7 +213,7 @@ namespace PhysIKA
 			Joint* parent_joint = cur_node->getParentJoint();
 			int parent_id = all_bodies[i].first;
 			int cur_id = cur_node->getId();
-			int cur_dof = parent_joint->getJointDOF();
+			int cur_dof = plan ? plan->getDof(cur_id) : parent_joint->getJointDOF();
 			int start_idx = idx_map[cur_id];
 
 			
@@ -242,7 +245,7 @@ namespace PhysIKA
 					a_,
 					&(ddq[start_idx]));
 
-				m_a[cur_id] = a_p + parent_joint->getJointSpace().mul(&(ddq[start_idx]));
+				m_a[cur_id] = a_p + (plan ? plan->mul(cur_id, &(ddq[start_idx])) : parent_joint->getJointSpace().mul(&(ddq[start_idx])));
 			}
 			else
 			{
@@ -0,0 +1,631 @@
+#include "BatchedFDSolver.h"
+
+#include "RigidBodyRoot.h"
+#include "SpatialVector.h"
+#include "Transform3d.h"
+#include "Core/Utility/cuda_utilities.h"
+
+namespace PhysIKA
+{
+	/**
+	* The device helpers below mirror the host-side Transform3d math exactly, but work
+	* on the flattened (row major rotation, translation) representation the gather
+	* step uploads; Transform3d itself is host-only.
+	*/
+
+	__device__ void D_Rotate(const float* R, SpatialVector<float>& v)
+	{
+		float tx, ty, tz;
+		tx = R[0] * v[0] + R[1] * v[1] + R[2] * v[2];
+		ty = R[3] * v[0] + R[4] * v[1] + R[5] * v[2];
+		tz = R[6] * v[0] + R[7] * v[1] + R[8] * v[2];
+		v[0] = tx; v[1] = ty; v[2] = tz;
+
+		tx = R[0] * v[3] + R[1] * v[4] + R[2] * v[5];
+		ty = R[3] * v[3] + R[4] * v[4] + R[5] * v[5];
+		tz = R[6] * v[3] + R[7] * v[4] + R[8] * v[5];
+		v[3] = tx; v[4] = ty; v[5] = tz;
+	}
+
+	/// Motion transform: new_w = w; new_v = v - r x w; rotate both parts.
+	__device__ const SpatialVector<float> D_TransformM(const float* R, const float* r, const SpatialVector<float>& m)
+	{
+		SpatialVector<float> res = m;
+		res[3] -= r[1] * m[2] - r[2] * m[1];
+		res[4] -= r[2] * m[0] - r[0] * m[2];
+		res[5] -= r[0] * m[1] - r[1] * m[0];
+		D_Rotate(R, res);
+		return res;
+	}
+
+	/// Force transform: new_torque = torque - r x f; new_f = f; rotate both parts.
+	__device__ const SpatialVector<float> D_TransformF(const float* R, const float* r, const SpatialVector<float>& f)
+	{
+		SpatialVector<float> res = f;
+		res[0] -= r[1] * f[5] - r[2] * f[4];
+		res[1] -= r[2] * f[3] - r[0] * f[5];
+		res[2] -= r[0] * f[4] - r[1] * f[3];
+		D_Rotate(R, res);
+		return res;
+	}
+
+	/// Inertia transform I_2 = X_12f * I_1 * X_21m, column-wise then row-wise D_TransformF.
+	__device__ void D_TransformI(const float* R, const float* r, const float* I, float* res)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			SpatialVector<float> tmpv(I[0 * 6 + i], I[1 * 6 + i], I[2 * 6 + i], I[3 * 6 + i], I[4 * 6 + i], I[5 * 6 + i]);
+			SpatialVector<float> tmpres = D_TransformF(R, r, tmpv);
+			for (int k = 0; k < 6; ++k)
+			{
+				res[k * 6 + i] = tmpres[k];
+			}
+		}
+
+		for (int i = 0; i < 6; ++i)
+		{
+			SpatialVector<float> tmpv(res[i * 6 + 0], res[i * 6 + 1], res[i * 6 + 2], res[i * 6 + 3], res[i * 6 + 4], res[i * 6 + 5]);
+			SpatialVector<float> tmpres = D_TransformF(R, r, tmpv);
+			for (int k = 0; k < 6; ++k)
+			{
+				res[i * 6 + k] = tmpres[k];
+			}
+		}
+	}
+
+	__device__ const SpatialVector<float> D_Ixs(const float* m, const SpatialVector<float>& v)
+	{
+		SpatialVector<float> res;
+		for (int i = 0; i < 6; ++i)
+		{
+			res[i] = 0;
+			for (int j = 0; j < 6; ++j)
+			{
+				res[i] += m[i * 6 + j] * v[j];
+			}
+		}
+		return res;
+	}
+
+	__device__ void D_LoadSV(const float* buf, SpatialVector<float>& v)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			v[i] = buf[i];
+		}
+	}
+
+	__device__ void D_StoreSV(float* buf, const SpatialVector<float>& v)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			buf[i] = v[i];
+		}
+	}
+
+	/// Gauss-Jordan inverse of the leading dof x dof block, as RigidUtil::inverse does on the host.
+	__device__ void D_InverseD(float* D, int dof, float* res)
+	{
+		for (int i = 0; i < dof; ++i)
+		{
+			for (int j = 0; j < dof; ++j)
+			{
+				res[i * dof + j] = (i == j) ? 1.0f : 0.0f;
+			}
+		}
+
+		for (int i = 0; i < dof; ++i)
+		{
+			float pivot = D[i * dof + i];
+			for (int j = 0; j < dof; ++j)
+			{
+				D[i * dof + j] /= pivot;
+				res[i * dof + j] /= pivot;
+			}
+
+			for (int k = 0; k < dof; ++k)
+			{
+				if (k == i) continue;
+				float factor = D[k * dof + i];
+				for (int j = 0; j < dof; ++j)
+				{
+					D[k * dof + j] -= factor * D[i * dof + j];
+					res[k * dof + j] -= factor * res[i * dof + j];
+				}
+			}
+		}
+	}
+
+	/**
+	* One thread per articulated system. The three loops below are the forward velocity
+	* pass, the backward articulated inertia pass and the forward acceleration pass of
+	* ArticulatedBodyFDSolver::solve, with the body slots of the system laid out
+	* contiguously and visited in the gathered parent-before-child order.
+	*/
+	__global__ void K_BatchedABA(
+		int sysNum,
+		int* sysBodyBegin,
+		int* sysBodyNum,
+		float* gravity,
+		int* topo,
+		int* parent,
+		int* dofArr,
+		int* dofIdx,
+		float* Xarr,
+		float* R0arr,
+		float* vRel,
+		float* fExt,
+		float* inertia,
+		float* Sarr,
+		float* IAbuf,
+		float* pAbuf,
+		float* viBuf,
+		float* ciBuf,
+		float* aBuf,
+		float* Ubuf,
+		float* Dinvbuf,
+		float* uiBuf,
+		float* ddqBuf)
+	{
+		int sysId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (sysId >= sysNum) return;
+
+		int b0 = sysBodyBegin[sysId];
+		int nb = sysBodyNum[sysId];
+
+		// Pass 1: velocities, bias forces and articulated inertia initialization.
+		for (int k = 0; k < nb; ++k)
+		{
+			int j = topo[b0 + k];
+			int p = parent[j];
+
+			SpatialVector<float> vr;
+			D_LoadSV(vRel + 6 * j, vr);
+
+			SpatialVector<float> v;
+			if (p >= 0)
+			{
+				SpatialVector<float> vp;
+				D_LoadSV(viBuf + 6 * p, vp);
+				v = D_TransformM(Xarr + 12 * j, Xarr + 12 * j + 9, vp) + vr;
+			}
+			else
+			{
+				v = vr;
+			}
+			D_StoreSV(viBuf + 6 * j, v);
+
+			SpatialVector<float> c = v.crossM(vr);
+			D_StoreSV(ciBuf + 6 * j, c);
+
+			for (int e = 0; e < 36; ++e)
+			{
+				IAbuf[36 * j + e] = inertia[36 * j + e];
+			}
+
+			SpatialVector<float> fe;
+			D_LoadSV(fExt + 6 * j, fe);
+			D_Rotate(R0arr + 9 * j, fe);
+
+			SpatialVector<float> pA = v.crossF(D_Ixs(inertia + 36 * j, v)) - fe;
+			D_StoreSV(pAbuf + 6 * j, pA);
+		}
+
+		// Pass 2: backward articulated inertia accumulation.
+		for (int k = nb - 1; k >= 0; --k)
+		{
+			int j = topo[b0 + k];
+			int p = parent[j];
+			int dof = dofArr[j];
+
+			float* U = Ubuf + 36 * j;
+			float* D_inv = Dinvbuf + 36 * j;
+			const float* S = Sarr + 36 * j;
+
+			SpatialVector<float> pA;
+			D_LoadSV(pAbuf + 6 * j, pA);
+
+			if (dof > 0)
+			{
+				// U_i = IA * S_i;  D = S^T * U;  ui = S^T * (-pA)
+				for (int c = 0; c < dof; ++c)
+				{
+					SpatialVector<float> sc(S[6 * c + 0], S[6 * c + 1], S[6 * c + 2], S[6 * c + 3], S[6 * c + 4], S[6 * c + 5]);
+					SpatialVector<float> uc = D_Ixs(IAbuf + 36 * j, sc);
+					for (int e = 0; e < 6; ++e)
+					{
+						U[6 * c + e] = uc[e];
+					}
+				}
+
+				float D[36];
+				for (int a = 0; a < dof; ++a)
+				{
+					for (int b = 0; b < dof; ++b)
+					{
+						float s = 0;
+						for (int e = 0; e < 6; ++e)
+						{
+							s += S[6 * a + e] * U[6 * b + e];
+						}
+						D[a * dof + b] = s;
+					}
+
+					float s = 0;
+					for (int e = 0; e < 6; ++e)
+					{
+						s += S[6 * a + e] * (-pA[e]);
+					}
+					uiBuf[dofIdx[j] + a] = s;
+				}
+
+				D_InverseD(D, dof, D_inv);
+			}
+
+			if (p >= 0)
+			{
+				float Ia[36];
+				SpatialVector<float> pa;
+
+				if (dof > 0)
+				{
+					// Ia = IA - U * D_inv * U^T
+					float UD[36];
+					for (int e = 0; e < 6; ++e)
+					{
+						for (int b = 0; b < dof; ++b)
+						{
+							float s = 0;
+							for (int c = 0; c < dof; ++c)
+							{
+								s += U[6 * c + e] * D_inv[c * dof + b];
+							}
+							UD[e * dof + b] = s;
+						}
+					}
+
+					for (int e = 0; e < 6; ++e)
+					{
+						for (int f = 0; f < 6; ++f)
+						{
+							float s = 0;
+							for (int c = 0; c < dof; ++c)
+							{
+								s += UD[e * dof + c] * U[6 * c + f];
+							}
+							Ia[e * 6 + f] = IAbuf[36 * j + e * 6 + f] - s;
+						}
+					}
+
+					// pa = pA + U * D_inv * ui + Ia * ci
+					pa = pA;
+					for (int e = 0; e < 6; ++e)
+					{
+						for (int c = 0; c < dof; ++c)
+						{
+							pa[e] += UD[e * dof + c] * uiBuf[dofIdx[j] + c];
+						}
+					}
+
+					SpatialVector<float> ci;
+					D_LoadSV(ciBuf + 6 * j, ci);
+					pa += D_Ixs(Ia, ci);
+				}
+				else
+				{
+					for (int e = 0; e < 36; ++e)
+					{
+						Ia[e] = IAbuf[36 * j + e];
+					}
+					pa = pA;
+				}
+
+				// Accumulate onto the parent through the inverse transform:
+				// R' = R^T, r' = -(R * r).
+				const float* R = Xarr + 12 * j;
+				const float* r = Xarr + 12 * j + 9;
+				float Rinv[9], rinv[3];
+				for (int e = 0; e < 3; ++e)
+				{
+					for (int f = 0; f < 3; ++f)
+					{
+						Rinv[e * 3 + f] = R[f * 3 + e];
+					}
+					rinv[e] = -(R[e * 3 + 0] * r[0] + R[e * 3 + 1] * r[1] + R[e * 3 + 2] * r[2]);
+				}
+
+				float Iacc[36];
+				D_TransformI(Rinv, rinv, Ia, Iacc);
+				for (int e = 0; e < 36; ++e)
+				{
+					IAbuf[36 * p + e] += Iacc[e];
+				}
+
+				SpatialVector<float> pacc = D_TransformF(Rinv, rinv, pa);
+				for (int e = 0; e < 6; ++e)
+				{
+					pAbuf[6 * p + e] += pacc[e];
+				}
+			}
+		}
+
+		// Pass 3: forward accelerations and joint-space results.
+		for (int k = 0; k < nb; ++k)
+		{
+			int j = topo[b0 + k];
+			int p = parent[j];
+			int dof = dofArr[j];
+			int di = dofIdx[j];
+
+			SpatialVector<float> ci;
+			D_LoadSV(ciBuf + 6 * j, ci);
+
+			SpatialVector<float> a_p;
+			if (p < 0)
+			{
+				SpatialVector<float> g(0, 0, 0, -gravity[3 * sysId + 0], -gravity[3 * sysId + 1], -gravity[3 * sysId + 2]);
+				D_Rotate(R0arr + 9 * j, g);
+				a_p = g + ci;
+			}
+			else
+			{
+				SpatialVector<float> ap;
+				D_LoadSV(aBuf + 6 * p, ap);
+				a_p = D_TransformM(Xarr + 12 * j, Xarr + 12 * j + 9, ap) + ci;
+			}
+
+			if (dof > 0)
+			{
+				const float* S = Sarr + 36 * j;
+				const float* D_inv = Dinvbuf + 36 * j;
+
+				float a_[6];
+				for (int c = 0; c < dof; ++c)
+				{
+					float s = 0;
+					for (int e = 0; e < 6; ++e)
+					{
+						s += S[6 * c + e] * a_p[e];
+					}
+					a_[c] = uiBuf[di + c] - s;
+				}
+
+				SpatialVector<float> a = a_p;
+				for (int c = 0; c < dof; ++c)
+				{
+					float s = 0;
+					for (int e = 0; e < dof; ++e)
+					{
+						s += D_inv[c * dof + e] * a_[e];
+					}
+					ddqBuf[di + c] = s;
+
+					for (int e = 0; e < 6; ++e)
+					{
+						a[e] += S[6 * c + e] * s;
+					}
+				}
+				D_StoreSV(aBuf + 6 * j, a);
+			}
+			else
+			{
+				D_StoreSV(aBuf + 6 * j, a_p);
+			}
+		}
+	}
+
+	void BatchedFDSolver::clearSystems()
+	{
+		m_sys_body_begin.clear();
+		m_sys_body_num.clear();
+		m_sys_dof_begin.clear();
+		m_sys_dof_num.clear();
+		m_gravity.clear();
+
+		m_topo.clear();
+		m_parent.clear();
+		m_dof.clear();
+		m_dof_idx.clear();
+		m_X.clear();
+		m_R0.clear();
+		m_v_rel.clear();
+		m_fext.clear();
+		m_inertia.clear();
+		m_S.clear();
+	}
+
+	bool BatchedFDSolver::addSystem(const SystemState& s_system, const SystemMotionState& s)
+	{
+		RigidBodyRoot<DataType3f>* root = static_cast<RigidBodyRoot<DataType3f>*>(s.m_root);
+		if (!root)
+		{
+			return false;
+		}
+
+		const std::vector<int>& idx_map = root->getJointIdxMap();
+		auto& all_bodies = root->getAllParentidNodePair();
+		int n_rigid = all_bodies.size();
+		int n_dof = root->getJointDof();
+
+		int b0 = (int)m_parent.size();
+		int d0 = m_sys_dof_begin.empty() ? 0 : m_sys_dof_begin.back() + m_sys_dof_num.back();
+
+		m_sys_body_begin.push_back(b0);
+		m_sys_body_num.push_back(n_rigid);
+		m_sys_dof_begin.push_back(d0);
+		m_sys_dof_num.push_back(n_dof);
+
+		Vector3f g = root->getGravity();
+		m_gravity.push_back(g[0]);
+		m_gravity.push_back(g[1]);
+		m_gravity.push_back(g[2]);
+
+		m_parent.resize(b0 + n_rigid, -1);
+		m_dof.resize(b0 + n_rigid, 0);
+		m_dof_idx.resize(b0 + n_rigid, 0);
+		m_X.resize(12 * (b0 + n_rigid), 0);
+		m_R0.resize(9 * (b0 + n_rigid), 0);
+		m_v_rel.resize(6 * (b0 + n_rigid), 0);
+		m_fext.resize(6 * (b0 + n_rigid), 0);
+		m_inertia.resize(36 * (b0 + n_rigid), 0);
+		m_S.resize(36 * (b0 + n_rigid), 0);
+
+		MatrixMN<float> tensor;
+		for (int i = 0; i < n_rigid; ++i)
+		{
+			RigidBody2_ptr cur_node = all_bodies[i].second;
+			Joint* parent_joint = cur_node->getParentJoint();
+			int parent_id = all_bodies[i].first;
+			int cur_id = cur_node->getId();
+			int slot = b0 + cur_id;
+
+			m_topo.push_back(slot);
+			m_parent[slot] = parent_id >= 0 ? b0 + parent_id : -1;
+
+			int cur_dof = parent_joint->getJointDOF();
+			m_dof[slot] = cur_dof;
+			m_dof_idx[slot] = d0 + idx_map[cur_id];
+
+			const Matrix3f& R = s.m_X[cur_id].getRotationMatrix();
+			const Vector3f& t = s.m_X[cur_id].getTranslation();
+			for (int e = 0; e < 3; ++e)
+			{
+				for (int f = 0; f < 3; ++f)
+				{
+					m_X[12 * slot + 3 * e + f] = R(e, f);
+				}
+				m_X[12 * slot + 9 + e] = t[e];
+			}
+
+			Matrix3f R0 = s.m_global_q[cur_id].getConjugate().get3x3Matrix();
+			for (int e = 0; e < 3; ++e)
+			{
+				for (int f = 0; f < 3; ++f)
+				{
+					m_R0[9 * slot + 3 * e + f] = R0(e, f);
+				}
+			}
+
+			for (int e = 0; e < 6; ++e)
+			{
+				m_v_rel[6 * slot + e] = s.m_v[cur_id][e];
+				m_fext[6 * slot + e] = s_system.m_externalForce[cur_id][e];
+			}
+
+			cur_node->getI().getTensor(tensor);
+			for (int e = 0; e < 6; ++e)
+			{
+				for (int f = 0; f < 6; ++f)
+				{
+					m_inertia[36 * slot + 6 * e + f] = tensor(e, f);
+				}
+			}
+
+			if (cur_dof > 0)
+			{
+				const SpatialVector<float>* bases = parent_joint->getJointSpace().getBases();
+				for (int c = 0; c < cur_dof; ++c)
+				{
+					for (int e = 0; e < 6; ++e)
+					{
+						m_S[36 * slot + 6 * c + e] = bases[c][e];
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool BatchedFDSolver::solveAll(std::vector<Vectornd<float>>& ddq)
+	{
+		int sys_num = (int)m_sys_body_begin.size();
+		if (sys_num == 0)
+		{
+			return false;
+		}
+
+		int total_body = (int)m_parent.size();
+		int total_dof = m_sys_dof_begin.back() + m_sys_dof_num.back();
+
+		m_d_sys_body_begin.resize(sys_num);
+		m_d_sys_body_num.resize(sys_num);
+		m_d_gravity.resize(3 * sys_num);
+		m_d_topo.resize(total_body);
+		m_d_parent.resize(total_body);
+		m_d_dof.resize(total_body);
+		m_d_dof_idx.resize(total_body);
+		m_d_X.resize(12 * total_body);
+		m_d_R0.resize(9 * total_body);
+		m_d_v_rel.resize(6 * total_body);
+		m_d_fext.resize(6 * total_body);
+		m_d_inertia.resize(36 * total_body);
+		m_d_S.resize(36 * total_body);
+
+		m_d_IA.resize(36 * total_body);
+		m_d_pA.resize(6 * total_body);
+		m_d_vi.resize(6 * total_body);
+		m_d_ci.resize(6 * total_body);
+		m_d_a.resize(6 * total_body);
+		m_d_U.resize(36 * total_body);
+		m_d_D_inv.resize(36 * total_body);
+		m_d_ui.resize(total_dof > 0 ? total_dof : 1);
+		m_d_ddq.resize(total_dof > 0 ? total_dof : 1);
+
+		cuSafeCall(cudaMemcpy(m_d_sys_body_begin.getDataPtr(), m_sys_body_begin.data(), sys_num * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_sys_body_num.getDataPtr(), m_sys_body_num.data(), sys_num * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_gravity.getDataPtr(), m_gravity.data(), 3 * sys_num * sizeof(float), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_topo.getDataPtr(), m_topo.data(), total_body * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_parent.getDataPtr(), m_parent.data(), total_body * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_dof.getDataPtr(), m_dof.data(), total_body * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_dof_idx.getDataPtr(), m_dof_idx.data(), total_body * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_X.getDataPtr(), m_X.data(), 12 * total_body * sizeof(float), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_R0.getDataPtr(), m_R0.data(), 9 * total_body * sizeof(float), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_v_rel.getDataPtr(), m_v_rel.data(), 6 * total_body * sizeof(float), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_fext.getDataPtr(), m_fext.data(), 6 * total_body * sizeof(float), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_inertia.getDataPtr(), m_inertia.data(), 36 * total_body * sizeof(float), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_d_S.getDataPtr(), m_S.data(), 36 * total_body * sizeof(float), cudaMemcpyHostToDevice));
+
+		uint pDims = cudaGridSize(sys_num, BLOCK_SIZE);
+		K_BatchedABA << <pDims, BLOCK_SIZE >> > (
+			sys_num,
+			m_d_sys_body_begin.getDataPtr(),
+			m_d_sys_body_num.getDataPtr(),
+			m_d_gravity.getDataPtr(),
+			m_d_topo.getDataPtr(),
+			m_d_parent.getDataPtr(),
+			m_d_dof.getDataPtr(),
+			m_d_dof_idx.getDataPtr(),
+			m_d_X.getDataPtr(),
+			m_d_R0.getDataPtr(),
+			m_d_v_rel.getDataPtr(),
+			m_d_fext.getDataPtr(),
+			m_d_inertia.getDataPtr(),
+			m_d_S.getDataPtr(),
+			m_d_IA.getDataPtr(),
+			m_d_pA.getDataPtr(),
+			m_d_vi.getDataPtr(),
+			m_d_ci.getDataPtr(),
+			m_d_a.getDataPtr(),
+			m_d_U.getDataPtr(),
+			m_d_D_inv.getDataPtr(),
+			m_d_ui.getDataPtr(),
+			m_d_ddq.getDataPtr());
+		cuSynchronize();
+
+		std::vector<float> host_ddq(total_dof > 0 ? total_dof : 1);
+		cuSafeCall(cudaMemcpy(host_ddq.data(), m_d_ddq.getDataPtr(), host_ddq.size() * sizeof(float), cudaMemcpyDeviceToHost));
+
+		ddq.resize(sys_num);
+		for (int i = 0; i < sys_num; ++i)
+		{
+			ddq[i].resize(m_sys_dof_num[i]);
+			for (int k = 0; k < m_sys_dof_num[i]; ++k)
+			{
+				ddq[i][k] = host_ddq[m_sys_dof_begin[i] + k];
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include "Core/Array/Array.h"
+#include "Core/Vector/vector_nd.h"
+#include "SystemState.h"
+#include "SystemMotionState.h"
+
+namespace PhysIKA
+{
+	/**
+	* @brief Batched articulated-body forward dynamics on the GPU.
+	* @details Runs the same three-pass recursion as ArticulatedBodyFDSolver, but over many
+	*          independent articulated systems at once. Each system is handled by one CUDA
+	*          thread, so scenes with hundreds of short chains saturate the device instead
+	*          of walking each chain serially on the host with per-body heap matrices.
+	*          Motion state, joint spaces and inertia tensors are flattened into
+	*          structure-of-array device buffers before the launch; results come back as
+	*          one acceleration vector per system, in the order the systems were gathered.
+	*/
+	class BatchedFDSolver
+	{
+	public:
+		BatchedFDSolver() {}
+		~BatchedFDSolver() {}
+
+		/// Remove all gathered systems.
+		void clearSystems();
+
+		/**
+		* @brief Gather one system into the batch.
+		* @param s_system Current system state. The force state will be used.
+		* @param s Current system motion state. Position and velocity information will be used.
+		* @return Success or not.
+		*/
+		bool addSystem(const SystemState& s_system, const SystemMotionState& s);
+
+		/**
+		* @brief Solve forward dynamics of all gathered systems in one kernel launch.
+		* @param ddq One joint acceleration vector per system, in addSystem() order.
+		* @return Success or not.
+		*/
+		bool solveAll(std::vector<Vectornd<float>>& ddq);
+
+		int getSystemNumber() const { return (int)(m_sys_body_begin.size()); }
+
+	private:
+		/// Per system information.
+		std::vector<int> m_sys_body_begin;		// first body slot of the system
+		std::vector<int> m_sys_body_num;
+		std::vector<int> m_sys_dof_begin;		// first entry of the system in the ddq vector
+		std::vector<int> m_sys_dof_num;
+		std::vector<float> m_gravity;			// 3 floats per system
+
+		/// Per body information, flattened over all systems. Slot = body begin + node id.
+		std::vector<int> m_topo;				// body slots in parent-before-child order
+		std::vector<int> m_parent;				// parent body slot, -1 for a root
+		std::vector<int> m_dof;					// dof of the parent joint
+		std::vector<int> m_dof_idx;				// first ddq entry of the parent joint
+		std::vector<float> m_X;					// 12 floats: parent->child rotation (row major) + translation
+		std::vector<float> m_R0;				// 9 floats: conjugate global rotation
+		std::vector<float> m_v_rel;				// 6 floats: relative spatial velocity
+		std::vector<float> m_fext;				// 6 floats: external spatial force
+		std::vector<float> m_inertia;			// 36 floats: spatial inertia tensor
+		std::vector<float> m_S;					// 36 floats: joint space bases, base i in column i
+
+		/// Device mirrors of the gathered state.
+		DeviceArray<int> m_d_sys_body_begin;
+		DeviceArray<int> m_d_sys_body_num;
+		DeviceArray<float> m_d_gravity;
+		DeviceArray<int> m_d_topo;
+		DeviceArray<int> m_d_parent;
+		DeviceArray<int> m_d_dof;
+		DeviceArray<int> m_d_dof_idx;
+		DeviceArray<float> m_d_X;
+		DeviceArray<float> m_d_R0;
+		DeviceArray<float> m_d_v_rel;
+		DeviceArray<float> m_d_fext;
+		DeviceArray<float> m_d_inertia;
+		DeviceArray<float> m_d_S;
+
+		/// Device scratch of the recursion, reused between solves.
+		DeviceArray<float> m_d_IA;				// 36 floats per body
+		DeviceArray<float> m_d_pA;				// 6 floats per body
+		DeviceArray<float> m_d_vi;
+		DeviceArray<float> m_d_ci;
+		DeviceArray<float> m_d_a;
+		DeviceArray<float> m_d_U;				// 36 floats per body
+		DeviceArray<float> m_d_D_inv;			// 36 floats per body
+		DeviceArray<float> m_d_ui;				// one float per dof
+		DeviceArray<float> m_d_ddq;
+	};
+}
@@ -0,0 +1,209 @@
+#include <cuda_runtime.h>
+#include "BatchedStateUpdate.h"
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	//Quaternion's method bodies live in a host translation unit, so the
+	//kernels work on the raw float4 layout (x, y, z, w) instead.
+
+	GPU_FUNC inline float4 BSU_Mul(const float4 a, const float4 b)
+	{
+		return make_float4(
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z,
+			a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+	}
+
+	GPU_FUNC inline float3 BSU_Rotate(const float4 q, const float3 v)
+	{
+		//v + 2 w (u x v) + 2 u x (u x v)
+		float3 u = make_float3(q.x, q.y, q.z);
+		float3 c1 = cross(u, v);
+		float3 c2 = cross(u, c1);
+		return v + 2.0f * (q.w * c1 + c2);
+	}
+
+	GPU_FUNC inline float4 BSU_Normalize(const float4 q)
+	{
+		float n2 = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+		if (n2 < EPSILON)
+		{
+			return make_float4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+		float inv = rsqrtf(n2);
+		return make_float4(q.x * inv, q.y * inv, q.z * inv, q.w * inv);
+	}
+
+	__global__ void BSU_Integrate(
+		float4* q,
+		float4* dq,
+		float dt,
+		int num)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		float4 qi = q[pId];
+		float4 di = dq[pId];
+		qi.x += di.x * dt;
+		qi.y += di.y * dt;
+		qi.z += di.z * dt;
+		qi.w += di.w * dt;
+
+		q[pId] = BSU_Normalize(qi);
+	}
+
+	__global__ void BSU_ComposeLevel(
+		float3* globalR,
+		float4* globalQ,
+		float3* relR,
+		float4* relQ,
+		int* parent,
+		int* order,
+		int begin,
+		int count)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= count) return;
+
+		int i = order[begin + tId];
+		int p = parent[i];
+
+		if (p >= 0)
+		{
+			//the parent pose is final: it belongs to an earlier level
+			globalR[i] = globalR[p] + BSU_Rotate(globalQ[p], relR[i]);
+			globalQ[i] = BSU_Normalize(BSU_Mul(globalQ[p], relQ[i]));
+		}
+		else
+		{
+			globalR[i] = relR[i];
+			globalQ[i] = BSU_Normalize(relQ[i]);
+		}
+	}
+
+	BatchedStateUpdate& BatchedStateUpdate::getInstance()
+	{
+		static BatchedStateUpdate instance;
+		return instance;
+	}
+
+	void BatchedStateUpdate::integrate(std::vector<Quaternion<float>>& q, const std::vector<Quaternion<float>>& dq, float dt)
+	{
+		int num = (int)q.size();
+		if (num == 0) return;
+
+		if (m_relQ.size() < num)
+		{
+			m_relQ.resize(num);
+			m_globalQ.resize(num);
+		}
+
+		cuSafeCall(cudaMemcpy(m_relQ.getDataPtr(), q.data(), num * sizeof(float4), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_globalQ.getDataPtr(), dq.data(), num * sizeof(float4), cudaMemcpyHostToDevice));
+
+		uint pDims = cudaGridSize(num, BLOCK_SIZE);
+		BSU_Integrate << <pDims, BLOCK_SIZE >> > (
+			m_relQ.getDataPtr(),
+			m_globalQ.getDataPtr(),
+			dt,
+			num);
+
+		cuSafeCall(cudaMemcpy(q.data(), m_relQ.getDataPtr(), num * sizeof(float4), cudaMemcpyDeviceToHost));
+	}
+
+	void BatchedStateUpdate::rebuildSchedule(const std::vector<int>& parent)
+	{
+		int num = (int)parent.size();
+
+		//body ids carry no ordering guarantee, so walk the ancestor chain
+		std::vector<int> depth(num, 0);
+		int maxDepth = 0;
+		for (int i = 0; i < num; i++)
+		{
+			int d = 0;
+			for (int p = parent[i]; p >= 0; p = parent[p])
+			{
+				d++;
+			}
+			depth[i] = d;
+			maxDepth = d > maxDepth ? d : maxDepth;
+		}
+
+		std::vector<int> levelNum(maxDepth + 1, 0);
+		for (int i = 0; i < num; i++)
+		{
+			levelNum[depth[i]]++;
+		}
+
+		m_levelBegin.assign(maxDepth + 2, 0);
+		for (int l = 0; l <= maxDepth; l++)
+		{
+			m_levelBegin[l + 1] = m_levelBegin[l] + levelNum[l];
+		}
+
+		m_orderHost.resize(num);
+		std::vector<int> cursor(m_levelBegin.begin(), m_levelBegin.end() - 1);
+		for (int i = 0; i < num; i++)
+		{
+			m_orderHost[cursor[depth[i]]++] = i;
+		}
+
+		m_order.resize(num);
+		m_parent.resize(num);
+		cuSafeCall(cudaMemcpy(m_order.getDataPtr(), m_orderHost.data(), num * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_parent.getDataPtr(), parent.data(), num * sizeof(int), cudaMemcpyHostToDevice));
+
+		m_parentCache = parent;
+	}
+
+	void BatchedStateUpdate::updateGlobalInfo(std::vector<Vector3f>& global_r,
+		std::vector<Quaternion<float>>& global_q,
+		const std::vector<Vector3f>& rel_r,
+		const std::vector<Quaternion<float>>& rel_q,
+		const std::vector<int>& parent)
+	{
+		int num = (int)parent.size();
+		if (num == 0) return;
+
+		if (parent != m_parentCache)
+		{
+			rebuildSchedule(parent);
+		}
+
+		if (m_relR.size() < num)
+		{
+			m_relR.resize(num);
+			m_globalR.resize(num);
+			m_relQ.resize(num);
+			m_globalQ.resize(num);
+		}
+
+		cuSafeCall(cudaMemcpy(m_relR.getDataPtr(), rel_r.data(), num * sizeof(float3), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_relQ.getDataPtr(), rel_q.data(), num * sizeof(float4), cudaMemcpyHostToDevice));
+
+		int levelCount = (int)m_levelBegin.size() - 1;
+		for (int l = 0; l < levelCount; l++)
+		{
+			int begin = m_levelBegin[l];
+			int count = m_levelBegin[l + 1] - begin;
+
+			uint pDims = cudaGridSize(count, BLOCK_SIZE);
+			BSU_ComposeLevel << <pDims, BLOCK_SIZE >> > (
+				m_globalR.getDataPtr(),
+				m_globalQ.getDataPtr(),
+				m_relR.getDataPtr(),
+				m_relQ.getDataPtr(),
+				m_parent.getDataPtr(),
+				m_order.getDataPtr(),
+				begin,
+				count);
+		}
+		cuSynchronize();
+
+		cuSafeCall(cudaMemcpy(global_r.data(), m_globalR.getDataPtr(), num * sizeof(float3), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(global_q.data(), m_globalQ.getDataPtr(), num * sizeof(float4), cudaMemcpyDeviceToHost));
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <vector_types.h>
+#include "Core/Array/Array.h"
+#include "Core/Vector.h"
+#include "Core/Quaternion/quaternion.h"
+
+namespace PhysIKA
+{
+	/**
+	* @brief Batched quaternion and pose updates for the rigid pipeline.
+	* @details SystemMotionState walks every body on the host to integrate and
+	*          compose orientations, which serializes scenes with many bodies.
+	*          This helper flattens the state into structure-of-array device
+	*          buffers - the same layout discipline as BatchedFDSolver - and
+	*          replaces the host loops with batch kernels: one launch for
+	*          integrate-plus-normalize, and one launch per tree depth level
+	*          for the global pose composition, where the level schedule
+	*          guarantees every parent pose is final before a child reads it.
+	*          The schedule is cached and only rebuilt when the parent array
+	*          changes. Below MIN_BATCH bodies the host loop wins; callers
+	*          keep it as their small-scene path.
+	*/
+	class BatchedStateUpdate
+	{
+	public:
+		/// body count under which the upload outweighs the parallelism
+		static const int MIN_BATCH = 256;
+
+		static BatchedStateUpdate& getInstance();
+
+		/**
+		* @brief q[i] = normalize(q[i] + dq[i] * dt) for the whole batch in one launch.
+		*/
+		void integrate(std::vector<Quaternion<float>>& q, const std::vector<Quaternion<float>>& dq, float dt);
+
+		/**
+		* @brief Compose global poses from relative poses along the parent array.
+		* @param parent Parent body index per body, -1 for a root. Global
+		*        orientations are normalized on the way out.
+		*/
+		void updateGlobalInfo(std::vector<Vector3f>& global_r,
+			std::vector<Quaternion<float>>& global_q,
+			const std::vector<Vector3f>& rel_r,
+			const std::vector<Quaternion<float>>& rel_q,
+			const std::vector<int>& parent);
+
+	private:
+		BatchedStateUpdate() {}
+
+		void rebuildSchedule(const std::vector<int>& parent);
+
+		/// level schedule: m_orderHost holds body ids grouped by tree depth,
+		/// m_levelBegin the first slot of every level plus one final end mark
+		std::vector<int> m_parentCache;
+		std::vector<int> m_levelBegin;
+		std::vector<int> m_orderHost;
+
+		DeviceArray<int> m_order;
+		DeviceArray<int> m_parent;
+
+		DeviceArray<float3> m_relR;
+		DeviceArray<float3> m_globalR;
+		DeviceArray<float4> m_relQ;
+		DeviceArray<float4> m_globalQ;
+	};
+}
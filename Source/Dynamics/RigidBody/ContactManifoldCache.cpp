@@ -0,0 +1,97 @@
+#include "Dynamics/RigidBody/ContactManifoldCache.h"
+
+namespace PhysIKA
+{
+	bool ContactManifoldCache::warmStart(int body_a, int body_b, unsigned int feature,
+		float& normal_impulse, float tangent_impulse[2]) const
+	{
+		auto iter = m_manifolds.find(pairKey(body_a, body_b));
+		if (iter == m_manifolds.end())
+		{
+			return false;
+		}
+
+		const Manifold& manifold = iter->second;
+		for (int i = 0; i < manifold.point_num; ++i)
+		{
+			if (manifold.points[i].feature == feature)
+			{
+				normal_impulse = manifold.points[i].normal_impulse;
+				tangent_impulse[0] = manifold.points[i].tangent_impulse[0];
+				tangent_impulse[1] = manifold.points[i].tangent_impulse[1];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ContactManifoldCache::store(int body_a, int body_b, unsigned int feature,
+		float normal_impulse, const float tangent_impulse[2])
+	{
+		Manifold& manifold = m_manifolds[pairKey(body_a, body_b)];
+
+		int slot = -1;
+		for (int i = 0; i < manifold.point_num; ++i)
+		{
+			if (manifold.points[i].feature == feature)
+			{
+				slot = i;
+				break;
+			}
+		}
+
+		if (slot < 0)
+		{
+			if (manifold.point_num < MAX_MANIFOLD_POINTS)
+			{
+				slot = manifold.point_num++;
+			}
+			else
+			{
+				// full: evict the weakest point, strong contacts carry the stack
+				slot = 0;
+				for (int i = 1; i < MAX_MANIFOLD_POINTS; ++i)
+				{
+					if (manifold.points[i].normal_impulse < manifold.points[slot].normal_impulse)
+					{
+						slot = i;
+					}
+				}
+			}
+		}
+
+		manifold.points[slot].feature = feature;
+		manifold.points[slot].normal_impulse = normal_impulse;
+		manifold.points[slot].tangent_impulse[0] = tangent_impulse[0];
+		manifold.points[slot].tangent_impulse[1] = tangent_impulse[1];
+		manifold.points[slot].frame = m_frame;
+	}
+
+	void ContactManifoldCache::endFrame()
+	{
+		auto iter = m_manifolds.begin();
+		while (iter != m_manifolds.end())
+		{
+			Manifold& manifold = iter->second;
+
+			int alive = 0;
+			for (int i = 0; i < manifold.point_num; ++i)
+			{
+				if (manifold.points[i].frame == m_frame)
+				{
+					manifold.points[alive++] = manifold.points[i];
+				}
+			}
+			manifold.point_num = alive;
+
+			if (alive == 0)
+			{
+				iter = m_manifolds.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+	}
+}
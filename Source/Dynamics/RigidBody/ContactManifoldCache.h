@@ -0,0 +1,82 @@
+#pragma once
+
+#include <map>
+
+namespace PhysIKA
+{
+	/**
+	* @brief Persistent contact manifolds for warm starting an impulse solver.
+	* @details Manifolds are keyed by the body pair; the up-to-four points of a
+	*          manifold are matched across frames by a caller-defined feature id
+	*          (e.g. packed face/edge/vertex indices). A contact that persists
+	*          hands its converged impulse from the last frame to the solver as
+	*          the starting iterate, which is what lets stacking scenes run at a
+	*          fraction of the cold-start iteration count. Points not refreshed
+	*          during a frame are dropped in endFrame(), so separating contacts
+	*          do not leave stale impulses behind.
+	*
+	*          Per-frame protocol:
+	*            cache.beginFrame();
+	*            for each contact: cache.warmStart(a, b, feature, ...);
+	*            ... solver iterations ...
+	*            for each contact: cache.store(a, b, feature, ...);
+	*            cache.endFrame();
+	*/
+	class ContactManifoldCache
+	{
+	public:
+		static const int MAX_MANIFOLD_POINTS = 4;
+
+		struct ManifoldPoint
+		{
+			unsigned int feature = 0;
+			float normal_impulse = 0.0f;
+			float tangent_impulse[2] = { 0.0f, 0.0f };
+			int frame = 0;				// frame the point was last stored in
+		};
+
+		struct Manifold
+		{
+			int point_num = 0;
+			ManifoldPoint points[MAX_MANIFOLD_POINTS];
+		};
+
+		void beginFrame() { ++m_frame; }
+
+		/**
+		* @brief Look up the cached impulses of a persisting contact point.
+		* @return true if the pair had a point with this feature id last frame.
+		*/
+		bool warmStart(int body_a, int body_b, unsigned int feature,
+			float& normal_impulse, float tangent_impulse[2]) const;
+
+		/**
+		* @brief Record the converged impulses of a contact point for the next frame.
+		* @details If the manifold is full, the point with the smallest normal
+		*          impulse is replaced; strong contacts are the ones worth keeping.
+		*/
+		void store(int body_a, int body_b, unsigned int feature,
+			float normal_impulse, const float tangent_impulse[2]);
+
+		/**
+		* @brief Drop every point that was not stored this frame, and every
+		*        manifold that ran out of points.
+		*/
+		void endFrame();
+
+		void clear() { m_manifolds.clear(); }
+
+		int getManifoldNumber() const { return (int)m_manifolds.size(); }
+
+	private:
+		static unsigned long long pairKey(int body_a, int body_b)
+		{
+			unsigned int lo = body_a < body_b ? body_a : body_b;
+			unsigned int hi = body_a < body_b ? body_b : body_a;
+			return ((unsigned long long)lo << 32) | (unsigned long long)hi;
+		}
+
+		int m_frame = 0;
+		std::map<unsigned long long, Manifold> m_manifolds;
+	};
+}
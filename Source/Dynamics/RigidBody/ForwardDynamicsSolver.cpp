@@ -1,6 +1,7 @@
 
 #include "Dynamics/RigidBody/ForwardDynamicsSolver.h"
 #include "Core/Matrix/matrix_mxn.h"
+#include "Core/Matrix/fixed_matrix.h"
 #include "Core/Vector/vector_nd.h"
 #include "Dynamics/RigidBody/RigidUtil.h"
 #include "Transform3d.h"
@@ -45,7 +46,8 @@ namespace PhysIKA
 		std::cout << std::endl;
 	}
 
-	const SpatialVector<float> _v2p(const MatrixMN<float>& m, const SpatialVector<float>& v)
+	template<typename TMat>
+	const SpatialVector<float> _v2p(const TMat& m, const SpatialVector<float>& v)
 	{
 		SpatialVector<float> res;
 		for (int i = 0; i < 6; ++i)
@@ -124,7 +126,7 @@ namespace PhysIKA
 	}
 
 	template<typename T>
-	void IxS(const MatrixMN<T>& inertia, const JointSpaceBase<T>& S, SpatialVector<T>* res)
+	void IxS(const FixedMatrix<T, 6, 6>& inertia, const JointSpaceBase<T>& S, SpatialVector<T>* res)
 	{
 		int joint_dof = S.dof();
 
@@ -161,7 +163,9 @@ namespace PhysIKA
 		std::vector<SpatialVector<float>> avp(all_node.size());			// velocity, node frame
 		std::vector<SpatialVector<float>> fvp(all_node.size());
 
-		std::vector<MatrixMN<float>> IC(all_node.size());
+		//Spatial inertias are always 6x6; keeping them on the stack avoids one
+		//heap allocation per body per step.
+		std::vector<FixedMatrix<float, 6, 6>> IC(all_node.size());
 
 		/// ***  calculate C, using inverse dynamics *************
 		/// This part consists of 2 passes. 
@@ -2,6 +2,7 @@
 
 //#include "Core/Matrix/matrix_base.h"
 #include "Core/Vector/vector_3d.h"
+#include "Core/Matrix/fixed_matrix.h"
 #include "SpatialVector.h"
 
 
@@ -33,6 +34,7 @@ namespace PhysIKA
 		const Inertia<float> operator+(const Inertia<T>& inertia)const;
 
 		void getTensor(MatrixMN<T>& m) const;
+		void getTensor(FixedMatrix<T, 6, 6>& m) const;
 
 
 	public:
@@ -73,4 +75,17 @@ namespace PhysIKA
 		m(4, 4) = m_mass;
 		m(5, 5) = m_mass;
 	}
+
+	template<typename T>
+	inline void Inertia<T>::getTensor(FixedMatrix<T, 6, 6>& m) const
+	{
+		m.setZeros();
+
+		m(0, 0) = m_inertiaDiagonal[0];
+		m(1, 1) = m_inertiaDiagonal[1];
+		m(2, 2) = m_inertiaDiagonal[2];
+		m(3, 3) = m_mass;
+		m(4, 4) = m_mass;
+		m(5, 5) = m_mass;
+	}
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <queue>
 #include<memory>
 #include<vector>
+#include<thread>
 
 #include "Transform3d.h"
 #include "RigidBodyRoot.h"
@@ -23,10 +24,10 @@ namespace PhysIKA
 
 	void InverseDynamicsSolver::inverseDynamics(const SystemState& system_state, const Vectornd<float>& ddq, Vectornd<float>& tau, bool zeroAcceleration)
 	{
-		Vectornd<SpatialVector<float>> avp;
-		Vectornd<SpatialVector<float>> v;
+		std::vector<SpatialVector<float>> avp;
+		std::vector<SpatialVector<float>> v;
 		//Vectornd<Transform3d<float>> Xup;
-		Vectornd<SpatialVector<float>> fvp;
+		std::vector<SpatialVector<float>> fvp;
 
 		//std::vector< std::pair<int, std::shared_ptr<RigidBody2<DataType3f>>>> all_node =  static_cast<RigidBody2<DataType3f>*>(this->getParent())->getAllParentidNodePair();
 
@@ -36,6 +37,12 @@ namespace PhysIKA
 		std::vector< std::pair<int, std::shared_ptr<RigidBody2<DataType3f>>>> all_node = root->getAllParentidNodePair();
 		const std::vector<int>& idx_map = root->getJointIdxMap();
 
+		//The per-body state was indexed into empty Vectornd containers before;
+		//size the buffers up front.
+		avp.resize(all_node.size());
+		v.resize(all_node.size());
+		fvp.resize(all_node.size());
+
 		for (int i = 0; i < all_node.size(); ++i)
 		{
 			int parent_id = all_node[i].first;
@@ -92,4 +99,108 @@ namespace PhysIKA
 		//return tau;
 	}
 
+	void InverseDynamicsSolver::inverseDynamicsBatch(const SystemState& system_state,
+		const std::vector<SystemMotionState>& states,
+		const std::vector<Vectornd<float>>& ddqs,
+		std::vector<Vectornd<float>>& taus)
+	{
+		int batch_num = states.size();
+		if (batch_num <= 0)
+		{
+			return;
+		}
+
+		RigidBodyRoot<DataType3f>* root = static_cast<RigidBodyRoot<DataType3f>*>(this->m_parent_node);
+		const std::vector< std::pair<int, std::shared_ptr<RigidBody2<DataType3f>>>>& all_node = root->getAllParentidNodePair();
+		const std::vector<int>& idx_map = root->getJointIdxMap();
+		int n_node = all_node.size();
+		int joint_dof = root->getJointDof();
+
+		JointExecutionPlan* plan = root->getJointPlan() && root->getJointPlan()->isValid()
+			? root->getJointPlan().get() : NULL;
+
+		taus.resize(batch_num);
+
+		// one contiguous chunk per worker; each worker owns its scratch buffers
+		int worker_num = std::thread::hardware_concurrency();
+		if (worker_num <= 0) worker_num = 1;
+		if (worker_num > batch_num) worker_num = batch_num;
+
+		auto evaluateRange = [&](int k_begin, int k_end)
+		{
+			std::vector<SpatialVector<float>> avp(n_node);
+			std::vector<SpatialVector<float>> v(n_node);
+			std::vector<SpatialVector<float>> fvp(n_node);
+
+			for (int k = k_begin; k < k_end; ++k)
+			{
+				const SystemMotionState& s = states[k];
+				const Vectornd<float>& ddq = ddqs[k];
+				Vectornd<float>& tau = taus[k];
+				tau.resize(joint_dof);
+
+				for (int i = 0; i < n_node; ++i)
+				{
+					int parent_id = all_node[i].first;
+					std::shared_ptr<RigidBody2<DataType3f>> cur_node = all_node[i].second;
+					Joint* cur_joint = cur_node->getParentJoint();
+
+					SpatialVector<float> vJ = plan ? plan->mul(i, &(s.m_dq[idx_map[i]]))
+						: cur_joint->getJointSpace().mul(&(s.m_dq[idx_map[i]]));
+					SpatialVector<float> aJ = plan ? plan->mul(i, &(ddq[idx_map[i]]))
+						: cur_joint->getJointSpace().mul(&(ddq[idx_map[i]]));
+
+					if (parent_id < 0)
+					{
+						v[i] = vJ;
+						avp[i] = aJ;
+					}
+					else
+					{
+						v[i] = (s.m_X[i].transformM(v[parent_id]) + vJ);
+						avp[i] = s.m_X[i].transformM(avp[parent_id]) + aJ + v[i].crossM(vJ);
+					}
+					fvp[i] = cur_node->getI() * avp[i] + v[i].crossF(cur_node->getI()*v[i]);
+					fvp[i] = fvp[i] - system_state.m_externalForce[i];
+				}
+
+				for (int i = n_node - 1; i >= 0; --i)
+				{
+					int parent_id = all_node[i].first;
+					Joint* cur_joint = all_node[i].second->getParentJoint();
+
+					if (plan)
+						plan->transposeMul(i, fvp[i], &(tau[idx_map[i]]));
+					else
+						cur_joint->getJointSpace().transposeMul(fvp[i], &(tau[idx_map[i]]));
+
+					if (parent_id >= 0)
+					{
+						fvp[parent_id] = fvp[parent_id] + s.m_X[i].inverseTransform().transformF(fvp[i]);
+					}
+				}
+			}
+		};
+
+		if (worker_num == 1)
+		{
+			evaluateRange(0, batch_num);
+			return;
+		}
+
+		std::vector<std::thread> workers;
+		int chunk = (batch_num + worker_num - 1) / worker_num;
+		for (int w = 0; w < worker_num; ++w)
+		{
+			int k_begin = w * chunk;
+			int k_end = k_begin + chunk < batch_num ? k_begin + chunk : batch_num;
+			if (k_begin >= k_end) break;
+			workers.push_back(std::thread(evaluateRange, k_begin, k_end));
+		}
+		for (size_t w = 0; w < workers.size(); ++w)
+		{
+			workers[w].join();
+		}
+	}
+
 }
\ No newline at end of file
@@ -6,7 +6,7 @@
 #include "SystemState.h"
 
 #include<memory>
-//#include<vector>
+#include<vector>
 
 namespace PhysIKA
 {
@@ -29,6 +29,19 @@ namespace PhysIKA
 		//void inverseDynamics(const SystemState& s, const Vectornd<float>& ddq, Vectornd<float>& tau, bool zeroAcceleration = false);
 		void inverseDynamics(const SystemState& s, const Vectornd<float>& ddq, Vectornd<float>& tau, bool zeroAcceleration = false);
 
+		/// solve the inverse dynamic problem for a batch of candidate states.
+		/// Input: system_state, shared tree info and external forces;
+		///        states, K motion states to evaluate;
+		///        ddqs, the K general accelerations.
+		/// Output: taus, the K active force vectors (resized as needed).
+		/// The tree traversal setup (node pairs, index map, joint bases) is
+		/// gathered once and the K evaluations run on a thread pool chunk-wise,
+		/// each thread reusing its own scratch buffers.
+		void inverseDynamicsBatch(const SystemState& system_state,
+			const std::vector<SystemMotionState>& states,
+			const std::vector<Vectornd<float>>& ddqs,
+			std::vector<Vectornd<float>>& taus);
+
 		Node* getParent() { return m_parent_node; }
 		void setParent(Node* parent_node) { m_parent_node = parent_node; }
 
@@ -0,0 +1,185 @@
+#include "IslandBuilder.h"
+
+#include <cuda_runtime.h>
+
+#include "Core/Utility/cuda_utilities.h"
+
+namespace PhysIKA
+{
+	__device__ inline int Island_Find(int* parent, int i)
+	{
+		while (parent[i] != i)
+		{
+			// halve the path on the way up; benign race, parent only moves towards the root
+			int p = parent[i];
+			int gp = parent[p];
+			if (p != gp)
+			{
+				parent[i] = gp;
+			}
+			i = p;
+		}
+		return i;
+	}
+
+	__global__ void Island_InitParent(int* parent, int n)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= n) return;
+
+		parent[i] = i;
+	}
+
+	/// Lock-free hooking: repeatedly try to attach the larger root under the smaller one.
+	__global__ void Island_UnionPairs(int* parent, int* pairs, int pair_num)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= pair_num) return;
+
+		int a = pairs[2 * i];
+		int b = pairs[2 * i + 1];
+
+		while (true)
+		{
+			a = Island_Find(parent, a);
+			b = Island_Find(parent, b);
+			if (a == b) return;
+
+			if (a > b)
+			{
+				int tmp = a; a = b; b = tmp;
+			}
+
+			int old = atomicMin(&parent[b], a);
+			if (old == b) return;
+
+			// someone hooked b elsewhere first; keep merging from that root
+			b = old;
+		}
+	}
+
+	__global__ void Island_Flatten(int* parent, int n)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= n) return;
+
+		parent[i] = Island_Find(parent, i);
+	}
+
+	void IslandBuilder::reset()
+	{
+		if (m_d_parent)
+		{
+			cuSafeCall(cudaFree(m_d_parent));
+			m_d_parent = 0;
+		}
+		if (m_d_pairs)
+		{
+			cuSafeCall(cudaFree(m_d_pairs));
+			m_d_pairs = 0;
+		}
+		m_parent_capacity = 0;
+		m_pair_capacity = 0;
+
+		m_body_num = 0;
+		m_island_num = 0;
+		m_body_island.clear();
+		m_island_offset.clear();
+		m_island_bodies.clear();
+		m_island_active.clear();
+	}
+
+	void IslandBuilder::build(int body_num, const std::vector<std::pair<int, int>>& collision_pairs)
+	{
+		m_body_num = body_num;
+		m_island_num = 0;
+		m_body_island.assign(body_num, -1);
+		m_island_offset.clear();
+		m_island_bodies.clear();
+
+		if (body_num <= 0)
+		{
+			m_island_offset.push_back(0);
+			m_island_active.clear();
+			return;
+		}
+
+		int pair_num = (int)collision_pairs.size();
+
+		if (body_num > m_parent_capacity)
+		{
+			if (m_d_parent) cuSafeCall(cudaFree(m_d_parent));
+			m_parent_capacity = body_num;
+			cuSafeCall(cudaMalloc((void**)&m_d_parent, body_num * sizeof(int)));
+		}
+		if (pair_num > m_pair_capacity)
+		{
+			if (m_d_pairs) cuSafeCall(cudaFree(m_d_pairs));
+			m_pair_capacity = pair_num;
+			cuSafeCall(cudaMalloc((void**)&m_d_pairs, 2 * pair_num * sizeof(int)));
+		}
+
+		uint pDims = cudaGridSize(body_num, BLOCK_SIZE);
+		Island_InitParent << <pDims, BLOCK_SIZE >> > (m_d_parent, body_num);
+
+		if (pair_num > 0)
+		{
+			// std::pair<int,int> is two contiguous ints, upload as a flat array
+			cuSafeCall(cudaMemcpy(m_d_pairs, &collision_pairs[0], 2 * pair_num * sizeof(int), cudaMemcpyHostToDevice));
+
+			uint pairDims = cudaGridSize(pair_num, BLOCK_SIZE);
+			Island_UnionPairs << <pairDims, BLOCK_SIZE >> > (m_d_parent, m_d_pairs, pair_num);
+		}
+
+		Island_Flatten << <pDims, BLOCK_SIZE >> > (m_d_parent, body_num);
+		cuSynchronize();
+
+		std::vector<int> roots(body_num);
+		cuSafeCall(cudaMemcpy(&roots[0], m_d_parent, body_num * sizeof(int), cudaMemcpyDeviceToHost));
+
+		// compact root labels to dense island ids; roots are visited in body order,
+		// so a root always precedes the bodies it represents
+		for (int i = 0; i < body_num; ++i)
+		{
+			int r = roots[i];
+			if (m_body_island[r] < 0)
+			{
+				m_body_island[r] = m_island_num++;
+			}
+			m_body_island[i] = m_body_island[r];
+		}
+
+		// CSR island -> body lists via counting sort on island id
+		m_island_offset.assign(m_island_num + 1, 0);
+		for (int i = 0; i < body_num; ++i)
+		{
+			++m_island_offset[m_body_island[i] + 1];
+		}
+		for (int k = 0; k < m_island_num; ++k)
+		{
+			m_island_offset[k + 1] += m_island_offset[k];
+		}
+
+		m_island_bodies.resize(body_num);
+		std::vector<int> cursor(m_island_offset.begin(), m_island_offset.end() - 1);
+		for (int i = 0; i < body_num; ++i)
+		{
+			m_island_bodies[cursor[m_body_island[i]]++] = i;
+		}
+
+		// new islands start awake
+		m_island_active.assign(m_island_num, 1);
+	}
+
+	void IslandBuilder::updateActivity(const std::vector<float>& speed, float threshold)
+	{
+		m_island_active.assign(m_island_num, 0);
+		for (int i = 0; i < m_body_num; ++i)
+		{
+			if (speed[i] > threshold)
+			{
+				m_island_active[m_body_island[i]] = 1;
+			}
+		}
+	}
+}
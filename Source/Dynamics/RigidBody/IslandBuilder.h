@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+namespace PhysIKA
+{
+	/**
+	* @brief Contact-island discovery from a broadphase pair list.
+	* @details Bodies connected through overlap pairs are grouped into islands by
+	*          a GPU union-find (lock-free hooking with pointer jumping). Islands
+	*          can then be solved independently: the builder exposes a CSR layout
+	*          (island offsets + body lists) for parallel per-island dispatch, and
+	*          an activity flag per island so a whole resting pile can be skipped.
+	*          An island sleeps only when every body in it is below the speed
+	*          threshold; one moving body wakes the entire island.
+	*/
+	class IslandBuilder
+	{
+	public:
+		IslandBuilder() {}
+		~IslandBuilder() { reset(); }
+
+		void reset();
+
+		/**
+		* @brief Group body_num bodies into islands from the overlap pair list.
+		* @details Bodies that appear in no pair each form a singleton island.
+		*/
+		void build(int body_num, const std::vector<std::pair<int, int>>& collision_pairs);
+
+		/**
+		* @brief Recompute per-island activity from per-body speeds.
+		* @details speed is indexed by body id; an island is active if any of
+		*          its bodies moves faster than threshold.
+		*/
+		void updateActivity(const std::vector<float>& speed, float threshold);
+
+		int getIslandNumber() const { return m_island_num; }
+
+		/// Island id of a body, in [0, getIslandNumber()).
+		int getBodyIsland(int body_id) const { return m_body_island[body_id]; }
+
+		/// Bodies of island i are m_island_bodies[m_island_offset[i] .. m_island_offset[i+1]).
+		const std::vector<int>& getIslandOffsets() const { return m_island_offset; }
+		const std::vector<int>& getIslandBodies() const { return m_island_bodies; }
+
+		bool isIslandActive(int island_id) const { return m_island_active[island_id] != 0; }
+
+	private:
+		int m_body_num = 0;
+		int m_island_num = 0;
+
+		std::vector<int> m_body_island;
+		std::vector<int> m_island_offset;
+		std::vector<int> m_island_bodies;
+		std::vector<int> m_island_active;
+
+		// device buffers, grown on demand
+		int m_parent_capacity = 0;
+		int m_pair_capacity = 0;
+		int* m_d_parent = 0;
+		int* m_d_pairs = 0;
+	};
+}
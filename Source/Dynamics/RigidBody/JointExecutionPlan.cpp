@@ -0,0 +1,92 @@
+#include "Dynamics/RigidBody/JointExecutionPlan.h"
+
+#include <typeinfo>
+
+#include "Dynamics/RigidBody/Joint.h"
+
+namespace PhysIKA
+{
+	void JointExecutionPlan::clear()
+	{
+		m_valid = false;
+		m_joint_dof = 0;
+
+		m_dof.clear();
+		m_dof_idx.clear();
+		m_base_idx.clear();
+		m_bases.clear();
+
+		m_group_type.clear();
+		m_group_bodies.clear();
+	}
+
+	void JointExecutionPlan::build(const std::vector<Joint*>& joints, const std::vector<int>& idx_map, int joint_dof)
+	{
+		this->clear();
+
+		int n = (int)joints.size();
+		m_joint_dof = joint_dof;
+
+		m_dof.resize(n);
+		m_dof_idx.resize(n);
+		m_base_idx.resize(n);
+
+		for (int i = 0; i < n; ++i)
+		{
+			Joint* cur_joint = joints[i];
+			int cur_dof = cur_joint->getJointDOF();
+
+			m_dof[i] = cur_dof;
+			m_dof_idx[i] = i < (int)idx_map.size() ? idx_map[i] : 0;
+
+			// snapshot the joint-space bases into one contiguous array
+			m_base_idx[i] = (int)m_bases.size();
+			if (cur_dof > 0)
+			{
+				const SpatialVector<float>* bases = cur_joint->getJointSpace().getBases();
+				for (int c = 0; c < cur_dof; ++c)
+				{
+					m_bases.push_back(bases[c]);
+				}
+			}
+
+			// group by concrete type
+			const char* type_name = typeid(*cur_joint).name();
+			int g = 0;
+			for (; g < (int)m_group_type.size(); ++g)
+			{
+				if (m_group_type[g] == type_name) break;
+			}
+			if (g == (int)m_group_type.size())
+			{
+				m_group_type.push_back(type_name);
+				m_group_bodies.push_back(std::vector<int>());
+			}
+			m_group_bodies[g].push_back(i);
+		}
+
+		m_valid = true;
+	}
+
+	const SpatialVector<float> JointExecutionPlan::mul(int i, const float* q) const
+	{
+		SpatialVector<float> res;
+		const SpatialVector<float>* bases = m_bases.data() + m_base_idx[i];
+		int cur_dof = m_dof[i];
+		for (int c = 0; c < cur_dof; ++c)
+		{
+			res += bases[c] * q[c];
+		}
+		return res;
+	}
+
+	void JointExecutionPlan::transposeMul(int i, const SpatialVector<float>& v, float* res) const
+	{
+		const SpatialVector<float>* bases = m_bases.data() + m_base_idx[i];
+		int cur_dof = m_dof[i];
+		for (int c = 0; c < cur_dof; ++c)
+		{
+			res[c] = bases[c] * v;
+		}
+	}
+}
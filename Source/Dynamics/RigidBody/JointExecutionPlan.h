@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "Dynamics/RigidBody/SpatialVector.h"
+
+namespace PhysIKA
+{
+	class Joint;
+
+	/**
+	* @brief Flattened, type-sorted execution plan over the joints of one articulation.
+	* @details The per-step loops of the rigid path ask every Joint for its dof and its
+	*          joint-space bases through virtual calls, which is a pointer-chasing
+	*          traversal over small heap objects. The plan snapshots that information
+	*          once into contiguous arrays - dofs, dof offsets and bases - and groups
+	*          the bodies by concrete joint type, so batch loops can run without any
+	*          virtual dispatch. It is rebuilt only when the articulation changes
+	*          (RigidBodyRoot::updateTree); joint-space bases are set up once per
+	*          joint and never mutated during stepping, so the snapshot stays valid.
+	*/
+	class JointExecutionPlan
+	{
+	public:
+		JointExecutionPlan() {}
+
+		void clear();
+
+		/**
+		* @brief Rebuild the plan.
+		* @param joints Parent joint of every body, indexed by body id.
+		* @param idx_map Body id to first dof index, as RigidBodyRoot::getJointIdxMap.
+		* @param joint_dof Total dof of the articulation.
+		*/
+		void build(const std::vector<Joint*>& joints, const std::vector<int>& idx_map, int joint_dof);
+
+		bool isValid() const { return m_valid; }
+		void invalidate() { m_valid = false; }
+
+		int getJointNum() const { return (int)m_dof.size(); }
+		int getJointDof() const { return m_joint_dof; }
+
+		int getDof(int i) const { return m_dof[i]; }
+		int getDofIdx(int i) const { return m_dof_idx[i]; }
+		const SpatialVector<float>* getBases(int i) const { return m_bases.data() + m_base_idx[i]; }
+
+		/// S * q, the non-virtual counterpart of JointSpaceBase::mul.
+		const SpatialVector<float> mul(int i, const float* q) const;
+
+		/// S^T * v, the non-virtual counterpart of JointSpaceBase::transposeMul.
+		void transposeMul(int i, const SpatialVector<float>& v, float* res) const;
+
+		/// Bodies grouped by concrete joint type, each group a contiguous id array.
+		int getGroupNum() const { return (int)m_group_type.size(); }
+		const std::string& getGroupType(int g) const { return m_group_type[g]; }
+		const std::vector<int>& getGroupBodies(int g) const { return m_group_bodies[g]; }
+
+	private:
+		bool m_valid = false;
+		int m_joint_dof = 0;
+
+		std::vector<int> m_dof;
+		std::vector<int> m_dof_idx;
+		std::vector<int> m_base_idx;
+		std::vector<SpatialVector<float>> m_bases;
+
+		std::vector<std::string> m_group_type;
+		std::vector<std::vector<int>> m_group_bodies;
+	};
+}
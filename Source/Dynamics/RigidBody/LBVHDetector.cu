@@ -0,0 +1,348 @@
+#include "LBVHDetector.h"
+
+#include <algorithm>
+
+
+#include "Core/Utility/cuda_utilities.h"
+
+namespace PhysIKA
+{
+	__device__ inline unsigned int LBVH_ExpandBits(unsigned int v)
+	{
+		v = (v * 0x00010001u) & 0xFF0000FFu;
+		v = (v * 0x00000101u) & 0x0F00F00Fu;
+		v = (v * 0x00000011u) & 0xC30C30C3u;
+		v = (v * 0x00000005u) & 0x49249249u;
+		return v;
+	}
+
+	template<typename T>
+	__device__ inline bool LBVH_Overlap(const BoxAABB3d<T>& a, const BoxAABB3d<T>& b)
+	{
+		return !(a.m_u[0] < b.m_l[0] || b.m_u[0] < a.m_l[0]
+			|| a.m_u[1] < b.m_l[1] || b.m_u[1] < a.m_l[1]
+			|| a.m_u[2] < b.m_l[2] || b.m_u[2] < a.m_l[2]);
+	}
+
+	/// Common prefix length of two sort keys; keys are unique since the leaf id is appended.
+	__device__ inline int LBVH_Delta(unsigned long long* codes, int n, int i, int j)
+	{
+		if (j < 0 || j >= n) return -1;
+		return __clzll(codes[i] ^ codes[j]);
+	}
+
+	template<typename T>
+	__global__ void LBVH_ComputeCodes(
+		unsigned long long* codes,
+		int* sortedId,
+		BoxAABB3d<T>* boxes,
+		int n,
+		T ox, T oy, T oz,
+		T sx, T sy, T sz)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= n) return;
+
+		T cx = T(0.5) * (boxes[i].m_l[0] + boxes[i].m_u[0]);
+		T cy = T(0.5) * (boxes[i].m_l[1] + boxes[i].m_u[1]);
+		T cz = T(0.5) * (boxes[i].m_l[2] + boxes[i].m_u[2]);
+
+		unsigned int x = (unsigned int)min(max((int)((cx - ox) * sx), 0), 1023);
+		unsigned int y = (unsigned int)min(max((int)((cy - oy) * sy), 0), 1023);
+		unsigned int z = (unsigned int)min(max((int)((cz - oz) * sz), 0), 1023);
+
+		unsigned int morton = (LBVH_ExpandBits(x) << 2) + (LBVH_ExpandBits(y) << 1) + LBVH_ExpandBits(z);
+
+		codes[i] = ((unsigned long long)morton << 32) | (unsigned long long)i;
+		sortedId[i] = i;
+	}
+
+	/// Parallel radix-tree construction over the sorted codes, one thread per internal node.
+	__global__ void LBVH_BuildTree(
+		int* childL,
+		int* childR,
+		int* parent,
+		unsigned long long* codes,
+		int n)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= n - 1) return;
+
+		int d = (LBVH_Delta(codes, n, i, i + 1) - LBVH_Delta(codes, n, i, i - 1)) >= 0 ? 1 : -1;
+		int dmin = LBVH_Delta(codes, n, i, i - d);
+
+		int lmax = 2;
+		while (LBVH_Delta(codes, n, i, i + lmax * d) > dmin)
+		{
+			lmax <<= 1;
+		}
+
+		int l = 0;
+		for (int t = lmax >> 1; t > 0; t >>= 1)
+		{
+			if (LBVH_Delta(codes, n, i, i + (l + t) * d) > dmin)
+			{
+				l += t;
+			}
+		}
+		int j = i + l * d;
+		int dnode = LBVH_Delta(codes, n, i, j);
+
+		// split position: the highest index on the left side of the cut
+		int s = 0;
+		for (int t = (l + 1) >> 1; t > 0; t = (t == 1) ? 0 : ((t + 1) >> 1))
+		{
+			if (LBVH_Delta(codes, n, i, i + (s + t) * d) > dnode)
+			{
+				s += t;
+			}
+		}
+		int gamma = i + s * d + min(d, 0);
+
+		int left = (min(i, j) == gamma) ? (n - 1 + gamma) : gamma;
+		int right = (max(i, j) == gamma + 1) ? (n - 1 + gamma + 1) : (gamma + 1);
+
+		childL[i] = left;
+		childR[i] = right;
+		parent[left] = i;
+		parent[right] = i;
+
+		if (i == 0)
+		{
+			parent[0] = -1;
+		}
+	}
+
+	/// Bottom-up box fitting: each leaf walks towards the root, the second thread
+	/// arriving at an internal node merges the two finished child boxes.
+	template<typename T>
+	__global__ void LBVH_FitBoxes(
+		BoxAABB3d<T>* nodeBox,
+		int* visited,
+		int* childL,
+		int* childR,
+		int* parent,
+		int* sortedId,
+		BoxAABB3d<T>* boxes,
+		int n)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= n) return;
+
+		int node = parent[n - 1 + i];
+		while (node >= 0)
+		{
+			__threadfence();
+			if (atomicAdd(&visited[node], 1) == 0)
+			{
+				return;
+			}
+
+			int cl = childL[node];
+			int cr = childR[node];
+
+			const BoxAABB3d<T>& bl = (cl >= n - 1) ? boxes[sortedId[cl - (n - 1)]] : nodeBox[cl];
+			const BoxAABB3d<T>& br = (cr >= n - 1) ? boxes[sortedId[cr - (n - 1)]] : nodeBox[cr];
+
+			BoxAABB3d<T> box = bl;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				box.m_l[axis] = min(box.m_l[axis], br.m_l[axis]);
+				box.m_u[axis] = max(box.m_u[axis], br.m_u[axis]);
+			}
+			nodeBox[node] = box;
+
+			node = parent[node];
+		}
+	}
+
+	template<typename T>
+	__global__ void LBVH_FindPairs(
+		int* pairs,
+		int* counter,
+		int capacity,
+		BoxAABB3d<T>* nodeBox,
+		int* childL,
+		int* childR,
+		int* sortedId,
+		BoxAABB3d<T>* boxes,
+		int n)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= n) return;
+
+		int myId = sortedId[i];
+		BoxAABB3d<T> myBox = boxes[myId];
+
+		int stack[64];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			int node = stack[--top];
+
+			int c[2];
+			c[0] = childL[node];
+			c[1] = childR[node];
+
+			for (int k = 0; k < 2; ++k)
+			{
+				if (c[k] >= n - 1)
+				{
+					int leaf = c[k] - (n - 1);
+					if (leaf <= i) continue;		// each pair is reported once, by the lower leaf
+
+					int otherId = sortedId[leaf];
+					if (LBVH_Overlap(myBox, boxes[otherId]))
+					{
+						int slot = atomicAdd(counter, 1);
+						if (slot < capacity)
+						{
+							pairs[2 * slot] = min(myId, otherId);
+							pairs[2 * slot + 1] = max(myId, otherId);
+						}
+					}
+				}
+				else if (LBVH_Overlap(myBox, nodeBox[c[k]]))
+				{
+					stack[top++] = c[k];
+				}
+			}
+		}
+	}
+
+	template<typename T>
+	LBVHDetector<T>::~LBVHDetector()
+	{
+		if (m_counter != NULL)
+		{
+			cuSafeCall(cudaFree(m_counter));
+		}
+	}
+
+	template<typename T>
+	void LBVHDetector<T>::reset()
+	{
+		m_n = 0;
+	}
+
+	template<typename T>
+	void LBVHDetector<T>::resizeBuffers(int n)
+	{
+		m_boxes.resize(n);
+		m_codes.resize(n);
+		m_sortedId.resize(n);
+		m_childL.resize(n - 1);
+		m_childR.resize(n - 1);
+		m_parent.resize(2 * n - 1);
+		m_nodeBox.resize(n - 1);
+		m_visited.resize(n - 1);
+
+		if (m_capacity < 32 * n)
+		{
+			m_capacity = 32 * n;
+			m_pairs.resize(2 * m_capacity);
+		}
+
+		if (m_counter == NULL)
+		{
+			cuSafeCall(cudaMalloc((void**)&m_counter, sizeof(int)));
+		}
+	}
+
+	template<typename T>
+	bool LBVHDetector<T>::detect(const std::vector<BoxAABB3d<T>>& boxes, std::vector<std::pair<int, int>>& collision_pairs)
+	{
+		collision_pairs.clear();
+
+		int n = (int)boxes.size();
+		if (n < 2)
+		{
+			return false;
+		}
+
+		if (n != m_n)
+		{
+			resizeBuffers(n);
+			m_n = n;
+		}
+
+		cuSafeCall(cudaMemcpy(m_boxes.getDataPtr(), boxes.data(), n * sizeof(BoxAABB3d<T>), cudaMemcpyHostToDevice));
+
+		// scene bounds for the Morton quantization; the boxes are host data anyway
+		T lo[3], hi[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			lo[axis] = boxes[0].getl(axis);
+			hi[axis] = boxes[0].getu(axis);
+		}
+		for (int i = 1; i < n; ++i)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				lo[axis] = std::min(lo[axis], boxes[i].getl(axis));
+				hi[axis] = std::max(hi[axis], boxes[i].getu(axis));
+			}
+		}
+		T scale[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			T ext = hi[axis] - lo[axis];
+			scale[axis] = ext > 0 ? T(1024) / ext : T(0);
+		}
+
+		uint pDims = cudaGridSize(n, BLOCK_SIZE);
+
+		LBVH_ComputeCodes << <pDims, BLOCK_SIZE >> > (
+			m_codes.getDataPtr(), m_sortedId.getDataPtr(), m_boxes.getDataPtr(), n,
+			lo[0], lo[1], lo[2], scale[0], scale[1], scale[2]);
+		cuSynchronize();
+
+		m_sort.sortByKey(m_codes.getDataPtr(), m_sortedId.getDataPtr(), n);
+
+		LBVH_BuildTree << <pDims, BLOCK_SIZE >> > (
+			m_childL.getDataPtr(), m_childR.getDataPtr(), m_parent.getDataPtr(), m_codes.getDataPtr(), n);
+		cuSynchronize();
+
+		cuSafeCall(cudaMemset(m_visited.getDataPtr(), 0, (n - 1) * sizeof(int)));
+		LBVH_FitBoxes << <pDims, BLOCK_SIZE >> > (
+			m_nodeBox.getDataPtr(), m_visited.getDataPtr(), m_childL.getDataPtr(), m_childR.getDataPtr(),
+			m_parent.getDataPtr(), m_sortedId.getDataPtr(), m_boxes.getDataPtr(), n);
+		cuSynchronize();
+
+		int pair_num = 0;
+		for (;;)
+		{
+			cuSafeCall(cudaMemset(m_counter, 0, sizeof(int)));
+			LBVH_FindPairs << <pDims, BLOCK_SIZE >> > (
+				m_pairs.getDataPtr(), m_counter, m_capacity, m_nodeBox.getDataPtr(),
+				m_childL.getDataPtr(), m_childR.getDataPtr(), m_sortedId.getDataPtr(), m_boxes.getDataPtr(), n);
+			cuSynchronize();
+
+			cuSafeCall(cudaMemcpy(&pair_num, m_counter, sizeof(int), cudaMemcpyDeviceToHost));
+			if (pair_num <= m_capacity)
+			{
+				break;
+			}
+
+			// the preallocated pair buffer overflowed; grow it and run the query again
+			m_capacity = pair_num;
+			m_pairs.resize(2 * m_capacity);
+		}
+
+		if (pair_num > 0)
+		{
+			std::vector<int> host_pairs(2 * pair_num);
+			cuSafeCall(cudaMemcpy(host_pairs.data(), m_pairs.getDataPtr(), 2 * pair_num * sizeof(int), cudaMemcpyDeviceToHost));
+
+			collision_pairs.resize(pair_num);
+			for (int i = 0; i < pair_num; ++i)
+			{
+				collision_pairs[i] = std::make_pair(host_pairs[2 * i], host_pairs[2 * i + 1]);
+			}
+		}
+
+		return !collision_pairs.empty();
+	}
+}
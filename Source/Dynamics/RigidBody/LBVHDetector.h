@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include "Dynamics/RigidBody/BoxAABB3d.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility/Sort.h"
+
+namespace PhysIKA
+{
+	/**
+	* @brief GPU linear-BVH broad-phase detector.
+	* @details Drop-in alternative to SortSweepDetector for large box sets. Leaf
+	*          boxes are Morton-sorted, a radix tree is built over the sorted
+	*          codes in parallel (Karras 2012), internal boxes are fitted
+	*          bottom-up, and every leaf then traverses the tree to collect its
+	*          overlapping pairs. All stages run on the device; only the final
+	*          pair list is copied back to the host.
+	*/
+	template<typename T>
+	class LBVHDetector
+	{
+	public:
+		LBVHDetector() {}
+		~LBVHDetector();
+
+		void reset();
+
+		bool detect(const std::vector<BoxAABB3d<T>>& boxes, std::vector<std::pair<int, int>>& collision_pairs);
+
+	private:
+		void resizeBuffers(int n);
+
+		int m_n = 0;
+		int m_capacity = 0;					// pair buffer capacity
+
+		DeviceArray<BoxAABB3d<T>> m_boxes;
+		DeviceArray<unsigned long long> m_codes;	// morton code with the leaf id appended
+		DeviceArray<int> m_sortedId;
+		Sort m_sort;
+
+		// internal nodes 0 .. n-2; child entries >= n-1 encode sorted leaf (c - (n-1))
+		DeviceArray<int> m_childL;
+		DeviceArray<int> m_childR;
+		DeviceArray<int> m_parent;			// parent of internal i and of leaf n-1+i
+		DeviceArray<BoxAABB3d<T>> m_nodeBox;
+		DeviceArray<int> m_visited;
+
+		DeviceArray<int> m_pairs;			// two ints per pair
+		int* m_counter = NULL;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class LBVHDetector<float>;
+#else
+	template class LBVHDetector<double>;
+#endif
+}
@@ -11,51 +11,47 @@ namespace PhysIKA
 		//State solve(const State& s0, void(*dydt)(const State&, DState&), double dt)
 		//SystemMotionState solve(const State& s0, void(*dydt)(const State&, DState&), double dt)
 		//void solve(SystemMotionState& s0, void(*dydt)(const SystemMotionState&, DSystemMotionState&), double dt)
+
+		/**
+		* The stage state and the four derivative buffers are members, so a
+		* long-lived integrator allocates them once and every later step reuses
+		* the storage; the stage states are combined in place with
+		* SystemMotionState::axpyFrom instead of copy-then-add.
+		*/
 		template<typename DYDT>
 		void solve(SystemMotionState& s0, DYDT& dydt, double dt)
 		{
-			//return s0 + dydt(s0) * dt;
-
 			//State k1 = dydt(s0);
 			//State k2 = dydt(s0 + k1*(dt * 0.5));
 			//State k3 = dydt(s0 + k2*(dt*0.5));
 			//State k4 = dydt(s0 + k3 * dt);
 
-			SystemMotionState s;
-			//DSystemMotionState k;
-
-			s = s0;
-			DSystemMotionState k1;
-			dydt(s, k1);
+			dydt(s0, m_k1);
 
-			s = s0;
-			s.addDs(k1, dt*0.5);
-			DSystemMotionState k2;
-			dydt(s, k2);
+			m_stage.axpyFrom(s0, m_k1, dt*0.5);
+			dydt(m_stage, m_k2);
 
-			s = s0;
-			s.addDs(k2, dt*0.5);
-			DSystemMotionState k3;
-			dydt(s, k3);
+			m_stage.axpyFrom(s0, m_k2, dt*0.5);
+			dydt(m_stage, m_k3);
 
-			s = s0;
-			s.addDs(k3, dt);
-			DSystemMotionState k4;
-			dydt(s, k4);
+			m_stage.axpyFrom(s0, m_k3, dt);
+			dydt(m_stage, m_k4);
 
 			double newdt = dt / 6.0;
-			s0.addDs(k1, newdt);
-			s0.addDs(k2, newdt*2.0);
-			s0.addDs(k3, newdt*2.0);
-			s0.addDs(k4, newdt);
-
-			//DSystemMotionState k;
-			//dydt(s0, k);
-			//s0.addDs(k, dt);
+			s0.addDs(m_k1, newdt);
+			s0.addDs(m_k2, newdt*2.0);
+			s0.addDs(m_k3, newdt*2.0);
+			s0.addDs(m_k4, newdt);
 
 			//return s0;// +(k1 + (k2*2.0) + (k3*2.0) + k4)*(dt / 6.0);
-
 		}
 
+	private:
+		SystemMotionState m_stage;
+
+		DSystemMotionState m_k1;
+		DSystemMotionState m_k2;
+		DSystemMotionState m_k3;
+		DSystemMotionState m_k4;
 	};
 }
@@ -73,6 +73,9 @@ namespace PhysIKA
 			m_sizez = sz;
 		}
 
+		Vector3f getGeometrySize() const { return Vector3f(m_sizex, m_sizey, m_sizez); }
+		double getGlobalScale() const { return m_global_scale; }
+
 		Vector3f getGlobalR() const { return m_global_r; }
 		Quaternion<float> getGlobalQ() const { return m_global_q; }
 
@@ -0,0 +1,160 @@
+#include "Dynamics/RigidBody/RigidBodyModel.h"
+
+#include "tinyxml/tinyxml2.h"
+
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace PhysIKA
+{
+	namespace
+	{
+		std::map<std::string, std::shared_ptr<RigidBodyModel>> g_modelCache;
+		std::mutex g_modelCacheMutex;
+	}
+
+	std::shared_ptr<RigidBodyModel> RigidBodyModel::loadFromFile(std::string filename)
+	{
+		{
+			std::lock_guard<std::mutex> guard(g_modelCacheMutex);
+			auto iter = g_modelCache.find(filename);
+			if (iter != g_modelCache.end())
+			{
+				return iter->second;
+			}
+		}
+
+		tinyxml2::XMLDocument doc;
+		doc.LoadFile(filename.c_str());
+		tinyxml2::XMLElement* urdf_root = doc.RootElement();
+		if (!urdf_root)
+		{
+			return nullptr;
+		}
+
+		std::shared_ptr<RigidBodyModel> model = std::make_shared<RigidBodyModel>();
+		model->m_name = urdf_root->Attribute("name");
+
+		std::map<std::string, int> link_ids;
+
+		// find all link elements
+		tinyxml2::XMLElement* urdf_link = urdf_root->FirstChildElement("link");
+		while (urdf_link)
+		{
+			Link cur_link;
+			cur_link.name = urdf_link->Attribute("name");
+			link_ids[cur_link.name] = (int)model->m_links.size();
+
+			// -- link inertial --
+			auto link_inertial = urdf_link->FirstChildElement("inertial");
+			{
+				// relative position info
+				auto inertial_origin = link_inertial->FirstChildElement("origin");
+				std::stringstream ss_origin_xyz(inertial_origin->Attribute("xyz"));
+				std::stringstream ss_origin_rpy(inertial_origin->Attribute("rpy"));
+				Vector3f cur_r;
+				Vector3f cur_w;
+				ss_origin_rpy >> cur_w[1] >> cur_w[2] >> cur_w[0];
+				ss_origin_xyz >> cur_r[0] >> cur_r[1] >> cur_r[2];
+				Quaternion<float> q_rotate;
+				q_rotate.set(cur_w);
+				cur_link.r_j2r = cur_r;
+				cur_link.q_j2r = q_rotate;
+
+				// rigid body property info. inertia & mass
+				auto inertial_mass = link_inertial->FirstChildElement("mass");
+				std::stringstream ss_mass_value(inertial_mass->Attribute("value"));
+				double cur_mass;
+				ss_mass_value >> cur_mass;
+
+				auto inertial_inertia = link_inertial->FirstChildElement("inertia");
+				std::stringstream ss_inertia_ixx(inertial_inertia->Attribute("ixx"));
+				std::stringstream ss_inertia_iyy(inertial_inertia->Attribute("iyy"));
+				std::stringstream ss_inertia_izz(inertial_inertia->Attribute("izz"));
+				double ixx, iyy, izz;
+				ss_inertia_ixx >> ixx;
+				ss_inertia_iyy >> iyy;
+				ss_inertia_izz >> izz;
+				cur_link.inertia.setInertiaDiagonal(Vector3f(ixx, iyy, izz));
+				cur_link.inertia.setMass(cur_mass);
+			}
+
+			// rigid geometry info
+			auto link_visual = urdf_link->FirstChildElement("visual");
+			if (link_visual)
+			{
+				auto visual_geometry = link_visual->FirstChildElement("geometry");
+				if (visual_geometry)
+				{
+					auto geometry_box = visual_geometry->FirstChildElement("box");
+					if (geometry_box)
+					{
+						std::stringstream sssize(geometry_box->Attribute("size"));
+						float sx, sy, sz;
+						sssize >> sx >> sy >> sz;
+						cur_link.geometry_size = Vector3f(sx, sy, sz);
+						cur_link.has_geometry = true;
+					}
+				}
+			}
+
+			model->m_links.push_back(cur_link);
+
+			// next link
+			urdf_link = urdf_link->NextSiblingElement("link");
+		}
+
+		// find all joint elements
+		tinyxml2::XMLElement* urdf_joint = urdf_root->FirstChildElement("joint");
+		while (urdf_joint)
+		{
+			JointInfo cur_joint;
+			cur_joint.name = urdf_joint->Attribute("name");
+
+			// find parent and child
+			cur_joint.parent = link_ids[urdf_joint->FirstChildElement("parent")->Attribute("link")];
+			cur_joint.child = link_ids[urdf_joint->FirstChildElement("child")->Attribute("link")];
+
+			// find joint position info
+			auto joint_origin = urdf_joint->FirstChildElement("origin");
+			std::string xyz = joint_origin->Attribute("xyz");
+			std::string rpy = joint_origin->Attribute("rpy");
+			Vector3f cur_r;
+			Quaternion<float> q;
+			double or , op, oy;
+			std::stringstream ssxyz(xyz);
+			std::stringstream ssrpy(rpy);
+			ssxyz >> cur_r[0] >> cur_r[1] >> cur_r[2];
+			ssrpy >> or >> op >> oy;
+			q.set(Vector3f(oy, or , op));
+			cur_joint.r_r2j = cur_r;
+			cur_joint.q_r2j = q;
+
+			// joint property info
+			// axis is expressed in child node frame.
+			auto joint_axis = urdf_joint->FirstChildElement("axis");
+			std::string axis_xyz = joint_axis->Attribute("xyz");
+			std::stringstream ssaxis(axis_xyz);
+			ssaxis >> cur_joint.axis[0] >> cur_joint.axis[1] >> cur_joint.axis[2];
+
+			model->m_joints.push_back(cur_joint);
+
+			// next joint
+			urdf_joint = urdf_joint->NextSiblingElement("joint");
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(g_modelCacheMutex);
+			g_modelCache[filename] = model;
+		}
+
+		return model;
+	}
+
+	void RigidBodyModel::clearCache()
+	{
+		std::lock_guard<std::mutex> guard(g_modelCacheMutex);
+		g_modelCache.clear();
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Core/Vector/vector_3d.h"
+#include "Core/Quaternion/quaternion.h"
+#include "Dynamics/RigidBody/Inertia.h"
+
+namespace PhysIKA
+{
+	/**
+	* @brief Compiled, immutable description of a URDF robot.
+	* @details Parsing a URDF file yields one RigidBodyModel holding the link
+	*          inertias, geometry sizes and joint frames/axes. Models are cached
+	*          by filename, so loading the same robot many times parses and
+	*          compiles the XML once; every instance built from a model gets its
+	*          own node tree and motion state, while the shared model is never
+	*          mutated after compilation.
+	*/
+	class RigidBodyModel
+	{
+	public:
+		struct Link
+		{
+			std::string name;
+			Inertia<float> inertia;
+			Vector3f geometry_size;
+			bool has_geometry = false;
+			Vector3f r_j2r;						// inertial origin: joint frame -> link frame
+			Quaternion<float> q_j2r;
+		};
+
+		struct JointInfo					// "Joint" would clash with the scene-graph class
+		{
+			std::string name;
+			int parent = -1;					// link index
+			int child = -1;						// link index
+			Vector3f r_r2j;						// joint origin: parent link frame -> joint frame
+			Quaternion<float> q_r2j;
+			Vector3f axis;						// revolute axis, expressed in the child frame
+		};
+
+		const std::string& getName() const { return m_name; }
+		const std::vector<Link>& getLinks() const { return m_links; }
+		const std::vector<JointInfo>& getJoints() const { return m_joints; }
+
+		/**
+		* @brief Parse and compile a URDF file, or return the cached model if
+		*        this file has been compiled before.
+		*/
+		static std::shared_ptr<RigidBodyModel> loadFromFile(std::string filename);
+
+		static void clearCache();
+
+	private:
+		std::string m_name;
+		std::vector<Link> m_links;
+		std::vector<JointInfo> m_joints;
+	};
+}
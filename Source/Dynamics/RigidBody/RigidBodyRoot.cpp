@@ -187,6 +187,19 @@ namespace PhysIKA
 			this->m_state->setNum(this->m_all_childs_nodes.size(), this->m_joint_dof);
 		}
 
+		// rebuild the flattened joint plan; the per-step loops read dofs and
+		// joint-space bases from it instead of virtual calls on every Joint
+		if (!this->m_joint_plan)
+		{
+			this->m_joint_plan = std::make_shared<JointExecutionPlan>();
+		}
+		std::vector<Joint*> joints(m_all_childs_nodes.size());
+		for (int j = 0; j < (int)m_all_childs_nodes.size(); ++j)
+		{
+			joints[j] = m_all_childs_nodes[j]->getParentJoint();
+		}
+		this->m_joint_plan->build(joints, m_joint_idx_map, m_joint_dof);
+
 		//m_state.build();
 	}
 
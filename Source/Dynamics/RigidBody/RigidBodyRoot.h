@@ -4,6 +4,7 @@
 #include "Dynamics/RigidBody/RigidBody2.h"
 #include "Dynamics/RigidBody/Joint.h"
 #include "Dynamics/RigidBody/SystemState.h"
+#include "Dynamics/RigidBody/JointExecutionPlan.h"
 
 #include <list>
 
@@ -67,6 +68,9 @@ namespace PhysIKA
 
 		std::shared_ptr<SystemState> getSystemState() { return m_state; }
 		void setSystemState(std::shared_ptr<SystemState> state) { m_state = state; }
+
+		// flattened, type-sorted joint information; rebuilt by updateTree()
+		std::shared_ptr<JointExecutionPlan> getJointPlan() { return m_joint_plan; }
 		//cosnt SystemState& getSystemState() const { return m_state; }
 
 	private:
@@ -99,6 +103,9 @@ namespace PhysIKA
 		// system state
 		// includes: external force and motion states
 		std::shared_ptr<SystemState> m_state;
+
+		// joint execution plan shared by the per-step loops
+		std::shared_ptr<JointExecutionPlan> m_joint_plan;
 	};
 
 
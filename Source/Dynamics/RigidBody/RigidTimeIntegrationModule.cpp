@@ -62,9 +62,9 @@ namespace PhysIKA
 		RigidBodyRoot<DataType3f>* root = static_cast<RigidBodyRoot<DataType3f>*>(this->getParent());
 		SystemState& s = *(static_cast<RigidBodyRoot<DataType3f>*>(this->getParent())->getSystemState());
 
-		RK4Integrator rk4;
-		//*(s.m_motionState) = rk4.solve(*(s.m_motionState), dydt, m_dt);
-		rk4.solve(*(s.m_motionState), DydtAdapter(this), m_dt);
+		//*(s.m_motionState) = m_rk4.solve(*(s.m_motionState), dydt, m_dt);
+		DydtAdapter adapter(this);
+		m_rk4.solve(*(s.m_motionState), adapter, m_dt);
 
 		//s = s + RigidState::dydt(s) * m_dt;
 
@@ -122,6 +122,9 @@ namespace PhysIKA
 			/// joint index map
 			const std::vector<int>& idx_map = root->getJointIdxMap();
 
+			/// flattened joint plan, avoids virtual dispatch per joint per stage
+			JointExecutionPlan* joint_plan = root->getJointPlan() && root->getJointPlan()->isValid() ? root->getJointPlan().get() : NULL;
+
 			ds.setRigidNum(all_nodes.size());
 
 			for (int i = 0; i < all_nodes.size(); ++i)
@@ -130,14 +133,14 @@ namespace PhysIKA
 				std::shared_ptr<RigidBody2<DataType3f>> cur_node = all_nodes[i].second;
 				Joint* cur_joint = cur_node->getParentJoint();
 
-				int dof = cur_joint->getJointDOF();
+				int dof = joint_plan ? joint_plan->getDof(i) : cur_joint->getJointDOF();
 				if (dof > 0)
 				{
 					const Transform3d<float>& Xup = s0.m_X[i];
 					Transform3d<float> Xupinv = Xup.inverseTransform();
 
 					/// d_vJ
-					ds.m_v[i] = cur_joint->getJointSpace().mul(&(ds.m_dq[idx_map[i]]));
+					ds.m_v[i] = joint_plan ? joint_plan->mul(i, &(ds.m_dq[idx_map[i]])) : cur_joint->getJointSpace().mul(&(ds.m_dq[idx_map[i]]));
 
 					SpatialVector<float> cur_v6 = s0.m_v[i];
 
@@ -12,6 +12,7 @@
 
 #include<memory>
 #include<vector>
+#include "Dynamics/RigidBody/RKIntegrator.h"
 
 namespace PhysIKA
 {
@@ -52,6 +53,9 @@ namespace PhysIKA
 	private:
 		std::shared_ptr<ForwardDynamicsSolver> m_fd_solver;
 
+		// persistent integrator so its stage buffers are reused across steps
+		RK4Integrator m_rk4;
+
 		Vectornd<float> m_ddq;
 		double m_dt = 0;
 
@@ -51,6 +51,24 @@ namespace PhysIKA
 			}
 		}
 
+		/// Overload on raw bases, used by the flattened joint plan to avoid the
+		/// virtual per-element access of JointSpaceBase.
+		template<typename T>
+		static void IxS(const MatrixMN<T>& inertia, const SpatialVector<T>* S, int joint_dof, SpatialVector<T>* res)
+		{
+			for (int i = 0; i < joint_dof; ++i)
+			{
+				for (int j = 0; j < 6; ++j)
+				{
+					res[i][j] = 0;
+					for (int k = 0; k < 6; ++k)
+					{
+						res[i][j] += inertia(j, k) * S[i][k];
+					}
+				}
+			}
+		}
+
 		template<typename T>
 		static void setStxS(const SpatialVector<T>* S1, int dof1, const SpatialVector<T>* S2, int dof2, MatrixMN<T>& H, int idxi, int idxj)
 		{
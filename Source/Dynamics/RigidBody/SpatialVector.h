@@ -7,6 +7,17 @@
 #include "Core/Vector/vector_base.h"
 #include <glm/gtx/norm.hpp>
 
+// AVX2/FMA specializations of the hot spatial-algebra routines, used by the CPU
+// rigid-body path. Selected at compile time from the host compiler's target
+// flags; device code and non-AVX2 builds keep the generic template bodies.
+// The storage layout is left untouched (two tightly packed 3-vectors), so the
+// specializations use unaligned lane loads, which carry no penalty on AVX2
+// hardware, and the type stays memcpy-compatible with the flattened GPU buffers.
+#if !defined(__CUDACC__) && defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define SPATIAL_VECTOR_AVX2
+#include <immintrin.h>
+#endif
+
 
 namespace PhysIKA{
 
@@ -302,6 +313,66 @@ inline COMM_FUNC const SpatialVector<T> SpatialVector<T>::crossF(const SpatialVe
 	return res;
 }
 
+#ifdef SPATIAL_VECTOR_AVX2
+
+namespace SpatialVectorSIMD
+{
+	/// One [x y z 0] lane from a tightly packed 3-vector.
+	inline __m128 load3(const float* p)
+	{
+		return _mm_set_ps(0.0f, p[2], p[1], p[0]);
+	}
+
+	inline void store3(float* p, __m128 v)
+	{
+		float tmp[4];
+		_mm_storeu_ps(tmp, v);
+		p[0] = tmp[0]; p[1] = tmp[1]; p[2] = tmp[2];
+	}
+
+	/// Cross product of two [x y z 0] lanes: shuffle(a * b_yzx - a_yzx * b).
+	inline __m128 cross3(__m128 a, __m128 b)
+	{
+		__m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		__m128 c = _mm_fmsub_ps(a, b_yzx, _mm_mul_ps(a_yzx, b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+}
+
+template<>
+inline const SpatialVector<float> SpatialVector<float>::crossM(const SpatialVector<float>& vec) const
+{
+	using namespace SpatialVectorSIMD;
+
+	__m128 aw = load3(&this->m_angular.x);
+	__m128 av = load3(&this->m_linear.x);
+	__m128 bw = load3(&vec.m_angular.x);
+	__m128 bv = load3(&vec.m_linear.x);
+
+	SpatialVector<float> res;
+	store3(&res.m_angular.x, cross3(aw, bw));
+	store3(&res.m_linear.x, _mm_add_ps(cross3(aw, bv), cross3(av, bw)));
+	return res;
+}
+
+template<>
+inline const SpatialVector<float> SpatialVector<float>::crossF(const SpatialVector<float>& vec) const
+{
+	using namespace SpatialVectorSIMD;
+
+	__m128 aw = load3(&this->m_angular.x);
+	__m128 av = load3(&this->m_linear.x);
+	__m128 bw = load3(&vec.m_angular.x);
+	__m128 bv = load3(&vec.m_linear.x);
+
+	SpatialVector<float> res;
+	store3(&res.m_angular.x, _mm_add_ps(cross3(aw, bw), cross3(av, bv)));
+	store3(&res.m_linear.x, cross3(aw, bv));
+	return res;
+}
+
+#endif // SPATIAL_VECTOR_AVX2
 
 }
 
@@ -1,5 +1,6 @@
 #include "Dynamics/RigidBody/SystemMotionState.h"
 #include "RigidBodyRoot.h"
+#include "BatchedStateUpdate.h"
 
 namespace PhysIKA
 {
@@ -36,7 +37,7 @@ namespace PhysIKA
 		// /
 		if (this->m_root)
 		{
-			auto all_node_pairs = static_cast<RigidBodyRoot<DataType3f>*>(this->m_root)->getAllParentidNodePair();
+			const auto& all_node_pairs = static_cast<RigidBodyRoot<DataType3f>*>(this->m_root)->getAllParentidNodePair();
 
 			for (int i = 0; i < all_node_pairs.size(); ++i)
 			{
@@ -63,20 +64,96 @@ namespace PhysIKA
 		return *this;
 	}
 
+	SystemMotionState & SystemMotionState::axpyFrom(const SystemMotionState & s0, const DSystemMotionState & ds, double dt)
+	{
+		this->m_root = s0.m_root;
+
+		int n = s0.m_rel_r.size();
+		if (this->m_rel_r.size() != n)
+		{
+			this->setRigidNum(n);
+		}
+		if (s0.m_dq.size() > 0 && this->m_dq.size() != s0.m_dq.size())
+		{
+			this->m_dq.resize(s0.m_dq.size());
+		}
+
+		for (int i = 0; i < n; ++i)
+		{
+			this->m_rel_r[i] = s0.m_rel_r[i] + ds.m_rel_r[i] * dt;
+			this->m_rel_q[i] = s0.m_rel_q[i] + ds.m_rel_q[i] * dt;
+			this->m_v[i] = s0.m_v[i] + ds.m_v[i] * dt;
+		}
+
+		int dof = this->m_dq.size();
+		for (int i = 0; i < dof; ++i)
+		{
+			this->m_dq[i] = s0.m_dq[i] + ds.m_dq[i] * dt;
+		}
+
+		// update the derived transforms and global state, as addDs does
+		if (this->m_root)
+		{
+			const auto& all_node_pairs = static_cast<RigidBodyRoot<DataType3f>*>(this->m_root)->getAllParentidNodePair();
+
+			for (int i = 0; i < all_node_pairs.size(); ++i)
+			{
+				int parent_id = all_node_pairs[i].first;
+
+				this->m_X[i] = Transform3d<float>(this->m_rel_r[i], this->m_rel_q[i].getConjugate());
+
+				if (parent_id >= 0)
+				{
+					this->m_global_r[i] = this->m_global_r[parent_id] + this->m_global_q[parent_id].rotate(this->m_rel_r[i]);
+					this->m_global_q[i] = this->m_global_q[parent_id] * this->m_rel_q[i];
+				}
+				else
+				{
+					this->m_global_r[i] = this->m_rel_r[i];
+					this->m_global_q[i] = this->m_rel_q[i];
+				}
+				this->m_global_q[i].normalize();
+			}
+		}
+
+		return *this;
+	}
+
 	void SystemMotionState::updateGlobalInfo()
 	{
 		RigidBodyRoot<DataType3f>* root = static_cast<RigidBodyRoot<DataType3f>*> (m_root);
 
-		auto nodePairs = root->getAllParentidNodePair();
+		const auto& nodePairs = root->getAllParentidNodePair();
+		int n = (int)nodePairs.size();
 
-		for (int i = 0; i < nodePairs.size(); ++i)
+		//the joint transforms stay on the host either way
+		for (int i = 0; i < n; ++i)
+		{
+			int cur_id = nodePairs[i].second->getId();
+			this->m_X[cur_id].set(this->m_rel_r[cur_id], this->m_rel_q[cur_id].getConjugate());
+		}
+
+		if (n >= BatchedStateUpdate::MIN_BATCH)
+		{
+			//large scenes: level-scheduled batch kernels compose all poses
+			//in a few launches instead of one body at a time
+			std::vector<int> parent(n, -1);
+			for (int i = 0; i < n; ++i)
+			{
+				parent[nodePairs[i].second->getId()] = nodePairs[i].first;
+			}
+
+			BatchedStateUpdate::getInstance().updateGlobalInfo(
+				m_global_r, m_global_q, m_rel_r, m_rel_q, parent);
+			return;
+		}
+
+		for (int i = 0; i < n; ++i)
 		{
 			RigidBody2_ptr cur_node = nodePairs[i].second;
 			int cur_id = cur_node->getId();
 			int parent_id = nodePairs[i].first;
 
-			this->m_X[cur_id].set(this->m_rel_r[cur_id], this->m_rel_q[cur_id].getConjugate());
-
 			if (parent_id >= 0)
 			{
 				m_global_r[cur_id] = m_global_r[parent_id] + m_global_q[parent_id].rotate(m_rel_r[cur_id]);
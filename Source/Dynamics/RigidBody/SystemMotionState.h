@@ -53,6 +53,11 @@ namespace PhysIKA
 		//void build();
 		SystemMotionState& addDs(const DSystemMotionState& ds, double dt);
 
+		// In-place stage combination: *this = s0 + ds * dt, written into the
+		// existing storage in one sweep. Used by the RK integrator to avoid
+		// copying and reallocating the full system state for every stage.
+		SystemMotionState& axpyFrom(const SystemMotionState& s0, const DSystemMotionState& ds, double dt);
+
 		void updateGlobalInfo();
 
 		void setRigidNum(int n)
@@ -2,6 +2,7 @@
 
 
 #include "Core/Matrix/matrix_mxn.h"
+#include "Core/Matrix/fixed_matrix.h"
 #include "Core/Vector/vector_nd.h"
 #include "Core/Matrix/matrix_3x3.h"
 #include "Core/Quaternion/quaternion.h"
@@ -45,6 +46,7 @@ namespace PhysIKA
 
 		const Inertia<T> transformI(const Inertia<T>& inertia)const;
 		const MatrixMN<T> transformI(const MatrixMN<T>& inertia)const;
+		const FixedMatrix<T, 6, 6> transformI(const FixedMatrix<T, 6, 6>& inertia)const;
 
 		//MatrixMN<T> transformM(const MatrixMN<T>& m);
 
@@ -173,6 +175,64 @@ namespace PhysIKA
 		return res;
 	}
 
+#ifdef SPATIAL_VECTOR_AVX2
+
+	namespace TransformSIMD
+	{
+		/// Rotate one [x y z 0] lane: res = c0 * x + c1 * y + c2 * z.
+		inline __m128 rotate3(const Matrix3f& m, __m128 v)
+		{
+			__m128 c0 = _mm_set_ps(0.0f, m(2, 0), m(1, 0), m(0, 0));
+			__m128 c1 = _mm_set_ps(0.0f, m(2, 1), m(1, 1), m(0, 1));
+			__m128 c2 = _mm_set_ps(0.0f, m(2, 2), m(1, 2), m(0, 2));
+
+			__m128 res = _mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+			res = _mm_fmadd_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), res);
+			res = _mm_fmadd_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), res);
+			return res;
+		}
+	}
+
+	template<>
+	inline const SpatialVector<float>& Transform3d<float>::transformF(const SpatialVector<float>& f) const
+	{
+		using namespace SpatialVectorSIMD;
+
+		__m128 torque = load3(&f.m_angular.x);
+		__m128 lin = load3(&f.m_linear.x);
+		__m128 r = _mm_set_ps(0.0f, m_translation[2], m_translation[1], m_translation[0]);
+
+		// translation: new_torque = torque - r x f; new_f = f;
+		torque = _mm_sub_ps(torque, cross3(r, lin));
+
+		// rotation of both parts
+		SpatialVector<float> res;
+		store3(&res.m_angular.x, TransformSIMD::rotate3(m_rotation, torque));
+		store3(&res.m_linear.x, TransformSIMD::rotate3(m_rotation, lin));
+		return res;
+	}
+
+	template<>
+	inline const SpatialVector<float>& Transform3d<float>::transformM(const SpatialVector<float>& m) const
+	{
+		using namespace SpatialVectorSIMD;
+
+		__m128 ang = load3(&m.m_angular.x);
+		__m128 lin = load3(&m.m_linear.x);
+		__m128 r = _mm_set_ps(0.0f, m_translation[2], m_translation[1], m_translation[0]);
+
+		// translation: new_w = w; new_v = v - r x w;
+		lin = _mm_sub_ps(lin, cross3(r, ang));
+
+		// rotation of both parts
+		SpatialVector<float> res;
+		store3(&res.m_angular.x, TransformSIMD::rotate3(m_rotation, ang));
+		store3(&res.m_linear.x, TransformSIMD::rotate3(m_rotation, lin));
+		return res;
+	}
+
+#endif // SPATIAL_VECTOR_AVX2
+
 	// Transformation of inertia matrix
 	// I_2 = X_12f * I_1 * X_21m
 	template<typename T>
@@ -205,6 +265,36 @@ namespace PhysIKA
 
 	}
 
+	template<typename T>
+	inline const FixedMatrix<T, 6, 6> Transform3d<T>::transformI(const FixedMatrix<T, 6, 6>& inertia) const
+	{
+		FixedMatrix<T, 6, 6> res;
+
+		/// I_tmp = (X_12f * I_1)
+		for (int i = 0; i < 6; ++i)
+		{
+			SpatialVector<T> tmpv(inertia(0, i), inertia(1, i), inertia(2, i), inertia(3, i), inertia(4, i), inertia(5, i));
+			SpatialVector<T> tmpres = this->transformF(tmpv);
+
+			/// res = (X_12f * I_1)  = I_tmp
+			res(0, i) = tmpres[0]; res(1, i) = tmpres[1]; res(2, i) = tmpres[2];
+			res(3, i) = tmpres[3]; res(4, i) = tmpres[4]; res(5, i) = tmpres[5];
+		}
+
+		/// I_2 = I_tmp * X_21m = (X_12f * I_tmp^T)^T
+		for (int i = 0; i < 6; ++i)
+		{
+			SpatialVector<T> tmpv(res(i, 0), res(i, 1), res(i, 2), res(i, 3), res(i, 4), res(i, 5));
+			SpatialVector<T> tmpres = this->transformF(tmpv);
+
+			res(i, 0) = tmpres[0]; res(i, 1) = tmpres[1]; res(i, 2) = tmpres[2];
+			res(i, 3) = tmpres[3]; res(i, 4) = tmpres[4]; res(i, 5) = tmpres[5];
+		}
+
+		return res;
+
+	}
+
 	// Merge tow transformation into one
 	// X1 = [ E1      0 ]       X2 = [ E2      0 ]
 	//		[-E1*r1x  E1]            [-E2*r2x  E2]
@@ -2,6 +2,7 @@
 
 #include <string>
 #include "Dynamics/RigidBody/RigidBodyRoot.h"
+#include "Dynamics/RigidBody/RigidBodyModel.h"
 
 //#include <vector>
 #include <Core/Vector/vector_3d.h>
@@ -11,9 +12,19 @@ namespace PhysIKA{
 
 class Urdf{
 public:
+/**
+* @brief Load a robot from a URDF file.
+* @details The file is parsed into a cached RigidBodyModel on first use;
+*          repeated loads of the same file only instantiate from the
+*          compiled model, so a swarm of identical robots parses once.
+*/
 RigidBodyRoot_ptr loadFile(std::string filename);
 
+/**
+* @brief Build a fresh simulation tree from a compiled model.
+*/
+RigidBodyRoot_ptr instantiate(std::shared_ptr<RigidBodyModel> model);
 
 };
 
-}
\ No newline at end of file
+}
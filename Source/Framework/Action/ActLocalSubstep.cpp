@@ -0,0 +1,45 @@
+#include "ActLocalSubstep.h"
+#include "Framework/Framework/Node.h"
+
+namespace PhysIKA
+{
+
+	LocalSubstepAct::LocalSubstepAct(float interval)
+	{
+		m_interval = interval;
+	}
+
+	LocalSubstepAct::~LocalSubstepAct()
+	{
+
+	}
+
+	void LocalSubstepAct::process(Node* node)
+	{
+		if (node == NULL)
+		{
+			Log::sendMessage(Log::Error, "Node is invalid!");
+			return;
+		}
+
+		if (!node->isActive())
+		{
+			return;
+		}
+
+		float t = 0.0f;
+		float dt = node->getDt();
+
+		while (t + dt < m_interval)
+		{
+			node->advance(dt);
+
+			t += dt;
+			dt = node->getDt();
+		}
+
+		node->advance(m_interval - t);
+		node->updateTopology();
+	}
+
+}
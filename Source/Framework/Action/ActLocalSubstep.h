@@ -0,0 +1,27 @@
+#pragma once
+#include "Action.h"
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	LocalSubstepAct
+	*	\brief	Advance each node with its own stable timestep.
+	*
+	*	The global traversal clamps every node to the smallest dt in the
+	*	scene; this action instead lets every node cover the frame interval
+	*	with local substeps of its own size, re-querying the node's dt after
+	*	each substep so per-node adaptive steppers keep working. All nodes
+	*	land exactly on the frame boundary.
+	*/
+	class LocalSubstepAct : public Action
+	{
+	public:
+		LocalSubstepAct(float interval);
+		virtual ~LocalSubstepAct();
+
+	private:
+		void process(Node* node) override;
+
+		float m_interval;
+	};
+}
@@ -15,16 +15,12 @@ namespace PhysIKA
 
 	void PostProcessing::process(Node* node)
 	{
-		auto mList = node->getModuleList();
-		int cnt = 0;
-		for (auto iter = mList.begin(); iter != mList.end(); iter++)
+		//the compiled plan already holds only the active IO modules, so no
+		//per-module type-string compare happens here
+		auto& ioModules = node->getActiveModules("IOModule");
+		for (auto iter = ioModules.begin(); iter != ioModules.end(); iter++)
 		{
-			//printf("iter %s ::: %s\n", (*iter)->getName(),(*iter)->getModuleType());
-			if (std::string("IOModule").compare((*iter)->getModuleType()) == 0)
-			{
-				
-				(*iter)->execute();
-			}
+			(*iter)->execute();
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "Framework/Framework/Node.h"
+#include "CollidableHeightField.h"
+
+#include <cuda_runtime.h>
+
+namespace PhysIKA {
+
+	IMPLEMENT_CLASS_1(CollidableHeightField, TDataType)
+
+	template<typename TDataType>
+	CollidableHeightField<TDataType>::CollidableHeightField()
+		: CollidableObject(CollidableObject::HEIGHTFIELD_TYPE)
+		, m_origin(0)
+		, m_dx(0.01)
+		, m_dz(0.01)
+	{
+	}
+
+	template<typename TDataType>
+	CollidableHeightField<TDataType>::~CollidableHeightField()
+	{
+		m_heights.Release();
+	}
+
+	template<typename TDataType>
+	void CollidableHeightField<TDataType>::setHeights(std::vector<Real>& heights, int nx, int nz, Coord origin, Real dx, Real dz)
+	{
+		assert(heights.size() == nx * nz);
+
+		m_heights.Resize(nx, nz);
+		cudaMemcpy(m_heights.GetDataPtr(), &heights[0], nx * nz * sizeof(Real), cudaMemcpyHostToDevice);
+
+		m_origin = origin;
+		m_dx = dx;
+		m_dz = dz;
+	}
+
+	template<typename TDataType>
+	bool CollidableHeightField<TDataType>::initializeImpl()
+	{
+		return true;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include "Core/Array/Array2D.h"
+#include "Framework/Framework/CollidableObject.h"
+
+namespace PhysIKA {
+
+	/**
+	 * @brief A terrain collidable backed by a regular height map.
+	 *
+	 * Stores one height per grid cell over the xz plane instead of a full 3D
+	 * distance field: memory is independent of the terrain depth and a lookup
+	 * is a single bilinear fetch in 2D rather than a trilinear one in 3D.
+	 */
+	template<typename TDataType>
+	class CollidableHeightField : public CollidableObject
+	{
+		DECLARE_CLASS_1(CollidableHeightField, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		CollidableHeightField();
+		~CollidableHeightField();
+
+		/**
+		 * @brief Set the height samples. heights holds nx*nz values in row
+		 * major order; origin is the world position of sample (0, 0) and
+		 * dx/dz the grid spacing along x and z.
+		 */
+		void setHeights(std::vector<Real>& heights, int nx, int nz, Coord origin, Real dx, Real dz);
+
+		DeviceArray2D<Real>& getHeights() { return m_heights; }
+		Coord getOrigin() { return m_origin; }
+		Real getDx() { return m_dx; }
+		Real getDz() { return m_dz; }
+
+		void updateCollidableObject() override {};
+		void updateMechanicalState() override {};
+
+		bool initializeImpl() override;
+
+	private:
+		DeviceArray2D<Real> m_heights;
+		Coord m_origin;
+		Real m_dx;
+		Real m_dz;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class CollidableHeightField<DataType3f>;
+#else
+	template class CollidableHeightField<DataType3d>;
+#endif
+
+}
@@ -0,0 +1,33 @@
+#include "Framework/Framework/Node.h"
+#include "CollidableTransformedSDF.h"
+
+namespace PhysIKA {
+
+	IMPLEMENT_CLASS_1(CollidableTransformedSDF, TDataType)
+
+	template<typename TDataType>
+	CollidableTransformedSDF<TDataType>::CollidableTransformedSDF()
+		: CollidableObject(CollidableObject::SIGNED_DISTANCE_TYPE)
+		, m_translation(0)
+		, m_rotation(Matrix::identityMatrix())
+		, m_sdf(nullptr)
+	{
+	}
+
+
+	template<typename TDataType>
+	bool CollidableTransformedSDF<TDataType>::initializeImpl()
+	{
+		if (m_sdf == nullptr)
+		{
+			Coord lo(0.0f);
+			Coord hi(1.0f);
+			std::shared_ptr<DistanceField3D<TDataType>> box = std::make_shared<DistanceField3D<TDataType>>();
+			box->setSpace(lo - 0.025f, hi + 0.025f, 105, 105, 105);
+			box->loadBox(lo, hi, true);
+			this->setSDF(box);
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Framework/Topology/TransformedDistanceField3D.h"
+#include "Framework/Framework/CollidableObject.h"
+
+namespace PhysIKA {
+
+	/**
+	 * @brief A rigidly moving SDF obstacle.
+	 *
+	 * CollidableSDF wraps a static field; a rotating mixer blade or a
+	 * stirring paddle would have to re-bake (or tessellate) it every frame.
+	 * This collidable stores the field once in body space and carries a
+	 * rigid pose instead: collision models query it through the
+	 * TransformedDistanceField3D view, which applies the inverse transform
+	 * per query, so moving the obstacle costs a pose update and nothing
+	 * else.
+	 */
+	template<typename TDataType>
+	class CollidableTransformedSDF : public CollidableObject
+	{
+		DECLARE_CLASS_1(CollidableTransformedSDF, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef typename TDataType::Matrix Matrix;
+
+		CollidableTransformedSDF();
+
+		~CollidableTransformedSDF()
+		{
+			if (m_sdf != nullptr)
+			{
+				m_sdf->release();
+			}
+		}
+
+		/**
+		 * @brief The body-local field, stored once; the pose moves it.
+		 */
+		void setSDF(std::shared_ptr<DistanceField3D<TDataType>> sdf)
+		{
+			if (m_sdf != nullptr)
+			{
+				m_sdf->release();
+			}
+
+			m_sdf = sdf;
+		}
+
+		std::shared_ptr<DistanceField3D<TDataType>> getSDF() { return m_sdf; }
+
+		void setPose(const Coord& translation, const Matrix& rotation)
+		{
+			m_translation = translation;
+			m_rotation = rotation;
+		}
+
+		void setPose(const Transform<Real, 3>& transform)
+		{
+			setPose(transform.translation(), transform.rotation3x3Matrix());
+		}
+
+		Coord getTranslation() { return m_translation; }
+		Matrix getRotationMatrix() { return m_rotation; }
+
+		/**
+		 * @brief World-space view for the collision kernels, built from the
+		 * current pose; cheap enough to rebuild every frame.
+		 */
+		TransformedDistanceField3D<TDataType> getTransformedSDF()
+		{
+			TransformedDistanceField3D<TDataType> view;
+			view.setField(m_sdf);
+			view.setPose(m_translation, m_rotation);
+			return view;
+		}
+
+		void updateCollidableObject() override {};
+		void updateMechanicalState() override {};
+
+		bool initializeImpl() override;
+
+	private:
+		Coord m_translation;
+		Matrix m_rotation;
+
+		std::shared_ptr<DistanceField3D<TDataType>> m_sdf;
+	};
+
+
+#ifdef PRECISION_FLOAT
+	template class CollidableTransformedSDF<DataType3f>;
+#else
+	template class CollidableTransformedSDF<DataType3d>;
+#endif
+}
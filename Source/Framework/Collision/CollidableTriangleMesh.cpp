@@ -1,7 +1,11 @@
 #include "CollidableTriangleMesh.h"
+#include "Core/Utility.h"
+#include "Framework/Topology/TriangleSet.h"
 
 namespace PhysIKA
 {
+	IMPLEMENT_CLASS_1(CollidableTriangleMesh, TDataType)
+
 	template<typename TDataType>
 	CollidableSpheres<TDataType>::CollidableSpheres()
 	{
@@ -17,4 +21,53 @@ namespace PhysIKA
 	{
 
 	}
+
+	template<typename TDataType>
+	CollidableTriangleMesh<TDataType>::CollidableTriangleMesh()
+		: CollidableObject(CollidableObject::TRIANGLE_TYPE)
+		, m_triSet(nullptr)
+	{
+	}
+
+	template<typename TDataType>
+	CollidableTriangleMesh<TDataType>::~CollidableTriangleMesh()
+	{
+		m_prev_vertex.release();
+	}
+
+	template<typename TDataType>
+	void CollidableTriangleMesh<TDataType>::updateCollidableObject()
+	{
+		auto& points = m_triSet->getPoints();
+		if (m_prev_vertex.size() != points.size())
+		{
+			m_prev_vertex.resize(points.size());
+			Function1Pt::copy(m_prev_vertex, points);
+		}
+	}
+
+	template<typename TDataType>
+	void CollidableTriangleMesh<TDataType>::updateMechanicalState()
+	{
+		auto& points = m_triSet->getPoints();
+		if (m_prev_vertex.size() == points.size())
+		{
+			Function1Pt::copy(m_prev_vertex, points);
+		}
+	}
+
+	template<typename TDataType>
+	bool CollidableTriangleMesh<TDataType>::initializeImpl()
+	{
+		if (m_triSet == nullptr)
+		{
+			return false;
+		}
+
+		auto& points = m_triSet->getPoints();
+		m_prev_vertex.resize(points.size());
+		Function1Pt::copy(m_prev_vertex, points);
+
+		return true;
+	}
 }
\ No newline at end of file
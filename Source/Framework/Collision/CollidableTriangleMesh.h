@@ -22,6 +22,46 @@ namespace PhysIKA
 		DeviceArray<Coord> m_centers;
 	};
 
+	template <typename> class TriangleSet;
 
+	/**
+	 * @brief A collidable wrapper around a TriangleSet that keeps the vertex
+	 * positions of the previous frame, so collision models can sweep the
+	 * triangles through the frame instead of testing a single instant.
+	 */
+	template<typename TDataType>
+	class CollidableTriangleMesh : public CollidableObject
+	{
+		DECLARE_CLASS_1(CollidableTriangleMesh, TDataType)
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		CollidableTriangleMesh();
+		virtual ~CollidableTriangleMesh();
+
+		void setTriangleSet(std::shared_ptr<TriangleSet<TDataType>> triSet) { m_triSet = triSet; }
+		std::shared_ptr<TriangleSet<TDataType>> getTriangleSet() { return m_triSet; }
+
+		DeviceArray<Coord>& getPreviousVertices() { return m_prev_vertex; }
+
+		//capture the previous positions before the collision pass
+		void updateCollidableObject() override;
+
+		//commit the constrained positions as the new previous state
+		void updateMechanicalState() override;
+
+		bool initializeImpl() override;
+
+	private:
+		std::shared_ptr<TriangleSet<TDataType>> m_triSet;
+		DeviceArray<Coord> m_prev_vertex;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class CollidableTriangleMesh<DataType3f>;
+#else
+	template class CollidableTriangleMesh<DataType3d>;
+#endif
 
 }
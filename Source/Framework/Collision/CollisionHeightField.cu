@@ -0,0 +1,183 @@
+#include "CollisionHeightField.h"
+#include "Core/Utility.h"
+
+#include "Framework/Framework/Node.h"
+#include "Framework/Framework/CollidableObject.h"
+#include "Framework/Collision/CollidablePoints.h"
+#include "Framework/Collision/CollidableHeightField.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(CollisionHeightField, TDataType)
+
+	template<typename TDataType>
+	CollisionHeightField<TDataType>::CollisionHeightField()
+		: CollisionModel()
+		, m_cHeightField(nullptr)
+		, m_normal_friction(0.95)
+		, m_tangent_friction(0.1)
+	{
+	}
+
+	template<typename TDataType>
+	CollisionHeightField<TDataType>::~CollisionHeightField()
+	{
+		m_collidableObjects.clear();
+	}
+
+	template<typename TDataType>
+	bool CollisionHeightField<TDataType>::isSupport(std::shared_ptr<CollidableObject> obj)
+	{
+		if (obj->getType() == CollidableObject::POINTSET_TYPE)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	template<typename TDataType>
+	void CollisionHeightField<TDataType>::addDrivenObject(std::shared_ptr<CollidableObject> obj)
+	{
+		if (obj->getType() == CollidableObject::POINTSET_TYPE)
+		{
+			m_collidableObjects.push_back(obj);
+		}
+	}
+
+	template<typename TDataType>
+	void CollisionHeightField<TDataType>::addCollidableObject(std::shared_ptr<CollidableObject> obj)
+	{
+		if (obj->getType() == CollidableObject::POINTSET_TYPE)
+			addDrivenObject(obj);
+
+		if (obj->getType() == CollidableObject::HEIGHTFIELD_TYPE)
+			setCollidableHeightField(obj);
+	}
+
+	//bilinear height lookup at (x, z), clamped to the border samples
+	template<typename Real>
+	GPU_FUNC Real HF_SampleHeight(
+		DeviceArray2D<Real>& heights,
+		Real x, Real z)
+	{
+		int nx = heights.Nx();
+		int nz = heights.Ny();
+
+		x = x < 0 ? Real(0) : (x > nx - 1 ? Real(nx - 1) : x);
+		z = z < 0 ? Real(0) : (z > nz - 1 ? Real(nz - 1) : z);
+
+		int i = (int)x;
+		int j = (int)z;
+		if (i > nx - 2) i = nx - 2;
+		if (j > nz - 2) j = nz - 2;
+
+		Real fx = x - i;
+		Real fz = z - j;
+
+		Real h00 = heights(i, j);
+		Real h10 = heights(i + 1, j);
+		Real h01 = heights(i, j + 1);
+		Real h11 = heights(i + 1, j + 1);
+
+		return h00*(1 - fx)*(1 - fz) + h10*fx*(1 - fz) + h01*(1 - fx)*fz + h11*fx*fz;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void K_ConstrainParticlesHF(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray2D<Real> heights,
+		Coord origin,
+		Real dx,
+		Real dz,
+		Real normalFriction,
+		Real tangentialFriction,
+		Real dt)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos = posArr[pId];
+		Coord vec = velArr[pId];
+
+		Real gx = (pos[0] - origin[0]) / dx;
+		Real gz = (pos[2] - origin[2]) / dz;
+
+		Real h = origin[1] + HF_SampleHeight(heights, gx, gz);
+
+		if (pos[1] < h)
+		{
+			//normal from the height gradient, central differences one cell wide
+			Real hxp = HF_SampleHeight(heights, gx + 1, gz);
+			Real hxm = HF_SampleHeight(heights, gx - 1, gz);
+			Real hzp = HF_SampleHeight(heights, gx, gz + 1);
+			Real hzm = HF_SampleHeight(heights, gx, gz - 1);
+
+			Coord normal = Coord(-(hxp - hxm) / (2 * dx), Real(1), -(hzp - hzm) / (2 * dz));
+			normal = normal.normalize();
+
+			RandNumber rGen(pId);
+			pos[1] = h + Real(0.0001)*rGen.Generate();
+
+			// reflect velocity
+			Real vec_n = vec.dot(normal);
+			Coord vec_normal = vec_n*normal;
+			Coord vec_tan = vec - vec_normal;
+			if (vec_n > 0) vec_normal = -vec_normal;
+			vec_normal *= (1.0f - normalFriction);
+			vec = vec_normal + vec_tan;
+			vec *= pow(Real(M_E), -dt*tangentialFriction);
+		}
+
+		posArr[pId] = pos;
+		velArr[pId] = vec;
+	}
+
+	template<typename TDataType>
+	void CollisionHeightField<TDataType>::doCollision()
+	{
+		if (!m_cHeightField || m_collidableObjects.size() <= 0)
+		{
+			std::cout << "Collidable objects are not correctly set!" << std::endl;
+			return;
+		}
+
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			if (m_collidableObjects[i]->getType() == CollidableObject::POINTSET_TYPE)
+			{
+				std::shared_ptr<CollidablePoints<TDataType>> cPoints = std::dynamic_pointer_cast<CollidablePoints<TDataType>>(m_collidableObjects[i]);
+				DeviceArray<Coord>& pos = cPoints->getPositions();
+				DeviceArray<Coord>& vel = cPoints->getVelocities();
+
+				cPoints->updateCollidableObject();
+
+				cuint pDim = cudaGridSize(pos.size(), BLOCK_SIZE);
+				K_ConstrainParticlesHF << <pDim, BLOCK_SIZE >> > (
+					pos,
+					vel,
+					m_cHeightField->getHeights(),
+					m_cHeightField->getOrigin(),
+					m_cHeightField->getDx(),
+					m_cHeightField->getDz(),
+					m_normal_friction,
+					m_tangent_friction,
+					getParent()->getDt());
+
+				cPoints->updateMechanicalState();
+			}
+		}
+	}
+
+	template<typename TDataType>
+	bool CollisionHeightField<TDataType>::initializeImpl()
+	{
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			m_collidableObjects[i]->initialize();
+		}
+
+		return true;
+	}
+
+}
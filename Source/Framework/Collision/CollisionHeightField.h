@@ -0,0 +1,50 @@
+#pragma once
+#include "Framework/Framework/CollisionModel.h"
+
+namespace PhysIKA
+{
+template <typename> class CollidableHeightField;
+
+/**
+ * @brief Collision against a height-field terrain.
+ *
+ * The 2.5D counterpart of CollisionSDF: driven particle sets are projected
+ * onto the terrain surface with a bilinear height lookup and a normal taken
+ * from the height gradient, with the same friction response.
+ */
+template<typename TDataType>
+class CollisionHeightField : public CollisionModel
+{
+	DECLARE_CLASS_1(CollisionHeightField, TDataType)
+public:
+	typedef typename TDataType::Real Real;
+	typedef typename TDataType::Coord Coord;
+
+	CollisionHeightField();
+	virtual ~CollisionHeightField();
+
+	bool isSupport(std::shared_ptr<CollidableObject> obj) override;
+	void addDrivenObject(std::shared_ptr<CollidableObject> obj);
+	void setCollidableHeightField(std::shared_ptr<CollidableObject> hf) { m_cHeightField = std::dynamic_pointer_cast<CollidableHeightField<TDataType>>(hf); }
+
+	void addCollidableObject(std::shared_ptr<CollidableObject> obj) override;
+
+	bool initializeImpl() override;
+
+	void doCollision() override;
+
+protected:
+	Real m_normal_friction;
+	Real m_tangent_friction;
+
+	std::shared_ptr<CollidableHeightField<TDataType>> m_cHeightField;
+	std::vector<std::shared_ptr<CollidableObject>> m_collidableObjects;
+};
+
+#ifdef PRECISION_FLOAT
+template class CollisionHeightField<DataType3f>;
+#else
+template class CollisionHeightField<DataType3d>;
+#endif
+
+}
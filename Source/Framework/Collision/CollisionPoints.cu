@@ -1,5 +1,8 @@
 #include "CollisionPoints.h"
 #include "Core/Utility.h"
+
+#include <thrust/reduce.h>
+#include <thrust/execution_policy.h>
 #include "Framework/Framework/Node.h"
 #include "Framework/Framework/CollidableObject.h"
 #include "Framework/Collision/CollidablePoints.h"
@@ -42,6 +45,24 @@ namespace PhysIKA
 		}
 	}
 
+	template<typename Coord>
+	struct CP_MinOp
+	{
+		__host__ __device__ Coord operator()(const Coord& a, const Coord& b) const
+		{
+			return Coord(a[0] < b[0] ? a[0] : b[0], a[1] < b[1] ? a[1] : b[1], a[2] < b[2] ? a[2] : b[2]);
+		}
+	};
+
+	template<typename Coord>
+	struct CP_MaxOp
+	{
+		__host__ __device__ Coord operator()(const Coord& a, const Coord& b) const
+		{
+			return Coord(a[0] > b[0] ? a[0] : b[0], a[1] > b[1] ? a[1] : b[1], a[2] > b[2] ? a[2] : b[2]);
+		}
+	};
+
 	template<typename Real, typename Coord>
 	__global__ void K_Collide(
 		DeviceArray<int> objIds,
@@ -49,6 +70,7 @@ namespace PhysIKA
 		DeviceArray<Coord> newPoints,
 		DeviceArray<Real> weights,
 		NeighborList<int> neighbors,
+		DeviceArray<unsigned int> pairMask,
 		Real radius
 	)
 	{
@@ -65,7 +87,10 @@ namespace PhysIKA
 		{
 			int j = neighbors.getElement(pId, ne);
 			r = (pos_i - points[j]).norm();
-			if (r < radius && objIds[j] != id_i)
+			//the pair bitmask covers the first 32 objects; later ones pass through
+			int id_j = objIds[j];
+			bool pair_enabled = id_j >= 32 || ((pairMask[id_i] >> id_j) & 1) != 0;
+			if (r < radius && id_j != id_i && pair_enabled)
 			{
 				col_num++;
 				Coord center = (pos_i + points[j]) / 2;
@@ -142,6 +167,73 @@ namespace PhysIKA
 	template<typename TDataType>
 	void CollisionPoints<TDataType>::doCollision()
 	{
+		int obj_num = (int)m_collidableObjects.size();
+
+		Real radius = 0.005;
+
+		//per-object bounds, inflated by half the collision radius on each side
+		std::vector<Coord> obj_lo(obj_num);
+		std::vector<Coord> obj_hi(obj_num);
+		for (int i = 0; i < obj_num; i++)
+		{
+			DeviceArray<Coord>& points = m_collidableObjects[i]->getPositions();
+
+			Coord first;
+			cudaMemcpy(&first, points.getDataPtr(), sizeof(Coord), cudaMemcpyDeviceToHost);
+
+			Coord lo = thrust::reduce(thrust::device, points.getDataPtr(), points.getDataPtr() + points.size(), first, CP_MinOp<Coord>());
+			Coord hi = thrust::reduce(thrust::device, points.getDataPtr(), points.getDataPtr() + points.size(), first, CP_MaxOp<Coord>());
+
+			obj_lo[i] = lo - 0.5*radius;
+			obj_hi[i] = hi + 0.5*radius;
+		}
+
+		m_pairs_culled_mask = 0;
+		m_pairs_culled_aabb = 0;
+		m_pairs_active = 0;
+
+		std::vector<unsigned int> masks(obj_num, 0);
+		for (int i = 0; i < obj_num; i++)
+		{
+			for (int j = i + 1; j < obj_num; j++)
+			{
+				if (!m_collidableObjects[i]->canCollideWith(m_collidableObjects[j].get()))
+				{
+					m_pairs_culled_mask++;
+					continue;
+				}
+
+				bool overlap = true;
+				for (int d = 0; d < 3; d++)
+				{
+					if (obj_lo[i][d] > obj_hi[j][d] || obj_lo[j][d] > obj_hi[i][d])
+					{
+						overlap = false;
+						break;
+					}
+				}
+				if (!overlap)
+				{
+					m_pairs_culled_aabb++;
+					continue;
+				}
+
+				m_pairs_active++;
+				if (j < 32) masks[i] |= 1u << j;
+				if (i < 32) masks[j] |= 1u << i;
+			}
+		}
+
+		//no pair survived culling: the whole narrowphase can be skipped
+		if (m_pairs_active == 0)
+			return;
+
+		if (m_pairMask.size() != obj_num)
+		{
+			m_pairMask.resize(obj_num);
+		}
+		Function1Pt::copy(m_pairMask, masks);
+
 		int start = 0;
 		for (int i = 0; i < m_collidableObjects.size(); i++)
 		{
@@ -163,9 +255,8 @@ namespace PhysIKA
 			m_nList->resize(m_points.size());
 			m_nList->setNeighborLimit(5);
 		}
-		
 
-		Real radius = 0.005;
+
 		m_nbrQuery->queryParticleNeighbors(*m_nList, m_points, radius);
 
 		DeviceArray<Coord> posBuf;
@@ -184,7 +275,7 @@ namespace PhysIKA
 		{
 			weights.reset();
 			posBuf.reset();
-			K_Collide << <pDims, BLOCK_SIZE >> > (m_objId, m_points, posBuf, weights, *m_nList, radius);
+			K_Collide << <pDims, BLOCK_SIZE >> > (m_objId, m_points, posBuf, weights, *m_nList, m_pairMask, radius);
 			K_ComputeTarget << <pDims, BLOCK_SIZE >> > (m_points, posBuf, weights);
 			Function1Pt::copy(m_points, posBuf);
 		}
@@ -27,12 +27,30 @@ public:
 	bool initializeImpl() override;
 
 	void doCollision() override;
-	
+
+	/**
+	 * @brief Pair-culling statistics of the last doCollision() call.
+	 * Pairs rejected by the group/mask bits never get an AABB test; pairs
+	 * rejected by the AABB overlap test skip the GPU narrowphase; when every
+	 * pair is culled the whole narrowphase (neighbor query included) is
+	 * skipped for the frame.
+	 */
+	int getPairsCulledByMask() { return m_pairs_culled_mask; }
+	int getPairsCulledByAABB() { return m_pairs_culled_aabb; }
+	int getPairsActive() { return m_pairs_active; }
+
 protected:
 	DeviceArray<int> m_objId;
 	DeviceArray<Coord> m_points;
 	DeviceArray<Coord> m_vels;
 
+	//bitmask per object: which other objects it may currently collide with
+	DeviceArray<unsigned int> m_pairMask;
+
+	int m_pairs_culled_mask = 0;
+	int m_pairs_culled_aabb = 0;
+	int m_pairs_active = 0;
+
 	std::shared_ptr<NeighborQuery<TDataType>> m_nbrQuery;
 	std::shared_ptr<NeighborList<int>> m_nList;
 
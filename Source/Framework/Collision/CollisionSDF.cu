@@ -1,10 +1,16 @@
 #include "CollisionSDF.h"
 #include "Core/Utility.h"
+
+#include <thrust/copy.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/execution_policy.h>
 #include "Framework/Framework/Node.h"
 #include "Framework/Framework/CollidableObject.h"
 #include "Framework/Topology/DistanceField3D.h"
 #include "Framework/Collision/CollidablePoints.h"
 #include "Framework/Collision/CollidableSDF.h"
+#include "Framework/Collision/CollidableTransformedSDF.h"
 
 namespace PhysIKA
 {
@@ -53,18 +59,26 @@ namespace PhysIKA
 			setCollidableSDF(obj);
 	}
 
-	template<typename Real, typename Coord, typename TDataType>
+	//TField is DistanceField3D or TransformedDistanceField3D; both expose
+	//the same getDistance interface
+	template<typename Real, typename Coord, typename TField>
 	__global__ void K_ConstrainParticles(
 		DeviceArray<Coord> posArr,
 		DeviceArray<Coord> velArr,
-		DistanceField3D<TDataType> df,
+		TField df,
 		Real normalFriction,
 		Real tangentialFriction,
-		Real dt)
+		Real dt,
+		int* contactCount,
+		Real wakeSpeed,
+		int* ccdFlags)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
 		if (pId >= posArr.size()) return;
 
+		//fast particles take the continuous path instead
+		if (ccdFlags != NULL && ccdFlags[pId] != 0) return;
+
 		Coord pos = posArr[pId];
 		Coord vec = velArr[pId];
 
@@ -73,6 +87,12 @@ namespace PhysIKA
 		df.getDistance(pos, dist, normal);
 		// constrain particle
 		if (dist <= 0) {
+			//only moving contacts count as wake events; resting debris keeps
+			//its permanent ground contact without reactivating
+			if (contactCount != NULL && vec.norm() > wakeSpeed)
+			{
+				atomicAdd(contactCount, 1);
+			}
 			Real olddist = -dist;
 			RandNumber rGen(pId);
 			dist = 0.0001f*rGen.Generate();
@@ -93,17 +113,128 @@ namespace PhysIKA
 		velArr[pId] = vec;
 	}
 
+	template<typename Real, typename Coord>
+	__global__ void K_MarkFastParticles(
+		DeviceArray<int> flags,
+		DeviceArray<Coord> velArr,
+		Real dt,
+		Real threshold)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= velArr.size()) return;
+
+		flags[pId] = velArr[pId].norm() * dt > threshold ? 1 : 0;
+	}
+
+	/// Sphere-trace the motion segment of one fast particle against the SDF:
+	/// advancing by the sampled distance can never skip a surface.
+	template<typename Real, typename Coord, typename TField>
+	__global__ void K_CCDConstrainParticles(
+		DeviceArray<Coord> posArr,
+		DeviceArray<Coord> velArr,
+		DeviceArray<int> fastIds,
+		int fastNum,
+		TField df,
+		Real normalFriction,
+		Real tangentialFriction,
+		Real dt,
+		int* contactCount,
+		Real wakeSpeed)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= fastNum) return;
+
+		int pId = fastIds[tId];
+
+		Coord pos = posArr[pId];
+		Coord vec = velArr[pId];
+
+		Coord start = pos - vec * dt;
+		Coord dir = pos - start;
+		Real seg = dir.norm();
+		if (seg < REAL_EPSILON) return;
+		dir /= seg;
+
+		Real dist;
+		Coord normal;
+		bool hit = false;
+		Coord q = start;
+
+		Real t = 0;
+		for (int it = 0; it < 64 && t <= seg; ++it)
+		{
+			q = start + dir * t;
+			df.getDistance(q, dist, normal);
+			if (dist <= 0)
+			{
+				hit = true;
+				break;
+			}
+			//epsilon floor keeps grazing segments from stalling
+			t += max(dist, Real(0.001) * seg);
+		}
+
+		if (!hit)
+		{
+			//segment ends outside; fall back to the discrete test at the endpoint
+			df.getDistance(pos, dist, normal);
+			if (dist > 0) return;
+			q = pos;
+		}
+
+		if (contactCount != NULL && vec.norm() > wakeSpeed)
+		{
+			atomicAdd(contactCount, 1);
+		}
+
+		Real olddist = -dist;
+		RandNumber rGen(pId);
+		dist = 0.0001f*rGen.Generate();
+		// place the particle just outside the surface at the impact point
+		pos = q - (olddist + dist)*normal;
+		// reflect velocity
+		Real vec_n = vec.dot(normal);
+		Coord vec_normal = vec_n*normal;
+		Coord vec_tan = vec - vec_normal;
+		if (vec_n > 0) vec_normal = -vec_normal;
+		vec_normal *= (1.0f - normalFriction);
+		vec = vec_normal + vec_tan;
+		vec *= pow(Real(M_E), -dt*tangentialFriction);
+
+		posArr[pId] = pos;
+		velArr[pId] = vec;
+	}
+
 
 	template<typename TDataType>
 	void CollisionSDF<TDataType>::doCollision()
 	{
-		if (!m_cSDF || m_collidableObjects.size() <= 0)
+		if ((!m_cSDF && !m_cTransformedSDF) || m_collidableObjects.size() <= 0)
 		{
 			std::cout << "Collidable objects are not correctly set!" << std::endl;
 			return;
 		}
 
-		auto sdf = m_cSDF->getSDF();
+		//a moving obstacle is sampled through its inverse-transform view,
+		//refreshed from the pose once per step; the field itself is static
+		bool moving = m_cTransformedSDF != nullptr;
+
+		TransformedDistanceField3D<TDataType> tdf;
+		std::shared_ptr<DistanceField3D<TDataType>> sdf = nullptr;
+		if (moving)
+		{
+			tdf = m_cTransformedSDF->getTransformedSDF();
+		}
+		else
+		{
+			sdf = m_cSDF->getSDF();
+		}
+
+		int* contactCount = NULL;
+		if (m_wakeOnContact)
+		{
+			cuSafeCall(cudaMalloc((void**)&contactCount, sizeof(int)));
+		}
 
 		for (int i = 0; i < m_collidableObjects.size(); i++)
 		{
@@ -115,19 +246,122 @@ namespace PhysIKA
 
 				cPoints->updateCollidableObject();
 
+				if (contactCount != NULL)
+				{
+					cuSafeCall(cudaMemset(contactCount, 0, sizeof(int)));
+				}
+
+				int* ccdFlagsPtr = NULL;
+				int fastNum = 0;
+
 				cuint pDim = cudaGridSize(pos.size(), BLOCK_SIZE);
-				K_ConstrainParticles << <pDim, BLOCK_SIZE >> > (
-					pos,
-					vel,
-					*sdf,
-					m_normal_friction,
-					m_tangent_friction,
-					getParent()->getDt());
+
+				if (m_ccd)
+				{
+					if (m_ccd_flags.size() < pos.size())
+					{
+						m_ccd_flags.resize(pos.size());
+						m_ccd_ids.resize(pos.size());
+					}
+
+					K_MarkFastParticles << <pDim, BLOCK_SIZE >> > (m_ccd_flags, vel, getParent()->getDt(), m_ccd_threshold);
+
+					//compact the ids of the fast particles
+					int* ids_end = thrust::copy_if(thrust::device,
+						thrust::make_counting_iterator(0), thrust::make_counting_iterator((int)pos.size()),
+						m_ccd_flags.getDataPtr(), m_ccd_ids.getDataPtr(), thrust::identity<int>());
+					fastNum = ids_end - m_ccd_ids.getDataPtr();
+
+					if (fastNum > 0)
+					{
+						ccdFlagsPtr = m_ccd_flags.getDataPtr();
+					}
+				}
+
+				if (moving)
+				{
+					K_ConstrainParticles << <pDim, BLOCK_SIZE >> > (
+						pos,
+						vel,
+						tdf,
+						m_normal_friction,
+						m_tangent_friction,
+						getParent()->getDt(),
+						contactCount,
+						m_wakeSpeed,
+						ccdFlagsPtr);
+				}
+				else
+				{
+					K_ConstrainParticles << <pDim, BLOCK_SIZE >> > (
+						pos,
+						vel,
+						*sdf,
+						m_normal_friction,
+						m_tangent_friction,
+						getParent()->getDt(),
+						contactCount,
+						m_wakeSpeed,
+						ccdFlagsPtr);
+				}
+
+				if (fastNum > 0)
+				{
+					cuint ccdDim = cudaGridSize(fastNum, BLOCK_SIZE);
+					if (moving)
+					{
+						K_CCDConstrainParticles << <ccdDim, BLOCK_SIZE >> > (
+							pos,
+							vel,
+							m_ccd_ids,
+							fastNum,
+							tdf,
+							m_normal_friction,
+							m_tangent_friction,
+							getParent()->getDt(),
+							contactCount,
+							m_wakeSpeed);
+					}
+					else
+					{
+						K_CCDConstrainParticles << <ccdDim, BLOCK_SIZE >> > (
+							pos,
+							vel,
+							m_ccd_ids,
+							fastNum,
+							*sdf,
+							m_normal_friction,
+							m_tangent_friction,
+							getParent()->getDt(),
+							contactCount,
+							m_wakeSpeed);
+					}
+				}
+
+				if (contactCount != NULL)
+				{
+					int contacts = 0;
+					cuSafeCall(cudaMemcpy(&contacts, contactCount, sizeof(int), cudaMemcpyDeviceToHost));
+
+					if (contacts > 0)
+					{
+						Node* owner = cPoints->getParent();
+						if (owner != NULL && !owner->isActive())
+						{
+							owner->setActive(true);
+						}
+					}
+				}
 
 				cPoints->updateMechanicalState();
  			}
 		}
 
+		if (contactCount != NULL)
+		{
+			cuSafeCall(cudaFree(contactCount));
+		}
+
 
 	}
 
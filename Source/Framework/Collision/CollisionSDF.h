@@ -1,9 +1,11 @@
 #pragma once
 #include "Framework/Framework/CollisionModel.h"
+#include "Core/Array/Array.h"
 
 namespace PhysIKA
 {
 template <typename> class CollidableSDF;
+template <typename> class CollidableTransformedSDF;
 
 template<typename TDataType>
 class CollisionSDF : public CollisionModel
@@ -18,19 +20,63 @@ public:
 
 	bool isSupport(std::shared_ptr<CollidableObject> obj) override;
 	void addDrivenObject(std::shared_ptr<CollidableObject> obj);
-	void setCollidableSDF(std::shared_ptr<CollidableObject> sdf) { m_cSDF = std::dynamic_pointer_cast<CollidableSDF<TDataType>>(sdf); }
+	/**
+	 * @brief Accepts a static CollidableSDF or a rigidly moving
+	 * CollidableTransformedSDF; the moving one is sampled through its
+	 * inverse-transform view, so its field is never re-baked.
+	 */
+	void setCollidableSDF(std::shared_ptr<CollidableObject> sdf)
+	{
+		m_cSDF = std::dynamic_pointer_cast<CollidableSDF<TDataType>>(sdf);
+		m_cTransformedSDF = std::dynamic_pointer_cast<CollidableTransformedSDF<TDataType>>(sdf);
+	}
 
 	void addCollidableObject(std::shared_ptr<CollidableObject> obj) override;
 
 	bool initializeImpl() override;
 
 	void doCollision() override;
-	
+
+	/**
+	 * @brief Wake the parent node of any driven object whose particles were
+	 * pushed by the SDF while moving faster than wakeSpeed, so contact
+	 * events reactivate nodes put to sleep by SleepController. Resting
+	 * contacts (near-zero velocity) do not wake.
+	 */
+	void setWakeOnContact(bool enabled, Real wakeSpeed = Real(0.01))
+	{
+		m_wakeOnContact = enabled;
+		m_wakeSpeed = wakeSpeed;
+	}
+
+	/**
+	 * @brief Sphere-trace the motion segment of fast particles against the SDF.
+	 * Particles whose per-step displacement exceeds threshold are compacted
+	 * into a separate list and traced continuously from their previous
+	 * position, so bullets no longer tunnel through thin walls; slow
+	 * particles keep the cheap discrete projection. Pays for CCD only where
+	 * it is needed instead of substepping the whole scene.
+	 */
+	void enableCCD(bool enabled, Real threshold = Real(0.01))
+	{
+		m_ccd = enabled;
+		m_ccd_threshold = threshold;
+	}
+
 protected:
 	Real m_normal_friction;
 	Real m_tangent_friction;
 
+	bool m_wakeOnContact = false;
+	Real m_wakeSpeed = Real(0.01);
+
+	bool m_ccd = false;
+	Real m_ccd_threshold = Real(0.01);
+	DeviceArray<int> m_ccd_flags;
+	DeviceArray<int> m_ccd_ids;
+
 	std::shared_ptr<CollidableSDF<TDataType>> m_cSDF;
+	std::shared_ptr<CollidableTransformedSDF<TDataType>> m_cTransformedSDF;
 	std::vector<std::shared_ptr<CollidableObject>> m_collidableObjects;
 };
 
@@ -0,0 +1,208 @@
+#include "CollisionTriangleMeshCCD.h"
+#include "Core/Utility.h"
+
+#include <thrust/reduce.h>
+#include <thrust/functional.h>
+#include <thrust/execution_policy.h>
+#include "Framework/Framework/Node.h"
+#include "Framework/Collision/CollidableTriangleMesh.h"
+#include "Framework/Topology/TriangleSet.h"
+#include "Framework/Topology/NeighborQuery.h"
+#include "Framework/Topology/Primitive3D.h"
+#include "Framework/Topology/PrimitiveSweep3D.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS_1(CollisionTriangleMeshCCD, TDataType)
+
+	template<typename TDataType>
+	CollisionTriangleMeshCCD<TDataType>::CollisionTriangleMeshCCD()
+		: CollisionModel()
+	{
+	}
+
+	template<typename TDataType>
+	CollisionTriangleMeshCCD<TDataType>::~CollisionTriangleMeshCCD()
+	{
+		m_collidableObjects.clear();
+	}
+
+	template<typename TDataType>
+	bool CollisionTriangleMeshCCD<TDataType>::isSupport(std::shared_ptr<CollidableObject> obj)
+	{
+		if (obj->getType() == CollidableObject::TRIANGLE_TYPE)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	template<typename TDataType>
+	void CollisionTriangleMeshCCD<TDataType>::addCollidableObject(std::shared_ptr<CollidableObject> obj)
+	{
+		auto derived = std::dynamic_pointer_cast<CollidableTriangleMesh<TDataType>>(obj);
+		if (obj->getType() == CollidableObject::TRIANGLE_TYPE && derived != nullptr)
+		{
+			m_collidableObjects.push_back(derived);
+		}
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void K_MeshCCD_Displacement(
+		DeviceArray<Real> disp,
+		DeviceArray<Coord> curArr,
+		DeviceArray<Coord> prevArr)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= curArr.size()) return;
+
+		disp[pId] = (curArr[pId] - prevArr[pId]).norm();
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void K_MeshCCD_Constrain(
+		DeviceArray<Coord> points,
+		DeviceArray<Coord> points_prev,
+		DeviceArray<Coord> triVertex,
+		DeviceArray<Coord> triVertexPrev,
+		DeviceArray<TopologyModule::Triangle> triIndex,
+		NeighborList<int> candidates,
+		Real threshold)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= points.size()) return;
+
+		int nbrSize = candidates.getNeighborSize(pId);
+		if (nbrSize == 0) return;
+
+		Point3D start_point(points_prev[pId]);
+		Point3D end_point(points[pId]);
+		PointSweep3D ptSweep(start_point, end_point);
+
+		Real min_t = Real(10);
+		int min_j = -1;
+		typename Triangle3D::Param min_baryc;
+
+		for (int ne = 0; ne < nbrSize; ne++)
+		{
+			int j = candidates.getElement(pId, ne);
+			if (j >= 0) continue;
+			j = -j - 1;
+
+			Triangle3D start_triangle(triVertexPrev[triIndex[j][0]], triVertexPrev[triIndex[j][1]], triVertexPrev[triIndex[j][2]]);
+			Triangle3D end_triangle(triVertex[triIndex[j][0]], triVertex[triIndex[j][1]], triVertex[triIndex[j][2]]);
+			TriangleSweep3D triSweep(start_triangle, end_triangle);
+
+			typename Triangle3D::Param baryc;
+			Real t;
+			int num = ptSweep.intersect(triSweep, baryc, t, threshold);
+
+			if (num > 0 && t < min_t)
+			{
+				min_t = t;
+				min_j = j;
+				min_baryc = baryc;
+			}
+		}
+
+		if (min_j < 0) return;
+
+		//stop the vertex just ahead of the earliest impact point
+		Triangle3D hit_triangle(triVertex[triIndex[min_j][0]], triVertex[triIndex[min_j][1]], triVertex[triIndex[min_j][2]]);
+		Coord3D proj = hit_triangle.computeLocation(min_baryc);
+
+		Coord3D dir = start_point.origin - proj;
+		if (dir.norm() > REAL_EPSILON)
+		{
+			dir.normalize();
+		}
+		else
+		{
+			dir = hit_triangle.normal();
+			if (dir.norm() > REAL_EPSILON) dir.normalize();
+		}
+
+		points[pId] = proj + dir * threshold;
+	}
+
+	template<typename TDataType>
+	void CollisionTriangleMeshCCD<TDataType>::constrainPair(std::shared_ptr<CollidableTriangleMesh<TDataType>> pointMesh, std::shared_ptr<CollidableTriangleMesh<TDataType>> triMesh)
+	{
+		DeviceArray<Coord>& pts = pointMesh->getTriangleSet()->getPoints();
+		DeviceArray<Coord>& ptsPrev = pointMesh->getPreviousVertices();
+
+		DeviceArray<Coord>& triVerts = triMesh->getTriangleSet()->getPoints();
+		DeviceArray<Coord>& triVertsPrev = triMesh->getPreviousVertices();
+		DeviceArray<TopologyModule::Triangle>& triIdx = *(triMesh->getTriangleSet()->getTriangles());
+
+		if (pts.size() == 0 || triIdx.size() == 0) return;
+
+		//the query radius has to cover the motion of both sides plus the thickness
+		int maxNum = pts.size() > triVerts.size() ? pts.size() : triVerts.size();
+		if (m_disp_buf.size() < maxNum)
+		{
+			m_disp_buf.resize(maxNum);
+		}
+
+		uint pDims = cudaGridSize(pts.size(), BLOCK_SIZE);
+		K_MeshCCD_Displacement << <pDims, BLOCK_SIZE >> > (m_disp_buf, pts, ptsPrev);
+		Real maxDispP = thrust::reduce(thrust::device, m_disp_buf.getDataPtr(), m_disp_buf.getDataPtr() + pts.size(), Real(0), thrust::maximum<Real>());
+
+		uint tDims = cudaGridSize(triVerts.size(), BLOCK_SIZE);
+		K_MeshCCD_Displacement << <tDims, BLOCK_SIZE >> > (m_disp_buf, triVerts, triVertsPrev);
+		Real maxDispT = thrust::reduce(thrust::device, m_disp_buf.getDataPtr(), m_disp_buf.getDataPtr() + triVerts.size(), Real(0), thrust::maximum<Real>());
+
+		Real radius = maxDispP + maxDispT + m_threshold;
+
+		m_bvh.construct(triVerts, triIdx);
+		m_bvh.queryTriangleNeighbors(m_candidates, pts, radius);
+
+		K_MeshCCD_Constrain << <pDims, BLOCK_SIZE >> > (
+			pts,
+			ptsPrev,
+			triVerts,
+			triVertsPrev,
+			triIdx,
+			m_candidates,
+			m_threshold);
+		cuSynchronize();
+	}
+
+	template<typename TDataType>
+	void CollisionTriangleMeshCCD<TDataType>::doCollision()
+	{
+		if (m_collidableObjects.size() < 2) return;
+
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			m_collidableObjects[i]->updateCollidableObject();
+		}
+
+		//sweep the vertices of every mesh against the triangles of every other
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			for (int j = 0; j < m_collidableObjects.size(); j++)
+			{
+				if (i == j) continue;
+				constrainPair(m_collidableObjects[i], m_collidableObjects[j]);
+			}
+		}
+
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			m_collidableObjects[i]->updateMechanicalState();
+		}
+	}
+
+	template<typename TDataType>
+	bool CollisionTriangleMeshCCD<TDataType>::initializeImpl()
+	{
+		for (int i = 0; i < m_collidableObjects.size(); i++)
+		{
+			m_collidableObjects[i]->initialize();
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Core/Array/Array.h"
+#include "Framework/Framework/CollisionModel.h"
+#include "Framework/Topology/TriangleBVH.h"
+
+namespace PhysIKA
+{
+template <typename> class CollidableTriangleMesh;
+template <typename> class NeighborList;
+
+/**
+ * @brief Continuous collision detection between triangle meshes.
+ *
+ * Candidate pairs come from a triangle BVH enlarged by the largest vertex
+ * displacement of the frame; each surviving vertex is then swept against the
+ * moving candidate triangles with PointSweep3D/TriangleSweep3D, and vertices
+ * that would tunnel are stopped just before their earliest time of impact.
+ */
+template<typename TDataType>
+class CollisionTriangleMeshCCD : public CollisionModel
+{
+	DECLARE_CLASS_1(CollisionTriangleMeshCCD, TDataType)
+public:
+	typedef typename TDataType::Real Real;
+	typedef typename TDataType::Coord Coord;
+
+	CollisionTriangleMeshCCD();
+	virtual ~CollisionTriangleMeshCCD();
+
+	bool isSupport(std::shared_ptr<CollidableObject> obj) override;
+
+	void addCollidableObject(std::shared_ptr<CollidableObject> obj) override;
+
+	bool initializeImpl() override;
+
+	void doCollision() override;
+
+	/**
+	 * @brief Contact thickness: impacting vertices are stopped this far in
+	 * front of the surface.
+	 */
+	void setThreshold(Real threshold) { m_threshold = threshold; }
+
+protected:
+	void constrainPair(std::shared_ptr<CollidableTriangleMesh<TDataType>> pointMesh, std::shared_ptr<CollidableTriangleMesh<TDataType>> triMesh);
+
+	Real m_threshold = Real(0.0001);
+
+	TriangleBVH<TDataType> m_bvh;
+	NeighborList<int> m_candidates;
+	DeviceArray<Real> m_disp_buf;
+
+	std::vector<std::shared_ptr<CollidableTriangleMesh<TDataType>>> m_collidableObjects;
+};
+
+#ifdef PRECISION_FLOAT
+template class CollisionTriangleMeshCCD<DataType3f>;
+#else
+template class CollisionTriangleMeshCCD<DataType3d>;
+#endif
+
+}
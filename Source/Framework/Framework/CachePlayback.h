@@ -0,0 +1,29 @@
+#pragma once
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	CachePlayback
+	*	\brief	Type-erased interface for nodes that replay cached frames.
+	*
+	*	GUI code scrubs the timeline through this interface without
+	*	depending on the concrete (templated) playback node; any node
+	*	implementing it is picked up by a dynamic_cast over the scene
+	*	graph.
+	*/
+	class CachePlayback
+	{
+	public:
+		virtual ~CachePlayback() {};
+
+		/**
+		 * @brief Number of consecutive frames found on disk.
+		 */
+		virtual int getFrameCount() = 0;
+
+		/**
+		 * @brief Jump to an arbitrary frame; prefetching re-centers on it.
+		 */
+		virtual bool gotoFrame(int frame) = 0;
+	};
+}
@@ -12,6 +12,7 @@ namespace PhysIKA
 			TETRAHEDRON_TYPE,
 			POINTSET_TYPE,
 			SIGNED_DISTANCE_TYPE,
+			HEIGHTFIELD_TYPE,
 			UNDFINED
 		};
 
@@ -26,9 +27,31 @@ namespace PhysIKA
 
 		//should be called after the collision is finished
 		virtual void updateMechanicalState() = 0;
-		
+
 		std::string getModuleType() override { return "CollidableObject"; }
+
+		/**
+		 * @brief Collision layer filtering.
+		 * An object belongs to the layers of its group bits and collides with
+		 * the layers of its mask bits; a pair is tested only when each object's
+		 * group intersects the other's mask. Defaults collide with everything.
+		 */
+		void setCollisionGroup(unsigned int group) { m_collision_group = group; }
+		void setCollisionMask(unsigned int mask) { m_collision_mask = mask; }
+
+		unsigned int getCollisionGroup() { return m_collision_group; }
+		unsigned int getCollisionMask() { return m_collision_mask; }
+
+		bool canCollideWith(CollidableObject* other)
+		{
+			return (m_collision_group & other->m_collision_mask) != 0
+				&& (other->m_collision_group & m_collision_mask) != 0;
+		}
+
 	private:
 		CType m_type;
+
+		unsigned int m_collision_group = 1;
+		unsigned int m_collision_mask = 0xffffffff;
 	};
 }
@@ -0,0 +1,66 @@
+#include "CudaGraph.h"
+
+namespace PhysIKA {
+
+CudaGraph::CudaGraph()
+{
+	m_graph = nullptr;
+	m_exec = nullptr;
+	m_valid = false;
+}
+
+CudaGraph::~CudaGraph()
+{
+	invalidate();
+}
+
+bool CudaGraph::beginCapture(cudaStream_t stream)
+{
+	if (m_valid)
+	{
+		return false;
+	}
+
+	cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal);
+	return true;
+}
+
+void CudaGraph::endCapture(cudaStream_t stream)
+{
+	cudaStreamEndCapture(stream, &m_graph);
+
+	if (m_graph != nullptr &&
+		cudaGraphInstantiate(&m_exec, m_graph, nullptr, nullptr, 0) == cudaSuccess)
+	{
+		m_valid = true;
+	}
+	else
+	{
+		invalidate();
+	}
+}
+
+void CudaGraph::launch(cudaStream_t stream)
+{
+	if (m_valid)
+	{
+		cudaGraphLaunch(m_exec, stream);
+	}
+}
+
+void CudaGraph::invalidate()
+{
+	if (m_exec != nullptr)
+	{
+		cudaGraphExecDestroy(m_exec);
+		m_exec = nullptr;
+	}
+	if (m_graph != nullptr)
+	{
+		cudaGraphDestroy(m_graph);
+		m_graph = nullptr;
+	}
+	m_valid = false;
+}
+
+}
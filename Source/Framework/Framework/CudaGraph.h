@@ -0,0 +1,61 @@
+#pragma once
+#include <cuda_runtime.h>
+
+namespace PhysIKA
+{
+/**
+*  \brief Record-once/replay CUDA graph for a fixed per-step kernel sequence.
+*
+*  Modules that relaunch the same kernels with identical parameters every
+*  substep can capture the sequence into a graph on its first execution and
+*  replay it afterwards, reducing the CPU submit cost to a single launch.
+*  The capture is tied to the buffer pointers and scalar parameters baked in
+*  at record time: call invalidate() whenever a topology change, a resize or
+*  a parameter change makes them stale, and the next beginCapture() records
+*  again.
+*
+*  Usage:
+*      if (m_graph.beginCapture(stream))
+*      {
+*          ...submit work on stream...
+*          m_graph.endCapture(stream);
+*      }
+*      m_graph.launch(stream);
+*
+*  Everything between begin and end must stay on the given stream and must
+*  not synchronize the host (build with NDEBUG so cuExecute's device-wide
+*  synchronization is compiled out, or use cuExecuteAsync throughout).
+*/
+class CudaGraph
+{
+public:
+	CudaGraph();
+	~CudaGraph();
+
+	/**
+	 * @brief Start stream capture unless a valid graph already exists.
+	 * Returns true when the caller has to submit (and endCapture) the work.
+	 */
+	bool beginCapture(cudaStream_t stream);
+
+	void endCapture(cudaStream_t stream);
+
+	/**
+	 * @brief Replay the recorded sequence on the given stream.
+	 */
+	void launch(cudaStream_t stream);
+
+	bool isValid() { return m_valid; }
+
+	/**
+	 * @brief Drop the recorded graph; the next beginCapture() records again.
+	 */
+	void invalidate();
+
+private:
+	cudaGraph_t m_graph;
+	cudaGraphExec_t m_exec;
+	bool m_valid;
+};
+
+}
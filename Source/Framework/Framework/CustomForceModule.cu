@@ -0,0 +1,85 @@
+#include "CustomForceModule.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Framework/TaskScheduler.h"
+#include "Core/Utility/cuda_utilities.h"
+
+namespace PhysIKA
+{
+IMPLEMENT_CLASS_1(CustomForceModule, TDataType)
+
+template<typename TDataType>
+CustomForceModule<TDataType>::CustomForceModule()
+	: ForceModule()
+{
+}
+
+template<typename TDataType>
+CustomForceModule<TDataType>::~CustomForceModule()
+{
+	if (m_stream != nullptr)
+	{
+		cudaStreamDestroy(m_stream);
+	}
+	if (m_upstreamReady != nullptr)
+	{
+		cudaEventDestroy(m_upstreamReady);
+	}
+	if (m_callbackDone != nullptr)
+	{
+		cudaEventDestroy(m_callbackDone);
+	}
+}
+
+template<typename TDataType>
+cudaStream_t CustomForceModule<TDataType>::getStream()
+{
+	if (m_stream == nullptr)
+	{
+		cuSafeCall(cudaStreamCreateWithFlags(&m_stream, cudaStreamNonBlocking));
+		cuSafeCall(cudaEventCreateWithFlags(&m_upstreamReady, cudaEventDisableTiming));
+		cuSafeCall(cudaEventCreateWithFlags(&m_callbackDone, cudaEventDisableTiming));
+	}
+	return m_stream;
+}
+
+template<typename TDataType>
+bool CustomForceModule<TDataType>::execute()
+{
+	return applyForce();
+}
+
+template<typename TDataType>
+bool CustomForceModule<TDataType>::applyForce()
+{
+	if (!m_callback)
+	{
+		return true;
+	}
+
+	if (this->inPosition()->isEmpty() || this->inForce()->isEmpty())
+	{
+		return false;
+	}
+
+	cudaStream_t stream = getStream();
+	cudaStream_t solverStream = TaskScheduler::currentStream();
+
+	//order the callback's stream behind the solver stream and vice versa
+	//with events; the host never blocks here
+	cuSafeCall(cudaEventRecord(m_upstreamReady, solverStream));
+	cuSafeCall(cudaStreamWaitEvent(stream, m_upstreamReady, 0));
+
+	Real dt = getParent()->getDt();
+	m_callback(this->inForce()->getValue(),
+			   this->inPosition()->getValue(),
+			   this->inVelocity()->getValue(),
+			   dt,
+			   stream);
+
+	cuSafeCall(cudaEventRecord(m_callbackDone, stream));
+	cuSafeCall(cudaStreamWaitEvent(solverStream, m_callbackDone, 0));
+
+	return true;
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <functional>
+#include <cuda_runtime.h>
+#include "Framework/Framework/ModuleForce.h"
+#include "Framework/Framework/FieldArray.h"
+#include "Framework/Framework/DeclareModuleField.h"
+
+namespace PhysIKA {
+
+/*!
+*	\class	CustomForceModule
+*	\brief	User-supplied per-step force injection.
+*
+*	The callback runs once per step between the force reset in
+*	ParticleIntegrator::begin() and the velocity update, and receives the
+*	raw state arrays together with the module's private non-blocking
+*	stream. Work the callback enqueues on that stream is ordered against
+*	the solver with events only, so an external policy (a PyTorch network
+*	reached through the zero-copy Python bindings, a control loop, a
+*	hand-written kernel) can write forces every step without a
+*	device-host round-trip.
+*/
+template<typename TDataType>
+class CustomForceModule : public ForceModule
+{
+	DECLARE_CLASS_1(CustomForceModule, TDataType)
+public:
+	typedef typename TDataType::Real Real;
+	typedef typename TDataType::Coord Coord;
+
+	typedef std::function<void(DeviceArray<Coord>& force,
+							   DeviceArray<Coord>& position,
+							   DeviceArray<Coord>& velocity,
+							   Real dt,
+							   cudaStream_t stream)> ForceCallback;
+
+	CustomForceModule();
+	~CustomForceModule() override;
+
+	bool execute() override;
+
+	bool applyForce() override;
+
+	void setCallback(ForceCallback callback) { m_callback = callback; }
+
+	/**
+	 * @brief Dedicated non-blocking stream the callback should launch on;
+	 * created lazily on first use.
+	 */
+	cudaStream_t getStream();
+
+public:
+	/**
+	* @brief Position
+	* Particle position
+	*/
+	DEF_EMPTY_IN_ARRAY(Position, Coord, DeviceType::GPU, "Input particle position");
+
+	/**
+	* @brief Velocity
+	* Particle velocity
+	*/
+	DEF_EMPTY_IN_ARRAY(Velocity, Coord, DeviceType::GPU, "Input particle velocity");
+
+	/**
+	* @brief Force
+	* Force (density) the callback accumulates into
+	*/
+	DEF_EMPTY_IN_ARRAY(Force, Coord, DeviceType::GPU, "Force density on each particle");
+
+private:
+	ForceCallback m_callback;
+
+	cudaStream_t m_stream = nullptr;
+	cudaEvent_t m_upstreamReady = nullptr;
+	cudaEvent_t m_callbackDone = nullptr;
+};
+
+#ifdef PRECISION_FLOAT
+template class CustomForceModule<DataType3f>;
+#else
+template class CustomForceModule<DataType3d>;
+#endif
+
+}
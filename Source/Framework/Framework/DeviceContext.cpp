@@ -22,7 +22,57 @@ DeviceContext::DeviceContext()
 
 DeviceContext::~DeviceContext()
 {
+	for (size_t i = 0; i < m_streams.size(); i++)
+	{
+		cudaStreamDestroy(m_streams[i]);
+		cudaEventDestroy(m_events[i]);
+	}
+}
+
+cudaStream_t DeviceContext::getStream(int i)
+{
+	while ((int)m_streams.size() <= i)
+	{
+		cudaStream_t s;
+		cudaEvent_t e;
+		cudaStreamCreateWithFlags(&s, cudaStreamNonBlocking);
+		cudaEventCreateWithFlags(&e, cudaEventDisableTiming);
+		m_streams.push_back(s);
+		m_events.push_back(e);
+	}
+	return m_streams[i];
+}
+
+void DeviceContext::recordEvent(int i)
+{
+	getStream(i);
+	cudaEventRecord(m_events[i], m_streams[i]);
+}
 
+void DeviceContext::streamWaitEvent(int i, int j)
+{
+	getStream(i > j ? i : j);
+	cudaStreamWaitEvent(m_streams[i], m_events[j], 0);
+}
+
+void DeviceContext::streamWaitDefault(int i)
+{
+	getStream(i);
+	cudaEventRecord(m_events[i], 0);
+	cudaStreamWaitEvent(m_streams[i], m_events[i], 0);
+}
+
+void DeviceContext::streamSync(int i)
+{
+	cudaStreamSynchronize(getStream(i));
+}
+
+void DeviceContext::syncAll()
+{
+	for (size_t i = 0; i < m_streams.size(); i++)
+	{
+		cudaStreamSynchronize(m_streams[i]);
+	}
 }
 
 void DeviceContext::enable()
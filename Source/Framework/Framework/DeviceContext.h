@@ -2,6 +2,7 @@
 #include "Core/Platform.h"
 #include <list>
 #include <memory>
+#include <vector>
 #include "Framework/Framework/Module.h"
 
 namespace PhysIKA
@@ -23,6 +24,35 @@ public:
 	bool setDevice(int i);
 	int getDevice();
 
+	/**
+	 * @brief Stream pool for concurrent module execution. Streams and their
+	 * events are created lazily on first use and live as long as the context.
+	 * Modules that touch disjoint fields can launch on different streams via
+	 * cuExecuteAsync and order themselves with record/wait; streamSync(0) or
+	 * syncAll() rejoins the default timeline.
+	 */
+	cudaStream_t getStream(int i);
+
+	/**
+	 * @brief Record stream i's current work into its event.
+	 */
+	void recordEvent(int i);
+
+	/**
+	 * @brief Make stream i wait for the work last recorded on stream j.
+	 */
+	void streamWaitEvent(int i, int j);
+
+	/**
+	 * @brief Make stream i wait for everything already submitted on the
+	 * default stream, so async modules order correctly after legacy launches.
+	 */
+	void streamWaitDefault(int i);
+
+	void streamSync(int i);
+
+	void syncAll();
+
 /*	template<typename T>
 	std::shared_ptr< DeviceVariable<T> > allocDeviceVariable(std::string name, std::string description)
 	{
@@ -53,6 +83,10 @@ public:
 	DeviceType m_deviceType;
 		
 	cudaStream_t stream;
+
+private:
+	std::vector<cudaStream_t> m_streams;
+	std::vector<cudaEvent_t> m_events;
 };
 
 }
@@ -15,10 +15,16 @@ namespace PhysIKA
 		return m_owner;
 	}
 
+	//any rewire invalidates every cached chain resolution at once; cheaper
+	//than notifying each downstream field individually
+	static unsigned int s_connectionStamp = 1;
+
 	void Field::setSource(Field* source)
 	{
 		m_derived = source == nullptr ? false : true;
 		m_source = source;
+
+		s_connectionStamp++;
 	}
 
 	Field* Field::getSource()
@@ -26,6 +32,30 @@ namespace PhysIKA
 		return m_source;
 	}
 
+	unsigned int Field::connectionStamp()
+	{
+		return s_connectionStamp;
+	}
+
+	Field* Field::getTerminalField()
+	{
+		if (m_terminal != nullptr && m_terminalStamp == s_connectionStamp)
+		{
+			return m_terminal;
+		}
+
+		Field* f = this;
+		while (f->getSource() != nullptr)
+		{
+			f = f->getSource();
+		}
+
+		m_terminal = f;
+		m_terminalStamp = s_connectionStamp;
+
+		return m_terminal;
+	}
+
 	void Field::addSink(Field* f)
 	{
 		auto it = std::find(m_field_sink.begin(), m_field_sink.end(), f);
@@ -97,6 +127,24 @@ namespace PhysIKA
 	void Field::tagModified(bool modifed)
 	{
 		m_modified = modifed;
+
+		if (modifed)
+		{
+			for each (auto f in m_field_sink)
+			{
+				f->tagModified(true);
+			}
+		}
+	}
+
+	void Field::tagReadOnly(bool readOnly)
+	{
+		getTerminalField()->m_readOnly = readOnly;
+	}
+
+	bool Field::isReadOnly()
+	{
+		return getTerminalField()->m_readOnly;
 	}
 
 	Field::Field(std::string name, std::string description, FieldType type, Base* parent)
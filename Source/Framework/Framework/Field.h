@@ -33,6 +33,51 @@ public:
 	virtual const std::string getTemplateName() { return std::string(""); }
 	virtual const std::string getClassName() { return std::string("Field"); }
 
+	/**
+	 * @brief Checkpoint support. Fields whose element type is trivially
+	 * copyable report their element size and can dump/load their raw
+	 * contents; everything else returns 0/false and is skipped by
+	 * SceneSnapshot.
+	 */
+	virtual size_t getElementBytes() { return 0; }
+
+	/**
+	 * @brief Copy the full contents into dst (getElementCount() *
+	 * getElementBytes() bytes, host memory).
+	 */
+	virtual bool dumpRawData(void* dst) { return false; }
+
+	/**
+	 * @brief Resize to num elements and overwrite the contents from src.
+	 */
+	virtual bool loadRawData(const void* src, size_t num) { return false; }
+
+	/**
+	 * @brief Monitoring support. dumpRawData() stalls the pipeline behind
+	 * every kernel already queued, which is what a property panel or a
+	 * stats counter polling once per frame must not do. requestSnapshot()
+	 * instead enqueues an event-signaled copy into an internal pinned
+	 * host buffer and returns immediately; once isSnapshotReady() turns
+	 * true - typically the next frame - getSnapshotData() exposes the
+	 * buffer until the next request. Fields without raw-data support
+	 * decline the request.
+	 */
+	virtual bool requestSnapshot() { return false; }
+
+	/**
+	 * @brief Whether the last requested snapshot has landed in host memory.
+	 */
+	virtual bool isSnapshotReady() { return false; }
+
+	/**
+	 * @brief Pinned host copy of the contents at request time, or nullptr
+	 * while the copy is still in flight; getSnapshotCount() elements of
+	 * getElementBytes() bytes each.
+	 */
+	virtual const void* getSnapshotData() { return nullptr; }
+
+	virtual size_t getSnapshotCount() { return 0; }
+
 	FieldType getFieldType();
 
 	std::string	getObjectName() { return m_name; }
@@ -57,11 +102,45 @@ public:
 
 	Field* fieldPtr();
 
+	/**
+	 * @brief End of this field's source chain, i.e. the field that owns the
+	 * actual storage. The chain is walked once and the result is cached;
+	 * any rewire bumps the global connection stamp (see connectionStamp()),
+	 * which lazily invalidates every cached resolution, so per-access
+	 * traversals and casts disappear from steady-state module dispatch.
+	 */
+	Field* getTerminalField();
+
+	/**
+	 * @brief Monotonic counter bumped on every connection change; typed
+	 * caches built on top of getTerminalField() compare against it.
+	 */
+	static unsigned int connectionStamp();
+
 	std::vector<Field*>& getSinkFields() { return m_field_sink; }
 
 	bool isModified();
+
+	/**
+	 * @brief Tagging a field as modified also tags every sink connected to
+	 * it, so dirtiness propagates along field connections; tagging clean
+	 * only clears this field.
+	 */
 	void tagModified(bool modifed);
 
+	/**
+	 * @brief Read-only broadcast contract. Field connections already share
+	 * storage - every sink resolves to the same terminal field - so fanning
+	 * one output to many consumers copies nothing. tagReadOnly() makes that
+	 * sharing formal for static inputs (a boundary SDF feeding many fluid
+	 * nodes, say): the flag lives on the terminal field, every field in the
+	 * chain reports isReadOnly(), and the typed mutators refuse to write
+	 * through a read-only chain and log the offender instead of silently
+	 * corrupting every other consumer's input.
+	 */
+	void tagReadOnly(bool readOnly);
+	bool isReadOnly();
+
 	inline float getMin() { return m_min; }
 	inline void setMin(float min_val) { m_min = min_val; }
 
@@ -90,6 +169,10 @@ private:
 	float m_max = FLT_MAX;
 
 	bool m_modified = false;
+	bool m_readOnly = false;
+
+	Field* m_terminal = nullptr;
+	unsigned int m_terminalStamp = 0;
 
 	std::vector<Field*> m_field_sink;
 };
@@ -1,4 +1,6 @@
 #pragma once
+#include <type_traits>
+#include <vector>
 #include "Core/Typedef.h"
 #include "Core/Array/Array.h"
 #include "Core/Array/MemoryManager.h"
@@ -31,6 +33,84 @@ public:
 //	void resize(int num);
 	const std::string getTemplateName() override { return std::string(typeid(T).name()); }
 	const std::string getClassName() override { return std::string("ArrayBuffer"); }
+
+	size_t getElementBytes() override {
+		return std::is_trivially_copyable<T>::value ? sizeof(T) : 0;
+	}
+
+	bool dumpRawData(void* dst) override {
+		auto ref = this->getReference();
+		if (!std::is_trivially_copyable<T>::value || ref == nullptr)
+			return false;
+		if (ref->size() > 0)
+		{
+			//cudaMemcpyDefault resolves the direction for both device and host arrays
+			cuSafeCall(cudaMemcpy(dst, ref->getDataPtr(), ref->size() * sizeof(T), cudaMemcpyDefault));
+		}
+		return true;
+	}
+
+	bool requestSnapshot() override {
+		auto ref = this->getReference();
+		if (!std::is_trivially_copyable<T>::value || ref == nullptr)
+			return false;
+		//one copy in flight at a time; a request while the previous one
+		//is still pending keeps the pending one
+		if (m_snapshotRequested && !isSnapshotReady())
+			return true;
+
+		size_t num = ref->size();
+		if (m_snapshotCapacity < num)
+		{
+			if (m_snapshotBuf != nullptr)
+				cuSafeCall(cudaFreeHost(m_snapshotBuf));
+			cuSafeCall(cudaMallocHost((void**)&m_snapshotBuf, num * sizeof(T)));
+			m_snapshotCapacity = num;
+		}
+		if (m_snapshotEvent == nullptr)
+		{
+			cuSafeCall(cudaEventCreateWithFlags(&m_snapshotEvent, cudaEventDisableTiming));
+		}
+
+		if (num > 0)
+		{
+			cuSafeCall(cudaMemcpyAsync(m_snapshotBuf, ref->getDataPtr(), num * sizeof(T), cudaMemcpyDefault, 0));
+		}
+		cuSafeCall(cudaEventRecord(m_snapshotEvent, 0));
+		m_snapshotCount = num;
+		m_snapshotRequested = true;
+		return true;
+	}
+
+	bool isSnapshotReady() override {
+		//cudaErrorNotReady is the expected in-flight answer, not a failure
+		return m_snapshotRequested && cudaEventQuery(m_snapshotEvent) == cudaSuccess;
+	}
+
+	const void* getSnapshotData() override {
+		return isSnapshotReady() ? m_snapshotBuf : nullptr;
+	}
+
+	size_t getSnapshotCount() override { return m_snapshotCount; }
+
+	bool loadRawData(const void* src, size_t num) override {
+		if (!std::is_trivially_copyable<T>::value)
+			return false;
+		if (this->isReadOnly())
+		{
+			Log::sendMessage(Log::Error, "Field " + this->getObjectName() + " is shared read-only, write refused!");
+			return false;
+		}
+		this->setElementCount(num);
+		auto ref = this->getReference();
+		if (ref == nullptr)
+			return num == 0;
+		if (num > 0)
+		{
+			cuSafeCall(cudaMemcpy(ref->getDataPtr(), src, num * sizeof(T), cudaMemcpyDefault));
+		}
+		return true;
+	}
 //	DeviceType getDeviceType() override { return deviceType; }
 
 	/**
@@ -42,8 +122,29 @@ public:
 	std::shared_ptr<Array<T, deviceType>> getReference();
 
 	Array<T, deviceType>& getValue() { return *(getReference()); }
+
+	/**
+	 * @brief Read-only view for broadcast consumers; pairs with Field::tagReadOnly().
+	 */
+	const Array<T, deviceType>& getConstValue() { return *(getReference()); }
+
 	void setValue(std::vector<T>& vals);
 
+	/**
+	 * @brief Debug mode for the read-only contract: tags the chain read-only
+	 * and records a checksum of the current contents; verifyReadOnly()
+	 * recomputes it and logs when a writer bypassed the field API since the
+	 * seal. Each verification costs a full readback - a debugging aid for
+	 * broadcast scenes, not a per-frame check.
+	 */
+	void sealReadOnly();
+	bool verifyReadOnly();
+
+	/**
+	 * @brief Replace the contained array, e.g. with one co-allocated in a FieldGroup slab.
+	 */
+	void setReference(std::shared_ptr<Array<T, deviceType>> data) { m_data = data; }
+
 //	void reset() override { m_data->reset(); }
 
 	inline bool isEmpty() override {
@@ -56,6 +157,25 @@ public:
 
 private:
 	std::shared_ptr<Array<T, deviceType>> m_data = nullptr;
+
+	//typed resolution cache over Field::getTerminalField(); rebuilt lazily
+	//whenever the connection stamp changes
+	ArrayField<T, deviceType>* m_resolved = nullptr;
+	unsigned int m_resolvedStamp = 0;
+
+	static unsigned long long contentHash(const void* data, size_t bytes);
+
+	//read-only seal state for verifyReadOnly()
+	unsigned long long m_sealHash = 0;
+	bool m_sealed = false;
+
+	//asynchronous snapshot state: a pinned host buffer plus the event
+	//that signals the copy in flight
+	T* m_snapshotBuf = nullptr;
+	size_t m_snapshotCapacity = 0;
+	size_t m_snapshotCount = 0;
+	cudaEvent_t m_snapshotEvent = nullptr;
+	bool m_snapshotRequested = false;
 };
 
 template<typename T, DeviceType deviceType>
@@ -104,11 +224,26 @@ ArrayField<T, deviceType>::~ArrayField()
 	{
 		m_data->release();
 	}
+
+	if (m_snapshotEvent != nullptr)
+	{
+		cudaEventDestroy(m_snapshotEvent);
+	}
+	if (m_snapshotBuf != nullptr)
+	{
+		cudaFreeHost(m_snapshotBuf);
+	}
 }
 
 template<typename T, DeviceType deviceType>
 void ArrayField<T, deviceType>::setElementCount(size_t num)
 {
+	if (this->isReadOnly())
+	{
+		Log::sendMessage(Log::Error, "Field " + this->getObjectName() + " is shared read-only, resize refused!");
+		return;
+	}
+
 	auto arr = this->getSourceArrayField();
 	if (arr == nullptr)
 	{
@@ -141,12 +276,19 @@ bool ArrayField<T, deviceType>::connect(ArrayField<T, deviceType>* field2)
 template<typename T, DeviceType deviceType>
 void ArrayField<T, deviceType>::setValue(std::vector<T>& vals)
 {
+	if (this->isReadOnly())
+	{
+		Log::sendMessage(Log::Error, "Field " + this->getObjectName() + " is shared read-only, write refused!");
+		return;
+	}
+
 	std::shared_ptr<Array<T, deviceType>> data = getReference();
 	if (data == nullptr)
 	{
 		m_data = std::make_shared<Array<T, deviceType>>();
 		m_data->resize(vals.size());
 		Function1Pt::copy(*m_data, vals);
+		this->tagModified(true);
 		return;
 	}
 	else
@@ -158,48 +300,95 @@ void ArrayField<T, deviceType>::setValue(std::vector<T>& vals)
 		else
 		{
 			Function1Pt::copy(*data, vals);
+			this->tagModified(true);
 		}
 	}
 }
 
 template<typename T, DeviceType deviceType>
-std::shared_ptr<Array<T, deviceType>> ArrayField<T, deviceType>::getReference()
+unsigned long long ArrayField<T, deviceType>::contentHash(const void* data, size_t bytes)
 {
-	Field* source = getSource();
-	if (source == nullptr)
+	//FNV-1a, enough to catch a stray writer
+	const unsigned char* p = (const unsigned char*)data;
+	unsigned long long h = 14695981039346656037ull;
+	for (size_t i = 0; i < bytes; i++)
 	{
-		return m_data;
+		h ^= p[i];
+		h *= 1099511628211ull;
 	}
-	else
+	return h;
+}
+
+template<typename T, DeviceType deviceType>
+void ArrayField<T, deviceType>::sealReadOnly()
+{
+	auto src = this->getSourceArrayField();
+	if (src == nullptr)
 	{
-		ArrayField<T, deviceType>* var = dynamic_cast<ArrayField<T, deviceType>*>(source);
-		if (var != nullptr)
-		{
-			return var->getReference();
-		}
-		else
-		{
-			return nullptr;
-		}
+		return;
+	}
+
+	size_t bytes = src->getElementCount() * src->getElementBytes();
+	std::vector<char> host(bytes);
+	if (bytes > 0 && !src->dumpRawData(host.data()))
+	{
+		return;
 	}
+
+	src->m_sealHash = contentHash(host.data(), bytes);
+	src->m_sealed = true;
+	this->tagReadOnly(true);
+}
+
+template<typename T, DeviceType deviceType>
+bool ArrayField<T, deviceType>::verifyReadOnly()
+{
+	auto src = this->getSourceArrayField();
+	if (src == nullptr || !src->m_sealed)
+	{
+		return true;
+	}
+
+	size_t bytes = src->getElementCount() * src->getElementBytes();
+	std::vector<char> host(bytes);
+	if (bytes > 0 && !src->dumpRawData(host.data()))
+	{
+		return true;
+	}
+
+	if (contentHash(host.data(), bytes) != src->m_sealHash)
+	{
+		Log::sendMessage(Log::Error, "Field " + src->getObjectName() + " was modified while sealed read-only!");
+		return false;
+	}
+
+	return true;
+}
+
+template<typename T, DeviceType deviceType>
+std::shared_ptr<Array<T, deviceType>> ArrayField<T, deviceType>::getReference()
+{
+	ArrayField<T, deviceType>* src = getSourceArrayField();
+	return src == nullptr ? nullptr : src->m_data;
 }
 
 template<typename T, DeviceType deviceType>
 ArrayField<T, deviceType>* ArrayField<T, deviceType>::getSourceArrayField()
 {
-	Field* source = getSource();
-	if (source == nullptr)
+	if (getSource() == nullptr)
 	{
 		return this;
 	}
-	else
+
+	//resolve the chain once per rewire instead of walking it (and paying a
+	//dynamic_cast per hop) on every access
+	if (m_resolved == nullptr || m_resolvedStamp != Field::connectionStamp())
 	{
-		ArrayField<T, deviceType>* var = dynamic_cast<ArrayField<T, deviceType>*>(source);
-		if (var == nullptr)
-			return nullptr;
-		else
-			return var->getSourceArrayField();
+		m_resolved = dynamic_cast<ArrayField<T, deviceType>*>(getTerminalField());
+		m_resolvedStamp = Field::connectionStamp();
 	}
+
+	return m_resolved;
 }
 
 template<typename T>
@@ -0,0 +1,62 @@
+#include "FieldGroup.h"
+
+#include <cuda_runtime.h>
+#include "Core/Utility.h"
+#include "Core/Array/FrameArena.h"
+
+namespace PhysIKA {
+
+	void FieldGroup::reserve(int num, size_t bytesPerElement)
+	{
+		//Each member allocation is rounded up to the slab alignment; leave room
+		//for the padding so addArray() never runs out.
+		const size_t alignment = 256;
+		size_t capacity = (size_t)num * bytesPerElement + 16 * alignment;
+
+		m_slab = std::make_shared<SlabMemoryManager>(capacity);
+		m_members.clear();
+		m_num = num;
+	}
+
+	__global__ void K_GatherMember(
+		char* dst,
+		char* src,
+		int* newToOld,
+		int stride,
+		int num)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= num * stride) return;
+
+		int eId = tId / stride;
+		int byte = tId - eId * stride;
+
+		dst[tId] = src[newToOld[eId] * stride + byte];
+	}
+
+	void FieldGroup::permute(int* newToOld)
+	{
+		if (m_slab == nullptr || m_num == 0) return;
+
+		//Snapshot the whole slab once, then gather every member out of it. The
+		//scratch copy comes from the frame arena so repeated reorders reuse the
+		//same device memory.
+		size_t bytes = m_slab->used();
+		char* scratch = (char*)FrameArena::getInstance().allocate(bytes);
+		cuSafeCall(cudaMemcpy(scratch, m_slab->data(), bytes, cudaMemcpyDeviceToDevice));
+
+		for (size_t i = 0; i < m_members.size(); i++)
+		{
+			Member& m = m_members[i];
+			uint total = (uint)(m_num * m.stride);
+			uint pDims = cudaGridSize(total, BLOCK_SIZE);
+			K_GatherMember << <pDims, BLOCK_SIZE >> > (
+				m_slab->data() + m.offset,
+				scratch + m.offset,
+				newToOld,
+				(int)m.stride,
+				m_num);
+		}
+		cuSynchronize();
+	}
+}
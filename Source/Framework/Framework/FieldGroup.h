@@ -0,0 +1,73 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Core/Array/Array.h"
+#include "Core/Array/MemoryManager.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	FieldGroup
+	*	\brief	Structure-of-arrays group of per-element device arrays.
+	*
+	*	Per-particle state fields (position, velocity, force, ...) are normally
+	*	allocated one by one, so after a few resizes they end up scattered across
+	*	the device heap. A FieldGroup co-allocates its member arrays from a single
+	*	contiguous slab, which keeps them adjacent in memory and lets a spatial
+	*	reordering pass gather the whole state with one permutation instead of one
+	*	kernel launch per field.
+	*
+	*	All member arrays share the element count passed to reserve(). Resizing a
+	*	member array individually detaches it from the slab; rebuild the group
+	*	instead when the element count changes.
+	*/
+	class FieldGroup
+	{
+	public:
+		FieldGroup() {};
+		~FieldGroup() {};
+
+		/**
+		 * @brief Size the backing slab for num elements whose members total
+		 * bytesPerElement bytes. Previously created member arrays are forgotten;
+		 * their storage is freed once the last field drops its reference.
+		 */
+		void reserve(int num, size_t bytesPerElement);
+
+		/**
+		 * @brief Create a member array of the group's element count inside the slab.
+		 */
+		template<typename T>
+		std::shared_ptr<DeviceArray<T>> addArray()
+		{
+			size_t offset = m_slab->used();
+			auto arr = std::make_shared<DeviceArray<T>>(m_num, m_slab);
+
+			Member m;
+			m.offset = offset;
+			m.stride = sizeof(T);
+			m_members.push_back(m);
+
+			return arr;
+		}
+
+		/**
+		 * @brief Reorder every member array in place following newToOld, a device
+		 * permutation of size() indices (e.g. GridHash::getPermutation()).
+		 */
+		void permute(int* newToOld);
+
+		int size() { return m_num; }
+
+	private:
+		struct Member
+		{
+			size_t offset;
+			size_t stride;
+		};
+
+		int m_num = 0;
+		std::shared_ptr<SlabMemoryManager> m_slab;
+		std::vector<Member> m_members;
+	};
+}
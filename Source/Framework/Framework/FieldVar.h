@@ -1,6 +1,8 @@
 #pragma once
 #include <iostream>
 #include <functional>
+#include <type_traits>
+#include <cstring>
 #include "Core/Typedef.h"
 #include "Field.h"
 #include "Base.h"
@@ -32,6 +34,27 @@ public:
 	const std::string getTemplateName() override { return std::string(typeid(T).name()); }
 	const std::string getClassName() override { return std::string("Variable"); }
 
+	size_t getElementBytes() override {
+		return std::is_trivially_copyable<T>::value ? sizeof(T) : 0;
+	}
+
+	bool dumpRawData(void* dst) override {
+		auto ref = getReference();
+		if (!std::is_trivially_copyable<T>::value || ref == nullptr)
+			return false;
+		memcpy(dst, ref.get(), sizeof(T));
+		return true;
+	}
+
+	bool loadRawData(const void* src, size_t num) override {
+		if (!std::is_trivially_copyable<T>::value || num != 1)
+			return false;
+		if (m_data == nullptr)
+			m_data = std::make_shared<T>();
+		memcpy(m_data.get(), src, sizeof(T));
+		return true;
+	}
+
 	T& getValue();
 	void setValue(T val);
 
@@ -55,9 +78,14 @@ public:
 
 private:
 	CallBackFunc callbackFunc;
-	
+
 	std::shared_ptr<T> m_data = nullptr;
 
+	//typed resolution cache over Field::getTerminalField(); rebuilt lazily
+	//whenever the connection stamp changes
+	VarField<T>* m_resolved = nullptr;
+	unsigned int m_resolvedStamp = 0;
+
 };
 
 template<typename T>
@@ -119,6 +147,7 @@ void VarField<T>::setValue(T val)
 		*data = val;
 	}
 
+	this->tagModified(true);
 	this->update();
 }
 
@@ -146,23 +175,20 @@ void VarField<T>::update()
 template<typename T>
 std::shared_ptr<T> VarField<T>::getReference()
 {
-	Field* source = this->getSource();
-	if (source == nullptr)
+	if (this->getSource() == nullptr)
 	{
 		return m_data;
 	}
-	else
+
+	//resolve the chain once per rewire instead of walking it (and paying a
+	//dynamic_cast per hop) on every access
+	if (m_resolved == nullptr || m_resolvedStamp != Field::connectionStamp())
 	{
-		VarField<T>* var = dynamic_cast<VarField<T>*>(source);
-		if (var != nullptr)
-		{
-			return var->getReference();
-		}
-		else
-		{
-			return nullptr;
-		}
+		m_resolved = dynamic_cast<VarField<T>*>(this->getTerminalField());
+		m_resolvedStamp = Field::connectionStamp();
 	}
+
+	return m_resolved == nullptr ? nullptr : m_resolved->m_data;
 }
 
 template<typename T>
@@ -0,0 +1,137 @@
+#include "FrameGovernor.h"
+
+#include <sstream>
+#include <algorithm>
+
+namespace PhysIKA
+{
+	FrameGovernor& FrameGovernor::getInstance()
+	{
+		static FrameGovernor instance;
+		return instance;
+	}
+
+	void FrameGovernor::setBudget(float ms)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_budget = ms;
+	}
+
+	float FrameGovernor::budget()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		return m_budget;
+	}
+
+	void FrameGovernor::registerKnob(void* owner, int priority, const std::string& name,
+		std::function<bool()> degrade, std::function<bool()> restore)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		Knob knob;
+		knob.owner = owner;
+		knob.priority = priority;
+		knob.name = name;
+		knob.degrade = degrade;
+		knob.restore = restore;
+
+		//keep the list sorted by priority; registration order breaks ties
+		auto it = m_knobs.begin();
+		while (it != m_knobs.end() && it->priority <= priority) ++it;
+		m_knobs.insert(it, knob);
+	}
+
+	void FrameGovernor::removeKnobs(void* owner)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		m_knobs.erase(std::remove_if(m_knobs.begin(), m_knobs.end(),
+			[owner](const Knob& k) { return k.owner == owner; }),
+			m_knobs.end());
+	}
+
+	void FrameGovernor::endFrame(float frameMs)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		//exponential moving average; the first sample seeds it directly
+		const float alpha = 0.2f;
+		m_rollingMs = m_samples == 0 ? frameMs : (1.0f - alpha)*m_rollingMs + alpha*frameMs;
+		m_samples++;
+
+		if (m_budget <= 0.0f)
+		{
+			return;
+		}
+
+		//let the last action reach the rolling average before deciding again
+		const int COOLDOWN_FRAMES = 8;
+		if (m_cooldown > 0)
+		{
+			m_cooldown--;
+			return;
+		}
+
+		if (m_rollingMs > m_budget)
+		{
+			m_calmFrames = 0;
+
+			//cheapest quality loss first
+			for (size_t i = 0; i < m_knobs.size(); i++)
+			{
+				if (m_knobs[i].degrade())
+				{
+					m_knobs[i].level++;
+					m_cooldown = COOLDOWN_FRAMES;
+					return;
+				}
+			}
+			return;
+		}
+
+		//restore only after a sustained stretch clearly under budget, so a
+		//frame hovering at the limit does not flip a knob back and forth
+		const float RESTORE_FRACTION = 0.8f;
+		const int RESTORE_FRAMES = 16;
+
+		if (m_rollingMs < RESTORE_FRACTION * m_budget)
+		{
+			m_calmFrames++;
+			if (m_calmFrames < RESTORE_FRAMES)
+			{
+				return;
+			}
+
+			for (size_t i = m_knobs.size(); i > 0; i--)
+			{
+				Knob& knob = m_knobs[i - 1];
+				if (knob.level > 0 && knob.restore())
+				{
+					knob.level--;
+					m_cooldown = COOLDOWN_FRAMES;
+					m_calmFrames = 0;
+					return;
+				}
+			}
+		}
+		else
+		{
+			m_calmFrames = 0;
+		}
+	}
+
+	std::string FrameGovernor::report()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		std::stringstream ss;
+		ss << "Frame budget: " << m_budget << " ms, rolling average: " << m_rollingMs << " ms" << std::endl;
+		for (size_t i = 0; i < m_knobs.size(); i++)
+		{
+			ss << "  [" << m_knobs[i].priority << "] " << m_knobs[i].name
+				<< ": " << m_knobs[i].level << " step(s) degraded" << std::endl;
+		}
+
+		return ss.str();
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+
+namespace PhysIKA {
+
+/*!
+*	\class	FrameGovernor
+*	\brief	Frame-time budget governor with priority-ordered quality scaling.
+*
+*	Modules register degradation knobs - small steps that trade quality
+*	for time, such as dropping a solver iteration or skipping a cosmetic
+*	force term. When a budget is set through
+*	SceneGraph::setFrameTimeBudget(), the governor folds every frame's
+*	cost into a rolling average; whenever the average overruns the budget
+*	it degrades the lowest-priority knob that still has room, and when
+*	the scene stays comfortably under budget it restores the knobs in
+*	reverse order. A cooldown of a few frames after every action lets the
+*	new setting reach the average before the next decision, so the
+*	governor settles instead of oscillating.
+*/
+class FrameGovernor
+{
+public:
+	static FrameGovernor& getInstance();
+
+	/**
+	 * @brief Frame-time budget in milliseconds; 0 (the default) disables
+	 * the governor and restores nothing.
+	 */
+	void setBudget(float ms);
+	float budget();
+
+	/**
+	 * @brief Register one degradation knob. Lower priority values are
+	 * degraded first (and restored last), so cheap quality losses go
+	 * before visible ones. degrade() applies one step and returns false
+	 * when no further step is possible; restore() undoes one step and
+	 * returns false when the knob is back at full quality. The owner
+	 * pointer ties knob lifetime to the registering module; call
+	 * removeKnobs() from its destructor.
+	 */
+	void registerKnob(void* owner, int priority, const std::string& name,
+		std::function<bool()> degrade, std::function<bool()> restore);
+
+	void removeKnobs(void* owner);
+
+	/**
+	 * @brief Fold one frame's cost into the rolling average and degrade
+	 * or restore at most one knob step. Called from
+	 * SceneGraph::takeOneFrame().
+	 */
+	void endFrame(float frameMs);
+
+	/**
+	 * @brief One line per knob: priority, name and how many degradation
+	 * steps are currently applied.
+	 */
+	std::string report();
+
+private:
+	FrameGovernor() {};
+
+	struct Knob
+	{
+		void* owner;
+		int priority;
+		std::string name;
+		std::function<bool()> degrade;
+		std::function<bool()> restore;
+		int level = 0;
+	};
+
+	float m_budget = 0.0f;
+	float m_rollingMs = 0.0f;
+	unsigned int m_samples = 0;
+	int m_cooldown = 0;
+	int m_calmFrames = 0;
+
+	std::vector<Knob> m_knobs;
+	std::mutex m_mutex;
+};
+
+}
@@ -1,5 +1,7 @@
 #include "Log.h"
 #include <iostream>
+#include <thread>
+#include <chrono>
 
 namespace PhysIKA
 {
@@ -9,18 +11,104 @@ namespace PhysIKA
 	void(*Log::receiver)(const Message&) = NULL;
 	Log::MessageType Log::logLevel = Log::DebugInfo;
 
+	namespace
+	{
+		//bounded MPSC ring (Vyukov scheme): producers claim a slot with a CAS
+		//on the enqueue cursor, the single flush thread drains in order. A
+		//full ring drops the message instead of blocking the caller.
+		const unsigned int LOG_RING_SIZE = 4096;	//power of two
+		const unsigned int LOG_RING_MASK = LOG_RING_SIZE - 1;
+
+		struct LogSlot
+		{
+			std::atomic<unsigned int> seq;
+			Log::MessageType type;
+			std::string text;
+			time_t when;
+		};
+
+		LogSlot logRing[LOG_RING_SIZE];
+		std::atomic<unsigned int> logEnqueuePos(0);
+		std::atomic<unsigned int> logDequeuePos(0);
+		std::atomic<unsigned int> logDropped(0);
+
+		bool logAsync = false;
+		bool logRingInitialized = false;
+		std::atomic<bool> logFlushRunning(false);
+		std::thread logFlushThread;
+
+		bool enqueueMessage(Log::MessageType type, const std::string& text)
+		{
+			for (;;)
+			{
+				unsigned int pos = logEnqueuePos.load(std::memory_order_relaxed);
+				LogSlot& slot = logRing[pos & LOG_RING_MASK];
+				unsigned int seq = slot.seq.load(std::memory_order_acquire);
+				int dif = (int)(seq - pos);
+
+				if (dif == 0)
+				{
+					if (logEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						slot.type = type;
+						slot.text = text;
+						slot.when = time(NULL);
+						slot.seq.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (dif < 0)
+				{
+					logDropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+			}
+		}
+
+		bool dequeueMessage(Log::MessageType& type, std::string& text, time_t& when)
+		{
+			unsigned int pos = logDequeuePos.load(std::memory_order_relaxed);
+			LogSlot& slot = logRing[pos & LOG_RING_MASK];
+			unsigned int seq = slot.seq.load(std::memory_order_acquire);
+
+			if ((int)(seq - (pos + 1)) < 0)
+			{
+				return false;
+			}
+
+			type = slot.type;
+			text = slot.text;
+			when = slot.when;
+			slot.seq.store(pos + LOG_RING_SIZE, std::memory_order_release);
+			logDequeuePos.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+	}
+
 	void Log::sendMessage(MessageType type, const std::string& text)
 	{
 		// Skip logging to file if minimum level is higher
 		if ((int)type < (int)logLevel)
 			return;
 
+		if (logAsync)
+		{
+			//formatting, the message list and the file write all happen on
+			//the flush thread
+			enqueueMessage(type, text);
+			return;
+		}
+
+		deliverMessage(type, text, time(NULL));
+	}
+
+	void Log::deliverMessage(MessageType type, const std::string& text, time_t when)
+	{
 		// log message
 		Log::Message m;
 		m.type = type;
 		m.text = text;
-		time_t t = time(NULL);
-		m.when = localtime(&t);
+		m.when = localtime(&when);
 		messages.push_back(m);
 
 		// if user wants to catch messages, send it to him
@@ -50,6 +138,79 @@ namespace PhysIKA
 		}
 	}
 
+	void Log::enableAsync(bool enabled)
+	{
+		if (enabled == logAsync)
+			return;
+
+		if (enabled)
+		{
+			if (!logRingInitialized)
+			{
+				for (unsigned int i = 0; i < LOG_RING_SIZE; i++)
+				{
+					logRing[i].seq.store(i, std::memory_order_relaxed);
+				}
+				logRingInitialized = true;
+			}
+
+			logFlushRunning.store(true);
+			logFlushThread = std::thread([]()
+			{
+				MessageType type;
+				std::string text;
+				time_t when;
+
+				while (logFlushRunning.load())
+				{
+					if (dequeueMessage(type, text, when))
+					{
+						deliverMessage(type, text, when);
+					}
+					else
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}
+				}
+
+				//drain what is left before shutting down
+				while (dequeueMessage(type, text, when))
+				{
+					deliverMessage(type, text, when);
+				}
+			});
+
+			logAsync = true;
+		}
+		else
+		{
+			logAsync = false;
+			logFlushRunning.store(false);
+			if (logFlushThread.joinable())
+			{
+				logFlushThread.join();
+			}
+		}
+	}
+
+	void Log::flush()
+	{
+		while (logAsync && logDequeuePos.load(std::memory_order_acquire) != logEnqueuePos.load(std::memory_order_acquire))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		if (outputStream.is_open())
+		{
+			outputStream.flush();
+		}
+	}
+
+	unsigned int Log::getDroppedMessages()
+	{
+		return logDropped.load(std::memory_order_relaxed);
+	}
+
 
 	void Log::setOutput(const std::string& filename)
 	{
@@ -74,6 +235,8 @@ namespace PhysIKA
 
 	Log::~Log()
 	{
+		enableAsync(false);
+
 		if (outputStream.is_open())
 			outputStream.close();
 	}
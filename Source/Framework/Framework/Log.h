@@ -3,6 +3,7 @@
 #include <list>
 #include <fstream>
 #include <ctime>
+#include <atomic>
 
 namespace PhysIKA {
 
@@ -79,7 +80,27 @@ namespace PhysIKA {
 		 */
 		static void setLevel(MessageType level);
 
+		/*!
+		 *	\brief	Route messages through a lock-free ring buffer drained by a
+		 *	background thread, so formatting and file output never stall the
+		 *	caller. When the ring is full the message is dropped and counted
+		 *	rather than blocking the simulation.
+		 */
+		static void enableAsync(bool enabled);
+
+		/*!
+		 *	\brief	Block until every queued message has been written. Only
+		 *	meaningful while async mode is on.
+		 */
+		static void flush();
+
+		/*!
+		 *	\brief	Messages dropped because the async ring was full.
+		 */
+		static unsigned int getDroppedMessages();
+
 	private:
+		static void deliverMessage(MessageType type, const std::string& text, time_t when);
 
 		static std::string outputFile;
 		static std::ofstream outputStream;
@@ -88,11 +109,31 @@ namespace PhysIKA {
 		static void (*receiver)(const Message&);
 	};
 
+	// compile-time verbosity floor: messages below this level compile away
+	// entirely (0 = DebugInfo ... 3 = Error)
+#ifndef PHYSIKA_LOG_LEVEL
+	#define PHYSIKA_LOG_LEVEL 0
+#endif
+
 	// simple debug macro
-#ifdef NDEBUG
+#if defined(NDEBUG) || PHYSIKA_LOG_LEVEL > 0
 	#define LogDebug(DESC)
 #else
 	#define LogDebug(DESC) Log::sendMessage(Log::DebugInfo, DESC)
 #endif
 
+#if PHYSIKA_LOG_LEVEL > 1
+	#define LogInfo(DESC)
+#else
+	#define LogInfo(DESC) Log::sendMessage(Log::Info, DESC)
+#endif
+
+#if PHYSIKA_LOG_LEVEL > 2
+	#define LogWarning(DESC)
+#else
+	#define LogWarning(DESC) Log::sendMessage(Log::Warning, DESC)
+#endif
+
+	#define LogError(DESC) Log::sendMessage(Log::Error, DESC)
+
 }
@@ -1,5 +1,14 @@
 #include "Module.h"
 #include "Framework/Framework/Node.h"
+#include "Framework/Framework/ModuleProfiler.h"
+#include "Core/Array/MemoryManager.h"
+#include "Core/Utility/GTimer.h"
+#include "Core/Utility/TraceProfiler.h"
+#include "Core/Utility/cuda_utilities.h"
+
+#ifdef USE_NVTX
+#include <nvToolsExt.h>
+#endif
 
 namespace PhysIKA
 {
@@ -7,6 +16,9 @@ namespace PhysIKA
 Module::Module(std::string name)
 	: m_node(nullptr)
 	, m_initialized(false)
+	, m_kernel_time(0.0f, "kernel_time", "Kernel milliseconds of the last execution", FieldType::Out, this)
+	, m_kernel_launches(0.0f, "kernel_launches", "Kernel launches of the last execution", FieldType::Out, this)
+	, m_kernel_occupancy(0.0f, "kernel_occupancy", "Launch-weighted occupancy of the last execution", FieldType::Out, this)
 {
 //	attachField(&m_module_name, "module_name", "Module name", false);
 
@@ -30,18 +42,88 @@ bool Module::initialize()
 	return m_initialized;
 }
 
+void Module::setActive(bool active)
+{
+	if (m_module_active == active)
+	{
+		return;
+	}
+
+	m_module_active = active;
+
+	//recompile lazily: the plan is rebuilt on the next query, not per toggle
+	if (m_node != NULL)
+	{
+		m_node->markExecutionPlanDirty();
+	}
+}
+
 void Module::update()
 {
+	if (!m_module_active)
+	{
+		return;
+	}
+
 	if (!isInputComplete())
 	{
 		Log::sendMessage(Log::Error, std::string("Input for ") + this->getName() + std::string(" with class name of ") + this->getClassInfo()->getClassName() + std::string(" should be appropriately set"));
 		return;
 	}
 
+	if (m_lazy_update && m_executed && !isInputModified())
+	{
+		m_skip_count++;
+		return;
+	}
+
 	if (m_update_required)
 	{
-		//do execution if any field is modified
-		this->execute();
+		//do execution if any field is modified; device allocations made while
+		//executing are attributed to this module in MemoryStats
+		MemoryTagScope memScope(this->getName());
+
+		//timeline range for chrome://tracing; see TraceProfiler
+		TraceScope traceScope(this->getName());
+
+		bool kernelStats = KernelStats::getInstance().isEnabled();
+		if (kernelStats)
+		{
+			KernelStats::getInstance().beginModule(this->getName());
+		}
+
+		if (ModuleProfiler::getInstance().isEnabled())
+		{
+#ifdef USE_NVTX
+			nvtxRangePushA(this->getName().c_str());
+#endif
+			GTimer timer;
+			timer.start();
+			this->execute();
+			timer.stop();
+#ifdef USE_NVTX
+			nvtxRangePop();
+#endif
+			ModuleProfiler::getInstance().addSample(this->getName(), timer.getEclipsedTime());
+		}
+		else
+		{
+			this->execute();
+		}
+
+		if (kernelStats)
+		{
+			KernelStats::getInstance().endModule();
+
+			KernelStats::ModuleCounters counters;
+			if (KernelStats::getInstance().queryModule(this->getName(), counters))
+			{
+				m_kernel_time.setValue(counters.kernelMs);
+				m_kernel_launches.setValue((float)counters.launches);
+				m_kernel_occupancy.setValue(counters.occupancy);
+			}
+		}
+		m_executed = true;
 
 		//reset input fields
 		for each (auto f_in in fields_input)
@@ -57,6 +139,19 @@ void Module::update()
 	}
 }
 
+bool Module::isInputModified()
+{
+	for each (auto f_in in fields_input)
+	{
+		if (f_in->isModified())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 bool Module::isInputComplete()
 {
 	//If any input field is empty, return false;
@@ -34,6 +34,37 @@ public:
 	 */
 	bool isInputComplete();
 
+	/**
+	 * @brief Check whether any input field has been tagged as modified since
+	 * the last execution.
+	 */
+	bool isInputModified();
+
+	/**
+	 * @brief Skip execute() inside update() whenever no input field has been
+	 * modified since the last run. Off by default: dirtiness is only tracked
+	 * through tagModified()/field connections, so modules whose inputs are
+	 * rewritten in place by kernels (particle positions during integration)
+	 * must stay eager.
+	 */
+	void setLazyUpdate(bool lazy) { m_lazy_update = lazy; }
+
+	/**
+	 * @brief Number of update() calls skipped so far because all inputs were
+	 * clean; only counts while lazy update is enabled.
+	 */
+	unsigned int getSkipCount() { return m_skip_count; }
+
+	/**
+	 * @brief Enable or disable this module. A disabled module costs a single
+	 * flag test in update() and drops out of the parent node's compiled
+	 * execution plan entirely, so the per-frame module walks never touch it.
+	 * Toggling marks the plan stale; it is recompiled on the next query, not
+	 * per frame, so the GUI can flip modules freely.
+	 */
+	void setActive(bool active);
+	bool isActive() { return m_module_active; }
+
 	virtual void begin() {};
 
 	virtual bool execute();
@@ -82,6 +113,17 @@ public:
 
 	bool attachField(Field* field, std::string name, std::string desc, bool autoDestroy = true) override;
 
+public:
+	/**
+	 * @brief Kernel counters of this module's most recent execution,
+	 * refreshed while SceneGraph::setKernelStatsEnabled(true) is active:
+	 * number of kernel launches, summed kernel milliseconds and the
+	 * launch-weighted occupancy. Exposed as fields so the property panel
+	 * and the Python binding can watch a solver's kernels live.
+	 */
+	VarField<float> m_kernel_time;
+	VarField<float> m_kernel_launches;
+	VarField<float> m_kernel_occupancy;
 
 protected:
 	/// \brief Initialization function for each module
@@ -98,6 +140,11 @@ private:
 	bool m_initialized;
 
 	bool m_update_required = true;
+	bool m_module_active = true;
+
+	bool m_lazy_update = false;
+	bool m_executed = false;
+	unsigned int m_skip_count = 0;
 
 	std::vector<Field*> fields_input;
 	std::vector<Field*> fields_output;
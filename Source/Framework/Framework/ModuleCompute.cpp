@@ -1,21 +1,193 @@
 #include "ModuleCompute.h"
 #include "Framework/Framework/Node.h"
 
+#include <cstring>
+
 namespace PhysIKA
 {
+
+namespace
+{
+	//capacity shared by every memoization cache; host memory, see
+	//setMemoCapacity
+	size_t s_memo_capacity = size_t(256) << 20;
+	size_t s_memo_live = 0;
+
+	unsigned long long fnv1a(unsigned long long h, const void* data, size_t bytes)
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < bytes; i++)
+		{
+			h ^= p[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+}
+
 ComputeModule::ComputeModule()
 {
 }
 
 ComputeModule::~ComputeModule()
 {
+	dropCache();
+}
+
+void ComputeModule::setPure(bool pure)
+{
+	m_pure = pure;
+
+	if (pure)
+	{
+		//a pure module is by definition safe to skip on clean inputs, and
+		//lazy update keeps the input hash off the per-frame path
+		setLazyUpdate(true);
+	}
+	else
+	{
+		dropCache();
+	}
+}
+
+void ComputeModule::setMemoCapacity(size_t bytes)
+{
+	s_memo_capacity = bytes;
+}
+
+unsigned long long ComputeModule::inputSignature(bool& hashable)
+{
+	hashable = true;
+
+	unsigned long long h = 14695981039346656037ull;
+
+	std::vector<char> scratch;
+	auto& inputs = getInputFields();
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		Field* f = inputs[i];
+
+		size_t eb = f->getElementBytes();
+		if (eb == 0)
+		{
+			hashable = false;
+			return 0;
+		}
+
+		size_t num = f->getElementCount();
+
+		std::string name = f->getObjectName();
+		h = fnv1a(h, name.c_str(), name.size());
+		h = fnv1a(h, &num, sizeof(num));
+
+		scratch.resize(num * eb);
+		if (num > 0 && !f->dumpRawData(scratch.data()))
+		{
+			hashable = false;
+			return 0;
+		}
+		h = fnv1a(h, scratch.data(), scratch.size());
+	}
+
+	return h;
+}
+
+bool ComputeModule::captureOutputs()
+{
+	dropCache();
+
+	auto& outputs = getOutputFields();
+
+	size_t total = 0;
+	for (size_t i = 0; i < outputs.size(); i++)
+	{
+		size_t eb = outputs[i]->getElementBytes();
+		if (eb == 0)
+		{
+			return false;
+		}
+		total += outputs[i]->getElementCount() * eb;
+	}
+
+	if (s_memo_live + total > s_memo_capacity)
+	{
+		return false;
+	}
+
+	m_memo_outputs.resize(outputs.size());
+	for (size_t i = 0; i < outputs.size(); i++)
+	{
+		Field* f = outputs[i];
+		MemoBlob& blob = m_memo_outputs[i];
+
+		blob.elementCount = f->getElementCount();
+		blob.bytes.resize(blob.elementCount * f->getElementBytes());
+		if (blob.elementCount > 0 && !f->dumpRawData(blob.bytes.data()))
+		{
+			dropCache();
+			return false;
+		}
+	}
+
+	m_memo_bytes = total;
+	s_memo_live += total;
+	return true;
+}
+
+bool ComputeModule::restoreOutputs()
+{
+	auto& outputs = getOutputFields();
+	if (m_memo_outputs.size() != outputs.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < outputs.size(); i++)
+	{
+		MemoBlob& blob = m_memo_outputs[i];
+		if (!outputs[i]->loadRawData(blob.bytes.data(), blob.elementCount))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ComputeModule::dropCache()
+{
+	s_memo_live -= m_memo_bytes;
+	m_memo_bytes = 0;
+	m_memo_outputs.clear();
+	m_has_memo = false;
 }
 
 bool ComputeModule::execute()
 {
+	if (m_pure)
+	{
+		bool hashable = true;
+		unsigned long long key = inputSignature(hashable);
+
+		if (hashable)
+		{
+			if (m_has_memo && key == m_memo_key && restoreOutputs())
+			{
+				m_memo_hits++;
+				return true;
+			}
+
+			this->compute();
+
+			m_memo_key = key;
+			m_has_memo = captureOutputs();
+			return true;
+		}
+	}
+
 	this->compute();
 
 	return true;
 }
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "Framework/Framework/Module.h"
 
+#include <vector>
+
 namespace PhysIKA{
 
 class ComputeModule : public Module
@@ -13,9 +15,62 @@ public:
 
 	virtual void compute() {};
 
+	/**
+	 * @brief Declare this module pure: its outputs are a function of its
+	 * input fields only. Pure modules memoize their results - execute()
+	 * hashes the input contents and, when the signature matches the cached
+	 * one, restores the cached outputs instead of recomputing. Lazy update
+	 * already skips frames where nothing changed; memoization covers reuse
+	 * after a reset or reload, where the inputs are rebuilt to the same
+	 * values and an eager module would recompute from scratch. Enabling
+	 * purity also enables lazy update, so the input hash is only taken when
+	 * an input was actually touched. Only fields with raw-data support
+	 * (trivially copyable elements) can be hashed and cached; a module with
+	 * other fields silently stays uncached.
+	 */
+	void setPure(bool pure);
+	bool isPure() { return m_pure; }
+
+	/**
+	 * @brief Number of executions served from the memoization cache.
+	 */
+	unsigned int getMemoHitCount() { return m_memo_hits; }
+
+	/**
+	 * @brief Host bytes all memoization caches together may hold; a capture
+	 * that would exceed the cap is skipped and that module stays uncached.
+	 * The caches live in host memory, outside the device-byte budget of
+	 * MemoryStats, hence the separate cap.
+	 */
+	static void setMemoCapacity(size_t bytes);
+
 	std::string getModuleType() override { return "ComputeModule"; }
 private:
+	/**
+	 * @brief FNV-1a over name, element count and raw contents of every
+	 * input field; hashable turns false when any input lacks raw-data
+	 * support.
+	 */
+	unsigned long long inputSignature(bool& hashable);
+
+	bool captureOutputs();
+	bool restoreOutputs();
+	void dropCache();
 
+	bool m_pure = false;
+
+	bool m_has_memo = false;
+	unsigned long long m_memo_key = 0;
+	unsigned int m_memo_hits = 0;
+
+	struct MemoBlob
+	{
+		size_t elementCount = 0;
+		std::vector<char> bytes;
+	};
+
+	//cached outputs, parallel to getOutputFields()
+	std::vector<MemoBlob> m_memo_outputs;
+	size_t m_memo_bytes = 0;
 };
 }
-
@@ -0,0 +1,69 @@
+#include "ModuleProfiler.h"
+
+#include <sstream>
+#include <iomanip>
+
+namespace PhysIKA
+{
+	ModuleProfiler& ModuleProfiler::getInstance()
+	{
+		static ModuleProfiler instance;
+		return instance;
+	}
+
+	void ModuleProfiler::addSample(const std::string& name, float ms)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		Record& rec = m_records[name];
+
+		//exponential moving average; the first sample seeds it directly
+		const float alpha = 0.1f;
+		rec.rollingMs = rec.samples == 0 ? ms : (1.0f - alpha)*rec.rollingMs + alpha*ms;
+		rec.maxMs = ms > rec.maxMs ? ms : rec.maxMs;
+		rec.samples++;
+	}
+
+	std::string ModuleProfiler::report()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		std::stringstream ss;
+		ss << "Module profile (rolling ms | max ms | samples)" << std::endl;
+
+		for (auto it = m_records.begin(); it != m_records.end(); ++it)
+		{
+			ss << std::left << std::setw(32) << it->first
+				<< std::right << std::fixed << std::setprecision(3)
+				<< std::setw(10) << it->second.rollingMs
+				<< std::setw(10) << it->second.maxMs
+				<< std::setw(10) << it->second.samples
+				<< std::endl;
+		}
+
+		return ss.str();
+	}
+
+	std::string ModuleProfiler::reportCSV()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+
+		std::stringstream ss;
+		for (auto it = m_records.begin(); it != m_records.end(); ++it)
+		{
+			ss << it->first << ","
+				<< std::fixed << std::setprecision(3)
+				<< it->second.rollingMs << ","
+				<< it->second.maxMs << ","
+				<< it->second.samples << std::endl;
+		}
+
+		return ss.str();
+	}
+
+	void ModuleProfiler::clear()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_records.clear();
+	}
+}
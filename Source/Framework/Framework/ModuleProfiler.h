@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <map>
+#include <mutex>
+
+namespace PhysIKA {
+
+/*!
+*	\class	ModuleProfiler
+*	\brief	Rolling per-module GPU timing collected inside Module::update().
+*
+*	When enabled, every module execution is bracketed with CUDA events
+*	(GTimer) and the measured milliseconds are folded into a rolling
+*	average per module name. The report is reachable from
+*	SceneGraph::getProfileReport(), so regressions show up without
+*	hand-instrumenting individual modules. When the code is compiled with
+*	USE_NVTX, each execution additionally emits an NVTX range named after
+*	the module so Nsight captures map to Module::getName().
+*/
+class ModuleProfiler
+{
+public:
+	static ModuleProfiler& getInstance();
+
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	bool isEnabled() { return m_enabled; }
+
+	/**
+	 * @brief Fold one timed execution into the rolling statistics.
+	 */
+	void addSample(const std::string& name, float ms);
+
+	/**
+	 * @brief One line per module: rolling average, worst case and sample
+	 * count, sorted by name.
+	 */
+	std::string report();
+
+	/**
+	 * @brief Machine-readable form of report(): one
+	 * "module,avg_ms,max_ms,samples" line per module, no header.
+	 */
+	std::string reportCSV();
+
+	void clear();
+
+private:
+	ModuleProfiler() {};
+
+	struct Record
+	{
+		float rollingMs = 0.0f;
+		float maxMs = 0.0f;
+		unsigned int samples = 0;
+	};
+
+	bool m_enabled = false;
+
+	std::map<std::string, Record> m_records;
+	std::mutex m_mutex;
+};
+
+}
@@ -0,0 +1,87 @@
+#include "MpiContext.h"
+
+#include <cuda_runtime.h>
+
+#ifdef PHYSIKA_ENABLE_MPI
+#include <mpi.h>
+#endif
+
+namespace PhysIKA
+{
+	MpiContext& MpiContext::getInstance()
+	{
+		static MpiContext m_instance;
+		return m_instance;
+	}
+
+	void MpiContext::initialize(int* argc, char*** argv)
+	{
+		if (m_initialized)
+		{
+			return;
+		}
+
+#ifdef PHYSIKA_ENABLE_MPI
+		int alreadyUp = 0;
+		MPI_Initialized(&alreadyUp);
+		if (!alreadyUp)
+		{
+			MPI_Init(argc, argv);
+		}
+		MPI_Comm_rank(MPI_COMM_WORLD, &m_rank);
+		MPI_Comm_size(MPI_COMM_WORLD, &m_size);
+
+		//one rank per GPU: ranks sharing a host spread over its devices
+		int deviceNum = 0;
+		cudaGetDeviceCount(&deviceNum);
+		if (deviceNum > 0)
+		{
+			cudaSetDevice(m_rank % deviceNum);
+		}
+#endif
+
+		m_initialized = true;
+	}
+
+	void MpiContext::finalize()
+	{
+#ifdef PHYSIKA_ENABLE_MPI
+		if (m_initialized)
+		{
+			int down = 0;
+			MPI_Finalized(&down);
+			if (!down)
+			{
+				MPI_Finalize();
+			}
+		}
+#endif
+		m_initialized = false;
+	}
+
+	void MpiContext::barrier()
+	{
+#ifdef PHYSIKA_ENABLE_MPI
+		if (m_size > 1)
+		{
+			MPI_Barrier(MPI_COMM_WORLD);
+		}
+#endif
+	}
+
+	void MpiContext::ownedInterval(float lo, float hi, float& x0, float& x1)
+	{
+		float width = (hi - lo) / (float)m_size;
+		x0 = lo + m_rank * width;
+		x1 = m_rank == m_size - 1 ? hi : x0 + width;
+	}
+
+	std::string MpiContext::rankTag()
+	{
+		if (m_size <= 1)
+		{
+			return std::string("");
+		}
+		return std::string("_r") + std::to_string(m_rank);
+	}
+}
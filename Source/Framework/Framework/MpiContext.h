@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	MpiContext
+	*	\brief	Rank/size bookkeeping for the optional MPI execution mode.
+	*
+	*	Built with PhysIKA_MPI=ON, initialize() wraps MPI_Init, selects the
+	*	local CUDA device (rank modulo visible devices, the usual one-rank-
+	*	per-GPU farm layout) and every rank owns one x-slab of the global
+	*	domain, see ownedInterval(). Without the option the context compiles
+	*	to a single-rank stub, so call sites need no guards: rank 0, size 1,
+	*	barriers are no-ops.
+	*
+	*	Halo traffic between neighbor ranks goes through MpiHaloExchange,
+	*	which hands device pointers straight to MPI (CUDA-aware MPI);
+	*	ParticleWriter tags its output per rank and maintains a merge index.
+	*/
+	class MpiContext
+	{
+	public:
+		static MpiContext& getInstance();
+
+		/**
+		 * @brief Call once before the scene is built; wraps MPI_Init and
+		 * pins this rank to its local device.
+		 */
+		void initialize(int* argc, char*** argv);
+
+		/**
+		 * @brief Wraps MPI_Finalize; call after the last frame.
+		 */
+		void finalize();
+
+		int rank() { return m_rank; }
+		int size() { return m_size; }
+
+		bool isDistributed() { return m_size > 1; }
+
+		void barrier();
+
+		/**
+		 * @brief The x interval of the global domain owned by this rank;
+		 * equal-width slabs in rank order.
+		 */
+		void ownedInterval(float lo, float hi, float& x0, float& x1);
+
+		/**
+		 * @brief Suffix for per-rank output files, empty on single-rank runs.
+		 */
+		std::string rankTag();
+
+	private:
+		MpiContext() {};
+		MpiContext(const MpiContext&) {};
+		MpiContext& operator=(const MpiContext&) { return *this; };
+
+		int m_rank = 0;
+		int m_size = 1;
+		bool m_initialized = false;
+	};
+}
@@ -2,6 +2,7 @@
 #include "NodeIterator.h"
 
 #include "Framework/Action/Action.h"
+#include "Core/Utility/TraceProfiler.h"
 
 
 namespace PhysIKA
@@ -80,9 +81,32 @@ bool Node::isActive()
 
 void Node::setActive(bool active)
 {
+	//stage the cold arrays out of VRAM while the node sleeps, and bring
+	//them back ahead of the first frame after it wakes
+	if (m_coldArrays != nullptr)
+	{
+		if (active)
+		{
+			m_coldArrays->fetchToDevice();
+		}
+		else
+		{
+			m_coldArrays->evictToHost();
+		}
+	}
+
 	this->varActive()->setValue(active);
 }
 
+std::shared_ptr<ManagedMemoryManager<DeviceType::GPU>> Node::coldArrayManager()
+{
+	if (m_coldArrays == nullptr)
+	{
+		m_coldArrays = std::make_shared<ManagedMemoryManager<DeviceType::GPU>>();
+	}
+	return m_coldArrays;
+}
+
 bool Node::isVisible()
 {
 	return this->varVisible()->getValue();
@@ -157,6 +181,10 @@ void Node::removeAllChildren()
 
 void Node::advance(Real dt)
 {
+	//timeline range covering the whole step of this node's model, so the
+	//per-module ranges recorded inside nest under it; see TraceProfiler
+	TraceScope traceScope(std::string("advance ") + this->getName());
+
 	auto nModel = this->getNumericalModel();
 	if (nModel == NULL)
 	{
@@ -529,6 +557,7 @@ bool Node::addToModuleList(std::shared_ptr<Module> module)
 	{
 		m_module_list.push_back(module);
 		module->setParent(this);
+		m_plan_dirty = true;
 		return true;
 	}
 
@@ -541,10 +570,31 @@ bool Node::deleteFromModuleList(std::shared_ptr<Module> module)
 	if (found != m_module_list.end())
 	{
 		m_module_list.erase(found);
+		m_plan_dirty = true;
 		return true;
 	}
 
 	return true;
 }
 
+std::vector<std::shared_ptr<Module>>& Node::getActiveModules(std::string moduleType)
+{
+	if (m_plan_dirty)
+	{
+		//one pass over the module list groups the active modules by type;
+		//everything disabled simply never enters the plan
+		m_execution_plan.clear();
+		for (auto iter = m_module_list.begin(); iter != m_module_list.end(); iter++)
+		{
+			if ((*iter)->isActive())
+			{
+				m_execution_plan[(*iter)->getModuleType()].push_back(*iter);
+			}
+		}
+		m_plan_dirty = false;
+	}
+
+	return m_execution_plan[moduleType];
+}
+
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "Core/Typedef.h"
 #include "FieldVar.h"
 #include "Core/Platform.h"
+#include "Core/Array/MemoryManager.h"
 #include "NumericalModel.h"
 #include "ModuleTopology.h"
 #include "DeviceContext.h"
@@ -76,6 +77,26 @@ public:
 	void setMass(Real mass);
 	Real getMass();
 
+	/**
+	 * @brief Pin this node's simulation work to a CUDA device; -1 (the
+	 * default) keeps it on the primary device. The parallel scheduler
+	 * switches to the pinned device before initializing or advancing the
+	 * node, so its state is allocated and advanced there. Nodes pinned to
+	 * different devices read each other's connected fields directly over
+	 * peer access, which the scheduler enables per dependency edge.
+	 */
+	void setComputeDevice(int device) { m_computeDevice = device; }
+	int getComputeDevice() { return m_computeDevice; }
+
+	/**
+	 * @brief Allocator for this node's cold arrays (rest shapes, cached
+	 * SDF bricks). Blocks live in managed memory, so they can be paged
+	 * out of VRAM; setActive() stages them to the host while the node
+	 * sleeps and prefetches them back when it wakes, see
+	 * ManagedMemoryManager.
+	 */
+	std::shared_ptr<ManagedMemoryManager<DeviceType::GPU>> coldArrayManager();
+
 // 	Iterator begin();
 // 	Iterator end();
 
@@ -158,6 +179,24 @@ public:
 
 	std::list<std::shared_ptr<Module>>& getModuleList() { return m_module_list; }
 
+	/**
+	 * @brief Compiled execution plan: the active modules of one type, in
+	 * list order. The per-frame walks (e.g. the IO pass) iterate these
+	 * vectors instead of scanning m_module_list with a type-string compare
+	 * per module, so disabled modules cost nothing at dispatch time. The
+	 * plan is recompiled in one pass over the module list, and only when it
+	 * was marked stale - by add/delete or by Module::setActive - not per
+	 * frame. Scenes authored in the node editor tend to accumulate dozens
+	 * of dormant modules; those drop out here.
+	 */
+	std::vector<std::shared_ptr<Module>>& getActiveModules(std::string moduleType);
+
+	/**
+	 * @brief Invalidate the compiled execution plan; the next
+	 * getActiveModules() call rebuilds it.
+	 */
+	void markExecutionPlanDirty() { m_plan_dirty = true; }
+
 	bool hasModule(std::string name);
 
 	/**
@@ -376,6 +415,10 @@ private:
 
 	Real m_mass;
 
+	int m_computeDevice = -1;
+
+	std::shared_ptr<ManagedMemoryManager<DeviceType::GPU>> m_coldArrays = nullptr;
+
 	DEF_VAR(Location, Vector3f, 0, "Node location");
 	DEF_VAR(Rotation, Vector3f, 0, "Node rotation");
 	DEF_VAR(Scale, Vector3f, 0, "Node scale");
@@ -403,6 +446,12 @@ private:
 	 */
 	std::list<std::shared_ptr<Module>> m_module_list;
 
+	/**
+	 * @brief Active modules grouped by type; see getActiveModules()
+	 */
+	std::map<std::string, std::vector<std::shared_ptr<Module>>> m_execution_plan;
+	bool m_plan_dirty = true;
+
 	/**
 	 * @brief Pointer of a specific module
 	 * 
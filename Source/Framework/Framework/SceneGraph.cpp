@@ -1,11 +1,22 @@
 #include "SceneGraph.h"
+#include "Core/Array/FrameArena.h"
+#include "Core/Array/MemoryManager.h"
 #include "Framework/Action/ActAnimate.h"
 #include "Framework/Action/ActDraw.h"
 #include "Framework/Action/ActInit.h"
 #include "Framework/Action/ActReset.h"
 #include "Framework/Action/ActQueryTimestep.h"
 #include "Framework/Action/ActPostProcessing.h"
+#include "Framework/Action/ActLocalSubstep.h"
 #include "Framework/Framework/SceneLoaderFactory.h"
+#include "Framework/Framework/SceneSnapshot.h"
+#include "Framework/Framework/TaskScheduler.h"
+#include "Framework/Framework/ModuleProfiler.h"
+#include "Framework/Framework/FrameGovernor.h"
+#include "Core/Utility/CTimer.h"
+#include "Core/Utility/TraceProfiler.h"
+#include "Framework/Topology/NeighborStats.h"
+#include "Core/Utility/cuda_utilities.h"
 
 
 namespace PhysIKA
@@ -26,6 +37,47 @@ void SceneGraph::setAdaptiveInterval(bool adaptive)
 	m_advative_interval = adaptive;
 }
 
+void SceneGraph::setLocalSubstepping(bool enabled)
+{
+	m_local_substep = enabled;
+}
+
+void SceneGraph::setParallelExecution(bool enabled, int workerNum)
+{
+	m_parallel = enabled;
+	m_workerNum = workerNum;
+
+	if (!enabled)
+	{
+		m_scheduler = nullptr;
+	}
+}
+
+void SceneGraph::setDeviceRoundRobin(bool enabled)
+{
+	m_roundRobinDevices = enabled;
+	if (m_scheduler != nullptr)
+	{
+		m_scheduler->setRoundRobinDevices(enabled);
+	}
+}
+
+void SceneGraph::animateOnePass(float dt)
+{
+	if (m_parallel)
+	{
+		if (m_scheduler == nullptr)
+		{
+			m_scheduler = std::make_shared<TaskScheduler>(m_workerNum);
+			m_scheduler->setRoundRobinDevices(m_roundRobinDevices);
+		}
+		m_scheduler->animate(m_root);
+		return;
+	}
+
+	m_root->traverseTopDown<AnimateAct>(dt);
+}
+
 void SceneGraph::setGravity(Vector3f g)
 {
 	m_gravity = g;
@@ -36,6 +88,80 @@ Vector3f SceneGraph::getGravity()
 	return m_gravity;
 }
 
+std::string SceneGraph::getMemoryReport()
+{
+	return MemoryStats::report();
+}
+
+void SceneGraph::setProfilingEnabled(bool enabled)
+{
+	ModuleProfiler::getInstance().setEnabled(enabled);
+}
+
+std::string SceneGraph::getProfileReport()
+{
+	return ModuleProfiler::getInstance().report();
+}
+
+void SceneGraph::setKernelStatsEnabled(bool enabled)
+{
+	KernelStats::getInstance().setEnabled(enabled);
+}
+
+std::string SceneGraph::getKernelReport()
+{
+	return KernelStats::getInstance().report();
+}
+
+void SceneGraph::setDeterministic(bool enabled)
+{
+	m_deterministic = enabled;
+}
+
+bool SceneGraph::isDeterministic()
+{
+	return m_deterministic;
+}
+
+void SceneGraph::setFrameTimeBudget(float ms)
+{
+	FrameGovernor::getInstance().setBudget(ms);
+}
+
+std::string SceneGraph::getGovernorReport()
+{
+	return FrameGovernor::getInstance().report();
+}
+
+void SceneGraph::setTracingEnabled(bool enabled)
+{
+	TraceProfiler::getInstance().setEnabled(enabled);
+	if (enabled)
+	{
+		TraceProfiler::getInstance().nameCurrentThread("simulation");
+	}
+}
+
+bool SceneGraph::exportTrace(std::string fileName)
+{
+	return TraceProfiler::getInstance().exportChromeTracing(fileName);
+}
+
+std::string SceneGraph::getNeighborReport()
+{
+	return NeighborStats::getInstance().report();
+}
+
+void SceneGraph::setMemoryBudget(size_t bytes)
+{
+	MemoryStats::setBudget(bytes);
+}
+
+void SceneGraph::setMemoryOversubscription(bool enabled)
+{
+	MemoryStats::setOversubscription(enabled);
+}
+
 bool SceneGraph::initialize()
 {
 	if (m_initialized)
@@ -48,7 +174,19 @@ bool SceneGraph::initialize()
 		return false;
 	}
 
-	m_root->traverseBottomUp<InitAct>();
+	if (m_parallel)
+	{
+		if (m_scheduler == nullptr)
+		{
+			m_scheduler = std::make_shared<TaskScheduler>(m_workerNum);
+			m_scheduler->setRoundRobinDevices(m_roundRobinDevices);
+		}
+		m_scheduler->initialize(m_root);
+	}
+	else
+	{
+		m_root->traverseBottomUp<InitAct>();
+	}
 	m_initialized = true;
 
 	return m_initialized;
@@ -59,6 +197,49 @@ void SceneGraph::invalid()
 	m_initialized = false;
 }
 
+//Split of DrawAct for the pipelined frame mode: the snapshot pass copies
+//the simulation state into the render buffers before the next frame's
+//simulation may mutate it, the display pass only issues the draw calls.
+class ContextSnapshotAct : public Action
+{
+	void process(Node* node) override
+	{
+		if (!node->isVisible())
+		{
+			return;
+		}
+
+		auto& list = node->getVisualModuleList();
+		for (auto iter = list.begin(); iter != list.end(); iter++)
+		{
+			if ((*iter)->isVisible())
+			{
+				(*iter)->updateRenderingContext();
+			}
+		}
+	}
+};
+
+class DisplayOnlyAct : public Action
+{
+	void process(Node* node) override
+	{
+		if (!node->isVisible())
+		{
+			return;
+		}
+
+		auto& list = node->getVisualModuleList();
+		for (auto iter = list.begin(); iter != list.end(); iter++)
+		{
+			if ((*iter)->isVisible())
+			{
+				(*iter)->display();
+			}
+		}
+	}
+};
+
 void SceneGraph::draw()
 {
 	if (m_root == nullptr)
@@ -66,6 +247,14 @@ void SceneGraph::draw()
 		return;
 	}
 
+	if (m_pipelined)
+	{
+		//the snapshot was taken in takeOneFrame, before the next frame's
+		//simulation was handed off
+		m_root->traverseTopDown<DisplayOnlyAct>();
+		return;
+	}
+
 	m_root->traverseTopDown<DrawAct>();
 }
 
@@ -75,7 +264,48 @@ void SceneGraph::advance(float dt)
 	//	aController->
 }
 
+void SceneGraph::setPipelinedFrames(bool enabled)
+{
+	if (!enabled && m_sim_in_flight.valid())
+	{
+		//drain the worker so the caller sees a fully simulated state
+		m_sim_in_flight.get();
+	}
+
+	m_pipelined = enabled;
+}
+
 void SceneGraph::takeOneFrame()
+{
+	if (!m_pipelined)
+	{
+		simulateOneFrame();
+		return;
+	}
+
+	//finish the frame launched last time; its state is what gets displayed
+	if (m_sim_in_flight.valid())
+	{
+		m_sim_in_flight.get();
+	}
+
+	if (m_root == nullptr)
+	{
+		return;
+	}
+
+	//copy the finished state into the render buffers on this thread - the
+	//VBO mapping needs the GL context - then let the worker simulate the
+	//next frame while the caller draws and the cache writer drains
+	ContextSnapshotAct snapshot;
+	m_root->traverseTopDown(&snapshot);
+
+	m_sim_in_flight = std::async(std::launch::async, [this]() {
+		simulateOneFrame();
+	});
+}
+
+void SceneGraph::simulateOneFrame()
 {
 	/*
 	if (m_root == nullptr)
@@ -90,7 +320,44 @@ void SceneGraph::takeOneFrame()
 		return;
 	}
 
-	
+	CTimer frameTimer;
+	frameTimer.start();
+
+	FrameArena::getInstance().reset();
+	NeighborStats::getInstance().beginFrame();
+	SyncAudit::getInstance().beginFrame();
+
+
+
+	//Per-node substepping: every node negotiates its own dt and covers the
+	//frame interval locally instead of the whole scene running at the
+	//smallest stable dt.
+	if (m_local_substep)
+	{
+		float interval = 1.0f / m_frameRate;
+		m_root->traverseTopDown<LocalSubstepAct>(interval);
+		m_elapsedTime += interval;
+
+		m_root->traverseTopDown<PostProcessing>();
+
+		NeighborStats::getInstance().endFrame();
+
+		//one sticky-error probe covers every launch of the frame
+		checkFrameSentinel(m_frameNumber);
+		if (SyncAudit::getInstance().isEnabled())
+		{
+			std::cout << SyncAudit::getInstance().report();
+		}
+
+		frameTimer.stop();
+		m_frameCost = (float)(frameTimer.getElapsedTime() * 1000.0);
+		FrameGovernor::getInstance().endFrame(m_frameCost);
+
+		std::cout << "****************Frame " << m_frameNumber << " Ended" << std::endl << std::endl;
+
+		m_frameNumber++;
+		return;
+	}
 
 	float t = 0.0f;
 	float dt = 0.0f;
@@ -103,7 +370,7 @@ void SceneGraph::takeOneFrame()
 
 	if (m_advative_interval)
 	{
-		m_root->traverseTopDown<AnimateAct>(dt);
+		animateOnePass(dt);
 		m_elapsedTime += dt;
 	}
 	else
@@ -111,7 +378,7 @@ void SceneGraph::takeOneFrame()
 		float interval = 1.0f / m_frameRate;
 		while (t + dt < interval)
 		{
-			m_root->traverseTopDown<AnimateAct>(dt);
+			animateOnePass(dt);
 
 			t += dt;
 			time.reset();
@@ -119,23 +386,75 @@ void SceneGraph::takeOneFrame()
 			dt = time.getTimeStep();
 		}
 
-		m_root->traverseTopDown<AnimateAct>(interval - t);
+		animateOnePass(interval - t);
 
 		m_elapsedTime += interval;
 	}
 	
 	m_root->traverseTopDown<PostProcessing>();
 
+	NeighborStats::getInstance().endFrame();
+
+	//one sticky-error probe covers every launch of the frame
+	checkFrameSentinel(m_frameNumber);
+	if (SyncAudit::getInstance().isEnabled())
+	{
+		std::cout << SyncAudit::getInstance().report();
+	}
+
+	frameTimer.stop();
+	m_frameCost = (float)(frameTimer.getElapsedTime() * 1000.0);
+	FrameGovernor::getInstance().endFrame(m_frameCost);
+
 	std::cout << "****************Frame " << m_frameNumber << " Ended" << std::endl << std::endl;
 
 	m_frameNumber++;
 }
 
+void SceneGraph::takeFrames(int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		takeOneFrame();
+	}
+
+	//leave no frame in flight: scripts read the state right after this
+	if (m_sim_in_flight.valid())
+	{
+		m_sim_in_flight.get();
+	}
+}
+
 void SceneGraph::run()
 {
 
 }
 
+void SceneGraph::clearScene()
+{
+	//an in-flight frame still touches the state about to be dropped
+	if (m_sim_in_flight.valid())
+	{
+		m_sim_in_flight.get();
+	}
+
+	//the scheduler holds node references and per-worker streams; stop it first
+	m_scheduler = nullptr;
+
+	//dropping the root runs the field/array destructors, which release the
+	//per-node device buffers
+	m_root = nullptr;
+
+	m_initialized = false;
+	m_frameNumber = 0;
+	m_elapsedTime = 0.0f;
+
+	//freed blocks sit in the caching pools until trimmed
+	FrameArena::getInstance().release();
+	CachingMemoryManager<DeviceType::GPU>::trim();
+	CachingMemoryManager<DeviceType::CPU>::trim();
+}
+
 void SceneGraph::reset()
 {
 	if (m_root == nullptr)
@@ -150,6 +469,17 @@ void SceneGraph::reset()
 
 bool SceneGraph::load(std::string name)
 {
+	//checkpoint files restore into the already constructed scene instead
+	//of rebuilding it from a description
+	if (name.size() > 8 && name.substr(name.size() - 8) == std::string(".pkstate"))
+	{
+		if (!m_initialized)
+		{
+			initialize();
+		}
+		return SceneSnapshot::restore(*this, name);
+	}
+
 	SceneLoader* loader = SceneLoaderFactory::getInstance().getEntryByFileName(name);
 	if (loader)
 	{
@@ -3,8 +3,11 @@
 #include "Node.h"
 #include "NodeIterator.h"
 
+#include <future>
+
 namespace PhysIKA {
 
+class TaskScheduler;
 
 class SceneGraph : public Base
 {
@@ -23,10 +26,27 @@ public:
 	virtual void draw();
 	virtual void advance(float dt);
 	virtual void takeOneFrame();
+
+	/**
+	 * @brief Advance n frames back to back without returning to the caller;
+	 * the Python bindings run this with the GIL released so scripted
+	 * parameter sweeps step headless at full speed.
+	 */
+	void takeFrames(int n);
+
 	virtual void run();
 
 	void reset();
 
+	/**
+	 * @brief Drop the scene and return its device memory. Releasing the root
+	 * lets the field/array destructors free the state buffers, and the
+	 * caching pools and frame arena are trimmed afterwards so a process can
+	 * set up and tear down hundreds of scenes without accumulating device
+	 * memory. The graph is left uninitialized with frame counters reset.
+	 */
+	void clearScene();
+
 	virtual bool load(std::string name);
 
 	virtual void invoke(unsigned char type, unsigned char key, int x, int y) {};
@@ -50,13 +70,158 @@ public:
 	inline float getTimeCostPerFrame() { return m_frameCost; }
 	inline float getFrameInterval() { return 1.0f / m_frameRate; }
 	inline int getFrameNumber() { return m_frameNumber; }
+	inline float getElapsedTime() { return m_elapsedTime; }
+
+	/**
+	 * @brief Checkpoint support: SceneSnapshot restores the frame counters
+	 * alongside the mechanical state, see SceneSnapshot.h.
+	 */
+	inline void setFrameNumber(int frame) { m_frameNumber = frame; }
+	inline void setElapsedTime(float t) { m_elapsedTime = t; }
 
 	bool isIntervalAdaptive();
 	void setAdaptiveInterval(bool adaptive);
 
+	/**
+	 * @brief Dispatch the animation pass through TaskScheduler instead of the
+	 * serial top-down traversal. Nodes with no path between them in the
+	 * tree/port dependency graph advance concurrently on worker threads,
+	 * each with its own CUDA stream. Pass 0 to size the pool from the
+	 * hardware concurrency.
+	 */
+	void setParallelExecution(bool enabled, int workerNum = 0);
+
+	/**
+	 * @brief Spread nodes without an explicit Node::setComputeDevice pin
+	 * round-robin across the visible CUDA devices; only effective together
+	 * with setParallelExecution. Cross-device field connections are read
+	 * over peer access, which the scheduler enables per dependency edge.
+	 */
+	void setDeviceRoundRobin(bool enabled);
+
+	/**
+	 * @brief Let every node cover the frame interval with substeps of its
+	 * own stable dt instead of clamping the whole scene to the smallest one;
+	 * nodes synchronize at frame boundaries. Scenes mixing slow and fast
+	 * materials stop paying the fast node's dt everywhere.
+	 */
+	void setLocalSubstepping(bool enabled);
+
+	/**
+	 * @brief Overlap frame N's render and cache write with frame N+1's
+	 * simulation. In pipelined mode takeOneFrame() first waits for the
+	 * in-flight simulation, then snapshots the render state (the visual
+	 * modules' updateRenderingContext pass, which needs the GL context and
+	 * so stays on the calling thread), and hands the next frame's
+	 * simulation to a worker thread before returning. The caller then
+	 * draws the snapshot and the async cache writer drains, while the
+	 * worker simulates - with sim, render and IO of similar cost the
+	 * frame time approaches the largest of the three instead of their
+	 * sum. Displayed frames lag the simulation by one frame. draw() skips
+	 * the context update in this mode; the snapshot already happened.
+	 */
+	void setPipelinedFrames(bool enabled);
+
 	void setGravity(Vector3f g);
 	Vector3f getGravity();
 
+	/**
+	 * @brief Per-module device-memory report (live and high-water bytes),
+	 * collected by MemoryStats; see setMemoryBudget for over-commit handling.
+	 */
+	std::string getMemoryReport();
+
+	/**
+	 * @brief Bracket every Module::update() with CUDA events and keep a
+	 * rolling per-module millisecond average; see getProfileReport(). The
+	 * event synchronization adds a small overhead per module, so leave this
+	 * off for production runs.
+	 */
+	void setProfilingEnabled(bool enabled);
+
+	/**
+	 * @brief Rolling per-module GPU timing collected by ModuleProfiler.
+	 */
+	std::string getProfileReport();
+
+	/**
+	 * @brief Bracket every kernel launched through the cuExecute macros
+	 * with CUDA events and aggregate launch count, kernel milliseconds
+	 * and occupancy per module; each module publishes its aggregate
+	 * through the kernel_* fields, see KernelStats. Costs one event pair
+	 * per launch, so leave this off for production runs.
+	 */
+	void setKernelStatsEnabled(bool enabled);
+
+	/**
+	 * @brief Cumulative per-kernel launch statistics from KernelStats.
+	 */
+	std::string getKernelReport();
+
+	/**
+	 * @brief Make repeated runs of the same scene bitwise reproducible.
+	 * Solvers replace their atomic scatter accumulation with fixed-order
+	 * gather sums, neighbor lists are sorted into ascending index order
+	 * after construction, and collision impulse queues are reduced in a
+	 * stable order. Costs roughly an extra neighbor sweep per affected
+	 * kernel, so leave this off when throughput matters more than
+	 * replayability.
+	 */
+	void setDeterministic(bool enabled);
+	bool isDeterministic();
+
+	/**
+	 * @brief Frame-time budget in milliseconds; 0 (the default) disables
+	 * quality scaling. When the rolling frame cost overruns the budget,
+	 * the FrameGovernor degrades registered module knobs (solver
+	 * iterations, early-exit tolerances, cosmetic force terms) in
+	 * priority order, and restores them once the scene stays comfortably
+	 * under budget; see getGovernorReport().
+	 */
+	void setFrameTimeBudget(float ms);
+
+	/**
+	 * @brief Current budget, rolling frame cost and per-knob degradation
+	 * levels from FrameGovernor.
+	 */
+	std::string getGovernorReport();
+
+	/**
+	 * @brief Record named CPU and GPU ranges (Node::advance,
+	 * Module::update, the IO writer thread) into the TraceProfiler ring
+	 * buffer for a sim/render/IO timeline; see exportTrace().
+	 */
+	void setTracingEnabled(bool enabled);
+
+	/**
+	 * @brief Write the recorded timeline as chrome://tracing JSON.
+	 */
+	bool exportTrace(std::string fileName);
+
+	/**
+	 * @brief Last frame's neighbor-search health counters from
+	 * NeighborStats: neighbors dropped from capacity-limited lists,
+	 * particles outside the hash domain and the neighbor-count
+	 * histogram. Nonzero drop counts are the early warning for silent
+	 * quality loss.
+	 */
+	std::string getNeighborReport();
+
+	/**
+	 * @brief Device-byte budget; allocations beyond it evict cached scratch
+	 * blocks before failing. Pass 0 to disable.
+	 */
+	void setMemoryBudget(size_t bytes);
+
+	/**
+	 * @brief Allow the scene to exceed VRAM: allocations that still fail
+	 * after trimming the caching pool fall back to managed memory the
+	 * driver can page. Cold arrays should additionally be placed through
+	 * Node::coldArrayManager() so the sleep/active staging keeps the
+	 * paging off the solver's critical path.
+	 */
+	void setMemoryOversubscription(bool enabled);
+
 	Vector3f getLowerBound();
 	Vector3f getUpperBound();
 
@@ -80,6 +245,14 @@ private:
 		m_gravity = Vector3f(0.0f, -9.8f, 0.0f);
 	};
 
+	void animateOnePass(float dt);
+
+	/**
+	 * @brief One frame of pure simulation plus post-processing; the body of
+	 * takeOneFrame(), run on a worker thread in pipelined mode.
+	 */
+	void simulateOneFrame();
+
 	/**
 	* To avoid erroneous operations
 	*/
@@ -89,6 +262,8 @@ private:
 private:
 	bool m_initialized;
 	bool m_advative_interval = true;
+	bool m_local_substep = false;
+	bool m_deterministic = false;
 
 	float m_elapsedTime;
 	float m_maxTime;
@@ -104,6 +279,15 @@ private:
 
 private:
 	std::shared_ptr<Node> m_root = nullptr;
+
+	bool m_parallel = false;
+	bool m_roundRobinDevices = false;
+	int m_workerNum = 0;
+	std::shared_ptr<TaskScheduler> m_scheduler = nullptr;
+
+	//pipelined frame mode; see setPipelinedFrames
+	bool m_pipelined = false;
+	std::future<void> m_sim_in_flight;
 };
 
 }
\ No newline at end of file
@@ -1,11 +1,252 @@
 #include "SceneLoaderXML.h"
 #include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
 #include "Framework/ModuleTypes.h"
 
 namespace PhysIKA
 {
+	namespace
+	{
+		const char* ASSET_EXTENSIONS[] = { ".obj", ".sdf", ".sdfb", ".smesh", ".pcache", ".png", ".bmp", ".jpg", ".ppm" };
+
+		bool looksLikeAsset(const std::string& value)
+		{
+			for (size_t e = 0; e < sizeof(ASSET_EXTENSIONS) / sizeof(ASSET_EXTENSIONS[0]); e++)
+			{
+				std::string ext = ASSET_EXTENSIONS[e];
+				if (value.size() > ext.size() && value.compare(value.size() - ext.size(), ext.size(), ext) == 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void collectAssets(tinyxml2::XMLElement* element, const std::string& baseDir, std::set<std::string>& manifest)
+		{
+			for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr; attr = attr->Next())
+			{
+				std::string value = attr->Value();
+				if (!looksLikeAsset(value))
+				{
+					continue;
+				}
+
+				//paths may be relative to the scene file or to the working directory
+				FILE* file = fopen(value.c_str(), "rb");
+				if (file == NULL && !baseDir.empty())
+				{
+					value = baseDir + value;
+					file = fopen(value.c_str(), "rb");
+				}
+				if (file != NULL)
+				{
+					fclose(file);
+					manifest.insert(value);
+				}
+			}
+
+			for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement())
+			{
+				collectAssets(child, baseDir, manifest);
+			}
+		}
+
+		//---- compiled scene cache ------------------------------------------
+
+		const char COMPILED_MAGIC[4] = { 'P', 'S', 'C', 'B' };
+		const int COMPILED_VERSION = 1;
+
+		enum CompiledRecord
+		{
+			REC_NODE_BEGIN = 0,
+			REC_NODE_END = 1,
+			REC_MODULE = 2
+		};
+
+		bool sourceStamp(const std::string& file, long long& size, long long& mtime)
+		{
+			struct stat info;
+			if (stat(file.c_str(), &info) != 0)
+			{
+				return false;
+			}
+			size = (long long)info.st_size;
+			mtime = (long long)info.st_mtime;
+			return true;
+		}
+
+		int internString(const std::string& s, std::vector<std::string>& table, std::map<std::string, int>& index)
+		{
+			std::map<std::string, int>::iterator it = index.find(s);
+			if (it != index.end())
+			{
+				return it->second;
+			}
+			int id = (int)table.size();
+			table.push_back(s);
+			index[s] = id;
+			return id;
+		}
+
+		void compileNode(tinyxml2::XMLElement* nodeXML, std::vector<int>& records,
+			std::vector<std::string>& table, std::map<std::string, int>& index)
+		{
+			const char* name = nodeXML->Attribute("class");
+			if (!name)
+			{
+				return;
+			}
+
+			records.push_back(REC_NODE_BEGIN);
+			records.push_back(internString(name, table, index));
+			const char* nodeName = nodeXML->Attribute("name");
+			records.push_back(nodeName ? internString(nodeName, table, index) : -1);
+
+			//children before modules, mirroring processNode
+			tinyxml2::XMLElement* childXML = nodeXML->FirstChildElement("Node");
+			while (childXML)
+			{
+				compileNode(childXML, records, table, index);
+				childXML = childXML->NextSiblingElement("Node");
+			}
+
+			tinyxml2::XMLElement* moduleXML = nodeXML->FirstChildElement("Module");
+			while (moduleXML)
+			{
+				const char* className = moduleXML->Attribute("class");
+				if (className)
+				{
+					//store the full templated name the factory is keyed on
+					const char* dataType = moduleXML->Attribute("datatype");
+					std::string templateClass = std::string(className);
+					if (dataType)
+					{
+						templateClass += std::string("<") + std::string(dataType) + std::string(">");
+					}
+
+					records.push_back(REC_MODULE);
+					records.push_back(internString(templateClass, table, index));
+					const char* dependence = moduleXML->Attribute("dependence");
+					records.push_back(dependence ? internString(dependence, table, index) : -1);
+				}
+				moduleXML = moduleXML->NextSiblingElement("Module");
+			}
+
+			records.push_back(REC_NODE_END);
+		}
+
+		void appendBytes(std::vector<char>& out, const void* data, size_t bytes)
+		{
+			const char* p = (const char*)data;
+			out.insert(out.end(), p, p + bytes);
+		}
+
+		void appendInt(std::vector<char>& out, int v)
+		{
+			appendBytes(out, &v, sizeof(int));
+		}
+
+		/// cursor over the compiled blob; every read is bounds checked
+		struct BlobReader
+		{
+			const char* data;
+			size_t size;
+			size_t pos;
+			bool ok;
+
+			BlobReader(const std::vector<char>& blob)
+				: data(blob.data()), size(blob.size()), pos(0), ok(true) {}
+
+			bool read(void* dst, size_t bytes)
+			{
+				if (!ok || pos + bytes > size)
+				{
+					ok = false;
+					return false;
+				}
+				memcpy(dst, data + pos, bytes);
+				pos += bytes;
+				return true;
+			}
+
+			int readInt()
+			{
+				int v = 0;
+				read(&v, sizeof(int));
+				return v;
+			}
+		};
+	}
+
+	void SceneLoaderXML::prefetchAssets(tinyxml2::XMLElement* root, const std::string& baseDir)
+	{
+		std::set<std::string> manifest;
+		collectAssets(root, baseDir, manifest);
+
+		std::vector<std::string> files(manifest.begin(), manifest.end());
+		prefetchFiles(files);
+	}
+
+	void SceneLoaderXML::prefetchFiles(const std::vector<std::string>& files)
+	{
+		if (files.empty())
+		{
+			return;
+		}
+
+		//one file per worker at a time, read in large sequential blocks so
+		//every asset's round-trips overlap instead of queueing behind node init
+		std::atomic<size_t> next(0);
+		unsigned int workerNum = std::thread::hardware_concurrency();
+		if (workerNum == 0) workerNum = 4;
+		if (workerNum > 8) workerNum = 8;
+		if (workerNum > files.size()) workerNum = (unsigned int)files.size();
+
+		std::vector<std::thread> workers;
+		for (unsigned int w = 0; w < workerNum; w++)
+		{
+			workers.push_back(std::thread([&files, &next]() {
+				const size_t blockBytes = 4 * 1024 * 1024;
+				std::vector<char> block(blockBytes);
+				for (size_t i = next++; i < files.size(); i = next++)
+				{
+					FILE* file = fopen(files[i].c_str(), "rb");
+					if (file == NULL)
+					{
+						continue;
+					}
+					while (fread(block.data(), 1, blockBytes, file) == blockBytes)
+					{
+					}
+					fclose(file);
+				}
+			}));
+		}
+
+		for (size_t w = 0; w < workers.size(); w++)
+		{
+			workers[w].join();
+		}
+	}
+
 	std::shared_ptr<Node> SceneLoaderXML::load(const std::string filename)
 	{
+		std::string compiled = filename + "b";
+
+		auto cached = loadCompiled(filename, compiled);
+		if (cached != nullptr)
+		{
+			return cached;
+		}
+
 		tinyxml2::XMLDocument doc;
 		if (doc.LoadFile(filename.c_str()))
 		{
@@ -16,7 +257,270 @@ namespace PhysIKA
 		tinyxml2::XMLElement* scenegraph = doc.RootElement();
 		tinyxml2::XMLElement* rootXML  = scenegraph->FirstChildElement("Node");
 
-		return processNode(rootXML);
+		std::string::size_type slash = filename.find_last_of("/\\");
+		std::string baseDir = slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+		prefetchAssets(scenegraph, baseDir);
+
+		auto root = processNode(rootXML);
+		if (root != nullptr)
+		{
+			saveCompiled(scenegraph, filename, compiled, baseDir);
+		}
+
+		return root;
+	}
+
+	std::shared_ptr<Node> SceneLoaderXML::loadCompiled(const std::string& xmlFile, const std::string& compiledFile)
+	{
+		long long xmlSize, xmlMtime;
+		if (!sourceStamp(xmlFile, xmlSize, xmlMtime))
+		{
+			return nullptr;
+		}
+
+		FILE* file = fopen(compiledFile.c_str(), "rb");
+		if (file == NULL)
+		{
+			return nullptr;
+		}
+
+		fseek(file, 0, SEEK_END);
+		long bytes = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		std::vector<char> blob(bytes > 0 ? bytes : 0);
+		bool readAll = bytes > 0 && fread(blob.data(), 1, bytes, file) == (size_t)bytes;
+		fclose(file);
+		if (!readAll)
+		{
+			return nullptr;
+		}
+
+		BlobReader in(blob);
+
+		char magic[4];
+		if (!in.read(magic, 4) || memcmp(magic, COMPILED_MAGIC, 4) != 0)
+		{
+			return nullptr;
+		}
+		if (in.readInt() != COMPILED_VERSION)
+		{
+			return nullptr;
+		}
+
+		//stale caches fall back to the XML path, which rewrites them
+		long long size, mtime;
+		in.read(&size, sizeof(long long));
+		in.read(&mtime, sizeof(long long));
+		if (!in.ok || size != xmlSize || mtime != xmlMtime)
+		{
+			return nullptr;
+		}
+
+		int stringNum = in.readInt();
+		if (!in.ok || stringNum < 0)
+		{
+			return nullptr;
+		}
+		std::vector<std::string> table(stringNum);
+		for (int i = 0; i < stringNum; i++)
+		{
+			int len = in.readInt();
+			if (!in.ok || len < 0 || in.pos + len > in.size)
+			{
+				return nullptr;
+			}
+			table[i].assign(in.data + in.pos, len);
+			in.pos += len;
+		}
+
+		int assetNum = in.readInt();
+		if (!in.ok || assetNum < 0)
+		{
+			return nullptr;
+		}
+		std::vector<std::string> assets;
+		for (int i = 0; i < assetNum; i++)
+		{
+			int id = in.readInt();
+			if (!in.ok || id < 0 || id >= stringNum)
+			{
+				return nullptr;
+			}
+			assets.push_back(table[id]);
+		}
+
+		int recordNum = in.readInt();
+		if (!in.ok || recordNum < 0 || in.pos + (size_t)recordNum * sizeof(int) > in.size)
+		{
+			return nullptr;
+		}
+		std::vector<int> records(recordNum);
+		if (recordNum > 0)
+		{
+			memcpy(records.data(), in.data + in.pos, (size_t)recordNum * sizeof(int));
+		}
+
+		prefetchFiles(assets);
+
+		//each distinct class name hits the factory map once, not once per element
+		std::map<std::string, ClassInfo*>* classMap = Object::getClassMap();
+		std::vector<ClassInfo*> resolved(stringNum, nullptr);
+
+		std::shared_ptr<Node> root = nullptr;
+		std::vector<std::shared_ptr<Node>> stack;
+
+		size_t r = 0;
+		while (r < records.size())
+		{
+			int rec = records[r++];
+			if (rec == REC_NODE_BEGIN)
+			{
+				if (r + 2 > records.size()) return nullptr;
+				int classId = records[r++];
+				int nameId = records[r++];
+				if (classId < 0 || classId >= stringNum) return nullptr;
+
+				if (resolved[classId] == nullptr)
+				{
+					std::map<std::string, ClassInfo*>::iterator it = classMap->find(table[classId]);
+					if (it == classMap->end())
+					{
+						std::cout << table[classId] << " does not exist! " << std::endl;
+						return nullptr;
+					}
+					resolved[classId] = it->second;
+				}
+
+				std::shared_ptr<Node> node(dynamic_cast<Node*>(resolved[classId]->createObject()));
+				if (node == nullptr)
+				{
+					return nullptr;
+				}
+				if (nameId >= 0 && nameId < stringNum)
+				{
+					node->setName(table[nameId]);
+				}
+
+				if (!stack.empty())
+				{
+					stack.back()->addChild(node);
+				}
+				else if (root == nullptr)
+				{
+					root = node;
+				}
+				stack.push_back(node);
+			}
+			else if (rec == REC_NODE_END)
+			{
+				if (stack.empty()) return nullptr;
+				stack.pop_back();
+			}
+			else if (rec == REC_MODULE)
+			{
+				if (r + 2 > records.size() || stack.empty()) return nullptr;
+				int classId = records[r++];
+				int depId = records[r++];
+				if (classId < 0 || classId >= stringNum) return nullptr;
+
+				if (resolved[classId] == nullptr)
+				{
+					std::map<std::string, ClassInfo*>::iterator it = classMap->find(table[classId]);
+					if (it == classMap->end())
+					{
+						std::cout << "Create Module " << table[classId] << " failed!" << std::endl;
+						continue;
+					}
+					resolved[classId] = it->second;
+				}
+
+				std::shared_ptr<Module> module(dynamic_cast<Module*>(resolved[classId]->createObject()));
+				if (module == nullptr)
+				{
+					std::cout << "Create Module " << table[classId] << " failed!" << std::endl;
+					continue;
+				}
+
+				bool re = addModule(stack.back(), module);
+				if (!re)
+				{
+					std::cout << "Cannot add " << table[classId] << " to the current node!" << std::endl;
+				}
+				else if (depId >= 0 && depId < stringNum)
+				{
+					connectDependence(stack.back(), module, table[depId]);
+				}
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		return root;
+	}
+
+	void SceneLoaderXML::saveCompiled(tinyxml2::XMLElement* scenegraph, const std::string& xmlFile, const std::string& compiledFile, const std::string& baseDir)
+	{
+		long long xmlSize, xmlMtime;
+		if (!sourceStamp(xmlFile, xmlSize, xmlMtime))
+		{
+			return;
+		}
+
+		tinyxml2::XMLElement* rootXML = scenegraph->FirstChildElement("Node");
+		if (rootXML == NULL)
+		{
+			return;
+		}
+
+		std::vector<std::string> table;
+		std::map<std::string, int> index;
+		std::vector<int> records;
+		compileNode(rootXML, records, table, index);
+
+		std::set<std::string> manifest;
+		collectAssets(scenegraph, baseDir, manifest);
+		std::vector<int> assetIds;
+		for (std::set<std::string>::iterator it = manifest.begin(); it != manifest.end(); it++)
+		{
+			assetIds.push_back(internString(*it, table, index));
+		}
+
+		std::vector<char> out;
+		appendBytes(out, COMPILED_MAGIC, 4);
+		appendInt(out, COMPILED_VERSION);
+		appendBytes(out, &xmlSize, sizeof(long long));
+		appendBytes(out, &xmlMtime, sizeof(long long));
+
+		appendInt(out, (int)table.size());
+		for (size_t i = 0; i < table.size(); i++)
+		{
+			appendInt(out, (int)table[i].size());
+			appendBytes(out, table[i].data(), table[i].size());
+		}
+
+		appendInt(out, (int)assetIds.size());
+		for (size_t i = 0; i < assetIds.size(); i++)
+		{
+			appendInt(out, assetIds[i]);
+		}
+
+		appendInt(out, (int)records.size());
+		if (!records.empty())
+		{
+			appendBytes(out, records.data(), records.size() * sizeof(int));
+		}
+
+		//best effort: a scene that cannot cache still loads from XML next time
+		FILE* file = fopen(compiledFile.c_str(), "wb");
+		if (file == NULL)
+		{
+			return;
+		}
+		fwrite(out.data(), 1, out.size(), file);
+		fclose(file);
 	}
 
 	std::shared_ptr<Node> SceneLoaderXML::processNode(tinyxml2::XMLElement* nodeXML)
@@ -67,31 +571,11 @@ namespace PhysIKA
 
 				if (dependence)
 				{
-					if (module->getModuleType() == "CollisionModel")
-					{
-						auto cModel = std::dynamic_pointer_cast<CollisionModel>(module);
-						std::vector<std::string> strs = split(std::string(dependence), std::string(" "));
-						for (int i = 0; i < strs.size(); i++)
-						{
-							if (node->getName() == strs[i])
-							{
-								cModel->addCollidableObject(node->getCollidableObject());
-							}
-							auto children = node->getChildren();
-							std::list< std::shared_ptr<Node> >::iterator it = children.begin();
-							for (; it != children.end(); it++)
-							{
-								if ((*it)->getName() == strs[i])
-								{
-									cModel->addCollidableObject((*it)->getCollidableObject());
-								}
-							}
-						}
-					}
+					connectDependence(node, module, std::string(dependence));
 				}
-				
+
 			}
-			
+
 			moduleXML = moduleXML->NextSiblingElement("Module");
 		}
 
@@ -160,6 +644,31 @@ namespace PhysIKA
 		return false;
 	}
 
+	void SceneLoaderXML::connectDependence(std::shared_ptr<Node> node, std::shared_ptr<Module> module, const std::string& dependence)
+	{
+		if (module->getModuleType() == "CollisionModel")
+		{
+			auto cModel = std::dynamic_pointer_cast<CollisionModel>(module);
+			std::vector<std::string> strs = split(dependence, std::string(" "));
+			for (int i = 0; i < strs.size(); i++)
+			{
+				if (node->getName() == strs[i])
+				{
+					cModel->addCollidableObject(node->getCollidableObject());
+				}
+				auto children = node->getChildren();
+				std::list< std::shared_ptr<Node> >::iterator it = children.begin();
+				for (; it != children.end(); it++)
+				{
+					if ((*it)->getName() == strs[i])
+					{
+						cModel->addCollidableObject((*it)->getCollidableObject());
+					}
+				}
+			}
+		}
+	}
+
 	std::vector<std::string> SceneLoaderXML::split(std::string str, std::string pattern)
 	{
 		std::string::size_type pos;
@@ -187,4 +696,4 @@ namespace PhysIKA
 		return (extension == "xml");
 	}
 
-}
\ No newline at end of file
+}
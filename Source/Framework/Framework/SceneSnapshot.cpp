@@ -0,0 +1,220 @@
+#include "SceneSnapshot.h"
+#include "SceneGraph.h"
+#include "Node.h"
+#include "MechanicalState.h"
+#include "Field.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace PhysIKA
+{
+	namespace
+	{
+		const char SNAPSHOT_MAGIC[8] = { 'P', 'K', 'S', 'T', 'A', 'T', 'E', '\0' };
+
+		struct SnapshotHeader
+		{
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t nodeNum;
+			std::uint32_t frameNumber;
+			float elapsedTime;
+		};
+
+		struct FieldRecord
+		{
+			std::string name;
+			std::uint32_t elementBytes;
+			std::uint64_t elementCount;
+			std::vector<char> payload;
+		};
+
+		void writeString(std::ofstream& out, const std::string& str)
+		{
+			std::uint32_t len = (std::uint32_t)str.size();
+			out.write((const char*)&len, sizeof(len));
+			out.write(str.data(), len);
+		}
+
+		bool readString(std::ifstream& in, std::string& str)
+		{
+			std::uint32_t len = 0;
+			in.read((char*)&len, sizeof(len));
+			if (!in) return false;
+
+			str.resize(len);
+			if (len > 0)
+			{
+				in.read(&str[0], len);
+			}
+			return (bool)in;
+		}
+
+		/**
+		 * Gather every dumpable field of owner: trivially copyable element
+		 * type, non-empty, and a successful raw dump.
+		 */
+		void gatherFields(Base* owner, std::vector<FieldRecord>& records)
+		{
+			if (owner == nullptr) return;
+
+			std::vector<Field*>& fields = owner->getAllFields();
+			for (size_t i = 0; i < fields.size(); i++)
+			{
+				Field* f = fields[i];
+				size_t elementBytes = f->getElementBytes();
+				if (elementBytes == 0 || f->isEmpty())
+					continue;
+
+				FieldRecord rec;
+				rec.name = f->getObjectName();
+				rec.elementBytes = (std::uint32_t)elementBytes;
+				rec.elementCount = (std::uint64_t)f->getElementCount();
+				rec.payload.resize(rec.elementCount * elementBytes);
+				if (!f->dumpRawData(rec.payload.data()))
+					continue;
+
+				records.push_back(std::move(rec));
+			}
+		}
+
+		void writeFieldSection(std::ofstream& out, std::vector<FieldRecord>& records)
+		{
+			std::uint32_t fieldNum = (std::uint32_t)records.size();
+			out.write((const char*)&fieldNum, sizeof(fieldNum));
+
+			for (size_t i = 0; i < records.size(); i++)
+			{
+				FieldRecord& rec = records[i];
+				writeString(out, rec.name);
+				out.write((const char*)&rec.elementBytes, sizeof(rec.elementBytes));
+				out.write((const char*)&rec.elementCount, sizeof(rec.elementCount));
+				out.write(rec.payload.data(), rec.payload.size());
+			}
+		}
+
+		/**
+		 * Apply one stored field section to owner. Fields missing from the
+		 * owner or whose element size changed are skipped, the stream just
+		 * seeks over their payload.
+		 */
+		bool readFieldSection(std::ifstream& in, Base* owner)
+		{
+			std::uint32_t fieldNum = 0;
+			in.read((char*)&fieldNum, sizeof(fieldNum));
+			if (!in) return false;
+
+			for (std::uint32_t i = 0; i < fieldNum; i++)
+			{
+				std::string name;
+				std::uint32_t elementBytes = 0;
+				std::uint64_t elementCount = 0;
+
+				if (!readString(in, name)) return false;
+				in.read((char*)&elementBytes, sizeof(elementBytes));
+				in.read((char*)&elementCount, sizeof(elementCount));
+				if (!in) return false;
+
+				std::uint64_t payloadBytes = elementCount * elementBytes;
+
+				Field* f = owner != nullptr ? owner->getField(name) : nullptr;
+				if (f == nullptr || f->getElementBytes() != elementBytes)
+				{
+					in.seekg(payloadBytes, std::ios::cur);
+					continue;
+				}
+
+				std::vector<char> payload(payloadBytes);
+				if (payloadBytes > 0)
+				{
+					in.read(payload.data(), payloadBytes);
+					if (!in) return false;
+				}
+
+				f->loadRawData(payload.data(), (size_t)elementCount);
+			}
+
+			return true;
+		}
+
+		void collectNodes(SceneGraph& scene, std::vector<std::shared_ptr<Node>>& nodes)
+		{
+			for (auto it = scene.begin(); it != scene.end(); it++)
+			{
+				nodes.push_back(it.get());
+			}
+		}
+	}
+
+	bool SceneSnapshot::save(SceneGraph& scene, const std::string& filename)
+	{
+		std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+		if (!out) return false;
+
+		std::vector<std::shared_ptr<Node>> nodes;
+		collectNodes(scene, nodes);
+
+		SnapshotHeader header;
+		std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+		header.version = 1;
+		header.nodeNum = (std::uint32_t)nodes.size();
+		header.frameNumber = (std::uint32_t)scene.getFrameNumber();
+		header.elapsedTime = scene.getElapsedTime();
+		out.write((const char*)&header, sizeof(header));
+
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			writeString(out, nodes[i]->getName());
+
+			std::vector<FieldRecord> nodeFields;
+			gatherFields(nodes[i].get(), nodeFields);
+			writeFieldSection(out, nodeFields);
+
+			std::vector<FieldRecord> stateFields;
+			gatherFields(nodes[i]->getMechanicalState().get(), stateFields);
+			writeFieldSection(out, stateFields);
+		}
+
+		return (bool)out;
+	}
+
+	bool SceneSnapshot::restore(SceneGraph& scene, const std::string& filename)
+	{
+		std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+		if (!in) return false;
+
+		SnapshotHeader header;
+		in.read((char*)&header, sizeof(header));
+		if (!in || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.version != 1)
+		{
+			return false;
+		}
+
+		std::vector<std::shared_ptr<Node>> nodes;
+		collectNodes(scene, nodes);
+		if (nodes.size() != header.nodeNum)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			std::string name;
+			if (!readString(in, name) || name != nodes[i]->getName())
+			{
+				return false;
+			}
+
+			if (!readFieldSection(in, nodes[i].get())) return false;
+			if (!readFieldSection(in, nodes[i]->getMechanicalState().get())) return false;
+		}
+
+		scene.setFrameNumber((int)header.frameNumber);
+		scene.setElapsedTime(header.elapsedTime);
+
+		return true;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+namespace PhysIKA
+{
+	class SceneGraph;
+
+	/*!
+	*	\class	SceneSnapshot
+	*	\brief	Binary checkpoint of a running scene.
+	*
+	*	save() walks the scene graph and dumps every trivially copyable
+	*	field of each node and of its MechanicalState — positions,
+	*	velocities, attributes, solver state — together with the frame
+	*	counters into one binary file. restore() loads such a file back
+	*	into a scene built by the same program: node structure and field
+	*	names are matched against the file, field contents are overwritten
+	*	in place and derived data (neighbor lists, rest shapes held in
+	*	fields) comes back exactly as checkpointed, so a crashed multi-hour
+	*	run resumes from its last snapshot instead of re-simulating.
+	*
+	*	SceneGraph::load() dispatches to restore() for *.pkstate files.
+	*/
+	class SceneSnapshot
+	{
+	public:
+		/**
+		 * @brief Write the current state of the scene to filename.
+		 */
+		static bool save(SceneGraph& scene, const std::string& filename);
+
+		/**
+		 * @brief Overwrite the state of an initialized scene from
+		 * filename. Fails when the node structure does not match the
+		 * checkpoint; fields present in only one of the two are skipped.
+		 */
+		static bool restore(SceneGraph& scene, const std::string& filename);
+	};
+}
@@ -0,0 +1,326 @@
+#include "TaskScheduler.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Framework/NodePort.h"
+#include "Framework/Framework/Module.h"
+#include "Framework/Framework/Log.h"
+#include "Core/Utility/TraceProfiler.h"
+
+#include <unordered_map>
+
+namespace PhysIKA
+{
+	static thread_local cudaStream_t t_workerStream = 0;
+
+	TaskScheduler::TaskScheduler(int workerNum)
+	{
+		int num = workerNum > 0 ? workerNum : (int)std::thread::hardware_concurrency();
+		num = num > 0 ? num : 2;
+
+		cudaGetDevice(&m_primaryDevice);
+		cudaGetDeviceCount(&m_deviceNum);
+		if (m_deviceNum < 1)
+		{
+			m_deviceNum = 1;
+		}
+		m_deviceStreams.resize(num);
+
+		m_streams.resize(num);
+		for (int i = 0; i < num; i++)
+		{
+			cudaStreamCreate(&m_streams[i]);
+			m_workers.push_back(std::thread(&TaskScheduler::workerLoop, this, i));
+		}
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_shutdown = true;
+		}
+		m_workAvailable.notify_all();
+
+		for (size_t i = 0; i < m_workers.size(); i++)
+		{
+			m_workers[i].join();
+			cudaStreamDestroy(m_streams[i]);
+
+			for (auto it = m_deviceStreams[i].begin(); it != m_deviceStreams[i].end(); ++it)
+			{
+				cudaSetDevice(it->first);
+				cudaStreamDestroy(it->second);
+			}
+		}
+		cudaSetDevice(m_primaryDevice);
+	}
+
+	int TaskScheduler::deviceOf(Node* node)
+	{
+		int device = node->getComputeDevice();
+		return device >= 0 && device < m_deviceNum ? device : m_primaryDevice;
+	}
+
+	cudaStream_t TaskScheduler::streamForDevice(int workerId, int device)
+	{
+		if (device == m_primaryDevice)
+		{
+			return m_streams[workerId];
+		}
+
+		//each worker only ever touches its own map, so no locking is needed
+		auto it = m_deviceStreams[workerId].find(device);
+		if (it != m_deviceStreams[workerId].end())
+		{
+			return it->second;
+		}
+
+		cudaStream_t stream;
+		cudaStreamCreate(&stream);
+		m_deviceStreams[workerId][device] = stream;
+		return stream;
+	}
+
+	bool TaskScheduler::enablePeerPair(int devA, int devB)
+	{
+		if (devA == devB)
+		{
+			return true;
+		}
+
+		long long key = devA < devB
+			? ((long long)devA << 32) | (long long)devB
+			: ((long long)devB << 32) | (long long)devA;
+		if (m_peerPairs.find(key) != m_peerPairs.end())
+		{
+			return true;
+		}
+
+		int canForward = 0;
+		int canBackward = 0;
+		cudaDeviceCanAccessPeer(&canForward, devA, devB);
+		cudaDeviceCanAccessPeer(&canBackward, devB, devA);
+		if (!canForward || !canBackward)
+		{
+			return false;
+		}
+
+		cudaSetDevice(devA);
+		cudaDeviceEnablePeerAccess(devB, 0);
+		cudaSetDevice(devB);
+		cudaDeviceEnablePeerAccess(devA, 0);
+		cudaGetLastError();	//already-enabled is fine
+		cudaSetDevice(m_primaryDevice);
+
+		m_peerPairs.insert(key);
+		return true;
+	}
+
+	cudaStream_t TaskScheduler::currentStream()
+	{
+		return t_workerStream;
+	}
+
+	void TaskScheduler::collectNodes(std::shared_ptr<Node> node)
+	{
+		if (node == nullptr)
+		{
+			return;
+		}
+
+		m_nodes.push_back(node.get());
+
+		auto& children = node->getChildren();
+		for (auto it = children.begin(); it != children.end(); ++it)
+		{
+			collectNodes(*it);
+		}
+	}
+
+	void TaskScheduler::animate(std::shared_ptr<Node> root)
+	{
+		m_initPass = false;
+		dispatch(root, false);
+	}
+
+	void TaskScheduler::initialize(std::shared_ptr<Node> root)
+	{
+		m_initPass = true;
+		dispatch(root, true);
+	}
+
+	void TaskScheduler::dispatch(std::shared_ptr<Node> root, bool bottomUp)
+	{
+		m_nodes.clear();
+		collectNodes(root);
+
+		int num = (int)m_nodes.size();
+		if (num == 0)
+		{
+			return;
+		}
+
+		std::unordered_map<Node*, int> ids;
+		for (int i = 0; i < num; i++)
+		{
+			ids[m_nodes[i]] = i;
+		}
+
+		//spread unpinned nodes over the visible devices; the pin sticks to
+		//the node, so the assignment is stable across frames
+		if (m_roundRobin && m_deviceNum > 1)
+		{
+			int next = 0;
+			for (int i = 0; i < num; i++)
+			{
+				if (m_nodes[i]->getComputeDevice() < 0)
+				{
+					m_nodes[i]->setComputeDevice(next % m_deviceNum);
+					next++;
+				}
+			}
+		}
+
+		m_successors.assign(num, std::vector<int>());
+		m_indegree.assign(num, 0);
+
+		for (int i = 0; i < num; i++)
+		{
+			Node* node = m_nodes[i];
+
+			//the animation pass advances parents before children; the init
+			//pass runs bottom-up, so its tree edges are reversed
+			auto& children = node->getChildren();
+			for (auto it = children.begin(); it != children.end(); ++it)
+			{
+				auto cit = ids.find((*it).get());
+				if (cit != ids.end())
+				{
+					int from = bottomUp ? cit->second : i;
+					int to = bottomUp ? i : cit->second;
+					m_successors[from].push_back(to);
+					m_indegree[to]++;
+				}
+			}
+
+			//a port connection means the providing node feeds this one
+			auto& ports = node->getAllNodePorts();
+			for (size_t p = 0; p < ports.size(); p++)
+			{
+				auto& sources = ports[p]->getNodes();
+				for (size_t k = 0; k < sources.size(); k++)
+				{
+					if (sources[k] == nullptr)
+					{
+						continue;
+					}
+					auto sit = ids.find(sources[k].get());
+					if (sit != ids.end() && sit->second != i)
+					{
+						m_successors[sit->second].push_back(i);
+						m_indegree[i]++;
+					}
+				}
+			}
+		}
+
+		//a dependency edge across two devices means the consumer reads the
+		//provider's buffers remotely; make sure the pair can reach each
+		//other, otherwise co-locate the consumer with its provider
+		for (int i = 0; i < num; i++)
+		{
+			for (size_t k = 0; k < m_successors[i].size(); k++)
+			{
+				Node* provider = m_nodes[i];
+				Node* consumer = m_nodes[m_successors[i][k]];
+				if (!enablePeerPair(deviceOf(provider), deviceOf(consumer)))
+				{
+					Log::sendMessage(Log::Warning, "TaskScheduler: no peer access between the devices of " + provider->getName() + " and " + consumer->getName() + ", co-locating them");
+					consumer->setComputeDevice(deviceOf(provider));
+				}
+			}
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_pending = num;
+			for (int i = 0; i < num; i++)
+			{
+				if (m_indegree[i] == 0)
+				{
+					m_ready.push(i);
+				}
+			}
+		}
+		m_workAvailable.notify_all();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_frameDone.wait(lock, [this] { return m_pending == 0; });
+	}
+
+	void TaskScheduler::workerLoop(int workerId)
+	{
+		TraceProfiler::getInstance().nameCurrentThread("worker " + std::to_string(workerId));
+
+		while (true)
+		{
+			int task = -1;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_workAvailable.wait(lock, [this] { return m_shutdown || !m_ready.empty(); });
+
+				if (m_shutdown)
+				{
+					return;
+				}
+
+				task = m_ready.front();
+				m_ready.pop();
+			}
+
+			Node* node = m_nodes[task];
+
+			//run the task with the node's device current, so its state is
+			//allocated and advanced where the node is pinned
+			int device = deviceOf(node);
+			cudaSetDevice(device);
+			cudaStream_t stream = streamForDevice(workerId, device);
+			t_workerStream = stream;
+
+			if (m_initPass)
+			{
+				node->resetStatus();
+				node->initialize();
+
+				auto& list = node->getModuleList();
+				for (auto iter = list.begin(); iter != list.end(); iter++)
+				{
+					(*iter)->initialize();
+				}
+			}
+			else if (node->isActive())
+			{
+				node->advance(node->getDt());
+				node->updateTopology();
+			}
+			cudaStreamSynchronize(stream);
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				for (size_t k = 0; k < m_successors[task].size(); k++)
+				{
+					int succ = m_successors[task][k];
+					if (--m_indegree[succ] == 0)
+					{
+						m_ready.push(succ);
+						m_workAvailable.notify_one();
+					}
+				}
+
+				if (--m_pending == 0)
+				{
+					m_frameDone.notify_all();
+				}
+			}
+		}
+	}
+}
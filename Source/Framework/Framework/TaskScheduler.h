@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <map>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cuda_runtime.h>
+
+namespace PhysIKA {
+
+class Node;
+
+/*!
+*	\class	TaskScheduler
+*	\brief	Dependency-driven parallel execution of the animation pass.
+*
+*	takeOneFrame() advances nodes one at a time even when sibling nodes
+*	(two independent fluids, cloth plus rigid) share no data. The scheduler
+*	derives a DAG per frame: tree edges keep the parent-before-child order of
+*	the original top-down traversal, and every NodePort connection adds an
+*	edge from the providing node to the consumer. Nodes whose dependencies
+*	are satisfied are dispatched to a persistent worker pool, so independent
+*	subtrees advance concurrently.
+*
+*	Each worker owns a CUDA stream, published through currentStream() for
+*	modules that launch asynchronously; kernels issued on the legacy default
+*	stream still serialize on the device, but neighbor builds, reductions and
+*	host-side work of independent nodes overlap either way.
+*
+*	Nodes can additionally be spread across devices: a node pinned with
+*	Node::setComputeDevice is initialized and advanced with that device
+*	current, and setRoundRobinDevices() distributes the unpinned ones. Since
+*	connected fields share one allocation, a consumer on another device
+*	reads the provider's memory directly; the scheduler enables peer access
+*	per dependency edge and falls back to co-locating the two nodes when
+*	the devices cannot reach each other.
+*/
+class TaskScheduler
+{
+public:
+	TaskScheduler(int workerNum = 0);
+	~TaskScheduler();
+
+	/**
+	 * @brief Advance every active node reachable from root once, respecting
+	 * the dependency DAG. Blocks until the whole frame's work is done.
+	 */
+	void animate(std::shared_ptr<Node> root);
+
+	/**
+	 * @brief Initialize every node reachable from root, children before
+	 * parents as in the bottom-up InitAct traversal, with independent
+	 * subtrees initializing concurrently. Heavy per-node setup (rest shapes,
+	 * SDF loading) dominates scene startup and parallelizes well.
+	 */
+	void initialize(std::shared_ptr<Node> root);
+
+	/**
+	 * @brief Stream owned by the calling worker thread, or the default
+	 * stream when called outside the pool.
+	 */
+	static cudaStream_t currentStream();
+
+	/**
+	 * @brief Assign nodes without an explicit Node::setComputeDevice pin
+	 * round-robin across the visible devices; a dual-GPU workstation then
+	 * advances independent nodes on both cards. The assignment sticks to
+	 * the node, so it stays stable across frames.
+	 */
+	void setRoundRobinDevices(bool enabled) { m_roundRobin = enabled; }
+
+private:
+	void workerLoop(int workerId);
+
+	void collectNodes(std::shared_ptr<Node> node);
+
+	void dispatch(std::shared_ptr<Node> root, bool bottomUp);
+
+	int deviceOf(Node* node);
+
+	//Stream owned by a worker on the given device, created on first use;
+	//a CUDA stream is tied to the device it was created on.
+	cudaStream_t streamForDevice(int workerId, int device);
+
+	//Enable peer access between the two devices; returns false when they
+	//cannot reach each other.
+	bool enablePeerPair(int devA, int devB);
+
+	std::vector<Node*> m_nodes;
+	std::vector<std::vector<int>> m_successors;
+	std::vector<int> m_indegree;
+
+	std::vector<std::thread> m_workers;
+	std::vector<cudaStream_t> m_streams;
+	std::vector<std::map<int, cudaStream_t>> m_deviceStreams;	//per worker, keyed by device
+
+	std::set<long long> m_peerPairs;	//device pairs with peer access enabled
+
+	int m_primaryDevice = 0;
+	int m_deviceNum = 1;
+	bool m_roundRobin = false;
+
+	std::queue<int> m_ready;
+	std::mutex m_mutex;
+	std::condition_variable m_workAvailable;
+	std::condition_variable m_frameDone;
+
+	int m_pending = 0;
+	bool m_initPass = false;
+	bool m_shutdown = false;
+};
+
+}
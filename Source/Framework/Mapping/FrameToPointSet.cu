@@ -99,6 +99,143 @@ namespace PhysIKA
 	}
 
 
+#define FTP_MAX_BATCH 256
+
+#ifdef PRECISION_FLOAT
+	typedef float FTPReal;
+#else
+	typedef double FTPReal;
+#endif
+
+	//one rigid transform per cluster; rot already holds curMat*refMat^T
+	struct FTP_ClusterXf
+	{
+		FTPReal rot[9];
+		FTPReal curCenter[3];
+		FTPReal refCenter[3];
+	};
+
+	__constant__ FTP_ClusterXf c_clusterXf[FTP_MAX_BATCH];
+	__constant__ int c_clusterBegin[FTP_MAX_BATCH + 1];
+
+	template <typename Coord>
+	__global__ void FTP_BatchSkinning(
+		Coord** curPoints,
+		Coord** refPoints,
+		int clusterNum,
+		int totalNum)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= totalNum) return;
+
+		//locate the cluster whose range contains this thread
+		int lo = 0;
+		int hi = clusterNum - 1;
+		while (lo < hi)
+		{
+			int mid = (lo + hi + 1) >> 1;
+			if (c_clusterBegin[mid] <= tId)
+			{
+				lo = mid;
+			}
+			else
+			{
+				hi = mid - 1;
+			}
+		}
+
+		int local = tId - c_clusterBegin[lo];
+		const FTP_ClusterXf& xf = c_clusterXf[lo];
+
+		Coord r = refPoints[lo][local];
+		FTPReal x = r[0] - xf.refCenter[0];
+		FTPReal y = r[1] - xf.refCenter[1];
+		FTPReal z = r[2] - xf.refCenter[2];
+
+		curPoints[lo][local] = Coord(
+			xf.curCenter[0] + xf.rot[0] * x + xf.rot[1] * y + xf.rot[2] * z,
+			xf.curCenter[1] + xf.rot[3] * x + xf.rot[4] * y + xf.rot[5] * z,
+			xf.curCenter[2] + xf.rot[6] * x + xf.rot[7] * y + xf.rot[8] * z);
+	}
+
+	template<typename TDataType>
+	void FrameToPointSet<TDataType>::applyBatch(std::vector<std::shared_ptr<FrameToPointSet<TDataType>>>& mappings)
+	{
+		int num = (int)mappings.size();
+		if (num == 0) return;
+		if (num == 1)
+		{
+			mappings[0]->apply();
+			return;
+		}
+
+		std::vector<FTP_ClusterXf> xf(FTP_MAX_BATCH);
+		std::vector<int> begin(FTP_MAX_BATCH + 1);
+		std::vector<Coord*> cur(FTP_MAX_BATCH);
+		std::vector<Coord*> ref(FTP_MAX_BATCH);
+
+		//grow-only scratch for the per-cluster point buffers
+		static Coord** d_cur = nullptr;
+		static Coord** d_ref = nullptr;
+		static int s_capacity = 0;
+
+		for (int first = 0; first < num; first += FTP_MAX_BATCH)
+		{
+			int batch = num - first < FTP_MAX_BATCH ? num - first : FTP_MAX_BATCH;
+
+			int total = 0;
+			for (int i = 0; i < batch; i++)
+			{
+				FrameToPointSet<TDataType>* m = mappings[first + i].get();
+
+				DeviceArray<Coord>& refPoints = m->m_initTo->getPoints();
+
+				begin[i] = total;
+				total += refPoints.size();
+
+				cur[i] = m->m_to->getPoints().getDataPtr();
+				ref[i] = refPoints.getDataPtr();
+
+				//compose the cluster transform once on the host so the
+				//kernel applies a single rotation per point
+				Matrix rot = m->m_from->getOrientation()*m->m_initFrom->getOrientation().transpose();
+				Coord curCenter = m->m_from->getCenter();
+				Coord refCenter = m->m_initFrom->getCenter();
+
+				for (int r = 0; r < 3; r++)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						xf[i].rot[3 * r + c] = rot(r, c);
+					}
+					xf[i].curCenter[r] = curCenter[r];
+					xf[i].refCenter[r] = refCenter[r];
+				}
+			}
+			begin[batch] = total;
+
+			if (total == 0) continue;
+
+			cuSafeCall(cudaMemcpyToSymbol(c_clusterXf, xf.data(), batch * sizeof(FTP_ClusterXf)));
+			cuSafeCall(cudaMemcpyToSymbol(c_clusterBegin, begin.data(), (batch + 1) * sizeof(int)));
+
+			if (batch > s_capacity)
+			{
+				if (d_cur != nullptr) cuSafeCall(cudaFree(d_cur));
+				if (d_ref != nullptr) cuSafeCall(cudaFree(d_ref));
+				cuSafeCall(cudaMalloc(&d_cur, batch * sizeof(Coord*)));
+				cuSafeCall(cudaMalloc(&d_ref, batch * sizeof(Coord*)));
+				s_capacity = batch;
+			}
+			cuSafeCall(cudaMemcpy(d_cur, cur.data(), batch * sizeof(Coord*), cudaMemcpyHostToDevice));
+			cuSafeCall(cudaMemcpy(d_ref, ref.data(), batch * sizeof(Coord*), cudaMemcpyHostToDevice));
+
+			uint pDims = cudaGridSize(total, BLOCK_SIZE);
+			FTP_BatchSkinning<Coord> << <pDims, BLOCK_SIZE >> >(d_cur, d_ref, batch, total);
+			cuSynchronize();
+		}
+	}
+
 	template<typename TDataType>
 	bool FrameToPointSet<TDataType>::initializeImpl()
 	{
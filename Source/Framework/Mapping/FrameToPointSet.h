@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 #include "Core/Array/Array.h"
 #include "Framework/Framework/TopologyMapping.h"
 
@@ -26,6 +27,20 @@ public:
 
 	bool apply() override;
 
+	/**
+	 * @brief Skin many frame-driven clusters with a single launch.
+	 * @details An articulated setup drives tens of point clusters from tens
+	 *          of frames, one FrameToPointSet per cluster; calling apply()
+	 *          on each issues one tiny kernel per cluster and launch overhead
+	 *          dominates the stage. applyBatch() instead composes every
+	 *          cluster's rigid transform on the host, uploads the whole batch
+	 *          into a constant-memory table and skins the concatenated
+	 *          clusters in one kernel, each thread locating its cluster by a
+	 *          binary search over the range table. A single mapping falls
+	 *          back to apply().
+	 */
+	static void applyBatch(std::vector<std::shared_ptr<FrameToPointSet<TDataType>>>& mappings);
+
 protected:
 	bool initializeImpl() override;
 
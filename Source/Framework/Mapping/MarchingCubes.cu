@@ -0,0 +1,492 @@
+#pragma once
+#include <cuda_runtime.h>
+#include <vector>
+#include "MarchingCubes.h"
+#include "Core/Utility.h"
+#include "Framework/Framework/Log.h"
+
+namespace PhysIKA
+{
+	//cube corner offsets and the corner pair each edge connects; the same
+	//numbering is used by the host-side table construction below
+	__device__ const int MC_CORNERS[8][3] = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 },
+		{ 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } };
+
+	__device__ const int MC_EDGE_ENDS[12][2] = {
+		{ 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+		{ 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+
+	/**
+	 * Build the 256-case triangle table by tracing the isocontour over the
+	 * cube faces: on every face, crossings are paired along arcs of inside
+	 * corners (which also resolves the ambiguous face cases consistently),
+	 * the directed segments are chained into loops and each loop is fan
+	 * triangulated. Winding is such that triangle normals point away from
+	 * the high-density side. At most 15 vertices are emitted per cube, so
+	 * each case occupies one 16-entry row terminated with -1.
+	 */
+	static void MC_BuildTables(std::vector<int>& triTable, std::vector<int>& vertNumTable)
+	{
+		const int faceLoop[6][4] = {
+			{ 0, 3, 2, 1 }, { 4, 5, 6, 7 }, { 0, 1, 5, 4 },
+			{ 2, 3, 7, 6 }, { 0, 4, 7, 3 }, { 1, 2, 6, 5 } };
+		const int faceEdge[6][4] = {
+			{ 3, 2, 1, 0 }, { 4, 5, 6, 7 }, { 0, 9, 4, 8 },
+			{ 2, 11, 6, 10 }, { 8, 7, 11, 3 }, { 1, 10, 5, 9 } };
+
+		triTable.assign(256 * 16, -1);
+		vertNumTable.assign(256, 0);
+
+		for (int config = 0; config < 256; config++)
+		{
+			//next[e] = edge the contour segment starting at edge e ends on
+			int next[12];
+			for (int e = 0; e < 12; e++)
+			{
+				next[e] = -1;
+			}
+
+			for (int f = 0; f < 6; f++)
+			{
+				for (int s = 0; s < 4; s++)
+				{
+					bool inA = (config >> faceLoop[f][s]) & 1;
+					bool inB = (config >> faceLoop[f][(s + 1) % 4]) & 1;
+					if (inA || !inB)
+					{
+						continue;	//not an entry crossing
+					}
+
+					//walk the inside arc to the matching exit crossing
+					int t = s;
+					for (;;)
+					{
+						t = (t + 1) % 4;
+						bool inA2 = (config >> faceLoop[f][t]) & 1;
+						bool inB2 = (config >> faceLoop[f][(t + 1) % 4]) & 1;
+						if (inA2 && !inB2)
+						{
+							next[faceEdge[f][s]] = faceEdge[f][t];
+							break;
+						}
+					}
+				}
+			}
+
+			int num = 0;
+			bool visited[12] = { false };
+			for (int e = 0; e < 12; e++)
+			{
+				if (next[e] < 0 || visited[e])
+				{
+					continue;
+				}
+
+				int loop[12];
+				int len = 0;
+				int c = e;
+				do
+				{
+					loop[len++] = c;
+					visited[c] = true;
+					c = next[c];
+				} while (c != e);
+
+				for (int i = 1; i < len - 1; i++)
+				{
+					triTable[16 * config + num++] = loop[0];
+					triTable[16 * config + num++] = loop[i];
+					triTable[16 * config + num++] = loop[i + 1];
+				}
+			}
+			vertNumTable[config] = num;
+		}
+	}
+
+	__device__ static float MC_AtomicMinReal(float* address, float val)
+	{
+		int* address_as_i = (int*)address;
+		int old = *address_as_i, assumed;
+		do {
+			assumed = old;
+			old = atomicCAS(address_as_i, assumed,
+				__float_as_int(fminf(val, __int_as_float(assumed))));
+		} while (assumed != old);
+		return __int_as_float(old);
+	}
+
+	__device__ static float MC_AtomicMaxReal(float* address, float val)
+	{
+		int* address_as_i = (int*)address;
+		int old = *address_as_i, assumed;
+		do {
+			assumed = old;
+			old = atomicCAS(address_as_i, assumed,
+				__float_as_int(fmaxf(val, __int_as_float(assumed))));
+		} while (assumed != old);
+		return __int_as_float(old);
+	}
+
+	__device__ static double MC_AtomicMinReal(double* address, double val)
+	{
+		unsigned long long* address_as_ull = (unsigned long long*)address;
+		unsigned long long old = *address_as_ull, assumed;
+		do {
+			assumed = old;
+			double cur = __longlong_as_double(assumed);
+			old = atomicCAS(address_as_ull, assumed,
+				__double_as_longlong(val < cur ? val : cur));
+		} while (assumed != old);
+		return __longlong_as_double(old);
+	}
+
+	__device__ static double MC_AtomicMaxReal(double* address, double val)
+	{
+		unsigned long long* address_as_ull = (unsigned long long*)address;
+		unsigned long long old = *address_as_ull, assumed;
+		do {
+			assumed = old;
+			double cur = __longlong_as_double(assumed);
+			old = atomicCAS(address_as_ull, assumed,
+				__double_as_longlong(val > cur ? val : cur));
+		} while (assumed != old);
+		return __longlong_as_double(old);
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void K_MCComputeBounds(
+		Real* bounds,
+		DeviceArray<Coord> posArr)
+	{
+		__shared__ Real s_lo[3][BLOCK_SIZE];
+		__shared__ Real s_hi[3][BLOCK_SIZE];
+
+		int tId = threadIdx.x;
+		Coord lo = Coord(Real(1e30));
+		Coord hi = Coord(Real(-1e30));
+
+		for (int i = threadIdx.x + (blockIdx.x * blockDim.x); i < posArr.size(); i += blockDim.x * gridDim.x)
+		{
+			Coord pos = posArr[i];
+			for (int d = 0; d < 3; d++)
+			{
+				lo[d] = pos[d] < lo[d] ? pos[d] : lo[d];
+				hi[d] = pos[d] > hi[d] ? pos[d] : hi[d];
+			}
+		}
+
+		for (int d = 0; d < 3; d++)
+		{
+			s_lo[d][tId] = lo[d];
+			s_hi[d][tId] = hi[d];
+		}
+		__syncthreads();
+
+		for (int stride = blockDim.x / 2; stride > 0; stride /= 2)
+		{
+			if (tId < stride)
+			{
+				for (int d = 0; d < 3; d++)
+				{
+					s_lo[d][tId] = s_lo[d][tId + stride] < s_lo[d][tId] ? s_lo[d][tId + stride] : s_lo[d][tId];
+					s_hi[d][tId] = s_hi[d][tId + stride] > s_hi[d][tId] ? s_hi[d][tId + stride] : s_hi[d][tId];
+				}
+			}
+			__syncthreads();
+		}
+
+		if (tId == 0)
+		{
+			for (int d = 0; d < 3; d++)
+			{
+				MC_AtomicMinReal(&bounds[d], s_lo[d][0]);
+				MC_AtomicMaxReal(&bounds[3 + d], s_hi[d][0]);
+			}
+		}
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void K_MCSplatDensity(
+		Array3D<Real> density,
+		DeviceArray<Coord> posArr,
+		Coord origin,
+		Real h,
+		Real smoothingLength)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posArr.size()) return;
+
+		Coord pos = posArr[pId];
+		int R = (int)ceil(smoothingLength / h);
+		int ci = (int)floor((pos[0] - origin[0]) / h);
+		int cj = (int)floor((pos[1] - origin[1]) / h);
+		int ck = (int)floor((pos[2] - origin[2]) / h);
+
+		Real R2 = smoothingLength * smoothingLength;
+
+		for (int k = ck - R; k <= ck + R + 1; k++)
+		{
+			for (int j = cj - R; j <= cj + R + 1; j++)
+			{
+				for (int i = ci - R; i <= ci + R + 1; i++)
+				{
+					if (i < 0 || j < 0 || k < 0 || i >= density.Nx() || j >= density.Ny() || k >= density.Nz())
+						continue;
+
+					Coord node = origin + Coord(Real(i), Real(j), Real(k)) * h;
+					Real d2 = (node - pos).normSquared();
+					if (d2 >= R2)
+						continue;
+
+					Real w = Real(1) - d2 / R2;
+					atomicAdd(&density(i, j, k), w * w * w);
+				}
+			}
+		}
+	}
+
+	template <typename Real>
+	__global__ void K_MCClassifyCubes(
+		DeviceArray<int> vertNum,
+		Array3D<Real> density,
+		DeviceArray<int> vertNumTable,
+		Real isoValue,
+		int cnx, int cny, int cnz)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= cnx * cny * cnz) return;
+
+		int i = tId % cnx;
+		int j = (tId / cnx) % cny;
+		int k = tId / (cnx * cny);
+
+		int cubeIndex = 0;
+		for (int c = 0; c < 8; c++)
+		{
+			if (density(i + MC_CORNERS[c][0], j + MC_CORNERS[c][1], k + MC_CORNERS[c][2]) > isoValue)
+			{
+				cubeIndex |= 1 << c;
+			}
+		}
+
+		vertNum[tId] = vertNumTable[cubeIndex];
+	}
+
+	template <typename Real, typename Coord>
+	__global__ void K_MCGenerateTriangles(
+		DeviceArray<Coord> vertices,
+		DeviceArray<TopologyModule::Triangle> triangles,
+		Array3D<Real> density,
+		DeviceArray<int> vertNum,
+		DeviceArray<int> vertOffset,
+		DeviceArray<int> triTable,
+		Coord origin,
+		Real h,
+		Real isoValue,
+		int cnx, int cny, int cnz)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= cnx * cny * cnz) return;
+
+		int num = vertNum[tId];
+		if (num == 0) return;
+
+		int i = tId % cnx;
+		int j = (tId / cnx) % cny;
+		int k = tId / (cnx * cny);
+
+		int cubeIndex = 0;
+		for (int c = 0; c < 8; c++)
+		{
+			if (density(i + MC_CORNERS[c][0], j + MC_CORNERS[c][1], k + MC_CORNERS[c][2]) > isoValue)
+			{
+				cubeIndex |= 1 << c;
+			}
+		}
+
+		int offset = vertOffset[tId];
+		for (int v = 0; v < num; v++)
+		{
+			int e = triTable[16 * cubeIndex + v];
+			int c0 = MC_EDGE_ENDS[e][0];
+			int c1 = MC_EDGE_ENDS[e][1];
+
+			Real v0 = density(i + MC_CORNERS[c0][0], j + MC_CORNERS[c0][1], k + MC_CORNERS[c0][2]);
+			Real v1 = density(i + MC_CORNERS[c1][0], j + MC_CORNERS[c1][1], k + MC_CORNERS[c1][2]);
+			Real t = (isoValue - v0) / (v1 - v0);
+
+			Coord p0 = origin + Coord(Real(i + MC_CORNERS[c0][0]), Real(j + MC_CORNERS[c0][1]), Real(k + MC_CORNERS[c0][2])) * h;
+			Coord p1 = origin + Coord(Real(i + MC_CORNERS[c1][0]), Real(j + MC_CORNERS[c1][1]), Real(k + MC_CORNERS[c1][2])) * h;
+
+			vertices[offset + v] = p0 + (p1 - p0) * t;
+		}
+
+		for (int t = 0; t < num / 3; t++)
+		{
+			TopologyModule::Triangle tri;
+			tri[0] = offset + 3 * t;
+			tri[1] = offset + 3 * t + 1;
+			tri[2] = offset + 3 * t + 2;
+			triangles[offset / 3 + t] = tri;
+		}
+	}
+
+	template<typename TDataType>
+	MarchingCubes<TDataType>::MarchingCubes()
+		: TopologyMapping()
+	{
+	}
+
+	template<typename TDataType>
+	MarchingCubes<TDataType>::MarchingCubes(std::shared_ptr<PointSet<TDataType>> from, std::shared_ptr<TriangleSet<TDataType>> to)
+		: TopologyMapping()
+	{
+		m_from = from;
+		m_to = to;
+	}
+
+	template<typename TDataType>
+	MarchingCubes<TDataType>::~MarchingCubes()
+	{
+		m_triTable.release();
+		m_vertNumTable.release();
+		m_bounds.release();
+		m_vertCount.release();
+		m_vertOffset.release();
+		m_density.Release();
+	}
+
+	template<typename TDataType>
+	bool MarchingCubes<TDataType>::initializeImpl()
+	{
+		uploadTables();
+		return apply();
+	}
+
+	template<typename TDataType>
+	void MarchingCubes<TDataType>::uploadTables()
+	{
+		if (m_triTable.size() > 0)
+		{
+			return;
+		}
+
+		std::vector<int> triTable;
+		std::vector<int> vertNumTable;
+		MC_BuildTables(triTable, vertNumTable);
+
+		m_triTable.resize((int)triTable.size());
+		m_vertNumTable.resize((int)vertNumTable.size());
+		cuSafeCall(cudaMemcpy(m_triTable.getDataPtr(), triTable.data(), triTable.size() * sizeof(int), cudaMemcpyHostToDevice));
+		cuSafeCall(cudaMemcpy(m_vertNumTable.getDataPtr(), vertNumTable.data(), vertNumTable.size() * sizeof(int), cudaMemcpyHostToDevice));
+
+		m_bounds.resize(6);
+	}
+
+	template<typename TDataType>
+	bool MarchingCubes<TDataType>::apply()
+	{
+		if (m_from == nullptr || m_to == nullptr)
+		{
+			return false;
+		}
+
+		uploadTables();
+
+		DeviceArray<Coord>& points = m_from->getPoints();
+		if (points.size() == 0)
+		{
+			m_to->setSize(0);
+			m_to->getTriangles()->resize(0);
+			return true;
+		}
+
+		//particle AABB, padded so the density falls to zero inside the grid
+		Real initBounds[6] = { Real(1e30), Real(1e30), Real(1e30), Real(-1e30), Real(-1e30), Real(-1e30) };
+		cuSafeCall(cudaMemcpy(m_bounds.getDataPtr(), initBounds, sizeof(initBounds), cudaMemcpyHostToDevice));
+
+		uint pDims = cudaGridSize(points.size(), BLOCK_SIZE);
+		pDims = pDims > 64 ? 64 : pDims;
+		K_MCComputeBounds << <pDims, BLOCK_SIZE >> > (m_bounds.getDataPtr(), points);
+		cuSynchronize();
+
+		Real bounds[6];
+		cuSafeCall(cudaMemcpy(bounds, m_bounds.getDataPtr(), sizeof(bounds), cudaMemcpyDeviceToHost));
+
+		Real h = m_spacing;
+		Real pad = m_smoothingLength + 2 * h;
+		Coord lo(bounds[0] - pad, bounds[1] - pad, bounds[2] - pad);
+		Coord hi(bounds[3] + pad, bounds[4] + pad, bounds[5] + pad);
+
+		//coarsen the grid rather than let the transient volume explode when
+		//the particles scatter over a large domain
+		int nx, ny, nz;
+		for (;;)
+		{
+			nx = (int)ceil((hi[0] - lo[0]) / h) + 1;
+			ny = (int)ceil((hi[1] - lo[1]) / h) + 1;
+			nz = (int)ceil((hi[2] - lo[2]) / h) + 1;
+			if ((size_t)nx * ny * nz <= (size_t)1 << 24)
+			{
+				break;
+			}
+			h *= 2;
+			Log::sendMessage(Log::Warning, "MarchingCubes: density grid too large, doubling the grid spacing!");
+		}
+
+		if (m_density.Nx() != nx || m_density.Ny() != ny || m_density.Nz() != nz)
+		{
+			m_density.Release();
+			m_density.Resize(nx, ny, nz);
+		}
+		m_density.Reset();
+
+		uint sDims = cudaGridSize(points.size(), BLOCK_SIZE);
+		K_MCSplatDensity << <sDims, BLOCK_SIZE >> > (m_density, points, lo, h, m_smoothingLength);
+		cuSynchronize();
+
+		int cnx = nx - 1;
+		int cny = ny - 1;
+		int cnz = nz - 1;
+		int cubeNum = cnx * cny * cnz;
+
+		if (m_vertCount.size() != cubeNum)
+		{
+			m_vertCount.resize(cubeNum);
+			m_vertOffset.resize(cubeNum);
+		}
+
+		uint cDims = cudaGridSize(cubeNum, BLOCK_SIZE);
+		K_MCClassifyCubes << <cDims, BLOCK_SIZE >> > (m_vertCount, m_density, m_vertNumTable, m_isoValue, cnx, cny, cnz);
+		cuSynchronize();
+
+		m_scan.exclusive(m_vertOffset, m_vertCount);
+
+		int lastCount = 0;
+		int lastOffset = 0;
+		cuSafeCall(cudaMemcpy(&lastCount, m_vertCount.getDataPtr() + cubeNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastOffset, m_vertOffset.getDataPtr() + cubeNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		int totalVerts = lastCount + lastOffset;
+
+		m_to->setSize(totalVerts);
+		m_to->getTriangles()->resize(totalVerts / 3);
+
+		if (totalVerts > 0)
+		{
+			K_MCGenerateTriangles << <cDims, BLOCK_SIZE >> > (
+				m_to->getPoints(),
+				*m_to->getTriangles(),
+				m_density,
+				m_vertCount,
+				m_vertOffset,
+				m_triTable,
+				lo, h, m_isoValue,
+				cnx, cny, cnz);
+			cuSynchronize();
+		}
+
+		return true;
+	}
+}
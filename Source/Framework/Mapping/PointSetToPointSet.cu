@@ -28,7 +28,11 @@ namespace PhysIKA
 	template<typename TDataType>
 	PointSetToPointSet<TDataType>::~PointSetToPointSet()
 	{
-
+		m_initFromPos.release();
+		m_initToPos.release();
+		m_flags.release();
+		m_offsets.release();
+		m_counts.release();
 	}
 
 
@@ -78,19 +82,6 @@ namespace PhysIKA
 			//2
 			Real r2 = (initFrom[j] - initTo_i).norm();//to->j
 
-			/*if (pId == 0)
-			{
-				printf("initFrom**************************************");
-
-				printf("\n initFrom[j0]: %f %f %f \n from[j0]: %f %f %f \n initFrom: \n %f %f %f \n from: %f %f %f \n initTo: %f %f %f \n\n\n",
-					initFrom[j0][0], initFrom[j0][1], initFrom[j0][2],
-					from[j][0], from[j][1], from[j][2],
-					initFrom[j][0], initFrom[j][1], initFrom[j][2],
-					from[j][0], from[j][1], from[j][2],
-					initTo_i[0], initTo_i[1], initTo_i[2]);
-
-			}*/
-
 			//1
 			if (r1 > EPSILON)
 			{
@@ -136,7 +127,7 @@ namespace PhysIKA
 		D(1, 1) = D(1, 1) > threshold ? 1.0 / D(1, 1) : 1.0;
 		D(2, 2) = D(2, 2) > threshold ? 1.0 / D(2, 2) : 1.0;
 
-		mat_i = V * D * U.transpose(); //inverse 
+		mat_i = V * D * U.transpose(); //inverse
 		//
 
 		//2
@@ -188,27 +179,115 @@ namespace PhysIKA
 		SmoothKernel<Real> kernSmooth;
 		Real q = r / h;
 		return kernSmooth.Weight(r, h) / (h*h*h*h);
+	}
 
-		//Real q = r / h;
-		//if (r > h)
-		//{
-		//	return Real(0);
-		//}
-		//return 1 - q*q;
+	template <typename Real, typename Coord>
+	__global__ void P2P_MarkAffected(
+		DeviceArray<int> flags,
+		DeviceArray<Coord> initTo,
+		DeviceArray<Coord> newFrom,
+		int oldToNum,
+		Real radius)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= flags.size()) return;
+
+		//appended targets always need fresh correspondences
+		if (pId >= oldToNum)
+		{
+			flags[pId] = 1;
+			return;
+		}
+
+		//brute force over the appended sources: a crack event or an emitter
+		//step appends few points compared to the full set
+		Coord p = initTo[pId];
+		int f = 0;
+		int num = newFrom.size();
+		for (int j = 0; j < num; j++)
+		{
+			if ((p - newFrom[j]).norm() < radius)
+			{
+				f = 1;
+				break;
+			}
+		}
+		flags[pId] = f;
+	}
+
+	template <typename Coord>
+	__global__ void P2P_ScatterAffected(
+		DeviceArray<Coord> affPos,
+		DeviceArray<int> flags,
+		DeviceArray<int> offsets,
+		DeviceArray<Coord> initTo)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= flags.size()) return;
+
+		if (flags[pId])
+		{
+			affPos[offsets[pId]] = initTo[pId];
+		}
+	}
+
+	__global__ void P2P_RowCounts(
+		DeviceArray<int> counts,
+		DeviceArray<int> flags,
+		DeviceArray<int> offsets,
+		NeighborList<int> affList,
+		NeighborList<int> oldList)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= counts.size()) return;
+
+		counts[pId] = flags[pId] ? affList.getNeighborSize(offsets[pId]) : oldList.getNeighborSize(pId);
+	}
+
+	__global__ void P2P_MergeRows(
+		NeighborList<int> newList,
+		NeighborList<int> oldList,
+		NeighborList<int> affList,
+		DeviceArray<int> flags,
+		DeviceArray<int> offsets)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= flags.size()) return;
 
+		int num = newList.getNeighborSize(pId);
+		if (flags[pId])
+		{
+			int slot = offsets[pId];
+			for (int j = 0; j < num; j++)
+			{
+				newList.setElement(pId, j, affList.getElement(slot, j));
+			}
+		}
+		else
+		{
+			for (int j = 0; j < num; j++)
+			{
+				newList.setElement(pId, j, oldList.getElement(pId, j));
+			}
+		}
 	}
 
 
 	template<typename TDataType>
 	bool PointSetToPointSet<TDataType>::apply()
 	{
+		if (m_from->getPoints().size() != m_fromNum || m_to->getPoints().size() != m_toNum)
+		{
+			rebind();
+		}
+
 		cuint pDim = cudaGridSize(m_to->getPoints().size(), BLOCK_SIZE);
 
 		K_ApplyTransform << <pDim, BLOCK_SIZE >> > (
 			m_to->getPoints(),
 			m_from->getPoints(),
-			m_initTo->getPoints(),
-			m_initFrom->getPoints(),
+			m_initToPos,
+			m_initFromPos,
 			m_neighborhood,
 			m_radius);
 
@@ -218,17 +297,137 @@ namespace PhysIKA
 	template<typename TDataType>
 	void PointSetToPointSet<TDataType>::match(std::shared_ptr<PointSet<TDataType>> from, std::shared_ptr<PointSet<TDataType>> to)
 	{
-		m_initFrom = std::make_shared<PointSet<TDataType>>();
-		m_initTo = std::make_shared<PointSet<TDataType>>();
+		int fromNum = from->getPoints().size();
+		int toNum = to->getPoints().size();
+
+		m_initFromPos.resize(fromNum);
+		m_initToPos.resize(toNum);
+		Function1Pt::copy(m_initFromPos, from->getPoints());
+		Function1Pt::copy(m_initToPos, to->getPoints());
+
+		NeighborQuery<TDataType>* nbQuery = new NeighborQuery<TDataType>(m_initFromPos);
+
+		m_neighborhood.resize(toNum);
+		nbQuery->queryParticleNeighbors(m_neighborhood, m_initToPos, m_radius);
+
+		delete nbQuery;
+
+		m_fromNum = fromNum;
+		m_toNum = toNum;
+	}
+
+	template<typename TDataType>
+	void PointSetToPointSet<TDataType>::appendInit(DeviceArray<Coord>& rest, DeviceArray<Coord>& cur, int oldNum)
+	{
+		DeviceArray<Coord> keep;
+		keep.resize(oldNum);
+		cuSafeCall(cudaMemcpy(keep.getDataPtr(), rest.getDataPtr(), oldNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+
+		rest.resize(cur.size());
+		cuSafeCall(cudaMemcpy(rest.getDataPtr(), keep.getDataPtr(), oldNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+		cuSafeCall(cudaMemcpy(rest.getDataPtr() + oldNum, cur.getDataPtr() + oldNum, (cur.size() - oldNum) * sizeof(Coord), cudaMemcpyDeviceToDevice));
+
+		keep.release();
+	}
+
+	template<typename TDataType>
+	void PointSetToPointSet<TDataType>::rebind()
+	{
+		DeviceArray<Coord>& curFrom = m_from->getPoints();
+		DeviceArray<Coord>& curTo = m_to->getPoints();
+		int fromNum = curFrom.size();
+		int toNum = curTo.size();
+
+		//removed points invalidate the stored indices: full rebuild
+		if (fromNum < m_fromNum || toNum < m_toNum)
+		{
+			match(m_from, m_to);
+			return;
+		}
 
-		m_initFrom->copyFrom(*from);
-		m_initTo->copyFrom(*to);
+		//the appended points' current positions become their rest state
+		if (fromNum > m_fromNum)
+		{
+			appendInit(m_initFromPos, curFrom, m_fromNum);
+		}
+		if (toNum > m_toNum)
+		{
+			appendInit(m_initToPos, curTo, m_toNum);
+		}
+
+		//compact copy of the appended source points
+		int newFromNum = fromNum - m_fromNum;
+		DeviceArray<Coord> newFrom;
+		newFrom.resize(newFromNum);
+		if (newFromNum > 0)
+		{
+			cuSafeCall(cudaMemcpy(newFrom.getDataPtr(), m_initFromPos.getDataPtr() + m_fromNum, newFromNum * sizeof(Coord), cudaMemcpyDeviceToDevice));
+		}
+
+		if (m_flags.size() != toNum)
+		{
+			m_flags.resize(toNum);
+			m_offsets.resize(toNum);
+			m_counts.resize(toNum);
+		}
+
+		uint pDims = cudaGridSize(toNum, BLOCK_SIZE);
+		P2P_MarkAffected << <pDims, BLOCK_SIZE >> > (m_flags, m_initToPos, newFrom, m_toNum, m_radius);
+		cuSynchronize();
 
-		NeighborQuery<TDataType>* nbQuery = new NeighborQuery<TDataType>(m_initFrom->getPoints());
+		m_scan.exclusive(m_offsets, m_flags);
 
-		m_neighborhood.resize(m_initTo->getPoints().size());
-		nbQuery->queryParticleNeighbors(m_neighborhood, m_initTo->getPoints(), m_radius);
+		int affNum = 0;
+		int lastFlag = 0;
+		cuSafeCall(cudaMemcpy(&affNum, m_offsets.getDataPtr() + toNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastFlag, m_flags.getDataPtr() + toNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		affNum += lastFlag;
 
+		if (affNum == 0)
+		{
+			newFrom.release();
+			m_fromNum = fromNum;
+			m_toNum = toNum;
+			return;
+		}
+
+		DeviceArray<Coord> affPos;
+		affPos.resize(affNum);
+		P2P_ScatterAffected << <pDims, BLOCK_SIZE >> > (affPos, m_flags, m_offsets, m_initToPos);
+		cuSynchronize();
+
+		//requery only the affected rows against the full source set
+		NeighborQuery<TDataType>* nbQuery = new NeighborQuery<TDataType>(m_initFromPos);
+		NeighborList<int> affList;
+		affList.resize(affNum);
+		nbQuery->queryParticleNeighbors(affList, affPos, m_radius);
 		delete nbQuery;
+
+		P2P_RowCounts << <pDims, BLOCK_SIZE >> > (m_counts, m_flags, m_offsets, affList, m_neighborhood);
+		cuSynchronize();
+
+		NeighborList<int> newList;
+		newList.resize(toNum);
+		m_scan.exclusive(newList.getIndex(), m_counts);
+
+		int total = 0;
+		int lastCount = 0;
+		cuSafeCall(cudaMemcpy(&total, newList.getIndex().getDataPtr() + toNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastCount, m_counts.getDataPtr() + toNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		total += lastCount;
+
+		newList.resizeElements(total);
+		P2P_MergeRows << <pDims, BLOCK_SIZE >> > (newList, m_neighborhood, affList, m_flags, m_offsets);
+		cuSynchronize();
+
+		m_neighborhood.copyFrom(newList);
+
+		newList.release();
+		affList.release();
+		affPos.release();
+		newFrom.release();
+
+		m_fromNum = fromNum;
+		m_toNum = toNum;
 	}
-}
\ No newline at end of file
+}
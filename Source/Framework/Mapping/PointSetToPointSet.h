@@ -1,6 +1,7 @@
 #pragma once
 #include "Framework/Framework/TopologyMapping.h"
 #include "Core/Array/Array.h"
+#include "Core/Utility/Scan.h"
 #include "Framework/Topology/PointSet.h"
 
 namespace PhysIKA
@@ -31,16 +32,42 @@ protected:
 	bool initializeImpl() override;
 
 private:
+	/**
+	 * @brief Incremental correspondence update when either side resizes.
+	 *
+	 * Emitters and fracture append points; a full match() on every such
+	 * event recomputes all correspondences. rebind() instead snapshots the
+	 * appended points' current positions as their rest state and requeries
+	 * only the affected rows: the appended targets plus existing targets
+	 * within the searching radius of an appended source point. Unaffected
+	 * rows are copied over into the regrown list. Shrinking either side
+	 * invalidates the stored indices and falls back to a full match().
+	 */
+	void rebind();
+
+	/// grow rest-state positions to cur.size(), keeping the first oldNum entries
+	void appendInit(DeviceArray<Coord>& rest, DeviceArray<Coord>& cur, int oldNum);
+
 	//Searching radius
 	Real m_radius = 0.0125;
 
 	NeighborList<int> m_neighborhood;
-	
+
 	std::shared_ptr<PointSet<TDataType>> m_from = nullptr;
 	std::shared_ptr<PointSet<TDataType>> m_to = nullptr;
 
-	std::shared_ptr<PointSet<TDataType>> m_initFrom = nullptr;
-	std::shared_ptr<PointSet<TDataType>> m_initTo = nullptr;
+	//rest-state positions both sides are matched in
+	DeviceArray<Coord> m_initFromPos;
+	DeviceArray<Coord> m_initToPos;
+
+	//sizes the current correspondences were built for
+	int m_fromNum = 0;
+	int m_toNum = 0;
+
+	Scan m_scan;
+	DeviceArray<int> m_flags;
+	DeviceArray<int> m_offsets;
+	DeviceArray<int> m_counts;
 };
 
 
@@ -49,4 +76,4 @@ template class PointSetToPointSet<DataType3f>;
 #else
 template class PointSetToPointSet<DataType3d>;
 #endif
-}
\ No newline at end of file
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "CompactGridHash.h"
+#include "Core/Utility.h"
+#include <thrust/reduce.h>
+#include <thrust/system/cuda/execution_policy.h>
+#include <thrust/scan.h>
+#include <thrust/execution_policy.h>
+
+namespace PhysIKA {
+
+	template<typename TDataType>
+	CompactGridHash<TDataType>::CompactGridHash()
+	{
+	}
+
+	template<typename TDataType>
+	CompactGridHash<TDataType>::~CompactGridHash()
+	{
+	}
+
+	template<typename TDataType>
+	void CompactGridHash<TDataType>::setSpace(Real _h, Coord _lo, Coord _hi)
+	{
+		int padding = 2;
+		ds = _h;
+		lo = _lo - padding * ds;
+
+		Coord nSeg = (_hi - _lo) / ds;
+
+		nx = ceil(nSeg[0]) + 1 + 2 * padding;
+		ny = ceil(nSeg[1]) + 1 + 2 * padding;
+		nz = ceil(nSeg[2]) + 1 + 2 * padding;
+		hi = lo + Coord(nx, ny, nz) * ds;
+
+		//Table storage is allocated lazily in construct(), once the particle count is known.
+	}
+
+	template<typename TDataType>
+	__global__ void K_CGH_CountParticles(CompactGridHash<TDataType> hash, Array<typename TDataType::Coord> pos)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= pos.size()) return;
+
+		int3 gId3 = hash.getIndex3(pos[pId]);
+		int key = hash.getCellKey(gId3.x, gId3.y, gId3.z);
+		if (key == COMPACT_INVALID) return;
+
+		int slot = hash.insertCell(key);
+		if (slot != COMPACT_INVALID)
+			atomicAdd(&(hash.index[slot]), 1);
+	}
+
+	template<typename TDataType>
+	__global__ void K_CGH_ScatterParticles(CompactGridHash<TDataType> hash, Array<typename TDataType::Coord> pos)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= pos.size()) return;
+
+		int slot = hash.getIndex(pos[pId]);
+		if (slot == COMPACT_INVALID) return;
+
+		int offset = atomicAdd(&(hash.counter[slot]), 1);
+		hash.ids[hash.index[slot] + offset] = pId;
+	}
+
+	template<typename TDataType>
+	void CompactGridHash<TDataType>::construct(DeviceArray<Coord>& pos, cudaStream_t stream)
+	{
+		//Size the table at the next power of two above twice the particle count,
+		//which bounds the load factor at 0.5 even if every particle occupies its own cell.
+		int requested = 2 * pos.size();
+		int capacity = 1;
+		while (capacity < requested)
+		{
+			capacity *= 2;
+		}
+
+		if (capacity != table_size)
+		{
+			release();
+
+			table_size = capacity;
+
+			cuSafeCall(cudaMalloc((void**)&cell_key, table_size * sizeof(int)));
+			cuSafeCall(cudaMalloc((void**)&counter, table_size * sizeof(int)));
+			cuSafeCall(cudaMalloc((void**)&index, table_size * sizeof(int)));
+		}
+
+		cuSafeCall(cudaMemsetAsync(cell_key, 0xFF, table_size * sizeof(int), stream));
+		cuSafeCall(cudaMemsetAsync(counter, 0, table_size * sizeof(int), stream));
+		cuSafeCall(cudaMemsetAsync(index, 0, table_size * sizeof(int), stream));
+
+		dim3 pDims = int(ceil(pos.size() / BLOCK_SIZE + 0.5f));
+
+		K_CGH_CountParticles << <pDims, BLOCK_SIZE, 0, stream >> > (*this, pos);
+
+		particle_num = thrust::reduce(thrust::cuda::par.on(stream), index, index + table_size, (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::cuda::par.on(stream), index, index + table_size, index);
+
+		if (particle_num > ids_capacity)
+		{
+			if (ids != nullptr)
+			{
+				cuSafeCall(cudaFree(ids));
+			}
+			ids_capacity = 2 * ids_capacity > particle_num ? 2 * ids_capacity : particle_num;
+			cuSafeCall(cudaMalloc((void**)&ids, ids_capacity * sizeof(int)));
+		}
+
+		K_CGH_ScatterParticles << <pDims, BLOCK_SIZE, 0, stream >> > (*this, pos);
+	}
+
+	template<typename TDataType>
+	void CompactGridHash<TDataType>::clear()
+	{
+		if (cell_key != nullptr)
+			cuSafeCall(cudaMemset(cell_key, 0xFF, table_size * sizeof(int)));
+
+		if (counter != nullptr)
+			cuSafeCall(cudaMemset(counter, 0, table_size * sizeof(int)));
+
+		if (index != nullptr)
+			cuSafeCall(cudaMemset(index, 0, table_size * sizeof(int)));
+	}
+
+	template<typename TDataType>
+	void CompactGridHash<TDataType>::release()
+	{
+		if (cell_key != nullptr)
+			cuSafeCall(cudaFree(cell_key));
+
+		if (counter != nullptr)
+			cuSafeCall(cudaFree(counter));
+
+		if (ids != nullptr)
+			cuSafeCall(cudaFree(ids));
+
+		if (index != nullptr)
+			cuSafeCall(cudaFree(index));
+
+		cell_key = nullptr;
+		counter = nullptr;
+		ids = nullptr;
+		index = nullptr;
+
+		table_size = 0;
+		ids_capacity = 0;
+	}
+}
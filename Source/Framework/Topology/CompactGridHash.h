@@ -0,0 +1,147 @@
+#pragma once
+#include "Core/DataTypes.h"
+#include "Core/Utility.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility/Scan.h"
+#include "Framework/Topology/NeighborList.h"
+
+namespace PhysIKA {
+
+	#define COMPACT_INVALID -1
+
+	/*!
+	*	\class	CompactGridHash
+	*	\brief	Spatial hash over occupied cells only.
+	*
+	*	Unlike GridHash, which allocates nx*ny*nz buckets over the whole bounding box,
+	*	this index keys an open-addressing table on occupied cells, so memory and
+	*	rebuild cost scale with the particle count rather than the domain volume.
+	*	The device interface mirrors GridHash (getIndex/getIndex3/getCounter/getParticleId),
+	*	so neighbor query kernels can be shared between the two backends.
+	*/
+	template<typename TDataType>
+	class CompactGridHash
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		CompactGridHash();
+		~CompactGridHash();
+
+		void setSpace(Real _h, Coord _lo, Coord _hi);
+
+		void construct(DeviceArray<Coord>& pos, cudaStream_t stream = 0);
+
+		void clear();
+
+		void release();
+
+		GPU_FUNC inline int getCellKey(int i, int j, int k)
+		{
+			if (i < 0 || i >= nx) return COMPACT_INVALID;
+			if (j < 0 || j >= ny) return COMPACT_INVALID;
+			if (k < 0 || k >= nz) return COMPACT_INVALID;
+
+			return i + j*nx + k*nx*ny;
+		}
+
+		/**
+		 * @brief Maps a cell coordinate to its table slot, or COMPACT_INVALID when the cell is empty.
+		 */
+		GPU_FUNC inline int getIndex(int i, int j, int k)
+		{
+			int key = getCellKey(i, j, k);
+			if (key == COMPACT_INVALID) return COMPACT_INVALID;
+
+			int slot = (key * 73856093) & (table_size - 1);
+			for (int probe = 0; probe < table_size; probe++)
+			{
+				int stored = cell_key[slot];
+				if (stored == key)
+					return slot;
+				if (stored == COMPACT_INVALID)
+					return COMPACT_INVALID;
+
+				slot = (slot + 1) & (table_size - 1);
+			}
+			return COMPACT_INVALID;
+		}
+
+		GPU_FUNC inline int getIndex(Coord pos)
+		{
+			int i = floor((pos[0] - lo[0]) / ds);
+			int j = floor((pos[1] - lo[1]) / ds);
+			int k = floor((pos[2] - lo[2]) / ds);
+
+			return getIndex(i, j, k);
+		}
+
+		GPU_FUNC inline int3 getIndex3(Coord pos)
+		{
+			int i = floor((pos[0] - lo[0]) / ds);
+			int j = floor((pos[1] - lo[1]) / ds);
+			int k = floor((pos[2] - lo[2]) / ds);
+
+			return make_int3(i, j, k);
+		}
+
+		/**
+		 * @brief Inserts a cell into the table and returns its slot. Device-side, used during construction.
+		 */
+		GPU_FUNC inline int insertCell(int key)
+		{
+			int slot = (key * 73856093) & (table_size - 1);
+			for (int probe = 0; probe < table_size; probe++)
+			{
+				int stored = atomicCAS(&cell_key[slot], COMPACT_INVALID, key);
+				if (stored == COMPACT_INVALID || stored == key)
+					return slot;
+
+				slot = (slot + 1) & (table_size - 1);
+			}
+			return COMPACT_INVALID;
+		}
+
+		GPU_FUNC inline int getCounter(int slot)
+		{
+			if (slot >= table_size - 1)
+			{
+				return particle_num - index[slot];
+			}
+			return index[slot + 1] - index[slot];
+		}
+
+		GPU_FUNC inline int getParticleId(int slot, int n)
+		{
+			return ids[index[slot] + n];
+		}
+
+	public:
+		int nx, ny, nz;
+
+		int table_size = 0;		//power of two, roughly 2x the occupied cell count
+		int particle_num = 0;
+
+		Real ds;
+
+		Coord lo;
+		Coord hi;
+
+		int ids_capacity = 0;	//grow-only capacity of ids, kept across rebuilds
+
+		int* cell_key = nullptr;
+		int* ids = nullptr;
+		int* counter = nullptr;
+		int* index = nullptr;
+
+		Scan* m_scan = nullptr;
+		Reduction<int>* m_reduce = nullptr;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class CompactGridHash<DataType3f>;
+#else
+	template class CompactGridHash<DataType3d>;
+#endif
+}
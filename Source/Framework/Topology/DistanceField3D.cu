@@ -1,9 +1,18 @@
 #include <fstream>
+#include <vector>
+#include <cstring>
 #include "DistanceField3D.h"
+#include "SDFBrickStream.h"
 #include "Core/Utility.h"
 #include "Core/Vector.h"
 #include "Core/DataTypes.h"
 
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/execution_policy.h>
+
+#include "Framework/Topology/TriangleBVH.h"
+
 namespace PhysIKA{
 
 	template <typename Coord>
@@ -288,6 +297,8 @@ namespace PhysIKA{
 		dim3 gridDims = cudaGridSize3D(make_uint3(m_distance.Nx(), m_distance.Ny(), m_distance.Nz()), blockSize);
 
 		K_DistanceFieldToBox << <gridDims, blockSize >> >(m_distance, m_left, m_h, lo, hi, inverted);
+
+		updateTexture();
 	}
 
 	template <typename Real, typename Coord>
@@ -317,6 +328,8 @@ namespace PhysIKA{
 		dim3 gridDims = cudaGridSize3D(make_uint3(m_distance.Nx(), m_distance.Ny(), m_distance.Nz()), blockSize);
 
 		K_DistanceFieldToCylinder << <gridDims, blockSize >> >(m_distance, m_left, m_h, center, radius, height, axis, inverted);
+
+		updateTexture();
 	}
 
 	template <typename Real, typename Coord>
@@ -348,6 +361,8 @@ namespace PhysIKA{
 		dim3 gridDims = cudaGridSize3D(make_uint3(m_distance.Nx(), m_distance.Ny(), m_distance.Nz()), blockSize);
 
 		K_DistanceFieldToSphere << <gridDims, blockSize >> >(m_distance, m_left, m_h, center, radius, inverted);
+
+		updateTexture();
 	}
 
 	template<typename TDataType>
@@ -407,13 +422,585 @@ namespace PhysIKA{
 			invertSDF();
 		}
 
+		updateTexture();
+
 		std::cout << "read data successful" << std::endl;
 	}
 
+	template<typename TDataType>
+	void DistanceField3D<TDataType>::updateTexture()
+	{
+		//Hardware filtering only exists for 32-bit channels; the double
+		//precision build keeps the software interpolation path.
+		if (sizeof(Real) != 4 || m_distance.Size() == 0) return;
+
+		int nx = m_distance.Nx();
+		int ny = m_distance.Ny();
+		int nz = m_distance.Nz();
+
+		if (m_texDistance != 0)
+		{
+			cuSafeCall(cudaDestroyTextureObject(m_texDistance));
+			m_texDistance = 0;
+		}
+		if (m_texArray != nullptr)
+		{
+			cuSafeCall(cudaFreeArray(m_texArray));
+			m_texArray = nullptr;
+		}
+
+		cudaChannelFormatDesc channelDesc = cudaCreateChannelDesc<float>();
+		cudaExtent extent = make_cudaExtent(nx, ny, nz);
+		cuSafeCall(cudaMalloc3DArray(&m_texArray, &channelDesc, extent));
+
+		cudaMemcpy3DParms parms = { 0 };
+		parms.srcPtr = make_cudaPitchedPtr(m_distance.GetDataPtr(), nx * sizeof(float), nx, ny);
+		parms.dstArray = m_texArray;
+		parms.extent = extent;
+		parms.kind = cudaMemcpyDeviceToDevice;
+		cuSafeCall(cudaMemcpy3D(&parms));
+
+		cudaResourceDesc resDesc;
+		memset(&resDesc, 0, sizeof(resDesc));
+		resDesc.resType = cudaResourceTypeArray;
+		resDesc.res.array.array = m_texArray;
+
+		cudaTextureDesc texDesc;
+		memset(&texDesc, 0, sizeof(texDesc));
+		texDesc.addressMode[0] = cudaAddressModeClamp;
+		texDesc.addressMode[1] = cudaAddressModeClamp;
+		texDesc.addressMode[2] = cudaAddressModeClamp;
+		texDesc.filterMode = cudaFilterModeLinear;
+		texDesc.readMode = cudaReadModeElementType;
+		texDesc.normalizedCoords = 0;
+
+		cuSafeCall(cudaCreateTextureObject(&m_texDistance, &resDesc, &texDesc, nullptr));
+	}
+
+	template <typename Real, typename Coord>
+	__device__ Real MeshSDF_BoxDistSq(const Coord& p, const Coord& lo, const Coord& hi)
+	{
+		Real sum = 0;
+		for (int d = 0; d < 3; ++d)
+		{
+			Real e = 0;
+			if (p[d] < lo[d]) e = lo[d] - p[d];
+			else if (p[d] > hi[d]) e = p[d] - hi[d];
+			sum += e * e;
+		}
+		return sum;
+	}
+
+	/// Unsigned distance from p to the closest point of a triangle (Voronoi
+	/// region walk over vertices, edges and face).
+	template <typename Real, typename Coord>
+	__device__ Real MeshSDF_PointTriangleDist(const Coord& p, const Coord& a, const Coord& b, const Coord& c)
+	{
+		Coord ab = b - a;
+		Coord ac = c - a;
+		Coord ap = p - a;
+
+		Real d1 = ab.dot(ap);
+		Real d2 = ac.dot(ap);
+		if (d1 <= 0 && d2 <= 0) return (p - a).norm();
+
+		Coord bp = p - b;
+		Real d3 = ab.dot(bp);
+		Real d4 = ac.dot(bp);
+		if (d3 >= 0 && d4 <= d3) return (p - b).norm();
+
+		Real vc = d1 * d4 - d3 * d2;
+		if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		{
+			Real v = d1 / (d1 - d3);
+			return (p - (a + ab * v)).norm();
+		}
+
+		Coord cp = p - c;
+		Real d5 = ab.dot(cp);
+		Real d6 = ac.dot(cp);
+		if (d6 >= 0 && d5 <= d6) return (p - c).norm();
+
+		Real vb = d5 * d2 - d1 * d6;
+		if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		{
+			Real w = d2 / (d2 - d6);
+			return (p - (a + ac * w)).norm();
+		}
+
+		Real va = d3 * d6 - d5 * d4;
+		if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+		{
+			Real w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			return (p - (b + (c - b) * w)).norm();
+		}
+
+		Real denom = Real(1) / (va + vb + vc);
+		Real v = vb * denom;
+		Real w = vc * denom;
+		return (p - (a + ab * v + ac * w)).norm();
+	}
+
+	/// Moeller-Trumbore intersection of the +x ray from o with a triangle.
+	template <typename Real, typename Coord>
+	__device__ bool MeshSDF_RayHitX(const Coord& o, const Coord& v0, const Coord& v1, const Coord& v2)
+	{
+		Coord e1 = v1 - v0;
+		Coord e2 = v2 - v0;
+
+		//pvec = dir x e2 with dir = (1, 0, 0)
+		Coord pvec(0, -e2[2], e2[1]);
+		Real det = e1.dot(pvec);
+		if (abs(det) < REAL_EPSILON) return false;
+		Real inv_det = Real(1) / det;
+
+		Coord tvec = o - v0;
+		Real u = tvec.dot(pvec) * inv_det;
+		if (u < 0 || u > 1) return false;
+
+		Coord qvec = tvec.cross(e1);
+		Real v = qvec[0] * inv_det;
+		if (v < 0 || u + v > 1) return false;
+
+		return e2.dot(qvec) * inv_det > 0;
+	}
+
+	/// One thread per grid sample: closest triangle through the BVH for the
+	/// magnitude, +x ray-crossing parity for the sign.
+	template <typename Real, typename Coord>
+	__global__ void K_DistanceFieldFromMesh(
+		DeviceArray3D<Real> distance,
+		Coord start,
+		Coord h,
+		DeviceArray<Coord> vertices,
+		DeviceArray<TopologyModule::Triangle> triangles,
+		DeviceArray<Coord> nodeLo,
+		DeviceArray<Coord> nodeHi,
+		DeviceArray<int> childL,
+		DeviceArray<int> childR,
+		DeviceArray<int> sortedId,
+		int n,
+		bool inverted)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		int j = threadIdx.y + (blockIdx.y * blockDim.y);
+		int k = threadIdx.z + (blockIdx.z * blockDim.z);
+
+		if (i >= distance.Nx()) return;
+		if (j >= distance.Ny()) return;
+		if (k >= distance.Nz()) return;
+
+		Coord p = start + Coord(i, j, k)*h;
+
+		Real best = 1000000.0f;
+		int stack[64];
+		int sp = 0;
+		stack[sp++] = 0;
+
+		while (sp > 0)
+		{
+			int node = stack[--sp];
+
+			if (MeshSDF_BoxDistSq<Real>(p, nodeLo[node], nodeHi[node]) >= best * best) continue;
+
+			if (node >= n - 1)
+			{
+				TopologyModule::Triangle tri = triangles[sortedId[node - (n - 1)]];
+				Real dist = MeshSDF_PointTriangleDist<Real>(p, vertices[tri[0]], vertices[tri[1]], vertices[tri[2]]);
+				best = min(best, dist);
+			}
+			else if (sp + 2 <= 64)
+			{
+				stack[sp++] = childL[node];
+				stack[sp++] = childR[node];
+			}
+		}
+
+		int crossings = 0;
+		sp = 0;
+		stack[sp++] = 0;
+
+		while (sp > 0)
+		{
+			int node = stack[--sp];
+
+			if (p[1] < nodeLo[node][1] || p[1] > nodeHi[node][1]
+				|| p[2] < nodeLo[node][2] || p[2] > nodeHi[node][2]
+				|| p[0] > nodeHi[node][0]) continue;
+
+			if (node >= n - 1)
+			{
+				TopologyModule::Triangle tri = triangles[sortedId[node - (n - 1)]];
+				if (MeshSDF_RayHitX<Real>(p, vertices[tri[0]], vertices[tri[1]], vertices[tri[2]]))
+				{
+					crossings++;
+				}
+			}
+			else if (sp + 2 <= 64)
+			{
+				stack[sp++] = childL[node];
+				stack[sp++] = childR[node];
+			}
+		}
+
+		//odd crossing parity: inside; negative inside matches the analytic shapes
+		Real sign = (crossings & 1) ? Real(-1) : Real(1);
+		if (inverted) sign = -sign;
+
+		distance(i, j, k) = sign * best;
+	}
+
+	template<typename TDataType>
+	void DistanceField3D<TDataType>::loadMesh(DeviceArray<Coord>& vertices, DeviceArray<Triangle>& triangles, bool inverted)
+	{
+		if (triangles.size() <= 0 || m_distance.Size() == 0) return;
+
+		m_bInverted = inverted;
+
+		TriangleBVH<TDataType> bvh;
+		bvh.construct(vertices, triangles);
+
+		dim3 blockSize = make_uint3(8, 8, 8);
+		dim3 gridDims = cudaGridSize3D(make_uint3(m_distance.Nx(), m_distance.Ny(), m_distance.Nz()), blockSize);
+
+		K_DistanceFieldFromMesh << <gridDims, blockSize >> > (
+			m_distance, m_left, m_h,
+			vertices, triangles,
+			bvh.getNodeLo(), bvh.getNodeHi(), bvh.getChildL(), bvh.getChildR(), bvh.getSortedId(),
+			triangles.size(), inverted);
+		cuSynchronize();
+
+		updateTexture();
+	}
+
+	/// One thread per brick: mark bricks touching the narrow band and record the
+	/// representative distance at the brick center for the far bricks.
+	template <typename Real>
+	__global__ void K_SDF_MarkBricks(
+		DeviceArray3D<int> brickIndex,
+		DeviceArray3D<Real> coarseValue,
+		DeviceArray3D<Real> distance,
+		Real band)
+	{
+		int bi = threadIdx.x + (blockIdx.x * blockDim.x);
+		int bj = threadIdx.y + (blockIdx.y * blockDim.y);
+		int bk = threadIdx.z + (blockIdx.z * blockDim.z);
+
+		if (bi >= brickIndex.Nx()) return;
+		if (bj >= brickIndex.Ny()) return;
+		if (bk >= brickIndex.Nz()) return;
+
+		int nx = distance.Nx();
+		int ny = distance.Ny();
+		int nz = distance.Nz();
+
+		Real min_abs = 1000000.0f;
+		for (int dk = 0; dk <= 8; ++dk)
+		{
+			int k = min(8 * bk + dk, nz - 1);
+			for (int dj = 0; dj <= 8; ++dj)
+			{
+				int j = min(8 * bj + dj, ny - 1);
+				for (int di = 0; di <= 8; ++di)
+				{
+					int i = min(8 * bi + di, nx - 1);
+					Real dist = distance(i, j, k);
+					min_abs = min(min_abs, abs(dist));
+				}
+			}
+		}
+
+		coarseValue(bi, bj, bk) = distance(min(8 * bi + 4, nx - 1), min(8 * bj + 4, ny - 1), min(8 * bk + 4, nz - 1));
+		brickIndex(bi, bj, bk) = min_abs <= band ? 1 : 0;
+	}
+
+	/// Turn the scanned occupancy marks into brick ids (-1 for far bricks).
+	__global__ void K_SDF_AssignBrickIds(
+		DeviceArray3D<int> brickIndex,
+		int* scanned,
+		int num)
+	{
+		int b = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (b >= num) return;
+
+		int* marks = brickIndex.GetDataPtr();
+		marks[b] = marks[b] > 0 ? scanned[b] : -1;
+	}
+
+	/// One thread per occupied brick copies its 9x9x9 footprint into the pool.
+	template <typename Real>
+	__global__ void K_SDF_FillBricks(
+		DeviceArray<Real> pool,
+		DeviceArray3D<int> brickIndex,
+		DeviceArray3D<Real> distance)
+	{
+		int bi = threadIdx.x + (blockIdx.x * blockDim.x);
+		int bj = threadIdx.y + (blockIdx.y * blockDim.y);
+		int bk = threadIdx.z + (blockIdx.z * blockDim.z);
+
+		if (bi >= brickIndex.Nx()) return;
+		if (bj >= brickIndex.Ny()) return;
+		if (bk >= brickIndex.Nz()) return;
+
+		int id = brickIndex(bi, bj, bk);
+		if (id < 0) return;
+
+		int nx = distance.Nx();
+		int ny = distance.Ny();
+		int nz = distance.Nz();
+
+		Real* block = pool.getDataPtr() + id * 729;
+		for (int dk = 0; dk <= 8; ++dk)
+		{
+			int k = min(8 * bk + dk, nz - 1);
+			for (int dj = 0; dj <= 8; ++dj)
+			{
+				int j = min(8 * bj + dj, ny - 1);
+				for (int di = 0; di <= 8; ++di)
+				{
+					int i = min(8 * bi + di, nx - 1);
+					block[di + 9 * (dj + 9 * dk)] = distance(i, j, k);
+				}
+			}
+		}
+	}
+
+	template<typename TDataType>
+	void DistanceField3D<TDataType>::compress(Real band_width)
+	{
+		if (m_bSparse || m_distance.Size() == 0) return;
+
+		m_nx = m_distance.Nx();
+		m_ny = m_distance.Ny();
+		m_nz = m_distance.Nz();
+
+		int bnx = (m_nx + 7) / 8;
+		int bny = (m_ny + 7) / 8;
+		int bnz = (m_nz + 7) / 8;
+		int brick_num = bnx * bny * bnz;
+
+		m_brickIndex.Resize(bnx, bny, bnz);
+		m_coarseValue.Resize(bnx, bny, bnz);
+
+		dim3 blockSize = make_uint3(8, 8, 8);
+		dim3 gridDims = cudaGridSize3D(make_uint3(bnx, bny, bnz), blockSize);
+
+		K_SDF_MarkBricks << <gridDims, blockSize >> > (m_brickIndex, m_coarseValue, m_distance, band_width);
+
+		DeviceArray<int> scanned(brick_num);
+		int occupied = thrust::reduce(thrust::device, m_brickIndex.GetDataPtr(), m_brickIndex.GetDataPtr() + brick_num, (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::device, m_brickIndex.GetDataPtr(), m_brickIndex.GetDataPtr() + brick_num, scanned.getDataPtr());
+
+		uint pDims = cudaGridSize(brick_num, BLOCK_SIZE);
+		K_SDF_AssignBrickIds << <pDims, BLOCK_SIZE >> > (m_brickIndex, scanned.getDataPtr(), brick_num);
+
+		m_brickPool.resize(occupied > 0 ? occupied * 729 : 1);
+		K_SDF_FillBricks << <gridDims, blockSize >> > (m_brickPool, m_brickIndex, m_distance);
+		cuSynchronize();
+
+		scanned.release();
+
+		//the dense array and its texture mirror are no longer needed
+		if (m_texDistance != 0)
+		{
+			cuSafeCall(cudaDestroyTextureObject(m_texDistance));
+			m_texDistance = 0;
+		}
+		if (m_texArray != nullptr)
+		{
+			cuSafeCall(cudaFreeArray(m_texArray));
+			m_texArray = nullptr;
+		}
+		m_distance.Release();
+
+		m_bSparse = true;
+	}
+
 	template<typename TDataType>
 	void DistanceField3D<TDataType>::release()
 	{
+		if (m_texDistance != 0)
+		{
+			cuSafeCall(cudaDestroyTextureObject(m_texDistance));
+			m_texDistance = 0;
+		}
+		if (m_texArray != nullptr)
+		{
+			cuSafeCall(cudaFreeArray(m_texArray));
+			m_texArray = nullptr;
+		}
 		m_distance.Release();
+
+		m_brickIndex.Release();
+		m_coarseValue.Release();
+		m_brickPool.release();
+		m_bSparse = false;
+
+		if (m_stream != nullptr)
+		{
+			delete m_stream;
+			m_stream = nullptr;
+		}
+	}
+
+	template<typename TDataType>
+	void DistanceField3D<TDataType>::saveBricks(std::string filename)
+	{
+		if (!m_bSparse)
+		{
+			std::cout << "saveBricks requires brick storage, call compress first!" << std::endl;
+			return;
+		}
+
+		int bnx = m_brickIndex.Nx();
+		int bny = m_brickIndex.Ny();
+		int bnz = m_brickIndex.Nz();
+		uint64_t cellNum = (uint64_t)bnx * bny * bnz;
+		uint32_t brickNum = (uint32_t)(m_brickPool.size() / 729);
+
+		std::vector<int> hostIndex(cellNum);
+		std::vector<Real> hostCoarse(cellNum);
+		std::vector<Real> hostPool((size_t)brickNum * 729);
+		cuSafeCall(cudaMemcpy(hostIndex.data(), m_brickIndex.GetDataPtr(), cellNum * sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(hostCoarse.data(), m_coarseValue.GetDataPtr(), cellNum * sizeof(Real), cudaMemcpyDeviceToHost));
+		if (brickNum > 0)
+		{
+			cuSafeCall(cudaMemcpy(hostPool.data(), m_brickPool.getDataPtr(), (uint64_t)brickNum * 729 * sizeof(Real), cudaMemcpyDeviceToHost));
+		}
+
+		SDFBrickFileHeader header;
+		memset(&header, 0, sizeof(header));
+		const char magic[8] = { 'P', 'K', 'S', 'D', 'F', 'B', '\0', '\0' };
+		memcpy(header.magic, magic, sizeof(magic));
+		header.version = 1;
+		header.realBytes = sizeof(Real);
+		header.bnx = bnx;
+		header.bny = bny;
+		header.bnz = bnz;
+		header.brickNum = brickNum;
+		header.nx = m_nx;
+		header.ny = m_ny;
+		header.nz = m_nz;
+		header.left[0] = m_left[0];
+		header.left[1] = m_left[1];
+		header.left[2] = m_left[2];
+		header.h = m_h[0];
+
+		//64-byte aligned sections, payloads last so the reader only maps
+		//the ones it needs
+		uint64_t offset = (sizeof(SDFBrickFileHeader) + 63) & ~(uint64_t)63;
+		header.coarseOffset = offset;
+		offset = (offset + cellNum * sizeof(Real) + 63) & ~(uint64_t)63;
+		header.indexOffset = offset;
+		offset = (offset + cellNum * sizeof(int32_t) + 63) & ~(uint64_t)63;
+		header.brickOffset = offset;
+
+		std::ofstream output(filename.c_str(), std::ios::out | std::ios::binary);
+		if (!output.is_open())
+		{
+			std::cout << "Writing file " << filename << " error!" << std::endl;
+			return;
+		}
+
+		std::vector<char> zeros(64, 0);
+		output.write((const char*)&header, sizeof(header));
+		output.write(zeros.data(), header.coarseOffset - sizeof(header));
+		output.write((const char*)hostCoarse.data(), cellNum * sizeof(Real));
+		output.write(zeros.data(), header.indexOffset - header.coarseOffset - cellNum * sizeof(Real));
+		output.write((const char*)hostIndex.data(), cellNum * sizeof(int32_t));
+		output.write(zeros.data(), header.brickOffset - header.indexOffset - cellNum * sizeof(int32_t));
+		output.write((const char*)hostPool.data(), (uint64_t)brickNum * 729 * sizeof(Real));
+		output.close();
+	}
+
+	template<typename TDataType>
+	bool DistanceField3D<TDataType>::loadBricks(std::string filename, bool inverted, uint32_t maxResidentBricks)
+	{
+		SDFBrickStream* stream = new SDFBrickStream();
+		if (!stream->open(filename))
+		{
+			std::cout << "Reading file " << filename << " error!" << std::endl;
+			delete stream;
+			return false;
+		}
+
+		const SDFBrickFileHeader& header = stream->getHeader();
+		if (header.realBytes != sizeof(Real))
+		{
+			std::cout << "File " << filename << " was baked with a different floating point precision!" << std::endl;
+			delete stream;
+			return false;
+		}
+
+		release();
+
+		m_left = Coord(header.left[0], header.left[1], header.left[2]);
+		m_h = Coord(header.h, header.h, header.h);
+		m_nx = header.nx;
+		m_ny = header.ny;
+		m_nz = header.nz;
+		m_bInverted = inverted;
+
+		int bnx = header.bnx;
+		int bny = header.bny;
+		int bnz = header.bnz;
+		uint64_t cellNum = (uint64_t)bnx * bny * bnz;
+
+		std::cout << "SDF bricks: " << m_nx << ", " << m_ny << ", " << m_nz << " in " << header.brickNum << " bricks" << std::endl;
+
+		//everything starts non-resident: queries fall back to the coarse
+		//distances until the worker streams the region in
+		m_brickIndex.Resize(bnx, bny, bnz);
+		cuSafeCall(cudaMemset(m_brickIndex.GetDataPtr(), 0xFF, cellNum * sizeof(int)));
+
+		m_coarseValue.Resize(bnx, bny, bnz);
+		if (inverted)
+		{
+			std::vector<Real> hostCoarse((const Real*)stream->getCoarseData(), (const Real*)stream->getCoarseData() + cellNum);
+			for (uint64_t c = 0; c < cellNum; c++)
+			{
+				hostCoarse[c] = -hostCoarse[c];
+			}
+			cuSafeCall(cudaMemcpy(m_coarseValue.GetDataPtr(), hostCoarse.data(), cellNum * sizeof(Real), cudaMemcpyHostToDevice));
+		}
+		else
+		{
+			cuSafeCall(cudaMemcpy(m_coarseValue.GetDataPtr(), stream->getCoarseData(), cellNum * sizeof(Real), cudaMemcpyHostToDevice));
+		}
+
+		uint32_t poolCapacity = header.brickNum < maxResidentBricks ? header.brickNum : maxResidentBricks;
+		m_brickPool.resize(poolCapacity > 0 ? poolCapacity * 729 : 1);
+
+		stream->bindDevice(m_brickIndex.GetDataPtr(), m_brickPool.getDataPtr(), poolCapacity, 729 * sizeof(Real), inverted);
+
+		m_stream = stream;
+		m_bSparse = true;
+
+		return true;
+	}
+
+	template<typename TDataType>
+	void DistanceField3D<TDataType>::setActiveRegion(Coord lo, Coord hi)
+	{
+		if (m_stream == nullptr)
+		{
+			return;
+		}
+
+		const SDFBrickFileHeader& header = m_stream->getHeader();
+
+		int blo[3];
+		int bhi[3];
+		for (int d = 0; d < 3; d++)
+		{
+			int bn = d == 0 ? header.bnx : (d == 1 ? header.bny : header.bnz);
+			int l = (int)floor((lo[d] - m_left[d]) / (8 * m_h[d])) - 1;
+			int u = (int)floor((hi[d] - m_left[d]) / (8 * m_h[d])) + 1;
+			blo[d] = l < 0 ? 0 : (l > bn - 1 ? bn - 1 : l);
+			bhi[d] = u < 0 ? 0 : (u > bn - 1 ? bn - 1 : u);
+		}
+
+		m_stream->setActiveRegion(blo, bhi);
 	}
 
 	template class DistanceField3D<DataType3f>;
@@ -11,16 +11,22 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include "Core/Platform.h"
+#include "Core/Array/Array.h"
 #include "Core/Array/Array3D.h"
+#include "Framework/Framework/ModuleTopology.h"
 
 namespace PhysIKA {
 
+	class SDFBrickStream;
+
 	template<typename TDataType>
 	class DistanceField3D {
 	public:
 		typedef typename TDataType::Real Real;
 		typedef typename TDataType::Coord Coord;
+		typedef typename TopologyModule::Triangle Triangle;
 
 		DistanceField3D();
 
@@ -75,8 +81,77 @@ namespace PhysIKA {
 
 		void loadSphere(Coord& center, Real radius, bool inverted = false);
 
+		/**
+		 * @brief Bake the field from a triangle mesh on the GPU
+		 *
+		 * Every grid sample queries the closest triangle through a BVH over the
+		 * mesh and takes its sign from +x ray-crossing parity, so no pre-baked
+		 * .sdf file is needed. setSpace must have been called beforehand, as
+		 * with the other analytic load* methods.
+		 */
+		void loadMesh(DeviceArray<Coord>& vertices, DeviceArray<Triangle>& triangles, bool inverted = false);
+
 		void setSpace(const Coord p0, const Coord p1, int nbx, int nby, int nbz);
 
+		/**
+		 * @brief Mirror the distance field into a 3D texture object
+		 * 
+		 * Rebuilds the cudaArray copy of m_distance and enables the hardware
+		 * trilinear sampling path in getDistance. Called by the load* methods;
+		 * call it again after modifying m_distance directly.
+		 */
+		void updateTexture();
+
+		/**
+		 * @brief Convert the dense field into two-level brick storage
+		 *
+		 * Only 8^3-cell bricks whose distance range touches the narrow band
+		 * [-band_width, band_width] keep full-resolution samples (with a one
+		 * sample apron so interpolation never crosses bricks); every other
+		 * brick collapses to a single representative distance. The dense array
+		 * and its texture mirror are released afterwards, so a mostly-empty
+		 * terrain field shrinks by the fraction of far-away bricks. Queries go
+		 * through getDistance unchanged. Call after the field is final: the
+		 * brick storage is read-only (scale/invert no longer apply).
+		 *
+		 * @param band_width half width of the band kept at full resolution,
+		 *        in world units; a few grid cells is typically enough.
+		 */
+		void compress(Real band_width);
+
+		/**
+		 * @brief Write the brick storage built by compress() to a chunked file
+		 *
+		 * The file keeps the directory, one coarse distance per brick cell and
+		 * the payloads of near-surface bricks, so loadBricks can come back up
+		 * without ever reading the dense volume.
+		 */
+		void saveBricks(std::string filename);
+
+		/**
+		 * @brief Open a file written by saveBricks without reading its payloads
+		 *
+		 * Only the directory and the coarse distances are loaded, so the field
+		 * answers queries immediately (at coarse resolution away from streamed
+		 * bricks). Full-resolution payloads are streamed in by a worker thread
+		 * as setActiveRegion moves over them and evicted when it leaves, with
+		 * at most maxResidentBricks payloads on the device at a time. Inverted
+		 * fields negate samples while staging; the file itself is never
+		 * modified.
+		 */
+		bool loadBricks(std::string filename, bool inverted = false, uint32_t maxResidentBricks = 65536);
+
+		/**
+		 * @brief Tell the streaming loader which part of the domain is active
+		 *
+		 * lo/hi bound the region (in world coordinates) the simulation touches
+		 * this frame; one brick of padding is added on each side. No-op unless
+		 * the field came from loadBricks.
+		 */
+		void setActiveRegion(Coord lo, Coord hi);
+
+		bool isStreaming() const { return m_stream != nullptr; }
+
 	private:
 		GPU_FUNC inline Real lerp(Real a, Real b, Real alpha) const {
 			return (1.0f - alpha)*a + alpha *b;
@@ -107,11 +182,50 @@ namespace PhysIKA {
 		 * 
 		 */
 		DeviceArray3D<Real> m_distance;
+
+		/**
+		 * @brief Texture mirror of m_distance used for hardware trilinear sampling.
+		 * 
+		 */
+		cudaArray_t m_texArray = nullptr;
+		cudaTextureObject_t m_texDistance = 0;
+
+		/**
+		 * @brief Brick storage built by compress(); replaces m_distance.
+		 *
+		 * m_brickIndex holds -1 for far bricks and the brick id otherwise;
+		 * each allocated brick stores 9x9x9 samples (8^3 cells + apron) at
+		 * m_brickPool[id * 729]. m_coarseValue keeps one representative
+		 * distance per brick for queries outside the narrow band.
+		 */
+		bool m_bSparse = false;
+		int m_nx = 0;
+		int m_ny = 0;
+		int m_nz = 0;
+		DeviceArray3D<int> m_brickIndex;
+		DeviceArray3D<Real> m_coarseValue;
+		DeviceArray<Real> m_brickPool;
+
+		/**
+		 * @brief Host-side streaming loader owned by loadBricks.
+		 *
+		 * Kept as a raw pointer so the class stays copyable into kernels;
+		 * device code never touches it. Freed by release().
+		 */
+		SDFBrickStream* m_stream = nullptr;
+
+		GPU_FUNC void getDistanceSparse(const Coord &p, Real &d, Coord &normal);
 	};
 
 	template<typename TDataType>
 	GPU_FUNC void DistanceField3D<TDataType>::getDistance(const Coord &p, Real &d, Coord &normal)
 	{
+		if (m_bSparse)
+		{
+			getDistanceSparse(p, d, normal);
+			return;
+		}
+
 		// get cell and lerp values
 		Coord fp = (p - m_left)*Coord(1.0 / m_h[0], 1.0 / m_h[1], 1.0 / m_h[2]);
 		const int i = (int)floor(fp[0]);
@@ -123,6 +237,26 @@ namespace PhysIKA {
 			normal = Coord(0);
 			return;
 		}
+		if (m_texDistance != 0 && sizeof(Real) == 4)
+		{
+			//Hardware trilinear path: one filtered fetch for the distance and six
+			//for the gradient, with cell centers at integer + 0.5 texel coordinates.
+			float tx = (float)fp[0] + 0.5f;
+			float ty = (float)fp[1] + 0.5f;
+			float tz = (float)fp[2] + 0.5f;
+
+			d = tex3D<float>(m_texDistance, tx, ty, tz);
+
+			normal[0] = tex3D<float>(m_texDistance, i + 0.5f, ty, tz) - tex3D<float>(m_texDistance, i + 1.5f, ty, tz);
+			normal[1] = tex3D<float>(m_texDistance, tx, j + 0.5f, tz) - tex3D<float>(m_texDistance, tx, j + 1.5f, tz);
+			normal[2] = tex3D<float>(m_texDistance, tx, ty, k + 0.5f) - tex3D<float>(m_texDistance, tx, ty, k + 1.5f);
+
+			Real len = normal.norm();
+			if (len < 0.0001f) normal = Coord(0);
+			else normal = normal.normalize();
+			return;
+		}
+
 		Coord ip = Coord(i, j, k);
 
 		Coord alphav = fp - ip;
@@ -169,4 +303,79 @@ namespace PhysIKA {
 		d = (1.0f - gamma) * dxy0 + gamma * dxy1;
 	}
 
+	template<typename TDataType>
+	GPU_FUNC void DistanceField3D<TDataType>::getDistanceSparse(const Coord &p, Real &d, Coord &normal)
+	{
+		Coord fp = (p - m_left)*Coord(1.0 / m_h[0], 1.0 / m_h[1], 1.0 / m_h[2]);
+		const int i = (int)floor(fp[0]);
+		const int j = (int)floor(fp[1]);
+		const int k = (int)floor(fp[2]);
+		if (i < 0 || i >= m_nx - 1 || j < 0 || j >= m_ny - 1 || k < 0 || k >= m_nz - 1) {
+			if (m_bInverted) d = -100000.0f;
+			else d = 100000.0f;
+			normal = Coord(0);
+			return;
+		}
+
+		int brick = m_brickIndex(i >> 3, j >> 3, k >> 3);
+		if (brick < 0)
+		{
+			//far from the surface: one representative distance per brick
+			d = m_coarseValue(i >> 3, j >> 3, k >> 3);
+			normal = Coord(0);
+			return;
+		}
+
+		//the one-sample apron guarantees cell (i..i+1) never crosses a brick
+		const int li = i & 7;
+		const int lj = j & 7;
+		const int lk = k & 7;
+		const Real* block = m_brickPool.getDataPtr() + brick * 729;
+
+		Coord ip = Coord(i, j, k);
+
+		Coord alphav = fp - ip;
+		Real alpha = alphav[0];
+		Real beta = alphav[1];
+		Real gamma = alphav[2];
+
+		Real d000 = block[li + 9 * (lj + 9 * lk)];
+		Real d100 = block[li + 1 + 9 * (lj + 9 * lk)];
+		Real d010 = block[li + 9 * (lj + 1 + 9 * lk)];
+		Real d110 = block[li + 1 + 9 * (lj + 1 + 9 * lk)];
+		Real d001 = block[li + 9 * (lj + 9 * (lk + 1))];
+		Real d101 = block[li + 1 + 9 * (lj + 9 * (lk + 1))];
+		Real d011 = block[li + 9 * (lj + 1 + 9 * (lk + 1))];
+		Real d111 = block[li + 1 + 9 * (lj + 1 + 9 * (lk + 1))];
+
+		Real dx00 = lerp(d000, d100, alpha);
+		Real dx10 = lerp(d010, d110, alpha);
+		Real dxy0 = lerp(dx00, dx10, beta);
+
+		Real dx01 = lerp(d001, d101, alpha);
+		Real dx11 = lerp(d011, d111, alpha);
+		Real dxy1 = lerp(dx01, dx11, beta);
+
+		Real d0y0 = lerp(d000, d010, beta);
+		Real d0y1 = lerp(d001, d011, beta);
+		Real d0yz = lerp(d0y0, d0y1, gamma);
+
+		Real d1y0 = lerp(d100, d110, beta);
+		Real d1y1 = lerp(d101, d111, beta);
+		Real d1yz = lerp(d1y0, d1y1, gamma);
+
+		Real dx0z = lerp(dx00, dx01, gamma);
+		Real dx1z = lerp(dx10, dx11, gamma);
+
+		normal[0] = d0yz - d1yz;
+		normal[1] = dx0z - dx1z;
+		normal[2] = dxy0 - dxy1;
+
+		Real l = normal.norm();
+		if (l < 0.0001f) normal = Coord(0);
+		else normal = normal.normalize();
+
+		d = (1.0f - gamma) * dxy0 + gamma * dxy1;
+	}
+
 }
@@ -16,34 +16,175 @@ namespace PhysIKA
 		
 	}
 
-__global__ void K_updatePointNeighborsInEdges(NeighborList<int> nbl, DeviceArray<TopologyModule::Edge> edges){
-	int pId = threadIdx.x + (blockIdx.x * blockDim.x);
-	if (pId >= nbl.size()) return;
+__global__ void K_ES_CountDegrees(DeviceArray<int> counts, DeviceArray<TopologyModule::Edge> edges)
+{
+	int eId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (eId >= edges.size()) return;
+
+	atomicAdd(&counts[edges[eId][0]], 1);
+	atomicAdd(&counts[edges[eId][1]], 1);
+}
 
-	int neibor_num=0;
+__global__ void K_ES_ScatterIncidence(
+	DeviceArray<int> elements,
+	DeviceArray<int> cursor,
+	DeviceArray<TopologyModule::Edge> edges)
+{
+	int eId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (eId >= edges.size()) return;
+
+	int v0 = edges[eId][0];
+	int v1 = edges[eId][1];
+
+	elements[atomicAdd(&cursor[v0], 1)] = v1;
+	elements[atomicAdd(&cursor[v1], 1)] = v0;
+}
 
-	for(int i=0;i<edges.size();++i)
+	/*!
+	*	\brief	CSR construction of the vertex-incidence list: count each
+	*	vertex's degree with atomics, exclusive-scan the counts into row
+	*	offsets and scatter the edge endpoints behind a per-vertex cursor.
+	*	Three O(E) kernels, independent of how many edges touch one vertex.
+	*/
+	template<typename TDataType>
+	void EdgeSet<TDataType>::updatePointNeighbors()
 	{
-		if(edges[i][0] == pId){
-			nbl.setElement(pId, neibor_num++, edges[i][1]);
+		if (this->m_coords.isEmpty())
+			return;
+
+		int vNum = this->m_coords.size();
+		int eNum = m_edges.size();
+
+		if (m_edgeNeighbors.isEmpty() || m_edgeNeighbors.getValue().size() != vNum)
+		{
+			m_edgeNeighbors.setElementCount(vNum);
 		}
-		if(edges[i][1] == pId){
-			nbl.setElement(pId, neibor_num++, edges[i][0]);
+
+		NeighborList<int>& nbr = m_edgeNeighbors.getValue();
+		nbr.setDynamic();
+		nbr.resizeElements(2 * eNum);
+
+		DeviceArray<int>& index = nbr.getIndex();
+		cuSafeCall(cudaMemset(index.getDataPtr(), 0, vNum * sizeof(int)));
+
+		if (eNum > 0)
+		{
+			uint eDims = cudaGridSize(eNum, BLOCK_SIZE);
+			K_ES_CountDegrees << <eDims, BLOCK_SIZE >> > (index, m_edges);
+
+			Scan scan;
+			scan.exclusive(index);
+
+			DeviceArray<int> cursor;
+			cursor.resize(vNum);
+			Function1Pt::copy(cursor, index);
+
+			K_ES_ScatterIncidence << <eDims, BLOCK_SIZE >> > (nbr.getElements(), cursor, m_edges);
+			cuSynchronize();
+
+			cursor.release();
 		}
-		nbl.setNeighborSize(pId, neibor_num);
+	}
+
+__global__ void K_ES_EdgeKeys(
+	DeviceArray<unsigned long long> keys,
+	DeviceArray<int> ids,
+	DeviceArray<TopologyModule::Triangle> triangles)
+{
+	int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (tId >= triangles.size()) return;
+
+	TopologyModule::Triangle tri = triangles[tId];
+	for (int k = 0; k < 3; k++)
+	{
+		unsigned long long v0 = tri[k];
+		unsigned long long v1 = tri[(k + 1) % 3];
+		//canonical orientation so both owning triangles emit the same key
+		unsigned long long lo = v0 < v1 ? v0 : v1;
+		unsigned long long hi = v0 < v1 ? v1 : v0;
+
+		keys[3 * tId + k] = (lo << 32) | hi;
+		ids[3 * tId + k] = 3 * tId + k;
+	}
+}
+
+__global__ void K_ES_MarkUnique(DeviceArray<int> flags, DeviceArray<unsigned long long> keys)
+{
+	int i = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (i >= keys.size()) return;
+
+	flags[i] = (i == 0 || keys[i] != keys[i - 1]) ? 1 : 0;
+}
+
+__global__ void K_ES_CompactEdges(
+	DeviceArray<TopologyModule::Edge> edges,
+	DeviceArray<unsigned long long> keys,
+	DeviceArray<int> flags,
+	DeviceArray<int> offsets)
+{
+	int i = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (i >= keys.size()) return;
+
+	if (flags[i] == 1)
+	{
+		unsigned long long key = keys[i];
+		edges[offsets[i]] = TopologyModule::Edge(
+			(TopologyModule::PointType)(key >> 32),
+			(TopologyModule::PointType)(key & 0xffffffffull));
 	}
 }
 
 	template<typename TDataType>
-	void EdgeSet<TDataType>::updatePointNeighbors()
+	void EdgeSet<TDataType>::setEdgesFromTriangles(DeviceArray<TopologyModule::Triangle>& triangles)
 	{
-		if (this->m_coords.isEmpty())
+		int tNum = triangles.size();
+		if (tNum == 0)
+		{
+			m_edges.resize(0);
+			this->updatePointNeighbors();
 			return;
+		}
+
+		int candNum = 3 * tNum;
+		uint cDims = cudaGridSize(candNum, BLOCK_SIZE);
+
+		DeviceArray<unsigned long long> keys;
+		DeviceArray<int> ids;
+		keys.resize(candNum);
+		ids.resize(candNum);
+
+		uint tDims = cudaGridSize(tNum, BLOCK_SIZE);
+		K_ES_EdgeKeys << <tDims, BLOCK_SIZE >> > (keys, ids, triangles);
+
+		Sort sorter;
+		sorter.sortByKey(keys, ids);
+
+		DeviceArray<int> flags;
+		DeviceArray<int> offsets;
+		flags.resize(candNum);
+		offsets.resize(candNum);
 
-		auto nbr = m_edgeNeighbors.getValue();
-		uint pDims = cudaGridSize(nbr.size(), BLOCK_SIZE);
-		K_updatePointNeighborsInEdges<<< pDims, BLOCK_SIZE >>>(nbr, m_edges);
+		K_ES_MarkUnique << <cDims, BLOCK_SIZE >> > (flags, keys);
+
+		Scan scan;
+		scan.exclusive(offsets, flags);
+
+		int lastOffset = 0;
+		int lastFlag = 0;
+		cuSafeCall(cudaMemcpy(&lastOffset, offsets.getDataPtr() + candNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&lastFlag, flags.getDataPtr() + candNum - 1, sizeof(int), cudaMemcpyDeviceToHost));
+		int eNum = lastOffset + lastFlag;
+
+		m_edges.resize(eNum);
+		K_ES_CompactEdges << <cDims, BLOCK_SIZE >> > (m_edges, keys, flags, offsets);
 		cuSynchronize();
+
+		keys.release();
+		ids.release();
+		flags.release();
+		offsets.release();
+
+		this->updatePointNeighbors();
 	}
 
 	template<typename TDataType>
@@ -18,6 +18,16 @@ namespace PhysIKA
 
 		void updatePointNeighbors() override;
 
+		/**
+		 * @brief Rebuild the edge list from a triangle index list, on device.
+		 * Each triangle emits its three edges as canonical 64-bit keys
+		 * (min vertex in the high word), a radix sort groups duplicates and a
+		 * mark/scan/compact pass keeps one copy of each, so shared edges are
+		 * deduplicated without any host round trip. The vertex-incidence list
+		 * is rebuilt afterwards.
+		 */
+		void setEdgesFromTriangles(DeviceArray<TopologyModule::Triangle>& triangles);
+
 		void loadSmeshFile(std::string filename);
 
 		DeviceArray<Edge>* getEdges() {return &m_edges;}
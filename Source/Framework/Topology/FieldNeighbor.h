@@ -41,6 +41,13 @@ public:
 
 	bool connect(NeighborField<T>* field2);
 
+	/**
+	 * @brief Point this field at an externally owned neighbor list, e.g. one
+	 * shared between several modules. The previous list is released when this
+	 * field held the last reference.
+	 */
+	void setReference(std::shared_ptr<NeighborList<T>> data);
+
 	NeighborField<T>* getSourceNeighborField();
 
 private:
@@ -149,6 +156,24 @@ bool NeighborField<T>::connect(NeighborField<T>* field2)
 	return true;
 }
 
+template<typename T>
+void NeighborField<T>::setReference(std::shared_ptr<NeighborList<T>> data)
+{
+	auto arr = this->getSourceNeighborField();
+	if (arr == nullptr)
+	{
+		m_data = data;
+	}
+	else
+	{
+		if (arr->m_data != nullptr && arr->m_data.use_count() == 1)
+		{
+			arr->m_data->release();
+		}
+		arr->m_data = data;
+	}
+}
+
 template<typename T>
 std::shared_ptr<NeighborList<T>> NeighborField<T>::getReference()
 {
@@ -1,6 +1,12 @@
 #pragma once
 #include "GridHash.h"
+#include "NeighborStats.h"
 #include "Core/Utility.h"
+#include <thrust/sort.h>
+#include <thrust/system/cuda/execution_policy.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/execution_policy.h>
 
 namespace PhysIKA {
 
@@ -65,13 +71,6 @@ namespace PhysIKA {
 
 		cuSafeCall(cudaMalloc((void**)&counter, num * sizeof(int)));
 		cuSafeCall(cudaMalloc((void**)&index, num * sizeof(int)));
-
-		if (m_reduce != nullptr)
-		{
-			delete m_reduce;
-		}
-
-		m_reduce = Reduction<int>::Create(num);
 	}
 
 	template<typename TDataType>
@@ -183,6 +182,18 @@ namespace PhysIKA {
 
 	}
 
+	template<typename TDataType>
+	__global__ void K_CalculateMortonCode(GridHash<TDataType> hash, Array<typename TDataType::Coord> pos, unsigned int* codes, int* permutation)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= pos.size()) return;
+
+		int3 gId3 = hash.getIndex3(pos[pId]);
+
+		codes[pId] = hash.getMortonCode(gId3.x, gId3.y, gId3.z);
+		permutation[pId] = pId;
+	}
+
 	template<typename TDataType>
 	__global__ void K_ConstructHashTable(GridHash<TDataType> hash, Array<typename TDataType::Coord> pos)
 	{
@@ -191,7 +202,14 @@ namespace PhysIKA {
 
 		int gId = hash.getIndex(pos[pId]);
 
-		if (gId < 0) return;
+		if (gId < 0)
+		{
+			if (hash.stats != nullptr)
+			{
+				atomicAdd(&hash.stats[NeighborStats::SLOT_OUT_OF_DOMAIN], 1);
+			}
+			return;
+		}
 
 		int index = atomicAdd(&(hash.counter[gId]), 1);
 		hash.ids[hash.index[gId] + index] = pId;
@@ -295,31 +313,57 @@ namespace PhysIKA {
 	}
 
 	template<typename TDataType>
-	void GridHash<TDataType>::construct(DeviceArray<Coord>& pos)
+	void GridHash<TDataType>::construct(DeviceArray<Coord>& pos, cudaStream_t stream)
 	{
-		clear();
+		stats = NeighborStats::getInstance().deviceCounters();
+
+		if (counter != nullptr)
+			cuSafeCall(cudaMemsetAsync(counter, 0, num * sizeof(int), stream));
+
+		if (index != nullptr)
+			cuSafeCall(cudaMemsetAsync(index, 0, num * sizeof(int), stream));
 
 		dim3 pDims = int(ceil(pos.size() / BLOCK_SIZE + 0.5f));
 
-		K_CalculateParticleNumber << <pDims, BLOCK_SIZE >> > (*this, pos);
-		particle_num = m_reduce->accumulate(index, num);
+		K_CalculateParticleNumber << <pDims, BLOCK_SIZE, 0, stream >> > (*this, pos);
+		particle_num = thrust::reduce(thrust::cuda::par.on(stream), index, index + num, (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::cuda::par.on(stream), index, index + num, index);
 
-		if (m_scan == nullptr)
+		if (particle_num > ids_capacity)
 		{
-			m_scan = new Scan();
+			if (ids != nullptr)
+			{
+				cuSafeCall(cudaFree(ids));
+			}
+			ids_capacity = 2 * ids_capacity > particle_num ? 2 * ids_capacity : particle_num;
+			cuSafeCall(cudaMalloc((void**)&ids, ids_capacity * sizeof(int)));
 		}
-		m_scan->exclusive(index, num);
 
-		if (ids != nullptr)
+		//		std::cout << "Particle number: " << particle_num << std::endl;
+
+		K_ConstructHashTable << <pDims, BLOCK_SIZE, 0, stream >> > (*this, pos);
+
+		if (m_sort_by_morton)
 		{
-			cuSafeCall(cudaFree(ids));
-		}
-		cuSafeCall(cudaMalloc((void**)&ids, particle_num * sizeof(int)));
+			if (pos.size() > morton_capacity)
+			{
+				if (permutation != nullptr)
+				{
+					cuSafeCall(cudaFree(permutation));
+				}
+				if (morton_codes != nullptr)
+				{
+					cuSafeCall(cudaFree(morton_codes));
+				}
+				morton_capacity = 2 * morton_capacity > pos.size() ? 2 * morton_capacity : pos.size();
+				cuSafeCall(cudaMalloc((void**)&permutation, morton_capacity * sizeof(int)));
+				cuSafeCall(cudaMalloc((void**)&morton_codes, morton_capacity * sizeof(unsigned int)));
+			}
 
-		//		std::cout << "Particle number: " << particle_num << std::endl;
+			K_CalculateMortonCode << <pDims, BLOCK_SIZE, 0, stream >> > (*this, pos, morton_codes, permutation);
 
-		K_ConstructHashTable << <pDims, BLOCK_SIZE >> > (*this, pos);
-		cuSynchronize();
+			thrust::sort_by_key(thrust::cuda::par.on(stream), morton_codes, morton_codes + pos.size(), permutation);
+		}
 	}
 
 
@@ -333,19 +377,18 @@ namespace PhysIKA {
 		K_AddTriNumber << <pDimsTri, BLOCK_SIZE >> > (*this, tri, Tri_pos);
 		cuSynchronize();
 
-		particle_num = m_reduce->accumulate(index, num);
-
-		if (m_scan == nullptr)
-		{
-			m_scan = new Scan();
-		}
-		m_scan->exclusive(index, num);
+		particle_num = thrust::reduce(thrust::device, index, index + num, (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::device, index, index + num, index);
 
-		if (ids != nullptr)
+		if (particle_num > ids_capacity)
 		{
-			cuSafeCall(cudaFree(ids));
+			if (ids != nullptr)
+			{
+				cuSafeCall(cudaFree(ids));
+			}
+			ids_capacity = 2 * ids_capacity > particle_num ? 2 * ids_capacity : particle_num;
+			cuSafeCall(cudaMalloc((void**)&ids, ids_capacity * sizeof(int)));
 		}
-		cuSafeCall(cudaMalloc((void**)&ids, particle_num * sizeof(int)));
 
 		
 		K_AddTriElement << <pDimsTri, BLOCK_SIZE >> > (*this, tri, Tri_pos);
@@ -375,6 +418,15 @@ namespace PhysIKA {
 		if (index != nullptr)
 			cuSafeCall(cudaFree(index));
 
+		if (permutation != nullptr)
+			cuSafeCall(cudaFree(permutation));
+
+		if (morton_codes != nullptr)
+			cuSafeCall(cudaFree(morton_codes));
+
+		ids_capacity = 0;
+		morton_capacity = 0;
+
 		// 		if (m_scan != nullptr)
 		// 		{
 		// 			delete m_scan;
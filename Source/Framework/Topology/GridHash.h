@@ -11,8 +11,6 @@
 namespace PhysIKA{
 
 	#define INVALID -1
-	#define BUCKETS 8
-	#define CAPACITY 16
 
 	template<typename TDataType>
 	class GridHash
@@ -27,13 +25,36 @@ namespace PhysIKA{
 
 		void setSpace(Real _h, Coord _lo, Coord _hi);
 
-		void construct(DeviceArray<Coord>& pos);
+		void construct(DeviceArray<Coord>& pos, cudaStream_t stream = 0);
 		void construct(DeviceArray<Coord>& pos, DeviceArray<Triangle>& tri, DeviceArray<Coord>& Tri_pos);
 
 		void clear();
 
 		void release();
 
+		/**
+		 * @brief Enable/disable particle reordering by the Morton code of the owning cell.
+		 * When enabled, each call to construct(pos) additionally sorts all particle ids
+		 * along a Z-order curve and stores the resulting permutation, which can be applied
+		 * to state fields (position, velocity, attribute) via permute() to make neighbor
+		 * traversal cache-coherent. Disabled by default.
+		 */
+		void enableMortonSort(bool bEnabled) { m_sort_by_morton = bEnabled; }
+		bool isMortonSortEnabled() { return m_sort_by_morton; }
+
+		/**
+		 * @brief Permutation computed by the last construct() call when Morton sorting is enabled.
+		 * permutation[i] stores the old index of the particle that should be moved to slot i.
+		 */
+		int* getPermutation() { return permutation; }
+
+		/**
+		 * @brief Physically reorder a state field with the permutation of the last construct() call.
+		 * The hash table has to be rebuilt afterwards since particle indices change.
+		 */
+		template<typename T>
+		void permute(DeviceArray<T>& data, DeviceArray<T>& buffer);
+
 		GPU_FUNC inline int getIndex(int i, int j, int k)
 		{
 			if (i < 0 || i >= nx) return INVALID;
@@ -70,10 +91,24 @@ namespace PhysIKA{
 			//return counter[gId]; 
 		}
 
-		GPU_FUNC inline int getParticleId(int gId, int n) { 
+		GPU_FUNC inline int getParticleId(int gId, int n) {
 			return ids[index[gId] + n];
 		}
 
+		GPU_FUNC static inline unsigned int expandBits(unsigned int v)
+		{
+			v = (v * 0x00010001u) & 0xFF0000FFu;
+			v = (v * 0x00000101u) & 0x0F00F00Fu;
+			v = (v * 0x00000011u) & 0xC30C30C3u;
+			v = (v * 0x00000005u) & 0x49249249u;
+			return v;
+		}
+
+		GPU_FUNC inline unsigned int getMortonCode(int i, int j, int k)
+		{
+			return (expandBits((unsigned int)i) << 2) + (expandBits((unsigned int)j) << 1) + expandBits((unsigned int)k);
+		}
+
 	public:
 		int num;
 		int nx, ny, nz;
@@ -91,10 +126,47 @@ namespace PhysIKA{
 		int* counter = nullptr;
 		int* index = nullptr;
 
-		Scan* m_scan = nullptr;
-		Reduction<int>* m_reduce = nullptr;
+		int ids_capacity = 0;	//grow-only capacity of ids, kept across rebuilds
+
+		//Morton-sort scratch, grow-only like ids: rebuilt every frame, so the
+		//buffers are kept across rebuilds instead of reallocated
+		int* permutation = nullptr;
+		unsigned int* morton_codes = nullptr;
+		int morton_capacity = 0;
+
+		//NeighborStats counter block; particles outside the domain would
+		//otherwise vanish from neighbor search without a trace
+		int* stats = nullptr;
+
+		bool m_sort_by_morton = false;
 	};
 
+	template<typename T>
+	__global__ void K_PermuteElements(T* dst, T* src, int* permutation, int num)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		dst[pId] = src[permutation[pId]];
+	}
+
+	template<typename TDataType>
+	template<typename T>
+	void GridHash<TDataType>::permute(DeviceArray<T>& data, DeviceArray<T>& buffer)
+	{
+		if (permutation == nullptr || data.size() != particle_num)
+			return;
+
+		if (buffer.size() != data.size())
+			buffer.resize(data.size());
+
+		uint pDims = cudaGridSize(data.size(), BLOCK_SIZE);
+		K_PermuteElements << <pDims, BLOCK_SIZE >> > (buffer.getDataPtr(), data.getDataPtr(), permutation, data.size());
+		cuSynchronize();
+
+		data.Swap(buffer);
+	}
+
 #ifdef PRECISION_FLOAT
 	template class GridHash<DataType3f>;
 #else
@@ -0,0 +1,188 @@
+#pragma once
+#include "Core/Platform.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility.h"
+
+#include <vector>
+
+namespace PhysIKA
+{
+	template<typename T>
+	__global__ void K_HE_Pack(
+		T* dst,
+		T* src,
+		int* ids,
+		int num)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		dst[pId] = src[ids[pId]];
+	}
+
+	/*!
+	*	\class	HaloExchange
+	*	\brief	One-directional halo transfer between two devices with
+	*	compute/copy overlap.
+	*
+	*	Each exchange round covers one id set (typically the boundaryIds() of
+	*	a PartitionedNeighborList): begin() fixes the set, post() gathers a
+	*	state field (position, velocity, attribute) into a send buffer with a
+	*	compaction kernel and puts the peer copy in flight on a dedicated
+	*	copy stream, and completion() hands out the event recorded after the
+	*	last posted copy. A solver processes its interior particles while the
+	*	copies run, makes its compute stream wait() on the event, and then
+	*	reads the halo through receivedData() on the destination device.
+	*
+	*	Channels are identified by small integers chosen by the caller and
+	*	keep their buffers across rounds, so steady-state exchanges do no
+	*	allocations.
+	*/
+	class HaloExchange
+	{
+	public:
+		HaloExchange() {};
+
+		~HaloExchange()
+		{
+			for (size_t c = 0; c < m_channels.size(); c++)
+			{
+				if (m_channels[c].send != nullptr)
+				{
+					cudaSetDevice(m_srcDevice);
+					cudaFree(m_channels[c].send);
+					cudaSetDevice(m_dstDevice);
+					cudaFree(m_channels[c].recv);
+				}
+			}
+			if (m_stream != 0)
+			{
+				cudaSetDevice(m_srcDevice);
+				cudaStreamDestroy(m_stream);
+				cudaEventDestroy(m_event);
+			}
+		}
+
+		/**
+		 * @brief Source and destination device; peer access between the two
+		 * is the caller's responsibility (cudaMemcpyPeerAsync stages through
+		 * the host without it, which still works but kills the overlap).
+		 */
+		void setPeer(int srcDevice, int dstDevice)
+		{
+			m_srcDevice = srcDevice;
+			m_dstDevice = dstDevice;
+		}
+
+		/**
+		 * @brief Start a new round over the given id set; ids lives on the
+		 * source device.
+		 */
+		void begin(DeviceArray<int>& ids)
+		{
+			if (m_stream == 0)
+			{
+				cudaSetDevice(m_srcDevice);
+				cuSafeCall(cudaStreamCreate(&m_stream));
+				cuSafeCall(cudaEventCreateWithFlags(&m_event, cudaEventDisableTiming));
+			}
+
+			m_ids = ids.getDataPtr();
+			m_count = ids.size();
+		}
+
+		/**
+		 * @brief Gather field over the round's id set and post the async
+		 * copy to the destination device.
+		 */
+		template<typename T>
+		void post(int channelId, DeviceArray<T>& field)
+		{
+			if (m_count <= 0) return;
+
+			Channel& ch = channel(channelId, m_count * sizeof(T));
+
+			cudaSetDevice(m_srcDevice);
+
+			uint pDims = cudaGridSize(m_count, BLOCK_SIZE);
+			K_HE_Pack << <pDims, BLOCK_SIZE, 0, m_stream >> > (
+				(T*)ch.send, field.getDataPtr(), m_ids, m_count);
+
+			cuSafeCall(cudaMemcpyPeerAsync(ch.recv, m_dstDevice, ch.send, m_srcDevice, m_count * sizeof(T), m_stream));
+			cuSafeCall(cudaEventRecord(m_event, m_stream));
+		}
+
+		/**
+		 * @brief Event recorded after the last posted copy.
+		 */
+		cudaEvent_t completion() { return m_event; }
+
+		/**
+		 * @brief Make a compute stream on the destination device wait for
+		 * the round without stalling the host.
+		 */
+		void wait(cudaStream_t stream)
+		{
+			if (m_count <= 0) return;
+			cuSafeCall(cudaStreamWaitEvent(stream, m_event, 0));
+		}
+
+		/**
+		 * @brief Received halo data on the destination device, m_count
+		 * elements in id-set order.
+		 */
+		template<typename T>
+		T* receivedData(int channelId)
+		{
+			return channelId < (int)m_channels.size() ? (T*)m_channels[channelId].recv : nullptr;
+		}
+
+		int count() { return m_count; }
+
+	private:
+		struct Channel
+		{
+			void* send = nullptr;
+			void* recv = nullptr;
+			size_t capacity = 0;
+		};
+
+		Channel& channel(int channelId, size_t bytes)
+		{
+			if (channelId >= (int)m_channels.size())
+			{
+				m_channels.resize(channelId + 1);
+			}
+
+			Channel& ch = m_channels[channelId];
+			if (ch.capacity < bytes)
+			{
+				size_t newCap = 2 * ch.capacity > bytes ? 2 * ch.capacity : bytes;
+				if (ch.send != nullptr)
+				{
+					cudaSetDevice(m_srcDevice);
+					cudaFree(ch.send);
+					cudaSetDevice(m_dstDevice);
+					cudaFree(ch.recv);
+				}
+				cudaSetDevice(m_srcDevice);
+				cuSafeCall(cudaMalloc(&ch.send, newCap));
+				cudaSetDevice(m_dstDevice);
+				cuSafeCall(cudaMalloc(&ch.recv, newCap));
+				ch.capacity = newCap;
+			}
+			return ch;
+		}
+
+		int m_srcDevice = 0;
+		int m_dstDevice = 0;
+
+		int* m_ids = nullptr;
+		int m_count = 0;
+
+		cudaStream_t m_stream = 0;
+		cudaEvent_t m_event = 0;
+
+		std::vector<Channel> m_channels;
+	};
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include "Core/Platform.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility.h"
+#include "Framework/Topology/HaloExchange.h"
+
+#ifdef PHYSIKA_ENABLE_MPI
+#include <mpi.h>
+
+#include <vector>
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	MpiHaloExchange
+	*	\brief	Halo transfer to one neighbor rank over CUDA-aware MPI.
+	*
+	*	Same round structure as the on-node HaloExchange: begin() fixes the
+	*	outgoing id set and trades counts with the neighbor, post() packs a
+	*	state field with the K_HE_Pack compaction kernel and hands the device
+	*	pointers straight to MPI_Isend/MPI_Irecv, finish() waits the round
+	*	out. The interior of the subdomain is free to compute between post()
+	*	and finish(). Requires a CUDA-aware MPI build (OpenMPI with UCX or
+	*	MVAPICH2-GDR on our farm); a plain MPI segfaults on device pointers.
+	*
+	*	A rank in the middle of a slab chain holds two of these, one per
+	*	neighbor, with distinct base tags.
+	*/
+	class MpiHaloExchange
+	{
+	public:
+		MpiHaloExchange() {};
+
+		~MpiHaloExchange()
+		{
+			for (size_t c = 0; c < m_channels.size(); c++)
+			{
+				if (m_channels[c].send != nullptr)
+				{
+					cudaFree(m_channels[c].send);
+					cudaFree(m_channels[c].recv);
+				}
+			}
+		}
+
+		/**
+		 * @brief Neighbor rank and the base tag of this exchange; the two
+		 * endpoints have to use the same base tag.
+		 */
+		void setNeighbor(int rank, int baseTag = 0)
+		{
+			m_neighbor = rank;
+			m_baseTag = baseTag;
+		}
+
+		/**
+		 * @brief Start a round: fix the outgoing id set and trade element
+		 * counts with the neighbor. Synchronizes the packing stream, the
+		 * counts travel by blocking sendrecv.
+		 */
+		void begin(DeviceArray<int>& ids, cudaStream_t packStream = 0)
+		{
+			m_ids = ids.getDataPtr();
+			m_sendCount = ids.size();
+			m_packStream = packStream;
+
+			MPI_Sendrecv(&m_sendCount, 1, MPI_INT, m_neighbor, m_baseTag,
+				&m_recvCount, 1, MPI_INT, m_neighbor, m_baseTag,
+				MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		}
+
+		/**
+		 * @brief Pack field over the round's id set and put the send/receive
+		 * pair in flight; the device pointers go straight to MPI.
+		 */
+		template<typename T>
+		void post(int channelId, DeviceArray<T>& field)
+		{
+			Channel& ch = channel(channelId,
+				(m_sendCount > m_recvCount ? m_sendCount : m_recvCount) * sizeof(T));
+
+			if (m_sendCount > 0)
+			{
+				uint pDims = cudaGridSize(m_sendCount, BLOCK_SIZE);
+				K_HE_Pack << <pDims, BLOCK_SIZE, 0, m_packStream >> > (
+					(T*)ch.send, field.getDataPtr(), m_ids, m_sendCount);
+			}
+			//MPI reads the buffer as soon as Isend is posted
+			cudaStreamSynchronize(m_packStream);
+
+			int tag = m_baseTag + 1 + channelId;
+			if (m_sendCount > 0)
+			{
+				MPI_Request req;
+				MPI_Isend(ch.send, m_sendCount * sizeof(T), MPI_BYTE, m_neighbor, tag, MPI_COMM_WORLD, &req);
+				m_requests.push_back(req);
+			}
+			if (m_recvCount > 0)
+			{
+				MPI_Request req;
+				MPI_Irecv(ch.recv, m_recvCount * sizeof(T), MPI_BYTE, m_neighbor, tag, MPI_COMM_WORLD, &req);
+				m_requests.push_back(req);
+			}
+		}
+
+		/**
+		 * @brief Wait out every transfer of the round.
+		 */
+		void finish()
+		{
+			if (!m_requests.empty())
+			{
+				MPI_Waitall((int)m_requests.size(), m_requests.data(), MPI_STATUSES_IGNORE);
+				m_requests.clear();
+			}
+		}
+
+		/**
+		 * @brief Received halo data on the local device, recvCount() elements.
+		 */
+		template<typename T>
+		T* receivedData(int channelId)
+		{
+			return channelId < (int)m_channels.size() ? (T*)m_channels[channelId].recv : nullptr;
+		}
+
+		int sendCount() { return m_sendCount; }
+		int recvCount() { return m_recvCount; }
+
+	private:
+		struct Channel
+		{
+			void* send = nullptr;
+			void* recv = nullptr;
+			size_t capacity = 0;
+		};
+
+		Channel& channel(int channelId, size_t bytes)
+		{
+			if (channelId >= (int)m_channels.size())
+			{
+				m_channels.resize(channelId + 1);
+			}
+
+			Channel& ch = m_channels[channelId];
+			if (ch.capacity < bytes)
+			{
+				size_t newCap = 2 * ch.capacity > bytes ? 2 * ch.capacity : bytes;
+				if (ch.send != nullptr)
+				{
+					cudaFree(ch.send);
+					cudaFree(ch.recv);
+				}
+				cuSafeCall(cudaMalloc(&ch.send, newCap));
+				cuSafeCall(cudaMalloc(&ch.recv, newCap));
+				ch.capacity = newCap;
+			}
+			return ch;
+		}
+
+		int m_neighbor = -1;
+		int m_baseTag = 0;
+
+		int* m_ids = nullptr;
+		int m_sendCount = 0;
+		int m_recvCount = 0;
+
+		cudaStream_t m_packStream = 0;
+
+		std::vector<MPI_Request> m_requests;
+		std::vector<Channel> m_channels;
+	};
+}
+#endif
@@ -25,12 +25,12 @@ namespace PhysIKA
 		COMM_FUNC int size() { return m_index.size(); }
 
 		GPU_FUNC int getNeighborSize(int i)
-		{ 
+		{
 			if (!isLimited())
 			{
 				if (i >= m_index.size() - 1)
 				{
-					return m_elements.size() - m_index[i];
+					return elementSize() - m_index[i];
 				}
 				return m_index[i + 1] - m_index[i];
 			}
@@ -40,6 +40,15 @@ namespace PhysIKA
 			}
 		}
 
+		/**
+		 * @brief Number of stored elements. May be smaller than the capacity of the
+		 * underlying buffer when the list was sized via resizeElements().
+		 */
+		COMM_FUNC int elementSize()
+		{
+			return m_elementNum >= 0 ? m_elementNum : m_elements.size();
+		}
+
 		COMM_FUNC int getNeighborLimit()
 		{
 			return m_maxNum;
@@ -65,6 +74,48 @@ namespace PhysIKA
 				m_elements[m_maxNum*i + j] = elem;
 		}
 
+		/**
+		 * @brief Offset of particle i's first neighbor in the flat element buffer.
+		 * Together with getElementByOffset() this allows a warp (or sub-warp tile)
+		 * to iterate one particle's neighbors cooperatively with coalesced loads:
+		 *
+		 *   int start = nbr.beginIndex(i);
+		 *   int num   = nbr.getNeighborSize(i);
+		 *   for (int j = lane; j < num; j += tileSize) {
+		 *       ElementType nb = nbr.getElementByOffset(start + j);
+		 *       ...
+		 *   }
+		 */
+		GPU_FUNC int beginIndex(int i)
+		{
+			if (!isLimited())
+				return m_index[i];
+			else
+				return m_maxNum * i;
+		}
+
+		GPU_FUNC ElementType getElementByOffset(int offset)
+		{
+			return m_elements[offset];
+		}
+
+		/**
+		 * @brief Tile-cooperative neighbor traversal: lane lane of a tile of tileSize
+		 * threads visits neighbors lane, lane+tileSize, ... of particle i. The functor
+		 * is called as func(j, element) with j being the neighbor's local index.
+		 */
+		template<typename Function>
+		GPU_FUNC void forEachNeighborTiled(int i, int lane, int tileSize, Function func)
+		{
+			int start = beginIndex(i);
+			int num = getNeighborSize(i);
+
+			for (int j = lane; j < num; j += tileSize)
+			{
+				func(j, m_elements[start + j]);
+			}
+		}
+
 		COMM_FUNC bool isLimited()
 		{
 			return m_maxNum > 0;
@@ -82,10 +133,27 @@ namespace PhysIKA
 			}
 		}
 		
+		/**
+		 * @brief Grow-only sizing of the element buffer. Storage is reallocated with
+		 * amortized doubling only when the requested size exceeds the current capacity,
+		 * so per-step rebuilds with fluctuating neighbor counts (emitters!) do zero
+		 * allocations in steady state.
+		 */
+		void resizeElements(int num)
+		{
+			if (num > m_elements.size())
+			{
+				int capacity = 2 * m_elements.size() > num ? 2 * m_elements.size() : num;
+				m_elements.resize(capacity);
+			}
+			m_elementNum = num;
+		}
+
 		void release()
 		{
 			m_elements.release();
 			m_index.release();
+			m_elementNum = -1;
 		}
 
 		void setNeighborLimit(int nbrMax)
@@ -102,6 +170,7 @@ namespace PhysIKA
 		void copyFrom(NeighborList<ElementType>& neighborlist)
 		{
 			m_maxNum = neighborlist.m_maxNum;
+			m_elementNum = neighborlist.m_elementNum;
 			if (m_elements.size() != neighborlist.m_elements.size())
 				m_elements.resize(neighborlist.m_elements.size());
 
@@ -120,6 +189,7 @@ namespace PhysIKA
 	private:
 
 		int m_maxNum;
+		int m_elementNum = -1;	//-1: element buffer is exactly sized, use m_elements.size()
 		DeviceArray<ElementType> m_elements;
 		DeviceArray<int> m_index;
 	};
@@ -3,9 +3,15 @@
 #include "Core/Utility.h"
 #include "Framework/Framework/Node.h"
 #include "Framework/Topology/NeighborList.h"
+#include "Framework/Topology/NeighborStats.h"
 #include "Framework/Topology/FieldNeighbor.h"
 #include "Framework/Framework/SceneGraph.h"
 #include "Core/Utility/Scan.h"
+#include "Core/Array/FrameArena.h"
+#include <thrust/reduce.h>
+#include <thrust/system/cuda/execution_policy.h>
+#include <thrust/scan.h>
+#include <thrust/execution_policy.h>
 
 
 
@@ -86,6 +92,38 @@ namespace PhysIKA
 	NeighborQuery<TDataType>::~NeighborQuery()
 	{
 		m_hash.release();
+		m_compact_hash.release();
+		m_hash_fine.release();
+		m_hash_coarse.release();
+
+		if (m_stream != nullptr)
+		{
+			cuSafeCall(cudaStreamDestroy(m_stream));
+		}
+		if (m_copy_event != nullptr)
+		{
+			cuSafeCall(cudaEventDestroy(m_copy_event));
+		}
+		m_pos_staging.release();
+
+		m_refPosition.release();
+		m_displacement.release();
+		if (m_reduce_real != nullptr)
+		{
+			delete m_reduce_real;
+		}
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void K_CalDisplacement(
+		DeviceArray<Real> displacement,
+		DeviceArray<Coord> position,
+		DeviceArray<Coord> refPosition)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= position.size()) return;
+
+		displacement[pId] = (position[pId] - refPosition[pId]).norm();
 	}
 
 	template<typename TDataType>
@@ -161,16 +199,79 @@ namespace PhysIKA
 					this->outNeighborhood()->setElementCount(p_num);
 				}
 
-				m_hash.clear();
-				m_hash.construct(this->inPosition()->getValue());
+				Real h = this->inRadius()->getValue();
+
+				if (!this->inRadiusArray()->isEmpty())
+				{
+					queryNeighborVariableDynamic(this->outNeighborhood()->getValue(), this->inPosition()->getValue(), this->inRadiusArray()->getValue());
+					return;
+				}
+
+				if (m_incremental)
+				{
+					Real slack = m_slack_ratio * h;
+
+					if (m_refPosition.size() == p_num)
+					{
+						if (m_reduce_real == nullptr)
+						{
+							m_reduce_real = Reduction<Real>::Create(p_num);
+						}
+						if (m_displacement.size() != p_num)
+						{
+							m_displacement.resize(p_num);
+						}
+
+						uint pDims = cudaGridSize(p_num, BLOCK_SIZE);
+						K_CalDisplacement << <pDims, BLOCK_SIZE >> > (m_displacement, this->inPosition()->getValue(), m_refPosition);
+						cuSynchronize();
+
+						Real maxDisp = m_reduce_real->maximum(m_displacement.getDataPtr(), p_num);
+
+						//The cached list is valid as long as no pair can have moved across the slack margin.
+						if (Real(2) * maxDisp < slack)
+						{
+							return;
+						}
+					}
+
+					h += slack;
+
+					if (m_refPosition.size() != p_num)
+					{
+						m_refPosition.resize(p_num);
+					}
+					Function1Pt::copy(m_refPosition, this->inPosition()->getValue());
+				}
+
+				if (m_use_compact_hash)
+				{
+					if (m_hash_spacing != h)
+					{
+						m_compact_hash.setSpace(h, m_lowBound, m_highBound);
+						m_hash_spacing = h;
+					}
+
+					m_compact_hash.construct(this->inPosition()->getValue());
+				}
+				else
+				{
+					if (m_hash_spacing != h)
+					{
+						m_hash.setSpace(h, m_lowBound, m_highBound);
+						m_hash_spacing = h;
+					}
+
+					m_hash.construct(this->inPosition()->getValue());
+				}
 
 				if (!this->outNeighborhood()->getValue().isLimited())
 				{
-					queryNeighborDynamic(this->outNeighborhood()->getValue(), this->inPosition()->getValue(), this->inRadius()->getValue());
+					queryNeighborDynamic(this->outNeighborhood()->getValue(), this->inPosition()->getValue(), h);
 				}
 				else
 				{
-					queryNeighborFixed(this->outNeighborhood()->getValue(), this->inPosition()->getValue(), this->inRadius()->getValue());
+					queryNeighborFixed(this->outNeighborhood()->getValue(), this->inPosition()->getValue(), h);
 				}
 			}
 		}
@@ -184,14 +285,43 @@ namespace PhysIKA
 					this->outNeighborhood()->setElementCount(p_num);
 				}
 
-				if (triangle_first)
-					m_hash.clear();
-				//printf("hash clear\n");
+				//The cell-to-triangle lists are cached; they are only rebuilt when the mesh
+				//is tagged dirty or the triangle vertex buffer itself was replaced.
+				bool rebin = triangle_first || m_tri_dirty
+					|| m_tri_pos_ptr != this->inTrianglePosition()->getValue().getDataPtr()
+					|| m_tri_num != this->inTrianglePosition()->getValue().size();
+
+				if (m_use_tri_bvh)
+				{
+					//tree topology survives deformation, only the boxes are refitted
+					if (rebin)
+					{
+						m_tri_bvh.construct(this->inTrianglePosition()->getValue(), this->inTriangleIndex()->getValue());
 
-				if (triangle_first)
+						m_tri_pos_ptr = this->inTrianglePosition()->getValue().getDataPtr();
+						m_tri_num = this->inTrianglePosition()->getValue().size();
+						m_tri_dirty = false;
+					}
+					else
+					{
+						m_tri_bvh.refit(this->inTrianglePosition()->getValue(), this->inTriangleIndex()->getValue());
+					}
+
+					triangle_first = false;
+					m_tri_bvh.queryTriangleNeighbors(this->outNeighborhood()->getValue(), this->inPosition()->getValue(), this->inRadius()->getValue());
+					return;
+				}
+
+				if (rebin)
+				{
+					m_hash.clear();
 					m_hash.construct(this->inPosition()->getValue(), this->inTriangleIndex()->getValue(), this->inTrianglePosition()->getValue());
 
-				//printf("hash constract\n");
+					m_tri_pos_ptr = this->inTrianglePosition()->getValue().getDataPtr();
+					m_tri_num = this->inTrianglePosition()->getValue().size();
+					m_tri_dirty = false;
+				}
+
 				triangle_first = false;
 				queryNeighborTriDynamic(this->outNeighborhood()->getValue(), this->inPosition()->getValue(), this->inTrianglePosition()->getValue(), this->inTriangleIndex()->getValue(), this->inRadius()->getValue());
 			}
@@ -199,6 +329,104 @@ namespace PhysIKA
 	}
 
 
+	template<typename TDataType>
+	void NeighborQuery<TDataType>::computeAsync()
+	{
+		//the staged path covers the common dynamic particle query only;
+		//everything else falls back to the synchronous build
+		bool staged = !this->inPosition()->isEmpty()
+			&& this->inTriangleIndex()->isEmpty()
+			&& this->inRadiusArray()->isEmpty()
+			&& !m_incremental;
+
+		if (!staged)
+		{
+			compute();
+			return;
+		}
+
+		int p_num = this->inPosition()->getElementCount();
+		if (this->outNeighborhood()->getElementCount() != p_num)
+		{
+			this->outNeighborhood()->setElementCount(p_num);
+		}
+
+		NeighborList<int>& nbrList = this->outNeighborhood()->getValue();
+		if (nbrList.isLimited())
+		{
+			compute();
+			return;
+		}
+		if (nbrList.getIndex().size() != p_num)
+		{
+			nbrList.resize(p_num);
+		}
+
+		if (m_stream == nullptr)
+		{
+			cuSafeCall(cudaStreamCreateWithFlags(&m_stream, cudaStreamNonBlocking));
+			cuSafeCall(cudaEventCreateWithFlags(&m_copy_event, cudaEventDisableTiming));
+		}
+
+		Real h = this->inRadius()->getValue();
+
+		//Snapshot the positions on the legacy stream: it orders after every
+		//earlier write and a predictor launched afterwards orders after it,
+		//so the copy races with neither side. The build then reads only the
+		//snapshot and never the live positions.
+		if (m_pos_staging.size() != p_num)
+		{
+			m_pos_staging.resize(p_num);
+		}
+		cuSafeCall(cudaMemcpyAsync(m_pos_staging.getDataPtr(), this->inPosition()->getValue().getDataPtr(), p_num * sizeof(Coord), cudaMemcpyDeviceToDevice, 0));
+		cuSafeCall(cudaEventRecord(m_copy_event, 0));
+		cuSafeCall(cudaStreamWaitEvent(m_stream, m_copy_event, 0));
+
+		//hash construction and the count pass run on the private stream; the
+		//gather is finished in sync(), after the stream is drained
+		uint pDims = cudaGridSize(p_num, BLOCK_SIZE);
+		if (m_use_compact_hash)
+		{
+			if (m_hash_spacing != h)
+			{
+				m_compact_hash.setSpace(h, m_lowBound, m_highBound);
+				m_hash_spacing = h;
+			}
+
+			m_compact_hash.construct(m_pos_staging, m_stream);
+			K_CalNeighborSize << <pDims, BLOCK_SIZE, 0, m_stream >> > (nbrList.getIndex(), m_pos_staging, m_pos_staging, m_compact_hash, h);
+		}
+		else
+		{
+			if (m_hash_spacing != h)
+			{
+				m_hash.setSpace(h, m_lowBound, m_highBound);
+				m_hash_spacing = h;
+			}
+
+			m_hash.construct(m_pos_staging, m_stream);
+			K_CalNeighborSize << <pDims, BLOCK_SIZE, 0, m_stream >> > (nbrList.getIndex(), m_pos_staging, m_pos_staging, m_hash, h);
+		}
+
+		m_async_h = h;
+		m_async_pending = true;
+	}
+
+	template<typename TDataType>
+	void NeighborQuery<TDataType>::sync()
+	{
+		if (m_async_pending)
+		{
+			//the only wait on the private stream; after it the hash and the
+			//counts are complete and the gather runs against the snapshot
+			cuSafeCall(cudaStreamSynchronize(m_stream));
+
+			gatherNeighbors(this->outNeighborhood()->getValue(), m_pos_staging, m_pos_staging, m_async_h);
+
+			m_async_pending = false;
+		}
+	}
+
 	template<typename TDataType>
 	void NeighborQuery<TDataType>::setBoundingBox(Coord lowerBound, Coord upperBound)
 	{
@@ -241,12 +469,12 @@ namespace PhysIKA
 		}
 	}
 
-	template<typename Real, typename Coord, typename TDataType>
+	template<typename Real, typename Coord, typename THash>
 	__global__ void K_CalNeighborSize(
 		DeviceArray<int> count,
 		DeviceArray<Coord> position_new,
-		DeviceArray<Coord> position, 
-		GridHash<TDataType> hash, 
+		DeviceArray<Coord> position,
+		THash hash,
 		Real h)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
@@ -334,11 +562,88 @@ namespace PhysIKA
 	}
 
 	template<typename Real, typename Coord, typename TDataType>
+	__global__ void K_CalNeighborSizeVar(
+		DeviceArray<int> count,
+		DeviceArray<Coord> position_new,
+		DeviceArray<Coord> position,
+		DeviceArray<Real> radii,
+		GridHash<TDataType> hashFine,
+		GridHash<TDataType> hashCoarse,
+		Real fine_ds)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= position_new.size()) return;
+
+		Real h = radii[pId];
+		GridHash<TDataType>& hash = h <= fine_ds ? hashFine : hashCoarse;
+
+		Coord pos_ijk = position_new[pId];
+		int3 gId3 = hash.getIndex3(pos_ijk);
+
+		int counter = 0;
+		for (int c = 0; c < 27; c++)
+		{
+			int cId = hash.getIndex(gId3.x + offset1[c][0], gId3.y + offset1[c][1], gId3.z + offset1[c][2]);
+			if (cId >= 0) {
+				int totalNum = hash.getCounter(cId);
+				for (int i = 0; i < totalNum; i++) {
+					int nbId = hash.getParticleId(cId, i);
+					Real d_ij = (pos_ijk - position[nbId]).norm();
+					if (d_ij < h)
+					{
+						counter++;
+					}
+				}
+			}
+		}
+
+		count[pId] = counter;
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void K_GetNeighborElementsVar(
+		NeighborList<int> nbr,
+		DeviceArray<Coord> position_new,
+		DeviceArray<Coord> position,
+		DeviceArray<Real> radii,
+		GridHash<TDataType> hashFine,
+		GridHash<TDataType> hashCoarse,
+		Real fine_ds)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= position_new.size()) return;
+
+		Real h = radii[pId];
+		GridHash<TDataType>& hash = h <= fine_ds ? hashFine : hashCoarse;
+
+		Coord pos_ijk = position_new[pId];
+		int3 gId3 = hash.getIndex3(pos_ijk);
+
+		int j = 0;
+		for (int c = 0; c < 27; c++)
+		{
+			int cId = hash.getIndex(gId3.x + offset1[c][0], gId3.y + offset1[c][1], gId3.z + offset1[c][2]);
+			if (cId >= 0) {
+				int totalNum = hash.getCounter(cId);
+				for (int i = 0; i < totalNum; i++) {
+					int nbId = hash.getParticleId(cId, i);
+					Real d_ij = (pos_ijk - position[nbId]).norm();
+					if (d_ij < h)
+					{
+						nbr.setElement(pId, j, nbId);
+						j++;
+					}
+				}
+			}
+		}
+	}
+
+	template<typename Real, typename Coord, typename THash>
 	__global__ void K_GetNeighborElements(
 		NeighborList<int> nbr,
 		DeviceArray<Coord> position_new,
-		DeviceArray<Coord> position, 
-		GridHash<TDataType> hash, 
+		DeviceArray<Coord> position,
+		THash hash,
 		Real h)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
@@ -430,12 +735,58 @@ namespace PhysIKA
 		
 	}
 
+	//Deterministic mode: neighbor iteration order is the accumulation order
+	//of every gather sum downstream, and the grid hash fills its cells in
+	//whatever order the atomics land. Sorting each segment into ascending
+	//index order makes the lists - and everything folded over them -
+	//bitwise reproducible. Segments hold a few dozen entries, so an
+	//insertion sort per particle is cheap.
+	__global__ void K_SortNeighborElements(
+		NeighborList<int> neighbors)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= neighbors.size()) return;
+
+		int nbSize = neighbors.getNeighborSize(pId);
+		for (int i = 1; i < nbSize; i++)
+		{
+			int elem = neighbors.getElement(pId, i);
+			int j = i - 1;
+			while (j >= 0 && neighbors.getElement(pId, j) > elem)
+			{
+				neighbors.setElement(pId, j + 1, neighbors.getElement(pId, j));
+				j--;
+			}
+			neighbors.setElement(pId, j + 1, elem);
+		}
+	}
+
+	//always-on health counter: one histogram entry per particle, so silent
+	//truncation or starvation shows up in the per-frame NeighborStats pull
+	__global__ void K_NeighborHistogram(
+		NeighborList<int> neighbors,
+		int* stats)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= neighbors.size()) return;
+
+		int bin = neighbors.getNeighborSize(pId) / NeighborStats::HIST_BIN_WIDTH;
+		bin = bin >= NeighborStats::HIST_BINS ? NeighborStats::HIST_BINS - 1 : bin;
+		atomicAdd(&stats[NeighborStats::SLOT_HISTOGRAM + bin], 1);
+	}
+
 	template<typename TDataType>
 	void NeighborQuery<TDataType>::queryNeighborSize(DeviceArray<int>& num, DeviceArray<Coord>& pos, Real h)
 	{
 		uint pDims = cudaGridSize(num.size(), BLOCK_SIZE);
-		K_CalNeighborSize << <pDims, BLOCK_SIZE >> > (num, pos, this->inPosition()->getValue(), m_hash, h);
-		cuSynchronize();
+		if (m_use_compact_hash)
+		{
+			K_CalNeighborSize << <pDims, BLOCK_SIZE >> > (num, pos, this->inPosition()->getValue(), m_compact_hash, h);
+		}
+		else
+		{
+			K_CalNeighborSize << <pDims, BLOCK_SIZE >> > (num, pos, this->inPosition()->getValue(), m_hash, h);
+		}
 	}
 
 	template<typename TDataType>
@@ -460,47 +811,146 @@ namespace PhysIKA
 
 		queryNeighborSize(nbrNum, pos, h);
 
-		int sum = m_reduce.accumulate(nbrNum.getDataPtr(), nbrNum.size());
+		gatherNeighbors(nbrList, pos, this->inPosition()->getValue(), h);
+	}
 
-		m_scan.exclusive(nbrNum, true);
-		cuSynchronize();
+	//Finishes a dynamic query whose count pass already ran: prefix-sums the
+	//counts, sizes the element buffer and gathers the ids. pos holds the
+	//query positions and ref the hashed ones; both the synchronous path and
+	//sync() end here.
+	template<typename TDataType>
+	void NeighborQuery<TDataType>::gatherNeighbors(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, DeviceArray<Coord>& ref, Real h)
+	{
+		DeviceArray<int>& nbrNum = nbrList.getIndex();
+
+		int sum = thrust::reduce(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), nbrNum.getDataPtr());
 
 
 		if (sum > 0)
 		{
-			DeviceArray<int>& elements = nbrList.getElements();
-			elements.resize(sum);
+			nbrList.resizeElements(sum);
 
 			uint pDims = cudaGridSize(pos.size(), BLOCK_SIZE);
-			K_GetNeighborElements << <pDims, BLOCK_SIZE >> > (nbrList, pos, this->inPosition()->getValue(), m_hash, h);
+			if (m_use_compact_hash)
+			{
+				K_GetNeighborElements << <pDims, BLOCK_SIZE >> > (nbrList, pos, ref, m_compact_hash, h);
+			}
+			else
+			{
+				K_GetNeighborElements << <pDims, BLOCK_SIZE >> > (nbrList, pos, ref, m_hash, h);
+			}
+			cuSynchronize();
+
+			if (SceneGraph::getInstance().isDeterministic())
+			{
+				K_SortNeighborElements << <pDims, BLOCK_SIZE >> > (nbrList);
+				cuSynchronize();
+			}
+		}
+
+		{
+			uint pDims = cudaGridSize(pos.size(), BLOCK_SIZE);
+			K_NeighborHistogram << <pDims, BLOCK_SIZE >> > (nbrList, NeighborStats::getInstance().deviceCounters());
 			cuSynchronize();
 		}
 	}
 	template<typename TDataType>
-	void NeighborQuery<TDataType>::queryNeighborTriDynamic(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, DeviceArray<Coord>& posT, DeviceArray<Triangle>& Tris, Real h)
+	void NeighborQuery<TDataType>::queryNeighborVariableDynamic(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, DeviceArray<Real>& radii)
 	{
 		if (pos.size() <= 0)
 		{
 			return;
 		}
 
+		if (m_reduce_real == nullptr)
+		{
+			m_reduce_real = Reduction<Real>::Create(pos.size());
+		}
+
+		Real rMin = m_reduce_real->minimum(radii.getDataPtr(), radii.size());
+		Real rMax = m_reduce_real->maximum(radii.getDataPtr(), radii.size());
+
+		if (rMax - rMin < EPSILON)
+		{
+			//uniform radii, the two-level machinery degenerates to the standard path
+			if (m_hash_spacing != rMax)
+			{
+				m_hash.setSpace(rMax, m_lowBound, m_highBound);
+				m_hash_spacing = rMax;
+			}
+			m_hash.construct(pos);
+			queryNeighborDynamic(nbrList, pos, rMax);
+			return;
+		}
+
+		//A particle with radius r queries the finest grid whose cell size still covers r,
+		//so small particles avoid scanning the fat coarse cells of the large ones.
+		if (m_fine_spacing != rMin)
+		{
+			m_hash_fine.setSpace(rMin, m_lowBound, m_highBound);
+			m_fine_spacing = rMin;
+		}
+		if (m_coarse_spacing != rMax)
+		{
+			m_hash_coarse.setSpace(rMax, m_lowBound, m_highBound);
+			m_coarse_spacing = rMax;
+		}
+
+		m_hash_fine.construct(pos);
+		m_hash_coarse.construct(pos);
+
 		DeviceArray<int>& nbrNum = nbrList.getIndex();
 		if (nbrNum.size() != pos.size())
 			nbrList.resize(pos.size());
 
-		queryNeighborSizeTri(nbrNum, pos, Tris, posT, h);
+		uint pDims = cudaGridSize(pos.size(), BLOCK_SIZE);
+		K_CalNeighborSizeVar << <pDims, BLOCK_SIZE >> > (nbrNum, pos, this->inPosition()->getValue(), radii, m_hash_fine, m_hash_coarse, rMin);
+		cuSynchronize();
+
+		int sum = thrust::reduce(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), nbrNum.getDataPtr());
 
-		int sum = m_reduce.accumulate(nbrNum.getDataPtr(), nbrNum.size());
+		if (sum > 0)
+		{
+			nbrList.resizeElements(sum);
+
+			K_GetNeighborElementsVar << <pDims, BLOCK_SIZE >> > (nbrList, pos, this->inPosition()->getValue(), radii, m_hash_fine, m_hash_coarse, rMin);
+			cuSynchronize();
+
+			if (SceneGraph::getInstance().isDeterministic())
+			{
+				K_SortNeighborElements << <pDims, BLOCK_SIZE >> > (nbrList);
+				cuSynchronize();
+			}
+		}
 
-		m_scan.exclusive(nbrNum, true);
+		K_NeighborHistogram << <pDims, BLOCK_SIZE >> > (nbrList, NeighborStats::getInstance().deviceCounters());
 		cuSynchronize();
+	}
+
+	template<typename TDataType>
+	void NeighborQuery<TDataType>::queryNeighborTriDynamic(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, DeviceArray<Coord>& posT, DeviceArray<Triangle>& Tris, Real h)
+	{
+		if (pos.size() <= 0)
+		{
+			return;
+		}
+
+		DeviceArray<int>& nbrNum = nbrList.getIndex();
+		if (nbrNum.size() != pos.size())
+			nbrList.resize(pos.size());
+
+		queryNeighborSizeTri(nbrNum, pos, Tris, posT, h);
+
+		int sum = thrust::reduce(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), nbrNum.getDataPtr());
 
 
 		if (sum > 0)
 		{
-			DeviceArray<int>& elements = nbrList.getElements();
-			elements.resize(sum);
-			elements.reset();
+			nbrList.resizeElements(sum);
+			nbrList.getElements().reset();
 
 			uint pDims = cudaGridSize(pos.size(), BLOCK_SIZE);
 			K_GetNeighborElementsTri << <pDims, BLOCK_SIZE >> > (nbrList, pos, this->inPosition()->getValue(), Tris, posT, m_hash, h);
@@ -510,20 +960,22 @@ namespace PhysIKA
 
 	}
 
-	template<typename Real, typename Coord, typename TDataType>
+	template<typename Real, typename Coord, typename THash>
 	__global__ void K_ComputeNeighborFixed(
-		NeighborList<int> neighbors, 
+		NeighborList<int> neighbors,
 		DeviceArray<Coord> position_new,
-		DeviceArray<Coord> position, 
-		GridHash<TDataType> hash, 
+		DeviceArray<Coord> position,
+		THash hash,
 		Real h,
 		int* heapIDs,
-		Real* heapDistance)
+		Real* heapDistance,
+		int* stats)
 	{
 		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
 		if (pId > position_new.size()) return;
 
 		int nbrLimit = neighbors.getNeighborLimit();
+		int dropped = 0;
 
 		int* ids(heapIDs + pId * nbrLimit);// = new int[nbrLimit];
 		Real* distance(heapDistance + pId * nbrLimit);// = new Real[nbrLimit];
@@ -550,6 +1002,11 @@ namespace PhysIKA
 						}
 						else
 						{
+							//one candidate inside the radius is lost either
+							//way, whether it replaces the current farthest
+							//or is rejected itself
+							dropped++;
+
 							int maxId = 0;
 							float maxDist = distance[0];
 							for (int ne = 1; ne < nbrLimit; ne++)
@@ -578,29 +1035,60 @@ namespace PhysIKA
 		{
 			neighbors.setElement(pId, bId, ids[bId]);
 		}
+
+		if (stats != NULL && dropped > 0)
+		{
+			atomicAdd(&stats[NeighborStats::SLOT_DROPPED], dropped);
+		}
 	}
 
 	template<typename TDataType>
 	void NeighborQuery<TDataType>::queryNeighborFixed(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, Real h)
 	{
 		int num = pos.size();
-		int* ids;
-		Real* distance;
-		cuSafeCall(cudaMalloc((void**)&ids, num * sizeof(int) * nbrList.getNeighborLimit()));
-		cuSafeCall(cudaMalloc((void**)&distance, num * sizeof(int) * nbrList.getNeighborLimit()));
+		int* ids = FrameArena::getInstance().allocate<int>(num * nbrList.getNeighborLimit());
+		Real* distance = FrameArena::getInstance().allocate<Real>(num * nbrList.getNeighborLimit());
 
 		uint pDims = cudaGridSize(num, BLOCK_SIZE);
-		K_ComputeNeighborFixed << <pDims, BLOCK_SIZE >> > (
-			nbrList, 
-			pos, 
-			this->inPosition()->getValue(), 
-			m_hash, 
-			h, 
-			ids, 
-			distance);
+		if (m_use_compact_hash)
+		{
+			K_ComputeNeighborFixed << <pDims, BLOCK_SIZE >> > (
+				nbrList,
+				pos,
+				this->inPosition()->getValue(),
+				m_compact_hash,
+				h,
+				ids,
+				distance,
+				NeighborStats::getInstance().deviceCounters());
+		}
+		else
+		{
+			K_ComputeNeighborFixed << <pDims, BLOCK_SIZE >> > (
+				nbrList,
+				pos,
+				this->inPosition()->getValue(),
+				m_hash,
+				h,
+				ids,
+				distance,
+				NeighborStats::getInstance().deviceCounters());
+		}
 		cuSynchronize();
 
-		cuSafeCall(cudaFree(ids));
-		cuSafeCall(cudaFree(distance));
+		if (SceneGraph::getInstance().isDeterministic())
+		{
+			K_SortNeighborElements << <pDims, BLOCK_SIZE >> > (nbrList);
+			cuSynchronize();
+		}
+
+		K_NeighborHistogram << <pDims, BLOCK_SIZE >> > (nbrList, NeighborStats::getInstance().deviceCounters());
+		cuSynchronize();
 	}
+
+#ifdef PRECISION_FLOAT
+	template class NeighborQuery<DataType3f>;
+#else
+	template class NeighborQuery<DataType3d>;
+#endif
 }
\ No newline at end of file
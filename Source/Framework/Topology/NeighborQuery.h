@@ -4,6 +4,8 @@
 #include "Framework/Framework/FieldArray.h"
 #include "Framework/Topology/FieldNeighbor.h"
 #include "Framework/Topology/GridHash.h"
+#include "Framework/Topology/CompactGridHash.h"
+#include "Framework/Topology/TriangleBVH.h"
 #include "Core/Utility.h"
 #include "Framework/Framework/ModuleTopology.h"
 namespace PhysIKA {
@@ -33,6 +35,55 @@ namespace PhysIKA {
 
 		void setNeighborSizeLimit(int num) { m_maxNum = num; }
 
+		/**
+		 * @brief Enable/disable incremental (Verlet-list) updates.
+		 * In incremental mode the neighbor list is built with an inflated radius h*(1+slack)
+		 * and cached; subsequent calls to compute() only rebuild it once the maximum particle
+		 * displacement since the last rebuild exceeds half the slack margin. Lists may then
+		 * contain neighbors slightly beyond h, which SPH kernels already tolerate since the
+		 * smoothing kernel vanishes outside h.
+		 */
+		void enableIncrementalUpdate(bool bEnabled) { m_incremental = bEnabled; }
+		void setSlackRatio(Real ratio) { m_slack_ratio = ratio; }
+
+		/**
+		 * @brief Switch the spatial index to CompactGridHash, which stores occupied cells
+		 * only. Recommended for large sparse domains where a dense nx*ny*nz grid over the
+		 * scene bounding box would waste memory and make clear() a full-grid memset.
+		 */
+		void enableCompactHash(bool bEnabled) { m_use_compact_hash = bEnabled; }
+
+		/**
+		 * @brief Overlap neighbor-list construction with independent work launched on the
+		 * default stream afterwards (e.g. the predictor step of an integrator). The
+		 * positions are first snapshotted into a staging buffer on the legacy stream -
+		 * ordered after every earlier write and before any later launch, so a predictor
+		 * rewriting the live positions races with neither the copy nor the build - and
+		 * hash construction plus the neighbor count pass then run on a private
+		 * non-blocking stream against the snapshot. sync() is the only point that waits
+		 * on that stream; it finishes the prefix sum and gather and must be called before
+		 * any consumer touches the neighborhood output. Configurations the staged path
+		 * does not cover (triangle meshes, per-particle radii, incremental mode,
+		 * capacity-limited lists) fall back to a synchronous compute().
+		 */
+		void computeAsync();
+		void sync();
+
+		/**
+		 * @brief Force re-binning of the triangle mesh into the grid on the next compute().
+		 * The cell-to-triangle lists are cached across frames; callers must tag the mesh
+		 * dirty whenever its vertices move (e.g. rigid motion of a boundary mesh).
+		 */
+		void tagTriangleMeshDirty() { m_tri_dirty = true; }
+
+		/**
+		 * @brief Use a triangle BVH instead of grid rasterization for mesh queries.
+		 * The tree is built once and refitted (boxes only) every compute(), so
+		 * deforming meshes need no tagTriangleMeshDirty(). Recommended for meshes
+		 * with long thin triangles, which flood the grid with candidate entries.
+		 */
+		void enableTriangleBVH(bool bEnabled) { m_use_tri_bvh = bEnabled; }
+
 //		NeighborList<int>& getNeighborList() { return m_neighborhood.getValue(); }
 
 	protected:
@@ -41,10 +92,13 @@ namespace PhysIKA {
 	private:
 		void queryNeighborSize(DeviceArray<int>& num, DeviceArray<Coord>& pos, Real h);
 		void queryNeighborDynamic(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, Real h);
+		void gatherNeighbors(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, DeviceArray<Coord>& ref, Real h);
 
 		void queryNeighborFixed(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, Real h);
 
 
+		void queryNeighborVariableDynamic(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, DeviceArray<Real>& radii);
+
 		void queryNeighborTriDynamic(NeighborList<int>& nbrList, DeviceArray<Coord>& pos, DeviceArray<Coord>& posT, DeviceArray<Triangle>& Tris, Real h);
 		void queryNeighborSizeTri(DeviceArray<int>& num, DeviceArray<Coord>& pos, DeviceArray<Triangle>& Tris, DeviceArray<Coord>& posT, Real h);
 
@@ -60,6 +114,13 @@ namespace PhysIKA {
 		 * @brief Particle position
 		 */
 		DEF_EMPTY_IN_ARRAY(Position, Coord, DeviceType::GPU, "Particle position");
+
+		/**
+		* @brief Per-particle search radius, optional. When connected, neighbor search runs on a
+		* two-level (fine/coarse) grid so mixed-resolution particle sets no longer force the
+		* whole hash down to the smallest radius. Each particle gathers within its own radius.
+		*/
+		DEF_EMPTY_IN_ARRAY(RadiusArray, Real, DeviceType::GPU, "Per-particle search radius");
 		
 		/**
 		* @brief Triangle position
@@ -84,19 +145,45 @@ namespace PhysIKA {
 		Coord m_highBound;
 
 		GridHash<TDataType> m_hash;
+		CompactGridHash<TDataType> m_compact_hash;
+		bool m_use_compact_hash = false;
+
+		//two-level grids for per-particle radii
+		GridHash<TDataType> m_hash_fine;
+		GridHash<TDataType> m_hash_coarse;
+		Real m_fine_spacing = Real(0);
+		Real m_coarse_spacing = Real(0);
 
 		int* m_ids;
 		Real* m_distance;
 
-		Reduction<int> m_reduce;
-		Scan m_scan;
-
 		bool triangle_first = true;
+		bool m_tri_dirty = false;
+		bool m_use_tri_bvh = false;
+		TriangleBVH<TDataType> m_tri_bvh;
+		int m_tri_num = -1;
+		Coord* m_tri_pos_ptr = nullptr;
+
+		bool m_incremental = false;
+		Real m_slack_ratio = Real(0.2);
+		Real m_hash_spacing = Real(0);
+
+		DeviceArray<Coord> m_refPosition;
+		DeviceArray<Real> m_displacement;
+		Reduction<Real>* m_reduce_real = nullptr;
+
+		cudaStream_t m_stream = nullptr;
+		bool m_async_pending = false;
+
+		//staged async query state; see computeAsync
+		DeviceArray<Coord> m_pos_staging;
+		cudaEvent_t m_copy_event = nullptr;
+		Real m_async_h = Real(0);
 	};
 
 #ifdef PRECISION_FLOAT
-	template class NeighborQuery<DataType3f>;
+	extern template class NeighborQuery<DataType3f>;
 #else
-	template class NeighborQuery<DataType3d>;
+	extern template class NeighborQuery<DataType3d>;
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "NeighborStats.h"
+
+#include <sstream>
+#include <cuda_runtime.h>
+
+#include "Core/Utility/cuda_utilities.h"
+
+namespace PhysIKA
+{
+	NeighborStats& NeighborStats::getInstance()
+	{
+		static NeighborStats instance;
+		return instance;
+	}
+
+	int* NeighborStats::deviceCounters()
+	{
+		if (m_device == nullptr)
+		{
+			cuSafeCall(cudaMalloc((void**)&m_device, SLOT_NUM * sizeof(int)));
+			cuSafeCall(cudaMemset(m_device, 0, SLOT_NUM * sizeof(int)));
+		}
+		return m_device;
+	}
+
+	void NeighborStats::beginFrame()
+	{
+		cuSafeCall(cudaMemsetAsync(deviceCounters(), 0, SLOT_NUM * sizeof(int)));
+	}
+
+	void NeighborStats::endFrame()
+	{
+		SyncAudit::getInstance().onImplicitSync("NeighborStats readback");
+		cuSafeCall(cudaMemcpy(m_host, deviceCounters(), SLOT_NUM * sizeof(int), cudaMemcpyDeviceToHost));
+	}
+
+	std::string NeighborStats::report()
+	{
+		std::stringstream ss;
+		ss << "Dropped neighbors: " << droppedNeighbors()
+			<< ", particles out of hash domain: " << outOfDomain() << std::endl;
+		ss << "Neighbor-count histogram (bin width " << HIST_BIN_WIDTH << "):";
+		for (int i = 0; i < HIST_BINS; i++)
+		{
+			ss << " " << histogramBin(i);
+		}
+		ss << std::endl;
+
+		return ss.str();
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+
+namespace PhysIKA {
+
+/*!
+*	\class	NeighborStats
+*	\brief	Always-on health counters for neighbor search.
+*
+*	Capacity-limited neighbor lists silently evict the farthest candidate
+*	once a particle exceeds its limit, and particles outside the hash
+*	domain silently vanish from neighbor search altogether - both degrade
+*	simulation quality without any visible error. The search kernels fold
+*	these events, plus a neighbor-count histogram, into one small device
+*	counter block; SceneGraph::takeOneFrame() zeroes it at the start of
+*	the frame and pulls it back once at the end, so the per-frame cost is
+*	a handful of atomics and one tiny copy. A frame with a nonzero
+*	dropped count or a histogram piling into the top bin is the early
+*	warning the counters exist for.
+*/
+class NeighborStats
+{
+public:
+	static const int HIST_BINS = 16;
+	static const int HIST_BIN_WIDTH = 8;
+
+	//layout of the device counter block
+	static const int SLOT_DROPPED = 0;
+	static const int SLOT_OUT_OF_DOMAIN = 1;
+	static const int SLOT_HISTOGRAM = 2;
+	static const int SLOT_NUM = SLOT_HISTOGRAM + HIST_BINS;
+
+	static NeighborStats& getInstance();
+
+	/**
+	 * @brief Device counter block the search kernels accumulate into;
+	 * lazily allocated.
+	 */
+	int* deviceCounters();
+
+	/**
+	 * @brief Zero the device counters; called at the start of every frame.
+	 */
+	void beginFrame();
+
+	/**
+	 * @brief Pull the counters to the host once; called at the end of
+	 * every frame. The accessors below return this snapshot.
+	 */
+	void endFrame();
+
+	/**
+	 * @brief Neighbors evicted from capacity-limited lists last frame.
+	 */
+	int droppedNeighbors() { return m_host[SLOT_DROPPED]; }
+
+	/**
+	 * @brief Particles outside the hash domain last frame.
+	 */
+	int outOfDomain() { return m_host[SLOT_OUT_OF_DOMAIN]; }
+
+	/**
+	 * @brief Neighbor-count histogram of last frame; bin i covers
+	 * [i*HIST_BIN_WIDTH, (i+1)*HIST_BIN_WIDTH), the last bin is open.
+	 */
+	int histogramBin(int i) { return m_host[SLOT_HISTOGRAM + i]; }
+
+	/**
+	 * @brief Human-readable snapshot of the counters above.
+	 */
+	std::string report();
+
+private:
+	NeighborStats() {};
+
+	int* m_device = nullptr;
+	int m_host[SLOT_NUM] = { 0 };
+};
+
+}
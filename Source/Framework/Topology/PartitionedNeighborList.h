@@ -0,0 +1,137 @@
+#pragma once
+#include "Core/Platform.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility.h"
+#include "Framework/Topology/NeighborList.h"
+
+namespace PhysIKA
+{
+	template<typename Real, typename Coord>
+	__global__ void K_PNL_Classify(
+		DeviceArray<int> interiorIds,
+		DeviceArray<int> boundaryIds,
+		DeviceArray<Coord> pos,
+		Real x0,
+		Real x1,
+		Real band,
+		int* counters)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= pos.size()) return;
+
+		Real x = pos[pId][0];
+		if (x < x0 + band || x > x1 - band)
+		{
+			boundaryIds[atomicAdd(&counters[1], 1)] = pId;
+		}
+		else
+		{
+			interiorIds[atomicAdd(&counters[0], 1)] = pId;
+		}
+	}
+
+	/*!
+	*	\class	PartitionedNeighborList
+	*	\brief	NeighborList plus an interior/boundary split of one subdomain.
+	*
+	*	Boundary particles are the ones within one halo band of a subdomain
+	*	face along the split axis - exactly the set whose neighborhoods reach
+	*	into a remote subdomain. partition() compacts the two id sets on the
+	*	device, so a solver can run its kernels over interiorIds() while a
+	*	HaloExchange is still in flight, wait on the exchange, and finish
+	*	with boundaryIds(). The neighbor list itself is filled by the usual
+	*	NeighborQuery machinery through neighbors().
+	*
+	*	Porting a gather-style module is mechanical: SummationDensity's
+	*	kernel already takes positions and a NeighborList<int>, it only needs
+	*	an id indirection (pId = ids[tId]) to run over either subset.
+	*/
+	template<typename TDataType>
+	class PartitionedNeighborList
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		PartitionedNeighborList() {};
+
+		~PartitionedNeighborList()
+		{
+			if (m_counters != nullptr)
+			{
+				cudaFree(m_counters);
+			}
+		}
+
+		/**
+		 * @brief Split the particles into interior and boundary sets; [x0, x1]
+		 * is the owned interval along the split axis and band the halo width,
+		 * usually one smoothing length.
+		 */
+		void partition(DeviceArray<Coord>& pos, Real x0, Real x1, Real band, cudaStream_t stream = 0)
+		{
+			int num = pos.size();
+			if (num <= 0)
+			{
+				m_interiorIds.shrink(0);
+				m_boundaryIds.shrink(0);
+				return;
+			}
+
+			if (m_counters == nullptr)
+			{
+				cuSafeCall(cudaMalloc((void**)&m_counters, 2 * sizeof(int)));
+			}
+			//shrink() trims the logical size after compaction, so track the
+			//real capacity separately to keep the rebuilds allocation-free
+			if (m_idCapacity < num)
+			{
+				m_idCapacity = 2 * m_idCapacity > num ? 2 * m_idCapacity : num;
+				m_interiorIds.resize(m_idCapacity);
+				m_boundaryIds.resize(m_idCapacity);
+			}
+
+			cuSafeCall(cudaMemsetAsync(m_counters, 0, 2 * sizeof(int), stream));
+
+			uint pDims = cudaGridSize(num, BLOCK_SIZE);
+			K_PNL_Classify << <pDims, BLOCK_SIZE, 0, stream >> > (
+				m_interiorIds, m_boundaryIds, pos, x0, x1, band, m_counters);
+
+			int counts[2];
+			cuSafeCall(cudaMemcpyAsync(counts, m_counters, 2 * sizeof(int), cudaMemcpyDeviceToHost, stream));
+			cuSafeCall(cudaStreamSynchronize(stream));
+
+			m_interiorIds.shrink(counts[0]);
+			m_boundaryIds.shrink(counts[1]);
+		}
+
+		/**
+		 * @brief Particles whose whole neighborhood is local.
+		 */
+		DeviceArray<int>& interiorIds() { return m_interiorIds; }
+
+		/**
+		 * @brief Particles within one band of a face; their neighbor sweeps
+		 * read halo data.
+		 */
+		DeviceArray<int>& boundaryIds() { return m_boundaryIds; }
+
+		NeighborList<int>& neighbors() { return m_neighbors; }
+
+		void release()
+		{
+			m_interiorIds.release();
+			m_boundaryIds.release();
+			m_neighbors.release();
+		}
+
+	private:
+		NeighborList<int> m_neighbors;
+
+		DeviceArray<int> m_interiorIds;
+		DeviceArray<int> m_boundaryIds;
+
+		int m_idCapacity = 0;
+		int* m_counters = nullptr;
+	};
+}
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <sstream>
 #include "Core/Utility.h"
+#include "Framework/Framework/SceneGraph.h"
+#include "Framework/Topology/GridHash.h"
 
 namespace PhysIKA
 {
@@ -105,9 +107,14 @@ namespace PhysIKA
 	template<typename TDataType>
 	void PointSet<TDataType>::setPoints(std::vector<Coord>& pos)
 	{
-		//printf("%d\n", pos.size());
 		m_coords.resize(pos.size());
-		Function1Pt::copy(m_coords, pos);
+
+		//Stage through pinned pages: large scene loads push hundreds of MB up,
+		//and pageable memcpys halve the achievable upload bandwidth.
+		PinnedHostArray<Coord> staging((int)pos.size());
+		memcpy(staging.getDataPtr(), &pos[0], pos.size() * sizeof(Coord));
+		Function1Pt::copy(m_coords, staging);
+		staging.release();
 
 		tagAsChanged();
 	}
@@ -197,10 +204,174 @@ namespace PhysIKA
 		cuExecute(m_coords.size(), PS_Translate, m_coords, t);
 
 // 		uint pDims = cudaGridSize(m_coords.size(), BLOCK_SIZE);
-// 
+//
 // 		PS_Translate << <pDims, BLOCK_SIZE >> > (
 // 			m_coords,
 // 			t);
 // 		cuSynchronize();
 	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void PS_QueryRadius(
+		NeighborList<int> result,
+		DeviceArray<Coord> points,
+		DeviceArray<Coord> queries,
+		GridHash<TDataType> hash,
+		Real radius,
+		int maxNum)
+	{
+		int qId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (qId >= queries.size()) return;
+
+		Coord pos_q = queries[qId];
+		int3 gId3 = hash.getIndex3(pos_q);
+
+		int num = 0;
+		for (int c = 0; c < 27; c++)
+		{
+			int cId = hash.getIndex(gId3.x + c / 9 - 1, gId3.y + (c % 9) / 3 - 1, gId3.z + c % 3 - 1);
+			if (cId < 0) continue;
+
+			int totalNum = hash.getCounter(cId);
+			for (int t = 0; t < totalNum; t++)
+			{
+				int j = hash.getParticleId(cId, t);
+				if ((pos_q - points[j]).norm() < radius && num < maxNum)
+				{
+					result.setElement(qId, num++, j);
+				}
+			}
+		}
+		result.setNeighborSize(qId, num);
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void PS_QueryKNearest(
+		NeighborList<int> result,
+		DeviceArray<Coord> points,
+		DeviceArray<Coord> queries,
+		GridHash<TDataType> hash,
+		int k)
+	{
+		int qId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (qId >= queries.size()) return;
+
+		Coord pos_q = queries[qId];
+		int3 gId3 = hash.getIndex3(pos_q);
+
+		const int CAP = 16;
+		int ids[CAP];
+		Real dists[CAP];
+		int num = 0;
+
+		//widen the search window once when the first ring comes up short
+		for (int ext = 1; ext <= 2; ext++)
+		{
+			num = 0;
+			int side = 2 * ext + 1;
+			for (int c = 0; c < side*side*side; c++)
+			{
+				int cId = hash.getIndex(
+					gId3.x + c / (side*side) - ext,
+					gId3.y + (c % (side*side)) / side - ext,
+					gId3.z + c % side - ext);
+				if (cId < 0) continue;
+
+				int totalNum = hash.getCounter(cId);
+				for (int t = 0; t < totalNum; t++)
+				{
+					int j = hash.getParticleId(cId, t);
+					Real d = (pos_q - points[j]).norm();
+
+					if (num < k)
+					{
+						//insertion keeps the list ordered by distance
+						int ins = num++;
+						while (ins > 0 && dists[ins - 1] > d)
+						{
+							dists[ins] = dists[ins - 1];
+							ids[ins] = ids[ins - 1];
+							ins--;
+						}
+						dists[ins] = d;
+						ids[ins] = j;
+					}
+					else if (d < dists[k - 1])
+					{
+						int ins = k - 1;
+						while (ins > 0 && dists[ins - 1] > d)
+						{
+							dists[ins] = dists[ins - 1];
+							ids[ins] = ids[ins - 1];
+							ins--;
+						}
+						dists[ins] = d;
+						ids[ins] = j;
+					}
+				}
+			}
+
+			if (num >= k) break;
+		}
+
+		for (int n = 0; n < num; n++)
+		{
+			result.setElement(qId, n, ids[n]);
+		}
+		result.setNeighborSize(qId, num);
+	}
+
+	template<typename TDataType>
+	void PointSet<TDataType>::queryPointsInRadius(NeighborList<int>& result, DeviceArray<Coord>& queryPoints, Real radius, int maxNum)
+	{
+		if (m_coords.isEmpty() || queryPoints.isEmpty()) return;
+
+		if (m_queryHash == nullptr)
+		{
+			m_queryHash = std::make_shared<GridHash<TDataType>>();
+		}
+
+		Vector3f sceneLow = SceneGraph::getInstance().getLowerBound();
+		Vector3f sceneUp = SceneGraph::getInstance().getUpperBound();
+		m_queryHash->setSpace(radius, Coord(sceneLow[0], sceneLow[1], sceneLow[2]), Coord(sceneUp[0], sceneUp[1], sceneUp[2]));
+		m_queryHash->construct(m_coords);
+
+		if (result.size() != queryPoints.size())
+		{
+			result.resize(queryPoints.size());
+		}
+		result.setNeighborLimit(maxNum);
+
+		uint pDims = cudaGridSize(queryPoints.size(), BLOCK_SIZE);
+		PS_QueryRadius << <pDims, BLOCK_SIZE >> > (result, m_coords, queryPoints, *m_queryHash, radius, maxNum);
+		cuSynchronize();
+	}
+
+	template<typename TDataType>
+	void PointSet<TDataType>::queryKNearest(NeighborList<int>& result, DeviceArray<Coord>& queryPoints, int k, Real radiusHint)
+	{
+		if (m_coords.isEmpty() || queryPoints.isEmpty()) return;
+
+		k = k > 16 ? 16 : k;
+
+		if (m_queryHash == nullptr)
+		{
+			m_queryHash = std::make_shared<GridHash<TDataType>>();
+		}
+
+		Vector3f sceneLow = SceneGraph::getInstance().getLowerBound();
+		Vector3f sceneUp = SceneGraph::getInstance().getUpperBound();
+		m_queryHash->setSpace(radiusHint, Coord(sceneLow[0], sceneLow[1], sceneLow[2]), Coord(sceneUp[0], sceneUp[1], sceneUp[2]));
+		m_queryHash->construct(m_coords);
+
+		if (result.size() != queryPoints.size())
+		{
+			result.resize(queryPoints.size());
+		}
+		result.setNeighborLimit(k);
+
+		uint pDims = cudaGridSize(queryPoints.size(), BLOCK_SIZE);
+		PS_QueryKNearest<Real, Coord, TDataType> << <pDims, BLOCK_SIZE >> > (result, m_coords, queryPoints, *m_queryHash, k);
+		cuSynchronize();
+	}
 }
\ No newline at end of file
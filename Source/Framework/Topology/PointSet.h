@@ -6,6 +6,8 @@
 
 namespace PhysIKA
 {
+	template <typename> class GridHash;
+
 	template<typename TDataType>
 	class PointSet : public TopologyModule
 	{
@@ -37,12 +39,36 @@ namespace PhysIKA
 
 		void loadObjFile(std::string filename);
 
+		/**
+		 * @brief Batched queries against the stored points for external tools.
+		 *
+		 * Both calls take a device array of query points, rebuild the internal
+		 * spatial hash over the current points and return packed per-query
+		 * results, so callers outside the module system no longer have to
+		 * round-trip through a host-side brute force search.
+		 */
+
+		/**
+		 * @brief For every query point, collect the ids of all points within
+		 * radius, capped at maxNum per query.
+		 */
+		void queryPointsInRadius(NeighborList<int>& result, DeviceArray<Coord>& queryPoints, Real radius, int maxNum = 25);
+
+		/**
+		 * @brief For every query point, collect the k nearest points (k <= 16),
+		 * ordered by distance. radiusHint sets the hash cell size and should be
+		 * on the order of the expected distance to the k-th neighbor.
+		 */
+		void queryKNearest(NeighborList<int>& result, DeviceArray<Coord>& queryPoints, int k, Real radiusHint);
+
 	protected:
 		bool initializeImpl() override;
 
 		DeviceArray<Coord> m_coords;
 		DeviceArray<Coord> m_normals;
 		NeighborList<int> m_pointNeighbors;
+
+		std::shared_ptr<GridHash<TDataType>> m_queryHash;
 	};
 
 
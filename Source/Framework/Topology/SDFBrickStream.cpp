@@ -0,0 +1,357 @@
+#include "SDFBrickStream.h"
+
+#include "Core/Utility/cuda_utilities.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace PhysIKA
+{
+	namespace
+	{
+		const char SDF_BRICK_MAGIC[8] = { 'P', 'K', 'S', 'D', 'F', 'B', '\0', '\0' };
+
+		//bricks staged per pinned-buffer batch
+		const std::uint32_t STAGE_BRICKS = 256;
+	}
+
+	SDFBrickStream::SDFBrickStream()
+	{
+		std::memset(&m_header, 0, sizeof(m_header));
+		m_lo[0] = m_lo[1] = m_lo[2] = 0;
+		m_hi[0] = m_hi[1] = m_hi[2] = -1;
+	}
+
+	SDFBrickStream::~SDFBrickStream()
+	{
+		close();
+	}
+
+	bool SDFBrickStream::open(const std::string& filename)
+	{
+		close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(SDFBrickFileHeader))
+		{
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (base == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_file = file;
+		m_mapping = mapping;
+		m_fileBytes = (std::uint64_t)size.QuadPart;
+#else
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || (std::uint64_t)st.st_size < sizeof(SDFBrickFileHeader))
+		{
+			::close(fd);
+			return false;
+		}
+		void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (base == MAP_FAILED)
+		{
+			::close(fd);
+			return false;
+		}
+		m_fd = fd;
+		m_fileBytes = (std::uint64_t)st.st_size;
+#endif
+		m_base = base;
+
+		std::memcpy(&m_header, m_base, sizeof(m_header));
+		std::uint64_t cellNum = (std::uint64_t)m_header.bnx * m_header.bny * m_header.bnz;
+		std::uint64_t brickBytes = 729 * (std::uint64_t)m_header.realBytes;
+		if (std::memcmp(m_header.magic, SDF_BRICK_MAGIC, sizeof(SDF_BRICK_MAGIC)) != 0
+			|| m_header.version != 1
+			|| m_header.coarseOffset + cellNum * m_header.realBytes > m_fileBytes
+			|| m_header.indexOffset + cellNum * sizeof(std::int32_t) > m_fileBytes
+			|| m_header.brickOffset + m_header.brickNum * brickBytes > m_fileBytes)
+		{
+			unmapFile();
+			return false;
+		}
+
+		return true;
+	}
+
+	void SDFBrickStream::close()
+	{
+		if (m_worker.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_shutdown = true;
+			}
+			m_moreWork.notify_all();
+			m_worker.join();
+			m_shutdown = false;
+		}
+
+		if (m_staging != nullptr)
+		{
+			cudaFreeHost(m_staging);
+			m_staging = nullptr;
+		}
+		if (m_copyStream != 0)
+		{
+			cudaStreamDestroy(m_copyStream);
+			m_copyStream = 0;
+		}
+		m_devIndex = nullptr;
+		m_devPool = nullptr;
+		m_slotOfCell.clear();
+		m_resident.clear();
+		m_freeSlots.clear();
+
+		unmapFile();
+	}
+
+	void SDFBrickStream::unmapFile()
+	{
+		if (m_base == nullptr)
+		{
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(m_base);
+		CloseHandle((HANDLE)m_mapping);
+		CloseHandle((HANDLE)m_file);
+		m_mapping = nullptr;
+		m_file = nullptr;
+#else
+		munmap(m_base, (size_t)m_fileBytes);
+		::close(m_fd);
+		m_fd = -1;
+#endif
+		m_base = nullptr;
+		m_fileBytes = 0;
+	}
+
+	const void* SDFBrickStream::getCoarseData() const
+	{
+		if (m_base == nullptr)
+		{
+			return nullptr;
+		}
+		return (const char*)m_base + m_header.coarseOffset;
+	}
+
+	void SDFBrickStream::bindDevice(int* brickIndex, void* brickPool, std::uint32_t poolCapacity, std::uint32_t brickBytes, bool negate)
+	{
+		m_devIndex = brickIndex;
+		m_devPool = (char*)brickPool;
+		m_poolCapacity = poolCapacity;
+		m_brickBytes = brickBytes;
+		m_negate = negate;
+
+		std::uint64_t cellNum = (std::uint64_t)m_header.bnx * m_header.bny * m_header.bnz;
+		m_slotOfCell.assign((size_t)cellNum, -1);
+		m_resident.clear();
+		m_freeSlots.clear();
+		for (std::uint32_t s = poolCapacity; s > 0; s--)
+		{
+			m_freeSlots.push_back(s - 1);
+		}
+
+		cuSafeCall(cudaMallocHost(&m_staging, (std::uint64_t)STAGE_BRICKS * brickBytes));
+		cuSafeCall(cudaStreamCreate(&m_copyStream));
+
+		m_worker = std::thread(&SDFBrickStream::workerLoop, this);
+	}
+
+	void SDFBrickStream::setActiveRegion(const int lo[3], const int hi[3])
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (lo[0] == m_lo[0] && lo[1] == m_lo[1] && lo[2] == m_lo[2]
+			&& hi[0] == m_hi[0] && hi[1] == m_hi[1] && hi[2] == m_hi[2])
+		{
+			return;
+		}
+		for (int d = 0; d < 3; d++)
+		{
+			m_lo[d] = lo[d];
+			m_hi[d] = hi[d];
+		}
+		m_dirty = true;
+		m_moreWork.notify_one();
+	}
+
+	void SDFBrickStream::flush()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idle.wait(lock, [this] { return !m_dirty && !m_busy; });
+	}
+
+	void SDFBrickStream::workerLoop()
+	{
+		const std::int32_t* fileId = (const std::int32_t*)((const char*)m_base + m_header.indexOffset);
+		const char* payloads = (const char*)m_base + m_header.brickOffset;
+		const int bnx = (int)m_header.bnx;
+		const int bny = (int)m_header.bny;
+		const int bnz = (int)m_header.bnz;
+
+		int lo[3], hi[3];
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_moreWork.wait(lock, [this] { return m_dirty || m_shutdown; });
+				if (m_shutdown)
+				{
+					return;
+				}
+				for (int d = 0; d < 3; d++)
+				{
+					lo[d] = m_lo[d];
+					hi[d] = m_hi[d];
+				}
+				m_dirty = false;
+				m_busy = true;
+			}
+
+			//evict bricks that left the region: unpublish their cells first,
+			//then make sure no launched kernel can still be reading the slots
+			//before they are handed out again
+			const int minusOne = -1;
+			size_t kept = 0;
+			bool evicted = false;
+			for (size_t r = 0; r < m_resident.size(); r++)
+			{
+				int cell = m_resident[r];
+				int bi = cell % bnx;
+				int bj = (cell / bnx) % bny;
+				int bk = cell / (bnx * bny);
+				if (bi >= lo[0] && bi <= hi[0] && bj >= lo[1] && bj <= hi[1] && bk >= lo[2] && bk <= hi[2])
+				{
+					m_resident[kept++] = cell;
+					continue;
+				}
+				cuSafeCall(cudaMemcpy(m_devIndex + cell, &minusOne, sizeof(int), cudaMemcpyHostToDevice));
+				m_freeSlots.push_back((std::uint32_t)m_slotOfCell[cell]);
+				m_slotOfCell[cell] = -1;
+				evicted = true;
+			}
+			m_resident.resize(kept);
+			if (evicted)
+			{
+				cuSynchronize();
+			}
+
+			//stream missing in-region bricks in pinned batches; the cell is
+			//published only after its payload copy completed on the stream,
+			//so a query never sees a half-landed brick
+			int batchCell[STAGE_BRICKS];
+			int batchSlot[STAGE_BRICKS];
+			std::uint32_t batchNum = 0;
+
+			for (int bk = lo[2]; bk <= hi[2]; bk++)
+			{
+				for (int bj = lo[1]; bj <= hi[1]; bj++)
+				{
+					for (int bi = lo[0]; bi <= hi[0]; bi++)
+					{
+						int cell = bi + bnx * (bj + bny * bk);
+						std::int32_t id = fileId[cell];
+						if (id < 0 || m_slotOfCell[cell] >= 0)
+						{
+							continue;
+						}
+						if (m_freeSlots.empty())
+						{
+							//pool budget reached; the rest of the region
+							//keeps its coarse fallback
+							break;
+						}
+
+						std::uint32_t slot = m_freeSlots.back();
+						m_freeSlots.pop_back();
+
+						char* dst = m_staging + (std::uint64_t)batchNum * m_brickBytes;
+						std::memcpy(dst, payloads + (std::uint64_t)id * m_brickBytes, m_brickBytes);
+						if (m_negate)
+						{
+							if (m_header.realBytes == sizeof(float))
+							{
+								float* v = (float*)dst;
+								for (int s = 0; s < 729; s++) v[s] = -v[s];
+							}
+							else
+							{
+								double* v = (double*)dst;
+								for (int s = 0; s < 729; s++) v[s] = -v[s];
+							}
+						}
+						cuSafeCall(cudaMemcpyAsync(m_devPool + (std::uint64_t)slot * m_brickBytes, dst, m_brickBytes, cudaMemcpyHostToDevice, m_copyStream));
+
+						batchCell[batchNum] = cell;
+						batchSlot[batchNum] = (int)slot;
+						batchNum++;
+
+						if (batchNum == STAGE_BRICKS)
+						{
+							cuSafeCall(cudaStreamSynchronize(m_copyStream));
+							for (std::uint32_t b = 0; b < batchNum; b++)
+							{
+								cuSafeCall(cudaMemcpy(m_devIndex + batchCell[b], &batchSlot[b], sizeof(int), cudaMemcpyHostToDevice));
+								m_slotOfCell[batchCell[b]] = batchSlot[b];
+								m_resident.push_back(batchCell[b]);
+							}
+							batchNum = 0;
+						}
+					}
+				}
+			}
+
+			if (batchNum > 0)
+			{
+				cuSafeCall(cudaStreamSynchronize(m_copyStream));
+				for (std::uint32_t b = 0; b < batchNum; b++)
+				{
+					cuSafeCall(cudaMemcpy(m_devIndex + batchCell[b], &batchSlot[b], sizeof(int), cudaMemcpyHostToDevice));
+					m_slotOfCell[batchCell[b]] = batchSlot[b];
+					m_resident.push_back(batchCell[b]);
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_busy = false;
+			}
+			m_idle.notify_all();
+		}
+	}
+}
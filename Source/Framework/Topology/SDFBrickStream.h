@@ -0,0 +1,131 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <cuda_runtime.h>
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	SDFBrickStream
+	*	\brief	Lazy loader for chunked signed distance field files.
+	*
+	*	A brick file stores the two-level layout built by
+	*	DistanceField3D::compress: per brick cell one coarse distance and a
+	*	directory entry, plus the 9x9x9 sample payloads of near-surface
+	*	bricks. Only the header, the coarse values and the directory are
+	*	touched at load time; payloads are streamed into the device brick
+	*	pool by a worker thread as the caller moves the active region, and
+	*	bricks that leave the region are evicted. Startup cost and device
+	*	memory therefore track the region a simulation actually visits
+	*	instead of the whole volume. Cells whose payload has not landed yet
+	*	fall back to their coarse distance, exactly like far-away cells.
+	*/
+
+	struct SDFBrickFileHeader
+	{
+		char magic[8];                  //"PKSDFB\0\0"
+		std::uint32_t version;
+		std::uint32_t realBytes;
+		std::uint32_t bnx, bny, bnz;    //brick cells per axis
+		std::uint32_t brickNum;         //payloads stored in the file
+		std::int32_t nx, ny, nz;        //samples per axis
+		std::uint32_t padding;
+		double left[3];                 //lower corner and grid spacing
+		double h;
+		std::uint64_t coarseOffset;     //bnx*bny*bnz coarse distances
+		std::uint64_t indexOffset;      //bnx*bny*bnz int32 payload ids, -1 for far cells
+		std::uint64_t brickOffset;      //brickNum payloads of 729 samples each
+	};
+
+	class SDFBrickStream
+	{
+	public:
+		SDFBrickStream();
+		~SDFBrickStream();
+
+		/**
+		 * @brief Map the brick file and read its header; payloads stay on
+		 * disk until the active region reaches them.
+		 */
+		bool open(const std::string& filename);
+
+		void close();
+
+		const SDFBrickFileHeader& getHeader() const { return m_header; }
+
+		/**
+		 * @brief Coarse distances, one per brick cell, read directly from
+		 * the mapping. Valid until close().
+		 */
+		const void* getCoarseData() const;
+
+		/**
+		 * @brief Attach the device-side destination and start the worker.
+		 *
+		 * brickIndex holds one int per brick cell (pre-filled with -1 by
+		 * the caller) and is updated to pool slots as payloads land;
+		 * brickPool holds poolCapacity payloads of brickBytes each. When
+		 * negate is set every streamed sample is sign-flipped, which is
+		 * how an inverted field is realized without touching the file.
+		 */
+		void bindDevice(int* brickIndex, void* brickPool, std::uint32_t poolCapacity, std::uint32_t brickBytes, bool negate);
+
+		/**
+		 * @brief Move the active region (inclusive brick-cell bounds) and
+		 * wake the worker. Unchanged regions return immediately.
+		 */
+		void setActiveRegion(const int lo[3], const int hi[3]);
+
+		/**
+		 * @brief Block until the current region is fully resident.
+		 */
+		void flush();
+
+	private:
+		void workerLoop();
+		void unmapFile();
+
+		SDFBrickFileHeader m_header;
+
+		//file mapping
+		void* m_base = nullptr;
+		std::uint64_t m_fileBytes = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#else
+		int m_fd = -1;
+#endif
+
+		//device destination
+		int* m_devIndex = nullptr;
+		char* m_devPool = nullptr;
+		std::uint32_t m_poolCapacity = 0;
+		std::uint32_t m_brickBytes = 0;
+		bool m_negate = false;
+
+		//residency bookkeeping, worker thread only
+		std::vector<int> m_slotOfCell;  //-1 when not resident
+		std::vector<int> m_resident;    //cells currently holding a slot
+		std::vector<std::uint32_t> m_freeSlots;
+
+		char* m_staging = nullptr;      //pinned batch buffer
+		cudaStream_t m_copyStream = 0;
+
+		std::thread m_worker;
+		std::mutex m_mutex;
+		std::condition_variable m_moreWork;
+		std::condition_variable m_idle;
+		int m_lo[3];
+		int m_hi[3];
+		bool m_dirty = false;
+		bool m_busy = false;
+		bool m_shutdown = false;
+	};
+}
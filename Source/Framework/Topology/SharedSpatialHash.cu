@@ -0,0 +1,222 @@
+#pragma once
+#include "SharedSpatialHash.h"
+#include "Core/Utility.h"
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/execution_policy.h>
+
+namespace PhysIKA {
+
+	__constant__ int offset2[27][3] = { 0, 0, 0,
+		0, 0, 1,
+		0, 1, 0,
+		1, 0, 0,
+		0, 0, -1,
+		0, -1, 0,
+		-1, 0, 0,
+		0, 1, 1,
+		0, 1, -1,
+		0, -1, 1,
+		0, -1, -1,
+		1, 0, 1,
+		1, 0, -1,
+		-1, 0, 1,
+		-1, 0, -1,
+		1, 1, 0,
+		1, -1, 0,
+		-1, 1, 0,
+		-1, -1, 0,
+		1, 1, 1,
+		1, 1, -1,
+		1, -1, 1,
+		-1, 1, 1,
+		1, -1, -1,
+		-1, 1, -1,
+		-1, -1, 1,
+		-1, -1, -1
+	};
+
+	template<typename TDataType>
+	SharedSpatialHash<TDataType>& SharedSpatialHash<TDataType>::getInstance()
+	{
+		static SharedSpatialHash instance;
+		return instance;
+	}
+
+	template<typename TDataType>
+	int SharedSpatialHash<TDataType>::addSource(DeviceArray<Coord>* pos)
+	{
+		m_sources.push_back(pos);
+		return (int)m_sources.size() - 1;
+	}
+
+	template<typename TDataType>
+	void SharedSpatialHash<TDataType>::clearSources()
+	{
+		m_sources.clear();
+		m_offsets.clear();
+	}
+
+	template<typename Coord>
+	__global__ void K_SSH_Gather(
+		DeviceArray<Coord> fusedPos,
+		DeviceArray<int> tags,
+		DeviceArray<Coord> pos,
+		int offset,
+		int tag)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= pos.size()) return;
+
+		fusedPos[offset + pId] = pos[pId];
+		tags[offset + pId] = tag;
+	}
+
+	template<typename TDataType>
+	void SharedSpatialHash<TDataType>::construct(Real h, Coord lo, Coord hi)
+	{
+		int total = 0;
+		m_offsets.resize(m_sources.size());
+		for (size_t i = 0; i < m_sources.size(); i++)
+		{
+			m_offsets[i] = total;
+			total += m_sources[i]->size();
+		}
+
+		if (total == 0) return;
+
+		if (m_fusedPos.size() != total)
+		{
+			m_fusedPos.resize(total);
+			m_tags.resize(total);
+		}
+
+		for (size_t i = 0; i < m_sources.size(); i++)
+		{
+			uint pDims = cudaGridSize(m_sources[i]->size(), BLOCK_SIZE);
+			K_SSH_Gather << <pDims, BLOCK_SIZE >> > (m_fusedPos, m_tags, *m_sources[i], m_offsets[i], (int)i);
+		}
+		cuSynchronize();
+
+		if (m_spacing != h)
+		{
+			m_hash.setSpace(h, lo, hi);
+			m_spacing = h;
+		}
+
+		m_hash.construct(m_fusedPos);
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void K_SSH_CalPairSize(
+		DeviceArray<int> count,
+		DeviceArray<Coord> posA,
+		DeviceArray<Coord> fusedPos,
+		DeviceArray<int> tags,
+		GridHash<TDataType> hash,
+		int srcB,
+		Real h)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posA.size()) return;
+
+		Coord pos_ijk = posA[pId];
+		int3 gId3 = hash.getIndex3(pos_ijk);
+
+		int counter = 0;
+		for (int c = 0; c < 27; c++)
+		{
+			int cId = hash.getIndex(gId3.x + offset2[c][0], gId3.y + offset2[c][1], gId3.z + offset2[c][2]);
+			if (cId >= 0) {
+				int totalNum = hash.getCounter(cId);
+				for (int i = 0; i < totalNum; i++) {
+					int nbId = hash.getParticleId(cId, i);
+					if (tags[nbId] != srcB) continue;
+
+					Real d_ij = (pos_ijk - fusedPos[nbId]).norm();
+					if (d_ij < h)
+					{
+						counter++;
+					}
+				}
+			}
+		}
+
+		count[pId] = counter;
+	}
+
+	template<typename Real, typename Coord, typename TDataType>
+	__global__ void K_SSH_GetPairElements(
+		NeighborList<int> nbr,
+		DeviceArray<Coord> posA,
+		DeviceArray<Coord> fusedPos,
+		DeviceArray<int> tags,
+		GridHash<TDataType> hash,
+		int srcB,
+		int offsetB,
+		Real h)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= posA.size()) return;
+
+		Coord pos_ijk = posA[pId];
+		int3 gId3 = hash.getIndex3(pos_ijk);
+
+		int j = 0;
+		for (int c = 0; c < 27; c++)
+		{
+			int cId = hash.getIndex(gId3.x + offset2[c][0], gId3.y + offset2[c][1], gId3.z + offset2[c][2]);
+			if (cId >= 0) {
+				int totalNum = hash.getCounter(cId);
+				for (int i = 0; i < totalNum; i++) {
+					int nbId = hash.getParticleId(cId, i);
+					if (tags[nbId] != srcB) continue;
+
+					Real d_ij = (pos_ijk - fusedPos[nbId]).norm();
+					if (d_ij < h)
+					{
+						nbr.setElement(pId, j, nbId - offsetB);
+						j++;
+					}
+				}
+			}
+		}
+	}
+
+	template<typename TDataType>
+	void SharedSpatialHash<TDataType>::queryPairNeighbors(NeighborList<int>& nbr, int srcA, int srcB, Real h)
+	{
+		DeviceArray<Coord>& posA = *m_sources[srcA];
+		if (posA.size() <= 0) return;
+
+		DeviceArray<int>& nbrNum = nbr.getIndex();
+		if (nbrNum.size() != posA.size())
+			nbr.resize(posA.size());
+
+		uint pDims = cudaGridSize(posA.size(), BLOCK_SIZE);
+		K_SSH_CalPairSize << <pDims, BLOCK_SIZE >> > (nbrNum, posA, m_fusedPos, m_tags, m_hash, srcB, h);
+		cuSynchronize();
+
+		int sum = thrust::reduce(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), nbrNum.getDataPtr());
+
+		if (sum > 0)
+		{
+			nbr.resizeElements(sum);
+
+			K_SSH_GetPairElements << <pDims, BLOCK_SIZE >> > (nbr, posA, m_fusedPos, m_tags, m_hash, srcB, m_offsets[srcB], h);
+			cuSynchronize();
+		}
+	}
+
+	template<typename TDataType>
+	void SharedSpatialHash<TDataType>::release()
+	{
+		m_fusedPos.release();
+		m_tags.release();
+		m_hash.release();
+		m_spacing = Real(0);
+
+		clearSources();
+	}
+}
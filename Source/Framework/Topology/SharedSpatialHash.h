@@ -0,0 +1,71 @@
+#pragma once
+#include "Core/DataTypes.h"
+#include "Core/Utility.h"
+#include "Core/Array/Array.h"
+#include "Framework/Topology/GridHash.h"
+#include "Framework/Topology/NeighborList.h"
+
+namespace PhysIKA {
+
+	/*!
+	*	\class	SharedSpatialHash
+	*	\brief	One fused spatial index shared by several particle sources.
+	*
+	*	Scenes with several ParticleSystem nodes (SolidFluidInteraction, multi-fluid
+	*	setups) used to build one private grid hash per node over overlapping domains.
+	*	This service accepts multiple registered position arrays, concatenates them with
+	*	per-source tags, builds a single hash per step, and answers per-pair neighbor
+	*	queries against it, so N nodes cost one grid build instead of N.
+	*
+	*	Obtain the per-scene instance via getInstance(); sources re-register after
+	*	topology changes that replace their position buffers.
+	*/
+	template<typename TDataType>
+	class SharedSpatialHash
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+
+		static SharedSpatialHash& getInstance();
+
+		/**
+		 * @brief Register a position array and return its source id.
+		 */
+		int addSource(DeviceArray<Coord>* pos);
+
+		void clearSources();
+
+		/**
+		 * @brief Fuse all registered sources and build the shared hash.
+		 * Should be called once per step, before any pair query.
+		 */
+		void construct(Real h, Coord lo, Coord hi);
+
+		/**
+		 * @brief Gather, for every particle of source srcA, its neighbors belonging to
+		 * source srcB within radius h. Returned ids are local to srcB.
+		 */
+		void queryPairNeighbors(NeighborList<int>& nbr, int srcA, int srcB, Real h);
+
+		void release();
+
+	private:
+		SharedSpatialHash() {};
+
+		std::vector<DeviceArray<Coord>*> m_sources;
+		std::vector<int> m_offsets;
+
+		DeviceArray<Coord> m_fusedPos;
+		DeviceArray<int> m_tags;
+
+		GridHash<TDataType> m_hash;
+		Real m_spacing = Real(0);
+	};
+
+#ifdef PRECISION_FLOAT
+	template class SharedSpatialHash<DataType3f>;
+#else
+	template class SharedSpatialHash<DataType3d>;
+#endif
+}
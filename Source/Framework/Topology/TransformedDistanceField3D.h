@@ -0,0 +1,84 @@
+#pragma once
+#include <memory>
+#include "DistanceField3D.h"
+#include "Core/Matrix/transform_3d.h"
+
+namespace PhysIKA {
+
+	/**
+	 * @brief A rigidly moving view of a body-local distance field.
+	 *
+	 * A moving obstacle does not need its field re-baked per frame: signed
+	 * distances are invariant under a rigid transform, so it is enough to
+	 * take the query point into body space with the inverse transform,
+	 * sample the static field, and rotate the returned normal back to world
+	 * space. The wrapper shares the field's device storage (no copy, no
+	 * ownership) and mirrors the getDistance interface, so the collision
+	 * kernels accept either type. Scaling is deliberately unsupported: a
+	 * scaled field no longer returns true distances, which would break
+	 * sphere tracing.
+	 */
+	template<typename TDataType>
+	class TransformedDistanceField3D
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef typename TDataType::Matrix Matrix;
+
+		TransformedDistanceField3D()
+		{
+			m_translation = Coord(0);
+			m_rotation = Matrix::identityMatrix();
+			m_invRotation = Matrix::identityMatrix();
+		}
+
+		~TransformedDistanceField3D() {};
+
+		/**
+		 * @brief Share the body-local field; the wrapper never releases it.
+		 */
+		void setField(std::shared_ptr<DistanceField3D<TDataType>> field)
+		{
+			m_field = *field;
+		}
+
+		/**
+		 * @brief Body-to-world pose of the obstacle.
+		 */
+		void setPose(const Coord& translation, const Matrix& rotation)
+		{
+			m_translation = translation;
+			m_rotation = rotation;
+			m_invRotation = rotation.transpose();
+		}
+
+		void setPose(const Transform<Real, 3>& transform)
+		{
+			setPose(transform.translation(), transform.rotation3x3Matrix());
+		}
+
+		GPU_FUNC void getDistance(const Coord& p, Real& d, Coord& normal)
+		{
+			Coord q = m_invRotation * (p - m_translation);
+
+			Coord n;
+			m_field.getDistance(q, d, n);
+
+			normal = m_rotation * n;
+		}
+
+	private:
+		DistanceField3D<TDataType> m_field;
+
+		Coord m_translation;
+		Matrix m_rotation;
+		Matrix m_invRotation;
+	};
+
+#ifdef PRECISION_FLOAT
+	template class TransformedDistanceField3D<DataType3f>;
+#else
+	template class TransformedDistanceField3D<DataType3d>;
+#endif
+}
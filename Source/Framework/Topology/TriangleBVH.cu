@@ -0,0 +1,445 @@
+#include "TriangleBVH.h"
+
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/execution_policy.h>
+
+#include "Core/Utility.h"
+#include "Framework/Topology/NeighborList.h"
+
+namespace PhysIKA
+{
+	template<typename Coord>
+	struct TBVH_MinOp
+	{
+		__host__ __device__ Coord operator()(const Coord& a, const Coord& b) const
+		{
+			return Coord(a[0] < b[0] ? a[0] : b[0], a[1] < b[1] ? a[1] : b[1], a[2] < b[2] ? a[2] : b[2]);
+		}
+	};
+
+	template<typename Coord>
+	struct TBVH_MaxOp
+	{
+		__host__ __device__ Coord operator()(const Coord& a, const Coord& b) const
+		{
+			return Coord(a[0] > b[0] ? a[0] : b[0], a[1] > b[1] ? a[1] : b[1], a[2] > b[2] ? a[2] : b[2]);
+		}
+	};
+
+	__device__ inline unsigned int TBVH_ExpandBits(unsigned int v)
+	{
+		v = (v * 0x00010001u) & 0xFF0000FFu;
+		v = (v * 0x00000101u) & 0x0F00F00Fu;
+		v = (v * 0x00000011u) & 0xC30C30C3u;
+		v = (v * 0x00000005u) & 0x49249249u;
+		return v;
+	}
+
+	/// Common prefix length of two sort keys; keys are unique since the leaf id is appended.
+	__device__ inline int TBVH_Delta(unsigned long long* codes, int n, int i, int j)
+	{
+		if (j < 0 || j >= n) return -1;
+		return __clzll(codes[i] ^ codes[j]);
+	}
+
+	template<typename Coord, typename Triangle>
+	__global__ void TBVH_ComputeTriBoxes(
+		DeviceArray<Coord> triLo,
+		DeviceArray<Coord> triHi,
+		DeviceArray<Coord> vertices,
+		DeviceArray<Triangle> triangles)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= triangles.size()) return;
+
+		Coord v0 = vertices[triangles[i][0]];
+		Coord v1 = vertices[triangles[i][1]];
+		Coord v2 = vertices[triangles[i][2]];
+
+		Coord lo = v0;
+		Coord hi = v0;
+		for (int d = 0; d < 3; ++d)
+		{
+			lo[d] = min(lo[d], min(v1[d], v2[d]));
+			hi[d] = max(hi[d], max(v1[d], v2[d]));
+		}
+
+		triLo[i] = lo;
+		triHi[i] = hi;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void TBVH_ComputeCodes(
+		DeviceArray<unsigned long long> codes,
+		DeviceArray<int> sortedId,
+		DeviceArray<Coord> triLo,
+		DeviceArray<Coord> triHi,
+		Coord origin,
+		Coord scale)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= codes.size()) return;
+
+		Coord c = (triLo[i] + triHi[i]) * Real(0.5);
+
+		unsigned int x = (unsigned int)min(max((int)((c[0] - origin[0]) * scale[0]), 0), 1023);
+		unsigned int y = (unsigned int)min(max((int)((c[1] - origin[1]) * scale[1]), 0), 1023);
+		unsigned int z = (unsigned int)min(max((int)((c[2] - origin[2]) * scale[2]), 0), 1023);
+
+		unsigned int morton = (TBVH_ExpandBits(x) << 2) + (TBVH_ExpandBits(y) << 1) + TBVH_ExpandBits(z);
+
+		codes[i] = ((unsigned long long)morton << 32) | (unsigned long long)i;
+		sortedId[i] = i;
+	}
+
+	__global__ void TBVH_BuildTree(
+		DeviceArray<int> childL,
+		DeviceArray<int> childR,
+		DeviceArray<int> parent,
+		DeviceArray<unsigned long long> codes)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		int n = codes.size();
+		if (i >= n - 1) return;
+
+		unsigned long long* code_ptr = codes.getDataPtr();
+
+		//determine the range direction
+		int d = TBVH_Delta(code_ptr, n, i, i + 1) - TBVH_Delta(code_ptr, n, i, i - 1) > 0 ? 1 : -1;
+		int dmin = TBVH_Delta(code_ptr, n, i, i - d);
+
+		//find the range end by doubling then binary search
+		int lmax = 2;
+		while (TBVH_Delta(code_ptr, n, i, i + lmax * d) > dmin)
+		{
+			lmax *= 2;
+		}
+		int l = 0;
+		for (int t = lmax / 2; t > 0; t /= 2)
+		{
+			if (TBVH_Delta(code_ptr, n, i, i + (l + t) * d) > dmin)
+			{
+				l += t;
+			}
+		}
+		int j = i + l * d;
+
+		//find the split position
+		int dnode = TBVH_Delta(code_ptr, n, i, j);
+		int s = 0;
+		for (int t = (l + 1) >> 1; t > 0; t = (t == 1) ? 0 : ((t + 1) >> 1))
+		{
+			if (TBVH_Delta(code_ptr, n, i, i + (s + t) * d) > dnode)
+			{
+				s += t;
+			}
+		}
+		int gamma = i + s * d + min(d, 0);
+
+		int first = min(i, j);
+		int last = max(i, j);
+
+		//leaf k is stored at node n-1+k
+		int left = (first == gamma) ? (n - 1 + gamma) : gamma;
+		int right = (last == gamma + 1) ? (n - 1 + gamma + 1) : (gamma + 1);
+
+		childL[i] = left;
+		childR[i] = right;
+		parent[left] = i;
+		parent[right] = i;
+
+		if (i == 0)
+		{
+			parent[0] = -1;
+		}
+	}
+
+	template<typename Coord>
+	__global__ void TBVH_InitLeafBoxes(
+		DeviceArray<Coord> nodeLo,
+		DeviceArray<Coord> nodeHi,
+		DeviceArray<Coord> triLo,
+		DeviceArray<Coord> triHi,
+		DeviceArray<int> sortedId)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		int n = sortedId.size();
+		if (i >= n) return;
+
+		int tri = sortedId[i];
+		nodeLo[n - 1 + i] = triLo[tri];
+		nodeHi[n - 1 + i] = triHi[tri];
+	}
+
+	/// Bottom-up refit; the second thread arriving at a node merges both children.
+	template<typename Coord>
+	__global__ void TBVH_FitBoxes(
+		DeviceArray<Coord> nodeLo,
+		DeviceArray<Coord> nodeHi,
+		DeviceArray<int> childL,
+		DeviceArray<int> childR,
+		DeviceArray<int> parent,
+		DeviceArray<int> visited,
+		int n)
+	{
+		int i = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (i >= n) return;
+
+		int node = parent[n - 1 + i];
+		while (node >= 0)
+		{
+			if (atomicAdd(&visited[node], 1) == 0)
+			{
+				//first arrival: the sibling subtree is not fitted yet
+				return;
+			}
+			__threadfence();
+
+			int l = childL[node];
+			int r = childR[node];
+
+			Coord lo = nodeLo[l];
+			Coord hi = nodeHi[l];
+			for (int d = 0; d < 3; ++d)
+			{
+				lo[d] = min(lo[d], nodeLo[r][d]);
+				hi[d] = max(hi[d], nodeHi[r][d]);
+			}
+			nodeLo[node] = lo;
+			nodeHi[node] = hi;
+
+			node = parent[node];
+		}
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void TBVH_CountNeighbors(
+		DeviceArray<int> count,
+		DeviceArray<Coord> pos,
+		DeviceArray<Coord> nodeLo,
+		DeviceArray<Coord> nodeHi,
+		DeviceArray<int> childL,
+		DeviceArray<int> childR,
+		int n,
+		Real radius)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= pos.size()) return;
+
+		Coord p = pos[pId];
+
+		int num = 0;
+		int stack[64];
+		int sp = 0;
+		stack[sp++] = 0;
+
+		while (sp > 0)
+		{
+			int node = stack[--sp];
+
+			bool overlap = true;
+			for (int d = 0; d < 3; ++d)
+			{
+				if (p[d] + radius < nodeLo[node][d] || nodeHi[node][d] < p[d] - radius)
+				{
+					overlap = false;
+					break;
+				}
+			}
+			if (!overlap) continue;
+
+			if (node >= n - 1)
+			{
+				num++;
+			}
+			else if (sp + 2 <= 64)
+			{
+				stack[sp++] = childL[node];
+				stack[sp++] = childR[node];
+			}
+		}
+
+		count[pId] = num;
+	}
+
+	template<typename Real, typename Coord>
+	__global__ void TBVH_GetNeighbors(
+		NeighborList<int> nbr,
+		DeviceArray<Coord> pos,
+		DeviceArray<Coord> nodeLo,
+		DeviceArray<Coord> nodeHi,
+		DeviceArray<int> childL,
+		DeviceArray<int> childR,
+		DeviceArray<int> sortedId,
+		int n,
+		Real radius)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= pos.size()) return;
+
+		Coord p = pos[pId];
+
+		int j = 0;
+		int stack[64];
+		int sp = 0;
+		stack[sp++] = 0;
+
+		while (sp > 0)
+		{
+			int node = stack[--sp];
+
+			bool overlap = true;
+			for (int d = 0; d < 3; ++d)
+			{
+				if (p[d] + radius < nodeLo[node][d] || nodeHi[node][d] < p[d] - radius)
+				{
+					overlap = false;
+					break;
+				}
+			}
+			if (!overlap) continue;
+
+			if (node >= n - 1)
+			{
+				//same encoding as the grid rasterization path
+				nbr.setElement(pId, j, -sortedId[node - (n - 1)] - 1);
+				j++;
+			}
+			else if (sp + 2 <= 64)
+			{
+				stack[sp++] = childL[node];
+				stack[sp++] = childR[node];
+			}
+		}
+	}
+
+	template<typename TDataType>
+	void TriangleBVH<TDataType>::release()
+	{
+		m_codes.release();
+		m_sortedId.release();
+		m_childL.release();
+		m_childR.release();
+		m_parent.release();
+		m_visited.release();
+		m_nodeLo.release();
+		m_nodeHi.release();
+		m_triLo.release();
+		m_triHi.release();
+		m_num = 0;
+	}
+
+	template<typename TDataType>
+	void TriangleBVH<TDataType>::construct(DeviceArray<Coord>& vertices, DeviceArray<Triangle>& triangles)
+	{
+		int n = triangles.size();
+		if (n <= 0)
+		{
+			m_num = 0;
+			return;
+		}
+
+		if (n != m_num)
+		{
+			m_num = n;
+			m_codes.resize(n);
+			m_sortedId.resize(n);
+			m_childL.resize(n - 1 > 0 ? n - 1 : 1);
+			m_childR.resize(n - 1 > 0 ? n - 1 : 1);
+			m_parent.resize(2 * n - 1);
+			m_visited.resize(n - 1 > 0 ? n - 1 : 1);
+			m_nodeLo.resize(2 * n - 1);
+			m_nodeHi.resize(2 * n - 1);
+			m_triLo.resize(n);
+			m_triHi.resize(n);
+		}
+
+		uint pDims = cudaGridSize(n, BLOCK_SIZE);
+
+		TBVH_ComputeTriBoxes << <pDims, BLOCK_SIZE >> > (m_triLo, m_triHi, vertices, triangles);
+
+		Coord first_lo, first_hi;
+		cuSafeCall(cudaMemcpy(&first_lo, m_triLo.getDataPtr(), sizeof(Coord), cudaMemcpyDeviceToHost));
+		cuSafeCall(cudaMemcpy(&first_hi, m_triHi.getDataPtr(), sizeof(Coord), cudaMemcpyDeviceToHost));
+
+		Coord lo = thrust::reduce(thrust::device, m_triLo.getDataPtr(), m_triLo.getDataPtr() + n, first_lo, TBVH_MinOp<Coord>());
+		Coord hi = thrust::reduce(thrust::device, m_triHi.getDataPtr(), m_triHi.getDataPtr() + n, first_hi, TBVH_MaxOp<Coord>());
+
+		Coord scale;
+		for (int d = 0; d < 3; ++d)
+		{
+			Real ext = hi[d] - lo[d];
+			scale[d] = ext > REAL_EPSILON ? Real(1024) / ext : Real(0);
+		}
+
+		TBVH_ComputeCodes<Real> << <pDims, BLOCK_SIZE >> > (m_codes, m_sortedId, m_triLo, m_triHi, lo, scale);
+
+		m_sort.sortByKey(m_codes.getDataPtr(), m_sortedId.getDataPtr(), n);
+
+		if (n > 1)
+		{
+			TBVH_BuildTree << <pDims, BLOCK_SIZE >> > (m_childL, m_childR, m_parent, m_codes);
+		}
+		else
+		{
+			cuSafeCall(cudaMemset(m_parent.getDataPtr(), 0xff, sizeof(int)));
+		}
+
+		TBVH_InitLeafBoxes << <pDims, BLOCK_SIZE >> > (m_nodeLo, m_nodeHi, m_triLo, m_triHi, m_sortedId);
+
+		m_visited.reset();
+		TBVH_FitBoxes << <pDims, BLOCK_SIZE >> > (m_nodeLo, m_nodeHi, m_childL, m_childR, m_parent, m_visited, n);
+		cuSynchronize();
+	}
+
+	template<typename TDataType>
+	void TriangleBVH<TDataType>::refit(DeviceArray<Coord>& vertices, DeviceArray<Triangle>& triangles)
+	{
+		if (triangles.size() != m_num)
+		{
+			//topology changed, refit is not enough
+			construct(vertices, triangles);
+			return;
+		}
+		if (m_num <= 0) return;
+
+		uint pDims = cudaGridSize(m_num, BLOCK_SIZE);
+
+		TBVH_ComputeTriBoxes << <pDims, BLOCK_SIZE >> > (m_triLo, m_triHi, vertices, triangles);
+		TBVH_InitLeafBoxes << <pDims, BLOCK_SIZE >> > (m_nodeLo, m_nodeHi, m_triLo, m_triHi, m_sortedId);
+
+		m_visited.reset();
+		TBVH_FitBoxes << <pDims, BLOCK_SIZE >> > (m_nodeLo, m_nodeHi, m_childL, m_childR, m_parent, m_visited, m_num);
+		cuSynchronize();
+	}
+
+	template<typename TDataType>
+	void TriangleBVH<TDataType>::queryTriangleNeighbors(NeighborList<int>& nbr, DeviceArray<Coord>& pos, Real radius)
+	{
+		if (pos.size() <= 0 || m_num <= 0)
+		{
+			return;
+		}
+
+		DeviceArray<int>& nbrNum = nbr.getIndex();
+		if (nbrNum.size() != pos.size())
+			nbr.resize(pos.size());
+
+		uint pDims = cudaGridSize(pos.size(), BLOCK_SIZE);
+
+		TBVH_CountNeighbors << <pDims, BLOCK_SIZE >> > (nbrNum, pos, m_nodeLo, m_nodeHi, m_childL, m_childR, m_num, radius);
+		cuSynchronize();
+
+		int sum = thrust::reduce(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), (int)0, thrust::plus<int>());
+		thrust::exclusive_scan(thrust::device, nbrNum.getDataPtr(), nbrNum.getDataPtr() + nbrNum.size(), nbrNum.getDataPtr());
+
+		if (sum > 0)
+		{
+			nbr.resizeElements(sum);
+
+			TBVH_GetNeighbors << <pDims, BLOCK_SIZE >> > (nbr, pos, m_nodeLo, m_nodeHi, m_childL, m_childR, m_sortedId, m_num, radius);
+			cuSynchronize();
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "Core/Platform.h"
+#include "Core/Array/Array.h"
+#include "Core/Utility/Sort.h"
+#include "Framework/Framework/ModuleTopology.h"
+
+namespace PhysIKA
+{
+	template<typename ElementType> class NeighborList;
+
+	/**
+	* @brief Linear AABB-BVH over a triangle mesh with a refit path for deformation.
+	* @details The tree topology is built once from Morton-sorted triangle centroids
+	*          (radix-tree construction); when the mesh deforms without changing its
+	*          connectivity, refit() only recomputes the boxes bottom-up and keeps
+	*          the topology. Queries fill a NeighborList<int> with candidate
+	*          triangles per particle using the same -id-1 encoding as the grid
+	*          rasterization path, so MeshCollision and StaticMeshBoundary consume
+	*          the output unchanged. Unlike grid rasterization, a long thin triangle
+	*          occupies one leaf instead of every cell its box touches.
+	*/
+	template<typename TDataType>
+	class TriangleBVH
+	{
+	public:
+		typedef typename TDataType::Real Real;
+		typedef typename TDataType::Coord Coord;
+		typedef typename TopologyModule::Triangle Triangle;
+
+		TriangleBVH() {}
+		~TriangleBVH() { release(); }
+
+		void release();
+
+		/**
+		* @brief Full build: sort triangles along the Morton curve and construct the tree.
+		*/
+		void construct(DeviceArray<Coord>& vertices, DeviceArray<Triangle>& triangles);
+
+		/**
+		* @brief Recompute all boxes from the current vertex positions, keeping the
+		*        tree topology. Falls back to construct() if the triangle count changed.
+		*/
+		void refit(DeviceArray<Coord>& vertices, DeviceArray<Triangle>& triangles);
+
+		/**
+		* @brief Collect, for every query point, the triangles whose box comes within
+		*        radius. Ids are encoded as -id-1 in the dynamic neighbor list.
+		*/
+		void queryTriangleNeighbors(NeighborList<int>& nbr, DeviceArray<Coord>& pos, Real radius);
+
+		bool isEmpty() const { return m_num <= 0; }
+
+		int getTriangleNumber() const { return m_num; }
+
+		//raw tree arrays for external traversal kernels (e.g. mesh-to-SDF baking)
+		DeviceArray<Coord>& getNodeLo() { return m_nodeLo; }
+		DeviceArray<Coord>& getNodeHi() { return m_nodeHi; }
+		DeviceArray<int>& getChildL() { return m_childL; }
+		DeviceArray<int>& getChildR() { return m_childR; }
+		DeviceArray<int>& getSortedId() { return m_sortedId; }
+
+	private:
+		void updateBoxes(DeviceArray<Coord>& vertices, DeviceArray<Triangle>& triangles);
+
+		int m_num = 0;
+
+		DeviceArray<unsigned long long> m_codes;
+		DeviceArray<int> m_sortedId;
+		Sort m_sort;
+
+		// radix tree: internal nodes are [0, n-1), leaf i is stored at node n-1+i
+		DeviceArray<int> m_childL;
+		DeviceArray<int> m_childR;
+		DeviceArray<int> m_parent;
+		DeviceArray<int> m_visited;
+
+		DeviceArray<Coord> m_nodeLo;
+		DeviceArray<Coord> m_nodeHi;
+
+		// per-triangle boxes, in mesh order; also feed the Morton-code scene bounds
+		DeviceArray<Coord> m_triLo;
+		DeviceArray<Coord> m_triHi;
+	};
+
+	//DistanceField3D bakes fields for both precisions, keep both available
+	template class TriangleBVH<DataType3f>;
+	template class TriangleBVH<DataType3d>;
+}
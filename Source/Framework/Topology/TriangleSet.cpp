@@ -1,6 +1,7 @@
 #include "TriangleSet.h"
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include "Core/Utility.h"
 
@@ -46,6 +47,45 @@ namespace PhysIKA
 
 	}
 
+	template<typename TDataType>
+	void TriangleSet<TDataType>::updateEdges()
+	{
+		this->setEdgesFromTriangles(m_triangls);
+	}
+
+	template<typename TDataType>
+	void TriangleSet<TDataType>::updateEdgesHost()
+	{
+		std::vector<Triangle> triangles(m_triangls.size());
+		cuSafeCall(cudaMemcpy(triangles.data(), m_triangls.getDataPtr(), m_triangls.size() * sizeof(Triangle), cudaMemcpyDeviceToHost));
+
+		typedef TopologyModule::PointType PointType;
+		typedef TopologyModule::Edge Edge;
+
+		std::set<std::pair<PointType, PointType>> uniqueEdges;
+		for (size_t i = 0; i < triangles.size(); i++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				PointType v0 = triangles[i][k];
+				PointType v1 = triangles[i][(k + 1) % 3];
+				uniqueEdges.insert(std::make_pair(v0 < v1 ? v0 : v1, v0 < v1 ? v1 : v0));
+			}
+		}
+
+		std::vector<Edge> edges;
+		edges.reserve(uniqueEdges.size());
+		for (auto& e : uniqueEdges)
+		{
+			edges.push_back(Edge(e.first, e.second));
+		}
+
+		this->m_edges.resize(edges.size());
+		Function1Pt::copy(this->m_edges, edges);
+
+		this->updatePointNeighbors();
+	}
+
 
 	template<typename TDataType>
 	bool TriangleSet<TDataType>::initializeImpl()
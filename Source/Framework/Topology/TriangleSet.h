@@ -21,6 +21,21 @@ namespace PhysIKA
 
 		NeighborList<int>* getTriangleNeighbors() { return &m_triangleNeighbors; }
 
+		/**
+		 * @brief Rebuild the inherited edge list and vertex-incidence list
+		 * from the current triangles, entirely on device; see
+		 * EdgeSet::setEdgesFromTriangles. Call after setTriangles or
+		 * loadObjFile when edge adjacency is needed.
+		 */
+		void updateEdges();
+
+		/**
+		 * @brief Host reference path for updateEdges: set-based dedup after a
+		 * full download. Orders of magnitude slower on large meshes; kept for
+		 * validating the device path and for debugging without a GPU sort.
+		 */
+		void updateEdgesHost();
+
 		void updatePointNeighbors() override;
 
 		void loadObjFile(std::string filename);
@@ -20,6 +20,7 @@
 #include <GL/freeglut.h>
 #include "Core/Utility.h"
 #include "IO/Image_IO/image_io.h"
+#include "IO/Image_IO/async_image_writer.h"
 #include "GLApp.h"
 #include "Rendering/OpenGLContext.h"
 
@@ -148,10 +149,86 @@ bool GLApp::saveScreen()
     adaptor<<screen_capture_file_index_++;
     std::string index_str;
     adaptor>>index_str;
-    std::string file_name = std::string("screen_capture_") + index_str + std::string(".png"); 
+    std::string file_name = std::string("screen_capture_") + index_str + std::string(".png");
     return saveScreen(file_name);
 }
 
+void GLApp::enableFrameCapture(const std::string &prefix)
+{
+    frame_capture_prefix_ = prefix;
+    if (image_writer_ == nullptr)
+    {
+        image_writer_ = std::make_shared<AsyncImageWriter>();
+    }
+    frame_capture_enabled_ = true;
+}
+
+void GLApp::disableFrameCapture()
+{
+    frame_capture_enabled_ = false;
+
+    if (capture_pbo_[0] != 0)
+    {
+        glDeleteBuffers(2, capture_pbo_);
+        capture_pbo_[0] = capture_pbo_[1] = 0;
+        capture_pbo_pending_[0] = capture_pbo_pending_[1] = false;
+        capture_pbo_bytes_[0] = capture_pbo_bytes_[1] = 0;
+    }
+
+    if (image_writer_ != nullptr)
+    {
+        image_writer_->flush();
+    }
+}
+
+void GLApp::captureFrame()
+{
+    int width = this->getWidth(), height = this->getHeight();
+    int bytes = width*height*3;  //RGB
+
+    if (capture_pbo_[0] == 0)
+    {
+        glGenBuffers(2, capture_pbo_);
+    }
+
+    int cur = capture_pbo_index_ % 2;
+    int prev = (capture_pbo_index_ + 1) % 2;
+    capture_pbo_index_++;
+
+    //issue this frame's readback; with a bound pack PBO glReadPixels
+    //returns immediately and the transfer runs asynchronously
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture_pbo_[cur]);
+    if (capture_pbo_bytes_[cur] != bytes)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        capture_pbo_bytes_[cur] = bytes;
+    }
+    capture_pbo_width_[cur] = width;
+    capture_pbo_height_[cur] = height;
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0,0,width,height,GL_RGB,GL_UNSIGNED_BYTE,0);
+    capture_pbo_pending_[cur] = true;
+
+    //drain the other PBO; its readback was issued a frame ago and has
+    //landed, so mapping does not stall
+    if (capture_pbo_pending_[prev])
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture_pbo_[prev]);
+        unsigned char *pixels = (unsigned char*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (pixels != NULL)
+        {
+            std::stringstream adaptor;
+            adaptor<<screen_capture_file_index_++;
+            std::string file_name = frame_capture_prefix_ + adaptor.str() + std::string(".png");
+            image_writer_->enqueue(file_name, capture_pbo_width_[prev], capture_pbo_height_[prev], Image::RGB, pixels, true);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        capture_pbo_pending_[prev] = false;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
 void GLApp::drawFrameRate()
 {
 	if (!glutGet(GLUT_INIT_STATE))  //window is not created
@@ -391,6 +468,11 @@ void GLApp::displayFunction(void)
 
 	glPopMatrix();
 
+	if (cur_window->isCapturingFrames())
+	{
+		cur_window->captureFrame();
+	}
+
     glutPostRedisplay();
     glutSwapBuffers();
 }
@@ -12,12 +12,15 @@
  *
  */
 #pragma once
+#include <memory>
 #include <glm/vec4.hpp>
 #include "../AppBase.h"
 #include "Camera.h"
 
 namespace PhysIKA {
 
+class AsyncImageWriter;
+
 typedef glm::vec4 Color;
 
 class GLApp : public AppBase
@@ -40,6 +43,13 @@ public:
     //save screenshot to file
     bool saveScreen(const std::string &file_name) const;  //save to file with given name
     bool saveScreen();                                    //save to file with default name "screen_capture_XXX.png"
+
+    //capture every displayed frame without blocking the GL thread:
+    //readback goes through a double-buffered PBO ring and PNG encoding
+    //runs on a background thread with a bounded queue
+    void enableFrameCapture(const std::string &prefix = std::string("screen_capture_"));
+    void disableFrameCapture();
+    bool isCapturingFrames() const { return frame_capture_enabled_; }
 	bool isActive() { return m_bAnimate; }
 	void drawString(std::string s, const Color &color, int x, int y);
 
@@ -111,6 +121,10 @@ protected:
 
 	void drawBackground();
 	void drawAxis();
+
+	//issue this frame's async PBO readback and hand last frame's pixels
+	//to the background encoder; called from displayFunction before swap
+	void captureFrame();
 	void drawBoundingBox(Vector3f lo, Vector3f hi);
 
 protected:
@@ -143,6 +157,17 @@ protected:
     //current screen capture file index
     unsigned int screen_capture_file_index_;
 
+    //per-frame capture state, see captureFrame()
+    bool frame_capture_enabled_ = false;
+    std::string frame_capture_prefix_;
+    unsigned int capture_pbo_[2] = { 0, 0 };
+    int capture_pbo_bytes_[2] = { 0, 0 };
+    int capture_pbo_width_[2] = { 0, 0 };
+    int capture_pbo_height_[2] = { 0, 0 };
+    bool capture_pbo_pending_[2] = { false, false };
+    int capture_pbo_index_ = 0;
+    std::shared_ptr<AsyncImageWriter> image_writer_;
+
 	Camera m_camera;
 };
 }  //end of namespace PhysIKA
@@ -0,0 +1,233 @@
+/*
+ * @file headless_app.cpp
+ * @Brief Offscreen batch-render driver without any window system.
+ * @author Fei Zhu
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+ * If a copy of the GPL was not distributed with this file, you can obtain one at:
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+#include <GL/glew.h>
+#include <iostream>
+#include <sstream>
+
+#include "HeadlessApp.h"
+#include "Rendering/OpenGLContext.h"
+#include "IO/Image_IO/async_image_writer.h"
+#include "Framework/Framework/SceneGraph.h"
+
+namespace PhysIKA {
+
+HeadlessApp::HeadlessApp()
+    : m_width(0),
+      m_height(0),
+      m_initialized(false),
+      frame_limit_(1000),
+      capture_interval_(1),
+      frame_index_(0),
+      frame_capture_prefix_("headless_frame_")
+{
+}
+
+HeadlessApp::~HeadlessApp()
+{
+    flushFrames();
+
+    if (m_initialized)
+    {
+        glDeleteRenderbuffers(1, &color_rbo_);
+        glDeleteRenderbuffers(1, &depth_rbo_);
+        glDeleteFramebuffers(1, &fbo_);
+        if (capture_pbo_[0] != 0)
+        {
+            glDeleteBuffers(2, capture_pbo_);
+        }
+
+        OpenGLContext::getInstance().destroyOffscreen();
+    }
+}
+
+void HeadlessApp::createWindow(int width, int height)
+{
+    if (m_initialized)
+    {
+        return;
+    }
+
+    if (!OpenGLContext::getInstance().initializeOffscreen(width, height))
+    {
+        std::cerr << "error: failed to create an offscreen GL context, headless rendering unavailable!" << std::endl;
+        return;
+    }
+
+    m_width = width;
+    m_height = height;
+
+    //render into our own framebuffer rather than the pbuffer, so the
+    //target size never depends on what EGL actually allocated
+    glGenRenderbuffers(1, &color_rbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_rbo_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &depth_rbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_rbo_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_rbo_);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "error: offscreen framebuffer is incomplete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+
+    glViewport(0, 0, width, height);
+
+    glEnable(GL_DEPTH_TEST);
+    glClearDepth(1.0);
+    glEnable(GL_POINT_SMOOTH);
+    glHint(GL_POINT_SMOOTH_HINT, GL_NICEST);
+
+    image_writer_ = std::make_shared<AsyncImageWriter>();
+
+    SceneGraph::getInstance().initialize();
+
+    m_initialized = true;
+}
+
+void HeadlessApp::setCaptureInterval(unsigned int interval)
+{
+    capture_interval_ = interval < 1 ? 1 : interval;
+}
+
+void HeadlessApp::mainLoop()
+{
+    if (!m_initialized)
+    {
+        std::cerr << "error: createWindow() did not succeed, nothing to render!" << std::endl;
+        return;
+    }
+
+    while (frame_index_ < frame_limit_)
+    {
+        renderOneFrame();
+    }
+
+    flushFrames();
+}
+
+void HeadlessApp::renderOneFrame()
+{
+    if (!m_initialized)
+    {
+        return;
+    }
+
+    SceneGraph& scenegraph = SceneGraph::getInstance();
+
+    scenegraph.takeOneFrame();
+
+    drawScene();
+
+    if (frame_index_ % capture_interval_ == 0)
+    {
+        captureFrame();
+    }
+
+    glFlush();
+
+    frame_index_++;
+}
+
+void HeadlessApp::flushFrames()
+{
+    if (image_writer_ == nullptr)
+    {
+        return;
+    }
+
+    //drain the PBO whose readback is still in flight
+    if (m_initialized)
+    {
+        captureFrame();
+    }
+
+    image_writer_->flush();
+}
+
+void HeadlessApp::drawScene()
+{
+    SceneGraph& scenegraph = SceneGraph::getInstance();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+    glClearColor(0.6f, 0.6f, 0.6f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    m_camera.setGL(0.01f, 10.0f, (float)m_width, (float)m_height);
+
+    glPushMatrix();
+
+    scenegraph.draw();
+
+    glPopMatrix();
+}
+
+void HeadlessApp::captureFrame()
+{
+    int bytes = m_width * m_height * 3;  //RGB
+
+    if (capture_pbo_[0] == 0)
+    {
+        glGenBuffers(2, capture_pbo_);
+    }
+
+    int cur = capture_pbo_index_ % 2;
+    int prev = (capture_pbo_index_ + 1) % 2;
+    capture_pbo_index_++;
+
+    //issue this frame's readback; with a bound pack PBO glReadPixels
+    //returns immediately and the transfer runs asynchronously
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture_pbo_[cur]);
+    if (capture_pbo_bytes_[cur] != bytes)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        capture_pbo_bytes_[cur] = bytes;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    capture_pbo_pending_[cur] = true;
+
+    //drain the other PBO; its readback was issued a frame ago and has
+    //landed, so mapping does not stall
+    if (capture_pbo_pending_[prev])
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture_pbo_[prev]);
+        unsigned char *pixels = (unsigned char*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (pixels != NULL)
+        {
+            std::stringstream adaptor;
+            adaptor << screen_capture_file_index_++;
+            std::string file_name = frame_capture_prefix_ + adaptor.str() + std::string(".png");
+            image_writer_->enqueue(file_name, m_width, m_height, Image::RGB, pixels, true);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        capture_pbo_pending_[prev] = false;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+}  //end of namespace PhysIKA
@@ -0,0 +1,97 @@
+/*
+ * @file headless_app.h
+ * @Brief Offscreen batch-render driver without any window system.
+ * @author Fei Zhu
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+ * If a copy of the GPL was not distributed with this file, you can obtain one at:
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+#pragma once
+#include <memory>
+#include <string>
+#include "../AppBase.h"
+#include "GUI/GlutGUI/Camera.h"
+
+namespace PhysIKA {
+
+class AsyncImageWriter;
+
+/*
+ * HeadlessApp steps the SceneGraph and renders every frame into an
+ * offscreen framebuffer on an EGL context, with no glut window and no X
+ * display, so preview sequences can be produced directly on farm nodes.
+ * Frames go to disk through the same non-blocking capture path GLApp
+ * uses: an async double-buffered PBO readback feeding a background PNG
+ * encoder.
+ */
+class HeadlessApp : public AppBase
+{
+public:
+    HeadlessApp();
+    ~HeadlessApp();
+
+    //create the offscreen context and render target; also initializes the scene graph
+    void createWindow(int width, int height) override;
+
+    //render until the frame limit is reached, then block until all frames are on disk
+    void mainLoop() override;
+
+    //simulate one frame, draw it and hand the pixels to the background encoder
+    void renderOneFrame();
+
+    //block until every captured frame has been written
+    void flushFrames();
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+
+    void setOutputPrefix(const std::string &prefix) { frame_capture_prefix_ = prefix; }
+    void setFrameLimit(unsigned int frames) { frame_limit_ = frames; }
+
+    //write every interval-th simulated frame (1 captures all of them)
+    void setCaptureInterval(unsigned int interval);
+
+    Camera& activeCamera() { return m_camera; }
+
+protected:
+    void drawScene();
+
+    //issue this frame's async PBO readback and hand last frame's pixels
+    //to the background encoder; same scheme as GLApp::captureFrame()
+    void captureFrame();
+
+protected:
+    int m_width;
+    int m_height;
+
+    bool m_initialized;
+
+    unsigned int frame_limit_;
+    unsigned int capture_interval_;
+    unsigned int frame_index_;
+
+    //offscreen render target
+    unsigned int fbo_ = 0;
+    unsigned int color_rbo_ = 0;
+    unsigned int depth_rbo_ = 0;
+
+    //current capture file index
+    unsigned int screen_capture_file_index_ = 0;
+
+    //per-frame capture state, see captureFrame()
+    std::string frame_capture_prefix_;
+    unsigned int capture_pbo_[2] = { 0, 0 };
+    int capture_pbo_bytes_[2] = { 0, 0 };
+    bool capture_pbo_pending_[2] = { false, false };
+    int capture_pbo_index_ = 0;
+    std::shared_ptr<AsyncImageWriter> image_writer_;
+
+    Camera m_camera;
+};
+
+}  //end of namespace PhysIKA
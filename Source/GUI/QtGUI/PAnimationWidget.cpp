@@ -2,6 +2,10 @@
 
 #include "PSimulationThread.h"
 
+#include "Framework/Framework/SceneGraph.h"
+#include "Framework/Framework/Node.h"
+#include "Framework/Framework/CachePlayback.h"
+
 #include <QGridLayout>
 #include <QPushButton>
 #include <QSpinBox>
@@ -59,6 +63,7 @@ namespace PhysIKA
 
 		connect(m_startSim, SIGNAL(released()), this, SLOT(toggleSimulation()));
 		connect(m_resetSim, SIGNAL(released()), this, SLOT(resetSimulation()));
+		connect(m_sim_scrollbar, SIGNAL(valueChanged(int)), this, SLOT(scrubFrame(int)));
 		connect(PSimulationThread::instance(), SIGNAL(finished()), this, SLOT(simulationFinished()));
 	}
 
@@ -105,4 +110,25 @@ namespace PhysIKA
 		m_startSim->setDisabled(true);
 	}
 
+	void PAnimationWidget::scrubFrame(int frame)
+	{
+		//scrubbing drives playback nodes only; while a simulation runs the
+		//scrollbar keeps its progress-display role
+		if (m_sim_started && m_startSim->isChecked())
+		{
+			return;
+		}
+
+		SceneGraph& scene = SceneGraph::getInstance();
+		for (auto it = scene.begin(); it != scene.end(); it++)
+		{
+			auto playback = dynamic_cast<CachePlayback*>(it.get().get());
+			if (playback != nullptr)
+			{
+				playback->gotoFrame(frame);
+				m_sim_scrollbar->setMaximum(playback->getFrameCount() - 1);
+			}
+		}
+	}
+
 }
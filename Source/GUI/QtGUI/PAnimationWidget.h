@@ -27,6 +27,10 @@ namespace PhysIKA
 
 		void simulationFinished();
 
+		//timeline scrubbing for cache playback nodes; active while the
+		//simulation is not running
+		void scrubFrame(int frame);
+
 
 
 	public:
@@ -21,6 +21,7 @@
 #include <QSpinBox>
 #include <QRegularExpression>
 #include <QMessageBox>
+#include <QTimer>
 
 namespace PhysIKA
 {
@@ -406,6 +407,10 @@ namespace PhysIKA
 				{
 					this->addScalarFieldWidget(var);
 				}
+				else if (var->getClassName() == std::string("ArrayBuffer"))
+				{
+					this->addArrayFieldWidget(var);
+				}
 			}
 		}
 	}
@@ -440,7 +445,88 @@ namespace PhysIKA
 
 	void PPropertyWidget::addArrayFieldWidget(Field* field)
 	{
+		this->addWidget(new QArrayFieldSummaryWidget(field));
+	}
+
+	QArrayFieldSummaryWidget::QArrayFieldSummaryWidget(Field* field)
+		: QGroupBox()
+	{
+		m_field = field;
+
+		this->setStyleSheet("border:none");
+		QGridLayout* layout = new QGridLayout;
+		layout->setContentsMargins(0, 0, 0, 0);
+		layout->setSpacing(0);
+
+		this->setLayout(layout);
 
+		QLabel* name = new QLabel();
+		name->setFixedSize(160, 18);
+		name->setText(FormatFieldWidgetName(field->getObjectName()));
+
+		m_summary = new QLabel();
+		m_summary->setText(QString("%1 elements").arg((uint)m_field->getElementCount()));
+
+		layout->addWidget(name, 0, 0);
+		layout->addWidget(m_summary, 0, 1);
+
+		//the copy is requested here and picked up by the timer once the
+		//event signals; the panel never waits on the device
+		if (m_field->requestSnapshot())
+		{
+			m_timer = new QTimer(this);
+			connect(m_timer, SIGNAL(timeout()), this, SLOT(pollSnapshot()));
+			m_timer->start(30);
+		}
+	}
+
+	QArrayFieldSummaryWidget::~QArrayFieldSummaryWidget()
+	{
+	}
+
+	void QArrayFieldSummaryWidget::pollSnapshot()
+	{
+		if (!m_field->isSnapshotReady())
+		{
+			return;
+		}
+		m_timer->stop();
+
+		const void* data = m_field->getSnapshotData();
+		size_t num = m_field->getSnapshotCount();
+		if (data == nullptr || num == 0)
+		{
+			return;
+		}
+
+		std::string template_name = m_field->getTemplateName();
+		if (template_name == std::string(typeid(float).name()))
+		{
+			const float* vals = (const float*)data;
+			float vmin = vals[0];
+			float vmax = vals[0];
+			for (size_t i = 1; i < num; i++)
+			{
+				vmin = vals[i] < vmin ? vals[i] : vmin;
+				vmax = vals[i] > vmax ? vals[i] : vmax;
+			}
+			m_summary->setText(QString("%1 elements, [%2, %3]").arg((uint)num).arg(vmin).arg(vmax));
+		}
+		else if (template_name == std::string(typeid(Vector3f).name()))
+		{
+			const Vector3f* vals = (const Vector3f*)data;
+			float vmax = 0.0f;
+			for (size_t i = 0; i < num; i++)
+			{
+				float n = vals[i].norm();
+				vmax = n > vmax ? n : vmax;
+			}
+			m_summary->setText(QString("%1 elements, max |v| = %2").arg((uint)num).arg(vmax));
+		}
+		else
+		{
+			m_summary->setText(QString("%1 elements").arg((uint)num));
+		}
 	}
 
 }
@@ -12,7 +12,8 @@
 
 #include <vector>
 
-
+class QLabel;
+class QTimer;
 
 namespace PhysIKA
 {
@@ -96,6 +97,33 @@ namespace PhysIKA
 		QDoubleSpinner* spinner3;
 	};
 
+	/*!
+	*	\class	QArrayFieldSummaryWidget
+	*	\brief	Read-only summary of a device array field.
+	*
+	*	Reading a device array back for display used to stall the
+	*	pipeline behind every queued kernel; this widget instead asks
+	*	the field for an event-signaled snapshot into pinned memory and
+	*	polls a timer until the copy lands, so opening the property
+	*	panel costs the simulation nothing.
+	*/
+	class QArrayFieldSummaryWidget : public QGroupBox
+	{
+		Q_OBJECT
+	public:
+		QArrayFieldSummaryWidget(Field* field);
+		~QArrayFieldSummaryWidget();
+
+	public slots:
+		void pollSnapshot();
+
+	private:
+		Field* m_field = nullptr;
+
+		QLabel* m_summary = nullptr;
+		QTimer* m_timer = nullptr;
+	};
+
 	class PPropertyWidget : public QWidget
 	{
 		Q_OBJECT
@@ -0,0 +1,90 @@
+/*
+ * @file async_image_writer.cpp
+ * @Brief background encoding queue for captured frames.
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+ * If a copy of the GPL was not distributed with this file, you can obtain one at:
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+
+#include "async_image_writer.h"
+#include "image_io.h"
+
+namespace PhysIKA{
+
+AsyncImageWriter::AsyncImageWriter(unsigned int max_pending)
+    :max_pending_(max_pending == 0 ? 1 : max_pending)
+{
+    encoder_ = std::thread(&AsyncImageWriter::encodeLoop, this);
+}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    job_available_.notify_all();
+    encoder_.join();
+}
+
+void AsyncImageWriter::enqueue(const std::string &filename, unsigned int width, unsigned int height,
+                               Image::DataFormat data_format, const unsigned char *pixels, bool flip_vertically)
+{
+    std::shared_ptr<Job> job(new Job());
+    job->filename = filename;
+    job->image.setRawData(width, height, data_format, pixels);  //the one copy on the calling thread
+    job->flip = flip_vertically;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_done_.wait(lock, [&] { return in_flight_ < max_pending_; });
+    jobs_.push(job);
+    in_flight_++;
+    lock.unlock();
+
+    job_available_.notify_one();
+}
+
+void AsyncImageWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_done_.wait(lock, [&] { return in_flight_ == 0; });
+}
+
+void AsyncImageWriter::encodeLoop()
+{
+    for (;;)
+    {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job_available_.wait(lock, [&] { return !jobs_.empty() || shutdown_; });
+            if (jobs_.empty())
+            {
+                return;
+            }
+            job = jobs_.front();
+            jobs_.pop();
+        }
+
+        if (job->flip)
+        {
+            job->image.flipVertically();
+        }
+        ImageIO::save(job->filename, &job->image);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_flight_--;
+        }
+        job_done_.notify_all();
+    }
+}
+
+} //end of namespace PhysIKA
@@ -0,0 +1,72 @@
+/*
+ * @file async_image_writer.h
+ * @Brief background encoding queue for captured frames.
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+ * If a copy of the GPL was not distributed with this file, you can obtain one at:
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+
+#ifndef PHYSIKA_IO_IMAGE_IO_ASYNC_IMAGE_WRITER_H_
+#define PHYSIKA_IO_IMAGE_IO_ASYNC_IMAGE_WRITER_H_
+
+#include <string>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "image.h"
+
+namespace PhysIKA{
+
+/* Encodes and saves images on a background thread. enqueue() copies the
+ * raw pixels and returns; flipping and PNG compression happen off the
+ * calling (GL) thread. The queue is bounded: when max_pending frames
+ * wait, enqueue() blocks until the encoder drains one, so capture can
+ * not grow memory without limit when the disk falls behind.
+ */
+class AsyncImageWriter
+{
+public:
+    AsyncImageWriter(unsigned int max_pending = 8);
+    ~AsyncImageWriter();
+
+    /* pixels are in row order as read from GL; pass flip_vertically =
+     * true to restore top-down order on the worker thread
+     */
+    void enqueue(const std::string &filename, unsigned int width, unsigned int height,
+                 Image::DataFormat data_format, const unsigned char *pixels, bool flip_vertically);
+
+    //block until every enqueued frame is on disk
+    void flush();
+
+protected:
+    void encodeLoop();
+
+    struct Job
+    {
+        std::string filename;
+        Image image;
+        bool flip;
+    };
+
+    unsigned int max_pending_;
+    std::queue<std::shared_ptr<Job> > jobs_;
+
+    std::thread encoder_;
+    std::mutex mutex_;
+    std::condition_variable job_available_;
+    std::condition_variable job_done_;
+
+    unsigned int in_flight_ = 0;
+    bool shutdown_ = false;
+};
+
+} //end of namespace PhysIKA
+
+#endif //PHYSIKA_IO_IMAGE_IO_ASYNC_IMAGE_WRITER_H_
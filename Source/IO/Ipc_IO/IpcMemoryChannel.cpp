@@ -0,0 +1,291 @@
+#include "IpcMemoryChannel.h"
+
+#include "Core/Utility/cuda_utilities.h"
+
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+namespace PhysIKA
+{
+	namespace
+	{
+		const char IPC_MAGIC[8] = { 'P', 'K', 'I', 'P', 'C', '\0', '\0', '\0' };
+	}
+
+	IpcMemoryChannel::IpcMemoryChannel()
+	{
+		for (int i = 0; i < IPC_MAX_BUFFERS; i++)
+		{
+			m_devPtr[i] = nullptr;
+			m_devBytes[i] = 0;
+			m_mapped[i] = nullptr;
+			m_mappedGen[i] = 0;
+		}
+	}
+
+	IpcMemoryChannel::~IpcMemoryChannel()
+	{
+		close();
+	}
+
+	bool IpcMemoryChannel::create(const std::string& name)
+	{
+		close();
+
+#ifdef _WIN32
+		HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)sizeof(IpcChannelHeader), name.c_str());
+		if (mapping == NULL)
+		{
+			return false;
+		}
+		void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(IpcChannelHeader));
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			return false;
+		}
+		m_mapping = mapping;
+#else
+		std::string shmName = "/" + name;
+		int fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0666);
+		if (fd < 0)
+		{
+			return false;
+		}
+		if (ftruncate(fd, sizeof(IpcChannelHeader)) != 0)
+		{
+			::close(fd);
+			return false;
+		}
+		void* data = mmap(nullptr, sizeof(IpcChannelHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			::close(fd);
+			return false;
+		}
+		m_fd = fd;
+#endif
+
+		m_header = (IpcChannelHeader*)data;
+		m_owner = true;
+		m_name = name;
+
+		std::memset(m_header, 0, sizeof(IpcChannelHeader));
+		std::memcpy(m_header->magic, IPC_MAGIC, sizeof(IPC_MAGIC));
+		m_header->version = 1;
+
+		return true;
+	}
+
+	bool IpcMemoryChannel::open(const std::string& name)
+	{
+		close();
+
+#ifdef _WIN32
+		HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+		if (mapping == NULL)
+		{
+			return false;
+		}
+		void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(IpcChannelHeader));
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			return false;
+		}
+		m_mapping = mapping;
+#else
+		std::string shmName = "/" + name;
+		int fd = shm_open(shmName.c_str(), O_RDWR, 0666);
+		if (fd < 0)
+		{
+			return false;
+		}
+		void* data = mmap(nullptr, sizeof(IpcChannelHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			::close(fd);
+			return false;
+		}
+		m_fd = fd;
+#endif
+
+		m_header = (IpcChannelHeader*)data;
+		m_owner = false;
+		m_name = name;
+
+		if (std::memcmp(m_header->magic, IPC_MAGIC, sizeof(IPC_MAGIC)) != 0 || m_header->version != 1)
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void IpcMemoryChannel::close()
+	{
+		for (int i = 0; i < IPC_MAX_BUFFERS; i++)
+		{
+			if (m_mapped[i] != nullptr)
+			{
+				cudaIpcCloseMemHandle(m_mapped[i]);
+				m_mapped[i] = nullptr;
+			}
+			if (m_devPtr[i] != nullptr)
+			{
+				cudaFree(m_devPtr[i]);
+				m_devPtr[i] = nullptr;
+				m_devBytes[i] = 0;
+			}
+		}
+
+		if (m_header == nullptr)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_header);
+		CloseHandle((HANDLE)m_mapping);
+		m_mapping = nullptr;
+#else
+		munmap(m_header, sizeof(IpcChannelHeader));
+		::close(m_fd);
+		m_fd = -1;
+		if (m_owner)
+		{
+			std::string shmName = "/" + m_name;
+			shm_unlink(shmName.c_str());
+		}
+#endif
+
+		m_header = nullptr;
+		m_owner = false;
+	}
+
+	int IpcMemoryChannel::findBuffer(const std::string& bufferName) const
+	{
+		for (std::uint32_t i = 0; i < m_header->bufferNum; i++)
+		{
+			if (bufferName == m_header->buffers[i].name)
+			{
+				return (int)i;
+			}
+		}
+		return -1;
+	}
+
+	void* IpcMemoryChannel::ensureBuffer(const std::string& bufferName, std::uint32_t elementBytes, std::uint64_t elementCount)
+	{
+		if (m_header == nullptr || !m_owner || bufferName.size() >= 32)
+		{
+			return nullptr;
+		}
+
+		int slot = findBuffer(bufferName);
+		if (slot < 0)
+		{
+			if (m_header->bufferNum >= IPC_MAX_BUFFERS)
+			{
+				return nullptr;
+			}
+			slot = (int)m_header->bufferNum;
+			std::memset(&m_header->buffers[slot], 0, sizeof(IpcBufferDesc));
+			strncpy(m_header->buffers[slot].name, bufferName.c_str(), sizeof(m_header->buffers[slot].name) - 1);
+			m_header->bufferNum++;
+		}
+
+		IpcBufferDesc& desc = m_header->buffers[slot];
+		std::uint64_t bytes = elementCount * elementBytes;
+
+		//grow-only: a reallocation invalidates the exported handle, so it
+		//also bumps the generation consumers compare against
+		if (m_devBytes[slot] < bytes)
+		{
+			if (m_devPtr[slot] != nullptr)
+			{
+				cuSafeCall(cudaFree(m_devPtr[slot]));
+			}
+			cuSafeCall(cudaMalloc(&m_devPtr[slot], bytes));
+			cuSafeCall(cudaIpcGetMemHandle(&desc.handle, m_devPtr[slot]));
+			m_devBytes[slot] = bytes;
+			desc.generation++;
+		}
+
+		desc.elementBytes = elementBytes;
+		desc.elementCount = elementCount;
+
+		return m_devPtr[slot];
+	}
+
+	void IpcMemoryChannel::publishFrame()
+	{
+		if (m_header == nullptr || !m_owner)
+		{
+			return;
+		}
+
+		//the copies of this frame must be complete before consumers see
+		//the new frame number
+		cuSynchronize();
+		std::atomic_thread_fence(std::memory_order_release);
+		m_header->frameNumber++;
+	}
+
+	std::uint64_t IpcMemoryChannel::getFrameNumber() const
+	{
+		if (m_header == nullptr)
+		{
+			return 0;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return m_header->frameNumber;
+	}
+
+	void* IpcMemoryChannel::mapBuffer(const std::string& bufferName, std::uint64_t& elementCount, std::uint32_t& elementBytes)
+	{
+		elementCount = 0;
+		elementBytes = 0;
+		if (m_header == nullptr)
+		{
+			return nullptr;
+		}
+
+		int slot = findBuffer(bufferName);
+		if (slot < 0)
+		{
+			return nullptr;
+		}
+
+		IpcBufferDesc& desc = m_header->buffers[slot];
+
+		if (m_mapped[slot] != nullptr && m_mappedGen[slot] != desc.generation)
+		{
+			cudaIpcCloseMemHandle(m_mapped[slot]);
+			m_mapped[slot] = nullptr;
+		}
+
+		if (m_mapped[slot] == nullptr)
+		{
+			if (cudaIpcOpenMemHandle(&m_mapped[slot], desc.handle, cudaIpcMemLazyEnablePeerAccess) != cudaSuccess)
+			{
+				m_mapped[slot] = nullptr;
+				return nullptr;
+			}
+			m_mappedGen[slot] = desc.generation;
+		}
+
+		elementCount = desc.elementCount;
+		elementBytes = desc.elementBytes;
+		return m_mapped[slot];
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	IpcMemoryChannel
+	*	\brief	Cross-process device-buffer sharing via CUDA IPC.
+	*
+	*	The producer process keeps a set of named device buffers and
+	*	publishes their cudaIpcMemHandle_t plus sizes through a small
+	*	named shared-memory descriptor block. A consumer process (e.g. an
+	*	external renderer) opens the block by name, maps the handles with
+	*	cudaIpcOpenMemHandle and reads simulation memory directly — no
+	*	serialization, no files. The producer bumps a frame counter after
+	*	each publish; consumers poll it. Buffer reallocations (particle
+	*	count growth) bump a per-buffer generation so consumers know to
+	*	remap.
+	*/
+
+	#define IPC_MAX_BUFFERS 8
+
+	struct IpcBufferDesc
+	{
+		char name[32];
+		std::uint32_t elementBytes;
+		std::uint32_t generation;       //bumped on reallocation, consumers remap
+		std::uint64_t elementCount;
+		cudaIpcMemHandle_t handle;
+	};
+
+	struct IpcChannelHeader
+	{
+		char magic[8];                  //"PKIPC\0\0"
+		std::uint32_t version;
+		std::uint32_t bufferNum;
+		std::uint64_t frameNumber;      //bumped after every publishFrame()
+		IpcBufferDesc buffers[IPC_MAX_BUFFERS];
+	};
+
+	class IpcMemoryChannel
+	{
+	public:
+		IpcMemoryChannel();
+		~IpcMemoryChannel();
+
+		/**
+		 * @brief Producer side: create (or recreate) the named descriptor
+		 * block.
+		 */
+		bool create(const std::string& name);
+
+		/**
+		 * @brief Consumer side: open an existing descriptor block.
+		 */
+		bool open(const std::string& name);
+
+		void close();
+
+		bool isOpen() const { return m_header != nullptr; }
+
+		/**
+		 * @brief Producer: device buffer with at least elementCount *
+		 * elementBytes bytes published under bufferName, growing (and
+		 * re-exporting) it when needed. Returns the device pointer to
+		 * copy this frame's data into.
+		 */
+		void* ensureBuffer(const std::string& bufferName, std::uint32_t elementBytes, std::uint64_t elementCount);
+
+		/**
+		 * @brief Producer: make this frame's copies visible and bump the
+		 * frame counter consumers poll.
+		 */
+		void publishFrame();
+
+		std::uint64_t getFrameNumber() const;
+
+		/**
+		 * @brief Consumer: device pointer of the named buffer, mapped via
+		 * cudaIpcOpenMemHandle and remapped when its generation changed.
+		 * Returns null when the buffer does not exist.
+		 */
+		void* mapBuffer(const std::string& bufferName, std::uint64_t& elementCount, std::uint32_t& elementBytes);
+
+	private:
+		int findBuffer(const std::string& bufferName) const;
+
+		IpcChannelHeader* m_header = nullptr;
+		bool m_owner = false;
+		std::string m_name;
+
+		//producer-side allocations backing the exported handles
+		void* m_devPtr[IPC_MAX_BUFFERS];
+		std::uint64_t m_devBytes[IPC_MAX_BUFFERS];
+
+		//consumer-side mappings and the generation they were opened at
+		void* m_mapped[IPC_MAX_BUFFERS];
+		std::uint32_t m_mappedGen[IPC_MAX_BUFFERS];
+
+#ifdef _WIN32
+		void* m_mapping = nullptr;
+#else
+		int m_fd = -1;
+#endif
+	};
+}
@@ -0,0 +1,172 @@
+#include "AsyncWriteQueue.h"
+#include "ParticleCache.h"
+
+#include "Core/Utility/cuda_utilities.h"
+#include "Core/Utility/TraceProfiler.h"
+
+namespace PhysIKA
+{
+	AsyncWriteQueue& AsyncWriteQueue::getInstance()
+	{
+		static AsyncWriteQueue instance;
+		return instance;
+	}
+
+	AsyncWriteQueue::AsyncWriteQueue()
+	{
+		cuSafeCall(cudaStreamCreate(&m_stream));
+
+		for (int i = 0; i < SLOT_NUM; i++)
+		{
+			cuSafeCall(cudaEventCreateWithFlags(&m_slots[i].copyDone, cudaEventDisableTiming));
+		}
+
+		m_writer = std::thread(&AsyncWriteQueue::writerLoop, this);
+	}
+
+	AsyncWriteQueue::~AsyncWriteQueue()
+	{
+		flush();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_shutdown = true;
+		}
+		m_jobAvailable.notify_all();
+		m_writer.join();
+
+		for (int i = 0; i < SLOT_NUM; i++)
+		{
+			if (m_slots[i].data != nullptr)
+			{
+				cudaFreeHost(m_slots[i].data);
+			}
+			cudaEventDestroy(m_slots[i].copyDone);
+		}
+		cudaStreamDestroy(m_stream);
+	}
+
+	int AsyncWriteQueue::acquireSlot(std::uint64_t bytes)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		int slot = -1;
+		m_slotFree.wait(lock, [&] {
+			for (int i = 0; i < SLOT_NUM; i++)
+			{
+				if (!m_slots[i].busy)
+				{
+					slot = i;
+					return true;
+				}
+			}
+			return false;
+		});
+
+		m_slots[slot].busy = true;
+		lock.unlock();
+
+		//grow-only pinned buffer; safe outside the lock, the slot is ours
+		if (m_slots[slot].capacity < bytes)
+		{
+			if (m_slots[slot].data != nullptr)
+			{
+				cuSafeCall(cudaFreeHost(m_slots[slot].data));
+			}
+			cuSafeCall(cudaMallocHost(&m_slots[slot].data, bytes));
+			m_slots[slot].capacity = bytes;
+		}
+
+		return slot;
+	}
+
+	char* AsyncWriteQueue::slotBuffer(int slot)
+	{
+		return m_slots[slot].data;
+	}
+
+	void AsyncWriteQueue::submit(int slot, const FrameDesc& desc)
+	{
+		cuSafeCall(cudaEventRecord(m_slots[slot].copyDone, m_stream));
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push(Job{ slot, desc });
+			m_inFlight++;
+		}
+		m_jobAvailable.notify_one();
+	}
+
+	void AsyncWriteQueue::flush()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_slotFree.wait(lock, [&] { return m_inFlight == 0; });
+	}
+
+	void AsyncWriteQueue::writerLoop()
+	{
+		TraceProfiler::getInstance().nameCurrentThread("cache writer");
+
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobAvailable.wait(lock, [&] { return !m_jobs.empty() || m_shutdown; });
+				if (m_jobs.empty())
+				{
+					return;
+				}
+				job = m_jobs.front();
+				m_jobs.pop();
+			}
+
+			Slot& slot = m_slots[job.slot];
+
+			//timeline range for the whole disk write of this frame, so the
+			//IO overlap with simulation shows up in traces
+			TraceScope traceScope(std::string("write ") + job.desc.filename);
+
+			//wait for the staging copy of this frame only; the sim thread
+			//keeps issuing work on other streams meanwhile
+			cudaEventSynchronize(slot.copyDone);
+
+			std::uint32_t tags[3];
+			const void* datas[3];
+			std::uint64_t bytes[3];
+			std::uint32_t blockNum = 0;
+
+			const FrameDesc& desc = job.desc;
+			if (desc.posOffset >= 0)
+			{
+				tags[blockNum] = PC_BLOCK_POSITION;
+				datas[blockNum] = slot.data + desc.posOffset;
+				bytes[blockNum] = std::uint64_t(desc.particleNum) * 3 * desc.realBytes;
+				blockNum++;
+			}
+			if (desc.scalarOffset >= 0)
+			{
+				tags[blockNum] = PC_BLOCK_SCALAR;
+				datas[blockNum] = slot.data + desc.scalarOffset;
+				bytes[blockNum] = std::uint64_t(desc.particleNum) * desc.realBytes;
+				blockNum++;
+			}
+			if (desc.triOffset >= 0)
+			{
+				tags[blockNum] = PC_BLOCK_TRIANGLE;
+				datas[blockNum] = slot.data + desc.triOffset;
+				bytes[blockNum] = std::uint64_t(desc.triangleNum) * 3 * sizeof(std::uint32_t);
+				blockNum++;
+			}
+
+			ParticleCacheWriter::writeBlocks(desc.filename, desc.particleNum, desc.realBytes, tags, datas, bytes, blockNum);
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				slot.busy = false;
+				m_inFlight--;
+			}
+			m_slotFree.notify_all();
+		}
+	}
+}
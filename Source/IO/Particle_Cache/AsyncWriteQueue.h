@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace PhysIKA
+{
+	/*!
+	*	\class	AsyncWriteQueue
+	*	\brief	Background writer pipeline for per-frame output files.
+	*
+	*	Writers used to block the simulation thread for the whole
+	*	device-to-host copy plus the disk write of every frame. The queue
+	*	decouples the two: the simulation thread acquires a pinned staging
+	*	slot, issues cudaMemcpyAsync into it on the queue's stream and
+	*	submits a frame description; a persistent writer thread waits for
+	*	the copy to land (per-slot event) and streams the file to disk
+	*	while the next step runs.
+	*
+	*	A small fixed ring of slots bounds memory use and provides
+	*	backpressure: when the disk cannot keep up, acquireSlot() blocks
+	*	until a slot drains instead of queueing frames without limit.
+	*/
+	class AsyncWriteQueue
+	{
+	public:
+		/**
+		 * @brief Frame description handed to the writer thread. Offsets
+		 * index into the slot's staging buffer; -1 marks an absent block.
+		 */
+		struct FrameDesc
+		{
+			std::string filename;
+			std::uint32_t particleNum = 0;
+			std::uint32_t triangleNum = 0;
+			std::uint32_t realBytes = 0;
+			std::int64_t posOffset = -1;
+			std::int64_t scalarOffset = -1;
+			std::int64_t triOffset = -1;
+		};
+
+		static AsyncWriteQueue& getInstance();
+
+		~AsyncWriteQueue();
+
+		/**
+		 * @brief Acquire a staging slot with at least bytes of pinned
+		 * capacity. Blocks while every slot is in flight.
+		 */
+		int acquireSlot(std::uint64_t bytes);
+
+		char* slotBuffer(int slot);
+
+		/**
+		 * @brief Stream the staging copies must be issued on; submit()
+		 * records its completion event on this stream.
+		 */
+		cudaStream_t stream() { return m_stream; }
+
+		/**
+		 * @brief Hand an acquired slot to the writer thread. All
+		 * cudaMemcpyAsync calls into the slot must already be queued on
+		 * stream().
+		 */
+		void submit(int slot, const FrameDesc& desc);
+
+		/**
+		 * @brief Block until every submitted frame is on disk.
+		 */
+		void flush();
+
+	private:
+		AsyncWriteQueue();
+
+		void writerLoop();
+
+		static const int SLOT_NUM = 4;
+
+		struct Slot
+		{
+			char* data = nullptr;
+			std::uint64_t capacity = 0;
+			cudaEvent_t copyDone;
+			bool busy = false;
+		};
+
+		struct Job
+		{
+			int slot;
+			FrameDesc desc;
+		};
+
+		Slot m_slots[SLOT_NUM];
+		std::queue<Job> m_jobs;
+
+		cudaStream_t m_stream;
+		std::thread m_writer;
+
+		std::mutex m_mutex;
+		std::condition_variable m_jobAvailable;
+		std::condition_variable m_slotFree;
+
+		int m_inFlight = 0;
+		bool m_shutdown = false;
+	};
+}
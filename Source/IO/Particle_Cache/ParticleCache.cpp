@@ -0,0 +1,236 @@
+#include "ParticleCache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace PhysIKA
+{
+	namespace
+	{
+		const char PC_MAGIC[8] = { 'P', 'K', 'C', 'A', 'C', 'H', 'E', '\0' };
+
+		std::uint64_t alignTo64(std::uint64_t offset)
+		{
+			return (offset + 63) & ~std::uint64_t(63);
+		}
+	}
+
+	bool ParticleCacheWriter::writeFrame(const std::string& filename, const void* positions, const void* scalars, std::uint32_t particleNum, std::uint32_t realBytes)
+	{
+		std::uint32_t tags[2] = { PC_BLOCK_POSITION, PC_BLOCK_SCALAR };
+		const void* datas[2] = { positions, scalars };
+		std::uint64_t bytes[2] = { std::uint64_t(particleNum) * 3 * realBytes, std::uint64_t(particleNum) * realBytes };
+
+		return writeBlocks(filename, particleNum, realBytes, tags, datas, bytes, scalars != nullptr ? 2 : 1);
+	}
+
+	bool ParticleCacheWriter::writeBlocks(const std::string& filename, std::uint32_t particleNum, std::uint32_t realBytes, const std::uint32_t* tags, const void** datas, const std::uint64_t* bytes, std::uint32_t blockNum)
+	{
+		const std::uint32_t MAX_BLOCKS = 8;
+		if (blockNum == 0 || blockNum > MAX_BLOCKS)
+		{
+			return false;
+		}
+
+		FILE* fp = fopen(filename.c_str(), "wb");
+		if (fp == nullptr)
+		{
+			return false;
+		}
+
+		ParticleCacheHeader header;
+		std::memcpy(header.magic, PC_MAGIC, sizeof(header.magic));
+		header.version = 1;
+		header.realBytes = realBytes;
+		header.particleNum = particleNum;
+		header.blockNum = blockNum;
+
+		ParticleCacheBlock blocks[MAX_BLOCKS];
+		std::uint64_t offset = alignTo64(sizeof(ParticleCacheHeader) + blockNum * sizeof(ParticleCacheBlock));
+		for (std::uint32_t i = 0; i < blockNum; i++)
+		{
+			blocks[i].tag = tags[i];
+			blocks[i].reserved = 0;
+			blocks[i].offset = offset;
+			blocks[i].bytes = bytes[i];
+			offset = alignTo64(offset + bytes[i]);
+		}
+
+		bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+		ok = ok && fwrite(blocks, sizeof(ParticleCacheBlock), blockNum, fp) == blockNum;
+
+		//pad up to the first aligned block offset, then between blocks
+		char zeros[64] = { 0 };
+		std::uint64_t written = sizeof(header) + blockNum * sizeof(ParticleCacheBlock);
+		for (std::uint32_t i = 0; i < blockNum; i++)
+		{
+			std::uint64_t pad = blocks[i].offset - written;
+			ok = ok && fwrite(zeros, 1, pad, fp) == pad;
+			if (bytes[i] > 0)
+			{
+				ok = ok && fwrite(datas[i], 1, bytes[i], fp) == bytes[i];
+			}
+			written = blocks[i].offset + bytes[i];
+		}
+
+		fclose(fp);
+		return ok;
+	}
+
+	ParticleCacheReader::ParticleCacheReader()
+		: m_data(nullptr)
+		, m_size(0)
+#ifdef _WIN32
+		, m_file(nullptr)
+		, m_mapping(nullptr)
+#else
+		, m_fd(-1)
+#endif
+	{
+	}
+
+	ParticleCacheReader::~ParticleCacheReader()
+	{
+		close();
+	}
+
+	bool ParticleCacheReader::open(const std::string& filename)
+	{
+		close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(ParticleCacheHeader))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_file = file;
+		m_mapping = mapping;
+		m_data = data;
+		m_size = (std::uint64_t)size.QuadPart;
+#else
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ParticleCacheHeader))
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			::close(fd);
+			return false;
+		}
+
+		m_fd = fd;
+		m_data = data;
+		m_size = (std::uint64_t)st.st_size;
+#endif
+
+		if (std::memcmp(header()->magic, PC_MAGIC, sizeof(PC_MAGIC)) != 0 || header()->version != 1)
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void ParticleCacheReader::close()
+	{
+		if (m_data == nullptr)
+		{
+			return;
+		}
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle((HANDLE)m_mapping);
+		CloseHandle((HANDLE)m_file);
+		m_file = nullptr;
+		m_mapping = nullptr;
+#else
+		munmap(m_data, m_size);
+		::close(m_fd);
+		m_fd = -1;
+#endif
+
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	const ParticleCacheHeader* ParticleCacheReader::header() const
+	{
+		return (const ParticleCacheHeader*)m_data;
+	}
+
+	std::uint32_t ParticleCacheReader::getParticleNum() const
+	{
+		return m_data != nullptr ? header()->particleNum : 0;
+	}
+
+	std::uint32_t ParticleCacheReader::getRealBytes() const
+	{
+		return m_data != nullptr ? header()->realBytes : 0;
+	}
+
+	const void* ParticleCacheReader::getBlock(ParticleCacheTag tag, std::uint64_t& bytes) const
+	{
+		bytes = 0;
+		if (m_data == nullptr)
+		{
+			return nullptr;
+		}
+
+		const ParticleCacheBlock* blocks = (const ParticleCacheBlock*)((const char*)m_data + sizeof(ParticleCacheHeader));
+		for (std::uint32_t i = 0; i < header()->blockNum; i++)
+		{
+			if (blocks[i].tag == (std::uint32_t)tag && blocks[i].offset + blocks[i].bytes <= m_size)
+			{
+				bytes = blocks[i].bytes;
+				return (const char*)m_data + blocks[i].offset;
+			}
+		}
+
+		return nullptr;
+	}
+}
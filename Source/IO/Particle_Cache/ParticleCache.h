@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace PhysIKA
+{
+	/**
+	 * @brief Binary per-frame particle cache.
+	 *
+	 * On-disk layout: a fixed header, a block table, then one contiguous
+	 * block per attribute (positions, scalar mapping, ...) instead of
+	 * interleaved text rows. Blocks start at 64-byte aligned offsets so a
+	 * reader can memory-map the file and hand the pointers straight to the
+	 * GUI without parsing or copying.
+	 */
+
+	struct ParticleCacheHeader
+	{
+		char magic[8];              //"PKCACHE\0"
+		std::uint32_t version;      //currently 1
+		std::uint32_t realBytes;    //4 for float caches, 8 for double
+		std::uint32_t particleNum;
+		std::uint32_t blockNum;
+	};
+
+	enum ParticleCacheTag
+	{
+		PC_BLOCK_POSITION = 1,      //particleNum * 3 reals
+		PC_BLOCK_SCALAR = 2,        //particleNum reals
+		PC_BLOCK_TRIANGLE = 3,      //triangle count * 3 uint32 indices
+		PC_BLOCK_POSITION_DELTA = 4 //ParticleCacheDeltaHeader + varint residual stream, see ParticleCacheDelta.h
+	};
+
+	struct ParticleCacheBlock
+	{
+		std::uint32_t tag;          //ParticleCacheTag
+		std::uint32_t reserved;
+		std::uint64_t offset;       //from the start of the file
+		std::uint64_t bytes;
+	};
+
+	class ParticleCacheWriter
+	{
+	public:
+		/**
+		 * @brief Write one frame. positions holds particleNum xyz triplets,
+		 * scalars holds particleNum values or may be null.
+		 */
+		static bool writeFrame(const std::string& filename, const void* positions, const void* scalars, std::uint32_t particleNum, std::uint32_t realBytes);
+
+		/**
+		 * @brief Write one frame from an arbitrary set of blocks. The block
+		 * count of a triangle block is its bytes / (3 * sizeof(uint32)).
+		 */
+		static bool writeBlocks(const std::string& filename, std::uint32_t particleNum, std::uint32_t realBytes, const std::uint32_t* tags, const void** datas, const std::uint64_t* bytes, std::uint32_t blockNum);
+	};
+
+	class ParticleCacheReader
+	{
+	public:
+		ParticleCacheReader();
+		~ParticleCacheReader();
+
+		/**
+		 * @brief Memory-map a frame file. The returned block pointers stay
+		 * valid until close(); nothing is copied.
+		 */
+		bool open(const std::string& filename);
+		void close();
+
+		bool isOpen() const { return m_data != nullptr; }
+
+		std::uint32_t getParticleNum() const;
+		std::uint32_t getRealBytes() const;
+
+		/**
+		 * @brief Pointer to the block with the given tag, or null when the
+		 * frame does not contain it. bytes receives the block size.
+		 */
+		const void* getBlock(ParticleCacheTag tag, std::uint64_t& bytes) const;
+
+	private:
+		const ParticleCacheHeader* header() const;
+
+		void* m_data;
+		std::uint64_t m_size;
+
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_fd;
+#endif
+	};
+}
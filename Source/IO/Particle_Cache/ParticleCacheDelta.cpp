@@ -0,0 +1,294 @@
+#include "ParticleCacheDelta.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace PhysIKA
+{
+	namespace
+	{
+		//residuals beyond this force a keyframe; keeps q*step exact in double
+		const long long Q_MAX = (1ll << 46);
+
+		void appendVarint(std::vector<char>& stream, long long q)
+		{
+			//zigzag so small negative residuals stay one byte
+			unsigned long long u = (static_cast<unsigned long long>(q) << 1) ^ static_cast<unsigned long long>(q >> 63);
+			while (u >= 0x80)
+			{
+				stream.push_back(static_cast<char>((u & 0x7f) | 0x80));
+				u >>= 7;
+			}
+			stream.push_back(static_cast<char>(u));
+		}
+
+		bool readVarint(const unsigned char*& cursor, const unsigned char* end, long long& q)
+		{
+			unsigned long long u = 0;
+			int shift = 0;
+			while (cursor < end && shift < 64)
+			{
+				unsigned char byte = *cursor++;
+				u |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					q = static_cast<long long>(u >> 1) ^ -static_cast<long long>(u & 1);
+					return true;
+				}
+				shift += 7;
+			}
+			return false;
+		}
+
+		double readComponent(const void* positions, std::uint32_t realBytes, std::uint64_t idx)
+		{
+			if (realBytes == sizeof(float))
+			{
+				return static_cast<const float*>(positions)[idx];
+			}
+			return static_cast<const double*>(positions)[idx];
+		}
+
+		void writeComponent(void* positions, std::uint32_t realBytes, std::uint64_t idx, double value)
+		{
+			if (realBytes == sizeof(float))
+			{
+				static_cast<float*>(positions)[idx] = static_cast<float>(value);
+			}
+			else
+			{
+				static_cast<double*>(positions)[idx] = value;
+			}
+		}
+	}
+
+	void ParticleCacheDeltaWriter::setKeyInterval(int frames)
+	{
+		m_keyInterval = frames < 1 ? 1 : frames;
+	}
+
+	void ParticleCacheDeltaWriter::setQuantization(double step)
+	{
+		if (step > 0.0)
+		{
+			m_step = step;
+		}
+	}
+
+	void ParticleCacheDeltaWriter::reset()
+	{
+		m_sinceKey = -1;
+	}
+
+	bool ParticleCacheDeltaWriter::writeKeyFrame(const std::string& filename, const void* positions, const void* scalars, std::uint32_t particleNum, std::uint32_t realBytes)
+	{
+		if (!ParticleCacheWriter::writeFrame(filename, positions, scalars, particleNum, realBytes))
+		{
+			m_sinceKey = -1;
+			return false;
+		}
+
+		std::uint64_t components = std::uint64_t(particleNum) * 3;
+		m_prev.resize(components);
+		for (std::uint64_t i = 0; i < components; i++)
+		{
+			m_prev[i] = readComponent(positions, realBytes, i);
+		}
+		m_prev2 = m_prev;
+
+		m_prevNum = particleNum;
+		m_sinceKey = 0;
+		return true;
+	}
+
+	bool ParticleCacheDeltaWriter::writeFrame(const std::string& filename, const void* positions, const void* scalars, std::uint32_t particleNum, std::uint32_t realBytes)
+	{
+		if (m_sinceKey < 0 || m_sinceKey >= m_keyInterval || particleNum != m_prevNum || particleNum == 0)
+		{
+			return writeKeyFrame(filename, positions, scalars, particleNum, realBytes);
+		}
+
+		std::uint64_t components = std::uint64_t(particleNum) * 3;
+
+		std::vector<char> stream;
+		stream.reserve(components * 2);
+
+		//closed loop: predict from the reconstructed history and advance it
+		//with the reconstructed values, so reader and writer never diverge
+		std::vector<double> recon(components);
+		for (std::uint64_t i = 0; i < components; i++)
+		{
+			double pred = 2.0 * m_prev[i] - m_prev2[i];
+			double r = readComponent(positions, realBytes, i) - pred;
+			long long q = static_cast<long long>(std::llround(r / m_step));
+			if (q > Q_MAX || q < -Q_MAX)
+			{
+				//a jump the quantizer cannot represent; resynchronize
+				return writeKeyFrame(filename, positions, scalars, particleNum, realBytes);
+			}
+			appendVarint(stream, q);
+			recon[i] = pred + double(q) * m_step;
+		}
+
+		ParticleCacheDeltaHeader dh;
+		dh.sinceKey = std::uint32_t(m_sinceKey + 1);
+		dh.particleNum = particleNum;
+		dh.step = m_step;
+		dh.streamBytes = stream.size();
+
+		std::vector<char> blob(sizeof(dh) + stream.size());
+		std::memcpy(blob.data(), &dh, sizeof(dh));
+		if (!stream.empty())
+		{
+			std::memcpy(blob.data() + sizeof(dh), stream.data(), stream.size());
+		}
+
+		std::uint32_t tags[2] = { PC_BLOCK_POSITION_DELTA, PC_BLOCK_SCALAR };
+		const void* datas[2] = { blob.data(), scalars };
+		std::uint64_t bytes[2] = { blob.size(), std::uint64_t(particleNum) * realBytes };
+
+		if (!ParticleCacheWriter::writeBlocks(filename, particleNum, realBytes, tags, datas, bytes, scalars != nullptr ? 2 : 1))
+		{
+			m_sinceKey = -1;
+			return false;
+		}
+
+		m_prev2.swap(m_prev);
+		m_prev.swap(recon);
+		m_sinceKey++;
+		return true;
+	}
+
+	void ParticleCacheDeltaReader::reset()
+	{
+		m_sinceKey = -1;
+	}
+
+	const void* ParticleCacheDeltaReader::getPositions() const
+	{
+		return m_positions.empty() ? nullptr : m_positions.data();
+	}
+
+	const void* ParticleCacheDeltaReader::getScalars(std::uint64_t& bytes) const
+	{
+		bytes = m_hasScalars ? m_scalars.size() : 0;
+		return m_hasScalars ? m_scalars.data() : nullptr;
+	}
+
+	bool ParticleCacheDeltaReader::open(const std::string& filename)
+	{
+		ParticleCacheReader reader;
+		if (!reader.open(filename))
+		{
+			return false;
+		}
+
+		std::uint32_t num = reader.getParticleNum();
+		std::uint32_t realBytes = reader.getRealBytes();
+		std::uint64_t components = std::uint64_t(num) * 3;
+
+		std::uint64_t deltaBytes = 0;
+		const void* delta = reader.getBlock(PC_BLOCK_POSITION_DELTA, deltaBytes);
+
+		if (delta == nullptr)
+		{
+			//a plain frame doubles as a keyframe
+			std::uint64_t posBytes = 0;
+			const void* positions = reader.getBlock(PC_BLOCK_POSITION, posBytes);
+			if (positions == nullptr && num > 0)
+			{
+				return false;
+			}
+
+			m_positions.resize(components * realBytes);
+			if (components > 0)
+			{
+				std::memcpy(m_positions.data(), positions, components * realBytes);
+			}
+
+			m_prev.resize(components);
+			for (std::uint64_t i = 0; i < components; i++)
+			{
+				m_prev[i] = readComponent(positions, realBytes, i);
+			}
+			m_prev2 = m_prev;
+			m_sinceKey = 0;
+		}
+		else
+		{
+			if (deltaBytes < sizeof(ParticleCacheDeltaHeader))
+			{
+				return false;
+			}
+
+			ParticleCacheDeltaHeader dh;
+			std::memcpy(&dh, delta, sizeof(dh));
+
+			//the state must be exactly the frame before this one
+			if (m_sinceKey < 0 || dh.sinceKey != std::uint32_t(m_sinceKey + 1)
+				|| dh.particleNum != num || num != m_num
+				|| dh.streamBytes > deltaBytes - sizeof(dh))
+			{
+				return false;
+			}
+
+			const unsigned char* cursor = static_cast<const unsigned char*>(delta) + sizeof(dh);
+			const unsigned char* end = cursor + dh.streamBytes;
+
+			m_positions.resize(components * realBytes);
+			std::vector<double> recon(components);
+			for (std::uint64_t i = 0; i < components; i++)
+			{
+				long long q = 0;
+				if (!readVarint(cursor, end, q))
+				{
+					m_sinceKey = -1;
+					return false;
+				}
+				recon[i] = 2.0 * m_prev[i] - m_prev2[i] + double(q) * dh.step;
+				writeComponent(m_positions.data(), realBytes, i, recon[i]);
+			}
+
+			m_prev2.swap(m_prev);
+			m_prev.swap(recon);
+			m_sinceKey = int(dh.sinceKey);
+		}
+
+		std::uint64_t scalarBytes = 0;
+		const void* scalarBlock = reader.getBlock(PC_BLOCK_SCALAR, scalarBytes);
+		m_hasScalars = scalarBlock != nullptr;
+		if (m_hasScalars)
+		{
+			m_scalars.resize(scalarBytes);
+			std::memcpy(m_scalars.data(), scalarBlock, scalarBytes);
+		}
+
+		m_num = num;
+		m_realBytes = realBytes;
+		return true;
+	}
+
+	int ParticleCacheDeltaReader::keyDistance(const std::string& filename)
+	{
+		ParticleCacheReader reader;
+		if (!reader.open(filename))
+		{
+			return -1;
+		}
+
+		std::uint64_t deltaBytes = 0;
+		const void* delta = reader.getBlock(PC_BLOCK_POSITION_DELTA, deltaBytes);
+		if (delta == nullptr)
+		{
+			return 0;
+		}
+		if (deltaBytes < sizeof(ParticleCacheDeltaHeader))
+		{
+			return -1;
+		}
+
+		ParticleCacheDeltaHeader dh;
+		std::memcpy(&dh, delta, sizeof(dh));
+		return int(dh.sinceKey);
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "ParticleCache.h"
+
+namespace PhysIKA
+{
+	/**
+	 * @brief Differential compression for the binary particle cache.
+	 *
+	 * Consecutive cache frames are highly correlated: a particle rarely moves
+	 * far from where its last two frames predict it. Delta frames therefore
+	 * store, per position component, the quantized residual against the
+	 * linear prediction 2*prev - prev2 (previous position plus previous
+	 * velocity), zigzag/varint packed so small residuals cost one byte
+	 * instead of a full real. The codec is closed-loop - both sides predict
+	 * from the reconstructed previous frames - so the quantization error is
+	 * bounded by half a step per frame and never accumulates.
+	 *
+	 * Every keyInterval frames, whenever the particle count changes, and
+	 * whenever a residual overflows the quantizer, a plain keyframe in the
+	 * uncompressed format is written instead; keyframes are readable by the
+	 * plain ParticleCacheReader, and the delta reader reads plain frames
+	 * transparently, so old caches keep working.
+	 */
+
+	struct ParticleCacheDeltaHeader
+	{
+		std::uint32_t sinceKey;     //frames since the covering keyframe, >= 1
+		std::uint32_t particleNum;
+		double step;                //quantization step, in world units
+		std::uint64_t streamBytes;  //varint stream size following this header
+	};
+
+	class ParticleCacheDeltaWriter
+	{
+	public:
+		/**
+		 * @brief Frames between keyframes; larger values compress better but
+		 * make random access walk further. Takes effect at the next keyframe.
+		 */
+		void setKeyInterval(int frames);
+
+		/**
+		 * @brief Quantization step in world units; reconstruction error is
+		 * bounded by half a step. The default of 1e-5 is well below visual
+		 * tolerance at unit scene scale.
+		 */
+		void setQuantization(double step);
+
+		/**
+		 * @brief Write one frame, deciding keyframe versus delta internally.
+		 * Same contract as ParticleCacheWriter::writeFrame; frames must be
+		 * submitted in playback order.
+		 */
+		bool writeFrame(const std::string& filename, const void* positions, const void* scalars, std::uint32_t particleNum, std::uint32_t realBytes);
+
+		/**
+		 * @brief Forget the prediction state so the next frame is a keyframe.
+		 */
+		void reset();
+
+	private:
+		bool writeKeyFrame(const std::string& filename, const void* positions, const void* scalars, std::uint32_t particleNum, std::uint32_t realBytes);
+
+		int m_keyInterval = 16;
+		int m_sinceKey = -1;        //-1: no usable state, force a keyframe
+		double m_step = 1e-5;
+
+		std::uint32_t m_prevNum = 0;
+
+		//reconstructed previous two frames, kept in double regardless of the
+		//cache precision so float and double caches share one code path
+		std::vector<double> m_prev;
+		std::vector<double> m_prev2;
+	};
+
+	class ParticleCacheDeltaReader
+	{
+	public:
+		/**
+		 * @brief Read one frame, plain or delta, updating the prediction
+		 * state. Delta frames require that the frames since their keyframe
+		 * were read through this reader in order; otherwise open() fails and
+		 * the caller should restart from the keyframe (see keyDistance()).
+		 */
+		bool open(const std::string& filename);
+
+		/**
+		 * @brief Forget the prediction state, e.g. before a non-sequential seek.
+		 */
+		void reset();
+
+		std::uint32_t getParticleNum() const { return m_num; }
+		std::uint32_t getRealBytes() const { return m_realBytes; }
+
+		/**
+		 * @brief Decoded positions of the last opened frame, particleNum xyz
+		 * triplets of getRealBytes() reals, or null for an empty frame.
+		 */
+		const void* getPositions() const;
+
+		/**
+		 * @brief Scalar block of the last opened frame, or null when absent.
+		 */
+		const void* getScalars(std::uint64_t& bytes) const;
+
+		/**
+		 * @brief How many frames before the given file its covering keyframe
+		 * lies: 0 for plain frames, the stored distance for delta frames, -1
+		 * when the file cannot be read. Lets a player map a random frame to
+		 * the decode start without touching the prediction state.
+		 */
+		static int keyDistance(const std::string& filename);
+
+	private:
+		std::uint32_t m_num = 0;
+		std::uint32_t m_realBytes = 0;
+
+		int m_sinceKey = -1;        //-1: no usable state
+
+		std::vector<double> m_prev;
+		std::vector<double> m_prev2;
+
+		std::vector<char> m_positions;
+		std::vector<char> m_scalars;
+		bool m_hasScalars = false;
+	};
+}
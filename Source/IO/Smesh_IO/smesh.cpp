@@ -1,63 +1,157 @@
 #include "smesh.h"
 #include <string.h>
+#include <cctype>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <sys/stat.h>
 using namespace std;
 
 namespace PhysIKA
 {
 
+namespace
+{
+    const char SMESH_CACHE_MAGIC[8] = { 'P', 'K', 'S', 'M', 'E', 'S', 'H', '\0' };
+
+    struct SmeshCacheHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t elemBytes[6];
+        uint64_t counts[6];
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+    };
+
+    bool fileInfo(const string &filename, uint64_t &size, int64_t &mtime)
+    {
+#ifdef _WIN32
+        struct _stat64 st;
+        if (_stat64(filename.c_str(), &st) != 0) return false;
+#else
+        struct stat st;
+        if (stat(filename.c_str(), &st) != 0) return false;
+#endif
+        size = (uint64_t)st.st_size;
+        mtime = (int64_t)st.st_mtime;
+        return true;
+    }
+
+    const char* nextWord(const char *p, string &word)
+    {
+        while (*p != '\0' && isspace((unsigned char)*p)) p++;
+        const char *start = p;
+        while (*p != '\0' && !isspace((unsigned char)*p)) p++;
+        word.assign(start, p - start);
+        return p;
+    }
+
+    template<typename T>
+    void writeVec(ofstream &out, const vector<T> &vec)
+    {
+        if (!vec.empty())
+        {
+            out.write((const char*)vec.data(), vec.size() * sizeof(T));
+        }
+    }
+
+    template<typename T>
+    bool readVec(ifstream &in, vector<T> &vec, uint64_t count)
+    {
+        vec.resize((size_t)count);
+        if (count > 0)
+        {
+            in.read((char*)vec.data(), count * sizeof(T));
+        }
+        return (bool)in;
+    }
+}
+
 void Smesh::loadFile(string filename)
 {
-    fstream filein(filename);
+    uint64_t srcSize = 0;
+    int64_t srcMtime = 0;
+    bool haveInfo = fileInfo(filename, srcSize, srcMtime);
+
+    string cacheName = filename + ".bin";
+    if (haveInfo && loadCache(cacheName, srcSize, srcMtime))
+    {
+        return;
+    }
+
+    parseText(filename);
+
+    if (haveInfo)
+    {
+        saveCache(cacheName, srcSize, srcMtime);
+    }
+}
+
+void Smesh::parseText(const string &filename)
+{
+    ifstream filein(filename, ios::in | ios::binary);
     if (!filein.is_open())
     {
         cout << "can't open smesh file:" << filename << endl;
         exit(0);
     }
 
+    //pull the whole file into memory once and tokenize with pointer
+    //sweeps; iostream extraction per number dominated large loads
+    string buffer((istreambuf_iterator<char>(filein)), istreambuf_iterator<char>());
+    filein.close();
+
+    const char *p = buffer.c_str();
     string part_str;
-    filein >> part_str;
+
+    p = nextWord(p, part_str);
     if (part_str != "*VERTICES")
     {
         cout << "first non-empty line must be '*VERTICES'." << endl;
         exit(0);
     }
-    int num_points = 0, point_dim = 0;
-    filein >> num_points >> point_dim;
+
+    char *q;
+    int num_points = (int)strtol(p, &q, 10); p = q;
+    int point_dim = (int)strtol(p, &q, 10); p = q;
     m_points.resize(num_points, Vector3f(0.0f));
     for (int i = 0; i < num_points; ++i)
     {
-        int vert_index;
-        filein >> vert_index;
+        strtol(p, &q, 10); p = q;    //vertex index
         for (int j = 0; j < point_dim; ++j)
         {
-            filein >> m_points[i][j];
+            m_points[i][j] = strtof(p, &q); p = q;
         }
     }
 
-    filein >> part_str;
+    p = nextWord(p, part_str);
     if (part_str != "*ELEMENTS")
     {
         cout << "after vertices, the first non-empty line must be '*ELEMENTS'." << endl;
         return;
     }
 
-    while (!filein.eof())
+    for (;;)
     {
-        string ele_type = "";
-        int num_eles = 0, ele_dim = 0;
-        filein >> ele_type >> num_eles >> ele_dim;
+        string ele_type;
+        p = nextWord(p, ele_type);
+        if (ele_type.empty())
+        {
+            break;
+        }
+
+        int num_eles = (int)strtol(p, &q, 10); p = q;
+        int ele_dim = (int)strtol(p, &q, 10); p = q;
         if (ele_type == "LINE")
         {
             m_edges.resize(num_eles);
             for (int i = 0; i < num_eles; ++i)
             {
-                int ele_index;
-                filein >> ele_index;
+                strtol(p, &q, 10); p = q;
                 for (int j = 0; j < ele_dim; ++j)
                 {
-                    filein >> m_edges[i][j];
+                    m_edges[i][j] = (int)strtol(p, &q, 10); p = q;
                 }
             }
         }
@@ -66,11 +160,10 @@ void Smesh::loadFile(string filename)
             m_triangles.resize(num_eles);
             for (int i = 0; i < num_eles; ++i)
             {
-                int ele_index;
-                filein >> ele_index;
+                strtol(p, &q, 10); p = q;
                 for (int j = 0; j < ele_dim; ++j)
                 {
-                    filein >> m_triangles[i][j];
+                    m_triangles[i][j] = (int)strtol(p, &q, 10); p = q;
                 }
             }
         }
@@ -79,11 +172,10 @@ void Smesh::loadFile(string filename)
             m_quads.resize(num_eles);
             for (int i = 0; i < num_eles; ++i)
             {
-                int ele_index;
-                filein >> ele_index;
+                strtol(p, &q, 10); p = q;
                 for (int j = 0; j < ele_dim; ++j)
                 {
-                    filein >> m_quads[i][j];
+                    m_quads[i][j] = (int)strtol(p, &q, 10); p = q;
                 }
             }
         }
@@ -92,11 +184,10 @@ void Smesh::loadFile(string filename)
             m_tets.resize(num_eles);
             for (int i = 0; i < num_eles; ++i)
             {
-                int ele_index;
-                filein >> ele_index;
+                strtol(p, &q, 10); p = q;
                 for (int j = 0; j < ele_dim; ++j)
                 {
-                    filein >> m_tets[i][j];
+                    m_tets[i][j] = (int)strtol(p, &q, 10); p = q;
                 }
             }
         }
@@ -105,11 +196,10 @@ void Smesh::loadFile(string filename)
             m_hexs.resize(num_eles);
             for (int i = 0; i < num_eles; ++i)
             {
-                int ele_index;
-                filein >> ele_index;
+                strtol(p, &q, 10); p = q;
                 for (int j = 0; j < ele_dim; ++j)
                 {
-                    filein >> m_hexs[i][j];
+                    m_hexs[i][j] = (int)strtol(p, &q, 10); p = q;
                 }
             }
         }
@@ -120,4 +210,73 @@ void Smesh::loadFile(string filename)
     }
 }
 
+bool Smesh::loadCache(const string &filename, uint64_t srcSize, int64_t srcMtime)
+{
+    ifstream in(filename, ios::in | ios::binary);
+    if (!in.is_open())
+    {
+        return false;
+    }
+
+    SmeshCacheHeader header;
+    in.read((char*)&header, sizeof(header));
+    if (!in
+        || memcmp(header.magic, SMESH_CACHE_MAGIC, sizeof(SMESH_CACHE_MAGIC)) != 0
+        || header.version != 1
+        || header.sourceSize != srcSize
+        || header.sourceMtime != srcMtime
+        || header.elemBytes[0] != sizeof(Vector3f)
+        || header.elemBytes[1] != sizeof(TopologyModule::Edge)
+        || header.elemBytes[2] != sizeof(TopologyModule::Triangle)
+        || header.elemBytes[3] != sizeof(TopologyModule::Quad)
+        || header.elemBytes[4] != sizeof(TopologyModule::Tetrahedron)
+        || header.elemBytes[5] != sizeof(TopologyModule::Hexahedron))
+    {
+        return false;
+    }
+
+    return readVec(in, m_points, header.counts[0])
+        && readVec(in, m_edges, header.counts[1])
+        && readVec(in, m_triangles, header.counts[2])
+        && readVec(in, m_quads, header.counts[3])
+        && readVec(in, m_tets, header.counts[4])
+        && readVec(in, m_hexs, header.counts[5]);
+}
+
+void Smesh::saveCache(const string &filename, uint64_t srcSize, int64_t srcMtime)
+{
+    ofstream out(filename, ios::out | ios::binary);
+    if (!out.is_open())
+    {
+        //a read-only asset directory is fine, the next load just parses again
+        return;
+    }
+
+    SmeshCacheHeader header;
+    memcpy(header.magic, SMESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = 1;
+    header.elemBytes[0] = sizeof(Vector3f);
+    header.elemBytes[1] = sizeof(TopologyModule::Edge);
+    header.elemBytes[2] = sizeof(TopologyModule::Triangle);
+    header.elemBytes[3] = sizeof(TopologyModule::Quad);
+    header.elemBytes[4] = sizeof(TopologyModule::Tetrahedron);
+    header.elemBytes[5] = sizeof(TopologyModule::Hexahedron);
+    header.counts[0] = m_points.size();
+    header.counts[1] = m_edges.size();
+    header.counts[2] = m_triangles.size();
+    header.counts[3] = m_quads.size();
+    header.counts[4] = m_tets.size();
+    header.counts[5] = m_hexs.size();
+    header.sourceSize = srcSize;
+    header.sourceMtime = srcMtime;
+    out.write((const char*)&header, sizeof(header));
+
+    writeVec(out, m_points);
+    writeVec(out, m_edges);
+    writeVec(out, m_triangles);
+    writeVec(out, m_quads);
+    writeVec(out, m_tets);
+    writeVec(out, m_hexs);
+}
+
 } // namespace PhysIKA
@@ -1,5 +1,7 @@
 #pragma once
+#include <string>
 #include <vector>
+#include <cstdint>
 #include <Core/Vector/vector_3d.h>
 #include <Framework/Framework/ModuleTopology.h>
 
@@ -7,6 +9,12 @@ namespace PhysIKA{
 
 class Smesh{
 public:
+/**
+ * Load a mesh. The text file is parsed once and mirrored into a binary
+ * sidecar (<filename>.bin); subsequent loads of an unchanged file read
+ * the sidecar directly, bounded by disk speed. The sidecar is
+ * invalidated by the source file's size or modification time changing.
+ */
 void loadFile(std::string filename);
 
 std::vector<Vector3f> m_points;
@@ -15,6 +23,11 @@ std::vector<TopologyModule::Triangle> m_triangles;
 std::vector<TopologyModule::Quad> m_quads;
 std::vector<TopologyModule::Tetrahedron> m_tets;
 std::vector<TopologyModule::Hexahedron> m_hexs;
+
+private:
+void parseText(const std::string &filename);
+bool loadCache(const std::string &filename, std::uint64_t srcSize, std::int64_t srcMtime);
+void saveCache(const std::string &filename, std::uint64_t srcSize, std::int64_t srcMtime);
 };
 
-}
\ No newline at end of file
+}
@@ -2,9 +2,112 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 namespace PhysIKA{
-    
+
+	namespace
+	{
+		struct ObjChunkResult
+		{
+			std::vector<Vector3f> verts;
+			std::vector<Face> faces;
+		};
+
+		/**
+		 * Parse every full line in [begin, end). Chunk boundaries are
+		 * snapped to newlines by the caller, so each line belongs to
+		 * exactly one chunk. Only positions and the leading index of each
+		 * face token are read; vt/vn references and other statements are
+		 * skipped.
+		 */
+		void parseObjChunk(const char* begin, const char* end, ObjChunkResult& out)
+		{
+			const char* cur = begin;
+			while (cur < end)
+			{
+				const char* eol = (const char*)memchr(cur, '\n', end - cur);
+				if (eol == nullptr) eol = end;
+
+				if (cur + 1 < eol && (cur[1] == ' ' || cur[1] == '\t'))
+				{
+					if (cur[0] == 'v')
+					{
+						char* p = (char*)(cur + 1);
+						float x = strtof(p, &p);
+						float y = strtof(p, &p);
+						float z = strtof(p, &p);
+						out.verts.push_back(Vector3f(x, y, z));
+					}
+					else if (cur[0] == 'f')
+					{
+						const char* p = cur + 1;
+						int idx[3];
+						int n = 0;
+						while (n < 3 && p < eol)
+						{
+							while (p < eol && (*p == ' ' || *p == '\t')) p++;
+							if (p >= eol) break;
+
+							char* q;
+							long v = strtol(p, &q, 10);
+							if (q == p) break;
+							idx[n++] = (int)v - 1;
+
+							//skip the /vt/vn part of the token
+							p = q;
+							while (p < eol && *p != ' ' && *p != '\t') p++;
+						}
+						if (n == 3)
+						{
+							out.faces.push_back(Face(idx[0], idx[1], idx[2]));
+						}
+					}
+				}
+
+				cur = eol + 1;
+			}
+		}
+
+		struct VertexKey
+		{
+			float x, y, z;
+
+			bool operator==(const VertexKey& rhs) const
+			{
+				return x == rhs.x && y == rhs.y && z == rhs.z;
+			}
+		};
+
+		struct VertexKeyHash
+		{
+			size_t operator()(const VertexKey& key) const
+			{
+				unsigned int a, b, c;
+				memcpy(&a, &key.x, sizeof(a));
+				memcpy(&b, &key.y, sizeof(b));
+				memcpy(&c, &key.z, sizeof(c));
+
+				size_t h = a;
+				h = h * 1000003u ^ b;
+				h = h * 1000003u ^ c;
+				return h;
+			}
+		};
+	}
+
 	ObjFileLoader::ObjFileLoader(std::string filename)
 	{
 		load(filename);
@@ -17,6 +120,129 @@ namespace PhysIKA{
 			exit(-1);
 		}
 
+		vertList.clear();
+		faceList.clear();
+
+		//fast path: memory-map the file and parse it chunk-parallel; fall
+		//back to the line-by-line stream parser when mapping fails
+		bool ok = false;
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file != INVALID_HANDLE_VALUE)
+		{
+			LARGE_INTEGER size;
+			HANDLE mapping = NULL;
+			void* data = nullptr;
+			if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+			{
+				mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			}
+			if (mapping != NULL)
+			{
+				data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			}
+			if (data != nullptr)
+			{
+				ok = parseMapped((const char*)data, (size_t)size.QuadPart);
+				UnmapViewOfFile(data);
+			}
+			if (mapping != NULL) CloseHandle(mapping);
+			CloseHandle(file);
+		}
+#else
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd >= 0)
+		{
+			struct stat st;
+			if (fstat(fd, &st) == 0 && st.st_size > 0)
+			{
+				void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data != MAP_FAILED)
+				{
+					ok = parseMapped((const char*)data, (size_t)st.st_size);
+					munmap(data, st.st_size);
+				}
+			}
+			::close(fd);
+		}
+#endif
+
+		if (!ok)
+		{
+			ok = parseStream(filename);
+		}
+
+		if (ok)
+		{
+			deduplicateVertices();
+		}
+
+		return ok;
+	}
+
+	bool ObjFileLoader::parseMapped(const char* data, size_t size)
+	{
+		int threadNum = (int)std::thread::hardware_concurrency();
+		if (threadNum <= 0) threadNum = 1;
+
+		//one chunk per MB at most; small files parse on the calling thread
+		int chunkLimit = (int)(size / (1 << 20)) + 1;
+		if (threadNum > chunkLimit) threadNum = chunkLimit;
+
+		//snap chunk seams forward to the next newline so every line is
+		//parsed by exactly one chunk
+		std::vector<const char*> bounds(threadNum + 1);
+		bounds[0] = data;
+		bounds[threadNum] = data + size;
+		for (int i = 1; i < threadNum; i++)
+		{
+			const char* nominal = data + size / threadNum * i;
+			const char* nl = (const char*)memchr(nominal, '\n', (data + size) - nominal);
+			bounds[i] = nl != nullptr ? nl + 1 : data + size;
+		}
+
+		std::vector<ObjChunkResult> results(threadNum);
+		if (threadNum == 1)
+		{
+			parseObjChunk(bounds[0], bounds[1], results[0]);
+		}
+		else
+		{
+			std::vector<std::thread> workers;
+			for (int i = 0; i < threadNum; i++)
+			{
+				workers.push_back(std::thread(parseObjChunk, bounds[i], bounds[i + 1], std::ref(results[i])));
+			}
+			for (int i = 0; i < threadNum; i++)
+			{
+				workers[i].join();
+			}
+		}
+
+		//vertices concatenated in chunk order reproduce file order, which
+		//is what the face indices refer to
+		size_t vertNum = 0;
+		size_t faceNum = 0;
+		for (int i = 0; i < threadNum; i++)
+		{
+			vertNum += results[i].verts.size();
+			faceNum += results[i].faces.size();
+		}
+
+		vertList.reserve(vertNum);
+		faceList.reserve(faceNum);
+		for (int i = 0; i < threadNum; i++)
+		{
+			vertList.insert(vertList.end(), results[i].verts.begin(), results[i].verts.end());
+			faceList.insert(faceList.end(), results[i].faces.begin(), results[i].faces.end());
+		}
+
+		return true;
+	}
+
+	bool ObjFileLoader::parseStream(const std::string &filename)
+	{
 		std::ifstream infile(filename);
 		if (!infile) {
 			std::cerr << "Failed to open. Terminating.\n";
@@ -43,15 +269,58 @@ namespace PhysIKA{
 				data >> c >> v0 >> v1 >> v2;
 				faceList.push_back(Face(v0 - 1, v1 - 1, v2 - 1));
 			}
-			else if (line.substr(0, 2) == std::string("vn")) {
-				std::cerr << "Obj-loader is not able to parse vertex normals, please strip them from the input file. \n";
-				exit(-2);
-			}
 			else {
 				++ignored_lines;
 			}
 		}
 		infile.close();
+
+		return true;
+	}
+
+	void ObjFileLoader::deduplicateVertices()
+	{
+		size_t num = vertList.size();
+		if (num == 0) return;
+
+		std::unordered_map<VertexKey, int, VertexKeyHash> unique;
+		unique.reserve(num);
+
+		std::vector<int> remap(num);
+		std::vector<Vector3f> merged;
+		merged.reserve(num);
+
+		for (size_t i = 0; i < num; i++)
+		{
+			VertexKey key = { vertList[i][0], vertList[i][1], vertList[i][2] };
+			auto it = unique.find(key);
+			if (it != unique.end())
+			{
+				remap[i] = it->second;
+			}
+			else
+			{
+				remap[i] = (int)merged.size();
+				unique.insert(std::make_pair(key, remap[i]));
+				merged.push_back(vertList[i]);
+			}
+		}
+
+		if (merged.size() == num) return;
+
+		for (size_t i = 0; i < faceList.size(); i++)
+		{
+			for (int d = 0; d < 3; d++)
+			{
+				int v = faceList[i][d];
+				if (v >= 0 && v < (int)num)
+				{
+					faceList[i][d] = remap[v];
+				}
+			}
+		}
+
+		vertList.swap(merged);
 	}
 
 	bool ObjFileLoader::save(const std::string &filename)
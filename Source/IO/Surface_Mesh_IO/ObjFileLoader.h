@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include "Core/Vector.h"
+#include "Framework/Topology/TriangleSet.h"
 
 namespace PhysIKA{
 
@@ -12,15 +13,44 @@ class ObjFileLoader
 public:
 	ObjFileLoader(std::string filename);
     ~ObjFileLoader(){}
-    
+
     bool load(const std::string &filename);
-    
+
     bool save(const std::string &filename);
 
 	std::vector<Vector3f>& getVertexList();
 	std::vector<Face>& getFaceList();
 
+	/**
+	 * @brief Hand the parsed mesh to a TriangleSet through its
+	 * setPoints/setTriangles interface.
+	 */
+	template<typename TDataType>
+	void feedTriangleSet(TriangleSet<TDataType>& triSet)
+	{
+		typedef typename TDataType::Coord Coord;
+
+		std::vector<Coord> points(vertList.size());
+		for (size_t i = 0; i < vertList.size(); i++)
+		{
+			points[i] = Coord(vertList[i][0], vertList[i][1], vertList[i][2]);
+		}
+
+		std::vector<TopologyModule::Triangle> triangles(faceList.size());
+		for (size_t i = 0; i < faceList.size(); i++)
+		{
+			triangles[i] = TopologyModule::Triangle(faceList[i][0], faceList[i][1], faceList[i][2]);
+		}
+
+		triSet.setPoints(points);
+		triSet.setTriangles(triangles);
+	}
+
 private:
+	bool parseMapped(const char* data, size_t size);
+	bool parseStream(const std::string &filename);
+	void deduplicateVertices();
+
 	std::vector<Vector3f> vertList;
 	std::vector<Face> faceList;
 };
@@ -14,7 +14,7 @@
 
 #pragma once
 #include <GL/glew.h>
-#include <cuda_gl_interop.h> 
+#include <cuda_gl_interop.h>
 #include "Core/Utility.h"
 
 namespace PhysIKA{
@@ -25,14 +25,16 @@ class CudaVBOMapper
 public:
 	CudaVBOMapper()
 	{
-		m_vbo = 0;
+		m_vbo[0] = m_vbo[1] = m_vbo[2] = 0;
 		m_size = 0;
-		m_cudaGraphicsResource = NULL;
+		m_cudaGraphicsResource[0] = m_cudaGraphicsResource[1] = m_cudaGraphicsResource[2] = NULL;
 	}
 
 
 	CudaVBOMapper(unsigned int num)
 	{
+		m_vbo[0] = m_vbo[1] = m_vbo[2] = 0;
+		m_cudaGraphicsResource[0] = m_cudaGraphicsResource[1] = m_cudaGraphicsResource[2] = NULL;
 		resize(num);
 	}
 
@@ -43,7 +45,35 @@ public:
 	{
 		release();
 	}
-	
+
+	/**
+	 * @brief Back a second VBO so CUDA writes one buffer while GL draws the
+	 * other; see swap(). Must be called before resize().
+	 */
+	void enableDoubleBuffering()
+	{
+		m_doubleBuffered = true;
+	}
+
+	/**
+	 * @brief Ring of three pre-mapped VBOs so no frame pays a map/unmap.
+	 *
+	 * cudaGraphicsMapResources/UnmapResources are synchronizing calls; with
+	 * several render modules their per-frame cost adds up. In this mode the
+	 * buffers rotate through write -> draw -> cooldown: CUDA writes into a
+	 * buffer that stays mapped across frames, the buffer handed to GL is
+	 * unmapped only at rotation (against an idle stream, so the call does
+	 * not stall), and a buffer returns to CUDA once a fence shows GL has
+	 * finished drawing it. swap() keeps the previous draw buffer whenever
+	 * the copy or the fence is still pending, same as double buffering.
+	 * Must be called before resize(); supersedes enableDoubleBuffering().
+	 */
+	void enablePersistentMapping()
+	{
+		m_persistent = true;
+		m_doubleBuffered = false;
+	}
+
 	void resize(unsigned int num)
 	{
 		if (m_size != 0)
@@ -52,19 +82,61 @@ public:
 		}
 
 		m_size = num;
-		glGenBuffers(1, &m_vbo);
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-		glBufferData(GL_ARRAY_BUFFER, m_size * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		cuSafeCall(cudaGraphicsGLRegisterBuffer(&m_cudaGraphicsResource, m_vbo, cudaGraphicsMapFlagsWriteDiscard));
+		int bufNum = m_persistent ? 3 : (m_doubleBuffered ? 2 : 1);
+		for (int i = 0; i < bufNum; i++)
+		{
+			glGenBuffers(1, &m_vbo[i]);
+			glBindBuffer(GL_ARRAY_BUFFER, m_vbo[i]);
+			glBufferData(GL_ARRAY_BUFFER, m_size * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			cuSafeCall(cudaGraphicsGLRegisterBuffer(&m_cudaGraphicsResource[i], m_vbo[i], cudaGraphicsMapFlagsWriteDiscard));
+		}
+
+		if (m_doubleBuffered || m_persistent)
+		{
+			cuSafeCall(cudaEventCreateWithFlags(&m_copyDone, cudaEventDisableTiming));
+		}
+
+		if (m_persistent)
+		{
+			cuSafeCall(cudaStreamCreateWithFlags(&m_mapStream, cudaStreamNonBlocking));
+
+			//the draw buffer starts unmapped, the other two stay mapped
+			m_writeIndex = 0;
+			m_drawIndex = 1;
+			m_coolIndex = 2;
+			mapPersistent(0);
+			mapPersistent(2);
+		}
 	}
 
 	void release()
 	{
-		if (m_vbo != 0)
+		for (int i = 0; i < 3; i++)
+		{
+			if (m_vbo[i] != 0)
+			{
+				glDeleteBuffers(1, &m_vbo[i]);
+				m_vbo[i] = 0;
+			}
+			if (m_drawFence[i] != NULL)
+			{
+				glDeleteSync(m_drawFence[i]);
+				m_drawFence[i] = NULL;
+			}
+			m_mappedPtr[i] = nullptr;
+		}
+		if (m_copyDone != NULL)
 		{
-			glDeleteBuffers(1, &m_vbo);
+			cudaEventDestroy(m_copyDone);
+			m_copyDone = NULL;
+		}
+		if (m_mapStream != 0)
+		{
+			cudaStreamDestroy(m_mapStream);
+			m_mapStream = 0;
 		}
 // 		if (m_cudaGraphicsResource != NULL)
 // 		{
@@ -75,23 +147,67 @@ public:
 
     T* cudaMap()
 	{
-		cuSafeCall(cudaGraphicsMapResources(1, &m_cudaGraphicsResource, 0));
+		if (m_persistent)
+		{
+			//mapped across frames, no API call on the hot path
+			return m_mappedPtr[m_writeIndex];
+		}
+
+		cuSafeCall(cudaGraphicsMapResources(1, &m_cudaGraphicsResource[m_writeIndex], 0));
 
 		T* dataPtr = nullptr;
 		size_t byte_size;
-		cuSafeCall(cudaGraphicsResourceGetMappedPointer((void **)&dataPtr, &byte_size, m_cudaGraphicsResource));
+		cuSafeCall(cudaGraphicsResourceGetMappedPointer((void **)&dataPtr, &byte_size, m_cudaGraphicsResource[m_writeIndex]));
 
 		return dataPtr;
 	}
 
     void cudaUnmap()
 	{
-		cuSafeCall(cudaGraphicsUnmapResources(1, &m_cudaGraphicsResource, 0));
+		if (m_persistent)
+		{
+			cuSafeCall(cudaEventRecord(m_copyDone, 0));
+			return;
+		}
+
+		cuSafeCall(cudaGraphicsUnmapResources(1, &m_cudaGraphicsResource[m_writeIndex], 0));
+
+		if (m_doubleBuffered)
+		{
+			cuSafeCall(cudaEventRecord(m_copyDone, 0));
+		}
+	}
+
+	/**
+	 * @brief Adopt the freshly written buffer for drawing if its copy has
+	 * completed; otherwise keep drawing the previous one. Never blocks.
+	 */
+	void swap()
+	{
+		if (m_persistent)
+		{
+			rotatePersistent();
+			return;
+		}
+
+		if (!m_doubleBuffered)
+		{
+			return;
+		}
+
+		if (cudaEventQuery(m_copyDone) == cudaSuccess)
+		{
+			m_writeIndex = 1 - m_writeIndex;
+		}
 	}
 
 	unsigned int getVBO()
 	{
-		return m_vbo;
+		if (m_persistent)
+		{
+			return m_vbo[m_drawIndex];
+		}
+		return m_doubleBuffered ? m_vbo[1 - m_writeIndex] : m_vbo[0];
 	}
 
 	unsigned int getSize()
@@ -100,9 +216,61 @@ public:
 	}
 
 private:
+	void mapPersistent(int i)
+	{
+		cuSafeCall(cudaGraphicsMapResources(1, &m_cudaGraphicsResource[i], m_mapStream));
+
+		size_t byte_size;
+		cuSafeCall(cudaGraphicsResourceGetMappedPointer((void **)&m_mappedPtr[i], &byte_size, m_cudaGraphicsResource[i]));
+	}
+
+	void rotatePersistent()
+	{
+		//the write buffer is only promoted once its copy has landed
+		if (cudaEventQuery(m_copyDone) != cudaSuccess)
+		{
+			return;
+		}
+
+		//the cooldown buffer returns to CUDA once GL finished drawing it
+		if (m_drawFence[m_coolIndex] != NULL)
+		{
+			GLenum state = glClientWaitSync(m_drawFence[m_coolIndex], 0, 0);
+			if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+			{
+				return;
+			}
+			glDeleteSync(m_drawFence[m_coolIndex]);
+			m_drawFence[m_coolIndex] = NULL;
+		}
+		mapPersistent(m_coolIndex);
+
+		//hand the write buffer to GL; the unmap runs against the idle map
+		//stream and everything queued to it has already completed
+		cuSafeCall(cudaGraphicsUnmapResources(1, &m_cudaGraphicsResource[m_writeIndex], m_mapStream));
+		cuSafeCall(cudaStreamSynchronize(m_mapStream));
+
+		//fence the outgoing draw buffer before it becomes the cooldown
+		m_drawFence[m_drawIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		int write = m_coolIndex;
+		m_coolIndex = m_drawIndex;
+		m_drawIndex = m_writeIndex;
+		m_writeIndex = write;
+	}
+
 	int m_size;
-	unsigned int m_vbo;
-    cudaGraphicsResource * m_cudaGraphicsResource;
+	bool m_doubleBuffered = false;
+	bool m_persistent = false;
+	int m_writeIndex = 0;
+	int m_drawIndex = 1;
+	int m_coolIndex = 2;
+	unsigned int m_vbo[3];
+    cudaGraphicsResource * m_cudaGraphicsResource[3];
+	T* m_mappedPtr[3] = { nullptr, nullptr, nullptr };
+	GLsync m_drawFence[3] = { NULL, NULL, NULL };
+	cudaEvent_t m_copyDone = NULL;
+	cudaStream_t m_mapStream = 0;
 };
 
 
@@ -0,0 +1,224 @@
+/*
+ * @file FluidSurfaceRender.cpp
+ * @Basic screen-space fluid surface render task
+ * @author Xiaowei He
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public
+ * License v2.0. If a copy of the GPL was not distributed with this file, you
+ * can obtain one at: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+
+#include "FluidSurfaceRender.h"
+
+namespace PhysIKA{
+
+static float fluidQuadVertices[] = {
+	// positions
+	-1,  1,
+	1, -1,
+	-1, -1,
+
+	-1,  1,
+	1, -1,
+	1,  1
+};
+
+FluidSurfaceRender::FluidSurfaceRender()
+{
+	m_depthShader.createFromFile("../../Shader/FluidDepth.vs.glsl", "../../Shader/FluidDepth.fs.glsl");
+	m_blurShader.createFromFile("../../Shader/FluidQuad.vs.glsl", "../../Shader/FluidBlur.fs.glsl");
+	m_shadeShader.createFromFile("../../Shader/FluidQuad.vs.glsl", "../../Shader/FluidShade.fs.glsl");
+
+	glGenVertexArrays(1, &quadVAO);
+	glGenBuffers(1, &quadVBO);
+	glBindVertexArray(quadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(fluidQuadVertices), fluidQuadVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+FluidSurfaceRender::~FluidSurfaceRender()
+{
+	if (m_fbo[0] != 0)
+	{
+		glDeleteFramebuffers(2, m_fbo);
+		glDeleteTextures(2, m_depthTex);
+		glDeleteRenderbuffers(1, &m_depthRbo);
+	}
+}
+
+void FluidSurfaceRender::resize(unsigned int num)
+{
+	m_vertVBO.resize(num);
+}
+
+void FluidSurfaceRender::setVertexArray(DeviceArray<float3>& pos)
+{
+	cudaMemcpy(m_vertVBO.cudaMap(), pos.getDataPtr(), sizeof(float3) * pos.size(), cudaMemcpyDeviceToDevice);
+	m_vertVBO.cudaUnmap();
+}
+
+void FluidSurfaceRender::setParticleRadius(float r)
+{
+	m_particle_radius = r;
+}
+
+void FluidSurfaceRender::setFluidColor(glm::vec4 color)
+{
+	m_fluid_color = color;
+}
+
+void FluidSurfaceRender::setSmoothingParams(int iterations, float blurRadius)
+{
+	m_smooth_iters = iterations < 0 ? 0 : iterations;
+	m_blur_radius = blurRadius < 1.0f ? 1.0f : blurRadius;
+}
+
+void FluidSurfaceRender::updateRenderTargets(int width, int height)
+{
+	if (width == m_width && height == m_height)
+	{
+		return;
+	}
+
+	if (m_fbo[0] != 0)
+	{
+		glDeleteFramebuffers(2, m_fbo);
+		glDeleteTextures(2, m_depthTex);
+		glDeleteRenderbuffers(1, &m_depthRbo);
+	}
+
+	glGenTextures(2, m_depthTex);
+	for (int i = 0; i < 2; i++)
+	{
+		glBindTexture(GL_TEXTURE_2D, m_depthTex[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &m_depthRbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthRbo);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(2, m_fbo);
+	for (int i = 0; i < 2; i++)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_depthTex[i], 0);
+		if (i == 0)
+		{
+			//only the splat pass resolves sphere overlaps with a depth test
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRbo);
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	m_width = width;
+	m_height = height;
+}
+
+void FluidSurfaceRender::display()
+{
+	m_vertVBO.swap();
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (viewport[2] <= 0 || viewport[3] <= 0)
+	{
+		return;
+	}
+	updateRenderTargets(viewport[2], viewport[3]);
+
+	GLint prevFbo = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
+
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+
+	//pass 1: splat the particles as sphere impostors, keeping the eye-space
+	//depth of the frontmost sphere per pixel; 0.0 marks the background
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo[0]);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(quadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+	glEnableVertexAttribArray(2);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertVBO.getVBO());
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+	glVertexAttribDivisor(2, 1);
+
+	m_depthShader.enable();
+	m_depthShader.setFloat("sprite_size", m_particle_radius);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, m_vertVBO.getSize());
+	m_depthShader.disable();
+
+	glVertexAttribDivisor(2, 0);
+	glDisableVertexAttribArray(2);
+
+	//pass 2: separable bilateral smoothing, ping-ponging between the two
+	//depth textures; the result always lands back in m_depthTex[0]
+	glDisable(GL_DEPTH_TEST);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_blurShader.enable();
+	m_blurShader.setInt("depth_tex", 0);
+	m_blurShader.setFloat("blur_radius", m_blur_radius);
+	m_blurShader.setFloat("depth_falloff", 1.0f / (3.0f * m_particle_radius));
+	for (int i = 0; i < m_smooth_iters; i++)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo[1]);
+		glBindTexture(GL_TEXTURE_2D, m_depthTex[0]);
+		m_blurShader.setVec2("blur_dir", 1.0f / m_width, 0.0f);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo[0]);
+		glBindTexture(GL_TEXTURE_2D, m_depthTex[1]);
+		m_blurShader.setVec2("blur_dir", 0.0f, 1.0f / m_height);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+	}
+	m_blurShader.disable();
+
+	//pass 3: reconstruct normals from the smoothed depth and shade into the
+	//framebuffer that was bound on entry, writing a matching depth so the
+	//fluid composites correctly with the rest of the scene
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prevFbo);
+	glEnable(GL_DEPTH_TEST);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_BLEND);
+
+	m_shadeShader.enable();
+	m_shadeShader.setInt("depth_tex", 0);
+	m_shadeShader.setVec2("texel_size", 1.0f / m_width, 1.0f / m_height);
+	m_shadeShader.setVec4("fluid_color", m_fluid_color);
+	glBindTexture(GL_TEXTURE_2D, m_depthTex[0]);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	m_shadeShader.disable();
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glPopAttrib();
+}
+
+}//end of namespace PhysIKA
@@ -0,0 +1,125 @@
+#include <GL/glew.h>
+#include "FluidSurfaceRenderModule.h"
+#include "Framework/Topology/PointSet.h"
+#include "Core/Vector.h"
+#include "Framework/Framework/Node.h"
+#include "OpenGLContext.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS(FluidSurfaceRenderModule)
+
+	FluidSurfaceRenderModule::FluidSurfaceRenderModule()
+		: VisualModule()
+		, m_color(Vector3f(0.1f, 0.4f, 0.8f))
+		, m_alpha(0.85f)
+		, m_radius(0.005f)
+		, m_smooth_iters(3)
+		, m_blur_radius(10.0f)
+	{
+	}
+
+	FluidSurfaceRenderModule::~FluidSurfaceRenderModule()
+	{
+	}
+
+	bool FluidSurfaceRenderModule::initializeImpl()
+	{
+		Node* parent = getParent();
+		if (parent == NULL)
+		{
+			Log::sendMessage(Log::Error, "Should insert this module into a node!");
+			return false;
+		}
+
+		auto pSet = TypeInfo::CastPointerDown<PointSet<DataType3f>>(parent->getTopologyModule());
+		if (pSet == nullptr)
+		{
+			Log::sendMessage(Log::Error, "FluidSurfaceRenderModule: The topology module is not supported!");
+			return false;
+		}
+
+		if (!pSet->isInitialized())
+		{
+			pSet->initialize();
+		}
+
+		DeviceArray<float3>* xyz = (DeviceArray<float3>*)&(pSet->getPoints());
+
+		m_surfaceRender = std::make_shared<FluidSurfaceRender>();
+		m_surfaceRender->resize(xyz->size());
+		m_surfaceRender->setParticleRadius(m_radius);
+		m_surfaceRender->setFluidColor(glm::vec4(m_color[0], m_color[1], m_color[2], m_alpha));
+		m_surfaceRender->setSmoothingParams(m_smooth_iters, m_blur_radius);
+
+		return true;
+	}
+
+	void FluidSurfaceRenderModule::updateRenderingContext()
+	{
+		Node* parent = getParent();
+		if (parent == NULL)
+		{
+			Log::sendMessage(Log::Error, "Should insert this module into a node!");
+			return;
+		}
+
+		auto pSet = TypeInfo::CastPointerDown<PointSet<DataType3f>>(parent->getTopologyModule());
+		if (pSet == nullptr)
+		{
+			Log::sendMessage(Log::Error, "FluidSurfaceRenderModule: The topology module is not supported!");
+			return;
+		}
+
+		DeviceArray<float3>* xyz = (DeviceArray<float3>*)&(pSet->getPoints());
+
+		m_surfaceRender->setVertexArray(*xyz);
+	}
+
+	void FluidSurfaceRenderModule::display()
+	{
+		glMatrixMode(GL_MODELVIEW_MATRIX);
+		glPushMatrix();
+
+		glRotatef(m_rotation.x(), m_rotation.y(), m_rotation.z(), m_rotation.w());
+		glTranslatef(m_translation[0], m_translation[1], m_translation[2]);
+		glScalef(m_scale[0], m_scale[1], m_scale[2]);
+
+		m_surfaceRender->display();
+
+		glPopMatrix();
+	}
+
+	void FluidSurfaceRenderModule::setColor(Vector3f color, float alpha)
+	{
+		m_color = color;
+		m_alpha = alpha;
+
+		if (m_surfaceRender != nullptr)
+		{
+			m_surfaceRender->setFluidColor(glm::vec4(m_color[0], m_color[1], m_color[2], m_alpha));
+		}
+	}
+
+	void FluidSurfaceRenderModule::setParticleRadius(float r)
+	{
+		m_radius = r;
+
+		if (m_surfaceRender != nullptr)
+		{
+			m_surfaceRender->setParticleRadius(r);
+		}
+	}
+
+	void FluidSurfaceRenderModule::setSmoothingParams(int iterations, float blurRadius)
+	{
+		m_smooth_iters = iterations;
+		m_blur_radius = blurRadius;
+
+		if (m_surfaceRender != nullptr)
+		{
+			m_surfaceRender->setSmoothingParams(iterations, blurRadius);
+		}
+	}
+
+}
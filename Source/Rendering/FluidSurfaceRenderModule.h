@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Framework/Framework/ModuleVisual.h"
+#include "Rendering/FluidSurfaceRender.h"
+
+namespace PhysIKA
+{
+	/**
+	 * @brief Screen-space fluid surface visualization.
+	 *
+	 * A sibling of PointRenderModule that draws the parent node's particle
+	 * set as a smooth closed surface instead of individual point splats:
+	 * depth splatting, bilateral smoothing and normal reconstruction all
+	 * happen in image space (see FluidSurfaceRender), so no surface mesh
+	 * is ever built and interactive previews skip the marching-cubes
+	 * round-trip entirely.
+	 */
+	class FluidSurfaceRenderModule : public VisualModule
+	{
+		DECLARE_CLASS(FluidSurfaceRenderModule)
+	public:
+		FluidSurfaceRenderModule();
+		~FluidSurfaceRenderModule();
+
+		void display() override;
+
+		void setColor(Vector3f color, float alpha = 0.85f);
+		void setParticleRadius(float r);
+
+		/**
+		 * @brief Bilateral smoothing iterations and half kernel width
+		 * in pixels; more of either gives a flatter surface.
+		 */
+		void setSmoothingParams(int iterations, float blurRadius);
+
+	protected:
+		bool  initializeImpl() override;
+
+		void updateRenderingContext() override;
+
+	private:
+		Vector3f m_color;
+		float m_alpha;
+		float m_radius;
+		int m_smooth_iters;
+		float m_blur_radius;
+
+		std::shared_ptr<FluidSurfaceRender> m_surfaceRender;
+	};
+
+}
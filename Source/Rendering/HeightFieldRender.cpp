@@ -0,0 +1,172 @@
+/*
+ * @file HeightFieldRender.cpp
+ * @Basic GPU-tessellated height field render task
+ * @author Xiaowei He
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public
+ * License v2.0. If a copy of the GPL was not distributed with this file, you
+ * can obtain one at: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+
+#include <GL/glew.h>
+#include <vector>
+
+#include "HeightFieldRender.h"
+#include "gl_utilities.h"
+
+namespace PhysIKA {
+
+//height samples covered by one patch edge; matches the GL-guaranteed
+//maximum tessellation level, so a close-up patch resolves every sample
+static const int PATCH_SAMPLES = 64;
+
+HeightFieldRender::HeightFieldRender()
+{
+	m_shader.createFromFile("../../Shader/HeightField.vs.glsl",
+	                        "../../Shader/HeightField.fs.glsl",
+	                        {},
+	                        "../../Shader/HeightField.tcs.glsl",
+	                        "../../Shader/HeightField.tes.glsl");
+}
+
+HeightFieldRender::~HeightFieldRender()
+{
+	if (m_heightTex != 0)
+		glVerify(glDeleteTextures(1, &m_heightTex));
+	if (m_patchVBO != 0)
+		glVerify(glDeleteBuffers(1, &m_patchVBO));
+	if (m_patchVAO != 0)
+		glVerify(glDeleteVertexArrays(1, &m_patchVAO));
+}
+
+void HeightFieldRender::resize(int nx, int nz)
+{
+	if (nx == m_nx && nz == m_nz)
+		return;
+
+	m_nx = nx;
+	m_nz = nz;
+
+	m_heightBuffer.resize(nx * nz);
+
+	if (m_heightTex == 0)
+		glVerify(glGenTextures(1, &m_heightTex));
+	glVerify(glBindTexture(GL_TEXTURE_2D, m_heightTex));
+	glVerify(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	glVerify(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	glVerify(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	glVerify(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	glVerify(glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, nx, nz, 0, GL_RED, GL_FLOAT, NULL));
+	glVerify(glBindTexture(GL_TEXTURE_2D, 0));
+
+	//coarse patch grid over the samples; the last row/column of patches
+	//is clipped to the field so edge levels can still resolve it fully
+	std::vector<float> corners;
+	for (int pz = 0; pz * PATCH_SAMPLES < nz - 1; pz++)
+	{
+		int z0 = pz * PATCH_SAMPLES;
+		int z1 = z0 + PATCH_SAMPLES < nz - 1 ? z0 + PATCH_SAMPLES : nz - 1;
+		for (int px = 0; px * PATCH_SAMPLES < nx - 1; px++)
+		{
+			int x0 = px * PATCH_SAMPLES;
+			int x1 = x0 + PATCH_SAMPLES < nx - 1 ? x0 + PATCH_SAMPLES : nx - 1;
+
+			corners.push_back((float)x0); corners.push_back((float)z0);
+			corners.push_back((float)x1); corners.push_back((float)z0);
+			corners.push_back((float)x1); corners.push_back((float)z1);
+			corners.push_back((float)x0); corners.push_back((float)z1);
+		}
+	}
+	m_patchVertNum = (int)corners.size() / 2;
+
+	if (m_patchVAO == 0)
+		glVerify(glGenVertexArrays(1, &m_patchVAO));
+	if (m_patchVBO == 0)
+		glVerify(glGenBuffers(1, &m_patchVBO));
+
+	glVerify(glBindVertexArray(m_patchVAO));
+	glVerify(glBindBuffer(GL_ARRAY_BUFFER, m_patchVBO));
+	glVerify(glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(float), corners.data(), GL_STATIC_DRAW));
+	glVerify(glEnableVertexAttribArray(0));
+	glVerify(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0));
+	glVerify(glBindBuffer(GL_ARRAY_BUFFER, 0));
+	glVerify(glBindVertexArray(0));
+}
+
+void HeightFieldRender::setGridInfo(float spacing, glm::vec2 origin)
+{
+	m_spacing = spacing;
+	m_origin = origin;
+}
+
+void HeightFieldRender::setSurfaceColor(glm::vec4 color)
+{
+	m_surface_color = color;
+}
+
+void HeightFieldRender::setLodDistance(float lodDistance)
+{
+	m_lod_distance = lodDistance > 0.0f ? lodDistance : 1.0f;
+}
+
+float* HeightFieldRender::mapHeights()
+{
+	return m_heightBuffer.cudaMap();
+}
+
+void HeightFieldRender::unmapHeights()
+{
+	m_heightBuffer.cudaUnmap();
+	m_heightsDirty = true;
+}
+
+void HeightFieldRender::display()
+{
+	if (m_patchVertNum == 0)
+		return;
+
+	//stream this frame's heights into the texture; the pixels come from
+	//the CUDA-written unpack buffer, so the copy never touches the host
+	if (m_heightsDirty)
+	{
+		glVerify(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_heightBuffer.getVBO()));
+		glVerify(glBindTexture(GL_TEXTURE_2D, m_heightTex));
+		glVerify(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+		glVerify(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_nx, m_nz, GL_RED, GL_FLOAT, 0));
+		glVerify(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		glVerify(glBindTexture(GL_TEXTURE_2D, 0));
+		m_heightsDirty = false;
+	}
+
+	glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
+
+	glEnable(GL_DEPTH_TEST);
+
+	m_shader.enable();
+
+	glVerify(glActiveTexture(GL_TEXTURE0));
+	glVerify(glBindTexture(GL_TEXTURE_2D, m_heightTex));
+	m_shader.setInt("height_tex", 0);
+
+	m_shader.setVec2("origin", m_origin);
+	m_shader.setFloat("spacing", m_spacing);
+	m_shader.setVec2("inv_tex_size", glm::vec2(1.0f / m_nx, 1.0f / m_nz));
+	m_shader.setFloat("lod_scale", m_lod_distance * (float)PATCH_SAMPLES);
+	m_shader.setFloat("max_level", (float)PATCH_SAMPLES);
+	m_shader.setVec4("surface_color", m_surface_color);
+
+	glVerify(glPatchParameteri(GL_PATCH_VERTICES, 4));
+	glVerify(glBindVertexArray(m_patchVAO));
+	glVerify(glDrawArrays(GL_PATCHES, 0, m_patchVertNum));
+	glVerify(glBindVertexArray(0));
+
+	m_shader.disable();
+
+	glPopAttrib();
+}
+
+} // namespace PhysIKA
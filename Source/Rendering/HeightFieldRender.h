@@ -0,0 +1,91 @@
+/*
+ * @file HeightFieldRender.h
+ * @Basic GPU-tessellated height field render task
+ * @author Xiaowei He
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public
+ * License v2.0. If a copy of the GPL was not distributed with this file, you
+ * can obtain one at: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+
+#pragma once
+
+#include "CudaVBOMapper.h"
+#include "ShaderProgram.h"
+
+namespace PhysIKA {
+
+/**
+ * @brief Renders a height field with hardware tessellation.
+ *
+ * The grid is drawn as coarse GL_PATCHES quads covering up to 64x64
+ * height samples each; a tessellation control shader picks a
+ * subdivision level per patch edge from the eye distance of the edge
+ * midpoint, and the evaluation shader displaces the generated vertices
+ * by sampling the height texture. Nothing is meshed on the host: the
+ * only per-frame traffic is the height texture itself, streamed
+ * device-to-device through a CUDA-mapped pixel unpack buffer, so a
+ * 4096x4096 field costs one 64 MB copy instead of 33M host-built
+ * triangles.
+ */
+class HeightFieldRender {
+public:
+	explicit HeightFieldRender();
+	~HeightFieldRender();
+
+	// disable copy
+	HeightFieldRender(const HeightFieldRender &) = delete;
+	HeightFieldRender &operator=(const HeightFieldRender &) = delete;
+
+	/**
+	 * @brief (Re)allocate the height texture, the staging buffer and the
+	 * patch grid for an nx x nz sample field.
+	 */
+	void resize(int nx, int nz);
+
+	void setGridInfo(float spacing, glm::vec2 origin);
+
+	void setSurfaceColor(glm::vec4 color);
+
+	/**
+	 * @brief Distance at which a patch edge still gets the full 64
+	 * segments; levels fall off as lodDistance / eyeDistance below it.
+	 */
+	void setLodDistance(float lodDistance);
+
+	/**
+	 * @brief Device pointer of the staging buffer; copy nx * nz floats
+	 * into it (row-major, x fastest) and call unmapHeights().
+	 */
+	float* mapHeights();
+	void unmapHeights();
+
+	void display();
+
+private:
+	int m_nx = 0;
+	int m_nz = 0;
+	float m_spacing = 0.005f;
+	glm::vec2 m_origin = glm::vec2(0.0f, 0.0f);
+	glm::vec4 m_surface_color = glm::vec4(0.3f, 0.5f, 0.8f, 1.0f);
+	float m_lod_distance = 4.0f;
+
+	//heights staged here by CUDA, consumed as a pixel unpack buffer
+	CudaVBOMapper<float> m_heightBuffer;
+	bool m_heightsDirty = false;
+
+	unsigned int m_heightTex = 0;
+
+	//patch corner positions in height-sample coordinates
+	unsigned int m_patchVAO = 0;
+	unsigned int m_patchVBO = 0;
+	int m_patchVertNum = 0;
+
+	ShaderProgram m_shader;
+};
+
+} // namespace PhysIKA
@@ -0,0 +1,121 @@
+#include <GL/glew.h>
+#include "HeightFieldRenderModule.h"
+#include "Core/Vector.h"
+#include "Framework/Framework/Node.h"
+#include "Dynamics/HeightField/HeightField.h"
+#include "OpenGLContext.h"
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS(HeightFieldRenderModule)
+
+	HeightFieldRenderModule::HeightFieldRenderModule()
+		: VisualModule()
+		, m_color(Vector3f(0.3f, 0.5f, 0.8f))
+		, m_alpha(1.0f)
+		, m_lod_distance(4.0f)
+	{
+	}
+
+	HeightFieldRenderModule::~HeightFieldRenderModule()
+	{
+	}
+
+	bool HeightFieldRenderModule::initializeImpl()
+	{
+		Node* parent = getParent();
+		if (parent == NULL)
+		{
+			Log::sendMessage(Log::Error, "Should insert this module into a node!");
+			return false;
+		}
+
+		auto heightField = dynamic_cast<HeightField<DataType2f>*>(parent);
+		if (heightField == nullptr)
+		{
+			Log::sendMessage(Log::Error, "HeightFieldRenderModule: The parent node is not a height field!");
+			return false;
+		}
+
+		if (heightField->getNx() == 0 || heightField->getNz() == 0)
+		{
+			Log::sendMessage(Log::Error, "HeightFieldRenderModule: The height field is empty, call setExtents() first!");
+			return false;
+		}
+
+		auto origin = heightField->getOrigin();
+
+		m_heightRender = std::make_shared<HeightFieldRender>();
+		m_heightRender->resize(heightField->getNx(), heightField->getNz());
+		m_heightRender->setGridInfo((float)heightField->getGridSpacing(), glm::vec2(origin[0], origin[1]));
+		m_heightRender->setSurfaceColor(glm::vec4(m_color[0], m_color[1], m_color[2], m_alpha));
+		m_heightRender->setLodDistance(m_lod_distance);
+
+		return true;
+	}
+
+	void HeightFieldRenderModule::updateRenderingContext()
+	{
+		Node* parent = getParent();
+		if (parent == NULL)
+		{
+			Log::sendMessage(Log::Error, "Should insert this module into a node!");
+			return;
+		}
+
+		auto heightField = dynamic_cast<HeightField<DataType2f>*>(parent);
+		if (heightField == nullptr)
+		{
+			Log::sendMessage(Log::Error, "HeightFieldRenderModule: The parent node is not a height field!");
+			return;
+		}
+
+		int num = heightField->getNx() * heightField->getNz();
+		if (num == 0)
+		{
+			return;
+		}
+
+		//only the heights travel per frame, device to device through the
+		//renderer's staging buffer
+		float* heights = m_heightRender->mapHeights();
+		cuSafeCall(cudaMemcpy(heights, heightField->getHeights().GetDataPtr(), num * sizeof(float), cudaMemcpyDeviceToDevice));
+		m_heightRender->unmapHeights();
+	}
+
+	void HeightFieldRenderModule::display()
+	{
+		glMatrixMode(GL_MODELVIEW_MATRIX);
+		glPushMatrix();
+
+		glRotatef(m_rotation.x(), m_rotation.y(), m_rotation.z(), m_rotation.w());
+		glTranslatef(m_translation[0], m_translation[1], m_translation[2]);
+		glScalef(m_scale[0], m_scale[1], m_scale[2]);
+
+		m_heightRender->display();
+
+		glPopMatrix();
+	}
+
+	void HeightFieldRenderModule::setColor(Vector3f color, float alpha)
+	{
+		m_color = color;
+		m_alpha = alpha;
+
+		if (m_heightRender != nullptr)
+		{
+			m_heightRender->setSurfaceColor(glm::vec4(m_color[0], m_color[1], m_color[2], m_alpha));
+		}
+	}
+
+	void HeightFieldRenderModule::setLodDistance(float lodDistance)
+	{
+		m_lod_distance = lodDistance;
+
+		if (m_heightRender != nullptr)
+		{
+			m_heightRender->setLodDistance(lodDistance);
+		}
+	}
+
+}
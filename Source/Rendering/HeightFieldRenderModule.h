@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+
+#include "Framework/Framework/ModuleVisual.h"
+#include "Rendering/HeightFieldRender.h"
+
+namespace PhysIKA
+{
+	template<typename TDataType> class HeightField;
+
+	/*!
+	*	\class	HeightFieldRenderModule
+	*	\brief	Adaptive height field visualization with GPU tessellation.
+	*
+	*	Attach to a HeightField node. Instead of dumping a dense triangle
+	*	mesh, the field is drawn as coarse patches whose subdivision is
+	*	decided on the GPU per frame from the eye distance, and the only
+	*	per-frame upload is the height texture itself, copied device to
+	*	device from the node's height array. A 4096 x 4096 field renders
+	*	at full rate this way.
+	*/
+	class HeightFieldRenderModule : public VisualModule
+	{
+		DECLARE_CLASS(HeightFieldRenderModule)
+	public:
+		HeightFieldRenderModule();
+		~HeightFieldRenderModule();
+
+		void display() override;
+
+		void setColor(Vector3f color, float alpha = 1.0f);
+
+		/**
+		 * @brief Eye distance at which a patch edge still tessellates to
+		 * one segment per height sample; detail falls off beyond it.
+		 */
+		void setLodDistance(float lodDistance);
+
+	protected:
+		bool  initializeImpl() override;
+
+		void updateRenderingContext() override;
+
+	private:
+		Vector3f m_color;
+		float m_alpha;
+		float m_lod_distance;
+
+		std::shared_ptr<HeightFieldRender> m_heightRender;
+	};
+
+}
@@ -0,0 +1,81 @@
+/*
+ * @file LineRender.cu
+ * @Basic device-filled line primitives
+ * @author Xiaowei He
+ *
+ * This file is part of PhysIKA, a versatile physics simulation library.
+ * Copyright (C) 2013- PhysIKA Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+ * If a copy of the GPL was not distributed with this file, you can obtain one at:
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+#include <GL/glew.h>
+#include "LineRender.h"
+
+#include "Core/Utility.h"
+
+namespace PhysIKA
+{
+	__global__ void LR_FillVelocityGlyphs(
+		glm::vec3* vert,
+		glm::vec3* color,
+		DeviceArray<float3> pos,
+		DeviceArray<float3> vel,
+		float scale,
+		unsigned int stride,
+		unsigned int glyphNum,
+		glm::vec3 col)
+	{
+		unsigned int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= glyphNum) return;
+
+		unsigned int i = tId * stride;
+
+		float3 p = pos[i];
+		float3 v = vel[i];
+
+		vert[2 * tId] = glm::vec3(p.x, p.y, p.z);
+		vert[2 * tId + 1] = glm::vec3(p.x + scale * v.x, p.y + scale * v.y, p.z + scale * v.z);
+
+		//dim tail, bright tip: the gradient encodes the direction
+		color[2 * tId] = 0.25f * col;
+		color[2 * tId + 1] = col;
+	}
+
+	void LineRender::setVelocityGlyphs(DeviceArray<float3>& pos, DeviceArray<float3>& vel, float scale, unsigned int stride, glm::vec3 color)
+	{
+		stride = stride < 1 ? 1 : stride;
+
+		unsigned int num = (unsigned int)pos.size();
+		unsigned int glyphNum = (num + stride - 1) / stride;
+		if (glyphNum == 0)
+		{
+			return;
+		}
+
+		if (m_vertex.getSize() != 2 * glyphNum)
+		{
+			resize(glyphNum);
+		}
+
+		glm::vec3* vert = m_vertex.cudaMap();
+		glm::vec3* col = m_vertexColor.cudaMap();
+
+		cuint pDims = cudaGridSize(glyphNum, BLOCK_SIZE);
+		LR_FillVelocityGlyphs << <pDims, BLOCK_SIZE >> > (
+			vert,
+			col,
+			pos,
+			vel,
+			scale,
+			stride,
+			glyphNum,
+			color);
+		cuSynchronize();
+
+		m_vertex.cudaUnmap();
+		m_vertexColor.cudaUnmap();
+	}
+}
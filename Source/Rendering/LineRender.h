@@ -39,6 +39,16 @@ public:
 
 	void setColors(HostArray<float3>& color);
 
+	/**
+	 * @brief Device-filled velocity glyphs: a kernel writes the segment
+	 * endpoints (position, position + velocity * scale) straight into the
+	 * mapped vertex VBO, so a glyph per particle costs no host copy at any
+	 * particle count. Every stride-th particle gets a glyph (GPU-side
+	 * decimation); the tail vertex is dimmed so the direction reads from
+	 * dark to bright. Resizes the VBOs to the glyph count.
+	 */
+	void setVelocityGlyphs(DeviceArray<float3>& pos, DeviceArray<float3>& vel, float scale, unsigned int stride, glm::vec3 color);
+
     void setLineWidth(float line_width);
     float getLineWidth() const;
 
@@ -1,5 +1,11 @@
 #include "OpenGLContext.h"
 
+#include <iostream>
+
+#ifdef PHYSIKA_USE_EGL
+#include <EGL/egl.h>
+#endif
+
 namespace PhysIKA
 {
 	OpenGLContext& OpenGLContext::getInstance()
@@ -24,6 +30,129 @@ namespace PhysIKA
 		m_initialized = true;
 		return m_initialized;
 	}
-}
 
+	bool OpenGLContext::initializeOffscreen(int width, int height)
+	{
+		if (m_initialized)
+		{
+			return true;
+		}
+
+#ifndef PHYSIKA_USE_EGL
+		std::cerr << "error: PhysIKA was built without EGL, offscreen rendering is not available!" << std::endl;
+		return false;
+#else
+		EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (display == EGL_NO_DISPLAY)
+		{
+			std::cerr << "error: no EGL display available!" << std::endl;
+			return false;
+		}
+
+		EGLint major = 0, minor = 0;
+		if (!eglInitialize(display, &major, &minor))
+		{
+			std::cerr << "error: failed to initialize EGL!" << std::endl;
+			return false;
+		}
+
+		const EGLint configAttribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+
+		EGLConfig config;
+		EGLint numConfigs = 0;
+		if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+		{
+			std::cerr << "error: no matching EGL config!" << std::endl;
+			eglTerminate(display);
+			return false;
+		}
+
+		const EGLint pbufferAttribs[] = {
+			EGL_WIDTH, width,
+			EGL_HEIGHT, height,
+			EGL_NONE
+		};
+
+		EGLSurface surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+		if (surface == EGL_NO_SURFACE)
+		{
+			std::cerr << "error: failed to create EGL pbuffer surface!" << std::endl;
+			eglTerminate(display);
+			return false;
+		}
+
+		eglBindAPI(EGL_OPENGL_API);
+
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+		if (context == EGL_NO_CONTEXT)
+		{
+			std::cerr << "error: failed to create EGL context!" << std::endl;
+			eglDestroySurface(display, surface);
+			eglTerminate(display);
+			return false;
+		}
+
+		if (!eglMakeCurrent(display, surface, surface, context))
+		{
+			std::cerr << "error: failed to make EGL context current!" << std::endl;
+			eglDestroyContext(display, context);
+			eglDestroySurface(display, surface);
+			eglTerminate(display);
+			return false;
+		}
+
+		glewExperimental = GL_TRUE;
+		if (glewInit() != GLEW_OK)
+		{
+			std::cerr << "error: glewInit failed on the offscreen context!" << std::endl;
+			destroyOffscreen();
+			return false;
+		}
+
+		m_eglDisplay = display;
+		m_eglContext = context;
+		m_eglSurface = surface;
+		m_offscreen = true;
+		m_initialized = true;
+		return true;
+#endif
+	}
+
+	void OpenGLContext::destroyOffscreen()
+	{
+#ifdef PHYSIKA_USE_EGL
+		if (!m_offscreen)
+		{
+			return;
+		}
+
+		EGLDisplay display = (EGLDisplay)m_eglDisplay;
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_eglContext != nullptr)
+		{
+			eglDestroyContext(display, (EGLContext)m_eglContext);
+		}
+		if (m_eglSurface != nullptr)
+		{
+			eglDestroySurface(display, (EGLSurface)m_eglSurface);
+		}
+		eglTerminate(display);
+
+		m_eglDisplay = nullptr;
+		m_eglContext = nullptr;
+		m_eglSurface = nullptr;
+		m_offscreen = false;
+		m_initialized = false;
+#endif
+	}
+}
 
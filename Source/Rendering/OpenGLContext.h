@@ -11,7 +11,21 @@ public:
 	static OpenGLContext& getInstance();
 
 	bool initialize();
+
+	/**
+	 * @brief Create a headless GL context on an EGL pbuffer and make it
+	 * current on the calling thread, so rendering works without any
+	 * window system (farm nodes, CI). Only available when the library
+	 * was built with EGL support (PHYSIKA_USE_EGL); returns false
+	 * otherwise or when no EGL device is present.
+	 */
+	bool initializeOffscreen(int width, int height);
+
+	//! Tear down the offscreen context created by initializeOffscreen().
+	void destroyOffscreen();
+
 	bool isInitialized() { return m_initialized; }
+	bool isOffscreen() { return m_offscreen; }
 
 private:
 	explicit OpenGLContext() { m_initialized = false; }
@@ -21,8 +35,14 @@ private:
 	~OpenGLContext() {};
 
 
-	
+
 	bool m_initialized;
+	bool m_offscreen = false;
+
+	//EGL handles, kept as void* so EGL types stay out of this header
+	void* m_eglDisplay = nullptr;
+	void* m_eglContext = nullptr;
+	void* m_eglSurface = nullptr;
 };
 
-}
\ No newline at end of file
+}
@@ -180,13 +180,83 @@ void PointRender::resize(unsigned int num)
 
 }
 
+void PointRender::enableDoubleBuffering()
+{
+	double_buffered_ = true;
+	m_vertVBO.enableDoubleBuffering();
+	m_vertexColor.enableDoubleBuffering();
+}
+
+void PointRender::enablePersistentMapping()
+{
+	persistent_ = true;
+	double_buffered_ = false;
+	m_vertVBO.enablePersistentMapping();
+	m_vertexColor.enablePersistentMapping();
+}
+
 int id = 0;
 void PointRender::setVertexArray(DeviceArray<float3>& pos)
 {
+	active_num_ = 0xffffffff;
+
+	if (double_buffered_ || persistent_)
+	{
+		//the copy targets the back buffer; cudaUnmap records the completion
+		//event the render pass handshakes on before adopting it
+		cudaMemcpyAsync(m_vertVBO.cudaMap(), pos.getDataPtr(), sizeof(float3) * pos.size(), cudaMemcpyDeviceToDevice, 0);
+		m_vertVBO.cudaUnmap();
+		return;
+	}
+
 	cudaMemcpy(m_vertVBO.cudaMap(), pos.getDataPtr(), sizeof(float3) * pos.size(), cudaMemcpyDeviceToDevice);
 	m_vertVBO.cudaUnmap();
 }
 
+void PointRender::setVertexArray(DeviceArray<float3>& pos, unsigned int num)
+{
+	setActiveCount(num);
+	if (num == 0)
+	{
+		return;
+	}
+
+	if (double_buffered_ || persistent_)
+	{
+		cudaMemcpyAsync(m_vertVBO.cudaMap(), pos.getDataPtr(), sizeof(float3) * num, cudaMemcpyDeviceToDevice, 0);
+		m_vertVBO.cudaUnmap();
+		return;
+	}
+
+	cudaMemcpy(m_vertVBO.cudaMap(), pos.getDataPtr(), sizeof(float3) * num, cudaMemcpyDeviceToDevice);
+	m_vertVBO.cudaUnmap();
+}
+
+void PointRender::setColor(DeviceArray<glm::vec3> color, unsigned int num)
+{
+	setActiveCount(num);
+	if (num == 0)
+	{
+		return;
+	}
+
+	if (double_buffered_ || persistent_)
+	{
+		cudaMemcpyAsync(m_vertexColor.cudaMap(), color.getDataPtr(), sizeof(glm::vec3) * num, cudaMemcpyDeviceToDevice, 0);
+		m_vertexColor.cudaUnmap();
+		return;
+	}
+
+	cudaMemcpy(m_vertexColor.cudaMap(), color.getDataPtr(), sizeof(glm::vec3) * num, cudaMemcpyDeviceToDevice);
+	m_vertexColor.cudaUnmap();
+}
+
+unsigned int PointRender::drawCount() const
+{
+	unsigned int size = const_cast<CudaVBOMapper<glm::vec3>&>(m_vertVBO).getSize();
+	return active_num_ < size ? active_num_ : size;
+}
+
 void PointRender::setVertexArray(HostArray<float3>& pos)
 {
 	cudaMemcpy(m_vertVBO.cudaMap(), pos.getDataPtr(), sizeof(float3) * pos.size(), cudaMemcpyDeviceToHost);
@@ -195,6 +265,13 @@ void PointRender::setVertexArray(HostArray<float3>& pos)
 
 void PointRender::setColorArray(DeviceArray<float3>& color)
 {
+	if (double_buffered_ || persistent_)
+	{
+		cudaMemcpyAsync(m_vertexColor.cudaMap(), color.getDataPtr(), sizeof(float3) * color.size(), cudaMemcpyDeviceToDevice, 0);
+		m_vertexColor.cudaUnmap();
+		return;
+	}
+
 	cudaMemcpy(m_vertexColor.cudaMap(), color.getDataPtr(), sizeof(float3) * color.size(), cudaMemcpyDeviceToDevice);
 	m_vertexColor.cudaUnmap();
 }
@@ -266,6 +343,9 @@ bool PointRender::isUsePointSprite() const
 
 void PointRender::renderInstancedSphere()
 {
+	m_vertVBO.swap();
+	m_vertexColor.swap();
+
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_BLEND);
 
@@ -288,7 +368,7 @@ void PointRender::renderInstancedSphere()
 	m_instancedShader.setFloat("sprite_size", m_instance_size);
 
 	glBindVertexArray(quadVAO);
-	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, m_vertVBO.getSize()); // 100 triangles of 6 vertices each
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, drawCount()); // 100 triangles of 6 vertices each
 	glBindVertexArray(0);
 
 	m_instancedShader.disable();
@@ -298,6 +378,9 @@ void PointRender::renderInstancedSphere()
 
 void PointRender::renderSprite()
 {
+	m_vertVBO.swap();
+	m_vertexColor.swap();
+
 	m_glsl.enable();
 
 	Matrix4f idenity = Matrix4f::identityMatrix();
@@ -327,7 +410,7 @@ void PointRender::renderSprite()
 	glBindBuffer(GL_ARRAY_BUFFER, m_vertVBO.getVBO());
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glVertexPointer(3, GL_FLOAT, 0, 0);
-	glDrawArrays(GL_POINTS, 0, m_vertVBO.getSize());
+	glDrawArrays(GL_POINTS, 0, drawCount());
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glDisableClientState(GL_VERTEX_ARRAY);
 
@@ -336,6 +419,9 @@ void PointRender::renderSprite()
 
 void PointRender::renderPoints()
 {
+	m_vertVBO.swap();
+	m_vertexColor.swap();
+
 	m_glsl.enable();
 
 	Matrix4f idenity = Matrix4f::identityMatrix();
@@ -356,7 +442,7 @@ void PointRender::renderPoints()
 	glBindBuffer(GL_ARRAY_BUFFER, m_vertVBO.getVBO());
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glVertexPointer(3, GL_FLOAT, 0, 0);
-	glDrawArrays(GL_POINTS, 0, m_vertVBO.getSize());
+	glDrawArrays(GL_POINTS, 0, drawCount());
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glDisableClientState(GL_VERTEX_ARRAY);
 
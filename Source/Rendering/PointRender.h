@@ -34,9 +34,39 @@ public:
 
 	void resize(unsigned int num);
 
+	/**
+	 * @brief Double-buffer the vertex and color VBOs: the simulation copies
+	 * into the back buffer while GL draws the front one, and the render pass
+	 * adopts a back buffer only once its copy event has completed. Call
+	 * before resize().
+	 */
+	void enableDoubleBuffering();
+
+	/**
+	 * @brief Keep the VBO ring persistently mapped: no map/unmap call on the
+	 * per-frame path at all, buffers rotate through write/draw/cooldown with
+	 * fence sync (see CudaVBOMapper::enablePersistentMapping). Call before
+	 * resize(); supersedes enableDoubleBuffering().
+	 */
+	void enablePersistentMapping();
+
 	void setVertexArray(DeviceArray<float3> &pos);
 	void setVertexArray(HostArray<float3> &pos);
 
+	/**
+	 * @brief Upload only the first num positions/colors (a compacted
+	 * subset) and draw that many; see setActiveCount().
+	 */
+	void setVertexArray(DeviceArray<float3> &pos, unsigned int num);
+	void setColor(DeviceArray<glm::vec3> color, unsigned int num);
+
+	/**
+	 * @brief Restrict the draw calls to the first num points of the VBO;
+	 * pass the full size to reset. Used by the culling/LOD pre-pass that
+	 * compacts visible points to the front of the buffer.
+	 */
+	void setActiveCount(unsigned int num) { active_num_ = num; }
+
 	void setColorArray(DeviceArray<float3> &color);
 	void setColorArray(HostArray<float3> &color);
 
@@ -60,6 +90,11 @@ public:
 
 private:
 	bool use_point_sprite_ = true;
+	bool double_buffered_ = false;
+	bool persistent_ = false;
+
+	unsigned int drawCount() const;
+	unsigned int active_num_ = 0xffffffff;
 
 	float m_instance_size = 0.0025f;
 
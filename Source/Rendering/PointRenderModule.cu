@@ -59,6 +59,14 @@ namespace PhysIKA
 		DeviceArray<float3>* xyz = (DeviceArray<float3>*)&(pSet->getPoints());
 
 		m_pointRender = std::make_shared<PointRender>();
+		if (m_persistentMapping)
+		{
+			m_pointRender->enablePersistentMapping();
+		}
+		else if (m_doubleBuffered)
+		{
+			m_pointRender->enableDoubleBuffering();
+		}
 		m_pointRender->resize(xyz->size());
 		m_colorArray.resize(xyz->size());
 
@@ -122,6 +130,94 @@ namespace PhysIKA
 		color[tId] = glm::vec3(hsv.r, hsv.g, hsv.b);
 	}
 
+	//view frustum in world space, rows of the (previous frame's) MVP
+	struct PRM_Frustum
+	{
+		float4 plane[6];
+		float4 wrow;
+	};
+
+	static void PRM_ExtractFrustum(const glm::mat4& mvp, PRM_Frustum& frustum)
+	{
+		//glm is column major: row r, column c is mvp[c][r]
+		float4 rows[4];
+		for (int r = 0; r < 4; r++)
+		{
+			rows[r] = make_float4(mvp[0][r], mvp[1][r], mvp[2][r], mvp[3][r]);
+		}
+
+		for (int a = 0; a < 3; a++)
+		{
+			frustum.plane[2 * a + 0] = make_float4(rows[3].x + rows[a].x, rows[3].y + rows[a].y, rows[3].z + rows[a].z, rows[3].w + rows[a].w);
+			frustum.plane[2 * a + 1] = make_float4(rows[3].x - rows[a].x, rows[3].y - rows[a].y, rows[3].z - rows[a].z, rows[3].w - rows[a].w);
+		}
+		frustum.wrow = rows[3];
+	}
+
+	__global__ void PRM_CullLod(
+		DeviceArray<int> flags,
+		DeviceArray<float4> pos,
+		PRM_Frustum frustum,
+		float lodScale,
+		float margin)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= pos.size()) return;
+
+		float4 p = pos[tId];
+
+		float w = frustum.wrow.x * p.x + frustum.wrow.y * p.y + frustum.wrow.z * p.z + frustum.wrow.w;
+		float absw = fabs(w);
+
+		for (int i = 0; i < 6; i++)
+		{
+			float d = frustum.plane[i].x * p.x + frustum.plane[i].y * p.y + frustum.plane[i].z * p.z + frustum.plane[i].w;
+			if (d < -margin * absw)
+			{
+				flags[tId] = 0;
+				return;
+			}
+		}
+
+		//keep probability falls off as 1/w^2: the expected number of drawn
+		//points per screen area stays roughly constant with distance
+		absw = absw < 1.0e-3f ? 1.0e-3f : absw;
+		float keep = lodScale / (absw * absw);
+		if (keep < 1.0f)
+		{
+			//the per-point sequence is deterministic, so the kept subset is
+			//temporally stable at a fixed scale
+			RandNumber rGen(tId);
+			if (rGen.Generate() > keep)
+			{
+				flags[tId] = 0;
+				return;
+			}
+		}
+
+		flags[tId] = 1;
+	}
+
+	__global__ void PRM_CompactVisible(
+		DeviceArray<float3> dstPos,
+		DeviceArray<glm::vec3> dstColor,
+		DeviceArray<float4> pos,
+		DeviceArray<glm::vec3> color,
+		DeviceArray<int> flags,
+		DeviceArray<int> offsets)
+	{
+		int tId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (tId >= pos.size()) return;
+
+		if (flags[tId] == 0) return;
+
+		float4 p = pos[tId];
+
+		int dst = offsets[tId];
+		dstPos[dst] = make_float3(p.x, p.y, p.z);
+		dstColor[dst] = color[tId];
+	}
+
 	void PointRenderModule::updateRenderingContext()
 	{
 		Node* parent = getParent();
@@ -139,7 +235,8 @@ namespace PhysIKA
 		}
 
 		DeviceArray<float3>* xyz = (DeviceArray<float3>*)&(pSet->getPoints());
-		
+
+		bool colorMapped = false;
 		if (!m_vecIndex.isEmpty())
 		{
 			uint pDims = cudaGridSize(xyz->size(), BLOCK_SIZE);
@@ -150,7 +247,7 @@ namespace PhysIKA
 				m_maxIndex.getValue());
 			cuSynchronize();
 
-			m_pointRender->setColor(m_colorArray);
+			colorMapped = true;
 		}
 		else if (!m_scalarIndex.isEmpty())
 		{
@@ -163,6 +260,95 @@ namespace PhysIKA
 				m_maxIndex.getValue());
 			cuSynchronize();
 
+			colorMapped = true;
+		}
+
+		//velocity glyph overlay, filled on device; see showVelocityGlyphs
+		if (m_glyphs_enabled && !m_vecIndex.isEmpty())
+		{
+			if (m_lineRender == nullptr)
+			{
+				m_lineRender = std::make_shared<LineRender>();
+			}
+
+			m_lineRender->setVelocityGlyphs(
+				*xyz,
+				*(DeviceArray<float3>*)&m_vecIndex.getValue(),
+				m_glyph_scale,
+				m_glyph_stride,
+				glm::vec3(1.0f, 0.8f, 0.2f));
+		}
+
+		int num = xyz->size();
+		if (m_lod_enabled && m_has_mvp && num > 0)
+		{
+			if (m_lod_flags.size() != num)
+			{
+				m_lod_flags.resize(num);
+				m_lod_offsets.resize(num);
+				m_packed_pos.resize(num);
+				m_culled_pos.resize(num);
+				m_culled_color.resize(num);
+			}
+
+			//aligned mirror: both passes below gather positions, so pack
+			//them once into float4 and read vector loads from then on
+			FunctionPack::pack(m_packed_pos, *xyz);
+
+			PRM_Frustum frustum;
+			PRM_ExtractFrustum(m_last_mvp, frustum);
+
+			uint pDims = cudaGridSize(num, BLOCK_SIZE);
+			PRM_CullLod << <pDims, BLOCK_SIZE >> > (
+				m_lod_flags,
+				m_packed_pos,
+				frustum,
+				m_lod_scale,
+				0.05f);
+
+			m_scan.exclusive(m_lod_offsets, m_lod_flags);
+
+			int lastFlag = 0;
+			int lastOffset = 0;
+			cuSafeCall(cudaMemcpy(&lastFlag, m_lod_flags.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+			cuSafeCall(cudaMemcpy(&lastOffset, m_lod_offsets.getDataPtr() + num - 1, sizeof(int), cudaMemcpyDeviceToHost));
+			int visible = lastFlag + lastOffset;
+
+			PRM_CompactVisible << <pDims, BLOCK_SIZE >> > (
+				m_culled_pos,
+				m_culled_color,
+				m_packed_pos,
+				m_colorArray,
+				m_lod_flags,
+				m_lod_offsets);
+			cuSynchronize();
+
+			//converge the drawn count to the budget: shrink hard when over,
+			//recover slowly when the view empties out again
+			if ((unsigned int)visible > m_screen_budget)
+			{
+				m_lod_scale *= (float)m_screen_budget / (float)visible;
+			}
+			else if ((unsigned int)visible < m_screen_budget * 9 / 10 && m_lod_scale < 1.0e12f)
+			{
+				m_lod_scale *= 1.05f;
+			}
+
+			if (colorMapped)
+			{
+				m_pointRender->setColor(m_culled_color, (unsigned int)visible);
+			}
+			else
+			{
+				m_pointRender->setColor(glm::vec3(m_color[0], m_color[1], m_color[2]));
+			}
+			m_pointRender->setVertexArray(m_culled_pos, (unsigned int)visible);
+
+			return;
+		}
+
+		if (colorMapped)
+		{
 			m_pointRender->setColor(m_colorArray);
 		}
 		else
@@ -170,10 +356,9 @@ namespace PhysIKA
 			m_pointRender->setColor(glm::vec3(m_color[0], m_color[1], m_color[2]));
 		}
 
-		
 		//if (m_colorArray)
 		//	m_pointRender->setColorArray(*(DeviceArray<float3>*)m_colorArray.get());
-		
+
 		m_pointRender->setVertexArray(*xyz);
 	}
 
@@ -186,6 +371,18 @@ namespace PhysIKA
 		glTranslatef(m_translation[0], m_translation[1], m_translation[2]);
 		glScalef(m_scale[0], m_scale[1], m_scale[2]);
 
+		if (m_lod_enabled)
+		{
+			//the camera is applied by now; the matrices feed the next
+			//frame's culling pre-pass
+			glm::mat4 mvMat;
+			glm::mat4 projMat;
+			glGetFloatv(GL_MODELVIEW_MATRIX, &mvMat[0][0]);
+			glGetFloatv(GL_PROJECTION_MATRIX, &projMat[0][0]);
+			m_last_mvp = projMat * mvMat;
+			m_has_mvp = true;
+		}
+
  		//m_pointRender->display();
 
 		switch (m_mode)
@@ -202,6 +399,11 @@ namespace PhysIKA
 			break;
 		}
 
+		if (m_glyphs_enabled && m_lineRender != nullptr)
+		{
+			m_lineRender->display();
+		}
+
 		glPopMatrix();
 	}
 
@@ -6,6 +6,7 @@
 #include "Rendering/TriangleRender.h"
 #include "Framework/Framework/FieldArray.h"
 #include "Framework/Framework/FieldVar.h"
+#include "Core/Utility/Scan.h"
 
 namespace PhysIKA
 {
@@ -29,6 +30,60 @@ namespace PhysIKA
 		void setColorRange(float min, float max);
 		void setReferenceColor(float v);
 
+		/**
+		 * @brief Double-buffer the underlying VBOs so the position copy never
+		 * stalls the simulation; the draw adopts a new buffer only after its
+		 * copy event completes. Call before the module is initialized.
+		 */
+		void setDoubleBuffered(bool enabled) { m_doubleBuffered = enabled; }
+
+		/**
+		 * @brief Keep the VBOs persistently mapped in a ring of three so no
+		 * frame pays a cudaGraphicsMapResources/Unmap call; with several
+		 * render modules active those synchronizing calls dominate the
+		 * render thread. Supersedes double buffering. Call before the
+		 * module is initialized.
+		 */
+		void setPersistentMapping(bool enabled) { m_persistentMapping = enabled; }
+
+		/**
+		 * @brief GPU culling/LOD pre-pass for very large particle counts.
+		 *
+		 * Before upload, a kernel drops points outside the view frustum and
+		 * stochastically decimates the rest with a keep probability falling
+		 * off as 1/w^2 of the clip-space depth, which keeps the projected
+		 * point density roughly uniform on screen. Survivors are stream
+		 * compacted (via Scan) to the front of the VBO and only they are
+		 * drawn. A feedback loop rescales the keep probability so the
+		 * number of drawn points converges to screenBudget. The frustum is
+		 * taken from the previous frame's matrices (the pre-pass runs
+		 * before the camera is applied), so culling lags the camera by one
+		 * frame; the plane margin absorbs small motions.
+		 */
+		void enableLod(bool enabled, unsigned int screenBudget = 1000000)
+		{
+			m_lod_enabled = enabled;
+			m_screen_budget = screenBudget < 1 ? 1 : screenBudget;
+		}
+
+		/**
+		 * @brief Velocity glyph overlay for field inspection.
+		 *
+		 * Draws a line segment from every stride-th particle along its
+		 * vector field value scaled by scale, on top of the points. The
+		 * segments are written by a kernel straight into the line VBO
+		 * (LineRender::setVelocityGlyphs), so the overlay works at millions
+		 * of particles; raise stride to thin it out. The vectors are taken
+		 * from m_vecIndex - connect the velocity field there, as done for
+		 * velocity-based coloring.
+		 */
+		void showVelocityGlyphs(bool enabled, float scale = 0.02f, unsigned int stride = 1)
+		{
+			m_glyphs_enabled = enabled;
+			m_glyph_scale = scale;
+			m_glyph_stride = stride < 1 ? 1 : stride;
+		}
+
 	public:
 		VarField<float> m_minIndex;
 		VarField<float> m_maxIndex;
@@ -44,11 +99,33 @@ namespace PhysIKA
 	private:
 		RenderMode m_mode;
 		Vector3f m_color;
+		bool m_doubleBuffered = false;
+		bool m_persistentMapping = false;
 
 		float m_refV;
 
 		DeviceArray<glm::vec3> m_colorArray;
 
+		//velocity glyph overlay; see showVelocityGlyphs
+		bool m_glyphs_enabled = false;
+		float m_glyph_scale = 0.02f;
+		unsigned int m_glyph_stride = 1;
+
+		//culling/LOD pre-pass state; see enableLod
+		bool m_lod_enabled = false;
+		unsigned int m_screen_budget = 1000000;
+		float m_lod_scale = 1.0e12f;    //keep-probability scale, adapted by feedback
+		bool m_has_mvp = false;
+		glm::mat4 m_last_mvp;
+		Scan m_scan;
+		DeviceArray<int> m_lod_flags;
+		DeviceArray<int> m_lod_offsets;
+		//16-byte aligned mirror of the positions so the culling pre-pass
+		//reads one vector load per point instead of three scalar loads
+		DeviceArray<float4> m_packed_pos;
+		DeviceArray<float3> m_culled_pos;
+		DeviceArray<glm::vec3> m_culled_color;
+
 // 		std::shared_ptr<PointRenderUtil> point_render_util;
 // 		std::shared_ptr<PointRenderTask> point_render_task;
 		std::shared_ptr<PointRender> m_pointRender;
@@ -0,0 +1,151 @@
+/*
+* @file RenderStateCache.cpp
+* @Brief Class RenderStateCache used to filter redundant openGL state changes
+* @author Wei Chen
+*
+* This file is part of PhysIKA, a versatile physics simulation library.
+* Copyright (C) 2013- PhysIKA Group.
+*
+* This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+* If a copy of the GPL was not distributed with this file, you can obtain one at:
+* http://www.gnu.org/licenses/gpl-2.0.html
+*
+*/
+
+#include "GlewHelper.h"
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "RenderStateCache.h"
+
+namespace PhysIKA {
+
+static const unsigned int CAMERA_BINDING_POINT = 0;
+static const unsigned int LIGHTING_BINDING_POINT = 1;
+
+RenderStateCache & RenderStateCache::instance()
+{
+    static RenderStateCache cache;
+    return cache;
+}
+
+bool RenderStateCache::useProgram(unsigned int program)
+{
+    if (program == this->cur_program_)
+    {
+        this->redundant_binds_++;
+        return false;
+    }
+
+    glVerify(glUseProgram(program));
+    this->cur_program_ = program;
+    return true;
+}
+
+bool RenderStateCache::bindVertexArray(unsigned int vao)
+{
+    if (vao == this->cur_vao_)
+    {
+        this->redundant_binds_++;
+        return false;
+    }
+
+    glVerify(glBindVertexArray(vao));
+    this->cur_vao_ = vao;
+    return true;
+}
+
+void RenderStateCache::notifyProgramDeleted(unsigned int program)
+{
+    if (program == this->cur_program_)
+        this->cur_program_ = 0xffffffff;
+}
+
+void RenderStateCache::notifyVertexArrayDeleted(unsigned int vao)
+{
+    if (vao == this->cur_vao_)
+        this->cur_vao_ = 0xffffffff;
+}
+
+void RenderStateCache::invalidate()
+{
+    this->cur_program_ = 0xffffffff;
+    this->cur_vao_ = 0xffffffff;
+    this->camera_valid_ = false;
+}
+
+void RenderStateCache::ensureBuffers()
+{
+    if (this->camera_ubo_ != 0)
+        return;
+
+    //CameraTransforms: modelview, projection, modelview-projection
+    glVerify(glGenBuffers(1, &this->camera_ubo_));
+    glVerify(glBindBuffer(GL_UNIFORM_BUFFER, this->camera_ubo_));
+    glVerify(glBufferData(GL_UNIFORM_BUFFER, 3 * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW));
+    glVerify(glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING_POINT, this->camera_ubo_));
+
+    //LightingData: light direction, light color, ambient
+    glVerify(glGenBuffers(1, &this->lighting_ubo_));
+    glVerify(glBindBuffer(GL_UNIFORM_BUFFER, this->lighting_ubo_));
+    glVerify(glBufferData(GL_UNIFORM_BUFFER, 3 * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW));
+    glVerify(glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTING_BINDING_POINT, this->lighting_ubo_));
+
+    glVerify(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+void RenderStateCache::updateCameraFromGL()
+{
+    this->ensureBuffers();
+
+    glm::mat4 model_view;
+    glm::mat4 proj;
+    glVerify(glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(model_view)));
+    glVerify(glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(proj)));
+
+    if (this->camera_valid_ &&
+        std::memcmp(glm::value_ptr(model_view), glm::value_ptr(this->cached_model_view_), sizeof(glm::mat4)) == 0 &&
+        std::memcmp(glm::value_ptr(proj), glm::value_ptr(this->cached_proj_), sizeof(glm::mat4)) == 0)
+    {
+        this->redundant_binds_++;
+        return;
+    }
+
+    this->cached_model_view_ = model_view;
+    this->cached_proj_ = proj;
+    this->camera_valid_ = true;
+
+    glm::mat4 mvp = proj * model_view;
+
+    glVerify(glBindBuffer(GL_UNIFORM_BUFFER, this->camera_ubo_));
+    glVerify(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(model_view)));
+    glVerify(glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(proj)));
+    glVerify(glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(mvp)));
+    glVerify(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+void RenderStateCache::setLighting(const glm::vec4 & light_dir, const glm::vec4 & light_color, const glm::vec4 & ambient)
+{
+    this->ensureBuffers();
+
+    glm::vec4 data[3] = { light_dir, light_color, ambient };
+
+    glVerify(glBindBuffer(GL_UNIFORM_BUFFER, this->lighting_ubo_));
+    glVerify(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), data));
+    glVerify(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+}
+
+void RenderStateCache::bindUniformBlocks(unsigned int program)
+{
+    this->ensureBuffers();
+
+    GLuint camera_idx = glGetUniformBlockIndex(program, "CameraTransforms");
+    if (camera_idx != GL_INVALID_INDEX)
+        glVerify(glUniformBlockBinding(program, camera_idx, CAMERA_BINDING_POINT));
+
+    GLuint lighting_idx = glGetUniformBlockIndex(program, "LightingData");
+    if (lighting_idx != GL_INVALID_INDEX)
+        glVerify(glUniformBlockBinding(program, lighting_idx, LIGHTING_BINDING_POINT));
+}
+
+}// end of namespace PhysIKA
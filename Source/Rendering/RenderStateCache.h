@@ -0,0 +1,99 @@
+/*
+* @file RenderStateCache.h
+* @Brief Class RenderStateCache used to filter redundant openGL state changes
+* @author Wei Chen
+*
+* This file is part of PhysIKA, a versatile physics simulation library.
+* Copyright (C) 2013- PhysIKA Group.
+*
+* This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+* If a copy of the GPL was not distributed with this file, you can obtain one at:
+* http://www.gnu.org/licenses/gpl-2.0.html
+*
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace PhysIKA {
+
+/*
+ * RenderStateCache is a thin layer between the render modules and the GL
+ * driver that drops redundant state changes. With many render module
+ * instances active per frame, most glUseProgram / glBindVertexArray calls
+ * and many uniform updates re-set the value that is already bound, and
+ * the driver-side validation of those calls ends up costing more than
+ * the GPU work itself. ShaderProgram routes its program binds and
+ * uniform updates through this cache; render tasks can do the same for
+ * their vertex array binds.
+ *
+ * The cache also owns two uniform buffer objects for data shared by all
+ * shaders of a frame (camera matrices and lighting), so shaders that
+ * declare the matching uniform blocks receive them with one upload per
+ * frame instead of one set of glUniform calls per draw.
+ *
+ * A counter keeps track of how many GL calls were skipped; it can be
+ * polled (and reset) per frame to judge how much driver overhead the
+ * cache removes.
+ *
+ * If GL state is changed behind the cache's back, call invalidate().
+ */
+class RenderStateCache
+{
+public:
+    static RenderStateCache & instance();
+
+    // disable copy
+    RenderStateCache(const RenderStateCache & rhs) = delete;
+    RenderStateCache & operator = (const RenderStateCache & rhs) = delete;
+
+    //deduplicated binds; each returns true when the GL call was actually issued
+    bool useProgram(unsigned int program);
+    bool bindVertexArray(unsigned int vao);
+
+    //! A deleted object id may be recycled by GL, so forget it if it is the cached one.
+    void notifyProgramDeleted(unsigned int program);
+    void notifyVertexArrayDeleted(unsigned int vao);
+
+    //! Drop all cached state, e.g. after GL was driven directly.
+    void invalidate();
+
+    /*
+     * Shared per-frame data. updateCameraFromGL() snapshots the fixed
+     * function modelview/projection matrices into the CameraTransforms
+     * uniform block (binding point 0); setLighting() fills the
+     * LightingData block (binding point 1). bindUniformBlocks() wires a
+     * program's blocks of those names to the binding points once after
+     * linking.
+     */
+    void updateCameraFromGL();
+    void setLighting(const glm::vec4 & light_dir, const glm::vec4 & light_color, const glm::vec4 & ambient);
+    void bindUniformBlocks(unsigned int program);
+
+    //! Number of GL bind/uniform calls skipped since the last reset.
+    unsigned long long redundantBindCount() const { return redundant_binds_; }
+    void resetCounters() { redundant_binds_ = 0; }
+
+    //! Used by ShaderProgram when its own uniform value cache skips a call.
+    void countRedundantBind() { redundant_binds_++; }
+
+private:
+    RenderStateCache() = default;
+
+    void ensureBuffers();
+
+    //0xffffffff means unknown, so the first bind always goes through
+    unsigned int cur_program_ = 0xffffffff;
+    unsigned int cur_vao_ = 0xffffffff;
+
+    unsigned int camera_ubo_ = 0;
+    unsigned int lighting_ubo_ = 0;
+
+    glm::mat4 cached_model_view_;
+    glm::mat4 cached_proj_;
+    bool camera_valid_ = false;
+
+    unsigned long long redundant_binds_ = 0;
+};
+
+} // end of namespace PhysIKA
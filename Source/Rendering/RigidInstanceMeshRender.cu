@@ -0,0 +1,197 @@
+#pragma once
+#include <GL/glew.h>
+#include "RigidInstanceMeshRender.h"
+#include "Framework/Topology/TriangleSet.h"
+#include "Core/Vector.h"
+#include "Framework/Framework/Node.h"
+#include "Core/Utility.h"
+#include "Dynamics/RigidBody/RigidBody2.h"
+#include "OpenGLContext.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+
+namespace PhysIKA
+{
+	IMPLEMENT_CLASS(RigidInstanceMeshRender)
+
+	RigidInstanceMeshRender::RigidInstanceMeshRender()
+		: VisualModule()
+		, m_color(Vector3f(0.2f, 0.3, 0.0f))
+	{
+	}
+
+	__global__ void SetupInstancedTriangles(
+		DeviceArray<float3> originVerts,
+		DeviceArray<float3> vertices,
+		DeviceArray<float3> normals,
+		DeviceArray<TopologyModule::Triangle> triangles
+	)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= triangles.size()) return;
+
+		TopologyModule::Triangle tri = triangles[pId];
+		float3 v1 = originVerts[tri[0]];
+		float3 v2 = originVerts[tri[1]];
+		float3 v3 = originVerts[tri[2]];
+
+		vertices[3 * pId + 0] = v1;
+		vertices[3 * pId + 1] = v2;
+		vertices[3 * pId + 2] = v3;
+
+		float3 triN = cross(v2 - v1, v3 - v1);
+		triN = normalize(triN);
+
+		normals[3 * pId + 0] = triN;
+		normals[3 * pId + 1] = triN;
+		normals[3 * pId + 2] = triN;
+	}
+
+	RigidInstanceMeshRender::~RigidInstanceMeshRender()
+	{
+		vertices.release();
+		normals.release();
+	}
+
+	void RigidInstanceMeshRender::collectBodies(std::vector<RigidBody2<DataType3f>*>& bodies)
+	{
+		Node* parent = getParent();
+		if (parent == NULL)
+		{
+			return;
+		}
+
+		std::vector<Node*> stack;
+		stack.push_back(parent);
+		while (!stack.empty())
+		{
+			Node* node = stack.back();
+			stack.pop_back();
+
+			auto body = dynamic_cast<RigidBody2<DataType3f>*>(node);
+			if (body != nullptr)
+			{
+				bodies.push_back(body);
+			}
+
+			auto children = node->getChildren();
+			for (auto it = children.begin(); it != children.end(); it++)
+			{
+				stack.push_back(it->get());
+			}
+		}
+	}
+
+	bool RigidInstanceMeshRender::initializeImpl()
+	{
+		Node* parent = getParent();
+		if (parent == NULL)
+		{
+			Log::sendMessage(Log::Error, "Should insert this module into a node!");
+			return false;
+		}
+
+		std::vector<RigidBody2<DataType3f>*> bodies;
+		collectBodies(bodies);
+		if (bodies.empty())
+		{
+			Log::sendMessage(Log::Error, "RigidInstanceMeshRender: no rigid body found below this node!");
+			return false;
+		}
+
+		//the first body's mesh becomes the shared one; the other bodies
+		//reuse it with their size and scale folded into the instance matrix
+		auto triSet = TypeInfo::CastPointerDown<TriangleSet<DataType3f>>(bodies[0]->getTopologyModule());
+		if (triSet == nullptr)
+		{
+			Log::sendMessage(Log::Error, "RigidInstanceMeshRender: The topology module is not supported!");
+			return false;
+		}
+
+		auto triangles = triSet->getTriangles();
+
+		m_instanceRender = std::make_shared<RigidInstanceRender>();
+		m_instanceRender->resizeMesh(triangles->size());
+		m_instanceRender->resizeInstances((unsigned int)bodies.size());
+
+		vertices.resize(3 * triangles->size());
+		normals.resize(3 * triangles->size());
+
+		{
+			auto verts = triSet->getPoints();
+			uint pDims = cudaGridSize(triangles->size(), BLOCK_SIZE);
+			DeviceArray<float3>* fverts = (DeviceArray<float3>*) & verts;
+			SetupInstancedTriangles << <pDims, BLOCK_SIZE >> > (*fverts, vertices, normals, *triangles);
+
+			m_instanceRender->setVertexArray(vertices);
+			m_instanceRender->setNormalArray(normals);
+		}
+
+		for (unsigned int i = 0; i < bodies.size(); i++)
+		{
+			m_instanceRender->setInstanceColor(i, glm::vec3(m_color[0], m_color[1], m_color[2]));
+		}
+
+		updateRenderingContext();
+
+		return true;
+	}
+
+	void RigidInstanceMeshRender::updateRenderingContext()
+	{
+		if (m_instanceRender == nullptr)
+		{
+			return;
+		}
+
+		std::vector<RigidBody2<DataType3f>*> bodies;
+		collectBodies(bodies);
+		if (bodies.empty())
+		{
+			return;
+		}
+
+		Vector3f refSize = bodies[0]->getGeometrySize() * (float)bodies[0]->getGlobalScale();
+
+		for (unsigned int i = 0; i < bodies.size(); i++)
+		{
+			RigidBody2<DataType3f>* body = bodies[i];
+
+			float ran;
+			Vector3f axis;
+			body->getGlobalQ().toRotationAxis(ran, axis);
+
+			Vector3f t = body->getGlobalR() * (float)body->getGlobalScale();
+			Vector3f size = body->getGeometrySize() * (float)body->getGlobalScale();
+
+			glm::mat4 mat(1.0);
+			mat = glm::translate(mat, glm::vec3(t[0], t[1], t[2]));
+			mat = glm::rotate(mat, ran, glm::vec3(axis[0], axis[1], axis[2]));
+			mat = glm::scale(mat, glm::vec3(size[0] / refSize[0], size[1] / refSize[1], size[2] / refSize[2]));
+
+			//unchanged matrices are filtered out and never re-uploaded
+			m_instanceRender->setInstanceTransform(i, mat);
+		}
+	}
+
+	void RigidInstanceMeshRender::display()
+	{
+		glMatrixMode(GL_MODELVIEW_MATRIX);
+		glPushMatrix();
+
+		glRotatef(m_rotation.x(), m_rotation.y(), m_rotation.z(), m_rotation.w());
+		glTranslatef(m_translation[0], m_translation[1], m_translation[2]);
+		glScalef(m_scale[0], m_scale[1], m_scale[2]);
+
+		m_instanceRender->display();
+
+		glPopMatrix();
+	}
+
+	void RigidInstanceMeshRender::setColor(Vector3f color)
+	{
+		m_color = color;
+	}
+
+}
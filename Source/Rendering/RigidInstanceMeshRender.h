@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Framework/Framework/ModuleVisual.h"
+#include "Rendering/RigidInstanceRender.h"
+
+#include <vector>
+
+namespace PhysIKA
+{
+	template<typename TDataType> class RigidBody2;
+
+	/*!
+	*	\class	RigidInstanceMeshRender
+	*	\brief	Draws a whole rigid body tree in one instanced call.
+	*
+	*	Attach to the root of a RigidBody2 hierarchy instead of one render
+	*	module per body: the shared mesh is uploaded once and every body
+	*	contributes only a model matrix (and a color) to a per-instance
+	*	buffer, drawn with a single instanced call per frame. Bodies that
+	*	did not move upload nothing, so large mostly-resting scenes stop
+	*	being draw-call-bound.
+	*
+	*	All bodies are assumed to share the same base mesh (RigidBody2
+	*	loads the standard cube); per-body sizes and scales are folded
+	*	into the instance matrices relative to the first body found.
+	*/
+	class RigidInstanceMeshRender : public VisualModule
+	{
+		DECLARE_CLASS(RigidInstanceMeshRender)
+	public:
+		RigidInstanceMeshRender();
+		~RigidInstanceMeshRender();
+
+		void display() override;
+		void setColor(Vector3f color);
+
+	protected:
+		bool  initializeImpl() override;
+
+		void updateRenderingContext() override;
+
+	private:
+		void collectBodies(std::vector<RigidBody2<DataType3f>*>& bodies);
+
+		Vector3f m_color;
+
+		DeviceArray<float3> vertices;
+		DeviceArray<float3> normals;
+
+		std::shared_ptr<RigidInstanceRender> m_instanceRender;
+	};
+
+}
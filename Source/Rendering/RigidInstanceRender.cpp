@@ -0,0 +1,282 @@
+/*
+ * @file rigid_instance_render.cpp
+ * @Basic instanced render task of rigid meshes
+ * @author Wei Chen, Xiaowei He
+ *
+ * This file is part of Physika, a versatile physics simulation library.
+ * Copyright (C) 2013- Physika Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+ * If a copy of the GPL was not distributed with this file, you can obtain one at:
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+
+#include <GL/glew.h>
+#include "RigidInstanceRender.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <cstring>
+
+namespace PhysIKA {
+
+	static const char * rigid_instance_render_vertex_shader = R"STR(
+#version 330
+
+layout(location = 0) in vec3 VertexPosition;
+layout(location = 1) in vec3 VertexNormal;
+layout(location = 2) in vec3 InstanceColor;
+layout(location = 3) in mat4 InstanceMat;
+
+out vec3 LightIntensity;
+out vec3 outVertexColor;
+
+struct LightInfo
+{
+	vec4 Position; //ligth position in eye coords
+	vec3 La; //ambient light intensity
+	vec3 Ld; //diffuse light intensity
+	vec3 Ls; // specular light intensity
+};
+uniform LightInfo Light;
+
+struct MaterialInfo
+{
+	vec3 Ka; // ambient reflectivity
+	vec3 Kd; // diffuse reflectivity
+	vec3 Ks; // specular reflectivity
+	float Shininess; // specular shininess factor
+};
+uniform MaterialInfo Material;
+
+uniform bool bDoubleShading;
+uniform mat4 ModelViewMatrix;
+uniform mat3 NormalMatrix;
+uniform mat4 MVP;
+
+
+void main()
+{
+	vec4 worldPos = InstanceMat * vec4(VertexPosition, 1.0);
+	vec3 tnorm = normalize(NormalMatrix * (mat3(InstanceMat) * VertexNormal));
+	vec4 eyeCoords = ModelViewMatrix * worldPos;
+	vec3 s = normalize(vec3(Light.Position - eyeCoords));
+	vec3 v = normalize(-eyeCoords.xyz);
+	vec3 r = reflect(-s, tnorm);
+	float sDotN = dot(s, tnorm);
+	if(bDoubleShading)
+		sDotN = abs(sDotN);
+	else
+		sDotN = max(0.0, dot(s, tnorm));
+	vec3 ambient = Light.La * Material.Ka;
+	vec3 diffuse = Light.Ld * Material.Ka * sDotN;
+	vec3 spec = vec3(0.0);
+	if (sDotN > 0.0)
+	{
+		spec = Light.Ls * Material.Ks *
+			pow(max(0.0, dot(r, v)), Material.Shininess);
+	}
+	LightIntensity = ambient + diffuse + spec;
+
+	gl_Position = MVP * worldPos;
+	outVertexColor = InstanceColor;
+})STR";
+
+static const char * rigid_instance_render_frag_shader = R"STR(
+	#version 330
+
+	in vec3 LightIntensity;
+	in vec3 outVertexColor;
+
+	layout(location = 0) out vec4 FragColor;
+
+	void main()
+	{
+		FragColor = vec4(LightIntensity*outVertexColor, 1.0);
+	}
+	)STR";
+
+
+RigidInstanceRender::RigidInstanceRender()
+{
+	m_solidShader.createFromCStyleString(rigid_instance_render_vertex_shader, rigid_instance_render_frag_shader);
+}
+
+RigidInstanceRender::~RigidInstanceRender()
+{
+	if (m_instanceVBO != 0)
+	{
+		glDeleteBuffers(1, &m_instanceVBO);
+		m_instanceVBO = 0;
+	}
+	if (m_instanceColorVBO != 0)
+	{
+		glDeleteBuffers(1, &m_instanceColorVBO);
+		m_instanceColorVBO = 0;
+	}
+}
+
+void RigidInstanceRender::setVertexArray(DeviceArray<float3>& vertArray)
+{
+	cudaMemcpy(m_vertVBO.cudaMap(), vertArray.getDataPtr(), sizeof(float3) * m_vertVBO.getSize(), cudaMemcpyDeviceToDevice);
+	m_vertVBO.cudaUnmap();
+}
+
+void RigidInstanceRender::setNormalArray(DeviceArray<float3>& normArray)
+{
+	cudaMemcpy(m_normVBO.cudaMap(), normArray.getDataPtr(), sizeof(float3) * m_normVBO.getSize(), cudaMemcpyDeviceToDevice);
+	m_normVBO.cudaUnmap();
+}
+
+void RigidInstanceRender::resizeMesh(unsigned int triNum)
+{
+	m_vertVBO.resize(3 * triNum);
+	m_normVBO.resize(3 * triNum);
+}
+
+void RigidInstanceRender::resizeInstances(unsigned int instanceNum)
+{
+	m_transforms.assign(instanceNum, glm::mat4(1.0f));
+	m_colors.assign(instanceNum, glm::vec3(1.0f));
+
+	if (m_instanceVBO == 0)
+	{
+		glGenBuffers(1, &m_instanceVBO);
+		glGenBuffers(1, &m_instanceColorVBO);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, instanceNum * sizeof(glm::mat4), m_transforms.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceColorVBO);
+	glBufferData(GL_ARRAY_BUFFER, instanceNum * sizeof(glm::vec3), m_colors.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_dirtyLo = -1;
+	m_dirtyHi = -1;
+}
+
+void RigidInstanceRender::setInstanceTransform(unsigned int i, const glm::mat4& mat)
+{
+	if (i >= m_transforms.size() || std::memcmp(&m_transforms[i], &mat, sizeof(glm::mat4)) == 0)
+	{
+		return;
+	}
+	m_transforms[i] = mat;
+	if (m_dirtyLo < 0 || (int)i < m_dirtyLo) m_dirtyLo = (int)i;
+	if ((int)i > m_dirtyHi) m_dirtyHi = (int)i;
+}
+
+void RigidInstanceRender::setInstanceColor(unsigned int i, const glm::vec3& color)
+{
+	if (i >= m_colors.size() || std::memcmp(&m_colors[i], &color, sizeof(glm::vec3)) == 0)
+	{
+		return;
+	}
+	m_colors[i] = color;
+	if (m_dirtyLo < 0 || (int)i < m_dirtyLo) m_dirtyLo = (int)i;
+	if ((int)i > m_dirtyHi) m_dirtyHi = (int)i;
+}
+
+void RigidInstanceRender::enableDoubleShading()
+{
+	m_bEnableDoubleShading = true;
+}
+
+void RigidInstanceRender::disableDoubleShading()
+{
+	m_bEnableDoubleShading = false;
+}
+
+void RigidInstanceRender::uploadDirtyRange()
+{
+	if (m_dirtyLo < 0)
+	{
+		return;
+	}
+
+	int num = m_dirtyHi - m_dirtyLo + 1;
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferSubData(GL_ARRAY_BUFFER, m_dirtyLo * sizeof(glm::mat4), num * sizeof(glm::mat4), &m_transforms[m_dirtyLo]);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceColorVBO);
+	glBufferSubData(GL_ARRAY_BUFFER, m_dirtyLo * sizeof(glm::vec3), num * sizeof(glm::vec3), &m_colors[m_dirtyLo]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_dirtyLo = -1;
+	m_dirtyHi = -1;
+}
+
+void RigidInstanceRender::display()
+{
+	unsigned int instanceNum = (unsigned int)m_transforms.size();
+	if (instanceNum == 0 || m_vertVBO.getSize() == 0)
+	{
+		return;
+	}
+
+	uploadDirtyRange();
+
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+
+	m_solidShader.enable();
+
+	glm::mat4 mvMat;
+	glm::mat3 normMat;
+	glm::mat4 projMat;
+	glGetFloatv(GL_MODELVIEW_MATRIX, &mvMat[0][0]);
+	glGetFloatv(GL_PROJECTION_MATRIX, &projMat[0][0]);
+	normMat = glm::mat3(glm::vec3(mvMat[0]), glm::vec3(mvMat[1]), glm::vec3(mvMat[2]));
+	m_solidShader.setMat4("ModelViewMatrix", mvMat);
+	m_solidShader.setMat3("NormalMatrix", normMat);
+	m_solidShader.setMat4("MVP", projMat * mvMat);
+	m_solidShader.setBool("bDoubleShading", m_bEnableDoubleShading);
+
+	glm::vec4  worldLight = glm::vec4(-5.0f, 5.0f, 2.0f, 1.0f);
+	m_solidShader.setVec3("Material.Kd", 0.9f, 0.5f, 0.3f);
+	m_solidShader.setVec3("Light.Ld", 1.0f, 1.0f, 1.0f);
+	m_solidShader.setVec4("Light.Position", mvMat*worldLight);
+	m_solidShader.setVec3("Material.Ka", 0.9f, 0.5f, 0.3f);
+	m_solidShader.setVec3("Light.La", 0.4f, 0.4f, 0.4f);
+	m_solidShader.setVec3("Material.Ks", 0.8f, 0.8f, 0.8f);
+	m_solidShader.setVec3("Light.Ls", 1.0f, 1.0f, 1.0f);
+	m_solidShader.setFloat("Material.Shininess", 100.0f);
+
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertVBO.getVBO());
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, m_normVBO.getVBO());
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+	glEnableVertexAttribArray(2);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceColorVBO);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+	glVertexAttribDivisor(2, 1);
+
+	//a mat4 attribute occupies four consecutive locations
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	for (int c = 0; c < 4; c++)
+	{
+		glEnableVertexAttribArray(3 + c);
+		glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(c * sizeof(glm::vec4)));
+		glVertexAttribDivisor(3 + c, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawArraysInstanced(GL_TRIANGLES, 0, m_vertVBO.getSize(), instanceNum);
+
+	for (int c = 0; c < 4; c++)
+	{
+		glVertexAttribDivisor(3 + c, 0);
+		glDisableVertexAttribArray(3 + c);
+	}
+	glVertexAttribDivisor(2, 0);
+	glDisableVertexAttribArray(2);
+	glDisableVertexAttribArray(1);
+	glDisableVertexAttribArray(0);
+
+	m_solidShader.disable();
+
+	glPopAttrib();
+}
+
+}//end of namespace Physika
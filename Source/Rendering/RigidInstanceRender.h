@@ -0,0 +1,88 @@
+/*
+ * @file rigid_instance_render.h
+ * @Basic instanced render task of rigid meshes
+ * @author Wei Chen, Xiaowei He
+ *
+ * This file is part of Physika, a versatile physics simulation library.
+ * Copyright (C) 2013- Physika Group.
+ *
+ * This Source Code Form is subject to the terms of the GNU General Public License v2.0.
+ * If a copy of the GPL was not distributed with this file, you can obtain one at:
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "CudaVBOMapper.h"
+#include <Core/Array/Array.h>
+#include "ShaderProgram.h"
+
+namespace PhysIKA {
+
+/*
+ * RigidInstanceRender draws one mesh many times in a single call: the
+ * triangle soup of the shared mesh lives in one pair of VBOs and every
+ * instance contributes a model matrix and a color through instanced
+ * vertex attributes (divisor 1). Per-instance data keeps a host shadow
+ * copy; setInstanceTransform/setInstanceColor only mark an instance
+ * dirty when its value actually changed, and display() uploads a single
+ * coalesced range, so a mostly-resting scene uploads almost nothing.
+ */
+class RigidInstanceRender
+{
+public:
+    explicit RigidInstanceRender();
+    ~RigidInstanceRender();
+
+    //disable copy
+    RigidInstanceRender(const RigidInstanceRender &) = delete;
+    RigidInstanceRender & operator = (const RigidInstanceRender &) = delete;
+
+	/**
+	 * @brief Upload the shared triangle soup; resizeMesh must have been
+	 * called with the matching triangle count.
+	 */
+	void setVertexArray(DeviceArray<float3>& vertArray);
+	void setNormalArray(DeviceArray<float3>& normArray);
+
+	void resizeMesh(unsigned int triNum);
+	void resizeInstances(unsigned int instanceNum);
+
+	/**
+	 * @brief Set an instance's model matrix (column major, glm layout);
+	 * no-op when the value is unchanged, otherwise widens the dirty range
+	 * uploaded by the next display().
+	 */
+	void setInstanceTransform(unsigned int i, const glm::mat4& mat);
+	void setInstanceColor(unsigned int i, const glm::vec3& color);
+
+	void enableDoubleShading();
+	void disableDoubleShading();
+
+    void display();
+
+private:
+	void uploadDirtyRange();
+
+	bool m_bEnableDoubleShading = true;
+
+	ShaderProgram m_solidShader;
+
+	CudaVBOMapper<glm::vec3> m_vertVBO;
+	CudaVBOMapper<glm::vec3> m_normVBO;
+
+	unsigned int m_instanceVBO = 0;      //mat4 per instance
+	unsigned int m_instanceColorVBO = 0; //vec3 per instance
+
+	std::vector<glm::mat4> m_transforms;
+	std::vector<glm::vec3> m_colors;
+
+	//inclusive dirty instance range, -1 when clean
+	int m_dirtyLo = -1;
+	int m_dirtyHi = -1;
+};
+
+}
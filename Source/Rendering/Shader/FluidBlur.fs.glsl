@@ -0,0 +1,41 @@
+#version 330 compatibility
+out vec4 FragColor;
+
+in vec2 tex_coord;
+
+uniform sampler2D depth_tex;
+uniform vec2 blur_dir;       //one texel along x or y; the filter is separable
+uniform float blur_radius;   //half kernel width in texels
+uniform float depth_falloff; //range weight; larger values preserve silhouettes
+
+void main()
+{
+    float center = texture(depth_tex, tex_coord).x;
+    if (center >= 0.0)
+    {
+        FragColor = vec4(center, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    float sum = 0.0;
+    float wsum = 0.0;
+    for (float x = -blur_radius; x <= blur_radius; x += 1.0)
+    {
+        float sample_z = texture(depth_tex, tex_coord + x * blur_dir).x;
+        if (sample_z >= 0.0) continue;  //never smooth across the background
+
+        float r = x / blur_radius;
+        float w = exp(-r * r * 4.0);
+
+        float dz = (sample_z - center) * depth_falloff;
+        float g = exp(-dz * dz);
+
+        sum += sample_z * w * g;
+        wsum += w * g;
+    }
+
+    if (wsum > 0.0) sum /= wsum;
+    else sum = center;
+
+    FragColor = vec4(sum, 0.0, 0.0, 1.0);
+}
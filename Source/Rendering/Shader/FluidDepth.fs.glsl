@@ -0,0 +1,30 @@
+#version 330 compatibility
+out vec4 FragColor;
+
+in vec3 frag_pos;
+in vec2 tex_coord;
+in float out_sprite_size;
+
+void main()
+{
+    vec3 normal;
+    normal.xy = tex_coord;
+    float radius = dot(normal.xy, normal.xy);
+    if (radius > 1.0) discard;
+    normal.z = sqrt(1.0 - radius);
+
+    //eye-space depth of the sphere surface; the background keeps the
+    //clear value 0.0 (visible fluid always has negative eye-space z)
+    float eye_z = frag_pos.z + out_sprite_size * normal.z;
+    FragColor = vec4(eye_z, 0.0, 0.0, 1.0);
+
+    float far=gl_DepthRange.far;
+    float near=gl_DepthRange.near;
+
+    vec4 clip_space_pos = gl_ProjectionMatrix * vec4(frag_pos.xy, eye_z, 1.0);
+
+    float ndc_depth = clip_space_pos.z / clip_space_pos.w;
+
+    float depth = (((far-near) * ndc_depth) + near + far) / 2.0;
+    gl_FragDepth = depth;
+}
@@ -0,0 +1,10 @@
+#version 330 compatibility
+layout (location = 0) in vec2 corner;
+
+out vec2 tex_coord;
+
+void main()
+{
+    tex_coord = corner * 0.5 + 0.5;
+    gl_Position = vec4(corner, 0.0, 1.0);
+}
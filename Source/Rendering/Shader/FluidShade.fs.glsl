@@ -0,0 +1,66 @@
+#version 330 compatibility
+out vec4 FragColor;
+
+in vec2 tex_coord;
+
+uniform sampler2D depth_tex;
+uniform vec2 texel_size;
+uniform vec4 fluid_color;
+
+//reconstruct the eye-space position of a texel from its window coordinate
+//and the smoothed eye-space depth, inverting the projection analytically
+vec3 eyePos(vec2 uv, float eye_z)
+{
+    vec2 ndc = uv * 2.0 - 1.0;
+    float x = -eye_z * (ndc.x + gl_ProjectionMatrix[2][0]) / gl_ProjectionMatrix[0][0];
+    float y = -eye_z * (ndc.y + gl_ProjectionMatrix[2][1]) / gl_ProjectionMatrix[1][1];
+    return vec3(x, y, eye_z);
+}
+
+void main()
+{
+    float eye_z = texture(depth_tex, tex_coord).x;
+    if (eye_z >= 0.0) discard;  //background; the splat pass cleared to 0.0
+
+    vec3 pos = eyePos(tex_coord, eye_z);
+
+    //screen-space derivatives; take the smaller difference on each axis so
+    //normals stay clean across silhouette edges
+    float zx1 = texture(depth_tex, tex_coord + vec2(texel_size.x, 0.0)).x;
+    float zx0 = texture(depth_tex, tex_coord - vec2(texel_size.x, 0.0)).x;
+    vec3 ddx = eyePos(tex_coord + vec2(texel_size.x, 0.0), zx1) - pos;
+    vec3 ddx2 = pos - eyePos(tex_coord - vec2(texel_size.x, 0.0), zx0);
+    if (abs(ddx2.z) < abs(ddx.z)) ddx = ddx2;
+
+    float zy1 = texture(depth_tex, tex_coord + vec2(0.0, texel_size.y)).x;
+    float zy0 = texture(depth_tex, tex_coord - vec2(0.0, texel_size.y)).x;
+    vec3 ddy = eyePos(tex_coord + vec2(0.0, texel_size.y), zy1) - pos;
+    vec3 ddy2 = pos - eyePos(tex_coord - vec2(0.0, texel_size.y), zy0);
+    if (abs(ddy2.z) < abs(ddy.z)) ddy = ddy2;
+
+    vec3 normal = normalize(cross(ddx, ddy));
+    if (normal.z < 0.0) normal = -normal;
+
+    vec3 light_dir = vec3(0.577, 0.577, 0.577);
+    vec3 view_dir = normalize(-pos);
+    vec3 half_dir = normalize(light_dir + view_dir);
+
+    float diffuse = max(dot(light_dir, normal), 0.0);
+    float specular = pow(max(dot(half_dir, normal), 0.0), 64.0);
+
+    //Schlick approximation; grazing angles lighten like a water surface
+    float fresnel = 0.02 + 0.98 * pow(1.0 - max(dot(view_dir, normal), 0.0), 5.0);
+
+    vec3 color = fluid_color.rgb * (0.2 + 0.8 * diffuse) + vec3(specular) + fresnel * vec3(0.1);
+    FragColor = vec4(color, fluid_color.a);
+
+    float far=gl_DepthRange.far;
+    float near=gl_DepthRange.near;
+
+    vec4 clip_space_pos = gl_ProjectionMatrix * vec4(pos, 1.0);
+
+    float ndc_depth = clip_space_pos.z / clip_space_pos.w;
+
+    float depth = (((far-near) * ndc_depth) + near + far) / 2.0;
+    gl_FragDepth = depth;
+}
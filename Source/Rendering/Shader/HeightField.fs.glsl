@@ -0,0 +1,24 @@
+#version 400 compatibility
+
+in vec3 te_normal;
+in vec3 te_eye_pos;
+
+uniform vec4 surface_color;
+
+void main()
+{
+    vec3 normal = normalize(gl_NormalMatrix * te_normal);
+    if (normal.z < 0.0)
+        normal = -normal;
+
+    vec3 light_dir = normalize(vec3(0.2, 1.0, 0.3));
+    light_dir = normalize(gl_NormalMatrix * light_dir);
+    vec3 view_dir = normalize(-te_eye_pos);
+
+    float diffuse = max(dot(normal, light_dir), 0.0);
+    vec3 half_vec = normalize(light_dir + view_dir);
+    float spec = pow(max(dot(normal, half_vec), 0.0), 32.0);
+
+    vec3 color = surface_color.rgb * (0.25 + 0.75 * diffuse) + vec3(0.2) * spec;
+    gl_FragColor = vec4(color, surface_color.a);
+}
@@ -0,0 +1,44 @@
+#version 400 compatibility
+
+layout (vertices = 4) out;
+
+in vec2 v_grid[];
+out vec2 tc_grid[];
+
+uniform sampler2D height_tex;
+uniform vec2 origin;
+uniform float spacing;
+uniform vec2 inv_tex_size;
+uniform float lod_scale;    //tess level ~ lod_scale / eye distance
+uniform float max_level;
+
+//tessellation level for one patch edge, from the eye distance of the
+//displaced edge midpoint
+float edgeLevel(vec2 g0, vec2 g1)
+{
+    vec2 mid = 0.5 * (g0 + g1);
+    float h = texture(height_tex, (mid + 0.5) * inv_tex_size).r;
+    vec3 world = vec3(origin.x + mid.x * spacing, h, origin.y + mid.y * spacing);
+    float dist = max(length(vec3(gl_ModelViewMatrix * vec4(world, 1.0))), 1e-3);
+    //also never exceed one segment per height sample on this edge
+    float samples = max(abs(g1.x - g0.x), abs(g1.y - g0.y));
+    return clamp(lod_scale / dist, 1.0, min(max_level, samples));
+}
+
+void main()
+{
+    tc_grid[gl_InvocationID] = v_grid[gl_InvocationID];
+
+    if (gl_InvocationID == 0)
+    {
+        //levels are a function of the shared corner pair only, so
+        //neighbouring patches split their common edge identically and
+        //the mesh stays crack free
+        gl_TessLevelOuter[0] = edgeLevel(v_grid[0], v_grid[3]);
+        gl_TessLevelOuter[1] = edgeLevel(v_grid[0], v_grid[1]);
+        gl_TessLevelOuter[2] = edgeLevel(v_grid[1], v_grid[2]);
+        gl_TessLevelOuter[3] = edgeLevel(v_grid[3], v_grid[2]);
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
@@ -0,0 +1,34 @@
+#version 400 compatibility
+
+layout (quads, fractional_even_spacing, ccw) in;
+
+in vec2 tc_grid[];
+
+out vec3 te_normal;
+out vec3 te_eye_pos;
+
+uniform sampler2D height_tex;
+uniform vec2 origin;
+uniform float spacing;
+uniform vec2 inv_tex_size;
+
+void main()
+{
+    vec2 g = mix(mix(tc_grid[0], tc_grid[1], gl_TessCoord.x),
+                 mix(tc_grid[3], tc_grid[2], gl_TessCoord.x),
+                 gl_TessCoord.y);
+    vec2 uv = (g + 0.5) * inv_tex_size;
+
+    float h = texture(height_tex, uv).r;
+
+    //central-difference normal from the height texture
+    float hx0 = texture(height_tex, uv - vec2(inv_tex_size.x, 0.0)).r;
+    float hx1 = texture(height_tex, uv + vec2(inv_tex_size.x, 0.0)).r;
+    float hz0 = texture(height_tex, uv - vec2(0.0, inv_tex_size.y)).r;
+    float hz1 = texture(height_tex, uv + vec2(0.0, inv_tex_size.y)).r;
+    te_normal = normalize(vec3(hx0 - hx1, 2.0 * spacing, hz0 - hz1));
+
+    vec3 world = vec3(origin.x + g.x * spacing, h, origin.y + g.y * spacing);
+    te_eye_pos = vec3(gl_ModelViewMatrix * vec4(world, 1.0));
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(world, 1.0);
+}
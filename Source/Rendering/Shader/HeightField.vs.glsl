@@ -0,0 +1,12 @@
+#version 400 compatibility
+
+//patch corner position in height-sample coordinates; everything else
+//happens in the tessellation stages
+layout (location = 0) in vec2 grid_pos;
+
+out vec2 v_grid;
+
+void main()
+{
+    v_grid = grid_pos;
+}
@@ -13,6 +13,7 @@
 */
 
 #include "GlewHelper.h"
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -21,6 +22,7 @@
 
 
 #include "ShaderProgram.h"
+#include "RenderStateCache.h"
 
 namespace PhysIKA {
 /*
@@ -71,13 +73,17 @@ ShaderProgram::ShaderProgram(const char * vertex_shader_source,
 ShaderProgram::ShaderProgram(ShaderProgram && rhs) noexcept
 {
     this->program_ = rhs.program_;
+    this->uniform_cache_ = std::move(rhs.uniform_cache_);
     rhs.program_ = 0;
+    rhs.uniform_cache_.clear();
 }
 
 ShaderProgram & ShaderProgram::operator= (ShaderProgram && rhs) noexcept
 {
     this->program_ = rhs.program_;
+    this->uniform_cache_ = std::move(rhs.uniform_cache_);
     rhs.program_ = 0;
+    rhs.uniform_cache_.clear();
     return *this;
 }
 
@@ -106,7 +112,7 @@ void ShaderProgram::createFromCStyleString(const char * vertex_shader_source,
                         GL_FRAGMENT_SHADER,
                         GL_GEOMETRY_SHADER,
                         GL_TESS_CONTROL_SHADER,
-                        GL_TESS_CONTROL_SHADER
+                        GL_TESS_EVALUATION_SHADER
                       };
 
     const char * sources[5] = {
@@ -213,6 +219,10 @@ void ShaderProgram::createFromString(const std::string & vertex_shader_str,
 
 void ShaderProgram::destory()
 {
+    //the id may be recycled for the next program, so the cache must forget it
+    RenderStateCache::instance().notifyProgramDeleted(this->program_);
+    this->uniform_cache_.clear();
+
     glVerify(glDeleteProgram(this->program_));
     this->program_ = 0;
 }
@@ -221,13 +231,13 @@ void ShaderProgram::enable() const
 {
     if (this->isValid())
     {
-        glVerify(glUseProgram(this->program_));
+        RenderStateCache::instance().useProgram(this->program_);
     }
 }
 
 void ShaderProgram::disable() const
 {
-    glVerify(glUseProgram(0));
+    RenderStateCache::instance().useProgram(0);
 }
 
 bool ShaderProgram::setBool(const std::string & name, bool val) 
@@ -237,117 +247,272 @@ bool ShaderProgram::setBool(const std::string & name, bool val)
 
 bool ShaderProgram::setInt(const std::string & name, int val) 
 {
-    return openGLSetShaderInt(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderInt(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setFloat(const std::string & name, float val)
 {
-    return openGLSetShaderFloat(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderFloat(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec2(const std::string & name, const Vector2f & val)
 {
-    return openGLSetShaderVec2(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec2(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec2(const std::string & name, const Vector2d & val)
 {
-    return openGLSetShaderVec2(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec2(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec2(const std::string & name, const glm::vec2 & val)
 {
-    return openGLSetShaderVec2(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec2(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec2(const std::string & name, float x, float y)
 {
-    return openGLSetShaderVec2(this->program_, name, x, y);
+    float packed[2] = { x, y };
+    if (this->isUniformCached(name, packed, sizeof(packed)))
+        return true;
+
+    bool ok = openGLSetShaderVec2(this->program_, name, x, y);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec3(const std::string & name, const Vector3f & val)
 {
-    return openGLSetShaderVec3(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec3(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec3(const std::string & name, const Vector3d & val)
 {
-    return openGLSetShaderVec3(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec3(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec3(const std::string & name, const glm::vec3 & val)
 {
-    return openGLSetShaderVec3(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec3(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec3(const std::string & name, float x, float y, float z)
 {
-    return openGLSetShaderVec3(this->program_, name, x, y, z);
+    float packed[3] = { x, y, z };
+    if (this->isUniformCached(name, packed, sizeof(packed)))
+        return true;
+
+    bool ok = openGLSetShaderVec3(this->program_, name, x, y, z);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec4(const std::string & name, const Vector4f & val)
 {
-    return openGLSetShaderVec4(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec4(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec4(const std::string & name, const Vector4d & val)
 {
-    return openGLSetShaderVec4(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec4(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec4(const std::string & name, const glm::vec4 & val)
 {
-    return openGLSetShaderVec4(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderVec4(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setVec4(const std::string & name, float x, float y, float z, float w)
 {
-    return openGLSetShaderVec4(this->program_, name, x, y, z, w);
+    float packed[4] = { x, y, z, w };
+    if (this->isUniformCached(name, packed, sizeof(packed)))
+        return true;
+
+    bool ok = openGLSetShaderVec4(this->program_, name, x, y, z, w);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat2(const std::string & name, const Matrix2f & val)
 {
-    return openGLSetShaderMat2(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat2(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat2(const std::string & name, const Matrix2d & val)
 {
-    return openGLSetShaderMat2(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat2(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat2(const std::string & name, const glm::mat2 & val)
 {
-    return openGLSetShaderMat2(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat2(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat3(const std::string & name, const Matrix3f & val)
 {
-    return openGLSetShaderMat3(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat3(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat3(const std::string & name, const Matrix3d & val)
 {
-    return openGLSetShaderMat3(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat3(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat3(const std::string & name, const glm::mat3 & val)
 {
-    return openGLSetShaderMat3(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat3(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat4(const std::string & name, const Matrix4f & val)
 {
-    return openGLSetShaderMat4(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat4(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat4(const std::string & name, const Matrix4d & val)
 {
-    return openGLSetShaderMat4(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat4(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
 }
 
 bool ShaderProgram::setMat4(const std::string & name, const glm::mat4 & val)
 {
-    return openGLSetShaderMat4(this->program_, name, val);
+    if (this->isUniformCached(name, &val, sizeof(val)))
+        return true;
+
+    bool ok = openGLSetShaderMat4(this->program_, name, val);
+    if (!ok)
+        this->uniform_cache_.erase(name);
+    return ok;
+}
+
+bool ShaderProgram::isUniformCached(const std::string & name, const void * data, unsigned int bytes)
+{
+    CachedUniform & slot = this->uniform_cache_[name];
+    if (slot.size == bytes && std::memcmp(slot.data, data, bytes) == 0)
+    {
+        RenderStateCache::instance().countRedundantBind();
+        return true;
+    }
+
+    std::memcpy(slot.data, data, bytes);
+    slot.size = bytes;
+    return false;
 }
 
 bool ShaderProgram::isValid() const
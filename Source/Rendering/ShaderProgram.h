@@ -13,6 +13,9 @@
 */
 #pragma once
 
+#include <string>
+#include <unordered_map>
+
 #include <glm/fwd.hpp>
 
 #include "Core/Vector.h"
@@ -103,7 +106,22 @@ public:
     unsigned int id() const;
 
 private:
+    /*
+     * Last value set for each uniform; setters skip the GL call (and count
+     * the elimination in RenderStateCache) when the value did not change.
+     */
+    struct CachedUniform
+    {
+        unsigned char data[128];
+        unsigned int size = 0;
+    };
+
+    //returns true when the cached value already matches and the GL call can be skipped
+    bool isUniformCached(const std::string & name, const void * data, unsigned int bytes);
+
     unsigned int program_ = 0;
+
+    std::unordered_map<std::string, CachedUniform> uniform_cache_;
 };
 
 } // end of namespace PhysIKA
@@ -0,0 +1,333 @@
+/**
+ * Microbenchmarks for the Core GPU primitives.
+ *
+ * Times Scan::exclusive, Reduction<T>, Function2Pt::saxpy, svd3 and
+ * GridHash::construct across sizes from 1k to 16M elements, reporting
+ * effective GB/s next to the Thrust equivalent (which ships with the
+ * CUDA toolkit) where one exists. Run the binary by hand after touching
+ * any of these primitives and diff the GB/s column; an end-to-end run
+ * hides a slow Scan for weeks.
+ */
+#include <cstdio>
+#include <memory>
+
+#include <thrust/device_ptr.h>
+#include <thrust/execution_policy.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+
+#include "Core/Utility.h"
+#include "Core/Array/Array.h"
+#include "Core/Algorithm/svd3_cuda.h"
+#include "Core/Vector.h"
+#include "Framework/Topology/GridHash.h"
+
+using namespace PhysIKA;
+
+__device__ uint BM_Hash(uint x)
+{
+	x = (x ^ 61) ^ (x >> 16);
+	x *= 9;
+	x ^= x >> 4;
+	x *= 0x27d4eb2d;
+	x ^= x >> 15;
+	return x;
+}
+
+__global__ void K_BM_FillInt(int* data, int num, int val)
+{
+	int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (pId >= num) return;
+
+	data[pId] = val;
+}
+
+__global__ void K_BM_FillRandom(float* data, int num)
+{
+	int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (pId >= num) return;
+
+	data[pId] = BM_Hash(pId) / 4294967296.0f;
+}
+
+__global__ void K_BM_RandomCoords(Vector3f* pos, int num)
+{
+	int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (pId >= num) return;
+
+	pos[pId] = Vector3f(
+		BM_Hash(3 * pId + 0) / 4294967296.0f,
+		BM_Hash(3 * pId + 1) / 4294967296.0f,
+		BM_Hash(3 * pId + 2) / 4294967296.0f);
+}
+
+__global__ void K_BM_Svd(float* A, float* traces, int num)
+{
+	int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (pId >= num) return;
+
+	float* a = A + 9 * pId;
+	float u11, u12, u13, u21, u22, u23, u31, u32, u33;
+	float s11, s22, s33;
+	float v11, v12, v13, v21, v22, v23, v31, v32, v33;
+
+	svd(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8],
+		u11, u12, u13, u21, u22, u23, u31, u32, u33,
+		s11, s22, s33,
+		v11, v12, v13, v21, v22, v23, v31, v32, v33);
+
+	traces[pId] = s11 + s22 + s33;
+}
+
+//cell id of each particle, for the Thrust sort-by-key reference of
+//GridHash::construct
+__global__ void K_BM_CellIds(Vector3f* pos, int* keys, int* vals, int num, float h, int nx, int ny, int nz)
+{
+	int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+	if (pId >= num) return;
+
+	int i = (int)(pos[pId][0] / h);
+	int j = (int)(pos[pId][1] / h);
+	int k = (int)(pos[pId][2] / h);
+	i = i < 0 ? 0 : (i >= nx ? nx - 1 : i);
+	j = j < 0 ? 0 : (j >= ny ? ny - 1 : j);
+	k = k < 0 ? 0 : (k >= nz ? nz - 1 : k);
+
+	keys[pId] = i + j * nx + k * nx * ny;
+	vals[pId] = pId;
+}
+
+struct BM_Saxpy
+{
+	float alpha;
+
+	BM_Saxpy(float a) : alpha(a) {}
+
+	__host__ __device__ float operator()(const float& x, const float& y) const
+	{
+		return alpha * x + y;
+	}
+};
+
+/**
+ * Average milliseconds per call; the first call is a discarded warm-up
+ * so lazy allocations inside the primitive do not count.
+ */
+template<typename F>
+float benchmark(F func, int reps = 10)
+{
+	func();
+	cuSynchronize();
+
+	GTimer timer;
+	timer.start();
+	for (int i = 0; i < reps; i++)
+	{
+		func();
+	}
+	timer.stop();
+
+	return timer.getEclipsedTime() / reps;
+}
+
+void printRow(const char* name, int num, float ms, double bytes, float refMs)
+{
+	if (refMs > 0.0f)
+	{
+		printf("%-24s %9d %10.3f %8.1f %10.3f %7.2fx\n",
+			name, num, ms, bytes / (ms * 1.0e6), refMs, refMs / ms);
+	}
+	else
+	{
+		printf("%-24s %9d %10.3f %8.1f %10s %8s\n",
+			name, num, ms, bytes / (ms * 1.0e6), "-", "-");
+	}
+}
+
+void benchmarkScan(int num)
+{
+	DeviceArray<int> input;
+	DeviceArray<int> output;
+	input.resize(num);
+	output.resize(num);
+
+	uint pDims = cudaGridSize(num, BLOCK_SIZE);
+	K_BM_FillInt << <pDims, BLOCK_SIZE >> > (input.getDataPtr(), num, 1);
+	cuSynchronize();
+
+	Scan scan;
+	float ms = benchmark([&]() {
+		scan.exclusive(output, input);
+	});
+
+	thrust::device_ptr<int> tIn(input.getDataPtr());
+	thrust::device_ptr<int> tOut(output.getDataPtr());
+	float refMs = benchmark([&]() {
+		thrust::exclusive_scan(tIn, tIn + num, tOut);
+		cuSynchronize();
+	});
+
+	printRow("Scan::exclusive", num, ms, 2.0 * num * sizeof(int), refMs);
+
+	input.release();
+	output.release();
+}
+
+void benchmarkReduction(int num)
+{
+	DeviceArray<float> input;
+	input.resize(num);
+
+	uint pDims = cudaGridSize(num, BLOCK_SIZE);
+	K_BM_FillRandom << <pDims, BLOCK_SIZE >> > (input.getDataPtr(), num);
+	cuSynchronize();
+
+	std::shared_ptr<Reduction<float>> reduce(Reduction<float>::Create(num));
+	float ms = benchmark([&]() {
+		reduce->accumulate(input.getDataPtr(), num);
+	});
+
+	thrust::device_ptr<float> tIn(input.getDataPtr());
+	float refMs = benchmark([&]() {
+		thrust::reduce(tIn, tIn + num);
+	});
+
+	printRow("Reduction::accumulate", num, ms, (double)num * sizeof(float), refMs);
+
+	input.release();
+}
+
+void benchmarkFunction2Pt(int num)
+{
+	DeviceArray<float> x;
+	DeviceArray<float> y;
+	DeviceArray<float> z;
+	x.resize(num);
+	y.resize(num);
+	z.resize(num);
+
+	uint pDims = cudaGridSize(num, BLOCK_SIZE);
+	K_BM_FillRandom << <pDims, BLOCK_SIZE >> > (x.getDataPtr(), num);
+	K_BM_FillRandom << <pDims, BLOCK_SIZE >> > (y.getDataPtr(), num);
+	cuSynchronize();
+
+	float ms = benchmark([&]() {
+		Function2Pt::saxpy(z, x, y, 2.0f);
+		cuSynchronize();
+	});
+
+	thrust::device_ptr<float> tX(x.getDataPtr());
+	thrust::device_ptr<float> tY(y.getDataPtr());
+	thrust::device_ptr<float> tZ(z.getDataPtr());
+	float refMs = benchmark([&]() {
+		thrust::transform(tX, tX + num, tY, tZ, BM_Saxpy(2.0f));
+		cuSynchronize();
+	});
+
+	printRow("Function2Pt::saxpy", num, ms, 3.0 * num * sizeof(float), refMs);
+
+	x.release();
+	y.release();
+	z.release();
+}
+
+void benchmarkSvd(int num)
+{
+	DeviceArray<float> A;
+	DeviceArray<float> traces;
+	A.resize(9 * num);
+	traces.resize(num);
+
+	uint pDims9 = cudaGridSize(9 * num, BLOCK_SIZE);
+	K_BM_FillRandom << <pDims9, BLOCK_SIZE >> > (A.getDataPtr(), 9 * num);
+	cuSynchronize();
+
+	uint pDims = cudaGridSize(num, BLOCK_SIZE);
+	float ms = benchmark([&]() {
+		K_BM_Svd << <pDims, BLOCK_SIZE >> > (A.getDataPtr(), traces.getDataPtr(), num);
+		cuSynchronize();
+	});
+
+	printRow("svd3", num, ms, 10.0 * num * sizeof(float), 0.0f);
+
+	A.release();
+	traces.release();
+}
+
+void benchmarkGridHash(int num)
+{
+	float h = 0.01f;
+
+	DeviceArray<Vector3f> pos;
+	pos.resize(num);
+
+	uint pDims = cudaGridSize(num, BLOCK_SIZE);
+	K_BM_RandomCoords << <pDims, BLOCK_SIZE >> > (pos.getDataPtr(), num);
+	cuSynchronize();
+
+	GridHash<DataType3f> hash;
+	hash.setSpace(h, Vector3f(0.0f, 0.0f, 0.0f), Vector3f(1.0f, 1.0f, 1.0f));
+
+	float ms = benchmark([&]() {
+		hash.clear();
+		hash.construct(pos);
+		cuSynchronize();
+	});
+
+	//reference: the textbook counting-sort construction via Thrust
+	DeviceArray<int> keys;
+	DeviceArray<int> vals;
+	keys.resize(num);
+	vals.resize(num);
+
+	int nx = (int)(1.0f / h);
+	thrust::device_ptr<int> tKeys(keys.getDataPtr());
+	thrust::device_ptr<int> tVals(vals.getDataPtr());
+	float refMs = benchmark([&]() {
+		K_BM_CellIds << <pDims, BLOCK_SIZE >> > (pos.getDataPtr(), keys.getDataPtr(), vals.getDataPtr(), num, h, nx, nx, nx);
+		thrust::sort_by_key(tKeys, tKeys + num, tVals);
+		cuSynchronize();
+	});
+
+	printRow("GridHash::construct", num, ms, (double)num * (sizeof(Vector3f) + 2 * sizeof(int)), refMs);
+
+	hash.release();
+	pos.release();
+	keys.release();
+	vals.release();
+}
+
+int main()
+{
+	int sizes[] = { 1 << 10, 1 << 14, 1 << 18, 1 << 22, 1 << 24 };
+	int sizeNum = sizeof(sizes) / sizeof(sizes[0]);
+
+	printf("%-24s %9s %10s %8s %10s %8s\n",
+		"benchmark", "n", "ms", "GB/s", "thrust ms", "speedup");
+
+	for (int i = 0; i < sizeNum; i++)
+	{
+		benchmarkScan(sizes[i]);
+	}
+	for (int i = 0; i < sizeNum; i++)
+	{
+		benchmarkReduction(sizes[i]);
+	}
+	for (int i = 0; i < sizeNum; i++)
+	{
+		benchmarkFunction2Pt(sizes[i]);
+	}
+	for (int i = 0; i < sizeNum; i++)
+	{
+		benchmarkSvd(sizes[i]);
+	}
+	for (int i = 0; i < sizeNum; i++)
+	{
+		benchmarkGridHash(sizes[i]);
+	}
+
+	return 0;
+}
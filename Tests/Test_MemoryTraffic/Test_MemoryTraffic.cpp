@@ -0,0 +1,98 @@
+/**
+ * Memory-traffic regression tests.
+ *
+ * Runs representative models for a number of warm-up frames and then
+ * asserts that the steady-state frames make zero device allocations,
+ * using the MemoryStats allocation counter behind every MemoryManager
+ * (pool hits served from cached blocks do not count). This guards the
+ * caching allocator and the capacity-reuse work: a module that
+ * reintroduces a per-frame cudaMalloc turns these tests red instead of
+ * silently costing every frame.
+ */
+#include "gtest/gtest.h"
+
+#include <cuda_runtime.h>
+
+#include "Framework/Framework/SceneGraph.h"
+#include "Core/Array/MemoryManager.h"
+#include "Dynamics/ParticleSystem/ParticleFluid.h"
+#include "Dynamics/ParticleSystem/PositionBasedFluidModel.h"
+#include "Dynamics/ParticleSystem/Peridynamics.h"
+#include "Dynamics/ParticleSystem/StaticBoundary.h"
+
+using namespace PhysIKA;
+
+namespace
+{
+	const int WARMUP_FRAMES = 10;
+	const int STEADY_FRAMES = 20;
+
+	//step the current scene through warm-up, then return how many device
+	//allocations the steady-state frames made
+	size_t steadyStateAllocs()
+	{
+		SceneGraph& scene = SceneGraph::getInstance();
+		scene.initialize();
+
+		for (int i = 0; i < WARMUP_FRAMES; i++)
+		{
+			scene.takeOneFrame();
+		}
+		cudaDeviceSynchronize();
+
+		size_t before = MemoryStats::allocCount();
+		for (int i = 0; i < STEADY_FRAMES; i++)
+		{
+			scene.takeOneFrame();
+		}
+		cudaDeviceSynchronize();
+
+		return MemoryStats::allocCount() - before;
+	}
+}
+
+TEST(MemoryTraffic, PositionBasedFluid)
+{
+	SceneGraph& scene = SceneGraph::getInstance();
+	scene.invalid();
+
+	auto root = scene.createNewScene<StaticBoundary<DataType3f>>();
+	root->loadCube(Vector3f(0), Vector3f(1), 0.02f, true);
+
+	auto fluid = std::make_shared<ParticleFluid<DataType3f>>();
+	root->addParticleSystem(fluid);
+	fluid->loadParticles(Vector3f(0.3f, 0.05f, 0.3f), Vector3f(0.7f, 0.25f, 0.7f), 0.01f);
+	fluid->setMass(10);
+
+	auto pbd = std::make_shared<PositionBasedFluidModel<DataType3f>>();
+	fluid->currentPosition()->connect(&pbd->m_position);
+	fluid->currentVelocity()->connect(&pbd->m_velocity);
+	fluid->currentForce()->connect(&pbd->m_forceDensity);
+	pbd->setSmoothingLength(0.02f);
+	fluid->setNumericalModel(pbd);
+
+	EXPECT_EQ(steadyStateAllocs(), 0u);
+}
+
+TEST(MemoryTraffic, Peridynamics)
+{
+	SceneGraph& scene = SceneGraph::getInstance();
+	scene.invalid();
+
+	auto root = scene.createNewScene<StaticBoundary<DataType3f>>();
+	root->loadCube(Vector3f(0), Vector3f(1), 0.02f, true);
+
+	auto solid = std::make_shared<ParticleFluid<DataType3f>>();
+	root->addParticleSystem(solid);
+	solid->loadParticles(Vector3f(0.4f, 0.1f, 0.4f), Vector3f(0.6f, 0.3f, 0.6f), 0.01f);
+	solid->setMass(1);
+
+	auto peri = std::make_shared<Peridynamics<DataType3f>>();
+	solid->currentPosition()->connect(&peri->m_position);
+	solid->currentVelocity()->connect(&peri->m_velocity);
+	solid->currentForce()->connect(&peri->m_forceDensity);
+	peri->m_horizon.setValue(0.02f);
+	solid->setNumericalModel(peri);
+
+	EXPECT_EQ(steadyStateAllocs(), 0u);
+}
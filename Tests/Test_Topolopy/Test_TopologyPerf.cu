@@ -0,0 +1,563 @@
+/**
+ * Stress and performance fixtures for the topology primitives.
+ *
+ * Covers GridHash::construct, NeighborQuery (dynamic and fixed-size
+ * NeighborList modes), TriangleSet mesh upload and DistanceField3D query
+ * throughput: correctness against brute-force references at small N,
+ * timing fixtures at 1M elements. Set PHYSIKA_TOPO_LARGE=1 to extend the
+ * timing fixtures to 4M and 16M elements (too slow for every ctest run).
+ *
+ * Timing fixtures print one "[ perf ]" line each. CI on the reference GPU
+ * points PHYSIKA_TOPO_BASELINE at a file of "<name> <milliseconds>" lines
+ * recorded from a known-good build; a fixture then fails when it runs more
+ * than 10% over its baseline, so topology changes cannot regress silently.
+ * Without the variable the timings are informational only, keeping the
+ * suite green on developer machines with arbitrary GPUs.
+ */
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <cuda_runtime.h>
+
+#include "Core/Utility.h"
+#include "Core/Array/Array.h"
+#include "Core/Vector.h"
+#include "Framework/Topology/GridHash.h"
+#include "Framework/Topology/NeighborList.h"
+#include "Framework/Topology/NeighborQuery.h"
+#include "Framework/Topology/TriangleSet.h"
+#include "Framework/Topology/DistanceField3D.h"
+
+using namespace PhysIKA;
+
+namespace
+{
+	__device__ uint TT_Hash(uint x)
+	{
+		x = (x ^ 61) ^ (x >> 16);
+		x *= 9;
+		x ^= x >> 4;
+		x *= 0x27d4eb2d;
+		x ^= x >> 15;
+		return x;
+	}
+
+	__global__ void K_TT_RandomCoords(Vector3f* pos, int num)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		pos[pId] = Vector3f(
+			TT_Hash(3 * pId + 0) / 4294967296.0f,
+			TT_Hash(3 * pId + 1) / 4294967296.0f,
+			TT_Hash(3 * pId + 2) / 4294967296.0f);
+	}
+
+	__global__ void K_TT_SampleField(
+		float* dist,
+		Vector3f* pos,
+		DistanceField3D<DataType3f> field,
+		int num)
+	{
+		int pId = threadIdx.x + (blockIdx.x * blockDim.x);
+		if (pId >= num) return;
+
+		float d;
+		Vector3f normal;
+		field.getDistance(pos[pId], d, normal);
+		dist[pId] = d;
+	}
+
+	//cudaEvent stopwatch; elapsed() synchronizes
+	struct GpuTimer
+	{
+		GpuTimer()
+		{
+			cudaEventCreate(&m_start);
+			cudaEventCreate(&m_stop);
+		}
+		~GpuTimer()
+		{
+			cudaEventDestroy(m_start);
+			cudaEventDestroy(m_stop);
+		}
+
+		void start() { cudaEventRecord(m_start); }
+		float elapsed()
+		{
+			cudaEventRecord(m_stop);
+			cudaEventSynchronize(m_stop);
+			float ms = 0.0f;
+			cudaEventElapsedTime(&ms, m_start, m_stop);
+			return ms;
+		}
+
+		cudaEvent_t m_start;
+		cudaEvent_t m_stop;
+	};
+
+	bool largeFixturesEnabled()
+	{
+		const char* env = std::getenv("PHYSIKA_TOPO_LARGE");
+		return env != nullptr && env[0] == '1';
+	}
+
+	float baselineMillis(const std::string& name)
+	{
+		static std::map<std::string, float> s_baseline;
+		static bool s_loaded = false;
+		if (!s_loaded)
+		{
+			s_loaded = true;
+			const char* path = std::getenv("PHYSIKA_TOPO_BASELINE");
+			if (path != nullptr)
+			{
+				std::ifstream in(path);
+				std::string key;
+				float ms;
+				while (in >> key >> ms)
+				{
+					s_baseline[key] = ms;
+				}
+			}
+		}
+
+		auto it = s_baseline.find(name);
+		return it == s_baseline.end() ? -1.0f : it->second;
+	}
+
+	void expectWithinBaseline(const std::string& name, float ms)
+	{
+		std::printf("[ perf ] %-40s %10.3f ms\n", name.c_str(), ms);
+
+		float base = baselineMillis(name);
+		if (base > 0.0f)
+		{
+			EXPECT_LE(ms, 1.1f * base)
+				<< name << " regressed more than 10% against the baseline ("
+				<< base << " ms)";
+		}
+	}
+
+	void fillRandomCoords(DeviceArray<Vector3f>& pos)
+	{
+		cuint pDims = cudaGridSize((uint)pos.size(), BLOCK_SIZE);
+		K_TT_RandomCoords << <pDims, BLOCK_SIZE >> > (pos.getDataPtr(), (int)pos.size());
+		cuSynchronize();
+	}
+
+	//brute-force O(N^2) neighbor reference on the host
+	std::vector<std::set<int>> bruteForceNeighbors(const HostArray<Vector3f>& pos, float h)
+	{
+		std::vector<std::set<int>> nbr(pos.size());
+		for (int i = 0; i < pos.size(); i++)
+		{
+			for (int j = 0; j < pos.size(); j++)
+			{
+				if (i != j && (pos[i] - pos[j]).norm() < h)
+				{
+					nbr[i].insert(j);
+				}
+			}
+		}
+		return nbr;
+	}
+
+	std::vector<std::set<int>> downloadNeighbors(NeighborList<int>& nbrList)
+	{
+		HostArray<int> index;
+		HostArray<int> elements;
+		index.resize(nbrList.getIndex().size());
+		elements.resize(nbrList.getElements().size());
+		Function1Pt::copy(index, nbrList.getIndex());
+		Function1Pt::copy(elements, nbrList.getElements());
+
+		int num = index.size();
+		int limit = nbrList.getNeighborLimit();
+
+		std::vector<std::set<int>> nbr(num);
+		for (int i = 0; i < num; i++)
+		{
+			if (limit > 0)
+			{
+				for (int j = 0; j < index[i]; j++)
+				{
+					nbr[i].insert(elements[limit * i + j]);
+				}
+			}
+			else
+			{
+				int end = (i == num - 1) ? nbrList.elementSize() : index[i + 1];
+				for (int j = index[i]; j < end; j++)
+				{
+					nbr[i].insert(elements[j]);
+				}
+			}
+		}
+
+		index.release();
+		elements.release();
+		return nbr;
+	}
+}
+
+TEST(NeighborQuery, matchesBruteForce)
+{
+	const int num = 2000;
+	const float h = 0.1f;
+
+	NeighborQuery<DataType3f> query(h, Vector3f(0), Vector3f(1));
+	query.inPosition()->setElementCount(num);
+	fillRandomCoords(query.inPosition()->getValue());
+
+	ASSERT_TRUE(query.initialize());
+
+	HostArray<Vector3f> hostPos;
+	hostPos.resize(num);
+	Function1Pt::copy(hostPos, query.inPosition()->getValue());
+
+	auto expected = bruteForceNeighbors(hostPos, h);
+	auto actual = downloadNeighbors(query.outNeighborhood()->getValue());
+
+	ASSERT_EQ((int)actual.size(), num);
+	for (int i = 0; i < num; i++)
+	{
+		//the hash query includes the particle itself; the reference does not
+		actual[i].erase(i);
+		EXPECT_EQ(actual[i], expected[i]) << "neighbor set differs for particle " << i;
+	}
+
+	hostPos.release();
+}
+
+TEST(NeighborQuery, limitedModeIsValidSubset)
+{
+	const int num = 2000;
+	const float h = 0.1f;
+	const int limit = 24;
+
+	NeighborQuery<DataType3f> query(h, Vector3f(0), Vector3f(1));
+	query.setNeighborSizeLimit(limit);
+	query.inPosition()->setElementCount(num);
+	fillRandomCoords(query.inPosition()->getValue());
+
+	ASSERT_TRUE(query.initialize());
+
+	HostArray<Vector3f> hostPos;
+	hostPos.resize(num);
+	Function1Pt::copy(hostPos, query.inPosition()->getValue());
+
+	auto reference = bruteForceNeighbors(hostPos, h);
+	auto limited = downloadNeighbors(query.outNeighborhood()->getValue());
+
+	ASSERT_EQ((int)limited.size(), num);
+	for (int i = 0; i < num; i++)
+	{
+		limited[i].erase(i);
+		EXPECT_LE((int)limited[i].size(), limit);
+
+		//every stored id must be a true neighbor...
+		for (int j : limited[i])
+		{
+			EXPECT_TRUE(reference[i].count(j) > 0)
+				<< "particle " << i << " stores non-neighbor " << j;
+		}
+
+		//...and nothing may be dropped while the limit has room
+		if ((int)reference[i].size() < limit)
+		{
+			EXPECT_EQ(limited[i], reference[i]) << "particle " << i << " dropped neighbors below the limit";
+		}
+	}
+
+	hostPos.release();
+}
+
+TEST(TriangleSet, gridMeshCounts)
+{
+	//the default constructor builds an 11x11 vertex grid of 200 triangles
+	TriangleSet<DataType3f> triSet;
+
+	EXPECT_EQ(triSet.getPoints().size(), 121);
+	EXPECT_EQ(triSet.getTriangles()->size(), 200);
+}
+
+namespace
+{
+	//the TriangleSet default-constructor grid at an arbitrary resolution
+	void buildGridMesh(TriangleSet<DataType3f>& triSet, int n)
+	{
+		std::vector<Vector3f> positions;
+		std::vector<TopologyModule::Triangle> triangles;
+		float dx = 1.0f / (n - 1);
+
+		for (int k = 0; k < n; k++) {
+			for (int i = 0; i < n; i++) {
+				positions.push_back(Vector3f(i * dx, 0.0f, k * dx));
+				if (k < n - 1 && i < n - 1)
+				{
+					triangles.push_back(TopologyModule::Triangle(i + k * n, i + 1 + k * n, i + 1 + (k + 1) * n));
+					triangles.push_back(TopologyModule::Triangle(i + k * n, i + 1 + (k + 1) * n, i + (k + 1) * n));
+				}
+			}
+		}
+
+		triSet.setPoints(positions);
+		triSet.setTriangles(triangles);
+	}
+
+	std::set<std::pair<unsigned int, unsigned int>> downloadEdges(TriangleSet<DataType3f>& triSet)
+	{
+		DeviceArray<TopologyModule::Edge>* edges = triSet.getEdges();
+		std::vector<TopologyModule::Edge> hostEdges(edges->size());
+		cudaMemcpy(hostEdges.data(), edges->getDataPtr(), edges->size() * sizeof(TopologyModule::Edge), cudaMemcpyDeviceToHost);
+
+		std::set<std::pair<unsigned int, unsigned int>> result;
+		for (auto& e : hostEdges)
+		{
+			result.insert(std::make_pair(e[0], e[1]));
+		}
+		return result;
+	}
+}
+
+TEST(TriangleSet, edgeConstruction)
+{
+	//11x11 grid: 10*11 horizontal + 11*10 vertical + 10*10 diagonal edges
+	TriangleSet<DataType3f> devSet;
+	devSet.updateEdges();
+	auto devEdges = downloadEdges(devSet);
+	EXPECT_EQ((int)devEdges.size(), 320);
+
+	//the device sort/dedup path and the host set-based path must agree
+	TriangleSet<DataType3f> hostSet;
+	hostSet.updateEdgesHost();
+	auto hostEdges = downloadEdges(hostSet);
+	EXPECT_EQ(devEdges, hostEdges);
+}
+
+TEST(TriangleSet, vertexIncidence)
+{
+	TriangleSet<DataType3f> triSet;
+	triSet.updateEdges();
+
+	NeighborList<int>& nbr = triSet.getEdgeNeighbors();
+	ASSERT_EQ(nbr.size(), 121);
+
+	HostArray<int> index;
+	index.resize(nbr.getIndex().size());
+	Function1Pt::copy(index, nbr.getIndex());
+
+	//CSR row offsets must cover both endpoints of every edge exactly once
+	EXPECT_EQ(nbr.elementSize(), 2 * 320);
+	EXPECT_EQ(index[0], 0);
+
+	//corner vertex 0 touches its right, lower and diagonal neighbor
+	EXPECT_EQ(index[1] - index[0], 3);
+
+	index.release();
+}
+
+TEST(TopologyPerf, triangleEdgeConstruction)
+{
+	std::vector<int> sizes = { 708 };		//2*(n-1)^2 = ~1M triangles
+	if (largeFixturesEnabled())
+	{
+		sizes.push_back(2832);				//~16M triangles
+	}
+
+	for (int n : sizes)
+	{
+		TriangleSet<DataType3f> triSet;
+		buildGridMesh(triSet, n);
+
+		//warm up the sort/scan scratch buffers before timing
+		triSet.updateEdges();
+
+		const int iters = 5;
+		GpuTimer timer;
+		timer.start();
+		for (int i = 0; i < iters; i++)
+		{
+			triSet.updateEdges();
+		}
+		float ms = timer.elapsed() / iters;
+
+		int triNum = 2 * (n - 1) * (n - 1);
+		char name[64];
+		std::sprintf(name, "TriangleSet.updateEdges.%dM", (triNum + (1 << 19)) >> 20);
+		expectWithinBaseline(name, ms);
+	}
+}
+
+TEST(DistanceField3D, boxDistances)
+{
+	Vector3f lo(0.1f);
+	Vector3f hi(0.9f);
+
+	DistanceField3D<DataType3f> field;
+	field.setSpace(Vector3f(0) - 0.025f, Vector3f(1) + 0.025f, 105, 105, 105);
+	field.loadBox(lo, hi, false);
+
+	const int num = 3;
+	std::vector<Vector3f> samples = {
+		Vector3f(0.5f, 0.5f, 0.5f),		//deep inside: -0.4 to the nearest face
+		Vector3f(0.5f, 0.95f, 0.5f),	//0.05 above the top face
+		Vector3f(0.05f, 0.5f, 0.5f)		//0.05 outside the low-x face
+	};
+	std::vector<float> expected = { -0.4f, 0.05f, 0.05f };
+
+	DeviceArray<Vector3f> devPos;
+	DeviceArray<float> devDist;
+	devPos.resize(num);
+	devDist.resize(num);
+	cuSafeCall(cudaMemcpy(devPos.getDataPtr(), samples.data(), num * sizeof(Vector3f), cudaMemcpyHostToDevice));
+
+	K_TT_SampleField << <1, num >> > (devDist.getDataPtr(), devPos.getDataPtr(), field, num);
+	cuSynchronize();
+
+	float dist[num];
+	cuSafeCall(cudaMemcpy(dist, devDist.getDataPtr(), num * sizeof(float), cudaMemcpyDeviceToHost));
+
+	//trilinear sampling on a 105^3 grid: allow two cells of error
+	float tol = 2.0f * 1.05f / 104.0f;
+	for (int i = 0; i < num; i++)
+	{
+		EXPECT_NEAR(dist[i], expected[i], tol) << "sample " << i;
+	}
+
+	devPos.release();
+	devDist.release();
+	field.release();
+}
+
+TEST(TopologyPerf, gridHashConstruct)
+{
+	std::vector<int> sizes = { 1 << 20 };
+	if (largeFixturesEnabled())
+	{
+		sizes.push_back(1 << 22);
+		sizes.push_back(1 << 24);
+	}
+
+	for (int num : sizes)
+	{
+		DeviceArray<Vector3f> pos;
+		pos.resize(num);
+		fillRandomCoords(pos);
+
+		GridHash<DataType3f> hash;
+		hash.setSpace(0.0125f, Vector3f(0) - 0.025f, Vector3f(1) + 0.025f);
+
+		//warm up allocations before timing
+		hash.construct(pos);
+		cuSynchronize();
+
+		const int iters = 20;
+		GpuTimer timer;
+		timer.start();
+		for (int i = 0; i < iters; i++)
+		{
+			hash.construct(pos);
+		}
+		float ms = timer.elapsed() / iters;
+
+		char name[64];
+		std::sprintf(name, "GridHash.construct.%dM", num >> 20);
+		expectWithinBaseline(name, ms);
+
+		hash.release();
+		pos.release();
+	}
+}
+
+TEST(TopologyPerf, neighborQueryDynamicVsLimited)
+{
+	std::vector<int> sizes = { 1 << 20 };
+	if (largeFixturesEnabled())
+	{
+		sizes.push_back(1 << 22);
+		sizes.push_back(1 << 24);
+	}
+
+	for (int num : sizes)
+	{
+		for (int limit : { 0, 32 })
+		{
+			NeighborQuery<DataType3f> query(0.0125f, Vector3f(0), Vector3f(1));
+			if (limit > 0)
+			{
+				query.setNeighborSizeLimit(limit);
+			}
+			query.inPosition()->setElementCount(num);
+			fillRandomCoords(query.inPosition()->getValue());
+
+			ASSERT_TRUE(query.initialize());
+
+			const int iters = 10;
+			GpuTimer timer;
+			timer.start();
+			for (int i = 0; i < iters; i++)
+			{
+				query.compute();
+			}
+			float ms = timer.elapsed() / iters;
+
+			char name[64];
+			std::sprintf(name, "NeighborQuery.%s.%dM", limit > 0 ? "limited" : "dynamic", num >> 20);
+			expectWithinBaseline(name, ms);
+		}
+	}
+}
+
+TEST(TopologyPerf, distanceFieldQueryThroughput)
+{
+	Vector3f lo(0.1f);
+	Vector3f hi(0.9f);
+
+	DistanceField3D<DataType3f> field;
+	field.setSpace(Vector3f(0) - 0.025f, Vector3f(1) + 0.025f, 105, 105, 105);
+	field.loadBox(lo, hi, false);
+
+	std::vector<int> sizes = { 1 << 20 };
+	if (largeFixturesEnabled())
+	{
+		sizes.push_back(1 << 24);
+	}
+
+	for (int num : sizes)
+	{
+		DeviceArray<Vector3f> pos;
+		DeviceArray<float> dist;
+		pos.resize(num);
+		dist.resize(num);
+		fillRandomCoords(pos);
+
+		cuint pDims = cudaGridSize((uint)num, BLOCK_SIZE);
+		K_TT_SampleField << <pDims, BLOCK_SIZE >> > (dist.getDataPtr(), pos.getDataPtr(), field, num);
+		cuSynchronize();
+
+		const int iters = 20;
+		GpuTimer timer;
+		timer.start();
+		for (int i = 0; i < iters; i++)
+		{
+			K_TT_SampleField << <pDims, BLOCK_SIZE >> > (dist.getDataPtr(), pos.getDataPtr(), field, num);
+		}
+		float ms = timer.elapsed() / iters;
+
+		char name[64];
+		std::sprintf(name, "DistanceField3D.query.%dM", num >> 20);
+		expectWithinBaseline(name, ms);
+
+		pos.release();
+		dist.release();
+	}
+}